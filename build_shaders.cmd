@@ -20,3 +20,4 @@ fxc shaders\tex2vid.hlsl %CS_FXCOPTS% /D AV_PIX_FMT_YUV422P=1 /Fo %OUTDIR%\conve
 fxc shaders\tex2vid.hlsl %CS_FXCOPTS% /D AV_PIX_FMT_YUV444P=1 /Fo %OUTDIR%\convert_yuv444
 fxc shaders\motion_sample.hlsl %CS_FXCOPTS% /Fo %OUTDIR%\mosample
 fxc shaders\downsample.hlsl %CS_FXCOPTS% /Fo %OUTDIR%\downsample
+fxc shaders\motion_diff.hlsl %CS_FXCOPTS% /Fo %OUTDIR%\motion_diff
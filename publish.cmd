@@ -21,6 +21,7 @@ copy /Y ".\bin\svr_standalone64.dll" "publish_temp\svr\"
 copy /Y ".\bin\svr_launcher.exe" "publish_temp\svr\"
 copy /Y ".\bin\svr_launcher64.exe" "publish_temp\svr\"
 copy /Y ".\bin\svr_encoder.exe" "publish_temp\svr\"
+copy /Y ".\bin\svr_encoder_host.dll" "publish_temp\svr\"
 copy /Y ".\bin\svr_shared.dll" "publish_temp\svr\"
 copy /Y ".\bin\svr_shared64.dll" "publish_temp\svr\"
 copy /Y ".\bin\avcodec-59.dll" "publish_temp\svr\"
@@ -0,0 +1,51 @@
+// Difference between a game frame and the one before it, for adaptive motion blur.
+// This is the same as svr_mosample_get_difference: the color sums of 4x4 blocks are compared with the previous frame.
+// The sums are counted in 8-bit units and the total is in quarters of those, so it fits in 32 bits at 4K.
+
+Texture2D<unorm float4> source_texture : register(t0);
+RWTexture2D<float4> prev_texture : register(u0); // Block sums of the previous game frame.
+RWByteAddressBuffer diff_buffer : register(u1); // Total difference.
+
+groupshared uint group_diff;
+
+// This must be synchronized with the compute shader Dispatch call in CPU code!
+[numthreads(8, 8, 1)]
+void main(uint3 dtid : SV_DispatchThreadID, uint gidx : SV_GroupIndex)
+{
+    if (gidx == 0)
+    {
+        group_diff = 0;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    uint2 size;
+    prev_texture.GetDimensions(size.x, size.y);
+
+    if (all(dtid.xy < size))
+    {
+        float3 sum = 0.0f;
+
+        for (uint y = 0; y < 4; y++)
+        {
+            for (uint x = 0; x < 4; x++)
+            {
+                sum += source_texture.Load(int3(dtid.xy * 4 + uint2(x, y), 0)).rgb;
+            }
+        }
+
+        sum = round(sum * 255.0f);
+
+        float3 d = abs(sum - prev_texture[dtid.xy].rgb);
+        prev_texture[dtid.xy] = float4(sum, 0.0f);
+
+        InterlockedAdd(group_diff, (uint)round((d.r + d.g + d.b) * 0.25f));
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (gidx == 0)
+    {
+        diff_buffer.InterlockedAdd(0, group_diff);
+    }
+}
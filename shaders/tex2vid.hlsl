@@ -35,6 +35,23 @@ uint3 convert_rgb_to_yuv(float3 rgb)
     return ret;
 }
 
+// Chroma samples that cover several pixels are written by the thread of the first pixel, with the average of all the pixels.
+// Pixels past the edge repeat the last pixel.
+float3 load_average(uint3 dtid, uint2 size)
+{
+    uint2 dims;
+    input_texture.GetDimensions(dims.x, dims.y);
+
+    uint2 last = min(dtid.xy + size - 1, dims - 1);
+
+    float3 sum = input_texture.Load(dtid).xyz;
+    sum += input_texture.Load(uint3(last.x, dtid.y, 0)).xyz;
+    sum += input_texture.Load(uint3(dtid.x, last.y, 0)).xyz;
+    sum += input_texture.Load(uint3(last.x, last.y, 0)).xyz;
+
+    return sum * 0.25;
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 
 #if AV_PIX_FMT_NV12
@@ -51,7 +68,12 @@ void proc(uint3 dtid)
     float4 pix = input_texture.Load(dtid);
     uint3 yuv = convert_rgb_to_yuv(pix.xyz);
     output_texture_y[dtid.xy] = yuv.x;
-    output_texture_uv[dtid.xy >> 1] = uint2(yuv.yz);
+
+    if ((dtid.x & 1) == 0 && (dtid.y & 1) == 0)
+    {
+        uint3 avg_yuv = convert_rgb_to_yuv(load_average(dtid, uint2(2, 2)));
+        output_texture_uv[dtid.xy >> 1] = uint2(avg_yuv.yz);
+    }
 }
 
 #endif
@@ -73,8 +95,13 @@ void proc(uint3 dtid)
     float4 pix = input_texture.Load(dtid);
     uint3 yuv = convert_rgb_to_yuv(pix.xyz);
     output_texture_y[dtid.xy] = yuv.x;
-    output_texture_u[int2(dtid.x >> 1, dtid.y)] = yuv.y;
-    output_texture_v[int2(dtid.x >> 1, dtid.y)] = yuv.z;
+
+    if ((dtid.x & 1) == 0)
+    {
+        uint3 avg_yuv = convert_rgb_to_yuv(load_average(dtid, uint2(2, 1)));
+        output_texture_u[int2(dtid.x >> 1, dtid.y)] = avg_yuv.y;
+        output_texture_v[int2(dtid.x >> 1, dtid.y)] = avg_yuv.z;
+    }
 }
 
 #endif
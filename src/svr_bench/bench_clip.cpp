@@ -0,0 +1,149 @@
+#include "bench_priv.h"
+#include <math.h>
+
+// Synthetic clips for the motion blur reports, since there are no recorded game frames that can be shipped.
+// A smooth background texture pans horizontally and a solid block moves in front of it, both at sub-pixel positions
+// so every sub-frame is different when something moves.
+
+const s32 BENCH_CLIP_TEXTURE_SIZE = 256; // Must be a power of two so positions can wrap with a mask.
+const s32 BENCH_CLIP_TEXTURE_CELL = 16; // Pixels between the random values that the texture is made from.
+const s32 BENCH_CLIP_BLOCK_SIZE = 40;
+
+u8* bench_clip_texture;
+
+void bench_clip_init()
+{
+    if (bench_clip_texture)
+    {
+        return;
+    }
+
+    const s32 NUM_CELLS = BENCH_CLIP_TEXTURE_SIZE / BENCH_CLIP_TEXTURE_CELL;
+
+    u8 cells[NUM_CELLS * NUM_CELLS * 4];
+
+    srand(BENCH_CLIP_TEXTURE_SIZE);
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(cells); i++)
+    {
+        cells[i] = (u8)(rand() % 256);
+    }
+
+    bench_clip_texture = (u8*)svr_alloc(BENCH_CLIP_TEXTURE_SIZE * BENCH_CLIP_TEXTURE_SIZE * 4);
+
+    // Bilinear between the random values, wrapping around so the texture can repeat.
+    for (s32 y = 0; y < BENCH_CLIP_TEXTURE_SIZE; y++)
+    {
+        for (s32 x = 0; x < BENCH_CLIP_TEXTURE_SIZE; x++)
+        {
+            s32 cx = x / BENCH_CLIP_TEXTURE_CELL;
+            s32 cy = y / BENCH_CLIP_TEXTURE_CELL;
+            float fx = (float)(x % BENCH_CLIP_TEXTURE_CELL) / BENCH_CLIP_TEXTURE_CELL;
+            float fy = (float)(y % BENCH_CLIP_TEXTURE_CELL) / BENCH_CLIP_TEXTURE_CELL;
+
+            u8* c00 = cells + (cy * NUM_CELLS + cx) * 4;
+            u8* c10 = cells + (cy * NUM_CELLS + (cx + 1) % NUM_CELLS) * 4;
+            u8* c01 = cells + (((cy + 1) % NUM_CELLS) * NUM_CELLS + cx) * 4;
+            u8* c11 = cells + (((cy + 1) % NUM_CELLS) * NUM_CELLS + (cx + 1) % NUM_CELLS) * 4;
+
+            u8* px = bench_clip_texture + (y * BENCH_CLIP_TEXTURE_SIZE + x) * 4;
+
+            for (s32 c = 0; c < 4; c++)
+            {
+                float top = c00[c] + (c10[c] - c00[c]) * fx;
+                float bottom = c01[c] + (c11[c] - c01[c]) * fx;
+                px[c] = (u8)(top + (bottom - top) * fy + 0.5f);
+            }
+
+            px[3] = 255;
+        }
+    }
+}
+
+void bench_clip_free()
+{
+    svr_maybe_free((void**)&bench_clip_texture);
+}
+
+// Time is in video frames, so the clips move the same no matter how many sub-frames there are.
+void bench_clip_render(BenchClip* clip, double time, u8* dest, s32 dest_pitch)
+{
+    double move_time = svr_max(time - clip->still_frames, 0.0);
+
+    double pan = clip->pan_speed * move_time;
+    s32 pan_int = (s32)floor(pan);
+    s32 pan_frac = (s32)((pan - pan_int) * 256.0);
+
+    for (s32 y = 0; y < BENCH_CLIP_HEIGHT; y++)
+    {
+        const u8* row = bench_clip_texture + (y & (BENCH_CLIP_TEXTURE_SIZE - 1)) * BENCH_CLIP_TEXTURE_SIZE * 4;
+        u8* dest_row = dest + y * dest_pitch;
+
+        for (s32 x = 0; x < BENCH_CLIP_WIDTH; x++)
+        {
+            const u8* a = row + ((x + pan_int) & (BENCH_CLIP_TEXTURE_SIZE - 1)) * 4;
+            const u8* b = row + ((x + pan_int + 1) & (BENCH_CLIP_TEXTURE_SIZE - 1)) * 4;
+
+            for (s32 c = 0; c < 4; c++)
+            {
+                dest_row[x * 4 + c] = (u8)((a[c] * (256 - pan_frac) + b[c] * pan_frac + 128) >> 8);
+            }
+        }
+    }
+
+    if (clip->block_speed == 0.0f)
+    {
+        return;
+    }
+
+    // The block goes across the frame and starts over, with the edge pixels covered by the part of the block that is in them.
+    double block_x = fmod(clip->block_speed * move_time, (double)(BENCH_CLIP_WIDTH + BENCH_CLIP_BLOCK_SIZE)) - BENCH_CLIP_BLOCK_SIZE;
+    s32 block_y = (BENCH_CLIP_HEIGHT - BENCH_CLIP_BLOCK_SIZE) / 2;
+
+    s32 start_x = svr_max((s32)floor(block_x), 0);
+    s32 end_x = svr_min((s32)ceil(block_x + BENCH_CLIP_BLOCK_SIZE), BENCH_CLIP_WIDTH);
+
+    for (s32 x = start_x; x < end_x; x++)
+    {
+        double cover = svr_min(x + 1.0, block_x + BENCH_CLIP_BLOCK_SIZE) - svr_max((double)x, block_x);
+        s32 alpha = (s32)(cover * 256.0);
+
+        for (s32 y = block_y; y < block_y + BENCH_CLIP_BLOCK_SIZE; y++)
+        {
+            u8* px = dest + y * dest_pitch + x * 4;
+
+            px[0] = (u8)((px[0] * (256 - alpha) + 240 * alpha + 128) >> 8);
+            px[1] = (u8)((px[1] * (256 - alpha) + 40 * alpha + 128) >> 8);
+            px[2] = (u8)((px[2] * (256 - alpha) + 20 * alpha + 128) >> 8);
+        }
+    }
+}
+
+double bench_get_psnr(const u8* a, const u8* b, s32 pitch, s32 width, s32 height)
+{
+    double sum = 0.0;
+
+    for (s32 y = 0; y < height; y++)
+    {
+        for (s32 x = 0; x < width; x++)
+        {
+            const u8* pa = a + y * pitch + x * 4;
+            const u8* pb = b + y * pitch + x * 4;
+
+            for (s32 c = 0; c < 3; c++)
+            {
+                double d = (double)pa[c] - (double)pb[c];
+                sum += d * d;
+            }
+        }
+    }
+
+    double mse = sum / ((double)width * height * 3);
+
+    if (mse == 0.0)
+    {
+        return INFINITY;
+    }
+
+    return 10.0 * log10(255.0 * 255.0 / mse);
+}
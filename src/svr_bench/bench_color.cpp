@@ -0,0 +1,77 @@
+#include "bench_priv.h"
+#include "svr_color.h"
+
+// Speed of the processor color conversion for every pixel format and SIMD level, counted in bytes of BGRA source per second.
+
+const s32 BENCH_COLOR_WIDTH = 1920;
+const s32 BENCH_COLOR_HEIGHT = 1080;
+const s32 BENCH_COLOR_RUNS = 50;
+
+const char* BENCH_COLOR_FORMAT_NAMES[] =
+{
+    "nv12",
+    "yuv422p",
+    "yuv444p",
+};
+
+static void bench_color_run(SvrColorConversion* conv, SvrSimdLevel level, SvrWorkPool* pool, const char* pool_name)
+{
+    svr_color_convert(conv, level, pool); // Warm up.
+
+    s64 start = bench_get_time_ns();
+
+    for (s32 i = 0; i < BENCH_COLOR_RUNS; i++)
+    {
+        svr_color_convert(conv, level, pool);
+    }
+
+    s64 time = bench_get_time_ns() - start;
+    double bytes = (double)conv->width * conv->height * 4 * BENCH_COLOR_RUNS;
+
+    printf("Color %s %s %s: %.2f GB/s\n", BENCH_COLOR_FORMAT_NAMES[conv->format], svr_simd_get_level_name(level), pool_name, bytes / (double)time);
+}
+
+void bench_color()
+{
+    s32 src_pitch = BENCH_COLOR_WIDTH * 4;
+    u8* src = (u8*)svr_alloc(src_pitch * BENCH_COLOR_HEIGHT);
+
+    for (s32 i = 0; i < src_pitch * BENCH_COLOR_HEIGHT; i++)
+    {
+        src[i] = (u8)(i * 7);
+    }
+
+    SvrWorkPool* pool = svr_work_pool_create(0);
+
+    for (SvrPixelFormat format = SVR_PIXEL_FORMAT_NV12; format <= SVR_PIXEL_FORMAT_YUV444P; format++)
+    {
+        SvrColorConversion conv = {};
+        conv.format = format;
+        conv.width = BENCH_COLOR_WIDTH;
+        conv.height = BENCH_COLOR_HEIGHT;
+        conv.src = src;
+        conv.src_pitch = src_pitch;
+
+        for (s32 i = 0; i < svr_color_get_num_planes(format); i++)
+        {
+            SvrVec2I size = svr_color_get_plane_size(format, i, BENCH_COLOR_WIDTH, BENCH_COLOR_HEIGHT);
+            conv.planes[i] = (u8*)svr_alloc(size.x * size.y);
+            conv.pitches[i] = size.x;
+        }
+
+        for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+        {
+            bench_color_run(&conv, level, NULL, "1 thread");
+        }
+
+        bench_color_run(&conv, svr_simd_get_best_level(), pool, "pool");
+
+        for (s32 i = 0; i < svr_color_get_num_planes(format); i++)
+        {
+            svr_free(conv.planes[i]);
+        }
+    }
+
+    svr_work_pool_free(pool);
+    svr_free(src);
+}
@@ -0,0 +1,127 @@
+#include "bench_priv.h"
+#include "svr_copy.h"
+
+// Speed of copying the planes of a downloaded NV12 frame into a video frame, against one memcpy per row which is what the encoder did before.
+// The pitches differ like a mapped texture and an FFmpeg frame do, so the planes cannot be copied in one go.
+
+const s32 BENCH_COPY_RUNS = 50;
+
+struct BenchCopySize
+{
+    s32 width;
+    s32 height;
+};
+
+const BenchCopySize BENCH_COPY_SIZES[] =
+{
+    BenchCopySize { 1920, 1080 },
+    BenchCopySize { 3840, 2160 },
+};
+
+static s64 bench_copy_get_bytes(SvrCopyJob* job)
+{
+    s64 ret = 0;
+
+    for (s32 i = 0; i < job->num_planes; i++)
+    {
+        ret += (s64)job->planes[i].row_size * job->planes[i].num_rows;
+    }
+
+    return ret;
+}
+
+static void bench_copy_memcpy(SvrCopyJob* job)
+{
+    for (s32 i = 0; i < job->num_planes; i++)
+    {
+        SvrPlaneCopy* plane = &job->planes[i];
+
+        for (s32 y = 0; y < plane->num_rows; y++)
+        {
+            memcpy(plane->dest + (s64)y * plane->dest_pitch, plane->src + (s64)y * plane->src_pitch, plane->row_size);
+        }
+    }
+}
+
+static void bench_copy_print(const char* name, BenchCopySize size, SvrCopyJob* job, s64 time)
+{
+    double bytes = (double)bench_copy_get_bytes(job) * BENCH_COPY_RUNS;
+    printf("Copy %dx%d %s: %.2f GB/s\n", size.width, size.height, name, bytes / (double)time);
+}
+
+void bench_copy()
+{
+    SvrWorkPool* pool = svr_work_pool_create(0);
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(BENCH_COPY_SIZES); i++)
+    {
+        BenchCopySize size = BENCH_COPY_SIZES[i];
+
+        SvrCopyJob job = {};
+        job.num_planes = 2;
+
+        // Y plane and interleaved UV plane.
+        job.planes[0].row_size = size.width;
+        job.planes[0].num_rows = size.height;
+        job.planes[1].row_size = size.width;
+        job.planes[1].num_rows = size.height / 2;
+
+        for (s32 j = 0; j < job.num_planes; j++)
+        {
+            SvrPlaneCopy* plane = &job.planes[j];
+            plane->src_pitch = svr_align32(plane->row_size, 256);
+            plane->dest_pitch = svr_align32(plane->row_size + 32, 64);
+
+            u8* src = (u8*)svr_align_alloc(plane->src_pitch * plane->num_rows, 64);
+            memset(src, j + 1, plane->src_pitch * plane->num_rows);
+
+            plane->src = src;
+            plane->dest = (u8*)svr_align_alloc(plane->dest_pitch * plane->num_rows, 64);
+            memset(plane->dest, 0, plane->dest_pitch * plane->num_rows);
+        }
+
+        s64 start = bench_get_time_ns();
+
+        for (s32 j = 0; j < BENCH_COPY_RUNS; j++)
+        {
+            bench_copy_memcpy(&job);
+        }
+
+        bench_copy_print("memcpy rows", size, &job, bench_get_time_ns() - start);
+
+        for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= SVR_SIMD_SSE41 && level <= svr_simd_get_best_level(); level++)
+        {
+            job.level = level;
+
+            start = bench_get_time_ns();
+
+            for (s32 j = 0; j < BENCH_COPY_RUNS; j++)
+            {
+                svr_copy_planes(&job);
+            }
+
+            char buf[128];
+            SVR_SNPRINTF(buf, "%s 1 thread", svr_simd_get_level_name(level));
+            bench_copy_print(buf, size, &job, bench_get_time_ns() - start);
+        }
+
+        job.level = svr_simd_get_best_level();
+
+        start = bench_get_time_ns();
+
+        for (s32 j = 0; j < BENCH_COPY_RUNS; j++)
+        {
+            svr_copy_planes_parallel(&job, pool);
+        }
+
+        bench_copy_print("pool", size, &job, bench_get_time_ns() - start);
+
+        for (s32 j = 0; j < job.num_planes; j++)
+        {
+            svr_align_free((void*)job.planes[j].src, 64);
+            svr_align_free(job.planes[j].dest, 64);
+        }
+    }
+
+    svr_work_pool_free(pool);
+}
@@ -0,0 +1,68 @@
+#include "bench_priv.h"
+#include "svr_glyphs.h"
+
+// Speed of drawing the velo text at 1920x1080 for every SIMD level.
+// The atlas has cells of the default font size of 48 with a random coverage where a third is empty, which is about how much of a
+// real digit is outside of the stroke.
+
+const s32 BENCH_GLYPHS_WIDTH = 1920;
+const s32 BENCH_GLYPHS_HEIGHT = 1080;
+const s32 BENCH_GLYPHS_RUNS = 2000;
+
+static void bench_glyphs_level(SvrGlyphAtlas* atlas, bool border, SvrSimdLevel level, u8* frame, s64* samples)
+{
+    s32 pitch = BENCH_GLYPHS_WIDTH * 4;
+
+    SvrVec2I pos = { BENCH_GLYPHS_WIDTH / 2, BENCH_GLYPHS_HEIGHT - 100 };
+    SvrVec4I fill = { 255, 255, 255, 255 };
+    SvrVec4I border_color = { 0, 0, 0, border ? 255 : 0 };
+
+    for (s32 i = 0; i < BENCH_GLYPHS_RUNS; i++)
+    {
+        // The number changes every frame in a recording.
+        char digits[8];
+        SVR_SNPRINTF(digits, "%06d", 100000 + i * 37);
+
+        s64 start = bench_get_time_ns();
+
+        svr_glyph_draw_digits(atlas, digits, 6, pos, fill, border_color, frame, pitch, BENCH_GLYPHS_WIDTH, BENCH_GLYPHS_HEIGHT, level);
+
+        samples[i] = bench_get_time_ns() - start;
+    }
+
+    char buf[128];
+    SVR_SNPRINTF(buf, "Glyphs 6 digits %s %s", border ? "with border" : "no border", svr_simd_get_level_name(level));
+    bench_print_percentiles(buf, samples, BENCH_GLYPHS_RUNS, "ns");
+}
+
+void bench_glyphs()
+{
+    SvrGlyphAtlas atlas;
+    SvrVec2I origin = { 2, 40 };
+    svr_glyph_create_atlas(&atlas, 30, 52, origin, 27.0f, true);
+
+    srand(48);
+
+    s32 size = svr_glyph_get_atlas_pitch(&atlas) * atlas.cell_height;
+
+    for (s32 i = 0; i < size; i++)
+    {
+        atlas.fill[i] = (rand() % 3 == 0) ? 0 : (u8)rand();
+        atlas.border[i] = (rand() % 3 == 0) ? 0 : (u8)rand();
+    }
+
+    u8* frame = (u8*)svr_alloc(BENCH_GLYPHS_WIDTH * 4 * BENCH_GLYPHS_HEIGHT);
+    memset(frame, 0x40, BENCH_GLYPHS_WIDTH * 4 * BENCH_GLYPHS_HEIGHT);
+
+    s64* samples = (s64*)svr_alloc(sizeof(s64) * BENCH_GLYPHS_RUNS);
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        bench_glyphs_level(&atlas, false, level, frame, samples);
+        bench_glyphs_level(&atlas, true, level, frame, samples);
+    }
+
+    svr_free(samples);
+    svr_free(frame);
+    svr_glyph_free_atlas(&atlas);
+}
@@ -0,0 +1,304 @@
+#include "bench_priv.h"
+#include "encoder_shared.h"
+#include "encoder_host.h"
+
+// Round trip time of every kind of event between svr_game and svr_encoder, which is the cost of the transport alone.
+// The encoder side is the event loop of svr_encoder with a handler that does nothing, so all of the time is spent in the shared memory and in waking up.
+// The encoder runs on a thread that is started and stopped like svr_encoder_host.dll, and in another process like svr_encoder.exe,
+// to compare the overhead of the two. The process needs fork, so it is only measured on other platforms than Windows.
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+const s32 BENCH_IPC_ROUND_TRIPS = 5000;
+const s32 BENCH_IPC_QUIT_ROUND_TRIPS = 200; // Every quit needs a new encoder.
+
+using BenchIpcKind = s32;
+
+enum /* BenchIpcKind */
+{
+    BENCH_IPC_START, // ENCODER_EVENT_START, which waits on game_wake_event.
+    BENCH_IPC_STOP, // ENCODER_EVENT_STOP, which waits on game_wake_event.
+    BENCH_IPC_VIDEO, // One slot in the video ring, which waits on video_slot_event.
+    BENCH_IPC_AUDIO, // One block of ENCODER_MAX_SAMPLES samples in the audio ring, which waits on audio_space_event.
+    BENCH_IPC_QUIT, // ENCODER_EVENT_QUIT, which waits until the encoder has exited.
+
+    BENCH_IPC_NUM_KINDS,
+};
+
+const char* BENCH_IPC_KIND_NAMES[] =
+{
+    "start event",
+    "stop event",
+    "video slot",
+    "audio block",
+    "quit event",
+};
+
+// Connection to one encoder, like ProcEncoder.
+struct BenchIpcEncoder
+{
+    SvrIpcMem mem;
+    EncoderSharedMem* shared;
+    SvrIpcProcess encoder; // The thread of the encoder when it is hosted.
+    bool hosted;
+    EncoderHostParams host_params;
+};
+
+static void bench_ipc_handle_event(void* param)
+{
+    (void)param;
+}
+
+static void bench_ipc_handle_video_slot(void* param, s32 slot_idx)
+{
+    (void)param;
+    (void)slot_idx;
+}
+
+static void bench_ipc_handle_audio_samples(void* param, void* samples, s32 num_samples)
+{
+    (void)param;
+    (void)samples;
+    (void)num_samples;
+}
+
+// Opens the memory from the id and runs the event loop. The game process is NULL when on a thread.
+static void bench_ipc_encoder_run(const char* mem_id, bool hosted)
+{
+    SvrIpcMem mem = {};
+    SvrIpcProcess game = {};
+    EncoderSharedMem* shared;
+    EncoderSharedHandler handler = {};
+
+    if (!svr_ipc_open_mem(mem_id, &mem))
+    {
+        goto rexit;
+    }
+
+    shared = (EncoderSharedMem*)mem.ptr;
+
+    if (!hosted && !svr_ipc_open_process(shared->game_pid, &game))
+    {
+        goto rexit;
+    }
+
+    handler.start = bench_ipc_handle_event;
+    handler.stop = bench_ipc_handle_event;
+    handler.video_slot = bench_ipc_handle_video_slot;
+    handler.audio_samples = bench_ipc_handle_audio_samples;
+    handler.rings_read = bench_ipc_handle_event;
+    handler.game_exited = bench_ipc_handle_event;
+
+    encoder_shared_event_loop(shared, hosted ? NULL : &game, &handler);
+
+rexit:
+    svr_ipc_close_process(&game);
+    svr_ipc_free_mem(&mem);
+}
+
+static void bench_ipc_host_proc(void* param)
+{
+    EncoderHostParams* params = (EncoderHostParams*)param;
+    bench_ipc_encoder_run(params->shared_mem_id, true);
+}
+
+// Starts the encoder, like ProcState::encoder_launch.
+static bool bench_ipc_launch(BenchIpcEncoder* enc)
+{
+    svr_ipc_get_mem_id(&enc->mem, enc->host_params.shared_mem_id, sizeof(enc->host_params.shared_mem_id));
+
+    if (enc->hosted)
+    {
+        enc->encoder.handle = encoder_host_start_thread(bench_ipc_host_proc, &enc->host_params);
+        enc->encoder.pid = svr_ipc_get_current_pid();
+
+        return enc->encoder.handle != NULL;
+    }
+
+#ifndef _WIN32
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        bench_ipc_encoder_run(enc->host_params.shared_mem_id, false);
+        _exit(0);
+    }
+
+    return pid > 0 && svr_ipc_open_process((u32)pid, &enc->encoder);
+#else
+    return false;
+#endif
+}
+
+// Like ProcState::encoder_free_static, which waits until the encoder has exited.
+static void bench_ipc_quit(BenchIpcEncoder* enc)
+{
+    if (enc->hosted)
+    {
+        encoder_host_quit(enc->shared, &enc->encoder);
+        return;
+    }
+
+#ifndef _WIN32
+    encoder_shared_post_event(enc->shared, ENCODER_EVENT_QUIT);
+    svr_ipc_wait(&enc->shared->game_wake_event, &enc->encoder);
+
+    waitpid((pid_t)enc->encoder.pid, NULL, 0);
+    svr_ipc_close_process(&enc->encoder);
+#endif
+}
+
+// One round trip of the kind, done the same way as in ProcState. Returns false if the encoder is gone.
+static bool bench_ipc_round_trip(BenchIpcEncoder* enc, BenchIpcKind kind)
+{
+    EncoderSharedMem* shared = enc->shared;
+
+    switch (kind)
+    {
+        case BENCH_IPC_START:
+        case BENCH_IPC_STOP:
+        {
+            encoder_shared_post_event(shared, kind == BENCH_IPC_START ? ENCODER_EVENT_START : ENCODER_EVENT_STOP);
+
+            return svr_ipc_wait(&shared->game_wake_event, &enc->encoder) == SVR_IPC_WAIT_EVENT;
+        }
+
+        case BENCH_IPC_VIDEO:
+        {
+            s32 slot_idx;
+            svr_slot_ring_begin_write(&shared->video_ring, &slot_idx);
+            svr_slot_ring_end_write(&shared->video_ring);
+            svr_ipc_set_event(&shared->encoder_wake_event);
+
+            // The event may have been set for an earlier slot, so wait until this one is back.
+            while (svr_slot_ring_get_num_full(&shared->video_ring) > 0)
+            {
+                if (svr_ipc_wait(&shared->video_slot_event, &enc->encoder) == SVR_IPC_WAIT_EXITED)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        case BENCH_IPC_AUDIO:
+        {
+            s32 num_left = ENCODER_MAX_SAMPLES;
+
+            while (num_left > 0)
+            {
+                void* dest;
+                s32 num = svr_shared_ring_begin_write(&shared->audio_ring, &dest, num_left);
+                svr_shared_ring_end_write(&shared->audio_ring, num);
+                num_left -= num;
+            }
+
+            svr_ipc_set_event(&shared->encoder_wake_event);
+
+            while (svr_shared_ring_get_num_items(&shared->audio_ring) > 0)
+            {
+                if (svr_ipc_wait(&shared->audio_space_event, &enc->encoder) == SVR_IPC_WAIT_EXITED)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        case BENCH_IPC_QUIT:
+        {
+            bench_ipc_quit(enc);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void bench_ipc_run(bool hosted, const char* mode_name)
+{
+    BenchIpcEncoder enc = {};
+    enc.hosted = hosted;
+
+    s64* samples = SVR_ZALLOC_NUM(s64, BENCH_IPC_ROUND_TRIPS);
+    bool running = false;
+
+    if (!encoder_shared_create(&enc.mem, sizeof(u32)))
+    {
+        printf("Could not create the shared memory\n");
+        goto rexit;
+    }
+
+    enc.shared = (EncoderSharedMem*)enc.mem.ptr;
+
+    // Like encoder_set_shared_mem_params.
+    svr_slot_ring_restart(&enc.shared->video_ring);
+
+    for (BenchIpcKind kind = 0; kind < BENCH_IPC_NUM_KINDS; kind++)
+    {
+        // Every quit is timed with an encoder of its own, which has handled an event first so it is waiting.
+        s32 num = (kind == BENCH_IPC_QUIT) ? BENCH_IPC_QUIT_ROUND_TRIPS : BENCH_IPC_ROUND_TRIPS;
+
+        for (s32 i = 0; i < num; i++)
+        {
+            if (!running)
+            {
+                if (!bench_ipc_launch(&enc) || !bench_ipc_round_trip(&enc, BENCH_IPC_STOP))
+                {
+                    printf("Could not start the encoder %s\n", mode_name);
+                    goto rexit;
+                }
+
+                running = true;
+            }
+
+            s64 start = bench_get_time_ns();
+
+            if (!bench_ipc_round_trip(&enc, kind))
+            {
+                printf("Encoder %s is gone\n", mode_name);
+                running = false;
+                goto rexit;
+            }
+
+            samples[i] = bench_get_time_ns() - start;
+
+            if (kind == BENCH_IPC_QUIT)
+            {
+                running = false;
+            }
+        }
+
+        char buf[128];
+        SVR_SNPRINTF(buf, "Ipc %s %s round trip", mode_name, BENCH_IPC_KIND_NAMES[kind]);
+        bench_print_percentiles(buf, samples, num, "ns");
+    }
+
+rexit:
+    if (running)
+    {
+        bench_ipc_quit(&enc);
+    }
+
+    if (enc.shared)
+    {
+        encoder_shared_close_events(enc.shared);
+    }
+
+    svr_ipc_free_mem(&enc.mem);
+    svr_free(samples);
+}
+
+void bench_ipc()
+{
+    bench_ipc_run(true, "thread");
+
+#ifndef _WIN32
+    bench_ipc_run(false, "process");
+#endif
+}
@@ -0,0 +1,105 @@
+#include "bench_priv.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+struct BenchGroup
+{
+    const char* name;
+    void(*fn)();
+};
+
+BenchGroup BENCH_GROUPS[] =
+{
+    BenchGroup { "queue", bench_queue },
+    BenchGroup { "color", bench_color },
+    BenchGroup { "copy", bench_copy },
+    BenchGroup { "slot_ring", bench_slot_ring },
+    BenchGroup { "ipc", bench_ipc },
+    BenchGroup { "mosample", bench_mosample },
+    BenchGroup { "mosample_adaptive", bench_mosample_adaptive },
+    BenchGroup { "motion", bench_motion },
+    BenchGroup { "glyphs", bench_glyphs },
+    BenchGroup { "scan", bench_scan },
+    BenchGroup { "pe", bench_pe },
+    BenchGroup { "wave", bench_wave },
+};
+
+s64 bench_get_time_ns()
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+
+    return svr_rescale(now.QuadPart, 1000000000, freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (s64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+static int bench_compare_s64(const void* a, const void* b)
+{
+    s64 x = *(s64*)a;
+    s64 y = *(s64*)b;
+
+    return (x > y) - (x < y);
+}
+
+void bench_print_percentiles(const char* name, s64* samples, s32 num, const char* unit)
+{
+    qsort(samples, num, sizeof(s64), bench_compare_s64);
+
+    printf("%s p50: %lld %s\n", name, (long long)samples[num / 2], unit);
+    printf("%s p99: %lld %s\n", name, (long long)samples[svr_min(num - 1, (s32)((s64)num * 99 / 100))], unit);
+}
+
+static bool bench_run_group(const char* name)
+{
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(BENCH_GROUPS); i++)
+    {
+        BenchGroup* group = &BENCH_GROUPS[i];
+
+        if (!strcmp(group->name, name))
+        {
+            printf("# %s\n", group->name);
+            group->fn();
+            printf("\n");
+
+            fflush(stdout);
+            return true;
+        }
+    }
+
+    printf("No benchmark group named %s\n", name);
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    bool found = true;
+
+    printf("# %d cpus\n\n", svr_get_num_cpus());
+
+    if (argc < 2)
+    {
+        for (s32 i = 0; i < SVR_ARRAY_SIZE(BENCH_GROUPS); i++)
+        {
+            bench_run_group(BENCH_GROUPS[i].name);
+        }
+    }
+
+    for (s32 i = 1; i < argc; i++)
+    {
+        found &= bench_run_group(argv[i]);
+    }
+
+    return found ? 0 : 1;
+}
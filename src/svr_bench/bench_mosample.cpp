@@ -0,0 +1,77 @@
+#include "bench_priv.h"
+#include "svr_mosample.h"
+
+// Speed of the processor motion sampling at 1920x1080 for every SIMD level.
+// Adding is done for every sub-frame and downsampling once for every video frame, so the sub-frames per second decide the speed of a recording.
+
+const s32 BENCH_MOSAMPLE_WIDTH = 1920;
+const s32 BENCH_MOSAMPLE_HEIGHT = 1080;
+const s32 BENCH_MOSAMPLE_RUNS = 30;
+
+static void bench_mosample_print(const char* name, SvrSimdLevel level, const char* pool_name, s64 time)
+{
+    printf("Mosample %s %s %s: %.1f per second\n", name, svr_simd_get_level_name(level), pool_name, (double)BENCH_MOSAMPLE_RUNS / ((double)time / 1000000000.0));
+}
+
+static void bench_mosample_run(SvrMosampleBuffer* buf, u8* src, u8* dest, s32 pitch, SvrSimdLevel level, SvrWorkPool* pool, const char* pool_name)
+{
+    s64 start = bench_get_time_ns();
+
+    for (s32 i = 0; i < BENCH_MOSAMPLE_RUNS; i++)
+    {
+        svr_mosample_add(buf, src, pitch, 1.0f / BENCH_MOSAMPLE_RUNS, level, pool);
+    }
+
+    bench_mosample_print("sub-frames", level, pool_name, bench_get_time_ns() - start);
+
+    start = bench_get_time_ns();
+
+    for (s32 i = 0; i < BENCH_MOSAMPLE_RUNS; i++)
+    {
+        svr_mosample_downsample(buf, dest, pitch, level, pool);
+    }
+
+    bench_mosample_print("downsamples", level, pool_name, bench_get_time_ns() - start);
+}
+
+void bench_mosample()
+{
+    s32 pitch = BENCH_MOSAMPLE_WIDTH * 4;
+    u8* src = (u8*)svr_alloc(pitch * BENCH_MOSAMPLE_HEIGHT);
+    u8* dest = (u8*)svr_alloc(pitch * BENCH_MOSAMPLE_HEIGHT);
+
+    for (s32 i = 0; i < pitch * BENCH_MOSAMPLE_HEIGHT; i++)
+    {
+        src[i] = (u8)(i * 13);
+    }
+
+    SvrMosampleBuffer buf;
+    svr_mosample_create_buffer(&buf, BENCH_MOSAMPLE_WIDTH, BENCH_MOSAMPLE_HEIGHT);
+    svr_mosample_clear(&buf);
+
+    SvrWorkPool* pool = svr_work_pool_create(0);
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        bench_mosample_run(&buf, src, dest, pitch, level, NULL, "1 thread");
+    }
+
+    bench_mosample_run(&buf, src, dest, pitch, svr_simd_get_best_level(), pool, "pool");
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        s64 start = bench_get_time_ns();
+
+        for (s32 i = 0; i < BENCH_MOSAMPLE_RUNS; i++)
+        {
+            svr_mosample_get_difference(src, pitch, dest, pitch, BENCH_MOSAMPLE_WIDTH, BENCH_MOSAMPLE_HEIGHT, level);
+        }
+
+        bench_mosample_print("differences", level, "1 thread", bench_get_time_ns() - start);
+    }
+
+    svr_work_pool_free(pool);
+    svr_mosample_free_buffer(&buf);
+    svr_free(src);
+    svr_free(dest);
+}
@@ -0,0 +1,159 @@
+#include "bench_priv.h"
+#include "svr_mosample.h"
+#include <math.h>
+
+// Report of the adaptive motion sampling against blending every sub-frame, on synthetic clips.
+// The game frames stand for the render time, since the game renders every one of them and that is most of the time of a recording.
+// The error is the PSNR of the adaptive video frames against the ones with every sub-frame blended.
+// Frames are made the same way as proc_cpu: the difference is measured on every game frame before it is blended.
+
+const s32 BENCH_ADAPTIVE_VIDEO_FRAMES = 40;
+const s32 BENCH_ADAPTIVE_MULT = 60;
+const float BENCH_ADAPTIVE_EXPOSURE = 0.5f;
+const float BENCH_ADAPTIVE_LIMIT = 0.25f; // Same as the default profile.
+
+struct BenchAdaptiveRun
+{
+    s64 num_game_frames;
+    s64 work_time; // Time of the differences and blending, without making the game frames.
+    u8* video_frames; // Every video frame one after another.
+};
+
+static void bench_adaptive_record(BenchClip* clip, bool skip_closed, bool adaptive, BenchAdaptiveRun* run)
+{
+    s32 pitch = BENCH_CLIP_WIDTH * 4;
+    s32 frame_size = pitch * BENCH_CLIP_HEIGHT;
+
+    SvrMosampleShutter shutter = { BENCH_ADAPTIVE_MULT, BENCH_ADAPTIVE_EXPOSURE };
+
+    SvrMosampleSchedule sched;
+    svr_mosample_schedule_init(&sched, &shutter, 1, skip_closed);
+
+    if (adaptive)
+    {
+        svr_mosample_timer_set_adaptive(&sched.timers[0], BENCH_ADAPTIVE_LIMIT);
+    }
+
+    SvrMosampleBuffer buf;
+    svr_mosample_create_buffer(&buf, BENCH_CLIP_WIDTH, BENCH_CLIP_HEIGHT);
+
+    u8* frame = (u8*)svr_alloc(frame_size);
+    u8* prev_frame = (u8*)svr_alloc(frame_size);
+    bool has_prev = false;
+
+    SvrSimdLevel level = svr_simd_get_best_level();
+
+    run->num_game_frames = 0;
+    run->work_time = 0;
+    run->video_frames = (u8*)svr_alloc(frame_size * BENCH_ADAPTIVE_VIDEO_FRAMES);
+
+    s64 num_steps = 0;
+    s32 num_video_frames = 0;
+
+    while (num_video_frames < BENCH_ADAPTIVE_VIDEO_FRAMES)
+    {
+        // The game frame shows the time at its end.
+        num_steps += svr_mosample_schedule_get_steps(&sched, 0);
+        bench_clip_render(clip, (double)num_steps / sched.mult, frame, pitch);
+
+        run->num_game_frames++;
+
+        s64 start = bench_get_time_ns();
+
+        SvrMosampleScheduleStep sched_step;
+        svr_mosample_schedule_step(&sched, &sched_step);
+
+        if (adaptive)
+        {
+            if (has_prev)
+            {
+                float diff = svr_mosample_get_difference(frame, pitch, prev_frame, pitch, BENCH_CLIP_WIDTH, BENCH_CLIP_HEIGHT, level);
+                svr_mosample_timer_give_difference(&sched.timers[0], diff, sched_step.num_steps);
+            }
+
+            memcpy(prev_frame, frame, frame_size);
+            has_prev = true;
+        }
+
+        SvrMosampleStep* step = &sched_step.steps[0];
+
+        if (step->weight > 0.0f)
+        {
+            svr_mosample_add(&buf, frame, pitch, step->weight, level, NULL);
+        }
+
+        if (step->finish_frame)
+        {
+            svr_mosample_downsample(&buf, run->video_frames + num_video_frames * frame_size, pitch, level, NULL);
+            svr_mosample_clear(&buf);
+
+            num_video_frames++;
+        }
+
+        run->work_time += bench_get_time_ns() - start;
+    }
+
+    svr_mosample_free_buffer(&buf);
+    svr_free(frame);
+    svr_free(prev_frame);
+}
+
+static void bench_adaptive_clip(BenchClip* clip)
+{
+    s32 pitch = BENCH_CLIP_WIDTH * 4;
+    s32 frame_size = pitch * BENCH_CLIP_HEIGHT;
+
+    BenchAdaptiveRun full;
+    BenchAdaptiveRun skip;
+    BenchAdaptiveRun adaptive;
+    bench_adaptive_record(clip, false, false, &full);
+    bench_adaptive_record(clip, true, false, &skip);
+    bench_adaptive_record(clip, true, true, &adaptive);
+
+    // The video frames are one after another with the same pitch, so the whole clip is one tall image.
+    double clip_psnr = bench_get_psnr(full.video_frames, adaptive.video_frames, pitch, BENCH_CLIP_WIDTH, BENCH_CLIP_HEIGHT * BENCH_ADAPTIVE_VIDEO_FRAMES);
+    double skip_psnr = bench_get_psnr(full.video_frames, skip.video_frames, pitch, BENCH_CLIP_WIDTH, BENCH_CLIP_HEIGHT * BENCH_ADAPTIVE_VIDEO_FRAMES);
+
+    double min_psnr = INFINITY;
+
+    for (s32 i = 0; i < BENCH_ADAPTIVE_VIDEO_FRAMES; i++)
+    {
+        double psnr = bench_get_psnr(full.video_frames + i * frame_size, adaptive.video_frames + i * frame_size, pitch, BENCH_CLIP_WIDTH, BENCH_CLIP_HEIGHT);
+        min_psnr = svr_min(min_psnr, psnr);
+    }
+
+    printf("Mosample adaptive %s: %lld game frames, %.2fx fewer than all (%lld) and %.2fx fewer than skip closed (%lld)\n",
+           clip->name, (long long)adaptive.num_game_frames,
+           (double)full.num_game_frames / adaptive.num_game_frames, (long long)full.num_game_frames,
+           (double)skip.num_game_frames / adaptive.num_game_frames, (long long)skip.num_game_frames);
+
+    printf("Mosample adaptive %s: PSNR %.1f dB, worst frame %.1f dB (skip closed %.1f dB)\n", clip->name, clip_psnr, min_psnr, skip_psnr);
+
+    printf("Mosample adaptive %s: %.1f ms blending, %.1f ms with all\n", clip->name, adaptive.work_time / 1000000.0, full.work_time / 1000000.0);
+
+    svr_free(full.video_frames);
+    svr_free(skip.video_frames);
+    svr_free(adaptive.video_frames);
+}
+
+void bench_mosample_adaptive()
+{
+    bench_clip_init();
+
+    BenchClip clips[] =
+    {
+        BenchClip { "still", 0.0f, 0.0f, 0 },
+        BenchClip { "very slow pan", 0.5f, 0.0f, 0 },
+        BenchClip { "slow pan", 2.0f, 0.0f, 0 },
+        BenchClip { "fast pan", 40.0f, 0.0f, 0 },
+        BenchClip { "moving block", 0.0f, 12.0f, 0 },
+        BenchClip { "still then fast pan", 40.0f, 0.0f, BENCH_ADAPTIVE_VIDEO_FRAMES / 2 },
+    };
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(clips); i++)
+    {
+        bench_adaptive_clip(&clips[i]);
+    }
+
+    bench_clip_free();
+}
@@ -0,0 +1,190 @@
+#include "bench_priv.h"
+#include "svr_motion.h"
+#include "svr_mosample.h"
+#include <math.h>
+
+// Speed of the motion estimation and interpolation at 1920x1080 for every SIMD level, and the error of motion blur that is made from
+// few game frames with made sub-frames, against rendering every sub-frame.
+
+const s32 BENCH_MOTION_WIDTH = 1920;
+const s32 BENCH_MOTION_HEIGHT = 1080;
+const s32 BENCH_MOTION_RUNS = 5;
+
+const s32 BENCH_MOTION_VIDEO_FRAMES = 20;
+const s32 BENCH_MOTION_GAME_MULT = 8; // Game frames in a video frame.
+const s32 BENCH_MOTION_SYNTH = 8; // Sub-frames made from every game frame.
+const float BENCH_MOTION_EXPOSURE = 1.0f;
+
+static void bench_motion_speed()
+{
+    s32 pitch = BENCH_MOTION_WIDTH * 4;
+    u8* prev = (u8*)svr_alloc(pitch * BENCH_MOTION_HEIGHT);
+    u8* next = (u8*)svr_alloc(pitch * BENCH_MOTION_HEIGHT);
+    u8* dest = (u8*)svr_alloc(pitch * BENCH_MOTION_HEIGHT);
+
+    // Smooth pattern that has moved by a few pixels.
+    for (s32 y = 0; y < BENCH_MOTION_HEIGHT; y++)
+    {
+        for (s32 x = 0; x < pitch; x++)
+        {
+            prev[y * pitch + x] = (u8)(128.0f + 100.0f * sinf(x * 0.01f) * cosf(y * 0.013f));
+            next[y * pitch + x] = (u8)(128.0f + 100.0f * sinf((x + 28) * 0.01f) * cosf((y - 5) * 0.013f));
+        }
+    }
+
+    SvrMotionField field;
+    svr_motion_create_field(&field, BENCH_MOTION_WIDTH, BENCH_MOTION_HEIGHT);
+
+    SvrWorkPool* pool = svr_work_pool_create(0);
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        s64 start = bench_get_time_ns();
+
+        for (s32 i = 0; i < BENCH_MOTION_RUNS; i++)
+        {
+            svr_motion_estimate(&field, prev, pitch, next, pitch, level, NULL);
+        }
+
+        printf("Motion estimate %s 1 thread: %.1f ms\n", svr_simd_get_level_name(level), (bench_get_time_ns() - start) / 1000000.0 / BENCH_MOTION_RUNS);
+
+        start = bench_get_time_ns();
+
+        for (s32 i = 0; i < BENCH_MOTION_RUNS; i++)
+        {
+            svr_motion_interpolate(&field, prev, pitch, next, pitch, 0.5f, dest, pitch, level, NULL);
+        }
+
+        printf("Motion interpolate %s 1 thread: %.1f ms\n", svr_simd_get_level_name(level), (bench_get_time_ns() - start) / 1000000.0 / BENCH_MOTION_RUNS);
+    }
+
+    s64 start = bench_get_time_ns();
+
+    for (s32 i = 0; i < BENCH_MOTION_RUNS; i++)
+    {
+        svr_motion_estimate(&field, prev, pitch, next, pitch, svr_simd_get_best_level(), pool);
+    }
+
+    printf("Motion estimate %s pool: %.1f ms\n", svr_simd_get_level_name(svr_simd_get_best_level()), (bench_get_time_ns() - start) / 1000000.0 / BENCH_MOTION_RUNS);
+
+    svr_work_pool_free(pool);
+    svr_motion_free_field(&field);
+    svr_free(prev);
+    svr_free(next);
+    svr_free(dest);
+}
+
+// Records the clip with this many game frames in a video frame, making sub-frames from every game frame if synth is more than 1.
+static void bench_motion_record(BenchClip* clip, s32 mult, s32 synth, u8* video_frames, s64* work_time)
+{
+    s32 pitch = BENCH_CLIP_WIDTH * 4;
+    s32 frame_size = pitch * BENCH_CLIP_HEIGHT;
+
+    SvrMosampleTimer timer;
+    svr_mosample_timer_init(&timer, mult, BENCH_MOTION_EXPOSURE, false);
+
+    SvrMosampleBuffer buf;
+    svr_mosample_create_buffer(&buf, BENCH_CLIP_WIDTH, BENCH_CLIP_HEIGHT);
+
+    SvrMotionField field;
+    svr_motion_create_field(&field, BENCH_CLIP_WIDTH, BENCH_CLIP_HEIGHT);
+
+    u8* prev = (u8*)svr_alloc(frame_size);
+    u8* next = (u8*)svr_alloc(frame_size);
+    u8* temp = (u8*)svr_alloc(frame_size);
+
+    SvrSimdLevel level = svr_simd_get_best_level();
+
+    bench_clip_render(clip, 0.0, prev, pitch);
+
+    *work_time = 0;
+
+    s32 num_video_frames = 0;
+
+    for (s64 i = 1; num_video_frames < BENCH_MOTION_VIDEO_FRAMES; i++)
+    {
+        bench_clip_render(clip, (double)i / mult, next, pitch);
+
+        s64 start = bench_get_time_ns();
+
+        SvrMosampleStep step;
+        svr_mosample_timer_step(&timer, &step);
+
+        if (step.weight > 0.0f)
+        {
+            float open_part = svr_min(step.weight * timer.open_len / step.num_steps, 1.0f);
+            svr_motion_add_subframes(&field, &buf, prev, pitch, next, pitch, open_part, synth, step.weight, temp, level, NULL);
+        }
+
+        if (step.finish_frame)
+        {
+            svr_mosample_downsample(&buf, video_frames + num_video_frames * frame_size, pitch, level, NULL);
+            svr_mosample_clear(&buf);
+
+            num_video_frames++;
+        }
+
+        *work_time += bench_get_time_ns() - start;
+
+        memcpy(prev, next, frame_size);
+    }
+
+    svr_mosample_free_buffer(&buf);
+    svr_motion_free_field(&field);
+    svr_free(prev);
+    svr_free(next);
+    svr_free(temp);
+}
+
+static void bench_motion_clip(BenchClip* clip)
+{
+    s32 pitch = BENCH_CLIP_WIDTH * 4;
+    s32 frame_size = pitch * BENCH_CLIP_HEIGHT;
+    s32 all_mult = BENCH_MOTION_GAME_MULT * BENCH_MOTION_SYNTH;
+
+    u8* all_frames = (u8*)svr_alloc(frame_size * BENCH_MOTION_VIDEO_FRAMES);
+    u8* few_frames = (u8*)svr_alloc(frame_size * BENCH_MOTION_VIDEO_FRAMES);
+    u8* made_frames = (u8*)svr_alloc(frame_size * BENCH_MOTION_VIDEO_FRAMES);
+
+    s64 all_time;
+    s64 few_time;
+    s64 made_time;
+    bench_motion_record(clip, all_mult, 1, all_frames, &all_time);
+    bench_motion_record(clip, BENCH_MOTION_GAME_MULT, 1, few_frames, &few_time);
+    bench_motion_record(clip, BENCH_MOTION_GAME_MULT, BENCH_MOTION_SYNTH, made_frames, &made_time);
+
+    s32 height = BENCH_CLIP_HEIGHT * BENCH_MOTION_VIDEO_FRAMES;
+
+    printf("Motion synth %s: %d game frames %.1f dB, with %d made %.1f dB, against %d game frames\n", clip->name,
+           BENCH_MOTION_GAME_MULT, bench_get_psnr(all_frames, few_frames, pitch, BENCH_CLIP_WIDTH, height),
+           BENCH_MOTION_SYNTH, bench_get_psnr(all_frames, made_frames, pitch, BENCH_CLIP_WIDTH, height), all_mult);
+
+    printf("Motion synth %s: %.2f ms per video frame making and blending, %.2f ms blending all\n", clip->name,
+           made_time / 1000000.0 / BENCH_MOTION_VIDEO_FRAMES, all_time / 1000000.0 / BENCH_MOTION_VIDEO_FRAMES);
+
+    svr_free(all_frames);
+    svr_free(few_frames);
+    svr_free(made_frames);
+}
+
+void bench_motion()
+{
+    bench_motion_speed();
+
+    bench_clip_init();
+
+    BenchClip clips[] =
+    {
+        BenchClip { "slow pan", 4.0f, 0.0f, 0 },
+        BenchClip { "fast pan", 40.0f, 0.0f, 0 },
+        BenchClip { "moving block", 0.0f, 60.0f, 0 },
+        BenchClip { "pan and block", 16.0f, 100.0f, 0 },
+    };
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(clips); i++)
+    {
+        bench_motion_clip(&clips[i]);
+    }
+
+    bench_clip_free();
+}
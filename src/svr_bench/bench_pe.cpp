@@ -0,0 +1,221 @@
+#include "bench_priv.h"
+#include "svr_pe.h"
+#include "svr_scan.h"
+
+// Speed of searching only the code sections of a library against searching the whole image.
+// The image is made to look like a game library loaded in memory, with about the share of code, read only data, data and relocations
+// of client.dll, since no game library can be shipped. The code is random bytes where the bytes that are common in code are as common
+// as in code, and the rest is filled with what is common there: text and floats in read only data and mostly zeros in data.
+
+const u32 BENCH_PE_HEADERS_SIZE = 0x1000;
+const u32 BENCH_PE_CODE_SIZE = 14 * 1024 * 1024;
+const u32 BENCH_PE_RDATA_SIZE = 6 * 1024 * 1024;
+const u32 BENCH_PE_DATA_SIZE = 3 * 1024 * 1024;
+const u32 BENCH_PE_RELOC_SIZE = 1 * 1024 * 1024;
+const u32 BENCH_PE_IMAGE_SIZE = BENCH_PE_HEADERS_SIZE + BENCH_PE_CODE_SIZE + BENCH_PE_RDATA_SIZE + BENCH_PE_DATA_SIZE + BENCH_PE_RELOC_SIZE;
+
+const s32 BENCH_PE_NUM_FOUND = 80;
+const s32 BENCH_PE_NUM_MISSING = 5;
+const s32 BENCH_PE_NUM_PATTERNS = BENCH_PE_NUM_FOUND + BENCH_PE_NUM_MISSING;
+const s32 BENCH_PE_RUNS = 5;
+
+static const u8 BENCH_PE_CODE_BYTES[] = { 0x00, 0xff, 0xcc, 0x0f, 0x48, 0x89, 0x8b, 0xe8, 0x83, 0x85, 0x8d, 0x44, 0x24, 0x4c, 0xc3, 0x74 };
+
+static void bench_pe_write_u16(u8* dest, u16 value)
+{
+    memcpy(dest, &value, sizeof(value));
+}
+
+static void bench_pe_write_u32(u8* dest, u32 value)
+{
+    memcpy(dest, &value, sizeof(value));
+}
+
+static void bench_pe_write_section(u8* dest, const char* name, u32 rva, u32 size, u32 characteristics)
+{
+    memcpy(dest, name, strlen(name));
+    bench_pe_write_u32(dest + 8, size);
+    bench_pe_write_u32(dest + 12, rva);
+    bench_pe_write_u32(dest + 16, size);
+    bench_pe_write_u32(dest + 20, rva);
+    bench_pe_write_u32(dest + 36, characteristics);
+}
+
+static void bench_pe_make_image(u8* image)
+{
+    u32 rva = BENCH_PE_HEADERS_SIZE;
+    u8* code = image + rva;
+
+    for (u32 i = 0; i < BENCH_PE_CODE_SIZE; i++)
+    {
+        code[i] = (rand() % 2) ? BENCH_PE_CODE_BYTES[rand() % SVR_ARRAY_SIZE(BENCH_PE_CODE_BYTES)] : (u8)rand();
+    }
+
+    rva += BENCH_PE_CODE_SIZE;
+    u8* rdata = image + rva;
+
+    for (u32 i = 0; i < BENCH_PE_RDATA_SIZE; i += 4)
+    {
+        if (rand() % 2)
+        {
+            // Text.
+            for (s32 j = 0; j < 4; j++)
+            {
+                rdata[i + j] = (rand() % 8) ? (u8)('a' + rand() % 26) : 0;
+            }
+        }
+
+        else
+        {
+            float value = (float)(rand() % 2000) / 8.0f;
+            memcpy(rdata + i, &value, sizeof(value));
+        }
+    }
+
+    rva += BENCH_PE_RDATA_SIZE;
+    u8* data = image + rva;
+
+    for (u32 i = 0; i < BENCH_PE_DATA_SIZE; i++)
+    {
+        data[i] = (rand() % 8) ? 0 : (u8)rand();
+    }
+
+    rva += BENCH_PE_DATA_SIZE;
+    u8* reloc = image + rva;
+
+    for (u32 i = 0; i < BENCH_PE_RELOC_SIZE; i += 2)
+    {
+        bench_pe_write_u16(reloc + i, (u16)(0xa000 | (rand() & 0xfff)));
+    }
+
+    // The headers last so the sections do not write over them.
+    const s32 NT_POS = 0x40;
+    const s32 OPT_SIZE = 240;
+
+    memset(image, 0, BENCH_PE_HEADERS_SIZE);
+    image[0] = 'M';
+    image[1] = 'Z';
+    bench_pe_write_u32(image + 0x3c, NT_POS);
+
+    u8* nt = image + NT_POS;
+    memcpy(nt, "PE\0\0", 4);
+    bench_pe_write_u16(nt + 4, 0x8664);
+    bench_pe_write_u16(nt + 4 + 2, 4);
+    bench_pe_write_u16(nt + 4 + 16, OPT_SIZE);
+    bench_pe_write_u32(nt + 24 + 56, BENCH_PE_IMAGE_SIZE);
+
+    u8* sections = nt + 24 + OPT_SIZE;
+    rva = BENCH_PE_HEADERS_SIZE;
+
+    bench_pe_write_section(sections, ".text", rva, BENCH_PE_CODE_SIZE, SVR_PE_SECTION_CODE | SVR_PE_SECTION_EXECUTE);
+    rva += BENCH_PE_CODE_SIZE;
+    bench_pe_write_section(sections + 40, ".rdata", rva, BENCH_PE_RDATA_SIZE, SVR_PE_SECTION_INIT_DATA);
+    rva += BENCH_PE_RDATA_SIZE;
+    bench_pe_write_section(sections + 80, ".data", rva, BENCH_PE_DATA_SIZE, SVR_PE_SECTION_INIT_DATA);
+    rva += BENCH_PE_DATA_SIZE;
+    bench_pe_write_section(sections + 120, ".reloc", rva, BENCH_PE_RELOC_SIZE, SVR_PE_SECTION_INIT_DATA);
+}
+
+static void bench_pe_make_patterns(const u8* image, SvrScanPattern* patterns)
+{
+    for (s32 i = 0; i < BENCH_PE_NUM_PATTERNS; i++)
+    {
+        SvrScanPattern* pattern = &patterns[i];
+        *pattern = {};
+        pattern->size = 8 + rand() % 24;
+
+        s64 start = BENCH_PE_HEADERS_SIZE + ((s64)rand() * 32768 + rand()) % (BENCH_PE_CODE_SIZE - pattern->size);
+
+        for (s32 j = 0; j < pattern->size; j++)
+        {
+            // Game patterns have unknown bytes for addresses and offsets.
+            if (j > 0 && rand() % 4 == 0)
+            {
+                continue;
+            }
+
+            pattern->bytes[j] = i < BENCH_PE_NUM_FOUND ? image[start + j] : (u8)rand();
+            pattern->mask[j] = 0xff;
+        }
+
+        pattern->anchor = 0;
+    }
+}
+
+void bench_pe()
+{
+    srand(BENCH_PE_IMAGE_SIZE);
+
+    u8* image = (u8*)svr_alloc(BENCH_PE_IMAGE_SIZE);
+    bench_pe_make_image(image);
+
+    SvrScanPattern* patterns = (SvrScanPattern*)svr_alloc(sizeof(SvrScanPattern) * BENCH_PE_NUM_PATTERNS);
+    bench_pe_make_patterns(image, patterns);
+
+    s64* whole_offsets = (s64*)svr_alloc(sizeof(s64) * BENCH_PE_NUM_PATTERNS);
+    s64* code_offsets = (s64*)svr_alloc(sizeof(s64) * BENCH_PE_NUM_PATTERNS);
+
+    SvrSimdLevel level = svr_simd_get_best_level();
+
+    // Reading the headers is done every time a library is searched, so it must not cost anything next to the search.
+    s64 start = bench_get_time_ns();
+
+    SvrPeInfo info;
+    SvrPeRange pe_ranges[SVR_PE_MAX_SECTIONS];
+    s32 num_ranges = 0;
+
+    for (s32 i = 0; i < BENCH_PE_RUNS; i++)
+    {
+        svr_pe_read_info(image, BENCH_PE_IMAGE_SIZE, &info);
+        num_ranges = svr_pe_get_ranges(&info, SVR_PE_RANGE_CODE, pe_ranges, SVR_ARRAY_SIZE(pe_ranges));
+    }
+
+    printf("Pe read headers and code ranges: %.2f us\n", (bench_get_time_ns() - start) / 1000.0 / BENCH_PE_RUNS);
+
+    SvrScanRange ranges[SVR_PE_MAX_SECTIONS];
+    s64 code_bytes = 0;
+
+    for (s32 i = 0; i < num_ranges; i++)
+    {
+        ranges[i].start = pe_ranges[i].start;
+        ranges[i].end = pe_ranges[i].end;
+        code_bytes += ranges[i].end - ranges[i].start;
+    }
+
+    start = bench_get_time_ns();
+
+    for (s32 i = 0; i < BENCH_PE_RUNS; i++)
+    {
+        svr_scan_find_all(image, BENCH_PE_IMAGE_SIZE, patterns, BENCH_PE_NUM_PATTERNS, whole_offsets, level);
+    }
+
+    double whole_time = (bench_get_time_ns() - start) / 1000000.0 / BENCH_PE_RUNS;
+
+    start = bench_get_time_ns();
+
+    for (s32 i = 0; i < BENCH_PE_RUNS; i++)
+    {
+        svr_scan_find_all_in_ranges(image, ranges, num_ranges, patterns, BENCH_PE_NUM_PATTERNS, code_offsets, level);
+    }
+
+    double code_time = (bench_get_time_ns() - start) / 1000000.0 / BENCH_PE_RUNS;
+
+    s32 num_outside = 0;
+
+    for (s32 i = 0; i < BENCH_PE_NUM_PATTERNS; i++)
+    {
+        if (whole_offsets[i] != code_offsets[i])
+        {
+            num_outside++;
+        }
+    }
+
+    printf("Pe search whole image %s: %.1f MB in %.1f ms\n", svr_simd_get_level_name(level), BENCH_PE_IMAGE_SIZE / 1048576.0, whole_time);
+    printf("Pe search code ranges %s: %.1f MB in %.1f ms\n", svr_simd_get_level_name(level), code_bytes / 1048576.0, code_time);
+    printf("Pe patterns first found outside of code in the whole image: %d of %d\n", num_outside, BENCH_PE_NUM_PATTERNS);
+
+    svr_free(code_offsets);
+    svr_free(whole_offsets);
+    svr_free(patterns);
+    svr_free(image);
+}
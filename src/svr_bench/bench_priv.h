@@ -0,0 +1,53 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_alloc.h"
+#include "svr_atom.h"
+#include "svr_thread.h"
+#include "svr_work_pool.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Benchmarks of the parts of svr_common that can be built everywhere, built as svr_bench.
+// Every group is a function that times one module and prints one line per result as "name: value unit",
+// the same way as profiling.txt so results can be pasted there.
+// The groups to run are given on the command line, or all of them when there are none.
+
+s64 bench_get_time_ns();
+
+// Prints the 50th and 99th percentile of the samples, which are sorted in place.
+void bench_print_percentiles(const char* name, s64* samples, s32 num, const char* unit);
+
+// Synthetic clips for the motion blur reports, in bench_clip.cpp.
+const s32 BENCH_CLIP_WIDTH = 320;
+const s32 BENCH_CLIP_HEIGHT = 180;
+
+struct BenchClip
+{
+    const char* name;
+    float pan_speed; // Pixels per video frame that the background moves.
+    float block_speed; // Pixels per video frame that the block moves.
+    s32 still_frames; // Video frames at the start where nothing moves.
+};
+
+void bench_clip_init();
+void bench_clip_free();
+
+// Draws the clip at a time in video frames to 32 bpp pixels.
+void bench_clip_render(BenchClip* clip, double time, u8* dest, s32 dest_pitch);
+
+// Peak signal to noise ratio of the color channels in decibels, or infinity if the frames are the same.
+double bench_get_psnr(const u8* a, const u8* b, s32 pitch, s32 width, s32 height);
+
+void bench_queue();
+void bench_color();
+void bench_copy();
+void bench_slot_ring();
+void bench_ipc();
+void bench_mosample();
+void bench_mosample_adaptive();
+void bench_motion();
+void bench_glyphs();
+void bench_scan();
+void bench_pe();
+void bench_wave();
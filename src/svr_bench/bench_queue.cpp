@@ -0,0 +1,181 @@
+#include "bench_priv.h"
+#include "svr_ring.h"
+#include "svr_locked_queue.h"
+
+// Throughput and latency of the lock free rings against the locked queue they replaced in the encoder.
+// Waiting threads yield instead of sleeping on a doorbell, so the time is spent in the queues and not in the wakeups.
+
+const s32 BENCH_QUEUE_CAPACITY = 1024;
+const s32 BENCH_QUEUE_ITEMS = 2000000; // Total for the throughput runs.
+const s32 BENCH_QUEUE_ROUND_TRIPS = 20000;
+const s32 BENCH_QUEUE_THREADS = 2; // Producers and consumers each for the several thread runs.
+
+// The locked queue grows instead of getting full, so pushing always works.
+template <class T>
+static bool bench_queue_push(SvrLockedQueue<T>* queue, T* item)
+{
+    queue->push(item);
+    return true;
+}
+
+template <class T>
+static bool bench_queue_push(SvrSpscRing<T>* ring, T* item)
+{
+    return ring->push(item);
+}
+
+template <class T>
+static bool bench_queue_push(SvrMpmcRing<T>* ring, T* item)
+{
+    return ring->push(item);
+}
+
+template <class Queue>
+struct BenchQueueState
+{
+    Queue queue;
+    Queue reply; // For the round trips.
+    s32 items_per_thread;
+    SvrAtom32 num_pulled;
+    s32 num_items;
+};
+
+template <class Queue>
+static void bench_queue_producer(void* param)
+{
+    BenchQueueState<Queue>* state = (BenchQueueState<Queue>*)param;
+
+    for (s32 i = 0; i < state->items_per_thread; i++)
+    {
+        u64 item = i;
+
+        while (!bench_queue_push(&state->queue, &item))
+        {
+            svr_thread_yield();
+        }
+    }
+}
+
+template <class Queue>
+static void bench_queue_consumer(void* param)
+{
+    BenchQueueState<Queue>* state = (BenchQueueState<Queue>*)param;
+
+    while (svr_atom_load(&state->num_pulled) < state->num_items)
+    {
+        u64 item;
+
+        if (!state->queue.pull(&item))
+        {
+            svr_thread_yield();
+            continue;
+        }
+
+        svr_atom_add(&state->num_pulled, 1);
+    }
+}
+
+template <class Queue>
+static void bench_queue_throughput(const char* name, s32 num_threads)
+{
+    BenchQueueState<Queue>* state = SVR_ZALLOC(BenchQueueState<Queue>);
+    state->queue.init(BENCH_QUEUE_CAPACITY);
+    state->items_per_thread = BENCH_QUEUE_ITEMS / num_threads;
+    state->num_items = state->items_per_thread * num_threads;
+
+    SvrThread threads[BENCH_QUEUE_THREADS * 2] = {};
+
+    s64 start = bench_get_time_ns();
+
+    for (s32 i = 0; i < num_threads; i++)
+    {
+        svr_thread_start(&threads[i * 2], bench_queue_consumer<Queue>, state);
+        svr_thread_start(&threads[i * 2 + 1], bench_queue_producer<Queue>, state);
+    }
+
+    for (s32 i = 0; i < num_threads * 2; i++)
+    {
+        svr_thread_join(&threads[i]);
+    }
+
+    s64 time = bench_get_time_ns() - start;
+
+    printf("%s throughput: %.2f million items/s\n", name, (double)state->num_items / ((double)time / 1000.0));
+
+    state->queue.free();
+    svr_free(state);
+}
+
+template <class Queue>
+static void bench_queue_echo(void* param)
+{
+    BenchQueueState<Queue>* state = (BenchQueueState<Queue>*)param;
+
+    for (s32 i = 0; i < BENCH_QUEUE_ROUND_TRIPS; i++)
+    {
+        u64 item;
+
+        while (!state->queue.pull(&item))
+        {
+            svr_thread_yield();
+        }
+
+        while (!bench_queue_push(&state->reply, &item))
+        {
+            svr_thread_yield();
+        }
+    }
+}
+
+// Time from pushing an item until the reply from the other thread has been pulled.
+template <class Queue>
+static void bench_queue_latency(const char* name)
+{
+    BenchQueueState<Queue>* state = SVR_ZALLOC(BenchQueueState<Queue>);
+    state->queue.init(BENCH_QUEUE_CAPACITY);
+    state->reply.init(BENCH_QUEUE_CAPACITY);
+
+    s64* samples = SVR_ZALLOC_NUM(s64, BENCH_QUEUE_ROUND_TRIPS);
+
+    SvrThread echo = {};
+    svr_thread_start(&echo, bench_queue_echo<Queue>, state);
+
+    for (s32 i = 0; i < BENCH_QUEUE_ROUND_TRIPS; i++)
+    {
+        u64 item = i;
+        s64 start = bench_get_time_ns();
+
+        bench_queue_push(&state->queue, &item);
+
+        while (!state->reply.pull(&item))
+        {
+            svr_thread_yield();
+        }
+
+        samples[i] = bench_get_time_ns() - start;
+    }
+
+    svr_thread_join(&echo);
+
+    char buf[128];
+    SVR_SNPRINTF(buf, "%s round trip", name);
+    bench_print_percentiles(buf, samples, BENCH_QUEUE_ROUND_TRIPS, "ns");
+
+    svr_free(samples);
+    state->queue.free();
+    state->reply.free();
+    svr_free(state);
+}
+
+void bench_queue()
+{
+    bench_queue_throughput<SvrLockedQueue<u64>>("Locked queue 1:1", 1);
+    bench_queue_throughput<SvrSpscRing<u64>>("Spsc ring 1:1", 1);
+    bench_queue_throughput<SvrMpmcRing<u64>>("Mpmc ring 1:1", 1);
+    bench_queue_throughput<SvrLockedQueue<u64>>("Locked queue 2:2", BENCH_QUEUE_THREADS);
+    bench_queue_throughput<SvrMpmcRing<u64>>("Mpmc ring 2:2", BENCH_QUEUE_THREADS);
+
+    bench_queue_latency<SvrLockedQueue<u64>>("Locked queue");
+    bench_queue_latency<SvrSpscRing<u64>>("Spsc ring");
+    bench_queue_latency<SvrMpmcRing<u64>>("Mpmc ring");
+}
@@ -0,0 +1,112 @@
+#include "bench_priv.h"
+#include "svr_scan.h"
+
+// Speed of finding the game patterns, against searching for every pattern on its own like before.
+// The data is random bytes where the bytes that are common in code are as common as in a game library, since no game library can be shipped.
+// Most patterns are taken from the data so they are found somewhere in it, and a few are not in it so the search goes to the end.
+
+const s32 BENCH_SCAN_DATA_SIZE = 16 * 1024 * 1024;
+const s32 BENCH_SCAN_NUM_FOUND = 80;
+const s32 BENCH_SCAN_NUM_MISSING = 5;
+const s32 BENCH_SCAN_NUM_PATTERNS = BENCH_SCAN_NUM_FOUND + BENCH_SCAN_NUM_MISSING;
+
+static const u8 BENCH_SCAN_COMMON_BYTES[] = { 0x00, 0xff, 0xcc, 0x0f, 0x48, 0x89, 0x8b, 0xe8, 0x83, 0x85, 0x8d, 0x44, 0x24, 0x4c, 0xc3, 0x74 };
+
+static u8 bench_scan_get_byte()
+{
+    // Half of the bytes are one of the common ones.
+    if (rand() % 2)
+    {
+        return BENCH_SCAN_COMMON_BYTES[rand() % SVR_ARRAY_SIZE(BENCH_SCAN_COMMON_BYTES)];
+    }
+
+    return (u8)rand();
+}
+
+static void bench_scan_make_pattern(const u8* data, s32 size, bool missing, SvrScanPattern* out)
+{
+    char text[SVR_SCAN_MAX_BYTES * 3 + 1];
+    s32 len = 0;
+
+    for (s32 i = 0; i < size; i++)
+    {
+        // Game patterns have unknown bytes for addresses and offsets.
+        if (i > 0 && rand() % 4 == 0)
+        {
+            len += stbsp_snprintf(text + len, sizeof(text) - len, "?? ");
+        }
+
+        else
+        {
+            len += stbsp_snprintf(text + len, sizeof(text) - len, "%02X ", missing ? bench_scan_get_byte() : data[i]);
+        }
+    }
+
+    svr_scan_compile_pattern(text, out);
+}
+
+// How the patterns were found before, one pass for every pattern until it is found.
+static void bench_scan_find_each(const u8* data, const SvrScanPattern* patterns, s64* offsets)
+{
+    for (s32 i = 0; i < BENCH_SCAN_NUM_PATTERNS; i++)
+    {
+        offsets[i] = -1;
+
+        for (s64 pos = 0; pos + patterns[i].size <= BENCH_SCAN_DATA_SIZE; pos++)
+        {
+            if (svr_scan_compare(data + pos, &patterns[i]))
+            {
+                offsets[i] = pos;
+                break;
+            }
+        }
+    }
+}
+
+void bench_scan()
+{
+    srand(BENCH_SCAN_DATA_SIZE);
+
+    u8* data = (u8*)svr_alloc(BENCH_SCAN_DATA_SIZE);
+
+    for (s32 i = 0; i < BENCH_SCAN_DATA_SIZE; i++)
+    {
+        data[i] = bench_scan_get_byte();
+    }
+
+    SvrScanPattern* patterns = (SvrScanPattern*)svr_alloc(sizeof(SvrScanPattern) * BENCH_SCAN_NUM_PATTERNS);
+    s64* reference = (s64*)svr_alloc(sizeof(s64) * BENCH_SCAN_NUM_PATTERNS);
+    s64* offsets = (s64*)svr_alloc(sizeof(s64) * BENCH_SCAN_NUM_PATTERNS);
+
+    s64 start = bench_get_time_ns();
+
+    for (s32 i = 0; i < BENCH_SCAN_NUM_PATTERNS; i++)
+    {
+        s32 size = 8 + rand() % 24;
+        s32 pos = (s32)(((s64)rand() * 32768 + rand()) % (BENCH_SCAN_DATA_SIZE - size));
+
+        bench_scan_make_pattern(data + pos, size, i >= BENCH_SCAN_NUM_FOUND, &patterns[i]);
+    }
+
+    printf("Scan make and compile %d patterns: %.1f us\n", BENCH_SCAN_NUM_PATTERNS, (bench_get_time_ns() - start) / 1000.0);
+
+    start = bench_get_time_ns();
+    bench_scan_find_each(data, patterns, reference);
+    printf("Scan each pattern on its own: %.1f ms\n", (bench_get_time_ns() - start) / 1000000.0);
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        start = bench_get_time_ns();
+        svr_scan_find_all(data, BENCH_SCAN_DATA_SIZE, patterns, BENCH_SCAN_NUM_PATTERNS, offsets, level);
+        s64 time = bench_get_time_ns() - start;
+
+        bool same = !memcmp(offsets, reference, sizeof(s64) * BENCH_SCAN_NUM_PATTERNS);
+
+        printf("Scan all patterns %s: %.1f ms%s\n", svr_simd_get_level_name(level), time / 1000000.0, same ? "" : " (different offsets)");
+    }
+
+    svr_free(offsets);
+    svr_free(reference);
+    svr_free(patterns);
+    svr_free(data);
+}
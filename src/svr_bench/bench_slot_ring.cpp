@@ -0,0 +1,88 @@
+#include "bench_priv.h"
+#include "svr_slot_ring.h"
+
+// How much the number of shared texture slots lets svr_game run ahead of svr_encoder.
+// The game takes the same time for every frame, and the encoder is as fast on average but uneven, like when the encoder
+// sometimes waits for the video workers. With one slot every slow frame in the encoder holds up the game.
+// The work is made by waiting with yields instead of spinning, since the real work happens on the GPU and in other threads.
+
+const s32 BENCH_SLOT_RING_FRAMES = 2000;
+const s64 BENCH_SLOT_RING_GAME_NS = 50000;
+const s64 BENCH_SLOT_RING_ENCODER_NS[] = { 10000, 10000, 10000, 170000 }; // Repeats, average is the same as the game.
+
+struct BenchSlotRingState
+{
+    SvrSlotRing ring;
+    s64 game_wait_ns; // Time the game spent waiting for a free slot.
+};
+
+static void bench_slot_ring_work(s64 ns)
+{
+    s64 end = bench_get_time_ns() + ns;
+
+    while (bench_get_time_ns() < end)
+    {
+        svr_thread_yield();
+    }
+}
+
+static void bench_slot_ring_encoder(void* param)
+{
+    BenchSlotRingState* state = (BenchSlotRingState*)param;
+    s32 num_read = 0;
+
+    while (!svr_slot_ring_is_done(&state->ring))
+    {
+        s32 slot;
+
+        if (!svr_slot_ring_begin_read(&state->ring, &slot, NULL))
+        {
+            svr_thread_yield();
+            continue;
+        }
+
+        bench_slot_ring_work(BENCH_SLOT_RING_ENCODER_NS[num_read % SVR_ARRAY_SIZE(BENCH_SLOT_RING_ENCODER_NS)]);
+        num_read++;
+
+        svr_slot_ring_end_read(&state->ring);
+    }
+}
+
+void bench_slot_ring()
+{
+    for (s32 num_slots = 1; num_slots <= 8; num_slots *= 2)
+    {
+        BenchSlotRingState state = {};
+        svr_slot_ring_init(&state.ring, num_slots);
+
+        SvrThread encoder = {};
+        svr_thread_start(&encoder, bench_slot_ring_encoder, &state);
+
+        s64 start = bench_get_time_ns();
+
+        for (s32 i = 0; i < BENCH_SLOT_RING_FRAMES; i++)
+        {
+            bench_slot_ring_work(BENCH_SLOT_RING_GAME_NS);
+
+            s32 slot;
+            s64 wait_start = bench_get_time_ns();
+
+            while (!svr_slot_ring_begin_write(&state.ring, &slot))
+            {
+                svr_thread_yield();
+            }
+
+            state.game_wait_ns += bench_get_time_ns() - wait_start;
+
+            svr_slot_ring_end_write(&state.ring);
+        }
+
+        svr_slot_ring_stop(&state.ring);
+        svr_thread_join(&encoder);
+
+        s64 time = bench_get_time_ns() - start;
+
+        printf("Slot ring %d slots: %.0f frames/s, game waited %.1f us per frame\n", num_slots,
+               (double)BENCH_SLOT_RING_FRAMES / ((double)time / 1000000000.0), (double)state.game_wait_ns / 1000.0 / BENCH_SLOT_RING_FRAMES);
+    }
+}
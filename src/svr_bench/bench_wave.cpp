@@ -0,0 +1,80 @@
+#include "bench_priv.h"
+#include "svr_wave.h"
+
+// Speed of converting 32 bit samples to 16 bit for every SIMD level.
+// The counts are odd so every level ends with values that the scalar level has to do, such as the 735 samples of one
+// 60 fps frame at 44100 hz, and the few samples of a motion blur sub-frame. The buffers are used both aligned and moved off
+// the vector size, since the samples come from wherever the game has them.
+
+const s32 BENCH_WAVE_MAX_SAMPLES = 4095;
+const s32 BENCH_WAVE_TOTAL_SAMPLES = 1 << 23; // Converted for every result, so the short counts are repeated more.
+
+const s32 BENCH_WAVE_COUNTS[] = { 13, 735, 1601, BENCH_WAVE_MAX_SAMPLES };
+
+// Returns the samples per second.
+static double bench_wave_level(const SvrWaveS32* src, SvrWaveS16* dest, s32 num_samples, SvrSimdLevel level)
+{
+    s32 runs = BENCH_WAVE_TOTAL_SAMPLES / num_samples;
+
+    // Once first so the memory is warm.
+    svr_wave_convert(src, SVR_WAVE_FORMAT_S32, dest, num_samples, level);
+
+    s64 start = bench_get_time_ns();
+
+    for (s32 i = 0; i < runs; i++)
+    {
+        svr_wave_convert(src, SVR_WAVE_FORMAT_S32, dest, num_samples, level);
+    }
+
+    s64 time = svr_max(bench_get_time_ns() - start, (s64)1);
+
+    return (double)runs * num_samples * 1000000000.0 / time;
+}
+
+void bench_wave()
+{
+    // Room to move both buffers off the vector size.
+    u8* src_mem = (u8*)svr_alloc(sizeof(SvrWaveS32) * BENCH_WAVE_MAX_SAMPLES + 64);
+    u8* dest_mem = (u8*)svr_alloc(sizeof(SvrWaveS16) * BENCH_WAVE_MAX_SAMPLES + 64);
+
+    u8* src_aligned = (u8*)(((uintptr_t)src_mem + 31) & ~(uintptr_t)31);
+    u8* dest_aligned = (u8*)(((uintptr_t)dest_mem + 31) & ~(uintptr_t)31);
+
+    srand(16);
+
+    // Mostly inside 16 bits with some that have to be clipped, like a loud mix.
+    for (s32 i = 0; i < BENCH_WAVE_MAX_SAMPLES * 2 + 1; i++)
+    {
+        ((s32*)src_aligned)[i] = (rand() % 80000) - 40000;
+    }
+
+    for (s32 c = 0; c < SVR_ARRAY_SIZE(BENCH_WAVE_COUNTS); c++)
+    {
+        s32 num_samples = BENCH_WAVE_COUNTS[c];
+
+        for (s32 unaligned = 0; unaligned < 2; unaligned++)
+        {
+            // One value off, which keeps the alignment of the types but not of the vectors.
+            const SvrWaveS32* src = (const SvrWaveS32*)(src_aligned + (unaligned ? sizeof(s32) : 0));
+            SvrWaveS16* dest = (SvrWaveS16*)(dest_aligned + (unaligned ? sizeof(s16) : 0));
+
+            double scalar_rate = 0.0;
+
+            for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+            {
+                double rate = bench_wave_level(src, dest, num_samples, level);
+
+                if (level == SVR_SIMD_SCALAR)
+                {
+                    scalar_rate = rate;
+                }
+
+                printf("Wave s32 %d samples %s %s: %0.1f M samples/s (%0.2fx scalar)\n",
+                       num_samples, unaligned ? "unaligned" : "aligned", svr_simd_get_level_name(level), rate / 1000000.0, rate / scalar_rate);
+            }
+        }
+    }
+
+    svr_free(dest_mem);
+    svr_free(src_mem);
+}
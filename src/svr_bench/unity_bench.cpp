@@ -0,0 +1,15 @@
+#include "bench_priv.h"
+#include "bench_main.cpp"
+#include "bench_clip.cpp"
+#include "bench_queue.cpp"
+#include "bench_color.cpp"
+#include "bench_copy.cpp"
+#include "bench_slot_ring.cpp"
+#include "bench_ipc.cpp"
+#include "bench_mosample.cpp"
+#include "bench_mosample_adaptive.cpp"
+#include "bench_motion.cpp"
+#include "bench_glyphs.cpp"
+#include "bench_scan.cpp"
+#include "bench_pe.cpp"
+#include "bench_wave.cpp"
@@ -0,0 +1,41 @@
+#pragma once
+#include "encoder_shared.h"
+#include "svr_thread.h"
+
+// 64-bit games can run svr_encoder inside the game process instead, from svr_encoder_host.dll.
+// This uses the same shared memory and events as the process, so svr_game sends the same events to both.
+// The difference is that the game textures are given to svr_encoder directly on the D3D11 device of svr_game,
+// so there are no shared handles, no keyed mutexes and no second device that has to wait for the first.
+// The process is still used if the host cannot be loaded or the device cannot be used from another thread.
+
+struct ID3D11Device;
+struct ID3D11Texture2D;
+
+// Owned by svr_game and must stay alive until svr_encoder has handled ENCODER_EVENT_QUIT.
+struct EncoderHostParams
+{
+    char resource_path[260]; // Where svr_encoder can find its data. Same size as MAX_PATH.
+    char shared_mem_id[128]; // Same as the parameter to the process.
+
+    // Device of svr_game, which svr_encoder uses from its own thread.
+    // Multithread protection must be enabled by svr_game, since both threads use the immediate context.
+    ID3D11Device* d3d11_device;
+
+    // Used in place of game_texture_hs in the shared memory. Set by svr_game on ENCODER_EVENT_START.
+    ID3D11Texture2D* game_texs[ENCODER_VIDEO_SLOTS];
+};
+
+// Exported by svr_encoder_host.dll as ENCODER_HOST_START_NAME.
+// Starts the thread that svr_encoder runs on and returns its handle, which is set when the thread exits. Returns NULL if it could not start.
+// The handle is a HANDLE on Windows, and is kept by svr_game in SvrIpcProcess::handle so it is waited on like the process.
+using EncoderHostStartFn = void*(*)(EncoderHostParams* params);
+
+#define ENCODER_HOST_START_NAME "encoder_host_start"
+
+// Called by svr_encoder_host.dll. Starts the thread that runs svr_encoder with the parameters, and returns its handle like EncoderHostStartFn.
+// The thread must return once svr_encoder has left encoder_shared_event_loop.
+void* encoder_host_start_thread(SvrThreadFn fn, EncoderHostParams* params);
+
+// Called by svr_game. Tells svr_encoder to leave its event loop and waits for its thread to exit, which also closes the handle.
+// This works the same if the thread has already exited on its own.
+void encoder_host_quit(EncoderSharedMem* shared, SvrIpcProcess* host);
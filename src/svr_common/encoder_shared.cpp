@@ -0,0 +1,198 @@
+#include "encoder_shared.h"
+#include "encoder_host.h"
+
+bool encoder_shared_create(SvrIpcMem* mem, s32 sample_size)
+{
+    bool ret = false;
+    EncoderSharedMem* shared;
+    SvrSharedRing* audio_ring;
+    s32 audio_offset;
+
+    // Space for the audio ring is after the struct.
+    if (!svr_ipc_create_mem(sizeof(EncoderSharedMem) + sample_size * ENCODER_AUDIO_RING_SAMPLES, mem))
+    {
+        goto rfail;
+    }
+
+    shared = (EncoderSharedMem*)mem->ptr;
+
+    // svr_encoder needs these right away.
+    shared->game_pid = svr_ipc_get_current_pid();
+
+    if (!svr_ipc_create_event(&shared->game_wake_event)
+        || !svr_ipc_create_event(&shared->encoder_wake_event)
+        || !svr_ipc_create_event(&shared->video_slot_event)
+        || !svr_ipc_create_event(&shared->audio_space_event))
+    {
+        encoder_shared_close_events(shared);
+        goto rfail;
+    }
+
+    // The rings are never reset after this, since svr_encoder may look at them whenever it is woken up.
+    // Both are empty when a movie stops, since svr_encoder reads everything before it handles the stop.
+
+    svr_slot_ring_init(&shared->video_ring, ENCODER_VIDEO_SLOTS);
+    svr_slot_ring_stop(&shared->video_ring);
+
+    // Pointer types have different sizes in 32-bit and 64-bit, so the samples are at an offset from the ring.
+    audio_ring = &shared->audio_ring;
+    audio_offset = sizeof(EncoderSharedMem) - (s32)((u8*)audio_ring - (u8*)shared);
+
+    svr_shared_ring_init(audio_ring, sample_size, ENCODER_AUDIO_RING_SAMPLES, audio_offset);
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    svr_ipc_free_mem(mem);
+
+rexit:
+    return ret;
+}
+
+void encoder_shared_close_events(EncoderSharedMem* shared)
+{
+    svr_ipc_close_event(&shared->game_wake_event);
+    svr_ipc_close_event(&shared->encoder_wake_event);
+    svr_ipc_close_event(&shared->video_slot_event);
+    svr_ipc_close_event(&shared->audio_space_event);
+}
+
+void encoder_shared_post_event(EncoderSharedMem* shared, EncoderSharedEvent event)
+{
+    shared->event_type = event;
+    svr_ipc_set_event(&shared->encoder_wake_event);
+}
+
+// Reads every slot in the video ring that svr_game has filled, and gives them back.
+static void encoder_shared_read_video(EncoderSharedMem* shared, EncoderSharedHandler* handler)
+{
+    SvrSlotRing* ring = &shared->video_ring;
+    s32 slot_idx;
+
+    while (svr_slot_ring_begin_read(ring, &slot_idx, NULL))
+    {
+        handler->video_slot(handler->param, slot_idx);
+
+        svr_slot_ring_end_read(ring);
+
+        svr_ipc_set_event(&shared->video_slot_event); // svr_game may be waiting for a free slot.
+    }
+}
+
+// Reads all audio samples that svr_game has written to the audio ring.
+static void encoder_shared_read_audio(EncoderSharedMem* shared, EncoderSharedHandler* handler)
+{
+    SvrSharedRing* ring = &shared->audio_ring;
+    bool any_read = false;
+
+    while (true)
+    {
+        void* samples;
+        s32 num_samples = svr_shared_ring_begin_read(ring, &samples, ENCODER_MAX_SAMPLES);
+
+        if (num_samples == 0)
+        {
+            break;
+        }
+
+        handler->audio_samples(handler->param, samples, num_samples);
+
+        svr_shared_ring_end_read(ring, num_samples);
+        any_read = true;
+    }
+
+    if (any_read)
+    {
+        svr_ipc_set_event(&shared->audio_space_event); // svr_game may be waiting for space.
+    }
+}
+
+void encoder_shared_event_loop(EncoderSharedMem* shared, SvrIpcProcess* game, EncoderSharedHandler* handler)
+{
+    while (true)
+    {
+        SvrIpcWaitResult res = svr_ipc_wait(&shared->encoder_wake_event, game);
+
+        // Game exited or crashed or something.
+        if (res == SVR_IPC_WAIT_EXITED)
+        {
+            handler->game_exited(handler->param);
+            break;
+        }
+
+        // We are woken up here because svr_game has written video or audio or wants us to do something.
+        // Any code in here needs to be fast because the game may be waiting on us.
+
+        // The event must be read before the rings. svr_game writes to the rings before it sends an event,
+        // so everything that came before the event is read first.
+        EncoderSharedEvent event_type = shared->event_type;
+
+        encoder_shared_read_video(shared, handler);
+        encoder_shared_read_audio(shared, handler);
+
+        handler->rings_read(handler->param);
+
+        // Only woken up for new video or audio.
+        if (event_type == ENCODER_EVENT_NONE)
+        {
+            continue;
+        }
+
+        // Errors are cleared by svr_game when it has shown them, since errors from the rings are seen later.
+
+        switch (event_type)
+        {
+            case ENCODER_EVENT_START:
+            {
+                handler->start(handler->param);
+                break;
+            }
+
+            case ENCODER_EVENT_STOP:
+            {
+                handler->stop(handler->param);
+                break;
+            }
+        }
+
+        shared->event_type = ENCODER_EVENT_NONE;
+
+        // Notify svr_game that we handled this event.
+        // We go back to sleep after this, which puts us in a known paused state.
+        svr_ipc_set_event(&shared->game_wake_event);
+
+        // svr_game waits for the thread to exit after this.
+        if (event_type == ENCODER_EVENT_QUIT)
+        {
+            break;
+        }
+    }
+}
+
+void* encoder_host_start_thread(SvrThreadFn fn, EncoderHostParams* params)
+{
+    SvrThread thread = {};
+
+    if (!svr_thread_start(&thread, fn, params))
+    {
+        return NULL;
+    }
+
+    return thread.handle;
+}
+
+void encoder_host_quit(EncoderSharedMem* shared, SvrIpcProcess* host)
+{
+    encoder_shared_post_event(shared, ENCODER_EVENT_QUIT);
+
+    // On Windows the handle is the thread, so this returns right away if it has already exited.
+    svr_ipc_wait(&shared->game_wake_event, host);
+
+    SvrThread thread = {};
+    thread.handle = host->handle;
+
+    svr_thread_join(&thread);
+
+    host->handle = NULL;
+}
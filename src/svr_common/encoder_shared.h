@@ -1,12 +1,17 @@
 #pragma once
 #include "svr_common.h"
+#include "svr_slot_ring.h"
+#include "svr_shared_ring.h"
+#include "svr_ipc.h"
 
 // Shared stuff between 32-bit svr_game and 64-bit svr_encoder.
 
 // All Windows handles only use 32 bits of data, so we can safely refer to them in here as u32 with _h in the name.
 // https://learn.microsoft.com/en-us/windows/win32/winprog64/interprocess-communication
 
-const s32 ENCODER_MAX_SAMPLES = 4096; // How many samples can be stored at most in the buffer placed at audio_buffer_offset.
+const s32 ENCODER_AUDIO_RING_SAMPLES = 32768; // How many samples fit in the audio ring. Must be a power of two.
+const s32 ENCODER_MAX_SAMPLES = 4096; // How many samples svr_encoder reads from the audio ring at most at once. svr_game wakes svr_encoder when this many are waiting.
+const s32 ENCODER_VIDEO_SLOTS = 4; // How many game textures svr_game can fill before it has to wait for svr_encoder. Must be a power of two.
 
 // Identifiers used by the DXGI lock for synchronizing with the shared texture.
 // You need to specify which device to give access to, so that's what these are.
@@ -20,8 +25,7 @@ enum /* EncoderSharedEvent */
     ENCODER_EVENT_NONE,
     ENCODER_EVENT_START, // Movie parameters will be setup. This event can fail.
     ENCODER_EVENT_STOP, // Rendering will stop. This event cannot fail.
-    ENCODER_EVENT_NEW_VIDEO, // Texture at game_texture_h will have new data. This event can fail.
-    ENCODER_EVENT_NEW_AUDIO, // New samples will be placed at audio_buffer_offset. This event can fail.
+    ENCODER_EVENT_QUIT, // svr_encoder will leave its event loop. Only sent to svr_encoder_host.dll, since the process exits with the game.
 };
 
 struct EncoderSharedMovieParams
@@ -43,8 +47,13 @@ struct EncoderSharedMovieParams
     char dnxhr_profile[32];
     s32 video_fps;
     s32 x264_crf;
+    s32 memory_budget_mb; // Max memory for uncompressed frames and compressed packets that are waiting in svr_encoder.
+    s32 encode_workers; // How many video codec contexts to encode with at the same time, for encoders that support it.
+    s32 x264_chunk_length; // In seconds. Length of the chunks to split the video into when encoding libx264 with several workers.
     bool x264_intra;
     bool use_audio;
+    bool use_trace; // Record a trace next to the movie.
+    s32 stats_idx; // Part of the live statistics that this encoder writes, or -1 if svr_game has none.
 };
 
 // Memory that is shared between the processes.
@@ -52,21 +61,63 @@ struct EncoderSharedMem
 {
     EncoderSharedMovieParams movie_params; // Movie parameters and profile stuff set by svr_game on ENCODER_EVENT_START.
 
-    // Shared handle to the latest game texture in the B8G8R8A8 format. Updated on ENCODER_EVENT_NEW_VIDEO.
-    u32 game_texture_h;
+    // Video frames are not sent through events. svr_game fills the game textures through the video ring and wakes svr_encoder,
+    // and only has to wait when all of them are full. svr_encoder reads every filled slot before it handles an event.
+    // Shared handles to the game textures in the B8G8R8A8 format, one for every slot in the ring. Set on ENCODER_EVENT_START.
+    u32 game_texture_hs[ENCODER_VIDEO_SLOTS];
 
-    // Pointer types have different sizes in 32-bit and 64-bit so we have to store the offsets from the base
-    // of the shared memory instead. The audio samples here are updated on ENCODER_EVENT_NEW_AUDIO.
-    s32 audio_buffer_offset;
+    // When svr_game has no D3D11 device the frames are B8G8R8A8 pixels in memory instead, one frame for every slot one after another.
+    // This is the id of that memory, given to svr_encoder on ENCODER_EVENT_START. Empty when the game textures are used.
+    char frame_mem_id[32];
 
-    s32 waiting_audio_samples; // Set by svr_game to how many audio samples are waiting at audio_buffer_offset. Updated on ENCODER_EVENT_NEW_AUDIO.
+    SvrSlotRing video_ring; // Restarted by svr_game on ENCODER_EVENT_START and stopped on ENCODER_EVENT_STOP.
 
-    u32 game_wake_event_h; // Event set by svr_encoder to wake svr_game up.
-    u32 encoder_wake_event_h; // Event set by svr_game to wake svr_encoder up.
-    u32 game_pid; // Game process id. Used by svr_encoder to know if the game exits so we don't get stuck.
+    // Audio samples are written by svr_game and read by svr_encoder whenever it is woken up, and svr_game only has to wait
+    // when the ring is full. Pointer types have different sizes in 32-bit and 64-bit so the samples are placed at an offset
+    // from the ring instead, which is after this struct.
+    SvrSharedRing audio_ring;
 
-    EncoderSharedEvent event_type; // Set by svr_game to let svr_encoder know what to do when woken up. Updated on all events.
+    SvrIpcEvent game_wake_event; // Set by svr_encoder to wake svr_game up.
+    SvrIpcEvent encoder_wake_event; // Set by svr_game to wake svr_encoder up.
+    SvrIpcEvent video_slot_event; // Set by svr_encoder when a slot in the video ring has been given back.
+    SvrIpcEvent audio_space_event; // Set by svr_encoder when samples in the audio ring have been read.
+    u32 game_pid; // Game process id. Used by svr_encoder to stop waiting if the game exits so we don't get stuck.
+
+    // Set by svr_game to let svr_encoder know what to do when woken up. Updated on all events.
+    // Set back to ENCODER_EVENT_NONE by svr_encoder once handled, since it is also woken up for new video.
+    EncoderSharedEvent event_type;
 
     s32 error; // Set to 1 by svr_encoder on any error. A message will be written to error_message.
     char error_message[512]; // Any encoding error will be written here by svr_encoder when error is set to 1.
 };
+
+// The protocol of the shared memory, which is the same for svr_encoder.exe and svr_encoder_host.dll.
+// svr_game and svr_encoder both use this so they cannot disagree on how the rings and events are used.
+
+// Called by svr_game. Creates the shared memory with its events and rings, for audio samples of the given size.
+// The video ring is stopped until the first movie. The memory is freed on failure.
+bool encoder_shared_create(SvrIpcMem* mem, s32 sample_size);
+
+// Closes the events in this process. The other side still has its own.
+void encoder_shared_close_events(EncoderSharedMem* shared);
+
+// Called by svr_game. Sets the event and wakes svr_encoder, which sets game_wake_event when it has handled it.
+// Everything that was written to the rings before this is read by svr_encoder before the event is handled.
+void encoder_shared_post_event(EncoderSharedMem* shared, EncoderSharedEvent event);
+
+// What svr_encoder does with what it reads from the shared memory. Everything is called on the thread of the event loop.
+struct EncoderSharedHandler
+{
+    void* param; // Given to every function.
+
+    void(*start)(void* param); // ENCODER_EVENT_START.
+    void(*stop)(void* param); // ENCODER_EVENT_STOP.
+    void(*video_slot)(void* param, s32 slot_idx); // A filled slot in the video ring, which is given back when this returns.
+    void(*audio_samples)(void* param, void* samples, s32 num_samples); // Samples from the audio ring, which are given back when this returns.
+    void(*rings_read)(void* param); // Every time svr_encoder is woken up, after everything in the rings has been read.
+    void(*game_exited)(void* param); // svr_game went away without telling svr_encoder. The event loop returns after this.
+};
+
+// Called by svr_encoder. Handles everything that svr_game sends until ENCODER_EVENT_QUIT or until the game process exits.
+// The game process is NULL inside svr_game, where only ENCODER_EVENT_QUIT stops the loop.
+void encoder_shared_event_loop(EncoderSharedMem* shared, SvrIpcProcess* game, EncoderSharedHandler* handler);
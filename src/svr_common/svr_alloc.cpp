@@ -1,6 +1,8 @@
 #include "svr_alloc.h"
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
 
 void* svr_alloc(s32 size)
 {
@@ -31,7 +33,11 @@ char* svr_dup_str(const char* source)
 
 void* svr_align_alloc(s32 size, s32 align)
 {
+#ifdef _WIN32
     return _aligned_malloc(size, align);
+#else
+    return aligned_alloc(align, svr_align32(size, align));
+#endif
 }
 
 void svr_free(void* addr)
@@ -41,5 +47,10 @@ void svr_free(void* addr)
 
 void svr_align_free(void* addr, s32 align)
 {
+#ifdef _WIN32
     _aligned_free(addr);
+#else
+    (void)align; // Only needed by platforms that have to know where the real allocation starts.
+    free(addr);
+#endif
 }
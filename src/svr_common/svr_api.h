@@ -10,6 +10,7 @@
 // 3) Call svr_start when movie production should start.
 // 4a) Call svr_frame for all frames where movie production is active.
 // 4b) Optionally call svr_give_velocity before svr_frame.
+// 4c) Optionally set the time of every game frame from svr_get_frame_steps, which lets motion blur skip frames that are not used.
 // 5) Call svr_stop when movie production should stop.
 
 // Programming errors are printed to the debugger output (prefixed with "SVR (<function name>):").
@@ -18,7 +19,10 @@
 
 // Windows only.
 
-#ifdef SVR_GAME_DLL
+// svr_game_bench on other platforms only uses the types.
+#ifndef _WIN32
+#define SVR_API
+#elif defined(SVR_GAME_DLL)
 #define SVR_API __declspec(dllexport)
 #else
 #define SVR_API __declspec(dllimport)
@@ -29,7 +33,7 @@ extern "C"
 
 // To be increased when something in the interface changes. Internal DLL changes (svr_dll_version) does not have to up this.
 // The API must not be used if the DLL API version does not match the client header API version.
-const int SVR_API_VERSION = 1;
+const int SVR_API_VERSION = 5;
 
 struct IUnknown;
 struct IDirect3DSurface9;
@@ -55,6 +59,14 @@ struct SvrStartMovieData
 
     // Audio parameters that are being sent to svr_give_audio.
     SvrAudioParams audio_params;
+
+    // Set to true if the time of every game frame will be set from svr_get_frame_steps.
+    // When false, every game frame must be as long as one frame at the rate of svr_get_game_rate.
+    bool use_frame_steps;
+
+    // Length of the movie in seconds of video if it is known, such as when recording stops after a set time. Set to 0 if not known.
+    // Only used to show when the movie will be done.
+    int movie_length;
 };
 
 struct SvrWaveSample
@@ -63,6 +75,13 @@ struct SvrWaveSample
     short r;
 };
 
+// Samples that can go outside of 16 bits, such as a mix that has not been clipped yet.
+struct SvrWaveSample32
+{
+    int l;
+    int r;
+};
+
 // For checking mismatch between built DLL and client header.
 // Always call this and ensure that the versions match (compare to SVR_API_VERSION). The API should not be used if these mismatch, as it will most likely crash!
 // You should not call svr_init (or any function at all) if there is a mismatch.
@@ -120,6 +139,15 @@ SVR_API bool svr_start(const char* movie_name, const char* movie_profile, SvrSta
 // Set the host_framerate console variable to the value this returns.
 SVR_API int svr_get_game_rate();
 
+// Returns how many frames at the rate of svr_get_game_rate that a game frame should cover, when use_frame_steps is set in svr_start.
+// The frames ahead is counted in svr_frame calls. 0 is the game frame that is given to the next svr_frame call, 1 is the one after that and so on.
+// Use a count that matches how many frames later a new frame time is used by the game and shows up in svr_frame.
+// With motion blur, the frames where the shutter is closed are not used, so they can be covered by one longer game frame.
+// Otherwise this is always 1. The first frames of a movie are also always 1, since the game is already running them when the movie starts.
+// Set the host_framerate console variable to the value of svr_get_game_rate divided by this.
+// The audio given to svr_give_audio must also cover the same time as the game frames.
+SVR_API int svr_get_frame_steps(int frames_ahead);
+
 // To be called when movie recording should stop. Can be in response to a console command or UI element or some automatic event.
 // Calling this function will stop movie production and calling svr_frame will not do anything.
 // The console variables mentioned in svr_start can be reset back to their previous value after this. Also the host_framerate console variable must be set back to 0.
@@ -141,6 +169,11 @@ SVR_API bool svr_is_velo_enabled();
 // Must only be called after svr_start.
 SVR_API bool svr_is_audio_enabled();
 
+// Returns true if the active profile records a trace of the movie.
+// A module that records its own trace with the svr_trace functions should start it after svr_start and save it after svr_stop when this is set.
+// Must only be called after svr_start.
+SVR_API bool svr_is_trace_enabled();
+
 // For the velocity extension, call this to give the player xyz velocity so it can be drawn to the encoded video.
 // Must be called before svr_frame.
 SVR_API void svr_give_velocity(float* xyz);
@@ -148,4 +181,8 @@ SVR_API void svr_give_velocity(float* xyz);
 // Give audio samples to write. This must be 2 channel 16 bit samples at 44100 hz.
 SVR_API void svr_give_audio(SvrWaveSample* samples, int num_samples);
 
+// Same as svr_give_audio but for 32 bit samples, which are clipped to 16 bits.
+// Use this instead of converting the samples yourself, as they are converted straight into where the encoder reads them.
+SVR_API void svr_give_audio_32(SvrWaveSample32* samples, int num_samples);
+
 }
@@ -1,5 +1,6 @@
 #pragma once
 #include "svr_common.h"
+#include "svr_alloc.h"
 #include <assert.h>
 #include <string.h>
 
@@ -163,7 +164,6 @@ struct SvrDynArray
             return;
         }
 
-        s32 new_size = size + num;
         T* insert_at = mem + idx;
 
         // Move what we have to make room to insert.
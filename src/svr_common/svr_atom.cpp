@@ -1,4 +1,6 @@
 #include "svr_atom.h"
+
+#ifdef _WIN32
 #include <Windows.h>
 #include <intrin0.h>
 
@@ -133,3 +135,178 @@ void svr_wait_until_atom_is(SvrAtom64* atom, s64 target_value)
         captured_value = svr_atom_load(atom);
     }
 }
+
+void svr_wait_while_atom_is(SvrAtom32* atom, s32 value)
+{
+    while (svr_atom_load(atom) == value)
+    {
+        WaitOnAddress(&atom->v, &value, sizeof(value), INFINITE); // Awake when value differs.
+    }
+}
+
+void svr_atom_barrier()
+{
+    _ReadWriteBarrier();
+}
+
+void svr_cpu_relax()
+{
+    YieldProcessor();
+}
+
+#else
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+
+// Same semantics as the MSVC path but with the GCC builtins.
+// Waiting is done with futexes, which only exist for 32-bit values.
+
+const long SVR_ATOM64_MAX_WAIT_NS = 1000000; // Longest sleep of one wait on a 64-bit atom, see svr_wait_until_atom_is.
+
+void svr_atom_store(SvrAtom32* atom, s32 value)
+{
+    __atomic_store_n(&atom->v, value, __ATOMIC_RELEASE);
+}
+
+s32 svr_atom_load(SvrAtom32* atom)
+{
+    return __atomic_load_n(&atom->v, __ATOMIC_ACQUIRE);
+}
+
+void svr_atom_and(SvrAtom32* atom, s32 value)
+{
+    __atomic_fetch_and(&atom->v, value, __ATOMIC_SEQ_CST);
+}
+
+void svr_atom_or(SvrAtom32* atom, s32 value)
+{
+    __atomic_fetch_or(&atom->v, value, __ATOMIC_SEQ_CST);
+}
+
+bool svr_atom_cmpxchg(SvrAtom32* atom, s32* expr, s32 value)
+{
+    return __atomic_compare_exchange_n(&atom->v, expr, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+s32 svr_atom_add(SvrAtom32* atom, s32 num)
+{
+    return __atomic_fetch_add(&atom->v, num, __ATOMIC_SEQ_CST);
+}
+
+s32 svr_atom_sub(SvrAtom32* atom, s32 num)
+{
+    return svr_atom_add(atom, 0 - num);
+}
+
+void svr_atom_store(SvrAtom64* atom, s64 value)
+{
+    __atomic_store_n(&atom->v, value, __ATOMIC_RELEASE);
+}
+
+s64 svr_atom_load(SvrAtom64* atom)
+{
+    return __atomic_load_n(&atom->v, __ATOMIC_ACQUIRE);
+}
+
+void svr_atom_and(SvrAtom64* atom, s64 value)
+{
+    __atomic_fetch_and(&atom->v, value, __ATOMIC_SEQ_CST);
+}
+
+void svr_atom_or(SvrAtom64* atom, s64 value)
+{
+    __atomic_fetch_or(&atom->v, value, __ATOMIC_SEQ_CST);
+}
+
+bool svr_atom_cmpxchg(SvrAtom64* atom, s64* expr, s64 value)
+{
+    return __atomic_compare_exchange_n(&atom->v, expr, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+s64 svr_atom_add(SvrAtom64* atom, s64 num)
+{
+    return __atomic_fetch_add(&atom->v, num, __ATOMIC_SEQ_CST);
+}
+
+s64 svr_atom_sub(SvrAtom64* atom, s64 num)
+{
+    return svr_atom_add(atom, 0 - num);
+}
+
+static void svr_futex_wait(s32* addr, s32 value, struct timespec* timeout)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, timeout, NULL, 0);
+}
+
+static void svr_futex_wake_all(s32* addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+void svr_notify_atom_changed(SvrAtom32* atom)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    svr_futex_wake_all(&atom->v);
+}
+
+// Futexes only exist for 32-bit values, so 64-bit atoms are waited on with the low half (x86 is little endian).
+static s32* svr_atom_low_word(SvrAtom64* atom)
+{
+    return (s32*)&atom->v;
+}
+
+void svr_notify_atom_changed(SvrAtom64* atom)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    svr_futex_wake_all(svr_atom_low_word(atom));
+}
+
+void svr_wait_until_atom_is(SvrAtom32* atom, s32 target_value)
+{
+    s32 captured_value = svr_atom_load(atom);
+
+    while (captured_value != target_value)
+    {
+        svr_futex_wait(&atom->v, captured_value, NULL); // Awake when value differs.
+        captured_value = svr_atom_load(atom);
+    }
+}
+
+void svr_wait_until_atom_is(SvrAtom64* atom, s64 target_value)
+{
+    s64 captured_value = svr_atom_load(atom);
+
+    while (captured_value != target_value)
+    {
+        // If only the high half changes between the load and the wait, the futex sees no change and the wake may already have happened.
+        // The wait is bounded so that case is noticed late instead of never. Any change of the low half wakes right away.
+        struct timespec ts = { 0, SVR_ATOM64_MAX_WAIT_NS };
+        svr_futex_wait(svr_atom_low_word(atom), (s32)captured_value, &ts);
+        captured_value = svr_atom_load(atom);
+    }
+}
+
+void svr_wait_while_atom_is(SvrAtom32* atom, s32 value)
+{
+    while (svr_atom_load(atom) == value)
+    {
+        svr_futex_wait(&atom->v, value, NULL); // Awake when value differs.
+    }
+}
+
+void svr_atom_barrier()
+{
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+void svr_cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+#endif
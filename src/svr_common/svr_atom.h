@@ -2,6 +2,7 @@
 #include "svr_common.h"
 
 // Atomic operations for x86.
+// The Windows path uses the Interlocked functions, other platforms use the GCC builtins.
 
 struct SvrAtom32
 {
@@ -32,6 +33,10 @@ bool svr_atom_cmpxchg(SvrAtom64* atom, s64* expr, s64 value);
 s64 svr_atom_add(SvrAtom64* atom, s64 num);
 s64 svr_atom_sub(SvrAtom64* atom, s64 num);
 
+// Stops the compiler from moving loads and stores across this.
+// x86 keeps loads in order with other loads and stores in order with other stores, so nothing else is needed for that.
+void svr_atom_barrier();
+
 // Functions to wait on atoms. Makes it super easy to synchronize between threads.
 
 // Call this to wake waiting threads if anyone is waiting on this atom.
@@ -41,3 +46,10 @@ void svr_notify_atom_changed(SvrAtom64* atom);
 // Wait on atom. Writer must use notify function above to wake waiting threads.
 void svr_wait_until_atom_is(SvrAtom32* atom, s32 target_value);
 void svr_wait_until_atom_is(SvrAtom64* atom, s64 target_value);
+
+// Wait until the atom no longer has this value.
+void svr_wait_while_atom_is(SvrAtom32* atom, s32 value);
+
+// Hint to the processor that we are in a spin loop.
+void svr_cpu_relax();
+
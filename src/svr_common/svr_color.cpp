@@ -0,0 +1,569 @@
+#include "svr_color.h"
+#include "svr_work_pool.h"
+#include <string.h>
+#include <assert.h>
+#include <immintrin.h>
+
+// The coefficients of tex2vid.hlsl scaled by 219 / 255 for the partial range, in fixed point with 15 fractional bits.
+// The sums are truncated like the float to integer conversion in the shader.
+// Integer math is used so that the SIMD levels can give exactly the same result as the scalar level.
+
+const s32 COLOR_SHIFT = 15;
+
+const s32 COLOR_YR = 5983;
+const s32 COLOR_YG = 20127;
+const s32 COLOR_YB = 2032;
+
+const s32 COLOR_UR = -3224;
+const s32 COLOR_UG = -10847;
+const s32 COLOR_UB = 14071;
+
+const s32 COLOR_VR = 14071;
+const s32 COLOR_VG = -12781;
+const s32 COLOR_VB = -1290;
+
+// Rows that a thread converts at a time.
+const s32 COLOR_ROWS_PER_JOB = 16;
+
+// --------------------------------------------------------------------------------------------------------------------
+// Scalar level.
+// The row functions start at pixel x, which must be even, and continue to the end of the row.
+// For chroma, the source is the sum of 2^log2_num pixels.
+
+static inline u8 color_y(const u8* px)
+{
+    return (u8)((COLOR_YB * px[0] + COLOR_YG * px[1] + COLOR_YR * px[2] + (16 << COLOR_SHIFT)) >> COLOR_SHIFT);
+}
+
+static inline u8 color_u(s32 b, s32 g, s32 r, s32 log2_num)
+{
+    s32 shift = COLOR_SHIFT + log2_num;
+    return (u8)((COLOR_UB * b + COLOR_UG * g + COLOR_UR * r + (128 << shift)) >> shift);
+}
+
+static inline u8 color_v(s32 b, s32 g, s32 r, s32 log2_num)
+{
+    s32 shift = COLOR_SHIFT + log2_num;
+    return (u8)((COLOR_VB * b + COLOR_VG * g + COLOR_VR * r + (128 << shift)) >> shift);
+}
+
+static void color_y_row_scalar(const u8* src, u8* dest_y, s32 x, s32 width)
+{
+    for (; x < width; x++)
+    {
+        dest_y[x] = color_y(src + x * 4);
+    }
+}
+
+static void color_444_row_scalar(const u8* src, u8* dest_y, u8* dest_u, u8* dest_v, s32 x, s32 width)
+{
+    for (; x < width; x++)
+    {
+        const u8* px = src + x * 4;
+
+        dest_y[x] = color_y(px);
+        dest_u[x] = color_u(px[0], px[1], px[2], 0);
+        dest_v[x] = color_v(px[0], px[1], px[2], 0);
+    }
+}
+
+static void color_422_row_scalar(const u8* src, u8* dest_y, u8* dest_u, u8* dest_v, s32 x, s32 width)
+{
+    color_y_row_scalar(src, dest_y, x, width);
+
+    for (; x < width; x += 2)
+    {
+        const u8* p0 = src + x * 4;
+        const u8* p1 = (x + 1 < width) ? p0 + 4 : p0; // Repeat the edge for odd widths.
+
+        dest_u[x >> 1] = color_u(p0[0] + p1[0], p0[1] + p1[1], p0[2] + p1[2], 1);
+        dest_v[x >> 1] = color_v(p0[0] + p1[0], p0[1] + p1[1], p0[2] + p1[2], 1);
+    }
+}
+
+static void color_nv12_rows_scalar(const u8* src_a, const u8* src_b, u8* dest_ya, u8* dest_yb, u8* dest_uv, s32 x, s32 width)
+{
+    color_y_row_scalar(src_a, dest_ya, x, width);
+    color_y_row_scalar(src_b, dest_yb, x, width);
+
+    for (; x < width; x += 2)
+    {
+        s32 next = (x + 1 < width) ? 4 : 0; // Repeat the edge for odd widths.
+
+        const u8* pa = src_a + x * 4;
+        const u8* pb = src_b + x * 4;
+
+        s32 b = pa[0] + pa[next + 0] + pb[0] + pb[next + 0];
+        s32 g = pa[1] + pa[next + 1] + pb[1] + pb[next + 1];
+        s32 r = pa[2] + pa[next + 2] + pb[2] + pb[next + 2];
+
+        dest_uv[x + 0] = color_u(b, g, r, 2);
+        dest_uv[x + 1] = color_v(b, g, r, 2);
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// SSE4.1 level.
+// Processes 8 pixels at a time. The pixels are widened to 16 bits so that pmaddwd can do two products per lane.
+// Returns how many pixels were converted, the rest is left for the scalar level.
+
+SVR_TARGET_SSE41 static inline __m128i color_sse41_coefs(s32 b, s32 g, s32 r)
+{
+    return _mm_setr_epi16((s16)b, (s16)g, (s16)r, 0, (s16)b, (s16)g, (s16)r, 0);
+}
+
+// Loads 8 BGRA pixels as 16-bit channels, 2 pixels per register.
+SVR_TARGET_SSE41 static inline void color_sse41_load_8(const u8* src, __m128i* px)
+{
+    __m128i l0 = _mm_loadu_si128((const __m128i*)src);
+    __m128i l1 = _mm_loadu_si128((const __m128i*)(src + 16));
+
+    px[0] = _mm_cvtepu8_epi16(l0);
+    px[1] = _mm_cvtepu8_epi16(_mm_srli_si128(l0, 8));
+    px[2] = _mm_cvtepu8_epi16(l1);
+    px[3] = _mm_cvtepu8_epi16(_mm_srli_si128(l1, 8));
+}
+
+// Weighted sums of 4 pixels in 2 registers, shifted down with an offset.
+SVR_TARGET_SSE41 static inline __m128i color_sse41_dot_4(__m128i a, __m128i b, __m128i coefs, __m128i offset, s32 shift)
+{
+    __m128i sums = _mm_hadd_epi32(_mm_madd_epi16(a, coefs), _mm_madd_epi16(b, coefs));
+    return _mm_srai_epi32(_mm_add_epi32(sums, offset), shift);
+}
+
+// Sums of neighbouring pixels. Returns 2 pixel pairs in 1 register.
+SVR_TARGET_SSE41 static inline __m128i color_sse41_pair_sums(__m128i a, __m128i b)
+{
+    return _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+}
+
+SVR_TARGET_SSE41 static inline void color_sse41_store_8(u8* dest, __m128i lo, __m128i hi)
+{
+    __m128i w = _mm_packs_epi32(lo, hi);
+    _mm_storel_epi64((__m128i*)dest, _mm_packus_epi16(w, w));
+}
+
+SVR_TARGET_SSE41 static inline void color_sse41_store_4(u8* dest, __m128i v)
+{
+    __m128i w = _mm_packs_epi32(v, v);
+    s32 packed = _mm_cvtsi128_si32(_mm_packus_epi16(w, w));
+    memcpy(dest, &packed, 4);
+}
+
+SVR_TARGET_SSE41 static void color_sse41_y_8(const __m128i* px, u8* dest_y)
+{
+    __m128i cy = color_sse41_coefs(COLOR_YB, COLOR_YG, COLOR_YR);
+    __m128i oy = _mm_set1_epi32(16 << COLOR_SHIFT);
+
+    __m128i y0 = color_sse41_dot_4(px[0], px[1], cy, oy, COLOR_SHIFT);
+    __m128i y1 = color_sse41_dot_4(px[2], px[3], cy, oy, COLOR_SHIFT);
+
+    color_sse41_store_8(dest_y, y0, y1);
+}
+
+SVR_TARGET_SSE41 static s32 color_444_row_sse41(const u8* src, u8* dest_y, u8* dest_u, u8* dest_v, s32 width)
+{
+    __m128i cu = color_sse41_coefs(COLOR_UB, COLOR_UG, COLOR_UR);
+    __m128i cv = color_sse41_coefs(COLOR_VB, COLOR_VG, COLOR_VR);
+    __m128i oc = _mm_set1_epi32(128 << COLOR_SHIFT);
+
+    s32 x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i px[4];
+        color_sse41_load_8(src + x * 4, px);
+
+        color_sse41_y_8(px, dest_y + x);
+
+        __m128i u0 = color_sse41_dot_4(px[0], px[1], cu, oc, COLOR_SHIFT);
+        __m128i u1 = color_sse41_dot_4(px[2], px[3], cu, oc, COLOR_SHIFT);
+        __m128i v0 = color_sse41_dot_4(px[0], px[1], cv, oc, COLOR_SHIFT);
+        __m128i v1 = color_sse41_dot_4(px[2], px[3], cv, oc, COLOR_SHIFT);
+
+        color_sse41_store_8(dest_u + x, u0, u1);
+        color_sse41_store_8(dest_v + x, v0, v1);
+    }
+
+    return x;
+}
+
+SVR_TARGET_SSE41 static s32 color_422_row_sse41(const u8* src, u8* dest_y, u8* dest_u, u8* dest_v, s32 width)
+{
+    __m128i cu = color_sse41_coefs(COLOR_UB, COLOR_UG, COLOR_UR);
+    __m128i cv = color_sse41_coefs(COLOR_VB, COLOR_VG, COLOR_VR);
+    __m128i oc = _mm_set1_epi32(128 << (COLOR_SHIFT + 1));
+
+    s32 x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i px[4];
+        color_sse41_load_8(src + x * 4, px);
+
+        color_sse41_y_8(px, dest_y + x);
+
+        __m128i q0 = color_sse41_pair_sums(px[0], px[1]);
+        __m128i q1 = color_sse41_pair_sums(px[2], px[3]);
+
+        color_sse41_store_4(dest_u + (x >> 1), color_sse41_dot_4(q0, q1, cu, oc, COLOR_SHIFT + 1));
+        color_sse41_store_4(dest_v + (x >> 1), color_sse41_dot_4(q0, q1, cv, oc, COLOR_SHIFT + 1));
+    }
+
+    return x;
+}
+
+SVR_TARGET_SSE41 static s32 color_nv12_rows_sse41(const u8* src_a, const u8* src_b, u8* dest_ya, u8* dest_yb, u8* dest_uv, s32 width)
+{
+    __m128i cu = color_sse41_coefs(COLOR_UB, COLOR_UG, COLOR_UR);
+    __m128i cv = color_sse41_coefs(COLOR_VB, COLOR_VG, COLOR_VR);
+    __m128i oc = _mm_set1_epi32(128 << (COLOR_SHIFT + 2));
+
+    s32 x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i pa[4];
+        __m128i pb[4];
+        color_sse41_load_8(src_a + x * 4, pa);
+        color_sse41_load_8(src_b + x * 4, pb);
+
+        color_sse41_y_8(pa, dest_ya + x);
+        color_sse41_y_8(pb, dest_yb + x);
+
+        __m128i q0 = color_sse41_pair_sums(_mm_add_epi16(pa[0], pb[0]), _mm_add_epi16(pa[1], pb[1]));
+        __m128i q1 = color_sse41_pair_sums(_mm_add_epi16(pa[2], pb[2]), _mm_add_epi16(pa[3], pb[3]));
+
+        __m128i u = color_sse41_dot_4(q0, q1, cu, oc, COLOR_SHIFT + 2);
+        __m128i v = color_sse41_dot_4(q0, q1, cv, oc, COLOR_SHIFT + 2);
+
+        // Interleave to U0 V0 U1 V1 and so on.
+        __m128i uv = _mm_unpacklo_epi16(_mm_packs_epi32(u, u), _mm_packs_epi32(v, v));
+        _mm_storel_epi64((__m128i*)(dest_uv + x), _mm_packus_epi16(uv, uv));
+    }
+
+    return x;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// AVX2 level.
+// Same as the SSE4.1 level but with 16 pixels at a time.
+// The horizontal adds work within the 128-bit lanes, so the results are permuted back in order before packing.
+
+SVR_TARGET_AVX2 static inline __m256i color_avx2_coefs(s32 b, s32 g, s32 r)
+{
+    return _mm256_setr_epi16((s16)b, (s16)g, (s16)r, 0, (s16)b, (s16)g, (s16)r, 0, (s16)b, (s16)g, (s16)r, 0, (s16)b, (s16)g, (s16)r, 0);
+}
+
+// Loads 16 BGRA pixels as 16-bit channels, 4 pixels per register.
+SVR_TARGET_AVX2 static inline void color_avx2_load_16(const u8* src, __m256i* px)
+{
+    for (s32 i = 0; i < 4; i++)
+    {
+        px[i] = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + i * 16)));
+    }
+}
+
+// Weighted sums of 8 pixels in 2 registers, shifted down with an offset.
+// The result is in the lane order of the horizontal add, which the caller fixes with a permute.
+SVR_TARGET_AVX2 static inline __m256i color_avx2_dot_8(__m256i a, __m256i b, __m256i coefs, __m256i offset, s32 shift)
+{
+    __m256i sums = _mm256_hadd_epi32(_mm256_madd_epi16(a, coefs), _mm256_madd_epi16(b, coefs));
+    return _mm256_srai_epi32(_mm256_add_epi32(sums, offset), shift);
+}
+
+// Sums of neighbouring pixels. Returns 4 pixel pairs in 1 register.
+SVR_TARGET_AVX2 static inline __m256i color_avx2_pair_sums(__m256i a, __m256i b)
+{
+    return _mm256_add_epi16(_mm256_unpacklo_epi64(a, b), _mm256_unpackhi_epi64(a, b));
+}
+
+// Packs 8 values to 16-bit.
+SVR_TARGET_AVX2 static inline __m128i color_avx2_pack_8(__m256i v)
+{
+    return _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+SVR_TARGET_AVX2 static void color_avx2_dot_16(const __m256i* px, __m256i coefs, __m256i offset, u8* dest)
+{
+    // Pixels come out as 0 1 4 5 2 3 6 7 from the horizontal add.
+    __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+
+    __m256i v0 = _mm256_permutevar8x32_epi32(color_avx2_dot_8(px[0], px[1], coefs, offset, COLOR_SHIFT), order);
+    __m256i v1 = _mm256_permutevar8x32_epi32(color_avx2_dot_8(px[2], px[3], coefs, offset, COLOR_SHIFT), order);
+
+    _mm_storeu_si128((__m128i*)dest, _mm_packus_epi16(color_avx2_pack_8(v0), color_avx2_pack_8(v1)));
+}
+
+// Chroma for 8 pixel pairs, in order.
+SVR_TARGET_AVX2 static inline __m256i color_avx2_chroma_8(__m256i q0, __m256i q1, __m256i coefs, __m256i offset, s32 shift)
+{
+    // Pairs come out as 0 2 4 6 1 3 5 7 from the horizontal add.
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    return _mm256_permutevar8x32_epi32(color_avx2_dot_8(q0, q1, coefs, offset, shift), order);
+}
+
+SVR_TARGET_AVX2 static s32 color_444_row_avx2(const u8* src, u8* dest_y, u8* dest_u, u8* dest_v, s32 width)
+{
+    __m256i cy = color_avx2_coefs(COLOR_YB, COLOR_YG, COLOR_YR);
+    __m256i cu = color_avx2_coefs(COLOR_UB, COLOR_UG, COLOR_UR);
+    __m256i cv = color_avx2_coefs(COLOR_VB, COLOR_VG, COLOR_VR);
+    __m256i oy = _mm256_set1_epi32(16 << COLOR_SHIFT);
+    __m256i oc = _mm256_set1_epi32(128 << COLOR_SHIFT);
+
+    s32 x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        __m256i px[4];
+        color_avx2_load_16(src + x * 4, px);
+
+        color_avx2_dot_16(px, cy, oy, dest_y + x);
+        color_avx2_dot_16(px, cu, oc, dest_u + x);
+        color_avx2_dot_16(px, cv, oc, dest_v + x);
+    }
+
+    return x;
+}
+
+SVR_TARGET_AVX2 static s32 color_422_row_avx2(const u8* src, u8* dest_y, u8* dest_u, u8* dest_v, s32 width)
+{
+    __m256i cy = color_avx2_coefs(COLOR_YB, COLOR_YG, COLOR_YR);
+    __m256i cu = color_avx2_coefs(COLOR_UB, COLOR_UG, COLOR_UR);
+    __m256i cv = color_avx2_coefs(COLOR_VB, COLOR_VG, COLOR_VR);
+    __m256i oy = _mm256_set1_epi32(16 << COLOR_SHIFT);
+    __m256i oc = _mm256_set1_epi32(128 << (COLOR_SHIFT + 1));
+
+    s32 x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        __m256i px[4];
+        color_avx2_load_16(src + x * 4, px);
+
+        color_avx2_dot_16(px, cy, oy, dest_y + x);
+
+        __m256i q0 = color_avx2_pair_sums(px[0], px[1]);
+        __m256i q1 = color_avx2_pair_sums(px[2], px[3]);
+
+        __m128i u = color_avx2_pack_8(color_avx2_chroma_8(q0, q1, cu, oc, COLOR_SHIFT + 1));
+        __m128i v = color_avx2_pack_8(color_avx2_chroma_8(q0, q1, cv, oc, COLOR_SHIFT + 1));
+
+        _mm_storel_epi64((__m128i*)(dest_u + (x >> 1)), _mm_packus_epi16(u, u));
+        _mm_storel_epi64((__m128i*)(dest_v + (x >> 1)), _mm_packus_epi16(v, v));
+    }
+
+    return x;
+}
+
+SVR_TARGET_AVX2 static s32 color_nv12_rows_avx2(const u8* src_a, const u8* src_b, u8* dest_ya, u8* dest_yb, u8* dest_uv, s32 width)
+{
+    __m256i cy = color_avx2_coefs(COLOR_YB, COLOR_YG, COLOR_YR);
+    __m256i cu = color_avx2_coefs(COLOR_UB, COLOR_UG, COLOR_UR);
+    __m256i cv = color_avx2_coefs(COLOR_VB, COLOR_VG, COLOR_VR);
+    __m256i oy = _mm256_set1_epi32(16 << COLOR_SHIFT);
+    __m256i oc = _mm256_set1_epi32(128 << (COLOR_SHIFT + 2));
+
+    s32 x = 0;
+
+    for (; x + 16 <= width; x += 16)
+    {
+        __m256i pa[4];
+        __m256i pb[4];
+        color_avx2_load_16(src_a + x * 4, pa);
+        color_avx2_load_16(src_b + x * 4, pb);
+
+        color_avx2_dot_16(pa, cy, oy, dest_ya + x);
+        color_avx2_dot_16(pb, cy, oy, dest_yb + x);
+
+        __m256i q0 = color_avx2_pair_sums(_mm256_add_epi16(pa[0], pb[0]), _mm256_add_epi16(pa[1], pb[1]));
+        __m256i q1 = color_avx2_pair_sums(_mm256_add_epi16(pa[2], pb[2]), _mm256_add_epi16(pa[3], pb[3]));
+
+        __m128i u = color_avx2_pack_8(color_avx2_chroma_8(q0, q1, cu, oc, COLOR_SHIFT + 2));
+        __m128i v = color_avx2_pack_8(color_avx2_chroma_8(q0, q1, cv, oc, COLOR_SHIFT + 2));
+
+        // Interleave to U0 V0 U1 V1 and so on.
+        __m128i uv = _mm_packus_epi16(_mm_unpacklo_epi16(u, v), _mm_unpackhi_epi16(u, v));
+        _mm_storeu_si128((__m128i*)(dest_uv + x), uv);
+    }
+
+    return x;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static void color_convert_row_444(SvrSimdLevel level, const u8* src, u8* dest_y, u8* dest_u, u8* dest_v, s32 width)
+{
+    s32 x = 0;
+
+    if (level >= SVR_SIMD_AVX2)
+    {
+        x = color_444_row_avx2(src, dest_y, dest_u, dest_v, width);
+    }
+
+    else if (level >= SVR_SIMD_SSE41)
+    {
+        x = color_444_row_sse41(src, dest_y, dest_u, dest_v, width);
+    }
+
+    color_444_row_scalar(src, dest_y, dest_u, dest_v, x, width);
+}
+
+static void color_convert_row_422(SvrSimdLevel level, const u8* src, u8* dest_y, u8* dest_u, u8* dest_v, s32 width)
+{
+    s32 x = 0;
+
+    if (level >= SVR_SIMD_AVX2)
+    {
+        x = color_422_row_avx2(src, dest_y, dest_u, dest_v, width);
+    }
+
+    else if (level >= SVR_SIMD_SSE41)
+    {
+        x = color_422_row_sse41(src, dest_y, dest_u, dest_v, width);
+    }
+
+    color_422_row_scalar(src, dest_y, dest_u, dest_v, x, width);
+}
+
+static void color_convert_rows_nv12(SvrSimdLevel level, const u8* src_a, const u8* src_b, u8* dest_ya, u8* dest_yb, u8* dest_uv, s32 width)
+{
+    s32 x = 0;
+
+    if (level >= SVR_SIMD_AVX2)
+    {
+        x = color_nv12_rows_avx2(src_a, src_b, dest_ya, dest_yb, dest_uv, width);
+    }
+
+    else if (level >= SVR_SIMD_SSE41)
+    {
+        x = color_nv12_rows_sse41(src_a, src_b, dest_ya, dest_yb, dest_uv, width);
+    }
+
+    color_nv12_rows_scalar(src_a, src_b, dest_ya, dest_yb, dest_uv, x, width);
+}
+
+void svr_color_convert_rows(SvrColorConversion* conv, SvrSimdLevel level, s32 start_row, s32 end_row)
+{
+    end_row = svr_min(end_row, conv->height);
+
+    switch (conv->format)
+    {
+        case SVR_PIXEL_FORMAT_NV12:
+        {
+            assert((start_row & 1) == 0);
+
+            for (s32 i = start_row; i < end_row; i += 2)
+            {
+                // Repeat the edge for odd heights. The last Y row is then written twice with the same values.
+                s32 next_i = svr_min(i + 1, conv->height - 1);
+
+                const u8* src_a = conv->src + (s64)i * conv->src_pitch;
+                const u8* src_b = conv->src + (s64)next_i * conv->src_pitch;
+                u8* dest_ya = conv->planes[0] + (s64)i * conv->pitches[0];
+                u8* dest_yb = conv->planes[0] + (s64)next_i * conv->pitches[0];
+                u8* dest_uv = conv->planes[1] + (s64)(i >> 1) * conv->pitches[1];
+
+                color_convert_rows_nv12(level, src_a, src_b, dest_ya, dest_yb, dest_uv, conv->width);
+            }
+
+            break;
+        }
+
+        case SVR_PIXEL_FORMAT_YUV422P:
+        case SVR_PIXEL_FORMAT_YUV444P:
+        {
+            for (s32 i = start_row; i < end_row; i++)
+            {
+                const u8* src = conv->src + (s64)i * conv->src_pitch;
+                u8* dest_y = conv->planes[0] + (s64)i * conv->pitches[0];
+                u8* dest_u = conv->planes[1] + (s64)i * conv->pitches[1];
+                u8* dest_v = conv->planes[2] + (s64)i * conv->pitches[2];
+
+                if (conv->format == SVR_PIXEL_FORMAT_YUV422P)
+                {
+                    color_convert_row_422(level, src, dest_y, dest_u, dest_v, conv->width);
+                }
+
+                else
+                {
+                    color_convert_row_444(level, src, dest_y, dest_u, dest_v, conv->width);
+                }
+            }
+
+            break;
+        }
+    }
+}
+
+struct ColorWorkData
+{
+    SvrColorConversion* conv;
+    SvrSimdLevel level;
+    s32 rows_per_item;
+};
+
+static void color_work_proc(void* data, s32 start, s32 end)
+{
+    ColorWorkData* work = (ColorWorkData*)data;
+    svr_color_convert_rows(work->conv, work->level, start * work->rows_per_item, end * work->rows_per_item);
+}
+
+void svr_color_convert(SvrColorConversion* conv, SvrSimdLevel level, SvrWorkPool* pool)
+{
+    if (pool == NULL)
+    {
+        svr_color_convert_rows(conv, level, 0, conv->height);
+        return;
+    }
+
+    // NV12 is converted two rows at a time, so the jobs must not split those.
+    ColorWorkData work;
+    work.conv = conv;
+    work.level = level;
+    work.rows_per_item = (conv->format == SVR_PIXEL_FORMAT_NV12) ? 2 : 1;
+
+    s32 num_items = (conv->height + work.rows_per_item - 1) / work.rows_per_item;
+
+    svr_work_pool_run(pool, color_work_proc, &work, num_items, COLOR_ROWS_PER_JOB / work.rows_per_item);
+}
+
+s32 svr_color_get_num_planes(SvrPixelFormat format)
+{
+    switch (format)
+    {
+        case SVR_PIXEL_FORMAT_NV12: return 2;
+        case SVR_PIXEL_FORMAT_YUV422P: return 3;
+        case SVR_PIXEL_FORMAT_YUV444P: return 3;
+    }
+
+    return 0;
+}
+
+SvrVec2I svr_color_get_plane_size(SvrPixelFormat format, s32 plane, s32 width, s32 height)
+{
+    SvrVec2I ret = { width, height };
+
+    if (plane == 0)
+    {
+        return ret;
+    }
+
+    switch (format)
+    {
+        case SVR_PIXEL_FORMAT_NV12:
+        {
+            ret.x = ((width + 1) / 2) * 2; // U and V are interleaved.
+            ret.y = (height + 1) / 2;
+            break;
+        }
+
+        case SVR_PIXEL_FORMAT_YUV422P:
+        {
+            ret.x = (width + 1) / 2;
+            break;
+        }
+    }
+
+    return ret;
+}
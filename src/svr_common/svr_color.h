@@ -0,0 +1,47 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_simd.h"
+
+struct SvrWorkPool;
+
+// Conversion of BGRA pixels from the game to the pixel formats of the video encoders, on the processor.
+// This is the same conversion as tex2vid.hlsl: BT.709 coefficients in partial range.
+// Chroma samples that cover several pixels get the average of those pixels.
+// All levels give exactly the same result as the scalar level.
+
+using SvrPixelFormat = s32;
+
+enum /* SvrPixelFormat */
+{
+    SVR_PIXEL_FORMAT_NV12, // Full size Y plane, and a half width and half height plane with U and V interleaved.
+    SVR_PIXEL_FORMAT_YUV422P, // Full size Y plane, and half width U and V planes.
+    SVR_PIXEL_FORMAT_YUV444P, // Full size Y, U and V planes.
+};
+
+struct SvrColorConversion
+{
+    SvrPixelFormat format;
+    s32 width;
+    s32 height;
+
+    // Source pixels in the B8G8R8A8 format.
+    const u8* src;
+    s32 src_pitch;
+
+    // Destination planes in the order of the pixel format.
+    u8* planes[3];
+    s32 pitches[3];
+};
+
+// Converts a range of rows on the calling thread. The rows must be even for NV12.
+void svr_color_convert_rows(SvrColorConversion* conv, SvrSimdLevel level, s32 start_row, s32 end_row);
+
+// Converts the whole image, split up between the threads of the pool.
+// The pool can be NULL to only use the calling thread.
+void svr_color_convert(SvrColorConversion* conv, SvrSimdLevel level, SvrWorkPool* pool);
+
+// Number of planes for the pixel format.
+s32 svr_color_get_num_planes(SvrPixelFormat format);
+
+// Size of a plane in pixels (bytes per row without padding, and number of rows).
+SvrVec2I svr_color_get_plane_size(SvrPixelFormat format, s32 plane, s32 width, s32 height);
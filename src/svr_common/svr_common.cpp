@@ -3,12 +3,18 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
-#include <Windows.h>
 #include <assert.h>
+
+#ifdef _WIN32
+#include <Windows.h>
 #include <mfapi.h>
-#include <strsafe.h>
 #include <intrin.h>
+#else
+#include <sys/stat.h>
+#include <errno.h>
+#endif
 
+#ifdef _WIN32
 // Prefer to use this instead of calling Release yourself since you can use this to see the actual reference count.
 void svr_release(struct IUnknown* p)
 {
@@ -25,6 +31,7 @@ void svr_maybe_close_handle(void** h)
         *h = NULL;
     }
 }
+#endif
 
 void svr_maybe_free(void** addr)
 {
@@ -87,6 +94,7 @@ bool svr_ends_with(const char* str, const char* suffix)
     return !strcmp(str, suffix);
 }
 
+#ifdef _WIN32
 s32 svr_to_utf16(const char* value, s32 value_length, wchar* buf, s32 buf_chars)
 {
     s32 length = MultiByteToWideChar(CP_UTF8, 0, value, value_length, buf, buf_chars);
@@ -98,6 +106,7 @@ s32 svr_to_utf16(const char* value, s32 value_length, wchar* buf, s32 buf_chars)
 
     return length;
 }
+#endif
 
 template <class T>
 bool svr_are_values_sorted_priv(T* values, s32 num)
@@ -165,6 +174,7 @@ void svr_check_all_mask(bool* mask, s32 num, bool* all_false, bool* all_true)
     *all_true = are_all_true;
 }
 
+#ifdef _WIN32
 char* svr_read_file_as_string(const char* path, SvrReadFileFlags flags)
 {
     HANDLE h = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
@@ -208,6 +218,49 @@ char* svr_read_file_as_string(const char* path, SvrReadFileFlags flags)
 
     return ret;
 }
+#else
+char* svr_read_file_as_string(const char* path, SvrReadFileFlags flags)
+{
+    FILE* f = fopen(path, "rb");
+
+    if (f == NULL)
+    {
+        return NULL;
+    }
+
+    char* ret = NULL;
+
+    fseeko(f, 0, SEEK_END);
+    s64 size = ftello(f);
+    fseeko(f, 0, SEEK_SET);
+
+    s32 ceiling = 1; // Extra for terminator.
+
+    if (flags & SVR_READ_FILE_FLAGS_NEW_LINE)
+    {
+        ceiling++;
+    }
+
+    if (size >= 0 && size < (INT32_MAX - ceiling))
+    {
+        ret = (char*)svr_alloc((s32)size + ceiling);
+
+        size_t extra_pos = fread(ret, 1, size, f);
+
+        if (flags & SVR_READ_FILE_FLAGS_NEW_LINE)
+        {
+            ret[extra_pos] = '\n';
+            extra_pos++;
+        }
+
+        ret[extra_pos] = 0;
+    }
+
+    fclose(f);
+
+    return ret;
+}
+#endif
 
 const char* svr_read_line(const char* start, char* dest, s32 dest_size)
 {
@@ -356,7 +409,9 @@ const char* svr_extract_string(const char* text, char* dest, s32 dest_size)
     ptr = svr_advance_quote(ptr); // Maybe go inside quote.
     const char* next_ptr = svr_advance_string(quoted, ptr); // Read content.
     s32 dist = next_ptr - ptr; // Content length.
-    StringCchCopyNA(dest, dest_size, ptr, dist);
+    s32 copy_length = svr_min(dist, dest_size - 1);
+    memcpy(dest, ptr, copy_length);
+    dest[copy_length] = 0;
     next_ptr = svr_advance_quote(next_ptr); // Maybe go outside quote.
 
     return next_ptr;
@@ -402,7 +457,12 @@ SvrSplitTime svr_split_time(s64 us)
 
 s64 svr_rescale(s64 a, s64 b, s64 c)
 {
+#ifdef _WIN32
     return MFllMulDiv(a, b, c, c / 2);
+#else
+    // Same as MFllMulDiv, the product may not fit in 64 bits.
+    return (s64)(((__int128)a * b + c / 2) / c);
+#endif
 }
 
 bool svr_check_all_true(bool* opts, s32 num)
@@ -445,16 +505,43 @@ s32 svr_count_num_true(bool* opts, s32 num)
 
 s32 svr_count_set_bits(u32 bits)
 {
+#ifdef _WIN32
     s32 ret = __popcnt(bits);
+#else
+    s32 ret = __builtin_popcount(bits);
+#endif
     return ret;
 }
 
 bool svr_does_file_exist(const char* path)
 {
+#ifdef _WIN32
     WIN32_FILE_ATTRIBUTE_DATA attr;
     auto res = GetFileAttributesExA(path, GetFileExInfoStandard, &attr);
 
     return res != 0;
+#else
+    struct stat attr;
+    return stat(path, &attr) == 0;
+#endif
+}
+
+void svr_create_dir(const char* path)
+{
+#ifdef _WIN32
+    CreateDirectoryA(path, NULL);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+u32 svr_get_last_error()
+{
+#ifdef _WIN32
+    return GetLastError();
+#else
+    return (u32)errno;
+#endif
 }
 
 void svr_trim_right(char* buf, s32 length)
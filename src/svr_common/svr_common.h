@@ -1,6 +1,16 @@
 #pragma once
 #include <stdint.h>
 #include <malloc.h>
+
+#ifndef _WIN32
+#include <alloca.h>
+#include <strings.h>
+#define _alloca alloca
+#define strcmpi strcasecmp
+#define _fseeki64 fseeko
+#define _ftelli64 ftello
+#define MAX_PATH 260
+#endif
 #include <stdio.h>
 #include "stb_sprintf.h"
 
@@ -42,7 +52,7 @@ using wchar = wchar_t;
 
 #define SVR_BIT(N) (1 << (N))
 
-#ifdef _WIN64
+#if defined(_WIN64) || defined(__x86_64__)
 #define SVR_IS_X64() true
 #define SVR_IS_X86() false
 #else
@@ -50,12 +60,19 @@ using wchar = wchar_t;
 #define SVR_IS_X86() true
 #endif
 
-#ifdef _WIN64
+#if defined(_WIN64) || defined(__x86_64__)
 #define SVR_ARCH_STRING "x64"
 #else
 #define SVR_ARCH_STRING "x86"
 #endif
 
+// Separator for the paths that are made here. Windows takes a slash in most places too, but not all.
+#ifdef _WIN32
+#define SVR_PATH_SEP "\\"
+#else
+#define SVR_PATH_SEP "/"
+#endif
+
 struct SvrVec2I
 {
     s32 x;
@@ -96,6 +113,7 @@ inline void svr_clamp(T* v, T min, T max)
     *v = svr_min(svr_max(*v, min), max);
 }
 
+#ifdef _WIN32
 // Release a COM based object.
 void svr_release(struct IUnknown* p);
 
@@ -113,6 +131,7 @@ inline void svr_maybe_release(T** ptr)
 
 // Maybe release a HANDLE based object.
 void svr_maybe_close_handle(void** h);
+#endif
 
 void svr_maybe_free(void** addr);
 
@@ -136,7 +155,9 @@ const char* svr_va(const char* format, ...);
 bool svr_starts_with(const char* str, const char* prefix);
 bool svr_ends_with(const char* str, const char* suffix);
 
+#ifdef _WIN32
 s32 svr_to_utf16(const char* value, s32 value_length, wchar* buf, s32 buf_chars);
+#endif
 
 bool svr_is_sorted(s32* idxs, s32 num);
 bool svr_are_idxs_unique(s32* idxs, s32 num);
@@ -190,4 +211,10 @@ s32 svr_count_set_bits(u32 bits);
 
 bool svr_does_file_exist(const char* path);
 
+// Creates the directory if it is not there already. The directory above must exist.
+void svr_create_dir(const char* path);
+
+// Code of the last failed system call on this thread, for error messages. GetLastError on Windows and errno on other platforms.
+u32 svr_get_last_error();
+
 void svr_trim_right(char* buf, s32 length);
@@ -0,0 +1,126 @@
+#include "svr_copy.h"
+#include "svr_work_pool.h"
+#include <string.h>
+#include <immintrin.h>
+
+// Wider stores than 16 bytes don't make the copy faster since it is limited by memory, so AVX2 uses the SSE4.1 path.
+
+// Rows that a thread copies at a time. Big enough that the jobs are not just overhead, small enough to even out the threads.
+const s32 COPY_ROWS_PER_JOB = 32;
+
+// Copies until the destination is aligned for the streaming stores.
+// Returns how many bytes were copied.
+static inline s32 copy_align_head(u8* dest, const u8* src, s32 size, s32 align)
+{
+    s32 head = (s32)((align - ((uintptr_t)dest & (align - 1))) & (align - 1));
+    head = svr_min(head, size);
+
+    memcpy(dest, src, head);
+
+    return head;
+}
+
+SVR_TARGET_SSE41 static void copy_row_sse41(u8* dest, const u8* src, s32 size)
+{
+    s32 x = copy_align_head(dest, src, size, 16);
+
+    for (; x + 64 <= size; x += 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + x + 0));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + x + 16));
+        __m128i c = _mm_loadu_si128((const __m128i*)(src + x + 32));
+        __m128i d = _mm_loadu_si128((const __m128i*)(src + x + 48));
+
+        _mm_stream_si128((__m128i*)(dest + x + 0), a);
+        _mm_stream_si128((__m128i*)(dest + x + 16), b);
+        _mm_stream_si128((__m128i*)(dest + x + 32), c);
+        _mm_stream_si128((__m128i*)(dest + x + 48), d);
+    }
+
+    for (; x + 16 <= size; x += 16)
+    {
+        _mm_stream_si128((__m128i*)(dest + x), _mm_loadu_si128((const __m128i*)(src + x)));
+    }
+
+    memcpy(dest + x, src + x, size - x);
+}
+
+// Copies a range of rows, where the rows of all planes are numbered one after the other.
+static void copy_rows(SvrCopyJob* job, s32 start, s32 end)
+{
+    s32 plane_start = 0;
+
+    for (s32 i = 0; i < job->num_planes && start < end; i++)
+    {
+        SvrPlaneCopy* plane = &job->planes[i];
+        s32 plane_end = plane_start + plane->num_rows;
+
+        if (start < plane_end)
+        {
+            s32 last = svr_min(end, plane_end);
+
+            for (s32 j = start - plane_start; j < last - plane_start; j++)
+            {
+                u8* dest = plane->dest + (s64)j * plane->dest_pitch;
+                const u8* src = plane->src + (s64)j * plane->src_pitch;
+
+                if (job->level >= SVR_SIMD_SSE41)
+                {
+                    copy_row_sse41(dest, src, plane->row_size);
+                }
+
+                else
+                {
+                    memcpy(dest, src, plane->row_size);
+                }
+            }
+
+            start = last;
+        }
+
+        plane_start = plane_end;
+    }
+
+    // The streaming stores must be visible to the other threads when the copy is done.
+    if (job->level >= SVR_SIMD_SSE41)
+    {
+        _mm_sfence();
+    }
+}
+
+static void copy_work_proc(void* data, s32 start, s32 end)
+{
+    copy_rows((SvrCopyJob*)data, start, end);
+}
+
+static s32 copy_get_total_rows(SvrCopyJob* job)
+{
+    s32 ret = 0;
+
+    for (s32 i = 0; i < job->num_planes; i++)
+    {
+        ret += job->planes[i].num_rows;
+    }
+
+    return ret;
+}
+
+void svr_copy_planes(SvrCopyJob* job)
+{
+    copy_rows(job, 0, copy_get_total_rows(job));
+}
+
+void svr_copy_planes_parallel(SvrCopyJob* job, SvrWorkPool* pool)
+{
+    svr_work_pool_run(pool, copy_work_proc, job, copy_get_total_rows(job), COPY_ROWS_PER_JOB);
+}
+
+void svr_copy_start(SvrCopyJob* job, SvrWorkPool* pool)
+{
+    svr_work_pool_start(pool, copy_work_proc, job, copy_get_total_rows(job), COPY_ROWS_PER_JOB);
+}
+
+void svr_copy_wait(SvrWorkPool* pool)
+{
+    svr_work_pool_wait(pool);
+}
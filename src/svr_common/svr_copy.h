@@ -0,0 +1,41 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_simd.h"
+
+struct SvrWorkPool;
+
+// Copying of image planes between buffers with different pitches, such as from mapped textures to video frames.
+// The destination is written with non-temporal stores so that big frames don't push everything else out of the cache,
+// since the destination is not read again until much later by another thread.
+
+const s32 SVR_COPY_MAX_PLANES = 4;
+
+struct SvrPlaneCopy
+{
+    const u8* src;
+    u8* dest;
+    s32 src_pitch;
+    s32 dest_pitch;
+    s32 row_size; // Bytes to copy per row. Must not be larger than any of the pitches.
+    s32 num_rows;
+};
+
+struct SvrCopyJob
+{
+    SvrPlaneCopy planes[SVR_COPY_MAX_PLANES];
+    s32 num_planes;
+    SvrSimdLevel level;
+};
+
+// Copies all planes on the calling thread.
+void svr_copy_planes(SvrCopyJob* job);
+
+// Copies all planes, split up between the threads of the pool.
+void svr_copy_planes_parallel(SvrCopyJob* job, SvrWorkPool* pool);
+
+// Starts copying all planes on the pool threads and returns immediately.
+// The job and the buffers must stay valid until svr_copy_wait is called.
+void svr_copy_start(SvrCopyJob* job, SvrWorkPool* pool);
+
+// Waits for the copy from svr_copy_start to finish.
+void svr_copy_wait(SvrWorkPool* pool);
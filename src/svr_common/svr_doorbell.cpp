@@ -0,0 +1,41 @@
+#include "svr_doorbell.h"
+
+// How many times to check before parking.
+// Picked so that a consumer that is a little faster than its producer never has to sleep.
+const s32 DOORBELL_SPIN_COUNT = 4096;
+
+s32 svr_doorbell_prepare(SvrDoorbell* bell)
+{
+    return svr_atom_load(&bell->seq);
+}
+
+void svr_doorbell_wait(SvrDoorbell* bell, s32 ticket)
+{
+    for (s32 i = 0; i < DOORBELL_SPIN_COUNT; i++)
+    {
+        if (svr_atom_load(&bell->seq) != ticket)
+        {
+            return;
+        }
+
+        svr_cpu_relax();
+    }
+
+    // Both this and the increment in svr_doorbell_ring are full barriers.
+    // Either the producer sees that we are sleeping, or we see the new sequence.
+    svr_atom_add(&bell->num_sleepers, 1);
+
+    svr_wait_while_atom_is(&bell->seq, ticket);
+
+    svr_atom_sub(&bell->num_sleepers, 1);
+}
+
+void svr_doorbell_ring(SvrDoorbell* bell)
+{
+    svr_atom_add(&bell->seq, 1);
+
+    if (svr_atom_load(&bell->num_sleepers) > 0)
+    {
+        svr_notify_atom_changed(&bell->seq);
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_atom.h"
+
+// Wakeup signal for threads that consume from the lock free rings.
+// The consumer spins for a short while before going to sleep, and the producer only makes a system call
+// when there actually is a sleeping consumer. This replaces an event that is set on every single push.
+
+// Usage for the consumer:
+// s32 ticket = svr_doorbell_prepare(&bell);
+// Pull everything from the ring.
+// svr_doorbell_wait(&bell, ticket);
+
+// Usage for the producer:
+// Push to the ring.
+// svr_doorbell_ring(&bell);
+
+struct SvrDoorbell
+{
+    SvrAtom32 seq; // Increased on every ring.
+    SvrAtom32 num_sleepers; // How many threads are parked on seq.
+};
+
+// Take a ticket before checking for work, so rings that happen after this are not missed.
+s32 svr_doorbell_prepare(SvrDoorbell* bell);
+
+// Wait until the doorbell has been rung after the ticket was taken.
+void svr_doorbell_wait(SvrDoorbell* bell, s32 ticket);
+
+// Wake the consumer if it is waiting.
+void svr_doorbell_ring(SvrDoorbell* bell);
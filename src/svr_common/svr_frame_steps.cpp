@@ -0,0 +1,58 @@
+#include "svr_frame_steps.h"
+#include <assert.h>
+
+void svr_frame_steps_init(SvrFrameSteps* fs, s32 game_rate, s32 frames_ahead)
+{
+    assert(frames_ahead >= 0 && frames_ahead <= SVR_FRAME_STEPS_MAX_AHEAD);
+
+    *fs = {};
+
+    fs->game_rate = game_rate;
+    fs->frames_ahead = frames_ahead;
+    fs->current = 1;
+
+    // The frames that are already running use the game rate.
+    for (s32 i = 0; i < SVR_FRAME_STEPS_MAX_AHEAD + 1; i++)
+    {
+        fs->steps[i] = 1;
+    }
+}
+
+bool svr_frame_steps_set(SvrFrameSteps* fs, s32 steps, char* dest, s32 dest_size)
+{
+    fs->steps[(fs->num_frames + fs->frames_ahead) % (SVR_FRAME_STEPS_MAX_AHEAD + 1)] = steps;
+
+    if (steps == fs->current)
+    {
+        return false;
+    }
+
+    fs->current = steps;
+
+    if (steps == 1)
+    {
+        stbsp_snprintf(dest, dest_size, "host_framerate %d\n", fs->game_rate);
+    }
+
+    else
+    {
+        // 17 significant digits are needed for any double to be read back exactly.
+        stbsp_snprintf(dest, dest_size, "host_framerate %.17g\n", (double)fs->game_rate / (double)steps);
+    }
+
+    return true;
+}
+
+bool svr_frame_steps_check(SvrFrameSteps* fs, s32 steps)
+{
+    s32 set_steps = fs->steps[fs->num_frames % (SVR_FRAME_STEPS_MAX_AHEAD + 1)];
+    fs->num_frames++;
+
+    if (steps != set_steps)
+    {
+        fs->num_wrong++;
+        return false;
+    }
+
+    return true;
+}
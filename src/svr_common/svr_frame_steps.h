@@ -0,0 +1,36 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_mosample.h"
+
+// Keeps track of the host_framerate that a game has set for the frames that it gives to svr_frame.
+// A new host_framerate shows up some svr_frame calls later, so the steps of a frame are asked for ahead of time with svr_get_frame_steps.
+// When that frame is given to svr_frame, the steps must still be the same, or the frame does not cover the time that the motion blur
+// and the audio expect.
+
+// Usage:
+// svr_frame_steps_init when the movie starts and host_framerate is set to the game rate.
+// svr_frame_steps_set in every frame with the steps of the frame that is frames_ahead svr_frame calls away.
+// svr_frame_steps_check in every frame with the steps of the frame that is given to svr_frame now.
+
+const s32 SVR_FRAME_STEPS_MAX_AHEAD = SVR_MOSAMPLE_START_FRAMES;
+
+struct SvrFrameSteps
+{
+    s32 game_rate; // Frames per second when every frame covers one step.
+    s32 frames_ahead; // svr_frame calls until a new host_framerate shows up.
+    s32 current; // Steps that host_framerate was last set to cover.
+    s64 num_frames; // Number of frames that have been checked.
+    s64 num_wrong; // Frames where host_framerate was set for other steps than the ones given to svr_frame.
+    s32 steps[SVR_FRAME_STEPS_MAX_AHEAD + 1]; // Steps that host_framerate was set for, by frame number.
+};
+
+void svr_frame_steps_init(SvrFrameSteps* fs, s32 game_rate, s32 frames_ahead);
+
+// Sets the steps of the frame that is given to svr_frame after frames_ahead more calls.
+// Returns true if host_framerate has to be changed, with the console command written to dest.
+// The rate is written so that it reads back as the same double, so nothing drifts from rounding.
+bool svr_frame_steps_set(SvrFrameSteps* fs, s32 steps, char* dest, s32 dest_size);
+
+// Checks the steps of the frame that is given to svr_frame now against what host_framerate was set for.
+// Returns false if they are not the same.
+bool svr_frame_steps_check(SvrFrameSteps* fs, s32 steps);
@@ -0,0 +1,239 @@
+#include "svr_glyphs.h"
+#include "svr_alloc.h"
+#include <string.h>
+#include <math.h>
+#include <immintrin.h>
+
+// The blend is in integers: out = (color * a + dest * (255 - a)) / 255, rounded.
+// The color of the fourth channel is 255, so the alpha of the destination is blended the same way as the colors.
+// Every sum fits in 16 bits, so the SIMD level can use 16-bit lanes and give the same result.
+
+struct GlyphColor
+{
+    s32 channels[4]; // In the order of the pixels, with 255 as the last.
+    s32 alpha;
+};
+
+static inline s32 glyph_div255(s32 v)
+{
+    v += 128;
+    return (v + (v >> 8)) >> 8;
+}
+
+static GlyphColor glyph_make_color(SvrVec4I color)
+{
+    GlyphColor ret;
+    ret.channels[0] = color.z;
+    ret.channels[1] = color.y;
+    ret.channels[2] = color.x;
+    ret.channels[3] = 255;
+    ret.alpha = color.w;
+
+    for (s32 i = 0; i < 4; i++)
+    {
+        svr_clamp(&ret.channels[i], 0, 255);
+    }
+
+    svr_clamp(&ret.alpha, 0, 255);
+
+    return ret;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Scalar level.
+// The row functions start at pixel x and continue to end.
+
+static void glyph_blend_row_scalar(const u8* cov, u8* dest, s32 x, s32 end, GlyphColor* color)
+{
+    for (; x < end; x++)
+    {
+        s32 a = glyph_div255(cov[x] * color->alpha);
+
+        if (a == 0)
+        {
+            continue;
+        }
+
+        u8* px = dest + x * 4;
+
+        for (s32 i = 0; i < 4; i++)
+        {
+            px[i] = (u8)glyph_div255(color->channels[i] * a + px[i] * (255 - a));
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// SSE4.1 level.
+// 4 pixels at a time, as two halves of 2 pixels in 16-bit lanes.
+// Returns the pixel where the scalar level should continue.
+
+SVR_TARGET_SSE41 static inline __m128i glyph_sse41_div255(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+SVR_TARGET_SSE41 static inline __m128i glyph_sse41_blend_half(__m128i d, __m128i cov, __m128i col, __m128i alpha)
+{
+    __m128i a = glyph_sse41_div255(_mm_mullo_epi16(cov, alpha));
+    __m128i inv_a = _mm_sub_epi16(_mm_set1_epi16(255), a);
+
+    return glyph_sse41_div255(_mm_add_epi16(_mm_mullo_epi16(col, a), _mm_mullo_epi16(d, inv_a)));
+}
+
+SVR_TARGET_SSE41 static s32 glyph_blend_row_sse41(const u8* cov, u8* dest, s32 x, s32 end, GlyphColor* color)
+{
+    __m128i col = _mm_setr_epi16((s16)color->channels[0], (s16)color->channels[1], (s16)color->channels[2], (s16)color->channels[3],
+                                 (s16)color->channels[0], (s16)color->channels[1], (s16)color->channels[2], (s16)color->channels[3]);
+    __m128i alpha = _mm_set1_epi16((s16)color->alpha);
+
+    // Spreads the coverage of a pixel to the lanes of its channels.
+    __m128i lo_mask = _mm_setr_epi8(0, -1, 0, -1, 0, -1, 0, -1, 1, -1, 1, -1, 1, -1, 1, -1);
+    __m128i hi_mask = _mm_setr_epi8(2, -1, 2, -1, 2, -1, 2, -1, 3, -1, 3, -1, 3, -1, 3, -1);
+
+    __m128i zero = _mm_setzero_si128();
+
+    for (; x + 4 <= end; x += 4)
+    {
+        s32 cov4;
+        memcpy(&cov4, cov + x, 4);
+
+        if (cov4 == 0)
+        {
+            continue;
+        }
+
+        __m128i c = _mm_cvtsi32_si128(cov4);
+        __m128i d = _mm_loadu_si128((__m128i*)(dest + x * 4));
+
+        __m128i lo = glyph_sse41_blend_half(_mm_unpacklo_epi8(d, zero), _mm_shuffle_epi8(c, lo_mask), col, alpha);
+        __m128i hi = glyph_sse41_blend_half(_mm_unpackhi_epi8(d, zero), _mm_shuffle_epi8(c, hi_mask), col, alpha);
+
+        _mm_storeu_si128((__m128i*)(dest + x * 4), _mm_packus_epi16(lo, hi));
+    }
+
+    return x;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Drawing.
+
+static void glyph_blend_cell(SvrGlyphAtlas* atlas, const u8* cells, s32 digit, s32 x0, s32 y0, GlyphColor* color,
+                             u8* dest, s32 dest_pitch, s32 width, s32 height, SvrSimdLevel level)
+{
+    s32 pitch = svr_glyph_get_atlas_pitch(atlas);
+    const u8* cell = cells + digit * atlas->cell_width;
+
+    s32 start_x = svr_max(0, -x0);
+    s32 end_x = svr_min(atlas->cell_width, width - x0);
+    s32 start_y = svr_max(0, -y0);
+    s32 end_y = svr_min(atlas->cell_height, height - y0);
+
+    for (s32 y = start_y; y < end_y; y++)
+    {
+        // Moved so that the cell column is the same as the destination column.
+        const u8* cov = cell + (s64)y * pitch - x0;
+        u8* dest_row = dest + (s64)(y0 + y) * dest_pitch;
+
+        s32 x = x0 + start_x;
+        s32 end = x0 + end_x;
+
+        if (level >= SVR_SIMD_SSE41)
+        {
+            x = glyph_blend_row_sse41(cov, dest_row, x, end, color);
+        }
+
+        glyph_blend_row_scalar(cov, dest_row, x, end, color);
+    }
+}
+
+void svr_glyph_create_atlas(SvrGlyphAtlas* atlas, s32 cell_width, s32 cell_height, SvrVec2I origin, float advance, bool has_border)
+{
+    *atlas = {};
+
+    atlas->cell_width = cell_width;
+    atlas->cell_height = cell_height;
+    atlas->origin = origin;
+    atlas->advance = advance;
+
+    s32 size = svr_glyph_get_atlas_pitch(atlas) * cell_height;
+
+    atlas->fill = (u8*)svr_zalloc(size);
+
+    if (has_border)
+    {
+        atlas->border = (u8*)svr_zalloc(size);
+    }
+}
+
+void svr_glyph_free_atlas(SvrGlyphAtlas* atlas)
+{
+    if (atlas->fill)
+    {
+        svr_free(atlas->fill);
+        atlas->fill = NULL;
+    }
+
+    if (atlas->border)
+    {
+        svr_free(atlas->border);
+        atlas->border = NULL;
+    }
+}
+
+s32 svr_glyph_get_atlas_pitch(SvrGlyphAtlas* atlas)
+{
+    return atlas->cell_width * SVR_GLYPH_NUM_DIGITS;
+}
+
+// Digits are placed at whole pixels, since the cells were rasterized at whole pixels.
+static s32 glyph_get_digit_x(SvrGlyphAtlas* atlas, s32 idx)
+{
+    return (s32)floorf(idx * atlas->advance + 0.5f);
+}
+
+SvrVec4I svr_glyph_get_text_rect(SvrGlyphAtlas* atlas, s32 num_digits)
+{
+    SvrVec4I ret = {};
+
+    if (num_digits > 0)
+    {
+        ret.x = -atlas->origin.x;
+        ret.y = -atlas->origin.y;
+        ret.z = glyph_get_digit_x(atlas, num_digits - 1) + atlas->cell_width;
+        ret.w = atlas->cell_height;
+    }
+
+    return ret;
+}
+
+void svr_glyph_draw_digits(SvrGlyphAtlas* atlas, const char* digits, s32 num_digits, SvrVec2I pos, SvrVec4I fill_color, SvrVec4I border_color,
+                           u8* dest, s32 dest_pitch, s32 width, s32 height, SvrSimdLevel level)
+{
+    GlyphColor colors[] = { glyph_make_color(fill_color), glyph_make_color(border_color) };
+    const u8* layers[] = { atlas->fill, atlas->border };
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(layers); i++)
+    {
+        if (layers[i] == NULL || colors[i].alpha == 0)
+        {
+            continue;
+        }
+
+        for (s32 j = 0; j < num_digits; j++)
+        {
+            s32 digit = digits[j] - '0';
+
+            if (digit < 0 || digit >= SVR_GLYPH_NUM_DIGITS)
+            {
+                continue;
+            }
+
+            s32 x = pos.x + glyph_get_digit_x(atlas, j) - atlas->origin.x;
+            s32 y = pos.y - atlas->origin.y;
+
+            glyph_blend_cell(atlas, layers[i], digit, x, y, &colors[i], dest, dest_pitch, width, height, level);
+        }
+    }
+}
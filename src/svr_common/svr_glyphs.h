@@ -0,0 +1,38 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_simd.h"
+
+// Drawing of numbers from glyphs that are rasterized once, for the velo text.
+// The ten digits are rasterized into an atlas of coverage values when the font is loaded, so drawing a number is only
+// a blend of atlas cells over the pixels that the text covers. Every digit has the same advance, like tabular numbers.
+// The fill of all digits is drawn first and then the border, like an outline that is filled and then stroked.
+// Pixels are B8G8R8A8 with premultiplied alpha, which is the same as straight alpha for opaque frames.
+// All levels give exactly the same result as the scalar level.
+
+const s32 SVR_GLYPH_NUM_DIGITS = 10;
+
+struct SvrGlyphAtlas
+{
+    s32 cell_width;
+    s32 cell_height;
+    SvrVec2I origin; // Baseline origin in every cell.
+    float advance; // Pixels between the origins of two digits.
+
+    // Coverage from 0 to 255. The digits are next to each other in one row of cells, so the pitch is cell_width * SVR_GLYPH_NUM_DIGITS.
+    u8* fill;
+    u8* border; // NULL if there is no border.
+};
+
+void svr_glyph_create_atlas(SvrGlyphAtlas* atlas, s32 cell_width, s32 cell_height, SvrVec2I origin, float advance, bool has_border);
+void svr_glyph_free_atlas(SvrGlyphAtlas* atlas);
+
+s32 svr_glyph_get_atlas_pitch(SvrGlyphAtlas* atlas);
+
+// Rectangle that a number covers when the baseline origin of the first digit is at 0, 0.
+// The x and y are the top left corner and the z and w are the size.
+SvrVec4I svr_glyph_get_text_rect(SvrGlyphAtlas* atlas, s32 num_digits);
+
+// Draws a string of digits with the baseline origin of the first digit at pos. Only the pixels inside the frame are touched.
+// Colors are RGBA from 0 to 255 with straight alpha.
+void svr_glyph_draw_digits(SvrGlyphAtlas* atlas, const char* digits, s32 num_digits, SvrVec2I pos, SvrVec4I fill_color, SvrVec4I border_color,
+                           u8* dest, s32 dest_pitch, s32 width, s32 height, SvrSimdLevel level);
@@ -1,6 +1,6 @@
 #include "svr_ini.h"
 #include "svr_alloc.h"
-#include <strsafe.h>
+#include <string.h>
 
 using SvrIniLineType = s32;
 
@@ -153,7 +153,9 @@ SvrIniKeyValue* svr_ini_parse_expression(const char* expr)
         return NULL; // There is only an equal sign and nothing else.
     }
 
-    StringCchCopyNA(key_name, SVR_ARRAY_SIZE(key_name), ptr, dist);
+    s32 copy_length = svr_min(dist, SVR_ARRAY_SIZE(key_name) - 1);
+    memcpy(key_name, ptr, copy_length);
+    key_name[copy_length] = 0;
 
     ptr = next_ptr;
 
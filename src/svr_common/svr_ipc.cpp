@@ -0,0 +1,605 @@
+#include "svr_ipc.h"
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+
+bool svr_ipc_create_mem(s32 size, SvrIpcMem* mem)
+{
+    bool ret = false;
+
+    *mem = {};
+
+    SECURITY_ATTRIBUTES sa = {};
+    sa.nLength = sizeof(sa);
+    sa.bInheritHandle = TRUE; // Allow child processes to use this handle too.
+
+    // Create shared memory handle without a name. The handle is passed as a parameter to the child process
+    // and it will open in that way, since we use inherited handles.
+    HANDLE mem_h = CreateFileMappingA(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, size, NULL);
+
+    if (mem_h == NULL)
+    {
+        goto rfail;
+    }
+
+    mem->handle = (u32)mem_h;
+    mem->ptr = MapViewOfFile(mem_h, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+
+    if (mem->ptr == NULL)
+    {
+        goto rfail;
+    }
+
+    mem->size = size;
+    mem->owner = true;
+
+    memset(mem->ptr, 0, size); // Put to known state.
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    svr_ipc_free_mem(mem);
+
+rexit:
+    return ret;
+}
+
+void svr_ipc_get_mem_id(SvrIpcMem* mem, char* buf, s32 buf_size)
+{
+    // Inherited handles have the same value in the child process.
+    stbsp_snprintf(buf, buf_size, "%u", mem->handle);
+}
+
+bool svr_ipc_open_mem(const char* id, SvrIpcMem* mem)
+{
+    bool ret = false;
+
+    *mem = {};
+
+    // The child may be 64-bit and the parent 32-bit, but all handles only have 32 bits significant, so this is safe.
+    // The handle is not kept since it may be the same one that the creator has, when both are in the same process.
+    // The view keeps the memory alive by itself.
+    HANDLE mem_h = (HANDLE)strtoul(id, NULL, 10);
+    mem->ptr = MapViewOfFile(mem_h, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+
+    if (mem->ptr == NULL)
+    {
+        goto rfail;
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(mem->ptr, &info, sizeof(info));
+
+    mem->size = (s32)info.RegionSize;
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    svr_ipc_free_mem(mem);
+
+rexit:
+    return ret;
+}
+
+bool svr_ipc_give_mem(SvrIpcMem* mem, SvrIpcProcess* process, char* buf, s32 buf_size)
+{
+    HANDLE new_h;
+
+    if (!DuplicateHandle(GetCurrentProcess(), (HANDLE)mem->handle, (HANDLE)process->handle, &new_h, 0, FALSE, DUPLICATE_SAME_ACCESS))
+    {
+        return false;
+    }
+
+    // The handle only exists in the other process.
+    stbsp_snprintf(buf, buf_size, "%u", (u32)new_h);
+    return true;
+}
+
+bool svr_ipc_open_given_mem(const char* id, SvrIpcMem* mem)
+{
+    HANDLE mem_h = (HANDLE)strtoul(id, NULL, 10);
+
+    // Unlike with svr_ipc_open_mem, the handle was made for this process only, so it is ours to close.
+    // It must be closed even if the view could not be made, or the memory would stay until this process exits.
+    if (!svr_ipc_open_mem(id, mem))
+    {
+        CloseHandle(mem_h);
+        return false;
+    }
+
+    mem->handle = (u32)mem_h;
+    return true;
+}
+
+bool svr_ipc_create_named_mem(const char* name, s32 size, SvrIpcMem* mem)
+{
+    bool ret = false;
+
+    *mem = {};
+
+    // Names without a prefix are in the namespace of the session, so only processes of this session can see it.
+    // The mapping goes away when the last handle or view is closed, so nothing is left behind if the process crashes.
+    HANDLE mem_h = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, name);
+
+    if (mem_h == NULL)
+    {
+        goto rfail;
+    }
+
+    mem->handle = (u32)mem_h;
+
+    // The handle of the existing mapping is given back when the name is already used.
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        goto rfail;
+    }
+
+    mem->ptr = MapViewOfFile(mem_h, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+
+    if (mem->ptr == NULL)
+    {
+        goto rfail;
+    }
+
+    mem->size = size;
+    mem->owner = true;
+
+    memset(mem->ptr, 0, size);
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    svr_ipc_free_mem(mem);
+
+rexit:
+    return ret;
+}
+
+bool svr_ipc_open_named_mem(const char* name, SvrIpcMem* mem)
+{
+    bool ret = false;
+
+    *mem = {};
+
+    HANDLE mem_h = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, name);
+
+    if (mem_h == NULL)
+    {
+        goto rfail;
+    }
+
+    mem->handle = (u32)mem_h;
+    mem->ptr = MapViewOfFile(mem_h, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+
+    if (mem->ptr == NULL)
+    {
+        goto rfail;
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(mem->ptr, &info, sizeof(info));
+
+    mem->size = (s32)info.RegionSize;
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    svr_ipc_free_mem(mem);
+
+rexit:
+    return ret;
+}
+
+void svr_ipc_free_mem(SvrIpcMem* mem)
+{
+    if (mem->ptr)
+    {
+        UnmapViewOfFile(mem->ptr);
+        mem->ptr = NULL;
+    }
+
+    if (mem->handle)
+    {
+        CloseHandle((HANDLE)mem->handle);
+        mem->handle = 0;
+    }
+}
+
+bool svr_ipc_create_event(SvrIpcEvent* event)
+{
+    SECURITY_ATTRIBUTES sa = {};
+    sa.nLength = sizeof(sa);
+    sa.bInheritHandle = TRUE;
+
+    // These must be auto reset events so there are no race conditions!
+    HANDLE event_h = CreateEventA(&sa, FALSE, FALSE, NULL);
+
+    event->handle = (u32)event_h;
+    svr_atom_store(&event->signaled, 0);
+
+    return event_h != NULL;
+}
+
+void svr_ipc_close_event(SvrIpcEvent* event)
+{
+    if (event->handle)
+    {
+        CloseHandle((HANDLE)event->handle);
+    }
+}
+
+void svr_ipc_set_event(SvrIpcEvent* event)
+{
+    SetEvent((HANDLE)event->handle);
+}
+
+SvrIpcWaitResult svr_ipc_wait(SvrIpcEvent* event, SvrIpcProcess* process)
+{
+    if (process == NULL)
+    {
+        WaitForSingleObject((HANDLE)event->handle, INFINITE);
+        return SVR_IPC_WAIT_EVENT;
+    }
+
+    HANDLE handles[] =
+    {
+        (HANDLE)process->handle,
+        (HANDLE)event->handle,
+    };
+
+    DWORD waited = WaitForMultipleObjects(SVR_ARRAY_SIZE(handles), handles, FALSE, INFINITE);
+    HANDLE waited_h = handles[waited - WAIT_OBJECT_0];
+
+    if (waited_h == (HANDLE)process->handle)
+    {
+        return SVR_IPC_WAIT_EXITED;
+    }
+
+    return SVR_IPC_WAIT_EVENT;
+}
+
+bool svr_ipc_open_process(u32 pid, SvrIpcProcess* process)
+{
+    HANDLE process_h = OpenProcess(SYNCHRONIZE, FALSE, pid);
+
+    process->handle = process_h;
+    process->pid = pid;
+
+    return process_h != NULL;
+}
+
+void svr_ipc_close_process(SvrIpcProcess* process)
+{
+    if (process->handle)
+    {
+        CloseHandle((HANDLE)process->handle);
+        process->handle = NULL;
+    }
+}
+
+u32 svr_ipc_get_current_pid()
+{
+    return GetCurrentProcessId();
+}
+
+#else
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+
+// How long to sleep at most before checking if the other process is still there.
+const s32 IPC_PROCESS_CHECK_MS = 50;
+
+// Not the private futex operations, since the waiter and the waker are in different processes.
+
+static void ipc_futex_wait(s32* addr, s32 value, struct timespec* timeout)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT, value, timeout, NULL, 0);
+}
+
+static void ipc_futex_wake_one(s32* addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static bool ipc_is_process_alive(SvrIpcProcess* process)
+{
+    // A child that has exited stays around until it is waited for, so check that first.
+    int status;
+    pid_t res = waitpid((pid_t)process->pid, &status, WNOHANG);
+
+    if (res == (pid_t)process->pid)
+    {
+        return false;
+    }
+
+    if (kill((pid_t)process->pid, 0) == -1 && errno == ESRCH)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// The descriptors are closed once the memory is mapped, since the mapping stays valid without them.
+
+bool svr_ipc_create_mem(s32 size, SvrIpcMem* mem)
+{
+    bool ret = false;
+    s32 fd = -1;
+
+    *mem = {};
+
+    SVR_SNPRINTF(mem->name, "/svr_ipc_%u_%p", (u32)getpid(), (void*)mem);
+
+    fd = shm_open(mem->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if (fd == -1)
+    {
+        goto rfail;
+    }
+
+    mem->owner = true;
+
+    if (ftruncate(fd, size) == -1)
+    {
+        goto rfail;
+    }
+
+    mem->ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (mem->ptr == MAP_FAILED)
+    {
+        mem->ptr = NULL;
+        goto rfail;
+    }
+
+    mem->size = size; // New memory from ftruncate is already zeroed.
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    svr_ipc_free_mem(mem);
+
+rexit:
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return ret;
+}
+
+void svr_ipc_get_mem_id(SvrIpcMem* mem, char* buf, s32 buf_size)
+{
+    stbsp_snprintf(buf, buf_size, "%s", mem->name);
+}
+
+// Any process of the same user can open the memory from the name.
+bool svr_ipc_give_mem(SvrIpcMem* mem, SvrIpcProcess* process, char* buf, s32 buf_size)
+{
+    (void)process;
+
+    svr_ipc_get_mem_id(mem, buf, buf_size);
+    return true;
+}
+
+bool svr_ipc_open_given_mem(const char* id, SvrIpcMem* mem)
+{
+    return svr_ipc_open_mem(id, mem);
+}
+
+bool svr_ipc_open_mem(const char* id, SvrIpcMem* mem)
+{
+    bool ret = false;
+    s32 fd = -1;
+    struct stat info;
+
+    *mem = {};
+
+    SVR_SNPRINTF(mem->name, "%s", id);
+
+    fd = shm_open(mem->name, O_RDWR, 0600);
+
+    if (fd == -1)
+    {
+        goto rfail;
+    }
+
+    if (fstat(fd, &info) == -1)
+    {
+        goto rfail;
+    }
+
+    mem->ptr = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (mem->ptr == MAP_FAILED)
+    {
+        mem->ptr = NULL;
+        goto rfail;
+    }
+
+    mem->size = (s32)info.st_size;
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    svr_ipc_free_mem(mem);
+
+rexit:
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return ret;
+}
+
+bool svr_ipc_create_named_mem(const char* name, s32 size, SvrIpcMem* mem)
+{
+    bool ret = false;
+    s32 fd = -1;
+
+    *mem = {};
+
+    SVR_SNPRINTF(mem->name, "/%s", name);
+
+    fd = shm_open(mem->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    // Shared memory stays until it is removed, so the name may be left over from a process that crashed.
+    // That can't be told apart from a process that still runs, so the name is taken over. The other process keeps its own memory.
+    if (fd == -1 && errno == EEXIST)
+    {
+        shm_unlink(mem->name);
+        fd = shm_open(mem->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+
+    if (fd == -1)
+    {
+        goto rfail;
+    }
+
+    mem->owner = true;
+
+    if (ftruncate(fd, size) == -1)
+    {
+        goto rfail;
+    }
+
+    mem->ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (mem->ptr == MAP_FAILED)
+    {
+        mem->ptr = NULL;
+        goto rfail;
+    }
+
+    mem->size = size; // New memory from ftruncate is already zeroed.
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    svr_ipc_free_mem(mem);
+
+rexit:
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return ret;
+}
+
+bool svr_ipc_open_named_mem(const char* name, SvrIpcMem* mem)
+{
+    char full_name[64];
+    SVR_SNPRINTF(full_name, "/%s", name);
+
+    return svr_ipc_open_mem(full_name, mem);
+}
+
+void svr_ipc_free_mem(SvrIpcMem* mem)
+{
+    if (mem->ptr)
+    {
+        munmap(mem->ptr, mem->size);
+        mem->ptr = NULL;
+    }
+
+    // The name can be removed right away, the memory stays until everyone has unmapped it.
+    if (mem->owner)
+    {
+        shm_unlink(mem->name);
+        mem->owner = false;
+    }
+}
+
+bool svr_ipc_create_event(SvrIpcEvent* event)
+{
+    event->handle = 0;
+    svr_atom_store(&event->signaled, 0);
+
+    return true;
+}
+
+// The futex is only memory, so there is nothing to close.
+void svr_ipc_close_event(SvrIpcEvent* event)
+{
+    (void)event;
+}
+
+void svr_ipc_set_event(SvrIpcEvent* event)
+{
+    // A waiter only sleeps while the value is 0, so it only needs to be woken when the value goes from 0 to 1.
+    s32 expected = 0;
+
+    if (svr_atom_cmpxchg(&event->signaled, &expected, 1))
+    {
+        ipc_futex_wake_one(&event->signaled.v);
+    }
+}
+
+SvrIpcWaitResult svr_ipc_wait(SvrIpcEvent* event, SvrIpcProcess* process)
+{
+    while (true)
+    {
+        s32 expected = 1;
+
+        // Reset it when taking it, like an auto reset event.
+        if (svr_atom_cmpxchg(&event->signaled, &expected, 0))
+        {
+            return SVR_IPC_WAIT_EVENT;
+        }
+
+        if (process == NULL)
+        {
+            ipc_futex_wait(&event->signaled.v, 0, NULL);
+            continue;
+        }
+
+        if (!ipc_is_process_alive(process))
+        {
+            return SVR_IPC_WAIT_EXITED;
+        }
+
+        struct timespec ts = { 0, IPC_PROCESS_CHECK_MS * 1000000L };
+        ipc_futex_wait(&event->signaled.v, 0, &ts);
+    }
+}
+
+bool svr_ipc_open_process(u32 pid, SvrIpcProcess* process)
+{
+    process->handle = NULL;
+    process->pid = pid;
+
+    return ipc_is_process_alive(process);
+}
+
+// Nothing is opened for a process, it is only checked by its id.
+void svr_ipc_close_process(SvrIpcProcess* process)
+{
+    (void)process;
+}
+
+u32 svr_ipc_get_current_pid()
+{
+    return (u32)getpid();
+}
+
+#endif
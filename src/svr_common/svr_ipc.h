@@ -0,0 +1,88 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_atom.h"
+
+// Transport between svr_game and svr_encoder.
+// This is memory that is shared between two processes, events in that memory that wake the other process up,
+// and a way to notice that the other process has gone away so nobody waits forever.
+// Windows uses file mappings, events and process handles.
+// Other platforms use POSIX shared memory and futexes, and check if the other process is still there while waiting.
+
+// All Windows handles only use 32 bits of data, so they are stored as u32 here to be the same in 32-bit and 64-bit.
+
+// Event that wakes up one waiting process. It is reset when a wait returns, like an auto reset event on Windows.
+// Must be placed in the shared memory so both processes see the same one.
+struct SvrIpcEvent
+{
+    u32 handle; // Event handle on Windows.
+    SvrAtom32 signaled; // Futex on other platforms.
+};
+
+struct SvrIpcMem
+{
+    void* ptr;
+    s32 size;
+    u32 handle; // Mapping handle on Windows.
+    char name[64]; // Name of the shared memory on other platforms.
+    bool owner; // If this process created the memory.
+};
+
+// The process on the other side.
+// This is not shared, so the handle is the size of a pointer. When svr_encoder runs inside svr_game, this is the thread that it runs on.
+struct SvrIpcProcess
+{
+    void* handle; // Process or thread handle on Windows.
+    u32 pid;
+};
+
+using SvrIpcWaitResult = s32;
+
+enum /* SvrIpcWaitResult */
+{
+    SVR_IPC_WAIT_EVENT, // The event was set.
+    SVR_IPC_WAIT_EXITED, // The other process exited or crashed.
+};
+
+// Creates new zeroed shared memory that can be opened by child processes.
+bool svr_ipc_create_mem(s32 size, SvrIpcMem* mem);
+
+// Writes the text that another process can give to svr_ipc_open_mem to open this memory.
+void svr_ipc_get_mem_id(SvrIpcMem* mem, char* buf, s32 buf_size);
+
+// Opens shared memory from the id of svr_ipc_get_mem_id.
+// Can also be used in the process that created the memory, in which case only the view is freed by svr_ipc_free_mem.
+bool svr_ipc_open_mem(const char* id, SvrIpcMem* mem);
+
+// Gives another process access to memory, and writes the id that the process can give to svr_ipc_open_given_mem.
+// This is for memory that is created after the process was started, since it has not inherited the handle.
+// The process must be a real process that was opened with full access, and not only the access to wait.
+bool svr_ipc_give_mem(SvrIpcMem* mem, SvrIpcProcess* process, char* buf, s32 buf_size);
+
+// Opens memory from the id of svr_ipc_give_mem. The access that was given is closed by svr_ipc_free_mem.
+bool svr_ipc_open_given_mem(const char* id, SvrIpcMem* mem);
+
+// Creates new zeroed shared memory with a name, that any process of the same user can open with svr_ipc_open_named_mem.
+// This is for tools that look at a running process, so the name should be fixed and known by both sides.
+// On Windows this fails if another process has memory with the name. Other platforms take the name over.
+bool svr_ipc_create_named_mem(const char* name, s32 size, SvrIpcMem* mem);
+
+bool svr_ipc_open_named_mem(const char* name, SvrIpcMem* mem);
+
+void svr_ipc_free_mem(SvrIpcMem* mem);
+
+// The event must be in the shared memory and must be created before the other process is started.
+bool svr_ipc_create_event(SvrIpcEvent* event);
+
+// Must be called once in every process that uses the event. The event itself is not changed, since the other process may still use it.
+void svr_ipc_close_event(SvrIpcEvent* event);
+
+void svr_ipc_set_event(SvrIpcEvent* event);
+
+// Waits until the event is set or the other process exits.
+// The process can be NULL when the other side is in the same process, and then this only returns when the event is set.
+SvrIpcWaitResult svr_ipc_wait(SvrIpcEvent* event, SvrIpcProcess* process);
+
+bool svr_ipc_open_process(u32 pid, SvrIpcProcess* process);
+void svr_ipc_close_process(SvrIpcProcess* process);
+
+u32 svr_ipc_get_current_pid();
@@ -1,7 +1,7 @@
 #pragma once
 #include "svr_common.h"
 #include "svr_queue.h"
-#include <Windows.h>
+#include "svr_thread.h"
 
 // Lock based queue.
 // Safe for several threads to push and pull.
@@ -14,7 +14,7 @@ template <class T>
 struct SvrLockedQueue
 {
     SvrDynQueue<T> items;
-    SRWLOCK lock;
+    SvrLock lock;
 
     inline void init(s32 init_capacity)
     {
@@ -29,9 +29,9 @@ struct SvrLockedQueue
     // Pushes to the back.
     inline void push(T* item)
     {
-        AcquireSRWLockExclusive(&lock);
+        svr_lock_acquire(&lock);
         items.push(item);
-        ReleaseSRWLockExclusive(&lock);
+        svr_lock_release(&lock);
     }
 
     // Pops from the front.
@@ -39,7 +39,7 @@ struct SvrLockedQueue
     {
         bool ret = false;
 
-        AcquireSRWLockExclusive(&lock);
+        svr_lock_acquire(&lock);
 
         if (items.size() == 0)
         {
@@ -52,7 +52,7 @@ struct SvrLockedQueue
         ret = true;
 
     rexit:
-        ReleaseSRWLockExclusive(&lock);
+        svr_lock_release(&lock);
         return ret;
     }
 };
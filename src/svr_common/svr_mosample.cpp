@@ -0,0 +1,668 @@
+#include "svr_mosample.h"
+#include "svr_alloc.h"
+#include "svr_work_pool.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <immintrin.h>
+
+// Rows that a thread works on at a time.
+const s32 MOSAMPLE_ROWS_PER_JOB = 16;
+
+// The output table is indexed by the exponent and the top mantissa bits of the float.
+// Values below 2^-20 come out as 0 and values from 1 come out as 255, so only the 20 exponents between need entries.
+const s32 MOSAMPLE_OUT_MANTISSA_BITS = 10;
+const s32 MOSAMPLE_OUT_MIN_EXPONENT = 127 - 20;
+const s32 MOSAMPLE_OUT_SHIFT = 23 - MOSAMPLE_OUT_MANTISSA_BITS;
+const s32 MOSAMPLE_OUT_BASE = MOSAMPLE_OUT_MIN_EXPONENT << MOSAMPLE_OUT_MANTISSA_BITS;
+const s32 MOSAMPLE_OUT_ENTRIES = 20 << MOSAMPLE_OUT_MANTISSA_BITS;
+
+struct MosampleTables
+{
+    float to_linear[256];
+
+    // The last entry is for everything from 1 and up.
+    // There is extra space at the end since the gathers read 4 bytes at a time.
+    u8 from_linear[MOSAMPLE_OUT_ENTRIES + 4];
+};
+
+static MosampleTables mosample_tables;
+static bool mosample_tables_made;
+
+static void mosample_make_tables()
+{
+    if (mosample_tables_made)
+    {
+        return;
+    }
+
+    for (s32 i = 0; i < 256; i++)
+    {
+        mosample_tables.to_linear[i] = powf(i / 255.0f, 2.2f);
+    }
+
+    // Every entry is the value in the middle of the range that it covers.
+    for (s32 i = 0; i < MOSAMPLE_OUT_ENTRIES; i++)
+    {
+        u32 bits = (u32)(MOSAMPLE_OUT_BASE + i) << MOSAMPLE_OUT_SHIFT;
+        bits |= 1 << (MOSAMPLE_OUT_SHIFT - 1);
+
+        float v;
+        memcpy(&v, &bits, sizeof(float));
+
+        mosample_tables.from_linear[i] = (u8)(powf(v, 1.0f / 2.2f) * 255.0f + 0.5f);
+    }
+
+    mosample_tables.from_linear[MOSAMPLE_OUT_ENTRIES] = 255;
+
+    mosample_tables_made = true;
+}
+
+void svr_mosample_timer_init(SvrMosampleTimer* timer, s32 mult, float exposure, bool skip_closed)
+{
+    *timer = {};
+
+    timer->mult = mult;
+    timer->open_len = exposure * mult;
+    timer->open_pos = mult - timer->open_len;
+
+    // A sub-frame that ends right where the shutter opens is still closed.
+    timer->first_open = (s32)floorf(timer->open_pos) + 1;
+    svr_clamp(&timer->first_open, 1, mult);
+
+    timer->skip_closed = skip_closed;
+
+    timer->max_stride = mult - timer->first_open + 1;
+
+    for (s32 i = 0; i < SVR_MOSAMPLE_STRIDE_QUEUE; i++)
+    {
+        timer->strides[i] = 1;
+    }
+}
+
+void svr_mosample_timer_set_adaptive(SvrMosampleTimer* timer, float motion_limit)
+{
+    timer->adaptive = true;
+    timer->motion_limit = motion_limit;
+}
+
+void svr_mosample_timer_give_difference(SvrMosampleTimer* timer, float difference, s32 num_steps)
+{
+    // Motion is expected to be even over the sub-frames.
+    timer->motion = difference / num_steps;
+}
+
+// Stride for a video frame where the latest motion is the same over the whole frame.
+static s32 mosample_timer_get_stride(SvrMosampleTimer* timer)
+{
+    if (timer->motion * timer->max_stride <= timer->motion_limit)
+    {
+        return timer->max_stride;
+    }
+
+    s32 stride = (s32)(timer->motion_limit / timer->motion);
+    svr_clamp(&stride, 1, timer->max_stride);
+
+    return stride;
+}
+
+// Sub-frames that the game frame at this position covers.
+// Blended game frames are placed every stride sub-frames counting back from the end, so the last sub-frame is always one.
+// This means the steps never go past the end of a video frame.
+static s32 mosample_timer_get_steps_at(SvrMosampleTimer* timer, s32 pos, s32 stride)
+{
+    s32 start_pos = pos;
+
+    if (pos < timer->first_open - 1)
+    {
+        if (!timer->skip_closed)
+        {
+            return 1;
+        }
+
+        // The first blended game frame covers all of the closed sub-frames.
+        start_pos = timer->first_open - 1;
+    }
+
+    s32 num_strides = (timer->mult - start_pos - 1) / stride;
+    return timer->mult - num_strides * stride - pos;
+}
+
+// Part of the exposure that is between the two positions.
+static float mosample_timer_get_weight(SvrMosampleTimer* timer, s32 start_pos, s32 end_pos)
+{
+    // Without exposure only the last sub-frame is used, as it would be with a tiny exposure.
+    if (timer->open_len <= 0.0f)
+    {
+        return (end_pos == timer->mult) ? 1.0f : 0.0f;
+    }
+
+    float len = end_pos - svr_max((float)start_pos, timer->open_pos);
+    return svr_max(len, 0.0f) / timer->open_len;
+}
+
+s32 svr_mosample_timer_get_steps(SvrMosampleTimer* timer, s32 frames_ahead)
+{
+    s32 pos = timer->pos;
+    s32 frame_idx = 0;
+
+    for (s32 i = 0; i < frames_ahead; i++)
+    {
+        pos += mosample_timer_get_steps_at(timer, pos, timer->strides[frame_idx]);
+
+        if (pos == timer->mult)
+        {
+            pos = 0;
+            frame_idx = svr_min(frame_idx + 1, SVR_MOSAMPLE_STRIDE_QUEUE - 1);
+        }
+    }
+
+    return mosample_timer_get_steps_at(timer, pos, timer->strides[frame_idx]);
+}
+
+void svr_mosample_timer_step(SvrMosampleTimer* timer, SvrMosampleStep* step)
+{
+    s32 start_pos = timer->pos;
+
+    step->num_steps = mosample_timer_get_steps_at(timer, start_pos, timer->strides[0]);
+    timer->pos += step->num_steps;
+
+    step->weight = mosample_timer_get_weight(timer, start_pos, timer->pos);
+    step->finish_frame = timer->pos == timer->mult;
+
+    if (step->finish_frame)
+    {
+        timer->pos = 0;
+
+        memmove(timer->strides, timer->strides + 1, sizeof(s32) * (SVR_MOSAMPLE_STRIDE_QUEUE - 1));
+
+        if (timer->adaptive)
+        {
+            timer->strides[SVR_MOSAMPLE_STRIDE_QUEUE - 1] = mosample_timer_get_stride(timer);
+        }
+    }
+}
+
+static s64 mosample_get_gcd(s64 a, s64 b)
+{
+    while (b != 0)
+    {
+        s64 t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+bool svr_mosample_schedule_init(SvrMosampleSchedule* sched, SvrMosampleShutter* shutters, s32 num_shutters, bool skip_closed)
+{
+    *sched = {};
+
+    s64 mult = 1;
+
+    for (s32 i = 0; i < num_shutters; i++)
+    {
+        mult = (mult / mosample_get_gcd(mult, shutters[i].mult)) * shutters[i].mult;
+
+        if (mult > INT32_MAX)
+        {
+            return false;
+        }
+    }
+
+    sched->num_shutters = num_shutters;
+    sched->mult = (s32)mult;
+    sched->num_fixed = SVR_MOSAMPLE_START_FRAMES;
+
+    for (s32 i = 0; i < num_shutters; i++)
+    {
+        svr_mosample_timer_init(&sched->timers[i], shutters[i].mult, shutters[i].exposure, skip_closed);
+        sched->scales[i] = sched->mult / shutters[i].mult;
+    }
+
+    return true;
+}
+
+// Position in game sub-frames where a timer takes a game frame, after this many frames of its own after the next one.
+// Positions go past the end of the video frame when looking ahead, since all timers finish their video frames together.
+static s64 mosample_schedule_get_timer_end(SvrMosampleSchedule* sched, s32 idx, s32 frames_ahead)
+{
+    SvrMosampleTimer* timer = &sched->timers[idx];
+    s64 pos = timer->pos;
+
+    for (s32 i = 0; i <= frames_ahead; i++)
+    {
+        pos += svr_mosample_timer_get_steps(timer, i);
+    }
+
+    return pos * sched->scales[idx];
+}
+
+s32 svr_mosample_schedule_get_steps(SvrMosampleSchedule* sched, s32 frames_ahead)
+{
+    s64 ends[SVR_MOSAMPLE_MAX_SHUTTERS];
+    s32 timer_frames[SVR_MOSAMPLE_MAX_SHUTTERS] = {};
+
+    for (s32 i = 0; i < sched->num_shutters; i++)
+    {
+        ends[i] = mosample_schedule_get_timer_end(sched, i, 0);
+    }
+
+    s64 pos = sched->pos;
+
+    for (s32 i = 0; ; i++)
+    {
+        s64 next = INT64_MAX;
+
+        for (s32 j = 0; j < sched->num_shutters; j++)
+        {
+            next = svr_min(next, ends[j]);
+        }
+
+        // The fixed game frames end between the ends of the timers when those are longer.
+        // Timers are only stepped by the game frame that ends at their end, so they blend the same frames as without these.
+        if (i < sched->num_fixed)
+        {
+            next = pos + 1;
+        }
+
+        if (i == frames_ahead)
+        {
+            return (s32)(next - pos);
+        }
+
+        pos = next;
+
+        for (s32 j = 0; j < sched->num_shutters; j++)
+        {
+            if (ends[j] == next)
+            {
+                timer_frames[j]++;
+                ends[j] = mosample_schedule_get_timer_end(sched, j, timer_frames[j]);
+            }
+        }
+    }
+}
+
+void svr_mosample_schedule_step(SvrMosampleSchedule* sched, SvrMosampleScheduleStep* step)
+{
+    step->num_steps = svr_mosample_schedule_get_steps(sched, 0);
+    sched->pos += step->num_steps;
+
+    if (sched->num_fixed > 0)
+    {
+        sched->num_fixed--;
+    }
+
+    for (s32 i = 0; i < sched->num_shutters; i++)
+    {
+        step->steps[i] = {};
+
+        if (mosample_schedule_get_timer_end(sched, i, 0) == sched->pos)
+        {
+            svr_mosample_timer_step(&sched->timers[i], &step->steps[i]);
+        }
+    }
+
+    // Every timer finishes its video frame on the same game frame.
+    if (sched->pos == sched->mult)
+    {
+        sched->pos = 0;
+    }
+}
+
+void svr_mosample_create_buffer(SvrMosampleBuffer* buf, s32 width, s32 height)
+{
+    mosample_make_tables();
+
+    buf->width = width;
+    buf->height = height;
+    buf->pixels = (float*)svr_align_alloc(width * height * 4 * sizeof(float), 32);
+
+    svr_mosample_clear(buf);
+}
+
+void svr_mosample_free_buffer(SvrMosampleBuffer* buf)
+{
+    if (buf->pixels)
+    {
+        svr_align_free(buf->pixels, 32);
+        buf->pixels = NULL;
+    }
+}
+
+void svr_mosample_clear(SvrMosampleBuffer* buf)
+{
+    s64 num_pixels = (s64)buf->width * buf->height;
+
+    for (s64 i = 0; i < num_pixels; i++)
+    {
+        float* px = buf->pixels + i * 4;
+
+        px[0] = 0.0f;
+        px[1] = 0.0f;
+        px[2] = 0.0f;
+        px[3] = 1.0f;
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Scalar level.
+// The row functions start at pixel x and continue to the end of the row.
+// There is no fused multiply add in any level, so all levels round the same way.
+
+static void mosample_add_row_scalar(const u8* src, float* dest, float weight, s32 x, s32 width)
+{
+    for (; x < width; x++)
+    {
+        for (s32 i = 0; i < 4; i++)
+        {
+            dest[x * 4 + i] += mosample_tables.to_linear[src[x * 4 + i]] * weight;
+        }
+    }
+}
+
+static inline u8 mosample_from_linear(float v)
+{
+    s32 bits;
+    memcpy(&bits, &v, sizeof(float));
+
+    // Negative values have the sign bit set, so they are below the table and come out as 0 like in the shader.
+    s32 idx = (bits >> MOSAMPLE_OUT_SHIFT) - MOSAMPLE_OUT_BASE;
+    svr_clamp(&idx, 0, MOSAMPLE_OUT_ENTRIES);
+
+    return mosample_tables.from_linear[idx];
+}
+
+static void mosample_downsample_row_scalar(const float* src, u8* dest, s32 x, s32 width)
+{
+    for (; x < width; x++)
+    {
+        for (s32 i = 0; i < 4; i++)
+        {
+            dest[x * 4 + i] = mosample_from_linear(src[x * 4 + i]);
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// AVX2 level.
+// The row functions return the pixel where the scalar level has to continue.
+
+SVR_TARGET_AVX2 static s32 mosample_add_row_avx2(const u8* src, float* dest, float weight, s32 width)
+{
+    __m256 w = _mm256_set1_ps(weight);
+
+    s32 x = 0;
+
+    // 4 pixels at a time, with 2 pixels per vector.
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i px = _mm_loadu_si128((const __m128i*)(src + x * 4));
+        float* d = dest + x * 4;
+
+        __m256i i0 = _mm256_cvtepu8_epi32(px);
+        __m256i i1 = _mm256_cvtepu8_epi32(_mm_srli_si128(px, 8));
+
+        __m256 l0 = _mm256_i32gather_ps(mosample_tables.to_linear, i0, 4);
+        __m256 l1 = _mm256_i32gather_ps(mosample_tables.to_linear, i1, 4);
+
+        _mm256_storeu_ps(d, _mm256_add_ps(_mm256_loadu_ps(d), _mm256_mul_ps(l0, w)));
+        _mm256_storeu_ps(d + 8, _mm256_add_ps(_mm256_loadu_ps(d + 8), _mm256_mul_ps(l1, w)));
+    }
+
+    return x;
+}
+
+// Table entries for 8 values, in the low byte of every 32 bits.
+SVR_TARGET_AVX2 static inline __m256i mosample_avx2_from_linear_8(const float* src)
+{
+    __m256i bits = _mm256_castps_si256(_mm256_loadu_ps(src));
+    __m256i idx = _mm256_sub_epi32(_mm256_srai_epi32(bits, MOSAMPLE_OUT_SHIFT), _mm256_set1_epi32(MOSAMPLE_OUT_BASE));
+
+    idx = _mm256_max_epi32(idx, _mm256_setzero_si256());
+    idx = _mm256_min_epi32(idx, _mm256_set1_epi32(MOSAMPLE_OUT_ENTRIES));
+
+    __m256i v = _mm256_i32gather_epi32((const int*)mosample_tables.from_linear, idx, 1);
+    return _mm256_and_si256(v, _mm256_set1_epi32(0xff));
+}
+
+SVR_TARGET_AVX2 static s32 mosample_downsample_row_avx2(const float* src, u8* dest, s32 width)
+{
+    // Pixels come out as 0 2 4 6 1 3 5 7 from the packs.
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    s32 x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        const float* s = src + x * 4;
+
+        __m256i v0 = mosample_avx2_from_linear_8(s);
+        __m256i v1 = mosample_avx2_from_linear_8(s + 8);
+        __m256i v2 = mosample_avx2_from_linear_8(s + 16);
+        __m256i v3 = mosample_avx2_from_linear_8(s + 24);
+
+        __m256i v = _mm256_packus_epi16(_mm256_packus_epi32(v0, v1), _mm256_packus_epi32(v2, v3));
+        _mm256_storeu_si256((__m256i*)(dest + x * 4), _mm256_permutevar8x32_epi32(v, order));
+    }
+
+    return x;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Level selection.
+// The SSE 4.1 level uses the scalar level, since there are no gathers there and the tables are most of the work.
+
+static void mosample_add_rows(SvrMosampleBuffer* buf, const u8* src, s32 src_pitch, float weight, SvrSimdLevel level, s32 start_row, s32 end_row)
+{
+    end_row = svr_min(end_row, buf->height);
+
+    for (s32 i = start_row; i < end_row; i++)
+    {
+        const u8* src_row = src + (s64)i * src_pitch;
+        float* dest_row = buf->pixels + (s64)i * buf->width * 4;
+
+        s32 x = 0;
+
+        if (level >= SVR_SIMD_AVX2)
+        {
+            x = mosample_add_row_avx2(src_row, dest_row, weight, buf->width);
+        }
+
+        mosample_add_row_scalar(src_row, dest_row, weight, x, buf->width);
+    }
+}
+
+static void mosample_downsample_rows(SvrMosampleBuffer* buf, u8* dest, s32 dest_pitch, SvrSimdLevel level, s32 start_row, s32 end_row)
+{
+    end_row = svr_min(end_row, buf->height);
+
+    for (s32 i = start_row; i < end_row; i++)
+    {
+        const float* src_row = buf->pixels + (s64)i * buf->width * 4;
+        u8* dest_row = dest + (s64)i * dest_pitch;
+
+        s32 x = 0;
+
+        if (level >= SVR_SIMD_AVX2)
+        {
+            x = mosample_downsample_row_avx2(src_row, dest_row, buf->width);
+        }
+
+        mosample_downsample_row_scalar(src_row, dest_row, x, buf->width);
+    }
+}
+
+struct MosampleWorkData
+{
+    SvrMosampleBuffer* buf;
+    const u8* src;
+    u8* dest;
+    s32 pitch;
+    float weight;
+    SvrSimdLevel level;
+};
+
+static void mosample_add_work_proc(void* data, s32 start, s32 end)
+{
+    MosampleWorkData* work = (MosampleWorkData*)data;
+    mosample_add_rows(work->buf, work->src, work->pitch, work->weight, work->level, start, end);
+}
+
+static void mosample_downsample_work_proc(void* data, s32 start, s32 end)
+{
+    MosampleWorkData* work = (MosampleWorkData*)data;
+    mosample_downsample_rows(work->buf, work->dest, work->pitch, work->level, start, end);
+}
+
+void svr_mosample_add(SvrMosampleBuffer* buf, const u8* src, s32 src_pitch, float weight, SvrSimdLevel level, SvrWorkPool* pool)
+{
+    if (pool == NULL)
+    {
+        mosample_add_rows(buf, src, src_pitch, weight, level, 0, buf->height);
+        return;
+    }
+
+    MosampleWorkData work = {};
+    work.buf = buf;
+    work.src = src;
+    work.pitch = src_pitch;
+    work.weight = weight;
+    work.level = level;
+
+    svr_work_pool_run(pool, mosample_add_work_proc, &work, buf->height, MOSAMPLE_ROWS_PER_JOB);
+}
+
+void svr_mosample_downsample(SvrMosampleBuffer* buf, u8* dest, s32 dest_pitch, SvrSimdLevel level, SvrWorkPool* pool)
+{
+    if (pool == NULL)
+    {
+        mosample_downsample_rows(buf, dest, dest_pitch, level, 0, buf->height);
+        return;
+    }
+
+    MosampleWorkData work = {};
+    work.buf = buf;
+    work.dest = dest;
+    work.pitch = dest_pitch;
+    work.level = level;
+
+    svr_work_pool_run(pool, mosample_downsample_work_proc, &work, buf->height, MOSAMPLE_ROWS_PER_JOB);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Frame difference.
+// The sums of the color channels in every block are compared, which is the same as comparing the averages.
+
+static s32 mosample_diff_block_scalar(const u8* a, s32 a_pitch, const u8* b, s32 b_pitch)
+{
+    s32 sums[3] = {};
+
+    for (s32 y = 0; y < SVR_MOSAMPLE_DIFF_BLOCK; y++)
+    {
+        const u8* pa = a + (s64)y * a_pitch;
+        const u8* pb = b + (s64)y * b_pitch;
+
+        for (s32 x = 0; x < SVR_MOSAMPLE_DIFF_BLOCK; x++)
+        {
+            for (s32 i = 0; i < 3; i++)
+            {
+                sums[i] += pa[x * 4 + i] - pb[x * 4 + i];
+            }
+        }
+    }
+
+    return abs(sums[0]) + abs(sums[1]) + abs(sums[2]);
+}
+
+static s64 mosample_diff_row_scalar(const u8* a, s32 a_pitch, const u8* b, s32 b_pitch, s32 x, s32 num_blocks)
+{
+    s64 total = 0;
+
+    for (; x < num_blocks; x++)
+    {
+        s32 offset = x * SVR_MOSAMPLE_DIFF_BLOCK * 4;
+        total += mosample_diff_block_scalar(a + offset, a_pitch, b + offset, b_pitch);
+    }
+
+    return total;
+}
+
+// Column sums of 4 rows of 4 pixels, as 16-bit.
+SVR_TARGET_AVX2 static inline __m256i mosample_avx2_column_sums(const u8* src, s32 pitch)
+{
+    __m256i sum = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)src));
+
+    for (s32 y = 1; y < SVR_MOSAMPLE_DIFF_BLOCK; y++)
+    {
+        __m256i row = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + (s64)y * pitch)));
+        sum = _mm256_add_epi16(sum, row);
+    }
+
+    return sum;
+}
+
+SVR_TARGET_AVX2 static s32 mosample_diff_row_avx2(const u8* a, s32 a_pitch, const u8* b, s32 b_pitch, s32 num_blocks, s64* total)
+{
+    // Only the color channels of the first pixel are counted, where the sum of the whole block ends up.
+    __m256i mask = _mm256_setr_epi16(1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    __m256i acc = _mm256_setzero_si256();
+
+    s32 x = 0;
+
+    // The block sums fit in 16 bits with the sign, and a row is far from having enough blocks to overflow the 32-bit sums.
+    for (; x < num_blocks; x++)
+    {
+        s32 offset = x * SVR_MOSAMPLE_DIFF_BLOCK * 4;
+
+        __m256i d = _mm256_sub_epi16(mosample_avx2_column_sums(a + offset, a_pitch), mosample_avx2_column_sums(b + offset, b_pitch));
+
+        // Add the 4 pixels together. Pixels 0 and 1 are in the low half and 2 and 3 in the high half.
+        d = _mm256_add_epi16(d, _mm256_permute2x128_si256(d, d, 1));
+        d = _mm256_add_epi16(d, _mm256_srli_si256(d, 8));
+
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_abs_epi16(d), mask));
+    }
+
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+
+    *total += _mm_cvtsi128_si32(sum);
+
+    return x;
+}
+
+float svr_mosample_get_difference(const u8* a, s32 a_pitch, const u8* b, s32 b_pitch, s32 width, s32 height, SvrSimdLevel level)
+{
+    s32 num_blocks_x = width / SVR_MOSAMPLE_DIFF_BLOCK;
+    s32 num_blocks_y = height / SVR_MOSAMPLE_DIFF_BLOCK;
+
+    if (num_blocks_x == 0 || num_blocks_y == 0)
+    {
+        return 0.0f;
+    }
+
+    s64 total = 0;
+
+    for (s32 i = 0; i < num_blocks_y; i++)
+    {
+        const u8* row_a = a + (s64)i * SVR_MOSAMPLE_DIFF_BLOCK * a_pitch;
+        const u8* row_b = b + (s64)i * SVR_MOSAMPLE_DIFF_BLOCK * b_pitch;
+
+        s32 x = 0;
+
+        if (level >= SVR_SIMD_AVX2)
+        {
+            x = mosample_diff_row_avx2(row_a, a_pitch, row_b, b_pitch, num_blocks_x, &total);
+        }
+
+        total += mosample_diff_row_scalar(row_a, a_pitch, row_b, b_pitch, x, num_blocks_x);
+    }
+
+    // The sums are for 16 pixels.
+    s64 num_values = (s64)num_blocks_x * num_blocks_y * 3 * SVR_MOSAMPLE_DIFF_BLOCK * SVR_MOSAMPLE_DIFF_BLOCK;
+    return (float)((double)total / (double)num_values);
+}
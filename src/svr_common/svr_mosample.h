@@ -0,0 +1,140 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_simd.h"
+
+struct SvrWorkPool;
+
+// Motion sampling (motion blur) on the processor.
+// This is the same as motion_sample.hlsl and downsample.hlsl: sub-frames are converted to linear space, added together by
+// their weight in a 128 bpp buffer, and converted back to 32 bpp when a video frame is finished.
+// The conversions use tables instead of pow. Sources have 8 bits per channel so the linear table is exact, and the output
+// table is within 1 of the rounded pow result.
+// All levels give the same result as the scalar level.
+
+// Decides the weight of every sub-frame and when video frames are finished.
+// This is shared with the shaders in svr_game so both give the same frames.
+// Positions are counted in whole sub-frames, so video frames always end after exactly mult sub-frames and nothing drifts.
+// The shutter is open for the exposure at the end of every video frame. Sub-frames before that are not blended,
+// so the game can skip them and cover all of them in one longer game frame instead.
+//
+// In the adaptive mode, the open sub-frames are also covered by fewer game frames when there is little motion.
+// Every game frame is then blended with the weight of all sub-frames it covers, so the exposure stays the same.
+// The motion decides the stride of the video frame that is SVR_MOSAMPLE_STRIDE_QUEUE - 1 frames ahead,
+// so the steps that a game has been told about never change.
+
+// Video frames that the stride is known for. Games must not look further ahead than this.
+const s32 SVR_MOSAMPLE_STRIDE_QUEUE = 4;
+
+struct SvrMosampleTimer
+{
+    s32 mult; // Sub-frames in a video frame.
+    s32 pos; // Sub-frames that have passed in the current video frame.
+    float open_pos; // Position in sub-frames where the shutter opens.
+    float open_len; // Sub-frames that the shutter is open for.
+    s32 first_open; // First sub-frame, counting from 1, that the shutter is at least partly open for.
+    bool skip_closed; // If the sub-frames where the shutter is closed are covered by one game frame.
+
+    bool adaptive; // If the stride changes by the motion.
+    float motion_limit; // Largest difference between two blended game frames before the stride gets smaller.
+    float motion; // Latest difference for one sub-frame.
+    s32 max_stride; // Stride where only the last sub-frame is blended.
+    s32 strides[SVR_MOSAMPLE_STRIDE_QUEUE]; // Sub-frames between blended game frames, for the current video frame and the ones after.
+};
+
+// What to do with one game frame.
+struct SvrMosampleStep
+{
+    s32 num_steps; // Sub-frames that the game frame covers.
+    float weight; // Weight to add this game frame with. 0 if it is not blended.
+    bool finish_frame; // If the video frame is finished after the weight is added.
+};
+
+void svr_mosample_timer_init(SvrMosampleTimer* timer, s32 mult, float exposure, bool skip_closed);
+
+// Turns on the adaptive mode. The limit is in the units of svr_mosample_get_difference.
+void svr_mosample_timer_set_adaptive(SvrMosampleTimer* timer, float motion_limit);
+
+// Gives the latest difference between two game frames, and how many sub-frames there were between them.
+void svr_mosample_timer_give_difference(SvrMosampleTimer* timer, float difference, s32 num_steps);
+
+// Returns how many sub-frames the game frame this many frames after the next one should cover.
+// This is always 1 when the closed sub-frames are not skipped and the adaptive mode is off.
+s32 svr_mosample_timer_get_steps(SvrMosampleTimer* timer, s32 frames_ahead);
+
+// Moves the timer forward by the next game frame.
+void svr_mosample_timer_step(SvrMosampleTimer* timer, SvrMosampleStep* step);
+
+// Several shutters that are made from the same game frames, for making more than one movie in one go.
+// Each shutter has its own timer. The game runs at a rate where every shutter has its sub-frames, and every game frame
+// is only given to the shutters that have a sub-frame that ends there. So every shutter gets the same game frames
+// with the same weights as if it was used alone.
+// The adaptive mode is not used here, since the differences are between game frames of all shutters.
+
+const s32 SVR_MOSAMPLE_MAX_SHUTTERS = 4;
+
+// Game frames at the start that cover one game sub-frame each. The game is already running these at the rate of
+// svr_get_game_rate before a new host_framerate can show up, so they cannot be made longer.
+// Games must not take longer than this to use a new host_framerate.
+const s32 SVR_MOSAMPLE_START_FRAMES = 4;
+
+struct SvrMosampleShutter
+{
+    s32 mult;
+    float exposure;
+};
+
+struct SvrMosampleSchedule
+{
+    s32 num_shutters;
+    s32 mult; // Game frames in a video frame when none are skipped. A multiple of the mult of every shutter.
+    s32 pos; // Game sub-frames that have passed in the current video frame.
+    s32 num_fixed; // Game frames from the next one that must cover one game sub-frame.
+    SvrMosampleTimer timers[SVR_MOSAMPLE_MAX_SHUTTERS];
+    s32 scales[SVR_MOSAMPLE_MAX_SHUTTERS]; // Game sub-frames in one sub-frame of each shutter.
+};
+
+// What to do with one game frame. Shutters that do not see this game frame have no steps in their step.
+struct SvrMosampleScheduleStep
+{
+    s32 num_steps; // Game sub-frames that the game frame covers.
+    SvrMosampleStep steps[SVR_MOSAMPLE_MAX_SHUTTERS];
+};
+
+// Returns false if the game would need more than INT32_MAX sub-frames in a video frame to cover all the shutters.
+bool svr_mosample_schedule_init(SvrMosampleSchedule* sched, SvrMosampleShutter* shutters, s32 num_shutters, bool skip_closed);
+
+// Same as svr_mosample_timer_get_steps, in game sub-frames.
+s32 svr_mosample_schedule_get_steps(SvrMosampleSchedule* sched, s32 frames_ahead);
+
+// Moves every timer that has a sub-frame ending at the next game frame.
+void svr_mosample_schedule_step(SvrMosampleSchedule* sched, SvrMosampleScheduleStep* step);
+
+// Buffer that sub-frames are added to, in the same channel order as the source pixels.
+struct SvrMosampleBuffer
+{
+    s32 width;
+    s32 height;
+    float* pixels; // 4 floats for every pixel, rows one after another without padding.
+};
+
+void svr_mosample_create_buffer(SvrMosampleBuffer* buf, s32 width, s32 height);
+void svr_mosample_free_buffer(SvrMosampleBuffer* buf);
+
+// Puts the buffer back to the state for a new video frame.
+// The fourth channel starts at 1 like the clear in svr_game, so it always comes out as 255.
+void svr_mosample_clear(SvrMosampleBuffer* buf);
+
+// Adds a sub-frame of 32 bpp pixels with this weight. The pool can be NULL to only use the calling thread.
+void svr_mosample_add(SvrMosampleBuffer* buf, const u8* src, s32 src_pitch, float weight, SvrSimdLevel level, SvrWorkPool* pool);
+
+// Converts the buffer back to 32 bpp pixels. The pool can be NULL to only use the calling thread.
+void svr_mosample_downsample(SvrMosampleBuffer* buf, u8* dest, s32 dest_pitch, SvrSimdLevel level, SvrWorkPool* pool);
+
+// Frame difference for the adaptive mode.
+// This is the mean absolute difference of the color channels between two 32 bpp frames, from 0 to 255.
+// The frames are compared in blocks of 4x4 pixels, so noise and small details matter less than things that move.
+// Pixels in blocks that are not complete at the right and bottom edges are not used.
+// All levels give the same result.
+const s32 SVR_MOSAMPLE_DIFF_BLOCK = 4;
+
+float svr_mosample_get_difference(const u8* a, s32 a_pitch, const u8* b, s32 b_pitch, s32 width, s32 height, SvrSimdLevel level);
@@ -0,0 +1,528 @@
+#include "svr_motion.h"
+#include "svr_alloc.h"
+#include "svr_work_pool.h"
+#include "svr_mosample.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <immintrin.h>
+
+// The quarter size search covers the whole range and the full size search only looks around that.
+const s32 MOTION_SMALL_SCALE = 4;
+const s32 MOTION_SMALL_BLOCK = SVR_MOTION_BLOCK / MOTION_SMALL_SCALE;
+const s32 MOTION_SMALL_RANGE = SVR_MOTION_RANGE / MOTION_SMALL_SCALE;
+const s32 MOTION_REFINE_RANGE = MOTION_SMALL_SCALE / 2;
+
+// Rows of blocks that a thread works on at a time.
+const s32 MOTION_BLOCK_ROWS_PER_JOB = 1;
+
+// Rows of pixels that a thread converts at a time.
+const s32 MOTION_ROWS_PER_JOB = 32;
+
+void svr_motion_create_field(SvrMotionField* field, s32 width, s32 height)
+{
+    *field = {};
+
+    field->width = width;
+    field->height = height;
+    field->blocks_x = (width + SVR_MOTION_BLOCK - 1) / SVR_MOTION_BLOCK;
+    field->blocks_y = (height + SVR_MOTION_BLOCK - 1) / SVR_MOTION_BLOCK;
+    field->small_width = width / MOTION_SMALL_SCALE;
+    field->small_height = height / MOTION_SMALL_SCALE;
+
+    field->vectors = SVR_ZALLOC_NUM(SvrMotionVector, field->blocks_x * field->blocks_y);
+
+    for (s32 i = 0; i < 2; i++)
+    {
+        field->gray[i] = (u8*)svr_alloc(width * height);
+        field->small[i] = (u8*)svr_alloc(svr_max(field->small_width * field->small_height, 1));
+    }
+}
+
+void svr_motion_free_field(SvrMotionField* field)
+{
+    if (field->vectors)
+    {
+        svr_free(field->vectors);
+        field->vectors = NULL;
+    }
+
+    for (s32 i = 0; i < 2; i++)
+    {
+        if (field->gray[i])
+        {
+            svr_free(field->gray[i]);
+            field->gray[i] = NULL;
+        }
+
+        if (field->small[i])
+        {
+            svr_free(field->small[i]);
+            field->small[i] = NULL;
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Gray frames.
+
+static void motion_make_gray_rows(SvrMotionField* field, const u8* src, s32 src_pitch, u8* gray, s32 start_row, s32 end_row)
+{
+    end_row = svr_min(end_row, field->height);
+
+    for (s32 i = start_row; i < end_row; i++)
+    {
+        const u8* src_row = src + (s64)i * src_pitch;
+        u8* dest_row = gray + (s64)i * field->width;
+
+        for (s32 x = 0; x < field->width; x++)
+        {
+            const u8* px = src_row + x * 4;
+            dest_row[x] = (u8)((px[0] + 2 * px[1] + px[2] + 2) >> 2);
+        }
+    }
+}
+
+static void motion_make_small_rows(SvrMotionField* field, const u8* gray, u8* small, s32 start_row, s32 end_row)
+{
+    end_row = svr_min(end_row, field->small_height);
+
+    for (s32 i = start_row; i < end_row; i++)
+    {
+        const u8* src = gray + (s64)i * MOTION_SMALL_SCALE * field->width;
+        u8* dest_row = small + (s64)i * field->small_width;
+
+        for (s32 x = 0; x < field->small_width; x++)
+        {
+            s32 sum = 0;
+
+            for (s32 y = 0; y < MOTION_SMALL_SCALE; y++)
+            {
+                const u8* p = src + (s64)y * field->width + x * MOTION_SMALL_SCALE;
+
+                for (s32 j = 0; j < MOTION_SMALL_SCALE; j++)
+                {
+                    sum += p[j];
+                }
+            }
+
+            dest_row[x] = (u8)((sum + 8) >> 4);
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Block differences.
+
+static s32 motion_sad_scalar(const u8* a, const u8* b, s32 pitch, s32 width, s32 height)
+{
+    s32 sad = 0;
+
+    for (s32 y = 0; y < height; y++)
+    {
+        const u8* ra = a + (s64)y * pitch;
+        const u8* rb = b + (s64)y * pitch;
+
+        for (s32 x = 0; x < width; x++)
+        {
+            sad += abs(ra[x] - rb[x]);
+        }
+    }
+
+    return sad;
+}
+
+SVR_TARGET_SSE41 static inline __m128i motion_sse41_load_small_block(const u8* p, s32 pitch)
+{
+    s32 rows[MOTION_SMALL_BLOCK];
+
+    for (s32 y = 0; y < MOTION_SMALL_BLOCK; y++)
+    {
+        memcpy(&rows[y], p + (s64)y * pitch, 4);
+    }
+
+    return _mm_loadu_si128((const __m128i*)rows);
+}
+
+SVR_TARGET_SSE41 static s32 motion_small_sad_sse41(const u8* a, const u8* b, s32 pitch)
+{
+    __m128i sad = _mm_sad_epu8(motion_sse41_load_small_block(a, pitch), motion_sse41_load_small_block(b, pitch));
+    return _mm_cvtsi128_si32(sad) + _mm_extract_epi32(sad, 2);
+}
+
+SVR_TARGET_SSE41 static s32 motion_block_sad_sse41(const u8* a, const u8* b, s32 pitch, s32 height)
+{
+    __m128i sum = _mm_setzero_si128();
+
+    for (s32 y = 0; y < height; y++)
+    {
+        __m128i ra = _mm_loadu_si128((const __m128i*)(a + (s64)y * pitch));
+        __m128i rb = _mm_loadu_si128((const __m128i*)(b + (s64)y * pitch));
+        sum = _mm_add_epi32(sum, _mm_sad_epu8(ra, rb));
+    }
+
+    return _mm_cvtsi128_si32(sum) + _mm_extract_epi32(sum, 2);
+}
+
+static s32 motion_small_sad(SvrSimdLevel level, const u8* a, const u8* b, s32 pitch)
+{
+    if (level >= SVR_SIMD_SSE41)
+    {
+        return motion_small_sad_sse41(a, b, pitch);
+    }
+
+    return motion_sad_scalar(a, b, pitch, MOTION_SMALL_BLOCK, MOTION_SMALL_BLOCK);
+}
+
+static s32 motion_block_sad(SvrSimdLevel level, const u8* a, const u8* b, s32 pitch, s32 width, s32 height)
+{
+    if (level >= SVR_SIMD_SSE41 && width == SVR_MOTION_BLOCK)
+    {
+        return motion_block_sad_sse41(a, b, pitch, height);
+    }
+
+    return motion_sad_scalar(a, b, pitch, width, height);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Search.
+// Longer vectors cost a little more, so flat areas where everything matches equally stay still.
+
+static inline s32 motion_vector_cost(s32 vx, s32 vy)
+{
+    return abs(vx) + abs(vy);
+}
+
+static SvrMotionVector motion_search_small(SvrMotionField* field, SvrSimdLevel level, s32 bx, s32 by)
+{
+    SvrMotionVector best = {};
+
+    s32 x0 = bx * MOTION_SMALL_BLOCK;
+    s32 y0 = by * MOTION_SMALL_BLOCK;
+
+    // Blocks at the edges that are not complete in the quarter size frames start from no motion.
+    if (x0 + MOTION_SMALL_BLOCK > field->small_width || y0 + MOTION_SMALL_BLOCK > field->small_height)
+    {
+        return best;
+    }
+
+    s32 pitch = field->small_width;
+    const u8* next = field->small[1] + (s64)y0 * pitch + x0;
+
+    s32 best_cost = INT32_MAX;
+
+    for (s32 vy = -MOTION_SMALL_RANGE; vy <= MOTION_SMALL_RANGE; vy++)
+    {
+        if (y0 + vy < 0 || y0 + vy + MOTION_SMALL_BLOCK > field->small_height)
+        {
+            continue;
+        }
+
+        for (s32 vx = -MOTION_SMALL_RANGE; vx <= MOTION_SMALL_RANGE; vx++)
+        {
+            if (x0 + vx < 0 || x0 + vx + MOTION_SMALL_BLOCK > field->small_width)
+            {
+                continue;
+            }
+
+            const u8* prev = field->small[0] + (s64)(y0 + vy) * pitch + (x0 + vx);
+            s32 cost = motion_small_sad(level, prev, next, pitch) + motion_vector_cost(vx, vy);
+
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best.x = (s16)vx;
+                best.y = (s16)vy;
+            }
+        }
+    }
+
+    return best;
+}
+
+static SvrMotionVector motion_search_full(SvrMotionField* field, SvrSimdLevel level, s32 bx, s32 by, SvrMotionVector start)
+{
+    s32 x0 = bx * SVR_MOTION_BLOCK;
+    s32 y0 = by * SVR_MOTION_BLOCK;
+    s32 bw = svr_min(SVR_MOTION_BLOCK, field->width - x0);
+    s32 bh = svr_min(SVR_MOTION_BLOCK, field->height - y0);
+
+    s32 pitch = field->width;
+    const u8* next = field->gray[1] + (s64)y0 * pitch + x0;
+
+    // No motion is always tried first, since it is always inside the frame.
+    SvrMotionVector best = {};
+    s32 best_cost = motion_block_sad(level, field->gray[0] + (s64)y0 * pitch + x0, next, pitch, bw, bh);
+
+    s32 cx = start.x * MOTION_SMALL_SCALE;
+    s32 cy = start.y * MOTION_SMALL_SCALE;
+
+    for (s32 vy = cy - MOTION_REFINE_RANGE; vy <= cy + MOTION_REFINE_RANGE; vy++)
+    {
+        if (y0 + vy < 0 || y0 + vy + bh > field->height || abs(vy) > SVR_MOTION_RANGE)
+        {
+            continue;
+        }
+
+        for (s32 vx = cx - MOTION_REFINE_RANGE; vx <= cx + MOTION_REFINE_RANGE; vx++)
+        {
+            if (x0 + vx < 0 || x0 + vx + bw > field->width || abs(vx) > SVR_MOTION_RANGE)
+            {
+                continue;
+            }
+
+            const u8* prev = field->gray[0] + (s64)(y0 + vy) * pitch + (x0 + vx);
+            s32 cost = motion_block_sad(level, prev, next, pitch, bw, bh) + motion_vector_cost(vx, vy);
+
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best.x = (s16)vx;
+                best.y = (s16)vy;
+            }
+        }
+    }
+
+    return best;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Interpolation.
+// The blend is in 8-bit fixed point: (prev * (256 - w) + next * w + 128) >> 8, which never goes over 16 bits.
+
+static void motion_blend_block_scalar(const u8* prev, s32 prev_pitch, const u8* next, s32 next_pitch, u8* dest, s32 dest_pitch,
+                                      s32 x0, s32 y0, s32 bw, s32 bh, s32 ox_a, s32 oy_a, s32 ox_b, s32 oy_b, s32 w, s32 width, s32 height)
+{
+    for (s32 y = y0; y < y0 + bh; y++)
+    {
+        s32 ya = y + oy_a;
+        s32 yb = y + oy_b;
+        svr_clamp(&ya, 0, height - 1);
+        svr_clamp(&yb, 0, height - 1);
+
+        const u8* ra = prev + (s64)ya * prev_pitch;
+        const u8* rb = next + (s64)yb * next_pitch;
+        u8* rd = dest + (s64)y * dest_pitch;
+
+        for (s32 x = x0; x < x0 + bw; x++)
+        {
+            s32 xa = x + ox_a;
+            s32 xb = x + ox_b;
+            svr_clamp(&xa, 0, width - 1);
+            svr_clamp(&xb, 0, width - 1);
+
+            for (s32 i = 0; i < 4; i++)
+            {
+                rd[x * 4 + i] = (u8)((ra[xa * 4 + i] * (256 - w) + rb[xb * 4 + i] * w + 128) >> 8);
+            }
+        }
+    }
+}
+
+// For complete blocks where both sources are inside the frame.
+SVR_TARGET_AVX2 static void motion_blend_block_avx2(const u8* a, s32 a_pitch, const u8* b, s32 b_pitch, u8* dest, s32 dest_pitch, s32 w)
+{
+    __m256i wa = _mm256_set1_epi16((s16)(256 - w));
+    __m256i wb = _mm256_set1_epi16((s16)w);
+    __m256i round = _mm256_set1_epi16(128);
+
+    for (s32 y = 0; y < SVR_MOTION_BLOCK; y++)
+    {
+        const u8* ra = a + (s64)y * a_pitch;
+        const u8* rb = b + (s64)y * b_pitch;
+        u8* rd = dest + (s64)y * dest_pitch;
+
+        // 16 pixels are 64 bytes, which is 4 times 16 bytes that are widened to 16 bits.
+        for (s32 i = 0; i < SVR_MOTION_BLOCK * 4; i += 32)
+        {
+            __m256i va = _mm256_loadu_si256((const __m256i*)(ra + i));
+            __m256i vb = _mm256_loadu_si256((const __m256i*)(rb + i));
+
+            __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(va, _mm256_setzero_si256()), wa),
+                                          _mm256_mullo_epi16(_mm256_unpacklo_epi8(vb, _mm256_setzero_si256()), wb));
+            __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(va, _mm256_setzero_si256()), wa),
+                                          _mm256_mullo_epi16(_mm256_unpackhi_epi8(vb, _mm256_setzero_si256()), wb));
+
+            lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 8);
+            hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 8);
+
+            // The unpacks and the pack work within each half, so the order comes back as it was.
+            _mm256_storeu_si256((__m256i*)(rd + i), _mm256_packus_epi16(lo, hi));
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Work.
+
+struct MotionWorkData
+{
+    SvrMotionField* field;
+    SvrSimdLevel level;
+    const u8* prev;
+    s32 prev_pitch;
+    const u8* next;
+    s32 next_pitch;
+    u8* dest;
+    s32 dest_pitch;
+    s32 w;
+    float t;
+};
+
+static void motion_gray_work_proc(void* data, s32 start, s32 end)
+{
+    MotionWorkData* work = (MotionWorkData*)data;
+    SvrMotionField* field = work->field;
+
+    s32 start_row = start * MOTION_ROWS_PER_JOB;
+    s32 end_row = end * MOTION_ROWS_PER_JOB;
+
+    motion_make_gray_rows(field, work->prev, work->prev_pitch, field->gray[0], start_row, end_row);
+    motion_make_gray_rows(field, work->next, work->next_pitch, field->gray[1], start_row, end_row);
+}
+
+static void motion_small_work_proc(void* data, s32 start, s32 end)
+{
+    MotionWorkData* work = (MotionWorkData*)data;
+    SvrMotionField* field = work->field;
+
+    s32 start_row = start * MOTION_ROWS_PER_JOB;
+    s32 end_row = end * MOTION_ROWS_PER_JOB;
+
+    motion_make_small_rows(field, field->gray[0], field->small[0], start_row, end_row);
+    motion_make_small_rows(field, field->gray[1], field->small[1], start_row, end_row);
+}
+
+static void motion_estimate_work_proc(void* data, s32 start, s32 end)
+{
+    MotionWorkData* work = (MotionWorkData*)data;
+    SvrMotionField* field = work->field;
+
+    for (s32 by = start; by < svr_min(end, field->blocks_y); by++)
+    {
+        for (s32 bx = 0; bx < field->blocks_x; bx++)
+        {
+            SvrMotionVector coarse = motion_search_small(field, work->level, bx, by);
+            field->vectors[by * field->blocks_x + bx] = motion_search_full(field, work->level, bx, by, coarse);
+        }
+    }
+}
+
+static void motion_interpolate_work_proc(void* data, s32 start, s32 end)
+{
+    MotionWorkData* work = (MotionWorkData*)data;
+    SvrMotionField* field = work->field;
+
+    for (s32 by = start; by < svr_min(end, field->blocks_y); by++)
+    {
+        for (s32 bx = 0; bx < field->blocks_x; bx++)
+        {
+            SvrMotionVector v = field->vectors[by * field->blocks_x + bx];
+
+            s32 x0 = bx * SVR_MOTION_BLOCK;
+            s32 y0 = by * SVR_MOTION_BLOCK;
+            s32 bw = svr_min(SVR_MOTION_BLOCK, field->width - x0);
+            s32 bh = svr_min(SVR_MOTION_BLOCK, field->height - y0);
+
+            // The block moves from where it was in the previous frame to where it is in the next frame.
+            // At this time it is covered by the part of the previous frame that is v * t away,
+            // and by the part of the next frame that is v less than that.
+            s32 ox_a = (s32)floorf(v.x * work->t + 0.5f);
+            s32 oy_a = (s32)floorf(v.y * work->t + 0.5f);
+            s32 ox_b = ox_a - v.x;
+            s32 oy_b = oy_a - v.y;
+
+            bool inside = bw == SVR_MOTION_BLOCK && bh == SVR_MOTION_BLOCK
+                && x0 + svr_min(ox_a, ox_b) >= 0 && x0 + svr_max(ox_a, ox_b) + SVR_MOTION_BLOCK <= field->width
+                && y0 + svr_min(oy_a, oy_b) >= 0 && y0 + svr_max(oy_a, oy_b) + SVR_MOTION_BLOCK <= field->height;
+
+            if (work->level >= SVR_SIMD_AVX2 && inside)
+            {
+                const u8* a = work->prev + (s64)(y0 + oy_a) * work->prev_pitch + (x0 + ox_a) * 4;
+                const u8* b = work->next + (s64)(y0 + oy_b) * work->next_pitch + (x0 + ox_b) * 4;
+                u8* d = work->dest + (s64)y0 * work->dest_pitch + x0 * 4;
+
+                motion_blend_block_avx2(a, work->prev_pitch, b, work->next_pitch, d, work->dest_pitch, work->w);
+            }
+
+            else
+            {
+                motion_blend_block_scalar(work->prev, work->prev_pitch, work->next, work->next_pitch, work->dest, work->dest_pitch,
+                                          x0, y0, bw, bh, ox_a, oy_a, ox_b, oy_b, work->w, field->width, field->height);
+            }
+        }
+    }
+}
+
+static void motion_run(SvrWorkPool* pool, SvrWorkFn fn, MotionWorkData* work, s32 num_items, s32 items_per_job)
+{
+    if (pool == NULL)
+    {
+        fn(work, 0, num_items);
+        return;
+    }
+
+    svr_work_pool_run(pool, fn, work, num_items, items_per_job);
+}
+
+void svr_motion_estimate(SvrMotionField* field, const u8* prev, s32 prev_pitch, const u8* next, s32 next_pitch, SvrSimdLevel level, SvrWorkPool* pool)
+{
+    MotionWorkData work = {};
+    work.field = field;
+    work.level = level;
+    work.prev = prev;
+    work.prev_pitch = prev_pitch;
+    work.next = next;
+    work.next_pitch = next_pitch;
+
+    s32 num_gray_jobs = (field->height + MOTION_ROWS_PER_JOB - 1) / MOTION_ROWS_PER_JOB;
+    s32 num_small_jobs = (field->small_height + MOTION_ROWS_PER_JOB - 1) / MOTION_ROWS_PER_JOB;
+
+    // Every step needs all of the previous step, since the searches look at the rows around them.
+    motion_run(pool, motion_gray_work_proc, &work, num_gray_jobs, 1);
+    motion_run(pool, motion_small_work_proc, &work, num_small_jobs, 1);
+    motion_run(pool, motion_estimate_work_proc, &work, field->blocks_y, MOTION_BLOCK_ROWS_PER_JOB);
+}
+
+void svr_motion_interpolate(SvrMotionField* field, const u8* prev, s32 prev_pitch, const u8* next, s32 next_pitch, float t, u8* dest, s32 dest_pitch, SvrSimdLevel level, SvrWorkPool* pool)
+{
+    MotionWorkData work = {};
+    work.field = field;
+    work.level = level;
+    work.prev = prev;
+    work.prev_pitch = prev_pitch;
+    work.next = next;
+    work.next_pitch = next_pitch;
+    work.dest = dest;
+    work.dest_pitch = dest_pitch;
+    work.t = t;
+    work.w = (s32)floorf(t * 256.0f + 0.5f);
+    svr_clamp(&work.w, 0, 256);
+
+    motion_run(pool, motion_interpolate_work_proc, &work, field->blocks_y, MOTION_BLOCK_ROWS_PER_JOB);
+}
+
+void svr_motion_add_subframes(SvrMotionField* field, SvrMosampleBuffer* buf, const u8* prev, s32 prev_pitch, const u8* next, s32 next_pitch,
+                              float open_part, s32 num_subframes, float weight, u8* temp, SvrSimdLevel level, SvrWorkPool* pool)
+{
+    // Nothing to make if all sub-frames would be at the game frame.
+    if (num_subframes == 1 || open_part <= 0.0f)
+    {
+        svr_mosample_add(buf, next, next_pitch, weight, level, pool);
+        return;
+    }
+
+    float subframe_weight = weight / num_subframes;
+
+    svr_mosample_add(buf, next, next_pitch, subframe_weight, level, pool);
+
+    svr_motion_estimate(field, prev, prev_pitch, next, next_pitch, level, pool);
+
+    for (s32 i = 1; i < num_subframes; i++)
+    {
+        float t = 1.0f - open_part * i / num_subframes;
+
+        svr_motion_interpolate(field, prev, prev_pitch, next, next_pitch, t, temp, next_pitch, level, pool);
+        svr_mosample_add(buf, temp, next_pitch, subframe_weight, level, pool);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_simd.h"
+
+struct SvrWorkPool;
+struct SvrMosampleBuffer;
+
+// Block motion estimation and motion compensated interpolation of 32 bpp frames.
+// This is used to make sub-frames between two real sub-frames for motion blur, so the game can render fewer of them.
+// The made sub-frames are added to a SvrMosampleBuffer like the real ones.
+//
+// Motion is searched on a gray version of the frames, first on a quarter size version over the whole range
+// and then around that result on the full size version.
+// Between the frames, every block is moved along its vector and the previous and next frames are blended.
+// There is no handling of things that are covered or uncovered, so edges of moving things can show some blocks.
+// All levels give the same result as the scalar level.
+
+const s32 SVR_MOTION_BLOCK = 16; // Size of the blocks that have one vector each.
+const s32 SVR_MOTION_RANGE = 32; // Longest vector in pixels in each direction.
+
+struct SvrMotionVector
+{
+    s16 x;
+    s16 y;
+};
+
+struct SvrMotionField
+{
+    s32 width;
+    s32 height;
+    s32 blocks_x;
+    s32 blocks_y;
+
+    // Where every block of the next frame was in the previous frame, relative to the block.
+    SvrMotionVector* vectors;
+
+    // Gray versions of the previous and next frames at full and quarter size.
+    u8* gray[2];
+    u8* small[2];
+    s32 small_width;
+    s32 small_height;
+};
+
+void svr_motion_create_field(SvrMotionField* field, s32 width, s32 height);
+void svr_motion_free_field(SvrMotionField* field);
+
+// Finds the vectors from the next frame to the previous frame. The pool can be NULL to only use the calling thread.
+void svr_motion_estimate(SvrMotionField* field, const u8* prev, s32 prev_pitch, const u8* next, s32 next_pitch, SvrSimdLevel level, SvrWorkPool* pool);
+
+// Makes the frame at a time between the previous frame (0) and the next frame (1) with the vectors from svr_motion_estimate.
+// The pool can be NULL to only use the calling thread.
+void svr_motion_interpolate(SvrMotionField* field, const u8* prev, s32 prev_pitch, const u8* next, s32 next_pitch, float t, u8* dest, s32 dest_pitch, SvrSimdLevel level, SvrWorkPool* pool);
+
+// Adds a game frame to a motion blur buffer as several sub-frames that are made between the previous game frame and this one.
+// The sub-frames are spread evenly over the last part of the time between the two frames, which is the part that the shutter
+// is open for, and the last one is the game frame itself. Every sub-frame gets an even share of the weight.
+// The temp frame must be as big as the game frames, with the pitch of the next frame. The pool can be NULL to only use the calling thread.
+void svr_motion_add_subframes(SvrMotionField* field, SvrMosampleBuffer* buf, const u8* prev, s32 prev_pitch, const u8* next, s32 next_pitch,
+                              float open_part, s32 num_subframes, float weight, u8* temp, SvrSimdLevel level, SvrWorkPool* pool);
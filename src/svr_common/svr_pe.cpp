@@ -0,0 +1,180 @@
+#include "svr_pe.h"
+#include <string.h>
+
+// Offsets of the fields that are used, from the PE format documentation.
+const s32 PE_DOS_NEW_HEADER = 0x3c;
+const s32 PE_FILE_HEADER_SIZE = 24; // Signature and file header.
+const s32 PE_OPT_IMAGE_SIZE = 56; // Same for 32 and 64 bit.
+const s32 PE_SECTION_HEADER_SIZE = 40;
+
+static u16 pe_read_u16(const u8* data)
+{
+    u16 ret;
+    memcpy(&ret, data, sizeof(ret));
+    return ret;
+}
+
+static u32 pe_read_u32(const u8* data)
+{
+    u32 ret;
+    memcpy(&ret, data, sizeof(ret));
+    return ret;
+}
+
+u64 svr_pe_hash(const void* data, s64 size, u64 hash)
+{
+    const u8* bytes = (const u8*)data;
+
+    for (s64 i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+bool svr_pe_read_info(const u8* data, s64 size, SvrPeInfo* out)
+{
+    *out = {};
+
+    if (size < PE_DOS_NEW_HEADER + 4 || data[0] != 'M' || data[1] != 'Z')
+    {
+        return false;
+    }
+
+    s64 nt_pos = pe_read_u32(data + PE_DOS_NEW_HEADER);
+
+    if (nt_pos + PE_FILE_HEADER_SIZE > size || memcmp(data + nt_pos, "PE\0\0", 4))
+    {
+        return false;
+    }
+
+    const u8* file_header = data + nt_pos + 4;
+
+    s32 num_sections = pe_read_u16(file_header + 2);
+    s32 opt_size = pe_read_u16(file_header + 16);
+
+    s64 opt_pos = nt_pos + PE_FILE_HEADER_SIZE;
+    s64 sections_pos = opt_pos + opt_size;
+
+    if (opt_size < PE_OPT_IMAGE_SIZE + 4 || num_sections > SVR_PE_MAX_SECTIONS)
+    {
+        return false;
+    }
+
+    if (sections_pos + (s64)num_sections * PE_SECTION_HEADER_SIZE > size)
+    {
+        return false;
+    }
+
+    out->machine = pe_read_u16(file_header);
+    out->timestamp = pe_read_u32(file_header + 4);
+    out->image_size = pe_read_u32(data + opt_pos + PE_OPT_IMAGE_SIZE);
+    out->num_sections = num_sections;
+
+    for (s32 i = 0; i < num_sections; i++)
+    {
+        const u8* header = data + sections_pos + i * PE_SECTION_HEADER_SIZE;
+        SvrPeSection* section = &out->sections[i];
+
+        memcpy(section->name, header, 8);
+        section->virtual_size = pe_read_u32(header + 8);
+        section->rva = pe_read_u32(header + 12);
+        section->raw_size = pe_read_u32(header + 16);
+        section->raw_offset = pe_read_u32(header + 20);
+        section->characteristics = pe_read_u32(header + 36);
+    }
+
+    out->section_hash = svr_pe_hash(data + sections_pos, (s64)num_sections * PE_SECTION_HEADER_SIZE, SVR_PE_HASH_START);
+
+    return true;
+}
+
+const SvrPeSection* svr_pe_find_section(const SvrPeInfo* info, u32 rva)
+{
+    for (s32 i = 0; i < info->num_sections; i++)
+    {
+        const SvrPeSection* section = &info->sections[i];
+        u32 size = svr_max(section->virtual_size, section->raw_size);
+
+        if (rva >= section->rva && rva - section->rva < size)
+        {
+            return section;
+        }
+    }
+
+    return NULL;
+}
+
+bool svr_pe_is_section_type(const SvrPeSection* section, SvrPeRangeType type)
+{
+    bool is_code = (section->characteristics & (SVR_PE_SECTION_CODE | SVR_PE_SECTION_EXECUTE)) != 0;
+
+    switch (type)
+    {
+        case SVR_PE_RANGE_CODE:
+        {
+            return is_code;
+        }
+
+        case SVR_PE_RANGE_DATA:
+        {
+            return !is_code && (section->characteristics & (SVR_PE_SECTION_INIT_DATA | SVR_PE_SECTION_UNINIT_DATA)) != 0;
+        }
+    }
+
+    return false;
+}
+
+s32 svr_pe_get_ranges(const SvrPeInfo* info, SvrPeRangeType type, SvrPeRange* dest, s32 max_ranges)
+{
+    s32 num_ranges = 0;
+    SvrPeRange last = {};
+
+    // The loader requires the sections to be in the order of their addresses.
+    for (s32 i = 0; i < info->num_sections; i++)
+    {
+        const SvrPeSection* section = &info->sections[i];
+
+        if (!svr_pe_is_section_type(section, type))
+        {
+            continue;
+        }
+
+        // The virtual size can be 0 from some linkers, and then the raw size is used.
+        u32 size = section->virtual_size ? section->virtual_size : section->raw_size;
+
+        SvrPeRange range;
+        range.start = svr_min(section->rva, info->image_size);
+        range.end = svr_min(section->rva + size, info->image_size);
+
+        if (range.start == range.end)
+        {
+            continue;
+        }
+
+        // Sections are aligned to pages, so the end of the last section is rounded up.
+        if (num_ranges > 0 && range.start <= ((last.end + 4095) & ~4095U))
+        {
+            last.end = range.end;
+
+            if (num_ranges <= max_ranges)
+            {
+                dest[num_ranges - 1] = last;
+            }
+
+            continue;
+        }
+
+        last = range;
+        num_ranges++;
+
+        if (num_ranges <= max_ranges)
+        {
+            dest[num_ranges - 1] = last;
+        }
+    }
+
+    return num_ranges;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "svr_common.h"
+
+// Reading of the headers of PE images (exe and dll files).
+// The headers are at the start of both a loaded module and the file on disk, so both can be read.
+// Offsets in the image are relative virtual addresses, which are the same as offsets from the start of a loaded module.
+
+const s32 SVR_PE_MAX_SECTIONS = 96; // What the loader allows.
+
+const u32 SVR_PE_SECTION_CODE = 0x00000020;
+const u32 SVR_PE_SECTION_INIT_DATA = 0x00000040;
+const u32 SVR_PE_SECTION_UNINIT_DATA = 0x00000080;
+const u32 SVR_PE_SECTION_EXECUTE = 0x20000000;
+
+using SvrPeRangeType = s32;
+
+enum /* SvrPeRangeType */
+{
+    SVR_PE_RANGE_CODE, // Sections that can be executed, where code patterns are.
+    SVR_PE_RANGE_DATA, // Sections of data that cannot be executed, where globals are.
+};
+
+struct SvrPeSection
+{
+    char name[9];
+    u32 rva;
+    u32 virtual_size;
+    u32 raw_offset; // Offset in the file on disk.
+    u32 raw_size;
+    u32 characteristics;
+};
+
+// Range of relative virtual addresses, where the end is not included.
+struct SvrPeRange
+{
+    u32 start;
+    u32 end;
+};
+
+struct SvrPeInfo
+{
+    u16 machine;
+    u32 timestamp;
+    u32 image_size;
+
+    s32 num_sections;
+    SvrPeSection sections[SVR_PE_MAX_SECTIONS];
+
+    // Hash of the headers of the sections. Together with the timestamp and size this tells if two images are the same build.
+    u64 section_hash;
+};
+
+// Returns false if the data does not start with valid PE headers.
+bool svr_pe_read_info(const u8* data, s64 size, SvrPeInfo* out);
+
+// Returns the section that has the address, or NULL.
+const SvrPeSection* svr_pe_find_section(const SvrPeInfo* info, u32 rva);
+
+bool svr_pe_is_section_type(const SvrPeSection* section, SvrPeRangeType type);
+
+// Gets the ranges of all sections of a type, in the order of their addresses. Sections that are next to each other are one range.
+// Returns how many ranges there are, which can be more than max_ranges.
+s32 svr_pe_get_ranges(const SvrPeInfo* info, SvrPeRangeType type, SvrPeRange* dest, s32 max_ranges);
+
+// FNV-1a hash, which can be continued by passing in the previous hash.
+const u64 SVR_PE_HASH_START = 0xcbf29ce484222325ULL;
+u64 svr_pe_hash(const void* data, s64 size, u64 hash);
@@ -1,7 +1,9 @@
 #include "svr_prof.h"
-#include <Windows.h>
 #include <assert.h>
 
+#ifdef _WIN32
+#include <Windows.h>
+
 LARGE_INTEGER prof_timer_freq;
 
 s64 svr_prof_get_real_time()
@@ -22,6 +24,23 @@ void svr_prof_init()
     QueryPerformanceFrequency(&prof_timer_freq);
 }
 
+#else
+#include <time.h>
+
+s64 svr_prof_get_real_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (s64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void svr_prof_init()
+{
+}
+
+#endif
+
 void svr_prof_start(SvrProf* prof)
 {
     prof->start = svr_prof_get_real_time();
@@ -38,3 +57,77 @@ void svr_prof_reset(SvrProf* prof)
     prof->runs = 0;
     prof->total = 0;
 }
+
+// Times below 4 have their own buckets, the rest are split by the top set bit and the two bits below it.
+static s32 prof_get_histogram_bucket(s64 time)
+{
+    if (time < 4)
+    {
+        return (s32)svr_max(time, (s64)0);
+    }
+
+    s32 top_bit = 63;
+
+    while ((time & ((s64)1 << top_bit)) == 0)
+    {
+        top_bit--;
+    }
+
+    s32 sub = (s32)((time >> (top_bit - 2)) & 3);
+    s32 idx = (top_bit - 1) * 4 + sub;
+
+    return svr_min(idx, SVR_PROF_HISTOGRAM_BUCKETS - 1);
+}
+
+static s64 prof_get_histogram_bucket_end(s32 idx)
+{
+    if (idx < 4)
+    {
+        return idx;
+    }
+
+    s32 top_bit = idx / 4 + 1;
+    s32 sub = idx % 4;
+    s64 step = (s64)1 << (top_bit - 2);
+
+    return (4 + sub) * step + step - 1;
+}
+
+void svr_prof_histogram_add(SvrProfHistogram* hist, s64 time)
+{
+    hist->buckets[prof_get_histogram_bucket(time)]++;
+    hist->runs++;
+    hist->total += time;
+    hist->max = svr_max(hist->max, time);
+}
+
+void svr_prof_histogram_reset(SvrProfHistogram* hist)
+{
+    *hist = {};
+}
+
+s64 svr_prof_histogram_get_percentile(SvrProfHistogram* hist, s32 percent)
+{
+    if (hist->runs == 0)
+    {
+        return 0;
+    }
+
+    // Number of timings that must be at or below the returned value, rounded up.
+    s64 needed = (hist->runs * percent + 99) / 100;
+    needed = svr_max(needed, (s64)1);
+
+    s64 seen = 0;
+
+    for (s32 i = 0; i < SVR_PROF_HISTOGRAM_BUCKETS - 1; i++)
+    {
+        seen += hist->buckets[i];
+
+        if (seen >= needed)
+        {
+            return svr_min(prof_get_histogram_bucket_end(i), hist->max);
+        }
+    }
+
+    return hist->max;
+}
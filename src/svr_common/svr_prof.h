@@ -14,3 +14,22 @@ s64 svr_prof_get_real_time(); // Returns microseconds.
 void svr_prof_start(SvrProf* prof);
 void svr_prof_end(SvrProf* prof);
 void svr_prof_reset(SvrProf* prof);
+
+// Spread of many short timings, for when the average hides the slow ones.
+// There are 4 buckets for every power of two so every bucket is within 25% of its neighbours. The last bucket holds everything above 16 seconds.
+const s32 SVR_PROF_HISTOGRAM_BUCKETS = 100;
+
+struct SvrProfHistogram
+{
+    s64 buckets[SVR_PROF_HISTOGRAM_BUCKETS];
+    s64 runs;
+    s64 total;
+    s64 max;
+};
+
+void svr_prof_histogram_add(SvrProfHistogram* hist, s64 time); // Microseconds.
+void svr_prof_histogram_reset(SvrProfHistogram* hist);
+
+// Returns the time in microseconds that this percent (0 to 100) of the timings are below or equal to.
+// This is the upper edge of the bucket, so it is never below the real value.
+s64 svr_prof_histogram_get_percentile(SvrProfHistogram* hist, s32 percent);
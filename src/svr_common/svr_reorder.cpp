@@ -0,0 +1,31 @@
+#include "svr_reorder.h"
+
+void svr_stitch_start(SvrStitchTimes* times)
+{
+    times->last_dts = 0;
+    times->any = false;
+}
+
+void svr_stitch_offset(s64 chunk_start, s64* pts, s64* dts)
+{
+    *pts += chunk_start;
+    *dts += chunk_start;
+}
+
+bool svr_stitch_check(SvrStitchTimes* times, s64 pts, s64 dts)
+{
+    if (dts > pts)
+    {
+        return false;
+    }
+
+    if (times->any && dts <= times->last_dts)
+    {
+        return false;
+    }
+
+    times->last_dts = dts;
+    times->any = true;
+
+    return true;
+}
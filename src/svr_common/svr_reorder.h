@@ -0,0 +1,171 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_array.h"
+
+// Puts items that are made out of order back in order by an index, such as the packets from several encoders of one stream.
+// An index can have several items, which come out in the order they were added. The next index is only moved to
+// when the item that was added as the last one of its index has come out.
+// The items are kept in a heap by index, so adding and taking are O(log n) no matter how many indexes are waiting.
+// Not thread safe, it is meant to be used by the one thread that writes the items.
+
+template <class T>
+struct SvrReorder
+{
+    struct Entry
+    {
+        s64 idx;
+        s64 seq; // Order of adding, so items with the same index keep their order.
+        bool last;
+        T item;
+    };
+
+    SvrDynArray<Entry> heap;
+    s64 next_idx; // Index that can come out next.
+    s64 next_seq;
+
+    inline void init(s32 init_capacity)
+    {
+        heap.init(init_capacity);
+        clear(0);
+    }
+
+    inline void free()
+    {
+        heap.free();
+    }
+
+    // Forgets the items without freeing anything they point to, so that has to be done first.
+    inline void clear(s64 first_idx)
+    {
+        heap.size = 0;
+        next_idx = first_idx;
+        next_seq = 0;
+    }
+
+    inline s32 size()
+    {
+        return heap.size;
+    }
+
+    inline void push(s64 idx, bool last, const T& item)
+    {
+        Entry entry;
+        entry.idx = idx;
+        entry.seq = next_seq;
+        entry.last = last;
+        entry.item = item;
+
+        next_seq++;
+
+        heap.push(entry);
+
+        s32 pos = heap.size - 1;
+
+        while (pos > 0)
+        {
+            s32 parent = (pos - 1) / 2;
+
+            if (!is_before(&heap[pos], &heap[parent]))
+            {
+                break;
+            }
+
+            swap(pos, parent);
+            pos = parent;
+        }
+    }
+
+    // Takes the next item if it is its turn, and gives the index it was added with.
+    // When flushing, indexes that never came are skipped, so everything that is left comes out in order.
+    inline bool pull(T* item, s64* idx, bool flush)
+    {
+        if (heap.size == 0)
+        {
+            return false;
+        }
+
+        Entry* top = &heap[0];
+
+        if (top->idx > next_idx)
+        {
+            if (!flush)
+            {
+                return false;
+            }
+
+            next_idx = top->idx;
+        }
+
+        *item = top->item;
+        *idx = top->idx;
+
+        if (top->last)
+        {
+            next_idx = top->idx + 1;
+        }
+
+        heap[0] = heap[heap.size - 1];
+        heap.size--;
+
+        s32 pos = 0;
+
+        while (true)
+        {
+            s32 left = pos * 2 + 1;
+            s32 right = left + 1;
+            s32 first = pos;
+
+            if (left < heap.size && is_before(&heap[left], &heap[first]))
+            {
+                first = left;
+            }
+
+            if (right < heap.size && is_before(&heap[right], &heap[first]))
+            {
+                first = right;
+            }
+
+            if (first == pos)
+            {
+                break;
+            }
+
+            swap(pos, first);
+            pos = first;
+        }
+
+        return true;
+    }
+
+    inline static bool is_before(Entry* a, Entry* b)
+    {
+        return a->idx < b->idx || (a->idx == b->idx && a->seq < b->seq);
+    }
+
+    inline void swap(s32 a, s32 b)
+    {
+        Entry temp = heap[a];
+        heap[a] = heap[b];
+        heap[b] = temp;
+    }
+};
+
+// Decode timestamps of a stream that is put together from chunks that are encoded with contexts of their own.
+// Every context is given the frames of its chunk from 0 so the chunks are all encoded the same way, and the timestamps of the packets
+// are moved forward by where the chunk starts. With the same delay in every context the chunks follow each other without a gap,
+// but a context that delays differently would decode its first packets before the end of the previous chunk.
+// Such a stream cannot be muxed, and moving single packets would make them decode after they are shown, so it must fail instead.
+struct SvrStitchTimes
+{
+    s64 last_dts;
+    bool any; // Set once there is a last_dts.
+};
+
+void svr_stitch_start(SvrStitchTimes* times);
+
+// Moves the timestamps of a packet from the context of its chunk to the stream. Both are in the time base of the context.
+void svr_stitch_offset(s64 chunk_start, s64* pts, s64* dts);
+
+// Called for every packet of the stream in the order they are written.
+// Returns false if the packet would decode at or before the one before it, or after it is shown.
+bool svr_stitch_check(SvrStitchTimes* times, s64 pts, s64 dts);
@@ -0,0 +1,234 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_atom.h"
+#include "svr_alloc.h"
+#include <assert.h>
+
+// Bounded lock free ring queues.
+// Unlike SvrLockedQueue these do not grow, so the capacity must be picked for the worst case and be a power of two.
+// Pushing to a full ring fails, and the caller decides if it wants to wait or drop.
+// Indexes are free running 32-bit counters that are wrapped with the mask, so they are compared with unsigned differences.
+
+// Safe for one thread to push and one thread to pull.
+// Each side keeps a cached copy of the other side's index so the shared cache lines are only touched when needed.
+template <class T>
+struct SvrSpscRing
+{
+    T* items;
+    s32 mask;
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 write_idx; // Written by the producer.
+    s32 cached_read_idx; // Producer copy of read_idx.
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 read_idx; // Written by the consumer.
+    s32 cached_write_idx; // Consumer copy of write_idx.
+
+    SVR_THREAD_PADDING();
+
+    inline void init(s32 capacity)
+    {
+        assert((capacity & (capacity - 1)) == 0);
+
+        items = (T*)svr_alloc(sizeof(T) * capacity);
+        mask = capacity - 1;
+
+        svr_atom_store(&write_idx, 0);
+        svr_atom_store(&read_idx, 0);
+        cached_read_idx = 0;
+        cached_write_idx = 0;
+    }
+
+    inline void free()
+    {
+        if (items)
+        {
+            svr_free(items);
+            items = NULL;
+        }
+    }
+
+    // Pushes to the back.
+    inline bool push(T* item)
+    {
+        s32 w = svr_atom_load(&write_idx);
+
+        if ((u32)w - (u32)cached_read_idx > (u32)mask)
+        {
+            cached_read_idx = svr_atom_load(&read_idx);
+
+            if ((u32)w - (u32)cached_read_idx > (u32)mask)
+            {
+                return false; // Full.
+            }
+        }
+
+        items[w & mask] = *item;
+        svr_atom_store(&write_idx, (s32)((u32)w + 1));
+
+        return true;
+    }
+
+    // Pops from the front.
+    inline bool pull(T* item)
+    {
+        s32 r = svr_atom_load(&read_idx);
+
+        if (r == cached_write_idx)
+        {
+            cached_write_idx = svr_atom_load(&write_idx);
+
+            if (r == cached_write_idx)
+            {
+                return false; // Empty.
+            }
+        }
+
+        *item = items[r & mask];
+        svr_atom_store(&read_idx, (s32)((u32)r + 1));
+
+        return true;
+    }
+
+    // Only an estimate when called while the other side is working.
+    inline s32 size()
+    {
+        return (s32)((u32)svr_atom_load(&write_idx) - (u32)svr_atom_load(&read_idx));
+    }
+};
+
+// Safe for several threads to push and several threads to pull.
+// Every cell has a sequence number that tells if it is ready to be written or read for the current lap.
+template <class T>
+struct SvrMpmcRing
+{
+    struct Cell
+    {
+        SvrAtom32 seq;
+        T item;
+    };
+
+    Cell* cells;
+    s32 mask;
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 write_idx;
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 read_idx;
+
+    SVR_THREAD_PADDING();
+
+    inline void init(s32 capacity)
+    {
+        assert((capacity & (capacity - 1)) == 0);
+
+        cells = (Cell*)svr_alloc(sizeof(Cell) * capacity);
+        mask = capacity - 1;
+
+        for (s32 i = 0; i < capacity; i++)
+        {
+            svr_atom_store(&cells[i].seq, i);
+        }
+
+        svr_atom_store(&write_idx, 0);
+        svr_atom_store(&read_idx, 0);
+    }
+
+    inline void free()
+    {
+        if (cells)
+        {
+            svr_free(cells);
+            cells = NULL;
+        }
+    }
+
+    // Pushes to the back.
+    inline bool push(T* item)
+    {
+        Cell* cell;
+        s32 pos = svr_atom_load(&write_idx);
+
+        while (true)
+        {
+            cell = &cells[pos & mask];
+
+            s32 seq = svr_atom_load(&cell->seq);
+            s32 diff = (s32)((u32)seq - (u32)pos);
+
+            if (diff == 0)
+            {
+                // Cell is free in this lap, try to claim it. Gives back the new position on failure.
+                if (svr_atom_cmpxchg(&write_idx, &pos, (s32)((u32)pos + 1)))
+                {
+                    break;
+                }
+            }
+
+            else if (diff < 0)
+            {
+                return false; // Full.
+            }
+
+            else
+            {
+                pos = svr_atom_load(&write_idx); // Someone else took it.
+            }
+        }
+
+        cell->item = *item;
+        svr_atom_store(&cell->seq, (s32)((u32)pos + 1));
+
+        return true;
+    }
+
+    // Pops from the front.
+    inline bool pull(T* item)
+    {
+        Cell* cell;
+        s32 pos = svr_atom_load(&read_idx);
+
+        while (true)
+        {
+            cell = &cells[pos & mask];
+
+            s32 seq = svr_atom_load(&cell->seq);
+            s32 diff = (s32)((u32)seq - ((u32)pos + 1));
+
+            if (diff == 0)
+            {
+                if (svr_atom_cmpxchg(&read_idx, &pos, (s32)((u32)pos + 1)))
+                {
+                    break;
+                }
+            }
+
+            else if (diff < 0)
+            {
+                return false; // Empty.
+            }
+
+            else
+            {
+                pos = svr_atom_load(&read_idx);
+            }
+        }
+
+        *item = cell->item;
+        svr_atom_store(&cell->seq, (s32)((u32)pos + (u32)mask + 1)); // Free for the next lap.
+
+        return true;
+    }
+
+    // Only an estimate when called while other threads are working.
+    inline s32 size()
+    {
+        return (s32)((u32)svr_atom_load(&write_idx) - (u32)svr_atom_load(&read_idx));
+    }
+};
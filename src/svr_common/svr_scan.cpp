@@ -0,0 +1,383 @@
+#include "svr_scan.h"
+#include "svr_alloc.h"
+#include <string.h>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+struct ScanGroup
+{
+    // The anchor bytes, repeated so the SIMD levels can load them directly.
+    u8 first[32];
+    u8 second[32]; // Already masked.
+    u8 second_mask[32];
+
+    s32 head; // First pattern in the group, or -1 when all are found.
+};
+
+struct ScanState
+{
+    // The range that is searched now. The groups carry over from one range to the next.
+    const u8* data;
+    s64 size;
+    s64 base; // Offset of the range, which is added to the found offsets.
+
+    const SvrScanPattern* patterns;
+    s64* offsets;
+    s32* next; // Next pattern in the same group, or -1.
+
+    // Only the groups that have patterns left are kept at the start.
+    ScanGroup* groups;
+    s32 num_groups;
+};
+
+static s32 scan_get_lowest_bit(u32 bits)
+{
+#ifdef _MSC_VER
+    unsigned long ret;
+    _BitScanForward(&ret, bits);
+    return ret;
+#else
+    return __builtin_ctz(bits);
+#endif
+}
+
+static s32 scan_get_hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// How common the byte is in x86 and x64 code. Anchors of uncommon bytes give fewer places to compare.
+static s32 scan_get_byte_score(u8 b)
+{
+    switch (b)
+    {
+        case 0x00: case 0xff: case 0xcc: case 0x0f: case 0x48: case 0x89: case 0x8b: case 0xe8:
+        {
+            return 2;
+        }
+
+        case 0x01: case 0x04: case 0x08: case 0x10: case 0x20: case 0x24: case 0x28: case 0x30:
+        case 0x33: case 0x40: case 0x41: case 0x44: case 0x45: case 0x4c: case 0x50: case 0x51:
+        case 0x53: case 0x55: case 0x56: case 0x57: case 0x5d: case 0x5e: case 0x5f: case 0x74:
+        case 0x75: case 0x83: case 0x85: case 0x8d: case 0x90: case 0xc0: case 0xc3: case 0xc7:
+        case 0xe9: case 0xec:
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static s32 scan_pick_anchor(SvrScanPattern* pattern)
+{
+    s32 ret = -1;
+    s32 best_score = INT32_MAX;
+
+    for (s32 i = 0; i < pattern->size; i++)
+    {
+        if (pattern->mask[i] == 0)
+        {
+            continue;
+        }
+
+        s32 score = scan_get_byte_score(pattern->bytes[i]);
+
+        if (i + 1 < pattern->size && pattern->mask[i + 1])
+        {
+            score += scan_get_byte_score(pattern->bytes[i + 1]);
+        }
+
+        else
+        {
+            score += 3; // Only one byte to search for.
+        }
+
+        if (score < best_score)
+        {
+            best_score = score;
+            ret = i;
+        }
+    }
+
+    return ret;
+}
+
+bool svr_scan_compile_pattern(const char* text, SvrScanPattern* out)
+{
+    *out = {};
+
+    for (const char* ptr = text; *ptr; ptr++)
+    {
+        if (svr_is_whitespace(*ptr))
+        {
+            continue;
+        }
+
+        if (out->size == SVR_SCAN_MAX_BYTES)
+        {
+            return false;
+        }
+
+        if (ptr[0] == '?' && ptr[1] == '?')
+        {
+            out->size++;
+            ptr++;
+            continue;
+        }
+
+        s32 high = scan_get_hex_value(ptr[0]);
+        s32 low = high != -1 ? scan_get_hex_value(ptr[1]) : -1;
+
+        if (low == -1)
+        {
+            return false;
+        }
+
+        out->bytes[out->size] = (u8)((high << 4) | low);
+        out->mask[out->size] = 0xff;
+        out->size++;
+        ptr++;
+    }
+
+    out->anchor = scan_pick_anchor(out);
+
+    return out->anchor != -1;
+}
+
+bool svr_scan_compare(const u8* data, const SvrScanPattern* pattern)
+{
+    for (s32 i = 0; i < pattern->size; i++)
+    {
+        if ((data[i] & pattern->mask[i]) != pattern->bytes[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Compares the patterns of a group where its anchor is found.
+// Returns true if the group has no patterns left and was replaced by the last group.
+static bool scan_check_group(ScanState* state, s32 group_idx, s64 pos)
+{
+    ScanGroup* group = &state->groups[group_idx];
+    s32* link = &group->head;
+
+    while (*link != -1)
+    {
+        s32 idx = *link;
+        const SvrScanPattern* pattern = &state->patterns[idx];
+        s64 start = pos - pattern->anchor;
+
+        if (start >= 0 && start + pattern->size <= state->size && svr_scan_compare(state->data + start, pattern))
+        {
+            state->offsets[idx] = state->base + start;
+            *link = state->next[idx];
+            continue;
+        }
+
+        link = &state->next[idx];
+    }
+
+    if (group->head != -1)
+    {
+        return false;
+    }
+
+    state->num_groups--;
+    state->groups[group_idx] = state->groups[state->num_groups];
+
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Scalar level.
+// The groups are checked from the last so that a group that is replaced by the last one is not checked twice.
+
+static void scan_find_scalar(ScanState* state, s64 pos)
+{
+    for (; pos < state->size && state->num_groups > 0; pos++)
+    {
+        u8 first = state->data[pos];
+        u8 second = pos + 1 < state->size ? state->data[pos + 1] : 0;
+
+        for (s32 i = state->num_groups - 1; i >= 0; i--)
+        {
+            ScanGroup* group = &state->groups[i];
+
+            if (first == group->first[0] && (second & group->second_mask[0]) == group->second[0])
+            {
+                scan_check_group(state, i, pos);
+            }
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// SSE4.1 level.
+// 16 positions at a time. Returns the position where the scalar level should continue.
+
+SVR_TARGET_SSE41 static s64 scan_find_sse41(ScanState* state, s64 pos)
+{
+    for (; pos + 17 <= state->size && state->num_groups > 0; pos += 16)
+    {
+        __m128i first = _mm_loadu_si128((__m128i*)(state->data + pos));
+        __m128i second = _mm_loadu_si128((__m128i*)(state->data + pos + 1));
+
+        for (s32 i = state->num_groups - 1; i >= 0; i--)
+        {
+            ScanGroup* group = &state->groups[i];
+
+            __m128i first_hit = _mm_cmpeq_epi8(first, _mm_loadu_si128((__m128i*)group->first));
+            __m128i second_hit = _mm_cmpeq_epi8(_mm_and_si128(second, _mm_loadu_si128((__m128i*)group->second_mask)), _mm_loadu_si128((__m128i*)group->second));
+
+            u32 bits = (u32)_mm_movemask_epi8(_mm_and_si128(first_hit, second_hit));
+
+            while (bits)
+            {
+                s32 bit = scan_get_lowest_bit(bits);
+                bits &= bits - 1;
+
+                if (scan_check_group(state, i, pos + bit))
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return pos;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// AVX2 level.
+// 32 positions at a time. Returns the position where the scalar level should continue.
+
+SVR_TARGET_AVX2 static s64 scan_find_avx2(ScanState* state, s64 pos)
+{
+    for (; pos + 33 <= state->size && state->num_groups > 0; pos += 32)
+    {
+        __m256i first = _mm256_loadu_si256((__m256i*)(state->data + pos));
+        __m256i second = _mm256_loadu_si256((__m256i*)(state->data + pos + 1));
+
+        for (s32 i = state->num_groups - 1; i >= 0; i--)
+        {
+            ScanGroup* group = &state->groups[i];
+
+            __m256i first_hit = _mm256_cmpeq_epi8(first, _mm256_loadu_si256((__m256i*)group->first));
+            __m256i second_hit = _mm256_cmpeq_epi8(_mm256_and_si256(second, _mm256_loadu_si256((__m256i*)group->second_mask)), _mm256_loadu_si256((__m256i*)group->second));
+
+            u32 bits = (u32)_mm256_movemask_epi8(_mm256_and_si256(first_hit, second_hit));
+
+            while (bits)
+            {
+                s32 bit = scan_get_lowest_bit(bits);
+                bits &= bits - 1;
+
+                if (scan_check_group(state, i, pos + bit))
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return pos;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static s32 scan_find_or_add_group(ScanState* state, u8 first, u8 second, u8 second_mask)
+{
+    for (s32 i = 0; i < state->num_groups; i++)
+    {
+        ScanGroup* group = &state->groups[i];
+
+        if (group->first[0] == first && group->second[0] == second && group->second_mask[0] == second_mask)
+        {
+            return i;
+        }
+    }
+
+    ScanGroup* group = &state->groups[state->num_groups];
+    memset(group->first, first, sizeof(group->first));
+    memset(group->second, second, sizeof(group->second));
+    memset(group->second_mask, second_mask, sizeof(group->second_mask));
+    group->head = -1;
+
+    state->num_groups++;
+    return state->num_groups - 1;
+}
+
+void svr_scan_find_all_in_ranges(const u8* data, const SvrScanRange* ranges, s32 num_ranges, const SvrScanPattern* patterns, s32 num_patterns,
+                                 s64* offsets, SvrSimdLevel level)
+{
+    ScanState state = {};
+    state.patterns = patterns;
+    state.offsets = offsets;
+    state.next = (s32*)svr_alloc(sizeof(s32) * num_patterns);
+    state.groups = (ScanGroup*)svr_alloc(sizeof(ScanGroup) * num_patterns);
+
+    for (s32 i = 0; i < num_patterns; i++)
+    {
+        const SvrScanPattern* pattern = &patterns[i];
+        s32 anchor = pattern->anchor;
+
+        offsets[i] = -1;
+
+        if (anchor < 0 || anchor >= pattern->size)
+        {
+            continue;
+        }
+
+        bool has_second = anchor + 1 < pattern->size;
+        u8 second = has_second ? pattern->bytes[anchor + 1] : 0;
+        u8 second_mask = has_second ? pattern->mask[anchor + 1] : 0;
+
+        s32 group_idx = scan_find_or_add_group(&state, pattern->bytes[anchor], second, second_mask);
+
+        state.next[i] = state.groups[group_idx].head;
+        state.groups[group_idx].head = i;
+    }
+
+    for (s32 i = 0; i < num_ranges && state.num_groups > 0; i++)
+    {
+        state.data = data + ranges[i].start;
+        state.size = ranges[i].end - ranges[i].start;
+        state.base = ranges[i].start;
+
+        s64 pos = 0;
+
+        if (level >= SVR_SIMD_AVX2)
+        {
+            pos = scan_find_avx2(&state, pos);
+        }
+
+        else if (level >= SVR_SIMD_SSE41)
+        {
+            pos = scan_find_sse41(&state, pos);
+        }
+
+        scan_find_scalar(&state, pos);
+    }
+
+    svr_free(state.groups);
+    svr_free(state.next);
+}
+
+void svr_scan_find_all(const u8* data, s64 size, const SvrScanPattern* patterns, s32 num_patterns, s64* offsets, SvrSimdLevel level)
+{
+    SvrScanRange range;
+    range.start = 0;
+    range.end = size;
+
+    svr_scan_find_all_in_ranges(data, &range, 1, patterns, num_patterns, offsets, level);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_simd.h"
+
+// Search for many byte patterns at the same time with one pass over the data.
+// Every pattern has an anchor, which is two bytes of the pattern that are rare in code. The data is only searched for the anchors,
+// and the full patterns are only compared where an anchor is found. Patterns with the same anchor share the search.
+// Patterns that are found are removed from the search, and the search stops when everything is found.
+// All levels give the same result as the scalar level.
+
+// How many bytes there can be in a pattern.
+const s32 SVR_SCAN_MAX_BYTES = 256;
+
+struct SvrScanPattern
+{
+    u8 bytes[SVR_SCAN_MAX_BYTES]; // Unknown bytes are 0.
+    u8 mask[SVR_SCAN_MAX_BYTES]; // 0xff for known bytes and 0 for unknown bytes.
+    s32 size;
+
+    // Offset of the anchor. The second byte of the anchor can be unknown if the pattern has no two known bytes next to each other.
+    s32 anchor;
+};
+
+// Makes a pattern from text like "8B 0D ?? ?? ?? ?? 85 C9", where "??" is an unknown byte.
+// Returns false if the text is not a pattern or if it has no known bytes.
+bool svr_scan_compile_pattern(const char* text, SvrScanPattern* out);
+
+// Returns true if the pattern is at the data. The data must have at least the size of the pattern.
+bool svr_scan_compare(const u8* data, const SvrScanPattern* pattern);
+
+// Part of the data to search in, where the end is not included.
+struct SvrScanRange
+{
+    s64 start;
+    s64 end;
+};
+
+// Finds where every pattern is first found in the data. The offsets of patterns that are not found are -1.
+void svr_scan_find_all(const u8* data, s64 size, const SvrScanPattern* patterns, s32 num_patterns, s64* offsets, SvrSimdLevel level);
+
+// Same as above but only in some ranges of the data, which are searched in order. A pattern must be inside a range to be found.
+// The offsets are from the start of the data.
+void svr_scan_find_all_in_ranges(const u8* data, const SvrScanRange* ranges, s32 num_ranges, const SvrScanPattern* patterns, s32 num_patterns,
+                                 s64* offsets, SvrSimdLevel level);
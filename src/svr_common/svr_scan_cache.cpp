@@ -0,0 +1,278 @@
+#include "svr_scan_cache.h"
+#include "svr_pe.h"
+#include "svr_alloc.h"
+#include <string.h>
+
+// Layout of the data. Everything is little endian and has no padding.
+
+const u32 SCAN_CACHE_MAGIC = 0x43535653; // "SVSC".
+
+const s32 SCAN_CACHE_MAX_MODULES = 256;
+const s32 SCAN_CACHE_MAX_ENTRIES = 4096;
+
+struct ScanCacheHeader
+{
+    u32 magic;
+    u32 version;
+    s32 num_modules;
+    s32 reserved;
+};
+
+// Followed by the entries.
+struct ScanCacheModuleHeader
+{
+    char name[64];
+    u32 timestamp;
+    u32 image_size;
+    u64 section_hash;
+    s32 num_entries;
+    s32 reserved;
+};
+
+static bool scan_cache_read_bytes(const u8* data, s64 size, s64* pos, void* dest, s64 num)
+{
+    if (*pos + num > size)
+    {
+        return false;
+    }
+
+    memcpy(dest, data + *pos, num);
+    *pos += num;
+    return true;
+}
+
+static void scan_cache_write_bytes(SvrDynArray<u8>* dest, const void* data, s32 num)
+{
+    dest->insert_range(dest->size, (const u8*)data, num);
+}
+
+void svr_scan_cache_free(SvrScanCache* cache)
+{
+    for (s32 i = 0; i < cache->modules.size; i++)
+    {
+        cache->modules[i].entries.free();
+    }
+
+    cache->modules.free();
+    cache->changed = false;
+}
+
+bool svr_scan_cache_read(SvrScanCache* cache, const u8* data, s64 size)
+{
+    bool ret = false;
+    s64 pos = 0;
+    ScanCacheHeader header;
+
+    *cache = {};
+
+    if (!scan_cache_read_bytes(data, size, &pos, &header, sizeof(header)))
+    {
+        goto rfail;
+    }
+
+    if (header.magic != SCAN_CACHE_MAGIC || header.version != SVR_SCAN_CACHE_VERSION)
+    {
+        goto rfail;
+    }
+
+    if (header.num_modules < 0 || header.num_modules > SCAN_CACHE_MAX_MODULES)
+    {
+        goto rfail;
+    }
+
+    for (s32 i = 0; i < header.num_modules; i++)
+    {
+        ScanCacheModuleHeader module_header;
+
+        if (!scan_cache_read_bytes(data, size, &pos, &module_header, sizeof(module_header)))
+        {
+            goto rfail;
+        }
+
+        if (module_header.num_entries < 0 || module_header.num_entries > SCAN_CACHE_MAX_ENTRIES)
+        {
+            goto rfail;
+        }
+
+        SvrScanCacheModule* module = cache->modules.emplace_zero();
+        memcpy(module->name, module_header.name, sizeof(module->name));
+        module->name[SVR_ARRAY_SIZE(module->name) - 1] = 0;
+        module->timestamp = module_header.timestamp;
+        module->image_size = module_header.image_size;
+        module->section_hash = module_header.section_hash;
+
+        module->entries.expand_if_needed(module_header.num_entries);
+
+        if (!scan_cache_read_bytes(data, size, &pos, module->entries.mem, sizeof(SvrScanCacheEntry) * module_header.num_entries))
+        {
+            goto rfail;
+        }
+
+        module->entries.size = module_header.num_entries;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    svr_scan_cache_free(cache);
+
+rexit:
+    return ret;
+}
+
+void svr_scan_cache_write(SvrScanCache* cache, SvrDynArray<u8>* dest)
+{
+    ScanCacheHeader header = {};
+    header.magic = SCAN_CACHE_MAGIC;
+    header.version = SVR_SCAN_CACHE_VERSION;
+    header.num_modules = cache->modules.size;
+
+    scan_cache_write_bytes(dest, &header, sizeof(header));
+
+    for (s32 i = 0; i < cache->modules.size; i++)
+    {
+        SvrScanCacheModule* module = &cache->modules[i];
+
+        ScanCacheModuleHeader module_header = {};
+        memcpy(module_header.name, module->name, sizeof(module_header.name));
+        module_header.timestamp = module->timestamp;
+        module_header.image_size = module->image_size;
+        module_header.section_hash = module->section_hash;
+        module_header.num_entries = module->entries.size;
+
+        scan_cache_write_bytes(dest, &module_header, sizeof(module_header));
+        scan_cache_write_bytes(dest, module->entries.mem, sizeof(SvrScanCacheEntry) * module->entries.size);
+    }
+}
+
+u64 svr_scan_cache_hash_pattern(const SvrScanPattern* pattern)
+{
+    u64 hash = SVR_PE_HASH_START;
+    hash = svr_pe_hash(&pattern->size, sizeof(pattern->size), hash);
+    hash = svr_pe_hash(pattern->bytes, pattern->size, hash);
+    hash = svr_pe_hash(pattern->mask, pattern->size, hash);
+    return hash;
+}
+
+static SvrScanCacheModule* scan_cache_find_module(SvrScanCache* cache, const char* name)
+{
+    for (s32 i = 0; i < cache->modules.size; i++)
+    {
+        if (!strcmp(cache->modules[i].name, name))
+        {
+            return &cache->modules[i];
+        }
+    }
+
+    return NULL;
+}
+
+static SvrScanCacheEntry* scan_cache_find_entry(SvrScanCacheModule* module, u64 pattern_hash)
+{
+    for (s32 i = 0; i < module->entries.size; i++)
+    {
+        if (module->entries[i].pattern_hash == pattern_hash)
+        {
+            return &module->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+s32 svr_scan_find_all_cached(SvrScanCache* cache, const char* name, const u8* data, s64 size, const SvrScanRange* ranges, s32 num_ranges,
+                             const SvrScanPattern* patterns, s32 num_patterns, s64* offsets, SvrSimdLevel level)
+{
+    SvrPeInfo info;
+
+    // Nothing to tell if it has changed.
+    if (!svr_pe_read_info(data, size, &info))
+    {
+        svr_scan_find_all_in_ranges(data, ranges, num_ranges, patterns, num_patterns, offsets, level);
+        return 0;
+    }
+
+    SvrScanCacheModule* module = scan_cache_find_module(cache, name);
+
+    if (module == NULL)
+    {
+        module = cache->modules.emplace_zero();
+        SVR_COPY_STRING(name, module->name);
+        cache->changed = true;
+    }
+
+    if (module->timestamp != info.timestamp || module->image_size != info.image_size || module->section_hash != info.section_hash)
+    {
+        module->timestamp = info.timestamp;
+        module->image_size = info.image_size;
+        module->section_hash = info.section_hash;
+        module->entries.size = 0;
+        cache->changed = true;
+    }
+
+    u64* hashes = (u64*)svr_alloc(sizeof(u64) * num_patterns);
+    s32* left = (s32*)svr_alloc(sizeof(s32) * num_patterns);
+    s32 num_left = 0;
+
+    for (s32 i = 0; i < num_patterns; i++)
+    {
+        const SvrScanPattern* pattern = &patterns[i];
+
+        hashes[i] = svr_scan_cache_hash_pattern(pattern);
+        SvrScanCacheEntry* entry = scan_cache_find_entry(module, hashes[i]);
+
+        if (entry)
+        {
+            s64 offset = entry->offset;
+
+            if (offset == -1 || (offset >= 0 && offset + pattern->size <= size && svr_scan_compare(data + offset, pattern)))
+            {
+                offsets[i] = offset;
+                continue;
+            }
+        }
+
+        left[num_left] = i;
+        num_left++;
+    }
+
+    if (num_left > 0)
+    {
+        SvrScanPattern* left_patterns = (SvrScanPattern*)svr_alloc(sizeof(SvrScanPattern) * num_left);
+        s64* left_offsets = (s64*)svr_alloc(sizeof(s64) * num_left);
+
+        for (s32 i = 0; i < num_left; i++)
+        {
+            left_patterns[i] = patterns[left[i]];
+        }
+
+        svr_scan_find_all_in_ranges(data, ranges, num_ranges, left_patterns, num_left, left_offsets, level);
+
+        for (s32 i = 0; i < num_left; i++)
+        {
+            s32 idx = left[i];
+            offsets[idx] = left_offsets[i];
+
+            SvrScanCacheEntry* entry = scan_cache_find_entry(module, hashes[idx]);
+
+            if (entry == NULL)
+            {
+                entry = module->entries.emplace();
+                entry->pattern_hash = hashes[idx];
+            }
+
+            entry->offset = left_offsets[i];
+        }
+
+        cache->changed = true;
+
+        svr_free(left_offsets);
+        svr_free(left_patterns);
+    }
+
+    svr_free(left);
+    svr_free(hashes);
+
+    return num_patterns - num_left;
+}
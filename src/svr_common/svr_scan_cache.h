@@ -0,0 +1,47 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_array.h"
+#include "svr_scan.h"
+
+// Cache of where patterns were found in modules, so a module does not have to be searched again if it has not changed since last time.
+// A module is the same if its name, timestamp, image size and section headers are the same.
+// Cached offsets are still compared to their patterns before they are used. Patterns that do not match or are not in the cache are searched for.
+// Patterns that were not found are trusted to still not be there when the module is the same.
+
+const u32 SVR_SCAN_CACHE_VERSION = 2;
+
+struct SvrScanCacheEntry
+{
+    u64 pattern_hash;
+    s64 offset; // Relative to the start of the module, or -1 if not found.
+};
+
+struct SvrScanCacheModule
+{
+    char name[64];
+    u32 timestamp;
+    u32 image_size;
+    u64 section_hash;
+
+    SvrDynArray<SvrScanCacheEntry> entries;
+};
+
+struct SvrScanCache
+{
+    SvrDynArray<SvrScanCacheModule> modules;
+    bool changed; // If it has to be written again.
+};
+
+void svr_scan_cache_free(SvrScanCache* cache);
+
+// Reads a cache from the data of svr_scan_cache_write.
+// Returns false and leaves the cache empty if the data is not a cache of this version.
+bool svr_scan_cache_read(SvrScanCache* cache, const u8* data, s64 size);
+void svr_scan_cache_write(SvrScanCache* cache, SvrDynArray<u8>* dest);
+
+u64 svr_scan_cache_hash_pattern(const SvrScanPattern* pattern);
+
+// Like svr_scan_find_all_in_ranges, but for a loaded module that is only searched for the patterns that the cache cannot give.
+// The cache is updated with what was searched for. Returns the number of patterns that came from the cache.
+s32 svr_scan_find_all_cached(SvrScanCache* cache, const char* name, const u8* data, s64 size, const SvrScanRange* ranges, s32 num_ranges,
+                             const SvrScanPattern* patterns, s32 num_patterns, s64* offsets, SvrSimdLevel level);
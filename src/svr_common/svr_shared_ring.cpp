@@ -0,0 +1,88 @@
+#include "svr_shared_ring.h"
+#include <assert.h>
+
+void svr_shared_ring_init(SvrSharedRing* ring, s32 item_size, s32 capacity, s32 items_offset)
+{
+    assert((capacity & (capacity - 1)) == 0);
+
+    ring->item_size = item_size;
+    ring->mask = capacity - 1;
+    ring->items_offset = items_offset;
+
+    svr_atom_store(&ring->write_idx, 0);
+    svr_atom_store(&ring->read_idx, 0);
+    ring->cached_read_idx = 0;
+    ring->cached_write_idx = 0;
+}
+
+s32 svr_shared_ring_get_capacity(SvrSharedRing* ring)
+{
+    return ring->mask + 1;
+}
+
+s32 svr_shared_ring_get_num_items(SvrSharedRing* ring)
+{
+    return (s32)((u32)svr_atom_load(&ring->write_idx) - (u32)svr_atom_load(&ring->read_idx));
+}
+
+// Where the item at this index is stored.
+static u8* shared_ring_get_item(SvrSharedRing* ring, s32 idx)
+{
+    return (u8*)ring + ring->items_offset + (idx & ring->mask) * ring->item_size;
+}
+
+// How many items there are from this index to the end of the storage.
+static s32 shared_ring_get_num_until_end(SvrSharedRing* ring, s32 idx)
+{
+    return ring->mask + 1 - (idx & ring->mask);
+}
+
+s32 svr_shared_ring_begin_write(SvrSharedRing* ring, void** dest, s32 max_items)
+{
+    s32 w = svr_atom_load(&ring->write_idx);
+    s32 capacity = ring->mask + 1;
+    s32 num_free = capacity - (s32)((u32)w - (u32)ring->cached_read_idx);
+
+    // Only look at the other side when it seems like there is not enough room.
+    if (num_free < max_items)
+    {
+        ring->cached_read_idx = svr_atom_load(&ring->read_idx);
+        num_free = capacity - (s32)((u32)w - (u32)ring->cached_read_idx);
+    }
+
+    s32 num = svr_min(num_free, max_items);
+    num = svr_min(num, shared_ring_get_num_until_end(ring, w));
+
+    *dest = shared_ring_get_item(ring, w);
+    return num;
+}
+
+void svr_shared_ring_end_write(SvrSharedRing* ring, s32 num_items)
+{
+    s32 w = svr_atom_load(&ring->write_idx);
+    svr_atom_store(&ring->write_idx, (s32)((u32)w + (u32)num_items));
+}
+
+s32 svr_shared_ring_begin_read(SvrSharedRing* ring, void** src, s32 max_items)
+{
+    s32 r = svr_atom_load(&ring->read_idx);
+    s32 num_used = (s32)((u32)ring->cached_write_idx - (u32)r);
+
+    if (num_used < max_items)
+    {
+        ring->cached_write_idx = svr_atom_load(&ring->write_idx);
+        num_used = (s32)((u32)ring->cached_write_idx - (u32)r);
+    }
+
+    s32 num = svr_min(num_used, max_items);
+    num = svr_min(num, shared_ring_get_num_until_end(ring, r));
+
+    *src = shared_ring_get_item(ring, r);
+    return num;
+}
+
+void svr_shared_ring_end_read(SvrSharedRing* ring, s32 num_items)
+{
+    s32 r = svr_atom_load(&ring->read_idx);
+    svr_atom_store(&ring->read_idx, (s32)((u32)r + (u32)num_items));
+}
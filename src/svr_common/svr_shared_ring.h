@@ -0,0 +1,51 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_atom.h"
+
+// Ring of fixed size items that is safe for one thread to write and one thread to read, which can be in different processes.
+// The items are placed at an offset from the ring instead of through a pointer, since every process maps the memory
+// at a different address and pointers are different sizes in 32-bit and 64-bit.
+// Both sides get direct access to the items so nothing has to be copied in between. Only the items up to the end of
+// the storage are given at once, so a range that wraps around takes two calls.
+// Indexes are free running 32-bit counters that are wrapped with the mask, so they are compared with unsigned differences.
+
+struct SvrSharedRing
+{
+    s32 item_size; // In bytes.
+    s32 mask; // Number of items minus one.
+    s32 items_offset; // In bytes from the start of this struct.
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 write_idx; // Written by the producer.
+    s32 cached_read_idx; // Producer copy of read_idx.
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 read_idx; // Written by the consumer.
+    s32 cached_write_idx; // Consumer copy of write_idx.
+
+    SVR_THREAD_PADDING();
+};
+
+// Must be called when neither side is using the ring. The capacity must be a power of two.
+void svr_shared_ring_init(SvrSharedRing* ring, s32 item_size, s32 capacity, s32 items_offset);
+
+s32 svr_shared_ring_get_capacity(SvrSharedRing* ring);
+
+// Only an estimate when called while the other side is working.
+s32 svr_shared_ring_get_num_items(SvrSharedRing* ring);
+
+// Called by the producer. Gives where up to max_items can be written and returns how many that is.
+// Returns 0 if the ring is full.
+s32 svr_shared_ring_begin_write(SvrSharedRing* ring, void** dest, s32 max_items);
+
+// Called by the producer. Makes the written items visible to the consumer.
+void svr_shared_ring_end_write(SvrSharedRing* ring, s32 num_items);
+
+// Called by the consumer. Gives where up to max_items can be read from and returns how many that is.
+// Returns 0 if the ring is empty.
+s32 svr_shared_ring_begin_read(SvrSharedRing* ring, void** src, s32 max_items);
+
+// Called by the consumer. Gives the read items back to the producer.
+void svr_shared_ring_end_read(SvrSharedRing* ring, s32 num_items);
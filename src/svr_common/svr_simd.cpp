@@ -0,0 +1,86 @@
+#include "svr_simd.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+
+static SvrSimdLevel svr_simd_detect()
+{
+    s32 regs[4];
+
+    __cpuid(regs, 0);
+    s32 max_leaf = regs[0];
+
+    __cpuid(regs, 1);
+
+    bool has_sse41 = (regs[2] & SVR_BIT(19)) != 0;
+    bool has_osxsave = (regs[2] & SVR_BIT(27)) != 0;
+    bool has_avx = (regs[2] & SVR_BIT(28)) != 0;
+
+    if (!has_sse41)
+    {
+        return SVR_SIMD_SCALAR;
+    }
+
+    // The operating system must save the upper halves of the registers too.
+    if (!has_osxsave || !has_avx || (_xgetbv(0) & 6) != 6 || max_leaf < 7)
+    {
+        return SVR_SIMD_SSE41;
+    }
+
+    __cpuidex(regs, 7, 0);
+
+    bool has_avx2 = (regs[1] & SVR_BIT(5)) != 0;
+
+    if (!has_avx2)
+    {
+        return SVR_SIMD_SSE41;
+    }
+
+    return SVR_SIMD_AVX2;
+}
+
+#else
+
+static SvrSimdLevel svr_simd_detect()
+{
+    // These also check that the operating system supports the registers.
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SVR_SIMD_AVX2;
+    }
+
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        return SVR_SIMD_SSE41;
+    }
+
+    return SVR_SIMD_SCALAR;
+}
+
+#endif
+
+SvrSimdLevel svr_simd_get_best_level()
+{
+    // Same result every time, so it does not matter if several threads do this at once.
+    static SvrSimdLevel level = -1;
+
+    if (level == -1)
+    {
+        level = svr_simd_detect();
+    }
+
+    return level;
+}
+
+const char* svr_simd_get_level_name(SvrSimdLevel level)
+{
+    switch (level)
+    {
+        case SVR_SIMD_SCALAR: return "scalar";
+        case SVR_SIMD_SSE41: return "SSE4.1";
+        case SVR_SIMD_AVX2: return "AVX2";
+    }
+
+    return "unknown";
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "svr_common.h"
+
+// Selection of SIMD code paths.
+// The programs are built for the base instruction set, so the faster paths are compiled per function and are only
+// picked at runtime if the processor supports them.
+
+using SvrSimdLevel = s32;
+
+enum /* SvrSimdLevel */
+{
+    SVR_SIMD_SCALAR, // Plain code that works everywhere. Used as the reference for the others.
+    SVR_SIMD_SSE41,
+    SVR_SIMD_AVX2,
+
+    SVR_SIMD_NUM_LEVELS,
+};
+
+// Mark functions that use instructions above the base instruction set.
+// MSVC allows all intrinsics everywhere, but GCC and Clang need to be told per function.
+#ifdef _MSC_VER
+#define SVR_TARGET_SSE41
+#define SVR_TARGET_AVX2
+#else
+#define SVR_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SVR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Returns the best level that the processor and the operating system support.
+SvrSimdLevel svr_simd_get_best_level();
+
+// Name of the level, for logging.
+const char* svr_simd_get_level_name(SvrSimdLevel level);
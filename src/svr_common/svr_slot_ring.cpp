@@ -0,0 +1,111 @@
+#include "svr_slot_ring.h"
+#include <assert.h>
+
+void svr_slot_ring_init(SvrSlotRing* ring, s32 num_slots)
+{
+    assert(num_slots > 0 && num_slots <= SVR_SLOT_RING_MAX_SLOTS);
+    assert((num_slots & (num_slots - 1)) == 0);
+
+    ring->mask = num_slots - 1;
+
+    svr_atom_store(&ring->stopped, 0);
+    svr_atom_store(&ring->write_seq, 0);
+    svr_atom_store(&ring->read_seq, 0);
+
+    for (s32 i = 0; i < SVR_SLOT_RING_MAX_SLOTS; i++)
+    {
+        svr_atom_store(&ring->slot_seqs[i], 0);
+    }
+}
+
+s32 svr_slot_ring_get_num_slots(SvrSlotRing* ring)
+{
+    return ring->mask + 1;
+}
+
+s32 svr_slot_ring_get_num_full(SvrSlotRing* ring)
+{
+    return (s32)((u32)svr_atom_load(&ring->write_seq) - (u32)svr_atom_load(&ring->read_seq));
+}
+
+bool svr_slot_ring_begin_write(SvrSlotRing* ring, s32* slot_idx)
+{
+    assert(svr_atom_load(&ring->stopped) == 0);
+
+    s32 w = svr_atom_load(&ring->write_seq);
+    s32 r = svr_atom_load(&ring->read_seq);
+
+    if ((u32)w - (u32)r > (u32)ring->mask)
+    {
+        return false; // Full.
+    }
+
+    *slot_idx = w & ring->mask;
+    return true;
+}
+
+void svr_slot_ring_end_write(SvrSlotRing* ring)
+{
+    s32 w = svr_atom_load(&ring->write_seq);
+
+    // The slot must be marked before the sequence is increased, because the consumer can read it right after.
+    svr_atom_store(&ring->slot_seqs[w & ring->mask], (s32)((u32)w + 1));
+    svr_atom_store(&ring->write_seq, (s32)((u32)w + 1));
+}
+
+void svr_slot_ring_stop(SvrSlotRing* ring)
+{
+    svr_atom_store(&ring->stopped, 1);
+}
+
+void svr_slot_ring_restart(SvrSlotRing* ring)
+{
+    assert(svr_slot_ring_get_num_full(ring) == 0);
+
+    svr_atom_store(&ring->stopped, 0);
+}
+
+bool svr_slot_ring_begin_read(SvrSlotRing* ring, s32* slot_idx, s32* seq)
+{
+    s32 r = svr_atom_load(&ring->read_seq);
+
+    if (r == svr_atom_load(&ring->write_seq))
+    {
+        return false; // Empty.
+    }
+
+    s32 idx = r & ring->mask;
+
+    // Can only be different if the producer does not follow the protocol.
+    if (svr_atom_load(&ring->slot_seqs[idx]) != (s32)((u32)r + 1))
+    {
+        assert(false);
+        return false;
+    }
+
+    *slot_idx = idx;
+
+    if (seq)
+    {
+        *seq = r;
+    }
+
+    return true;
+}
+
+void svr_slot_ring_end_read(SvrSlotRing* ring)
+{
+    s32 r = svr_atom_load(&ring->read_seq);
+    svr_atom_store(&ring->read_seq, (s32)((u32)r + 1));
+}
+
+bool svr_slot_ring_is_done(SvrSlotRing* ring)
+{
+    // Stopped must be checked first. A slot may be written after the check for empty, but not after the stop.
+    if (svr_atom_load(&ring->stopped) == 0)
+    {
+        return false;
+    }
+
+    return svr_atom_load(&ring->read_seq) == svr_atom_load(&ring->write_seq);
+}
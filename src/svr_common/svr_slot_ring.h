@@ -0,0 +1,72 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_atom.h"
+
+// Ownership of a fixed number of frame slots that one producer fills and one consumer reads.
+// The slots themselves are stored somewhere else (such as shared textures), this only keeps track of whose turn it is.
+// Everything is fixed size so the ring can be placed in memory that is shared between 32-bit and 64-bit processes.
+// Sequence numbers are free running 32-bit counters that are compared with unsigned differences.
+
+// Nothing here blocks. Waiting for a slot is up to the caller, since the way to wake the other side depends on where the ring is.
+
+// Usage for the producer:
+// svr_slot_ring_begin_write to get a free slot, fill it, then svr_slot_ring_end_write to give it to the consumer.
+// svr_slot_ring_stop once nothing more will be written.
+
+// Usage for the consumer:
+// svr_slot_ring_begin_read to get the oldest filled slot, read it, then svr_slot_ring_end_read to give it back.
+// svr_slot_ring_is_done tells when everything has been read after a stop.
+
+const s32 SVR_SLOT_RING_MAX_SLOTS = 16;
+
+struct SvrSlotRing
+{
+    s32 mask;
+    SvrAtom32 stopped; // Set by the producer when nothing more will be written.
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 write_seq; // Number of slots that the producer has filled.
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 read_seq; // Number of slots that the consumer has given back.
+
+    SVR_THREAD_PADDING();
+
+    // The sequence number that was last written to each slot, plus one so that 0 means never written.
+    // The consumer checks this so it can never read a slot that is still being filled.
+    SvrAtom32 slot_seqs[SVR_SLOT_RING_MAX_SLOTS];
+};
+
+// Must be called when neither side is using the ring. The number of slots must be a power of two.
+void svr_slot_ring_init(SvrSlotRing* ring, s32 num_slots);
+
+s32 svr_slot_ring_get_num_slots(SvrSlotRing* ring);
+
+// Only an estimate when called while the other side is working.
+s32 svr_slot_ring_get_num_full(SvrSlotRing* ring);
+
+// Called by the producer. Returns false if all slots are full.
+// The same slot is returned until svr_slot_ring_end_write is called.
+bool svr_slot_ring_begin_write(SvrSlotRing* ring, s32* slot_idx);
+
+// Called by the producer. Gives the slot from svr_slot_ring_begin_write to the consumer.
+void svr_slot_ring_end_write(SvrSlotRing* ring);
+
+// Called by the producer after the last slot has been written.
+void svr_slot_ring_stop(SvrSlotRing* ring);
+
+// Called by the producer to write again after a stop, once the consumer has read everything.
+// The sequence numbers continue from before, so a consumer that looks at the ring at this time sees it as empty.
+void svr_slot_ring_restart(SvrSlotRing* ring);
+
+// Called by the consumer. Returns false if there is nothing to read.
+// The sequence number of the slot is written to seq if it is not NULL, which tells how many slots were written before it.
+bool svr_slot_ring_begin_read(SvrSlotRing* ring, s32* slot_idx, s32* seq);
+
+// Called by the consumer. Gives the slot from svr_slot_ring_begin_read back to the producer.
+void svr_slot_ring_end_read(SvrSlotRing* ring);
+
+// Called by the consumer. True when the producer has stopped and every slot has been read.
+bool svr_slot_ring_is_done(SvrSlotRing* ring);
@@ -0,0 +1,119 @@
+#include "svr_stats.h"
+#include "svr_thread.h"
+#include <string.h>
+#include <assert.h>
+
+// Tries to copy a part before giving up. A writer only holds a part for a few stores, so this is never reached unless it has stopped.
+// The reader gives its time away while a part is held, since the writer may have been switched out in the middle and needs the core to finish.
+const s32 STATS_READ_TRIES = 1000;
+
+// How much a new time counts in the moving averages. The average mostly covers the last 16 values.
+const double STATS_AVERAGE_WEIGHT = 1.0 / 16.0;
+
+void svr_stats_init(SvrStatsBlock* block, u32 game_pid)
+{
+    memset(block, 0, sizeof(SvrStatsBlock));
+
+    block->header.version = SVR_STATS_VERSION;
+    block->header.size = sizeof(SvrStatsBlock);
+    block->header.game_pid = game_pid;
+
+    // Readers check the magic first, so it is set last.
+    svr_atom_store((SvrAtom32*)&block->header.magic, (s32)SVR_STATS_MAGIC);
+}
+
+bool svr_stats_check(const void* mem, s32 size)
+{
+    if (size < (s32)sizeof(SvrStatsHeader))
+    {
+        return false;
+    }
+
+    SvrStatsHeader* header = (SvrStatsHeader*)mem;
+
+    if (svr_atom_load((SvrAtom32*)&header->magic) != (s32)SVR_STATS_MAGIC)
+    {
+        return false;
+    }
+
+    return header->version == SVR_STATS_VERSION && header->size == sizeof(SvrStatsBlock) && size >= (s32)sizeof(SvrStatsBlock);
+}
+
+// The sequence number is the first member of every part.
+// The stores of a part stay between the odd and the even number, and the loads of a reader stay between its two loads of the number.
+
+static void stats_write_part(void* part, const void* src, s32 size)
+{
+    SvrAtom32* seq = (SvrAtom32*)part;
+    s32 skip = sizeof(SvrAtom32);
+
+    svr_atom_store(seq, seq->v + 1);
+    svr_atom_barrier();
+
+    memcpy((u8*)part + skip, (const u8*)src + skip, size - skip);
+
+    svr_atom_barrier();
+    svr_atom_store(seq, seq->v + 1);
+}
+
+static bool stats_read_part(void* part, void* dest, s32 size)
+{
+    SvrAtom32* seq = (SvrAtom32*)part;
+
+    for (s32 i = 0; i < STATS_READ_TRIES; i++)
+    {
+        s32 before = svr_atom_load(seq);
+
+        if (before & 1)
+        {
+            svr_thread_yield();
+            continue;
+        }
+
+        svr_atom_barrier();
+        memcpy(dest, part, size);
+        svr_atom_barrier();
+
+        if (svr_atom_load(seq) == before)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void svr_stats_write_game(SvrStatsBlock* block, const SvrStatsGame* src)
+{
+    stats_write_part(&block->game, src, sizeof(SvrStatsGame));
+}
+
+void svr_stats_write_encoder(SvrStatsBlock* block, s32 idx, const SvrStatsEncoder* src)
+{
+    assert(idx >= 0 && idx < SVR_STATS_MAX_ENCODERS);
+
+    stats_write_part(&block->encoders[idx], src, sizeof(SvrStatsEncoder));
+}
+
+bool svr_stats_read_game(SvrStatsBlock* block, SvrStatsGame* dest)
+{
+    return stats_read_part(&block->game, dest, sizeof(SvrStatsGame));
+}
+
+bool svr_stats_read_encoder(SvrStatsBlock* block, s32 idx, SvrStatsEncoder* dest)
+{
+    assert(idx >= 0 && idx < SVR_STATS_MAX_ENCODERS);
+
+    return stats_read_part(&block->encoders[idx], dest, sizeof(SvrStatsEncoder));
+}
+
+void svr_stats_add_time(double* avg, double time)
+{
+    if (*avg == 0.0)
+    {
+        *avg = time;
+        return;
+    }
+
+    *avg += (time - *avg) * STATS_AVERAGE_WEIGHT;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_atom.h"
+
+// Live statistics of the movie that is being made, for tools such as svr_monitor to show while it renders.
+// The block is named shared memory that svr_game creates. svr_game and every svr_encoder write their own part of it.
+// Every part has a sequence number that is odd while the part is being written. Writers never wait for readers,
+// and readers copy the part again if the number changed while they copied it.
+// Everything has a fixed size and there is no padding, so the layout is the same in 32-bit and 64-bit and on every platform.
+// The version must be increased when anything in the layout changes.
+
+const char* const SVR_STATS_MEM_NAME = "svr_stats";
+const u32 SVR_STATS_MAGIC = 0x54535653; // "SVST".
+const u32 SVR_STATS_VERSION = 1;
+const s32 SVR_STATS_MAX_ENCODERS = 4; // Same as the max number of movies that svr_game can make at once.
+
+using SvrStatsState = s32;
+
+enum /* SvrStatsState */
+{
+    SVR_STATS_STATE_IDLE, // No movie. The numbers are from the last movie.
+    SVR_STATS_STATE_RENDERING,
+};
+
+// Moving averages of where the time goes in svr_game, in microseconds for every game frame.
+using SvrStatsGameStage = s32;
+
+enum /* SvrStatsGameStage */
+{
+    SVR_STATS_GAME_STAGE_GAME, // From the end of one svr_frame to the start of the next, which is the game making its frame.
+    SVR_STATS_GAME_STAGE_PROCESS, // Everything in svr_frame, such as motion blur and velo.
+    SVR_STATS_GAME_STAGE_SEND, // Giving frames to svr_encoder, which is mostly waiting for a free slot when svr_encoder is behind.
+    SVR_STATS_GAME_NUM_STAGES,
+};
+
+// Moving averages of where the time goes in svr_encoder, in microseconds for every frame or packet.
+using SvrStatsEncoderStage = s32;
+
+enum /* SvrStatsEncoderStage */
+{
+    SVR_STATS_ENCODER_STAGE_CONVERT, // Converting a game texture to the pixel format of the encoder on the GPU.
+    SVR_STATS_ENCODER_STAGE_DOWNLOAD, // Downloading a converted frame from the GPU.
+    SVR_STATS_ENCODER_STAGE_ENCODE, // Encoding a video frame. Several frames can be encoded at once with the video workers.
+    SVR_STATS_ENCODER_STAGE_WRITE, // Writing a packet of any stream to the movie file.
+    SVR_STATS_ENCODER_NUM_STAGES,
+};
+
+struct SvrStatsHeader
+{
+    u32 magic;
+    u32 version;
+    u32 size; // Of the whole block.
+    u32 game_pid;
+};
+
+// Written by svr_game.
+struct SvrStatsGame
+{
+    SvrAtom32 seq;
+    SvrStatsState state;
+    s32 num_encoders; // Movies that are made at once.
+    s32 video_fps;
+    s32 game_rate; // Game frames per second of video time.
+    s32 reserved;
+
+    // Times are from svr_prof_get_real_time, which is the same clock in every process.
+    s64 start_time;
+    s64 update_time;
+    s64 finish_time; // Estimated time of the last video frame, or 0 if the length of the movie is not known.
+
+    s64 game_frames; // svr_frame calls.
+    s64 video_frames; // Frames given to the first svr_encoder.
+    s64 audio_samples;
+    s64 movie_frames; // Length of the movie in video frames, or 0 if not known.
+
+    double frame_interval; // Moving average of microseconds between video frames, which sets how fast the movie renders.
+    double stage_times[SVR_STATS_GAME_NUM_STAGES];
+};
+
+// Written by one svr_encoder.
+struct SvrStatsEncoder
+{
+    SvrAtom32 seq;
+    SvrStatsState state;
+    char movie_name[128];
+
+    s64 update_time;
+
+    // The frame counts are in the order that the frames go through svr_encoder.
+    s64 frames_received; // Read from the video ring and converted.
+    s64 frames_downloaded;
+    s64 frames_encoded;
+    s64 frames_written; // Video packets written to the movie file.
+    s64 bytes_written;
+    s64 audio_samples;
+
+    // Number of items waiting in the queues between the threads.
+    s32 download_queue; // Converted textures that are not downloaded yet.
+    s32 encode_queue; // Video frames that are waiting to be encoded.
+    s32 audio_queue; // Audio buffers that are waiting to be converted.
+    s32 packet_queue; // Packets that are waiting to be written.
+
+    // Memory for frames and packets, in bytes.
+    s64 pool_used;
+    s64 pool_peak;
+    s64 pool_budget;
+    s32 pool_num_waits; // Times a frame had to wait for memory.
+    s32 reserved;
+
+    double stage_times[SVR_STATS_ENCODER_NUM_STAGES];
+};
+
+struct SvrStatsBlock
+{
+    SvrStatsHeader header;
+    SvrStatsGame game;
+    SvrStatsEncoder encoders[SVR_STATS_MAX_ENCODERS];
+};
+
+// Sets up a new block. Must be called before any part is written.
+void svr_stats_init(SvrStatsBlock* block, u32 game_pid);
+
+// Returns if the memory has a block of this version. Must be checked before reading anything else.
+bool svr_stats_check(const void* mem, s32 size);
+
+// Copies a whole part into the block. Every part must only be written by one thread. The sequence number of the source is not used.
+void svr_stats_write_game(SvrStatsBlock* block, const SvrStatsGame* src);
+void svr_stats_write_encoder(SvrStatsBlock* block, s32 idx, const SvrStatsEncoder* src);
+
+// Copies a part that is written at the same time by another process.
+// Returns false if the part was being changed during every try, which only happens if a writer has stopped in the middle.
+bool svr_stats_read_game(SvrStatsBlock* block, SvrStatsGame* dest);
+bool svr_stats_read_encoder(SvrStatsBlock* block, s32 idx, SvrStatsEncoder* dest);
+
+// Adds a time to a moving average, where the last few values count the most. The first value is taken as it is.
+void svr_stats_add_time(double* avg, double time);
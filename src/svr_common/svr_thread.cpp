@@ -0,0 +1,128 @@
+#include "svr_thread.h"
+#include "svr_alloc.h"
+
+#ifndef _WIN32
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#include <sched.h>
+#endif
+
+// What the new thread should call. Freed by the thread when it has started.
+struct SvrThreadStart
+{
+    SvrThreadFn fn;
+    void* param;
+};
+
+static void svr_thread_run(SvrThreadStart* start)
+{
+    SvrThreadStart copy = *start;
+    svr_free(start);
+
+    copy.fn(copy.param);
+}
+
+#ifdef _WIN32
+
+static DWORD CALLBACK svr_thread_proc(LPVOID param)
+{
+    svr_thread_run((SvrThreadStart*)param);
+    return 0; // Not used.
+}
+
+bool svr_thread_start(SvrThread* thread, SvrThreadFn fn, void* param)
+{
+    SvrThreadStart* start = SVR_ZALLOC(SvrThreadStart);
+    start->fn = fn;
+    start->param = param;
+
+    thread->handle = CreateThread(NULL, 0, svr_thread_proc, start, 0, NULL);
+
+    if (thread->handle == NULL)
+    {
+        svr_free(start);
+        return false;
+    }
+
+    return true;
+}
+
+void svr_thread_join(SvrThread* thread)
+{
+    if (thread->handle)
+    {
+        WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+        CloseHandle((HANDLE)thread->handle);
+        thread->handle = NULL;
+    }
+}
+
+u32 svr_thread_get_current_id()
+{
+    return GetCurrentThreadId();
+}
+
+void svr_thread_sleep(s32 ms)
+{
+    Sleep(ms);
+}
+
+void svr_thread_yield()
+{
+    SwitchToThread();
+}
+
+#else
+
+static void* svr_thread_proc(void* param)
+{
+    svr_thread_run((SvrThreadStart*)param);
+    return NULL;
+}
+
+bool svr_thread_start(SvrThread* thread, SvrThreadFn fn, void* param)
+{
+    SvrThreadStart* start = SVR_ZALLOC(SvrThreadStart);
+    start->fn = fn;
+    start->param = param;
+
+    pthread_t thread_h;
+
+    if (pthread_create(&thread_h, NULL, svr_thread_proc, start) != 0)
+    {
+        svr_free(start);
+        thread->handle = NULL;
+        return false;
+    }
+
+    thread->handle = (void*)thread_h;
+    return true;
+}
+
+void svr_thread_join(SvrThread* thread)
+{
+    if (thread->handle)
+    {
+        pthread_join((pthread_t)thread->handle, NULL);
+        thread->handle = NULL;
+    }
+}
+
+u32 svr_thread_get_current_id()
+{
+    return (u32)syscall(SYS_gettid);
+}
+
+void svr_thread_sleep(s32 ms)
+{
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+void svr_thread_yield()
+{
+    sched_yield();
+}
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+#include "svr_common.h"
+
+// Threads and locks for code that is built on several platforms.
+// Windows uses its own threads and slim reader/writer locks, other platforms use pthreads.
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#endif
+
+using SvrThreadFn = void(*)(void* param);
+
+struct SvrThread
+{
+    void* handle; // Thread handle on Windows, pthread_t on other platforms. NULL when not started.
+};
+
+// Zero initialized memory is an unlocked lock, so locks in zeroed structures don't have to be set up.
+struct SvrLock
+{
+#ifdef _WIN32
+    SRWLOCK srw;
+#else
+    pthread_mutex_t mutex;
+#endif
+};
+
+// Starts a thread that calls fn with param. Returns false if the thread could not be created.
+bool svr_thread_start(SvrThread* thread, SvrThreadFn fn, void* param);
+
+// Waits for the thread to exit and frees it. Does nothing if the thread was not started.
+void svr_thread_join(SvrThread* thread);
+
+u32 svr_thread_get_current_id();
+
+void svr_thread_sleep(s32 ms);
+
+// Gives the rest of the time slice to another thread that is ready to run.
+void svr_thread_yield();
+
+inline void svr_lock_acquire(SvrLock* lock)
+{
+#ifdef _WIN32
+    AcquireSRWLockExclusive(&lock->srw);
+#else
+    pthread_mutex_lock(&lock->mutex);
+#endif
+}
+
+inline void svr_lock_release(SvrLock* lock)
+{
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(&lock->srw);
+#else
+    pthread_mutex_unlock(&lock->mutex);
+#endif
+}
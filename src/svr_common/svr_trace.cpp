@@ -0,0 +1,461 @@
+#include "svr_trace.h"
+#include "svr_atom.h"
+#include "svr_alloc.h"
+#include <string.h>
+#include <stdarg.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+// Every thread takes one of the buffers the first time it records something in a trace, and keeps it until the trace is stopped.
+// The buffers are lists of chunks that are kept between traces and only grow when a thread records more than it did before.
+// Only the thread that owns a buffer writes to it. The count of every chunk is stored after its event is written, so a reader never sees half an event.
+
+const s32 TRACE_MAX_THREADS = 64;
+const s32 TRACE_CHUNK_EVENTS = 16384;
+const s32 TRACE_MAX_CHUNKS = 256; // About 100 MB for a thread that uses all of them.
+
+struct TraceChunk
+{
+    TraceChunk* next;
+    SvrAtom32 num_events;
+    SvrTraceEvent events[TRACE_CHUNK_EVENTS];
+};
+
+struct TraceThread
+{
+    u32 thread_id;
+    const char* name;
+    TraceChunk* first;
+    TraceChunk* cur; // Chunk that is written to, or NULL if nothing has been written yet.
+    s32 num_chunks;
+    s64 num_dropped;
+};
+
+bool svr_trace_active;
+
+TraceThread trace_threads[TRACE_MAX_THREADS];
+SvrAtom32 trace_num_threads; // Can go above the max when there are more threads.
+SvrAtom32 trace_session; // Increased for every trace, so the threads know that they have to take a new buffer.
+SvrAtom64 trace_num_lost; // Events from the threads above the max.
+
+thread_local TraceThread* trace_cur_thread;
+thread_local s32 trace_cur_session;
+thread_local const char* trace_cur_thread_name;
+
+static u32 trace_get_thread_id()
+{
+#ifdef _WIN32
+    return GetCurrentThreadId();
+#else
+    return (u32)syscall(SYS_gettid);
+#endif
+}
+
+static u32 trace_get_process_id()
+{
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return (u32)getpid();
+#endif
+}
+
+void svr_trace_start()
+{
+    svr_atom_store(&trace_num_threads, 0);
+    svr_atom_store(&trace_num_lost, 0);
+    svr_atom_add(&trace_session, 1);
+
+    svr_trace_active = true;
+}
+
+void svr_trace_stop()
+{
+    svr_trace_active = false;
+}
+
+void svr_trace_free()
+{
+    svr_trace_active = false;
+
+    for (s32 i = 0; i < TRACE_MAX_THREADS; i++)
+    {
+        TraceChunk* chunk = trace_threads[i].first;
+
+        while (chunk)
+        {
+            TraceChunk* next = chunk->next;
+            svr_free(chunk);
+            chunk = next;
+        }
+
+        trace_threads[i] = {};
+    }
+
+    // The threads must not use the buffers they had.
+    svr_atom_store(&trace_num_threads, 0);
+    svr_atom_add(&trace_session, 1);
+}
+
+void svr_trace_set_thread_name(const char* name)
+{
+    trace_cur_thread_name = name;
+}
+
+// Returns the buffer of the calling thread in this trace, or NULL if there are too many threads.
+static TraceThread* trace_get_thread()
+{
+    s32 session = svr_atom_load(&trace_session);
+
+    if (trace_cur_session == session)
+    {
+        return trace_cur_thread;
+    }
+
+    trace_cur_session = session;
+    trace_cur_thread = NULL;
+
+    s32 idx = svr_atom_add(&trace_num_threads, 1);
+
+    if (idx >= TRACE_MAX_THREADS)
+    {
+        return NULL;
+    }
+
+    TraceThread* thread = &trace_threads[idx];
+    thread->thread_id = trace_get_thread_id();
+    thread->name = trace_cur_thread_name;
+    thread->cur = NULL;
+    thread->num_dropped = 0;
+
+    for (TraceChunk* chunk = thread->first; chunk; chunk = chunk->next)
+    {
+        svr_atom_store(&chunk->num_events, 0);
+    }
+
+    trace_cur_thread = thread;
+    return thread;
+}
+
+// Moves on to the next chunk of the thread, which is allocated if the thread has not used this many before.
+static TraceChunk* trace_next_chunk(TraceThread* thread)
+{
+    TraceChunk* next = thread->cur ? thread->cur->next : thread->first;
+
+    if (next == NULL)
+    {
+        if (thread->num_chunks == TRACE_MAX_CHUNKS)
+        {
+            return NULL;
+        }
+
+        next = (TraceChunk*)svr_alloc(sizeof(TraceChunk));
+        next->next = NULL;
+        next->num_events.v = 0;
+
+        if (thread->cur)
+        {
+            thread->cur->next = next;
+        }
+
+        else
+        {
+            thread->first = next;
+        }
+
+        thread->num_chunks++;
+    }
+
+    thread->cur = next;
+    return next;
+}
+
+static void trace_add_event(const char* name, s64 time, s64 value, SvrTraceEventType type)
+{
+    TraceThread* thread = trace_get_thread();
+
+    if (thread == NULL)
+    {
+        svr_atom_add(&trace_num_lost, 1);
+        return;
+    }
+
+    // Only this thread changes the count, so it does not have to be loaded as an atom.
+    TraceChunk* chunk = thread->cur;
+    s32 num = chunk ? chunk->num_events.v : TRACE_CHUNK_EVENTS;
+
+    if (num == TRACE_CHUNK_EVENTS)
+    {
+        chunk = trace_next_chunk(thread);
+
+        if (chunk == NULL)
+        {
+            thread->num_dropped++;
+            return;
+        }
+
+        num = 0;
+    }
+
+    SvrTraceEvent* event = &chunk->events[num];
+    event->name = name;
+    event->time = time;
+    event->value = value;
+    event->type = type;
+
+    svr_atom_store(&chunk->num_events, num + 1);
+}
+
+void svr_trace_add_scope(const char* name, s64 start, s64 duration)
+{
+    trace_add_event(name, start, duration, SVR_TRACE_EVENT_SCOPE);
+}
+
+void svr_trace_add_counter(const char* name, s64 value)
+{
+    trace_add_event(name, svr_prof_get_real_time(), value, SVR_TRACE_EVENT_COUNTER);
+}
+
+static s32 trace_get_num_threads()
+{
+    return svr_min(svr_atom_load(&trace_num_threads), TRACE_MAX_THREADS);
+}
+
+static void trace_append(SvrDynArray<char>* dest, const char* format, ...)
+{
+    char buf[512];
+
+    va_list va;
+    va_start(va, format);
+    s32 len = SVR_VSNPRINTF(buf, format, va);
+    va_end(va);
+
+    len = svr_min(len, SVR_ARRAY_SIZE(buf) - 1);
+    dest->insert_range(dest->size, buf, len);
+}
+
+// Appends a name as a JSON string, since names can come from outside such as the name of a movie.
+// Characters that JSON does not allow in strings are escaped, and the name can be of any length.
+static void trace_append_string(SvrDynArray<char>* dest, const char* str)
+{
+    dest->push('"');
+
+    for (const char* ptr = str; *ptr; ptr++)
+    {
+        u8 c = (u8)*ptr;
+
+        if (c == '"' || c == '\\')
+        {
+            dest->push('\\');
+            dest->push((char)c);
+        }
+
+        else if (c < 0x20)
+        {
+            trace_append(dest, "\\u%04x", c);
+        }
+
+        else
+        {
+            dest->push((char)c);
+        }
+    }
+
+    dest->push('"');
+}
+
+void svr_trace_write_json(const char* process_name, SvrDynArray<char>* dest)
+{
+    u32 pid = trace_get_process_id();
+    s32 num_threads = trace_get_num_threads();
+
+    trace_append(dest, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    trace_append(dest, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":", pid);
+    trace_append_string(dest, process_name);
+    trace_append(dest, "}}");
+
+    for (s32 i = 0; i < num_threads; i++)
+    {
+        TraceThread* thread = &trace_threads[i];
+
+        if (thread->name)
+        {
+            trace_append(dest, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":", pid, thread->thread_id);
+            trace_append_string(dest, thread->name);
+            trace_append(dest, "}}");
+        }
+
+        for (TraceChunk* chunk = thread->first; chunk; chunk = chunk->next)
+        {
+            s32 num_events = svr_atom_load(&chunk->num_events);
+
+            for (s32 j = 0; j < num_events; j++)
+            {
+                SvrTraceEvent* event = &chunk->events[j];
+
+                switch (event->type)
+                {
+                    case SVR_TRACE_EVENT_SCOPE:
+                    {
+                        trace_append(dest, ",\n{\"name\":");
+                        trace_append_string(dest, event->name);
+                        trace_append(dest, ",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%lld,\"dur\":%lld}", pid, thread->thread_id, event->time, event->value);
+                        break;
+                    }
+
+                    case SVR_TRACE_EVENT_COUNTER:
+                    {
+                        trace_append(dest, ",\n{\"name\":");
+                        trace_append_string(dest, event->name);
+                        trace_append(dest, ",\"ph\":\"C\",\"pid\":%u,\"tid\":%u,\"ts\":%lld,\"args\":{\"value\":%lld}}", pid, thread->thread_id, event->time, event->value);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    trace_append(dest, "\n]}\n");
+}
+
+void svr_trace_get_stages(SvrDynArray<SvrTraceStage>* dest)
+{
+    s32 num_threads = trace_get_num_threads();
+
+    for (s32 i = 0; i < num_threads; i++)
+    {
+        TraceThread* thread = &trace_threads[i];
+
+        for (TraceChunk* chunk = thread->first; chunk; chunk = chunk->next)
+        {
+            s32 num_events = svr_atom_load(&chunk->num_events);
+            SvrTraceStage* stage = NULL;
+
+            for (s32 j = 0; j < num_events; j++)
+            {
+                SvrTraceEvent* event = &chunk->events[j];
+
+                if (event->type != SVR_TRACE_EVENT_SCOPE)
+                {
+                    continue;
+                }
+
+                // Most scopes come after one of the same name, and the same name is usually the same string.
+                if (stage == NULL || (stage->name != event->name && strcmp(stage->name, event->name)))
+                {
+                    stage = NULL;
+
+                    for (s32 k = 0; k < dest->size; k++)
+                    {
+                        if (!strcmp(dest->mem[k].name, event->name))
+                        {
+                            stage = &dest->mem[k];
+                            break;
+                        }
+                    }
+
+                    if (stage == NULL)
+                    {
+                        stage = dest->emplace_zero();
+                        stage->name = event->name;
+                    }
+                }
+
+                svr_prof_histogram_add(&stage->hist, event->value);
+            }
+        }
+    }
+}
+
+void svr_trace_write_stages(SvrDynArray<char>* dest)
+{
+    SvrDynArray<SvrTraceStage> stages = {};
+    svr_trace_get_stages(&stages);
+
+    trace_append(dest, "%-40s %10s %10s %10s %10s %10s %10s\n", "Stage (microseconds)", "Runs", "Average", "p50", "p90", "p99", "Max");
+
+    for (s32 i = 0; i < stages.size; i++)
+    {
+        SvrTraceStage* stage = &stages[i];
+        SvrProfHistogram* hist = &stage->hist;
+
+        trace_append(dest, "%-40s %10lld %10lld %10lld %10lld %10lld %10lld\n", stage->name, hist->runs, hist->total / hist->runs,
+                     svr_prof_histogram_get_percentile(hist, 50), svr_prof_histogram_get_percentile(hist, 90),
+                     svr_prof_histogram_get_percentile(hist, 99), hist->max);
+    }
+
+    s64 num_dropped = svr_trace_get_num_dropped();
+
+    if (num_dropped > 0)
+    {
+        trace_append(dest, "\n%lld events did not fit and are missing\n", num_dropped);
+    }
+
+    stages.free();
+}
+
+static bool trace_write_file(const char* path, SvrDynArray<char>* data)
+{
+    FILE* f = fopen(path, "wb");
+
+    if (f == NULL)
+    {
+        return false;
+    }
+
+    bool ret = fwrite(data->mem, 1, data->size, f) == (size_t)data->size;
+    fclose(f);
+
+    return ret;
+}
+
+bool svr_trace_save(const char* path, const char* process_name)
+{
+    bool ret = false;
+    SvrDynArray<char> data = {};
+    char full_path[512];
+
+    svr_trace_write_json(process_name, &data);
+    SVR_SNPRINTF(full_path, "%s.json", path);
+
+    if (!trace_write_file(full_path, &data))
+    {
+        goto rfail;
+    }
+
+    data.size = 0;
+    svr_trace_write_stages(&data);
+    SVR_SNPRINTF(full_path, "%s.txt", path);
+
+    if (!trace_write_file(full_path, &data))
+    {
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    data.free();
+    return ret;
+}
+
+s64 svr_trace_get_num_dropped()
+{
+    s64 ret = svr_atom_load(&trace_num_lost);
+    s32 num_threads = trace_get_num_threads();
+
+    for (s32 i = 0; i < num_threads; i++)
+    {
+        ret += trace_threads[i].num_dropped;
+    }
+
+    return ret;
+}
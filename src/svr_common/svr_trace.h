@@ -0,0 +1,92 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_array.h"
+#include "svr_prof.h"
+
+// Timeline of what the threads of a module did during a movie, saved as a Chrome trace that can be opened in ui.perfetto.dev or chrome://tracing.
+// Every thread records into its own buffer, so recording never takes a lock or waits for another thread.
+// Nothing is recorded unless a trace is started, and then the scopes and counters only cost a branch.
+// The times are from svr_prof_get_real_time, which is the same clock in every process, so the traces of svr_game, svr_standalone
+// and svr_encoder line up with each other and can be merged.
+
+using SvrTraceEventType = s32;
+
+enum /* SvrTraceEventType */
+{
+    SVR_TRACE_EVENT_SCOPE, // Time is the start and value is the duration.
+    SVR_TRACE_EVENT_COUNTER, // Value is what the counter was at the time.
+};
+
+struct SvrTraceEvent
+{
+    const char* name; // Must be a string that is never freed.
+    s64 time; // Microseconds.
+    s64 value;
+    SvrTraceEventType type;
+};
+
+// Every scope of the same name is a stage, and its durations are summed up here.
+struct SvrTraceStage
+{
+    const char* name;
+    SvrProfHistogram hist;
+};
+
+extern bool svr_trace_active; // Only to be read by the macros below.
+
+// Starts recording, and forgets the events of the last trace.
+// Must be called when no other thread of the module is recording.
+void svr_trace_start();
+
+// Stops recording. The events can be read after this once the threads of the module have finished their work.
+void svr_trace_stop();
+
+// Frees the buffers of all threads.
+void svr_trace_free();
+
+// Name shown for the calling thread. Should be set when the thread starts, before anything is recorded.
+void svr_trace_set_thread_name(const char* name);
+
+void svr_trace_add_scope(const char* name, s64 start, s64 duration);
+void svr_trace_add_counter(const char* name, s64 value);
+
+// Writes the events of the last trace as Chrome trace JSON. The process name is shown for every thread of this module.
+void svr_trace_write_json(const char* process_name, SvrDynArray<char>* dest);
+
+// Histograms of the durations of every stage of the last trace, in the order they were first seen.
+void svr_trace_get_stages(SvrDynArray<SvrTraceStage>* dest);
+
+// Writes a table of the percentiles of every stage of the last trace.
+void svr_trace_write_stages(SvrDynArray<char>* dest);
+
+// Saves the last trace to the path with .json added, and the table of the stages to the path with .txt added.
+bool svr_trace_save(const char* path, const char* process_name);
+
+// Returns how many events did not fit. Threads stop recording when they have used up their buffer, and threads above the max are not recorded.
+s64 svr_trace_get_num_dropped();
+
+struct SvrTraceScope
+{
+    const char* name;
+    s64 start;
+
+    inline SvrTraceScope(const char* in_name)
+    {
+        name = in_name;
+        start = svr_trace_active ? svr_prof_get_real_time() : -1;
+    }
+
+    inline ~SvrTraceScope()
+    {
+        if (start >= 0)
+        {
+            svr_trace_add_scope(name, start, svr_prof_get_real_time() - start);
+        }
+    }
+};
+
+// Records the time from here to the end of the enclosing block.
+#define SVR_TRACE_SCOPE(NAME) SvrTraceScope SVR_CAT(trace_scope_, __LINE__)(NAME)
+
+// Records the value of a counter, such as how many items are in a queue. The value is only evaluated when recording.
+#define SVR_TRACE_COUNTER(NAME, VALUE) do { if (svr_trace_active) svr_trace_add_counter((NAME), (s64)(VALUE)); } while (0)
@@ -0,0 +1,132 @@
+#include "svr_wave.h"
+#include <string.h>
+#include <immintrin.h>
+#include <assert.h>
+
+// Both channels are converted the same way, so the samples are worked on as a flat array of values.
+
+// --------------------------------------------------------------------------------------------------------------------
+// Scalar level.
+
+static void wave_convert_s32_scalar(const s32* src, s16* dest, s32 i, s32 num_values)
+{
+    for (; i < num_values; i++)
+    {
+        s32 v = src[i];
+        svr_clamp(&v, (s32)INT16_MIN, (s32)INT16_MAX);
+        dest[i] = (s16)v;
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// SSE4.1 level.
+// 8 values at a time. Returns the value where the scalar level should continue.
+
+SVR_TARGET_SSE41 static s32 wave_convert_s32_sse41(const s32* src, s16* dest, s32 i, s32 num_values)
+{
+    for (; i + 8 <= num_values; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((__m128i*)(src + i));
+        __m128i b = _mm_loadu_si128((__m128i*)(src + i + 4));
+
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(a, b));
+    }
+
+    return i;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// AVX2 level.
+// 16 values at a time. The pack works within the 128-bit lanes, so the middle quarters are swapped after.
+// Returns the value where the scalar level should continue.
+
+SVR_TARGET_AVX2 static s32 wave_convert_s32_avx2(const s32* src, s16* dest, s32 i, s32 num_values)
+{
+    for (; i + 16 <= num_values; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256((__m256i*)(src + i));
+        __m256i b = _mm256_loadu_si256((__m256i*)(src + i + 8));
+
+        __m256i packed = _mm256_packs_epi32(a, b);
+        packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+
+        _mm256_storeu_si256((__m256i*)(dest + i), packed);
+    }
+
+    return i;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+s32 svr_wave_get_sample_size(SvrWaveFormat format)
+{
+    switch (format)
+    {
+        case SVR_WAVE_FORMAT_S16: return sizeof(SvrWaveS16);
+        case SVR_WAVE_FORMAT_S32: return sizeof(SvrWaveS32);
+    }
+
+    assert(false);
+    return 0;
+}
+
+void svr_wave_convert(const void* src, SvrWaveFormat format, SvrWaveS16* dest, s32 num_samples, SvrSimdLevel level)
+{
+    switch (format)
+    {
+        case SVR_WAVE_FORMAT_S16:
+        {
+            memcpy(dest, src, sizeof(SvrWaveS16) * num_samples);
+            break;
+        }
+
+        case SVR_WAVE_FORMAT_S32:
+        {
+            const s32* values = (const s32*)src;
+            s16* dest_values = (s16*)dest;
+            s32 num_values = num_samples * 2;
+            s32 i = 0;
+
+            if (level >= SVR_SIMD_AVX2)
+            {
+                i = wave_convert_s32_avx2(values, dest_values, i, num_values);
+            }
+
+            if (level >= SVR_SIMD_SSE41)
+            {
+                i = wave_convert_s32_sse41(values, dest_values, i, num_values);
+            }
+
+            wave_convert_s32_scalar(values, dest_values, i, num_values);
+            break;
+        }
+    }
+}
+
+s32 svr_wave_write_ring(SvrSharedRing* ring, const void* src, SvrWaveFormat format, s32 num_samples, SvrSimdLevel level)
+{
+    assert(ring->item_size == sizeof(SvrWaveS16));
+
+    const u8* src_bytes = (const u8*)src;
+    s32 sample_size = svr_wave_get_sample_size(format);
+    s32 num_written = 0;
+
+    // The free space is given up to the end of the storage, so this takes two turns when it wraps around.
+    while (num_written < num_samples)
+    {
+        void* dest;
+        s32 num_free = svr_shared_ring_begin_write(ring, &dest, num_samples - num_written);
+
+        if (num_free == 0)
+        {
+            break;
+        }
+
+        svr_wave_convert(src_bytes + sample_size * num_written, format, (SvrWaveS16*)dest, num_free, level);
+        svr_shared_ring_end_write(ring, num_free);
+
+        num_written += num_free;
+    }
+
+    return num_written;
+}
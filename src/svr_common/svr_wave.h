@@ -0,0 +1,38 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_simd.h"
+#include "svr_shared_ring.h"
+
+// Conversion of stereo samples to the 16 bit samples that are encoded.
+// The conversion writes straight into where the samples are kept, so no buffer is needed in between.
+// The sample types have the same layout as SvrWaveSample and SvrWaveSample32 of svr_api.h, which is Windows only.
+
+struct SvrWaveS16
+{
+    s16 l;
+    s16 r;
+};
+
+struct SvrWaveS32
+{
+    s32 l;
+    s32 r;
+};
+
+using SvrWaveFormat = s32;
+
+enum /* SvrWaveFormat */
+{
+    SVR_WAVE_FORMAT_S16, // SvrWaveS16.
+    SVR_WAVE_FORMAT_S32, // SvrWaveS32, such as a mix that has not been clipped yet.
+};
+
+s32 svr_wave_get_sample_size(SvrWaveFormat format);
+
+// Converts samples to 16 bit. Values outside of 16 bits are clipped to the nearest end instead of wrapping around.
+// The source and destination can have any alignment. All levels give the same result as the scalar level.
+void svr_wave_convert(const void* src, SvrWaveFormat format, SvrWaveS16* dest, s32 num_samples, SvrSimdLevel level);
+
+// Converts samples into a shared ring of SvrWaveS16 until the ring is full, also across the end of the storage.
+// Returns how many samples were written, which is less than num_samples if the ring became full.
+s32 svr_wave_write_ring(SvrSharedRing* ring, const void* src, SvrWaveFormat format, s32 num_samples, SvrSimdLevel level);
@@ -0,0 +1,216 @@
+#include "svr_work_pool.h"
+#include "svr_atom.h"
+#include "svr_alloc.h"
+#include "svr_doorbell.h"
+#include "svr_trace.h"
+#include "svr_thread.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+struct SvrWorkThread
+{
+    SvrWorkPool* pool;
+    SvrThread thread;
+};
+
+struct SvrWorkPool
+{
+    SvrWorkThread* threads;
+    s32 num_threads; // Not including the calling thread.
+
+    // The current job. Written by the calling thread before generation is increased.
+    SvrWorkFn fn;
+    void* data;
+    s32 num_items;
+    s32 items_per_job;
+    bool stop;
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 generation; // Increased for every run.
+    SvrDoorbell start_bell; // Rung when generation is increased.
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 next_item; // Start of the next job that has not been taken.
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom32 num_busy; // Threads that have not finished the current run.
+    SvrDoorbell done_bell; // Rung when num_busy reaches 0.
+};
+
+// Take jobs until there are none left.
+static void svr_work_pool_take_jobs(SvrWorkPool* pool)
+{
+    SVR_TRACE_SCOPE("work_pool_jobs");
+
+    while (true)
+    {
+        s32 start = svr_atom_add(&pool->next_item, pool->items_per_job);
+
+        if (start >= pool->num_items)
+        {
+            break;
+        }
+
+        s32 end = svr_min(start + pool->items_per_job, pool->num_items);
+        pool->fn(pool->data, start, end);
+    }
+}
+
+static void svr_work_pool_thread_proc(SvrWorkPool* pool)
+{
+    s32 seen_generation = 0;
+
+    svr_trace_set_thread_name("SVR WORK THREAD");
+
+    while (true)
+    {
+        s32 ticket = svr_doorbell_prepare(&pool->start_bell);
+        s32 generation = svr_atom_load(&pool->generation);
+
+        if (generation == seen_generation)
+        {
+            svr_doorbell_wait(&pool->start_bell, ticket);
+            continue;
+        }
+
+        seen_generation = generation;
+
+        if (pool->stop)
+        {
+            break;
+        }
+
+        svr_work_pool_take_jobs(pool);
+
+        // The previous value is returned, so the last thread sees 1.
+        if (svr_atom_sub(&pool->num_busy, 1) == 1)
+        {
+            svr_doorbell_ring(&pool->done_bell);
+        }
+    }
+}
+
+static void svr_work_thread_proc(void* param)
+{
+#ifdef _WIN32
+    SetThreadDescription(GetCurrentThread(), L"SVR WORK THREAD");
+#endif
+
+    SvrWorkThread* thread = (SvrWorkThread*)param;
+    svr_work_pool_thread_proc(thread->pool);
+}
+
+s32 svr_get_num_cpus()
+{
+#ifdef _WIN32
+    return (s32)GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+#else
+    return (s32)svr_max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+}
+
+SvrWorkPool* svr_work_pool_create(s32 num_threads)
+{
+    if (num_threads <= 0)
+    {
+        num_threads = svr_get_num_cpus();
+    }
+
+    SvrWorkPool* pool = SVR_ZALLOC(SvrWorkPool);
+    pool->num_threads = num_threads - 1; // The calling thread is one of them.
+    pool->threads = SVR_ZALLOC_NUM(SvrWorkThread, svr_max(1, pool->num_threads));
+
+    for (s32 i = 0; i < pool->num_threads; i++)
+    {
+        SvrWorkThread* thread = &pool->threads[i];
+        thread->pool = pool;
+        svr_thread_start(&thread->thread, svr_work_thread_proc, thread);
+    }
+
+    return pool;
+}
+
+void svr_work_pool_free(SvrWorkPool* pool)
+{
+    pool->stop = true;
+
+    svr_atom_add(&pool->generation, 1);
+    svr_doorbell_ring(&pool->start_bell);
+
+    for (s32 i = 0; i < pool->num_threads; i++)
+    {
+        svr_thread_join(&pool->threads[i].thread);
+    }
+
+    svr_free(pool->threads);
+    svr_free(pool);
+}
+
+s32 svr_work_pool_get_num_threads(SvrWorkPool* pool)
+{
+    return pool->num_threads + 1;
+}
+
+// Sets up the job and wakes the pool threads.
+static void svr_work_pool_begin(SvrWorkPool* pool, SvrWorkFn fn, void* data, s32 num_items, s32 items_per_job)
+{
+    pool->fn = fn;
+    pool->data = data;
+    pool->num_items = num_items;
+    pool->items_per_job = svr_max(1, items_per_job);
+
+    svr_atom_store(&pool->next_item, 0);
+    svr_atom_store(&pool->num_busy, pool->num_threads);
+
+    // This is a full barrier, so the threads see the job above when they see the new generation.
+    svr_atom_add(&pool->generation, 1);
+    svr_doorbell_ring(&pool->start_bell);
+}
+
+void svr_work_pool_run(SvrWorkPool* pool, SvrWorkFn fn, void* data, s32 num_items, s32 items_per_job)
+{
+    // Not worth waking anyone for a single job.
+    if (pool->num_threads == 0 || num_items <= svr_max(1, items_per_job))
+    {
+        fn(data, 0, num_items);
+        return;
+    }
+
+    svr_work_pool_begin(pool, fn, data, num_items, items_per_job);
+
+    svr_work_pool_take_jobs(pool);
+
+    svr_work_pool_wait(pool);
+}
+
+void svr_work_pool_start(SvrWorkPool* pool, SvrWorkFn fn, void* data, s32 num_items, s32 items_per_job)
+{
+    if (pool->num_threads == 0)
+    {
+        fn(data, 0, num_items);
+        return;
+    }
+
+    svr_work_pool_begin(pool, fn, data, num_items, items_per_job);
+}
+
+void svr_work_pool_wait(SvrWorkPool* pool)
+{
+    // The other threads may still be working on their last jobs.
+    while (true)
+    {
+        s32 ticket = svr_doorbell_prepare(&pool->done_bell);
+
+        if (svr_atom_load(&pool->num_busy) == 0)
+        {
+            break;
+        }
+
+        svr_doorbell_wait(&pool->done_bell, ticket);
+    }
+}
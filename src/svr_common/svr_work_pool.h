@@ -0,0 +1,37 @@
+#pragma once
+#include "svr_common.h"
+
+// Threads that split up a range of items between them, for processing big images and buffers.
+// The calling thread takes part in the work too, and the call returns when everything is done.
+// Only one thread may use a pool at a time.
+
+struct SvrWorkPool;
+
+// Processes the items from start to end (not including end).
+using SvrWorkFn = void(*)(void* data, s32 start, s32 end);
+
+// Creates a pool with this many threads in total, including the calling thread.
+// Set to 0 to use one thread per processor.
+SvrWorkPool* svr_work_pool_create(s32 num_threads);
+
+// Stops the threads and frees the pool.
+void svr_work_pool_free(SvrWorkPool* pool);
+
+// Number of threads that work at the same time, including the calling thread.
+s32 svr_work_pool_get_num_threads(SvrWorkPool* pool);
+
+// Calls fn over the items from 0 to num_items in jobs of items_per_job each.
+// Jobs are taken as threads become free, so they should be small enough to even out the load but big enough
+// to not just be overhead.
+void svr_work_pool_run(SvrWorkPool* pool, SvrWorkFn fn, void* data, s32 num_items, s32 items_per_job);
+
+// Same as svr_work_pool_run but returns immediately and leaves all the work to the pool threads.
+// The data must stay valid until svr_work_pool_wait is called. Nothing else may be run before that.
+// If the pool has no threads of its own, the work is done here before returning.
+void svr_work_pool_start(SvrWorkPool* pool, SvrWorkFn fn, void* data, s32 num_items, s32 items_per_job);
+
+// Waits for the work from svr_work_pool_start to finish. Does nothing if nothing was started.
+void svr_work_pool_wait(SvrWorkPool* pool);
+
+// Number of processors that can run threads.
+s32 svr_get_num_cpus();
@@ -0,0 +1,876 @@
+#include "encoder_priv.h"
+
+// Benchmark of the render pipeline without svr_game, built as svr_encoder_bench.exe.
+// On other platforms it is built by CMakeLists.txt when pkg-config can find FFmpeg.
+// Frames and samples are made up or read from raw files, and are given to the render pipeline the same way as the ones from svr_game.
+// The conversion and download on the GPU are replaced by the same conversion on the processor (svr_color) and a copy into the frame,
+// so no D3D11 device is needed.
+// The result is written to stdout as one JSON object so that runs can be compared between versions. Everything else goes to the log.
+// With several worker counts the movie is made once for each, with one JSON object on every line, to see how the workers scale.
+
+#ifdef SVR_ENCODER_BENCH
+
+#include <math.h>
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/stat.h>
+#include <sys/resource.h>
+#endif
+
+const s32 BENCH_MADE_UP_FRAMES = 8; // Frames to make up when there is no video file.
+const s32 BENCH_MAX_SOURCE_MEM = 1024 * 1024 * 1024; // Max bytes of source frames to keep in memory.
+const s32 BENCH_MAX_SIZE = 8192; // Max width and height.
+const s32 BENCH_TONE_HZ = 440; // Pitch of the made up audio. Whole periods fit in one second, so the tone has no jump when it starts over.
+const double BENCH_PI = 3.14159265358979323846;
+
+const char* BENCH_STAGE_NAMES[] =
+{
+    "convert",
+    "download",
+    "encode",
+    "write",
+};
+
+static_assert(SVR_ARRAY_SIZE(BENCH_STAGE_NAMES) == SVR_STATS_ENCODER_NUM_STAGES, "Every encoder stage must have a name");
+
+static void bench_print_json_string(const char* str)
+{
+    putchar('"');
+
+    for (const char* c = str; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            printf("\\%c", *c);
+        }
+
+        else if ((u8)*c < 0x20)
+        {
+            printf("\\u%04x", (u8)*c);
+        }
+
+        else
+        {
+            putchar(*c);
+        }
+    }
+
+    putchar('"');
+}
+
+// Returns -1 if the file cannot be found.
+static s64 bench_get_file_size(const char* path)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attrs;
+
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attrs))
+    {
+        return -1;
+    }
+
+    return ((s64)attrs.nFileSizeHigh << 32) | attrs.nFileSizeLow;
+#else
+    struct stat attrs;
+
+    if (stat(path, &attrs) != 0)
+    {
+        return -1;
+    }
+
+    return (s64)attrs.st_size;
+#endif
+}
+
+// Most memory that the process has used at once, in bytes.
+static u64 bench_get_process_peak()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS mem_counters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &mem_counters, sizeof(mem_counters));
+
+    return (u64)mem_counters.PeakWorkingSetSize;
+#else
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (u64)usage.ru_maxrss * 1024; // In kilobytes on Linux.
+#endif
+}
+
+s32 EncoderState::bench_run(s32 argc, char** argv)
+{
+    s32 ret = 1;
+    s64 first_time = 0;
+
+    if (!bench_parse_options(argc, argv))
+    {
+        bench_print_usage();
+        return 1;
+    }
+
+    if (!bench_init())
+    {
+        goto rfail;
+    }
+
+    if (!bench_load_sources())
+    {
+        goto rfail;
+    }
+
+    for (s32 i = 0; i < bench_num_worker_counts; i++)
+    {
+        s64 time;
+
+        movie_params.encode_workers = bench_worker_counts[i];
+
+        if (!bench_run_movie(&time))
+        {
+            goto rfail;
+        }
+
+        if (i == 0)
+        {
+            first_time = time;
+        }
+
+        bench_print_result(time, first_time, bench_get_file_size(movie_params.dest_file));
+        fflush(stdout);
+    }
+
+    ret = 0;
+    goto rexit;
+
+rfail:
+    bench_print_error(shared_mem_ptr && shared_mem_ptr->error ? shared_mem_ptr->error_message : "ERROR: Could not start the benchmark\n");
+    free_dynamic();
+
+rexit:
+    bench_free();
+    return ret;
+}
+
+void EncoderState::bench_print_usage()
+{
+    printf("Usage: svr_encoder_bench [options]\n");
+    printf("\n");
+    printf("Encodes made up or recorded frames with the render pipeline of svr_encoder, and prints the result as JSON.\n");
+    printf("The conversion and download on the GPU are done on the processor instead.\n");
+    printf("\n");
+    printf("    --frames <n>               Video frames to encode, 600 by default\n");
+    printf("    --width <n>                Width of the video, 1920 by default\n");
+    printf("    --height <n>               Height of the video, 1080 by default\n");
+    printf("    --fps <n>                  Frames per second of the video, 60 by default\n");
+    printf("    --video-encoder <name>     dnxhr, libx264 or libx264_444, dnxhr by default\n");
+    printf("    --audio-encoder <name>     aac or none, aac by default\n");
+    printf("    --dnxhr-profile <name>     lb, sq or hq, hq by default\n");
+    printf("    --x264-preset <name>       ultrafast by default\n");
+    printf("    --x264-crf <n>             15 by default\n");
+    printf("    --x264-intra               Only use keyframes\n");
+    printf("    --x264-chunk-length <n>    Seconds of video in every chunk when there are several workers, 10 by default\n");
+    printf("    --workers <n,...>          Video frames to encode at the same time, 0 by default\n");
+    printf("                               Several counts make the movie once with each, to see how the workers scale\n");
+    printf("    --memory-budget <mb>       Memory for frames and packets, 4096 by default\n");
+    printf("    --audio-hz <n>             Sample rate of the audio, 44100 by default\n");
+    printf("    --audio-channels <n>       Channels of the audio, 2 by default\n");
+    printf("    --video-file <path>        Raw B8G8R8A8 frames of the same size as the video, made up by default\n");
+    printf("    --audio-file <path>        Raw interleaved s16 samples with the same rate and channels as the audio, made up by default\n");
+    printf("    --output <path>            Movie file to write, svr_encoder_bench.mov by default\n");
+    printf("    --trace                    Record a trace next to the movie\n");
+    printf("\n");
+    printf("The sources are used again from the start if they are shorter than the video.\n");
+}
+
+bool EncoderState::bench_parse_options(s32 argc, char** argv)
+{
+    // Same as the default profile.
+    movie_params = {};
+    movie_params.video_width = 1920;
+    movie_params.video_height = 1080;
+    movie_params.video_fps = 60;
+    movie_params.x264_crf = 15;
+    movie_params.x264_chunk_length = 10;
+    movie_params.memory_budget_mb = 4096;
+    movie_params.audio_hz = 44100;
+    movie_params.audio_channels = 2;
+    movie_params.audio_bits = 16; // Always the format of the game.
+    movie_params.use_audio = true;
+    movie_params.stats_idx = -1;
+
+    SVR_COPY_STRING("svr_encoder_bench.mov", movie_params.dest_file);
+    SVR_COPY_STRING("dnxhr", movie_params.video_encoder);
+    SVR_COPY_STRING("aac", movie_params.audio_encoder);
+    SVR_COPY_STRING("ultrafast", movie_params.x264_preset);
+    SVR_COPY_STRING("hq", movie_params.dnxhr_profile);
+
+    bench_num_frames = 600;
+    bench_worker_counts[0] = 0;
+    bench_num_worker_counts = 1;
+    bench_video_file = NULL;
+    bench_audio_file = NULL;
+
+    for (s32 i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!strcmp(arg, "--x264-intra"))
+        {
+            movie_params.x264_intra = true;
+            continue;
+        }
+
+        if (!strcmp(arg, "--trace"))
+        {
+            movie_params.use_trace = true;
+            continue;
+        }
+
+        // Everything else has a value.
+        if (value == NULL)
+        {
+            return false;
+        }
+
+        i++;
+
+        if (!strcmp(arg, "--frames"))
+        {
+            bench_num_frames = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--width"))
+        {
+            movie_params.video_width = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--height"))
+        {
+            movie_params.video_height = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--fps"))
+        {
+            movie_params.video_fps = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--video-encoder"))
+        {
+            SVR_COPY_STRING(value, movie_params.video_encoder);
+        }
+
+        else if (!strcmp(arg, "--audio-encoder"))
+        {
+            movie_params.use_audio = strcmp(value, "none") != 0;
+            SVR_COPY_STRING(value, movie_params.audio_encoder);
+        }
+
+        else if (!strcmp(arg, "--dnxhr-profile"))
+        {
+            SVR_COPY_STRING(value, movie_params.dnxhr_profile);
+        }
+
+        else if (!strcmp(arg, "--x264-preset"))
+        {
+            SVR_COPY_STRING(value, movie_params.x264_preset);
+        }
+
+        else if (!strcmp(arg, "--x264-crf"))
+        {
+            movie_params.x264_crf = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--x264-chunk-length"))
+        {
+            movie_params.x264_chunk_length = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--workers"))
+        {
+            if (!bench_parse_worker_counts(value))
+            {
+                return false;
+            }
+        }
+
+        else if (!strcmp(arg, "--memory-budget"))
+        {
+            movie_params.memory_budget_mb = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--audio-hz"))
+        {
+            movie_params.audio_hz = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--audio-channels"))
+        {
+            movie_params.audio_channels = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--video-file"))
+        {
+            bench_video_file = value;
+        }
+
+        else if (!strcmp(arg, "--audio-file"))
+        {
+            bench_audio_file = value;
+        }
+
+        else if (!strcmp(arg, "--output"))
+        {
+            SVR_COPY_STRING(value, movie_params.dest_file);
+        }
+
+        else
+        {
+            return false;
+        }
+    }
+
+    // Same limits as the movie profile. The encoders verify the names themselves.
+    // The size must be even for the chroma planes.
+
+    if (bench_num_frames < 1)
+    {
+        return false;
+    }
+
+    if (movie_params.video_width < 2 || movie_params.video_width > BENCH_MAX_SIZE || movie_params.video_width & 1)
+    {
+        return false;
+    }
+
+    if (movie_params.video_height < 2 || movie_params.video_height > BENCH_MAX_SIZE || movie_params.video_height & 1)
+    {
+        return false;
+    }
+
+    if (movie_params.video_fps < 1 || movie_params.video_fps > 1000)
+    {
+        return false;
+    }
+
+    if (movie_params.x264_crf < 0 || movie_params.x264_crf > 52)
+    {
+        return false;
+    }
+
+    if (movie_params.x264_chunk_length < 1 || movie_params.x264_chunk_length > 3600)
+    {
+        return false;
+    }
+
+    for (s32 i = 0; i < bench_num_worker_counts; i++)
+    {
+        if (bench_worker_counts[i] < 0 || bench_worker_counts[i] > 64)
+        {
+            return false;
+        }
+    }
+
+    if (movie_params.memory_budget_mb < 256)
+    {
+        return false;
+    }
+
+    if (movie_params.audio_hz < 8000 || movie_params.audio_hz > 192000)
+    {
+        return false;
+    }
+
+    if (movie_params.audio_channels < 1 || movie_params.audio_channels > AUDIO_MAX_CHANS)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Counts separated by commas, such as 0,2,4,8.
+bool EncoderState::bench_parse_worker_counts(const char* value)
+{
+    const char* pos = value;
+
+    bench_num_worker_counts = 0;
+
+    while (true)
+    {
+        char* end;
+        long count = strtol(pos, &end, 10);
+
+        if (end == pos || bench_num_worker_counts == BENCH_MAX_WORKER_COUNTS)
+        {
+            return false;
+        }
+
+        bench_worker_counts[bench_num_worker_counts] = (s32)count;
+        bench_num_worker_counts++;
+
+        if (*end == 0)
+        {
+            break;
+        }
+
+        if (*end != ',')
+        {
+            return false;
+        }
+
+        pos = end + 1;
+    }
+
+    return true;
+}
+
+// Same as init, but nothing is opened from svr_game.
+bool EncoderState::bench_init()
+{
+    bool ret = false;
+
+    main_thread_id = svr_thread_get_current_id();
+
+    svr_prof_init(); // Every module has its own timer state.
+
+    svr_trace_set_thread_name("ENCODER MAIN THREAD");
+
+    SVR_COPY_STRING(".", resource_path);
+
+    // Not shared with anything, but the render pipeline reports errors here and start_event reads the movie parameters from here.
+    shared_mem_ptr = SVR_ZALLOC(EncoderSharedMem);
+
+    if (!vid_init())
+    {
+        goto rfail;
+    }
+
+    if (!audio_init())
+    {
+        goto rfail;
+    }
+
+    if (!render_init())
+    {
+        goto rfail;
+    }
+
+    if (!pool_init())
+    {
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+// Must be called before free_static.
+void EncoderState::bench_free()
+{
+    svr_maybe_free((void**)&bench_video_mem);
+    svr_maybe_free((void**)&bench_audio_mem);
+
+    // Not from svr_ipc, so free_static must not see it.
+    svr_maybe_free((void**)&shared_mem_ptr);
+}
+
+// The frames are read before the movie starts, so reading the file is not timed.
+// Only as many frames as are needed are read, and at most BENCH_MAX_SOURCE_MEM of them.
+bool EncoderState::bench_load_video()
+{
+    bool ret = false;
+    s32 frame_size = movie_params.video_width * movie_params.video_height * 4;
+    s32 max_frames = svr_min(bench_num_frames, svr_max(1, BENCH_MAX_SOURCE_MEM / frame_size));
+
+    FILE* f = fopen(bench_video_file, "rb");
+
+    if (f == NULL)
+    {
+        error("ERROR: Could not open video file %s\n", bench_video_file);
+        goto rfail;
+    }
+
+    _fseeki64(f, 0, SEEK_END);
+    bench_num_video_frames = (s32)svr_min(_ftelli64(f) / frame_size, (s64)max_frames);
+    _fseeki64(f, 0, SEEK_SET);
+
+    if (bench_num_video_frames == 0)
+    {
+        error("ERROR: Video file %s does not have a whole %dx%d frame\n", bench_video_file, movie_params.video_width, movie_params.video_height);
+        goto rfail;
+    }
+
+    bench_video_mem = (u8*)svr_alloc(frame_size * bench_num_video_frames);
+
+    if (fread(bench_video_mem, frame_size, bench_num_video_frames, f) != (size_t)bench_num_video_frames)
+    {
+        error("ERROR: Could not read video file %s\n", bench_video_file);
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    if (f)
+    {
+        fclose(f);
+    }
+
+    return ret;
+}
+
+// Gradients that move every frame with some noise on top, so the encoders get both motion and detail.
+void EncoderState::bench_make_video()
+{
+    s32 width = movie_params.video_width;
+    s32 height = movie_params.video_height;
+    s32 frame_size = width * height * 4;
+
+    bench_num_video_frames = svr_min(BENCH_MADE_UP_FRAMES, svr_max(1, BENCH_MAX_SOURCE_MEM / frame_size));
+    bench_video_mem = (u8*)svr_alloc(frame_size * bench_num_video_frames);
+
+    u8* px = bench_video_mem;
+    u32 seed = 1;
+
+    for (s32 f = 0; f < bench_num_video_frames; f++)
+    {
+        for (s32 y = 0; y < height; y++)
+        {
+            for (s32 x = 0; x < width; x++)
+            {
+                seed = seed * 1664525 + 1013904223;
+                s32 noise = (s32)(seed >> 28) - 8;
+
+                px[0] = (u8)(x + f * 8 + noise);
+                px[1] = (u8)(y + f * 4 + noise);
+                px[2] = (u8)((x + y) / 2 - f * 8 + noise);
+                px[3] = 255;
+
+                px += 4;
+            }
+        }
+    }
+}
+
+// Same as bench_load_video, with as many samples as the video is long and at most BENCH_MAX_SOURCE_MEM of them.
+bool EncoderState::bench_load_audio()
+{
+    bool ret = false;
+    s32 sample_size = movie_params.audio_channels * sizeof(s16);
+    s64 max_samples = svr_min((s64)bench_num_frames * movie_params.audio_hz / movie_params.video_fps + 1, (s64)(BENCH_MAX_SOURCE_MEM / sample_size));
+
+    FILE* f = fopen(bench_audio_file, "rb");
+
+    if (f == NULL)
+    {
+        error("ERROR: Could not open audio file %s\n", bench_audio_file);
+        goto rfail;
+    }
+
+    _fseeki64(f, 0, SEEK_END);
+    bench_num_audio_samples = (s32)svr_min(_ftelli64(f) / sample_size, max_samples);
+    _fseeki64(f, 0, SEEK_SET);
+
+    if (bench_num_audio_samples == 0)
+    {
+        error("ERROR: Audio file %s does not have any samples\n", bench_audio_file);
+        goto rfail;
+    }
+
+    bench_audio_mem = (s16*)svr_alloc(sample_size * bench_num_audio_samples);
+
+    if (fread(bench_audio_mem, sample_size, bench_num_audio_samples, f) != (size_t)bench_num_audio_samples)
+    {
+        error("ERROR: Could not read audio file %s\n", bench_audio_file);
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    if (f)
+    {
+        fclose(f);
+    }
+
+    return ret;
+}
+
+// One second of a tone, with the next harmonic in every channel.
+void EncoderState::bench_make_audio()
+{
+    s32 channels = movie_params.audio_channels;
+
+    bench_num_audio_samples = movie_params.audio_hz;
+    bench_audio_mem = (s16*)svr_alloc(bench_num_audio_samples * channels * sizeof(s16));
+
+    for (s32 i = 0; i < bench_num_audio_samples; i++)
+    {
+        double t = (double)i / (double)movie_params.audio_hz;
+
+        for (s32 j = 0; j < channels; j++)
+        {
+            double pitch = (double)(BENCH_TONE_HZ * (j + 1));
+            bench_audio_mem[i * channels + j] = (s16)(sin(t * pitch * 2.0 * BENCH_PI) * 8192.0);
+        }
+    }
+}
+
+// The sources are the same for every worker count.
+bool EncoderState::bench_load_sources()
+{
+    bool ret = false;
+
+    if (bench_video_file)
+    {
+        if (!bench_load_video())
+        {
+            goto rfail;
+        }
+    }
+
+    else
+    {
+        bench_make_video();
+    }
+
+    if (movie_params.use_audio)
+    {
+        if (bench_audio_file)
+        {
+            if (!bench_load_audio())
+            {
+                goto rfail;
+            }
+        }
+
+        else
+        {
+            bench_make_audio();
+        }
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+// Makes the movie with the worker count that is in movie_params. The time is in microseconds.
+bool EncoderState::bench_run_movie(s64* time)
+{
+    bool ret = false;
+    s64 start_time;
+
+    bench_audio_pos = 0;
+
+    shared_mem_ptr->movie_params = movie_params;
+
+    start_event();
+
+    if (shared_mem_ptr->error)
+    {
+        goto rfail;
+    }
+
+    // Timed until the movie file is closed, since encoding the frames that are still queued is part of the work.
+    start_time = svr_prof_get_real_time();
+
+    for (s32 i = 0; i < bench_num_frames; i++)
+    {
+        if (!bench_give_video_frame(i))
+        {
+            goto rfail;
+        }
+
+        // The game gives the samples of one video frame at a time, with the remainder spread out between the frames.
+        if (movie_params.use_audio)
+        {
+            s64 hz = movie_params.audio_hz;
+            s64 fps = movie_params.video_fps;
+            s32 num_samples = (s32)(((i + 1) * hz / fps) - (i * hz / fps));
+
+            if (!bench_give_audio(num_samples))
+            {
+                goto rfail;
+            }
+        }
+    }
+
+    stop_event();
+
+    // The threads may have failed while the queued frames were flushed.
+    if (render_check_thread_errors())
+    {
+        goto rfail;
+    }
+
+    *time = svr_prof_get_real_time() - start_time;
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+// In place of render_receive_video and render_submit_texture.
+bool EncoderState::bench_give_video_frame(s32 frame_idx)
+{
+    SVR_TRACE_SCOPE("bench_give_video_frame");
+
+    bool ret = false;
+    s32 frame_size = movie_params.video_width * movie_params.video_height * 4;
+    AVFrame* frame = NULL;
+
+    if (render_check_thread_errors())
+    {
+        goto rfail;
+    }
+
+    frame = vid_convert_on_cpu(bench_video_mem + (s64)(frame_idx % bench_num_video_frames) * frame_size);
+    frame->pts = render_video_pts;
+
+    render_video_pts++;
+
+    render_encode_video_frame(frame);
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+// Given in pieces that are not larger than what svr_encoder reads from the audio ring at once.
+bool EncoderState::bench_give_audio(s32 num_samples)
+{
+    while (num_samples > 0)
+    {
+        s32 num = svr_min(num_samples, bench_num_audio_samples - bench_audio_pos);
+        num = svr_min(num, ENCODER_MAX_SAMPLES);
+
+        if (!render_receive_audio(bench_audio_mem + bench_audio_pos * movie_params.audio_channels, num))
+        {
+            return false;
+        }
+
+        bench_audio_pos = (bench_audio_pos + num) % bench_num_audio_samples;
+        num_samples -= num;
+    }
+
+    return true;
+}
+
+// The times are in microseconds, and the output size is -1 if the file is gone.
+// The speedup is against the first worker count.
+void EncoderState::bench_print_result(s64 time, s64 first_time, s64 output_size)
+{
+    double seconds = (double)time / 1000000.0;
+
+    printf("{\"svr_version\":%d", SVR_VERSION);
+
+    printf(",\"video_encoder\":");
+    bench_print_json_string(movie_params.video_encoder);
+    printf(",\"audio_encoder\":");
+    bench_print_json_string(movie_params.use_audio ? movie_params.audio_encoder : "none");
+    printf(",\"dnxhr_profile\":");
+    bench_print_json_string(movie_params.dnxhr_profile);
+    printf(",\"x264_preset\":");
+    bench_print_json_string(movie_params.x264_preset);
+    printf(",\"x264_crf\":%d,\"x264_intra\":%s", movie_params.x264_crf, movie_params.x264_intra ? "true" : "false");
+
+    printf(",\"width\":%d,\"height\":%d,\"fps\":%d,\"frames\":%d", movie_params.video_width, movie_params.video_height, movie_params.video_fps, bench_num_frames);
+    printf(",\"audio_hz\":%d,\"audio_channels\":%d", movie_params.audio_hz, movie_params.audio_channels);
+    printf(",\"workers\":%d,\"simd\":\"%s\"", movie_params.encode_workers, svr_simd_get_level_name(vid_simd_level));
+    printf(",\"video_source\":\"%s\",\"audio_source\":\"%s\"", bench_video_file ? "file" : "made_up", !movie_params.use_audio ? "none" : bench_audio_file ? "file" : "made_up");
+
+    printf(",\"seconds\":%.3f,\"frames_per_second\":%.2f", seconds, bench_num_frames / seconds);
+    printf(",\"realtime\":%.3f,\"speedup\":%.3f", (bench_num_frames / seconds) / movie_params.video_fps, (double)first_time / (double)time);
+    printf(",\"frames_encoded\":%lld,\"frames_written\":%lld", (long long)svr_atom_load(&stats_stage_counts[SVR_STATS_ENCODER_STAGE_ENCODE]), (long long)svr_atom_load(&stats_frames_written));
+
+    // The write stage runs for the packets of every stream.
+    printf(",\"stages\":{");
+
+    for (s32 i = 0; i < SVR_STATS_ENCODER_NUM_STAGES; i++)
+    {
+        s64 total = svr_atom_load(&stats_stage_times[i]);
+        s64 runs = svr_atom_load(&stats_stage_counts[i]);
+
+        printf("%s\"%s\":{\"runs\":%lld,\"total_ms\":%.1f,\"average_ms\":%.3f}", i > 0 ? "," : "", BENCH_STAGE_NAMES[i], (long long)runs, total / 1000.0, runs > 0 ? total / 1000.0 / runs : 0.0);
+    }
+
+    printf("}");
+
+    // How much of the audio encoding was done while the video was encoded, which is the point of giving every stream its own thread.
+    printf(",\"encoding_ms\":{\"video\":%.1f,\"audio\":%.1f,\"both\":%.1f}", stats_video_encode_time / 1000.0, stats_audio_encode_time / 1000.0, stats_both_encode_time / 1000.0);
+    printf(",\"audio_overlap\":%.3f", stats_audio_encode_time > 0 ? (double)stats_both_encode_time / (double)stats_audio_encode_time : 0.0);
+
+    printf(",\"pool_peak\":%lld,\"pool_budget\":%lld,\"pool_waits\":%d", (long long)svr_atom_load(&pool_peak), (long long)pool_budget, svr_atom_load(&pool_num_waits));
+    printf(",\"process_peak\":%llu", (unsigned long long)bench_get_process_peak());
+
+    printf(",\"output\":");
+    bench_print_json_string(movie_params.dest_file);
+    printf(",\"output_size\":%lld", (long long)output_size);
+
+    printf("}\n");
+}
+
+void EncoderState::bench_print_error(const char* message)
+{
+    svr_log("%s", message);
+
+    char buf[512];
+    SVR_COPY_STRING(message, buf);
+
+    // The messages end with a newline for the log.
+    s32 len = (s32)strlen(buf);
+
+    if (len > 0 && buf[len - 1] == '\n')
+    {
+        buf[len - 1] = 0;
+    }
+
+    printf("{\"error\":");
+    bench_print_json_string(buf);
+    printf("}\n");
+}
+
+int main(int argc, char** argv)
+{
+    // The result goes to stdout, so the log and the messages from ffmpeg go to a file.
+    svr_init_log("ENCODER_BENCH_LOG.txt", false);
+
+    av_log_set_callback(av_log_callback);
+    av_log_set_level(AV_LOG_WARNING);
+
+    svr_log("SVR " SVR_ARCH_STRING " version %d encoder benchmark\n", SVR_VERSION);
+
+    s32 ret = encoder_state.bench_run(argc, argv);
+    encoder_state.free_static();
+
+    return ret;
+}
+
+#endif
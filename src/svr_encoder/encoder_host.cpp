@@ -0,0 +1,40 @@
+#include "encoder_priv.h"
+
+// Entry for svr_encoder_host.dll, which runs the encoder on its own thread inside a 64-bit game.
+// See encoder_host.h.
+
+#ifdef SVR_ENCODER_HOST
+
+void encoder_host_thread_proc(void* param)
+{
+    EncoderHostParams* params = (EncoderHostParams*)param;
+
+    // The thread exits on failure, which svr_game sees the same way as when the process exits.
+    if (encoder_state.init(params->shared_mem_id, params))
+    {
+        encoder_state.event_loop();
+    }
+
+    encoder_state.free_static();
+}
+
+extern "C" __declspec(dllexport) void* encoder_host_start(EncoderHostParams* params)
+{
+    // The log is shared with svr_game through svr_shared64.dll, so it is already open.
+    svr_log("Running encoder in the game process\n");
+
+    av_log_set_callback(av_log_callback);
+    av_log_set_level(AV_LOG_WARNING);
+
+    void* thread_h = encoder_host_start_thread(encoder_host_thread_proc, params);
+
+    if (thread_h == NULL)
+    {
+        svr_log("ERROR: Could not create encoder host thread (%lu)\n", GetLastError());
+        return NULL;
+    }
+
+    return thread_h;
+}
+
+#endif
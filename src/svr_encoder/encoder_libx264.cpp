@@ -5,13 +5,21 @@
 // https://raw.githubusercontent.com/FFmpeg/FFmpeg/master/libavcodec/libx264.c
 // https://raw.githubusercontent.com/mirror/x264/master/x264.c
 
-void EncoderState::render_setup_libx264()
+void EncoderState::render_setup_libx264(AVCodecContext* ctx)
 {
-    av_opt_set(render_video_ctx->priv_data, "preset", movie_params.x264_preset, 0);
-    av_opt_set(render_video_ctx->priv_data, "crf", svr_va("%d", movie_params.x264_crf), 0);
+    av_opt_set(ctx->priv_data, "preset", movie_params.x264_preset, 0);
+    av_opt_set(ctx->priv_data, "crf", svr_va("%d", movie_params.x264_crf), 0);
 
     if (movie_params.x264_intra)
     {
-        av_opt_set(render_video_ctx->priv_data, "x264-params", "keyint=1", 0);
+        av_opt_set(ctx->priv_data, "x264-params", "keyint=1", 0);
+    }
+
+    // Every chunk starts with a keyframe anyway, so don't put more in than needed.
+    // Closed GOPs so that the last frames of a chunk don't depend on the next chunk.
+    if (render_video_chunk_frames > 0)
+    {
+        ctx->gop_size = render_video_chunk_frames;
+        ctx->flags |= AV_CODEC_FLAG_CLOSED_GOP;
     }
 }
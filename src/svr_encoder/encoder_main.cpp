@@ -4,6 +4,8 @@ EncoderState encoder_state;
 
 void av_log_callback(void* avcl, int level, const char* fmt, va_list vl)
 {
+    (void)avcl;
+
     // Change this comparison if you need to see more detailed output.
     if (level > AV_LOG_WARNING)
     {
@@ -36,13 +38,16 @@ void av_log_callback(void* avcl, int level, const char* fmt, va_list vl)
 #endif
 }
 
+// svr_encoder_host.dll starts from encoder_host_start instead, and svr_encoder_bench.exe has its own main in encoder_bench.cpp.
+// On other platforms this is built by CMakeLists.txt for svr_game_bench, and only takes frames in memory.
+#if !defined(SVR_ENCODER_HOST) && !defined(SVR_ENCODER_BENCH)
 int main(int argc, char** argv)
 {
 #ifdef SVR_DEBUG
     _set_error_mode(_OUT_TO_MSGBOX); // Must be called so we can actually use assert because Microsoft messed it up in console builds.
 #endif
 
-    svr_init_log("data\\ENCODER_LOG.txt", false);
+    svr_init_log("data" SVR_PATH_SEP "ENCODER_LOG.txt", false);
 
     if (argc != 2)
     {
@@ -54,19 +59,24 @@ int main(int argc, char** argv)
     av_log_set_callback(av_log_callback);
     av_log_set_level(AV_LOG_WARNING);
 
+#ifdef _WIN32
     SYSTEMTIME lt;
     GetLocalTime(&lt);
 
     svr_log("SVR " SVR_ARCH_STRING " version %d (%02d/%02d/%04d %02d:%02d:%02d)\n", SVR_VERSION, lt.wDay, lt.wMonth, lt.wYear, lt.wHour, lt.wMinute, lt.wSecond);
-    svr_log("For more information see https://github.com/crashfort/SourceDemoRender\n");
+#else
+    time_t now = time(NULL);
+    struct tm lt = *localtime(&now);
 
-    // We inherit handles when creating this process, so we can just read the handle address directly.
-    // The encoder is 64-bit and the game is 32-bit, but all handles only have 32 bits significant, so this is safe.
-    HANDLE shared_mem_h = (HANDLE)(u32)strtoul(argv[1], NULL, 10);
+    svr_log("SVR " SVR_ARCH_STRING " version %d (%02d/%02d/%04d %02d:%02d:%02d)\n", SVR_VERSION, lt.tm_mday, lt.tm_mon + 1, lt.tm_year + 1900, lt.tm_hour, lt.tm_min, lt.tm_sec);
+#endif
+    svr_log("For more information see https://github.com/crashfort/SourceDemoRender\n");
 
-    encoder_state.init(shared_mem_h);
+    // The game passes the id of the shared memory, which we can open since we inherit handles when creating this process.
+    encoder_state.init(argv[1], NULL);
     encoder_state.event_loop();
     encoder_state.free_static();
 
     return 0;
 }
+#endif
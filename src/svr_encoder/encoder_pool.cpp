@@ -0,0 +1,471 @@
+#include "encoder_priv.h"
+
+// Reusable frames and packets that are shared between the encoder threads.
+// Everything that is allocated here is accounted against the memory budget from the movie profile, so that the
+// encoder cannot grow without bounds if the encoding is slower than the game.
+// The buffers of frames and packets are counted for as long as anything references them, which can be longer than we hold them.
+// An encoder may keep a reference to a frame that was given back, and the muxer keeps packets in its interleave queue after they are written.
+
+// Stands in for a buffer from ffmpeg and gives its size back to the budget when the last reference to it is gone.
+struct PoolTrackedBuffer
+{
+    EncoderState* encoder;
+    AVBufferRef* inner;
+};
+
+// Called by whichever thread lets go of the last reference.
+static void pool_tracked_buffer_free(void* opaque, u8* data)
+{
+    (void)data; // Same as the data of the inner buffer.
+
+    PoolTrackedBuffer* tracked = (PoolTrackedBuffer*)opaque;
+    s64 size = tracked->inner->size;
+
+    av_buffer_unref(&tracked->inner);
+    tracked->encoder->pool_remove_usage(size);
+
+    svr_free(tracked);
+}
+
+bool EncoderState::pool_init()
+{
+    pool_video_frames.init(RENDER_QUEUED_FRAMES);
+    pool_audio_frames.init(RENDER_QUEUED_FRAMES);
+    pool_packets.init(RENDER_QUEUED_PACKETS);
+
+    return true;
+}
+
+void EncoderState::pool_free_static()
+{
+    pool_video_frames.free();
+    pool_audio_frames.free();
+    pool_packets.free();
+}
+
+// Must be called after the codecs have been opened since the frame sizes depend on them.
+bool EncoderState::pool_start()
+{
+    bool ret = false;
+
+    pool_budget = (s64)movie_params.memory_budget_mb * 1024LL * 1024LL;
+
+    svr_atom_store(&pool_used, 0);
+    svr_atom_store(&pool_peak, 0);
+    svr_atom_store(&pool_num_waits, 0);
+    svr_atom_store(&pool_video_frames_out, 0);
+    svr_atom_store(&pool_audio_frames_out, 0);
+
+    pool_video_frame_size = av_image_get_buffer_size(render_video_ctx->pix_fmt, render_video_ctx->width, render_video_ctx->height, 1);
+    pool_audio_frame_size = 0;
+
+    if (render_audio_ctx)
+    {
+        pool_audio_frame_size = av_samples_get_buffer_size(NULL, render_audio_ctx->ch_layout.nb_channels, render_audio_ctx->frame_size, render_audio_ctx->sample_fmt, 1);
+    }
+
+    // Allocate some of everything up front so the first frames don't have to wait for allocations.
+
+    s32 num_video_frames = (s32)svr_min((s64)POOL_PREALLOC_VIDEO_FRAMES, pool_budget / pool_video_frame_size);
+
+    for (s32 i = 0; i < num_video_frames; i++)
+    {
+        AVFrame* frame = pool_alloc_video_frame();
+
+        if (frame == NULL)
+        {
+            goto rfail;
+        }
+
+        pool_push_video_frame(frame);
+    }
+
+    if (render_audio_ctx)
+    {
+        for (s32 i = 0; i < POOL_PREALLOC_AUDIO_FRAMES; i++)
+        {
+            AVFrame* frame = pool_alloc_audio_frame();
+
+            if (frame == NULL)
+            {
+                goto rfail;
+            }
+
+            pool_push_audio_frame(frame);
+        }
+    }
+
+    for (s32 i = 0; i < POOL_PREALLOC_PACKETS; i++)
+    {
+        pool_put_packet(av_packet_alloc());
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+// Free the allocated buffers in the pools.
+void EncoderState::pool_free_dynamic()
+{
+    AVFrame* frame = NULL;
+
+    while (pool_video_frames.pull(&frame))
+    {
+        av_frame_free(&frame);
+    }
+
+    while (pool_audio_frames.pull(&frame))
+    {
+        av_frame_free(&frame);
+    }
+
+    AVPacket* packet = NULL;
+
+    while (pool_packets.pull(&packet))
+    {
+        av_packet_free(&packet);
+    }
+
+    pool_video_frame_size = 0;
+    pool_audio_frame_size = 0;
+}
+
+void EncoderState::pool_log_usage()
+{
+    s64 peak = svr_atom_load(&pool_peak);
+    s32 num_waits = svr_atom_load(&pool_num_waits);
+
+    svr_log("Peak encoder memory usage was %lld MB out of %lld MB\n", SVR_FROM_MB(peak), SVR_FROM_MB(pool_budget));
+
+    if (num_waits > 0)
+    {
+        svr_log("The encoder memory budget was reached %d times, the game had to wait for encoding\n", num_waits);
+    }
+}
+
+void EncoderState::pool_add_usage(s64 size)
+{
+    s64 used = svr_atom_add(&pool_used, size) + size;
+    s64 peak = svr_atom_load(&pool_peak);
+
+    while (used > peak)
+    {
+        if (svr_atom_cmpxchg(&pool_peak, &peak, used))
+        {
+            break;
+        }
+    }
+}
+
+void EncoderState::pool_remove_usage(s64 size)
+{
+    svr_atom_sub(&pool_used, size);
+    svr_doorbell_ring(&pool_bell); // Someone may be waiting for the budget to free up.
+}
+
+// Replaces the buffer with one that counts against the budget until the last reference to it is gone.
+// The buffer is left as it is and not counted if this fails.
+void EncoderState::pool_track_buffer(AVBufferRef** buf)
+{
+    PoolTrackedBuffer* tracked = SVR_ZALLOC(PoolTrackedBuffer);
+    tracked->encoder = this;
+    tracked->inner = *buf;
+
+    // Only writable while there is one reference, same as the buffers from ffmpeg.
+    AVBufferRef* wrapper = av_buffer_create((*buf)->data, (*buf)->size, pool_tracked_buffer_free, tracked, 0);
+
+    if (wrapper == NULL)
+    {
+        svr_free(tracked);
+        return;
+    }
+
+    pool_add_usage((*buf)->size);
+
+    *buf = wrapper;
+}
+
+void EncoderState::pool_track_frame(AVFrame* frame)
+{
+    for (s32 i = 0; i < AV_NUM_DATA_POINTERS; i++)
+    {
+        if (frame->buf[i])
+        {
+            pool_track_buffer(&frame->buf[i]);
+        }
+    }
+}
+
+// The packet must have just been received from an encoder.
+void EncoderState::pool_track_packet(AVPacket* packet)
+{
+    // Encoders give back packets with references, but make sure so that the data has a lifetime to follow.
+    if (av_packet_make_refcounted(packet) < 0)
+    {
+        return;
+    }
+
+    pool_track_buffer(&packet->buf);
+}
+
+// Returns true if a new allocation of this size fits in the budget.
+// The budget is ignored if none of these frames are out, because then there is nothing that can be given back.
+bool EncoderState::pool_can_allocate(s32 size, SvrAtom32* num_out)
+{
+    if (svr_atom_load(&pool_used) + size <= pool_budget || svr_atom_load(num_out) == 0)
+    {
+        return true;
+    }
+
+    // Nothing will be given back if a thread has stopped.
+    if (render_any_thread_failed())
+    {
+        return true;
+    }
+
+    return false;
+}
+
+AVFrame* EncoderState::pool_alloc_video_frame()
+{
+    AVFrame* ret = NULL;
+    s32 res;
+
+    ret = av_frame_alloc();
+
+    if (ret == NULL)
+    {
+        goto rfail;
+    }
+
+    ret->format = render_video_ctx->pix_fmt;
+    ret->width = render_video_ctx->width;
+    ret->height = render_video_ctx->height;
+
+    // Allocate buffers for frame.
+    res = av_frame_get_buffer(ret, 0);
+
+    if (res < 0)
+    {
+        goto rfail;
+    }
+
+    pool_track_frame(ret);
+
+    goto rexit;
+
+rfail:
+    av_frame_free(&ret);
+
+rexit:
+    return ret;
+}
+
+AVFrame* EncoderState::pool_alloc_audio_frame()
+{
+    AVFrame* ret = NULL;
+    s32 res;
+
+    ret = av_frame_alloc();
+
+    if (ret == NULL)
+    {
+        goto rfail;
+    }
+
+    ret->format = render_audio_ctx->sample_fmt;
+    ret->ch_layout = render_audio_ctx->ch_layout;
+    ret->sample_rate = render_audio_ctx->sample_rate;
+    ret->nb_samples = render_audio_ctx->frame_size; // All submitted audio frames will have this amount of samples, except the last.
+
+    // Allocate buffers for frame.
+    res = av_frame_get_buffer(ret, 0);
+
+    if (res < 0)
+    {
+        goto rfail;
+    }
+
+    pool_track_frame(ret);
+
+    goto rexit;
+
+rfail:
+    av_frame_free(&ret);
+
+rexit:
+    return ret;
+}
+
+// The encoder may still hold a reference to the buffers of a frame that was given back.
+// Writing to them would change a frame that is not encoded yet, and av_frame_make_writable would make new buffers that the budget does not know about.
+// Such a frame is let go instead, and its buffers are given back to the budget when the encoder lets go of them too.
+bool EncoderState::pool_is_frame_reusable(AVFrame* frame)
+{
+    if (av_frame_is_writable(frame))
+    {
+        return true;
+    }
+
+    av_frame_free(&frame);
+    return false;
+}
+
+// Called by the main thread.
+AVFrame* EncoderState::pool_get_video_frame()
+{
+    AVFrame* ret = NULL;
+    bool waited = false;
+
+    while (true)
+    {
+        s32 ticket = svr_doorbell_prepare(&pool_bell);
+
+        // Fast and good if we can reuse.
+        if (pool_video_frames.pull(&ret))
+        {
+            if (pool_is_frame_reusable(ret))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        if (pool_can_allocate(pool_video_frame_size, &pool_video_frames_out))
+        {
+            ret = pool_alloc_video_frame();
+            break;
+        }
+
+        // Budget is used up, so wait until the video encode thread or a video worker gives something back.
+        // This blocks the game as well, which is what we want.
+
+        if (!waited)
+        {
+            svr_atom_add(&pool_num_waits, 1);
+            waited = true;
+        }
+
+        svr_doorbell_wait(&pool_bell, ticket);
+    }
+
+    if (ret)
+    {
+        svr_atom_add(&pool_video_frames_out, 1);
+    }
+
+    return ret;
+}
+
+// Called by the main thread or the audio thread.
+AVFrame* EncoderState::pool_get_audio_frame()
+{
+    AVFrame* ret = NULL;
+    bool waited = false;
+
+    while (true)
+    {
+        s32 ticket = svr_doorbell_prepare(&pool_bell);
+
+        // Fast and good if we can reuse.
+        if (pool_audio_frames.pull(&ret))
+        {
+            if (pool_is_frame_reusable(ret))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        if (pool_can_allocate(pool_audio_frame_size, &pool_audio_frames_out))
+        {
+            ret = pool_alloc_audio_frame();
+            break;
+        }
+
+        if (!waited)
+        {
+            svr_atom_add(&pool_num_waits, 1);
+            waited = true;
+        }
+
+        svr_doorbell_wait(&pool_bell, ticket);
+    }
+
+    if (ret)
+    {
+        svr_atom_add(&pool_audio_frames_out, 1);
+    }
+
+    return ret;
+}
+
+// The rings are larger than what the budget allows for most movies, but if one is full the frame is let go instead.
+// Its buffers are given back to the budget then.
+void EncoderState::pool_push_video_frame(AVFrame* frame)
+{
+    if (!pool_video_frames.push(&frame))
+    {
+        av_frame_free(&frame);
+    }
+}
+
+void EncoderState::pool_push_audio_frame(AVFrame* frame)
+{
+    if (!pool_audio_frames.push(&frame))
+    {
+        av_frame_free(&frame);
+    }
+}
+
+// Called by the video encode thread or a video worker.
+void EncoderState::pool_put_video_frame(AVFrame* frame)
+{
+    pool_push_video_frame(frame);
+    svr_atom_sub(&pool_video_frames_out, 1);
+    svr_doorbell_ring(&pool_bell);
+}
+
+// Called by the audio encode thread.
+void EncoderState::pool_put_audio_frame(AVFrame* frame)
+{
+    pool_push_audio_frame(frame);
+    svr_atom_sub(&pool_audio_frames_out, 1);
+    svr_doorbell_ring(&pool_bell);
+}
+
+// Called by the encode threads or a video worker.
+AVPacket* EncoderState::pool_get_packet()
+{
+    AVPacket* ret = NULL;
+
+    if (pool_packets.pull(&ret))
+    {
+        return ret;
+    }
+
+    return av_packet_alloc();
+}
+
+// Called by the encode threads, a video worker or the packet thread.
+// The packet must not reference any data.
+void EncoderState::pool_put_packet(AVPacket* packet)
+{
+    if (packet == NULL)
+    {
+        return;
+    }
+
+    // Packets have no data, so a full ring only costs an allocation later.
+    if (!pool_packets.push(&packet))
+    {
+        av_packet_free(&packet);
+    }
+}
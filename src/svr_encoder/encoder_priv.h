@@ -1,18 +1,34 @@
 #pragma once
 #include "svr_common.h"
 #include "encoder_shared.h"
+#include "encoder_host.h"
 #include "svr_log.h"
 #include "svr_alloc.h"
 #include "svr_locked_array.h"
-#include "svr_locked_queue.h"
+#include "svr_ring.h"
+#include "svr_reorder.h"
+#include "svr_doorbell.h"
+#include "svr_work_pool.h"
+#include "svr_copy.h"
+#include "svr_color.h"
+#include "svr_simd.h"
 #include "svr_atom.h"
 #include "svr_defs.h"
+#include "svr_trace.h"
+#include "svr_stats.h"
+#include "svr_thread.h"
 #include <stdio.h>
+#include <assert.h>
+
+// On other platforms the frames are always converted on the processor.
+#ifdef _WIN32
 #include <Windows.h>
 #include <d3d11_1.h>
 #include <d3d11shadertracing.h>
 #include <dxgi.h>
-#include <assert.h>
+#else
+#include <time.h>
+#endif
 
 extern "C"
 {
@@ -24,6 +40,8 @@ extern "C"
     #include <libavutil/samplefmt.h>
     #include <libavutil/opt.h>
     #include <libavutil/audio_fifo.h>
+    #include <libavutil/imgutils.h>
+    #include <libavutil/cpu.h>
 }
 
 #include "encoder_state.h"
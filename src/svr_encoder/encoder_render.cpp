@@ -5,9 +5,9 @@
 // Should be synchronized with proc_profile.cpp.
 const RenderVideoInfo RENDER_VIDEO_INFOS[] =
 {
-    RenderVideoInfo { "dnxhr", "dnxhd", AV_PIX_FMT_YUV422P, &EncoderState::render_setup_dnxhr },
-    RenderVideoInfo { "libx264", "libx264", AV_PIX_FMT_NV12, &EncoderState::render_setup_libx264 },
-    RenderVideoInfo { "libx264_444", "libx264", AV_PIX_FMT_YUV444P, &EncoderState::render_setup_libx264 },
+    RenderVideoInfo { "dnxhr", "dnxhd", AV_PIX_FMT_YUV422P, true, &EncoderState::render_setup_dnxhr },
+    RenderVideoInfo { "libx264", "libx264", AV_PIX_FMT_NV12, false, &EncoderState::render_setup_libx264 },
+    RenderVideoInfo { "libx264_444", "libx264", AV_PIX_FMT_YUV444P, false, &EncoderState::render_setup_libx264 },
 };
 
 // Should be synchronized with proc_profile.cpp.
@@ -16,19 +16,40 @@ const RenderAudioInfo RENDER_AUDIO_INFOS[] =
     RenderAudioInfo { "aac", "aac_mf", AV_SAMPLE_FMT_S16, 0, NULL },
 };
 
+// The thread queues have a fixed capacity. If a consumer has fallen this far behind, wait for it to catch up.
+// Returns false if the consumer thread has failed since it will never pull anything again. The caller owns the item then.
+template <class R, class T>
+static bool render_push_wait(R* ring, T* item, SvrAtom32* consumer_status)
+{
+    while (!ring->push(item))
+    {
+        if (svr_atom_load(consumer_status) == 0)
+        {
+            return false;
+        }
+
+        svr_thread_yield();
+    }
+
+    return true;
+}
+
 bool EncoderState::render_init()
 {
-    render_frame_queue.init(RENDER_QUEUED_FRAMES);
+    render_video_encode.encoder = this;
+    render_video_encode.type = AVMEDIA_TYPE_VIDEO;
+    render_video_encode.queue.init(RENDER_QUEUED_FRAMES);
+
+    render_audio_encode.encoder = this;
+    render_audio_encode.type = AVMEDIA_TYPE_AUDIO;
+    render_audio_encode.queue.init(RENDER_QUEUED_FRAMES);
+
     render_packet_queue.init(RENDER_QUEUED_PACKETS);
     render_audio_queue.init(RENDER_QUEUED_AUDIO_BUFFERS);
-    render_recycled_video_frames.init(RENDER_QUEUED_FRAMES);
-    render_recycled_audio_frames.init(RENDER_QUEUED_FRAMES);
+    render_worker_queue.init(RENDER_QUEUED_FRAMES);
+    render_reorder.init(64);
     render_recycled_audio_buffers.init(RENDER_QUEUED_AUDIO_BUFFERS);
 
-    render_frame_wake_event_h = CreateEventA(NULL, FALSE, FALSE, NULL);
-    render_packet_wake_event_h = CreateEventA(NULL, FALSE, FALSE, NULL);
-    render_audio_wake_event_h = CreateEventA(NULL, FALSE, FALSE, NULL);
-
     return true;
 }
 
@@ -63,20 +84,42 @@ bool EncoderState::render_start()
         goto rfail;
     }
 
+    if (!pool_start())
+    {
+        error("ERROR: Could not allocate render frames\n");
+        goto rfail;
+    }
+
+    svr_atom_store(&render_workers_status, 1);
+
+    render_reorder.clear(0);
+    svr_stitch_start(&render_stitch_times);
+
+    if (render_num_video_workers > 0)
+    {
+        if (!render_start_video_workers())
+        {
+            goto rfail;
+        }
+    }
+
+    render_video_encode.ctx = render_video_ctx;
+    render_video_encode.stream = render_video_stream;
+
+    render_audio_encode.ctx = render_audio_ctx;
+    render_audio_encode.stream = render_audio_stream;
+
     // Threads are ok at the start.
-    svr_atom_store(&render_frame_thread_status, 1);
+    svr_atom_store(&render_video_encode.status, 1);
+    svr_atom_store(&render_audio_encode.status, 1);
     svr_atom_store(&render_packet_thread_status, 1);
     svr_atom_store(&render_audio_thread_status, 1);
 
-    render_frame_thread_message[0] = 0;
+    render_video_encode.message[0] = 0;
+    render_audio_encode.message[0] = 0;
     render_packet_thread_message[0] = 0;
     render_audio_thread_message[0] = 0;
 
-    // Be extra sure that these events are not triggered, so the threads enter a waiting state.
-    ResetEvent(render_frame_wake_event_h);
-    ResetEvent(render_packet_wake_event_h);
-    ResetEvent(render_audio_wake_event_h);
-
     svr_atom_store(&render_started, 1);
 
     render_start_threads();
@@ -92,15 +135,12 @@ rexit:
 
 void EncoderState::render_free_static()
 {
-    svr_maybe_close_handle(&render_frame_wake_event_h);
-    svr_maybe_close_handle(&render_packet_wake_event_h);
-    svr_maybe_close_handle(&render_audio_wake_event_h);
-
-    render_frame_queue.free();
+    render_video_encode.queue.free();
+    render_audio_encode.queue.free();
     render_packet_queue.free();
     render_audio_queue.free();
-    render_recycled_video_frames.free();
-    render_recycled_audio_frames.free();
+    render_worker_queue.free();
+    render_reorder.free();
     render_recycled_audio_buffers.free();
 }
 
@@ -115,6 +155,21 @@ void EncoderState::render_free_dynamic()
             render_submit_texture();
         }
 
+        render_finish_texture_download();
+
+        // Send flush to audio thread if we started it.
+        // This must be done before the audio fifo is flushed, since the audio thread submits to it and to the audio encode thread.
+
+        if (render_audio_thread.handle)
+        {
+            RenderAudioThreadInput flush_audio_buf = {};
+            render_push_wait(&render_audio_queue, &flush_audio_buf, &render_audio_thread_status);
+
+            svr_doorbell_ring(&render_audio_bell); // Notify audio thread.
+
+            svr_thread_join(&render_audio_thread); // Wait for audio thread to finish.
+        }
+
         // Flush out all of the remaining samples in the audio fifo for encode.
 
         if (movie_params.use_audio)
@@ -122,21 +177,14 @@ void EncoderState::render_free_dynamic()
             render_flush_audio_fifo();
         }
 
-        // Send flush to audio thread if we started it.
+        // Send flushes to video workers or video encode thread, and audio encode thread.
 
-        if (render_audio_thread_h)
+        if (render_num_video_workers > 0)
         {
-            RenderAudioThreadInput flush_audio_buf = {};
-            render_audio_queue.push(&flush_audio_buf);
-
-            SetEvent(render_audio_wake_event_h); // Notify audio thread.
-
-            WaitForSingleObject(render_audio_thread_h, INFINITE); // Wait for audio thread to finish.
+            render_stop_video_workers();
         }
 
-        // Send flushes to frame thread.
-
-        if (render_video_ctx)
+        else if (render_video_ctx)
         {
             render_encode_video_frame(NULL);
         }
@@ -146,27 +194,53 @@ void EncoderState::render_free_dynamic()
             render_encode_audio_frame(NULL);
         }
 
-        WaitForSingleObject(render_frame_thread_h, INFINITE); // Wait for frame thread to finish.
+        // Wait for encode threads to finish. The streams are flushed independently, so the audio is not held up by the video.
+
+        svr_thread_join(&render_video_encode.thread);
+        svr_thread_join(&render_audio_encode.thread);
+
+        // All packets have been sent to the packet thread at this point, so the flush packet will be the last.
 
         // Flush the packet thread.
 
-        AVPacket* flush_packet = NULL;
-        render_packet_queue.push(&flush_packet);
-        SetEvent(render_packet_wake_event_h); // Notify packet thread.
+        RenderPacketThreadInput flush_packet = {};
+        flush_packet.reorder_idx = -1;
+        render_push_wait(&render_packet_queue, &flush_packet, &render_packet_thread_status);
+        svr_doorbell_ring(&render_packet_bell); // Notify packet thread.
 
-        WaitForSingleObject(render_packet_thread_h, INFINITE); // Wait for packet thread to finish.
+        svr_thread_join(&render_packet_thread); // Wait for packet thread to finish.
 
         av_write_trailer(render_output_context); // Can only be written if avformat_write_header was called.
     }
 
     else
     {
+        // The frame that is being copied cannot be encoded anymore.
+        AVFrame* download_frame = vid_finish_download();
+        av_frame_free(&download_frame);
+
         // Wake threads so they can exit (if they even started).
         // Since render_started is 0, they will immediately exit.
+        // They must be gone before the queues are emptied below, as the queues only allow one consumer.
+
+        svr_doorbell_ring(&render_video_encode.bell);
+        svr_doorbell_ring(&render_audio_encode.bell);
+        svr_doorbell_ring(&render_packet_bell);
+        svr_doorbell_ring(&render_audio_bell);
+        svr_doorbell_ring(&render_worker_bell);
 
-        SetEvent(render_frame_wake_event_h);
-        SetEvent(render_packet_wake_event_h);
-        SetEvent(render_audio_wake_event_h);
+        svr_thread_join(&render_video_encode.thread);
+        svr_thread_join(&render_audio_encode.thread);
+        svr_thread_join(&render_packet_thread);
+        svr_thread_join(&render_audio_thread);
+
+        if (render_video_workers)
+        {
+            for (s32 i = 0; i < render_num_video_workers; i++)
+            {
+                svr_thread_join(&render_video_workers[i].thread);
+            }
+        }
     }
 
     if (render_output_context)
@@ -177,13 +251,21 @@ void EncoderState::render_free_dynamic()
         render_output_context = NULL;
     }
 
+    render_free_video_workers();
+
     avcodec_free_context(&render_video_ctx);
     avcodec_free_context(&render_audio_ctx);
 
     render_video_stream = NULL;
     render_audio_stream = NULL;
 
+    render_video_encode.ctx = NULL;
+    render_video_encode.stream = NULL;
+    render_audio_encode.ctx = NULL;
+    render_audio_encode.stream = NULL;
+
     render_video_info = NULL;
+    render_video_codec = NULL;
     render_audio_info = NULL;
 
     render_container = NULL;
@@ -193,12 +275,12 @@ void EncoderState::render_free_dynamic()
     render_video_pts = 0;
     render_audio_pts = 0;
 
-    render_free_recycled_stuff();
-    render_free_lingering_thread_inputs();
+    render_video_chunk_frames = 0;
+    render_video_chunk_idx = 0;
+    render_chunk_worker = NULL;
 
-    svr_maybe_close_handle(&render_frame_thread_h);
-    svr_maybe_close_handle(&render_packet_thread_h);
-    svr_maybe_close_handle(&render_audio_thread_h);
+    render_free_recycled_audio_buffers();
+    render_free_lingering_thread_inputs();
 }
 
 // Find the structure matching the configuration in the movie profile.
@@ -240,6 +322,7 @@ bool EncoderState::render_setup_audio_info()
 bool EncoderState::render_init_output_context()
 {
     bool ret = false;
+    s32 res;
 
     // Guess container based on extension.
     render_container = av_guess_format(NULL, movie_params.dest_file, NULL);
@@ -256,7 +339,7 @@ bool EncoderState::render_init_output_context()
         goto rfail;
     }
 
-    s32 res = avformat_alloc_output_context2(&render_output_context, render_container, NULL, NULL);
+    res = avformat_alloc_output_context2(&render_output_context, render_container, NULL, NULL);
 
     if (res < 0)
     {
@@ -285,6 +368,9 @@ bool EncoderState::render_init_video()
 {
     bool ret = false;
     s32 res;
+    AVRational video_q;
+    const AVCodec* codec;
+    s32 num_threads;
 
     if (!render_setup_video_info())
     {
@@ -292,9 +378,9 @@ bool EncoderState::render_init_video()
     }
 
     // Time base for video. Always based in seconds, so 1/60 for example.
-    AVRational video_q = av_make_q(1, movie_params.video_fps);
+    video_q = av_make_q(1, movie_params.video_fps);
 
-    const AVCodec* codec = avcodec_find_encoder_by_name(render_video_info->codec_name);
+    codec = avcodec_find_encoder_by_name(render_video_info->codec_name);
 
     // Maybe seems silly but this is possible to happen if someone replaces the dlls or something.
     if (codec == NULL)
@@ -321,40 +407,29 @@ bool EncoderState::render_init_video()
 
     render_video_stream->id = render_output_context->nb_streams - 1;
 
-    render_video_ctx = avcodec_alloc_context3(codec);
+    render_video_stream->time_base = video_q;
+    render_video_stream->avg_frame_rate = av_inv_q(video_q);
 
-    if (render_video_ctx == NULL)
-    {
-        error("ERROR: Could not create video render codec context\n");
-        goto rfail;
-    }
+    render_video_codec = codec;
 
-    render_video_ctx->bit_rate = 0;
-    render_video_ctx->width = movie_params.video_width;
-    render_video_ctx->height = movie_params.video_height;
-    render_video_ctx->time_base = video_q;
-    render_video_ctx->pix_fmt = render_video_info->pixel_format;
-    render_video_ctx->color_primaries = AVCOL_PRI_BT709;
-    render_video_ctx->color_trc = AVCOL_TRC_BT709;
-    render_video_ctx->color_range = AVCOL_RANGE_MPEG;
-    render_video_ctx->colorspace = AVCOL_SPC_BT709;
+    // With several workers every context gets its share of the threads.
+    // Otherwise use all threads.
+    num_threads = 0;
 
-    render_video_stream->time_base = render_video_ctx->time_base;
-    render_video_stream->avg_frame_rate = av_inv_q(render_video_ctx->time_base);
-
-    if (render_output_context->oformat->flags & AVFMT_GLOBALHEADER)
+    if (render_use_video_workers())
     {
-        render_video_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
-    }
+        render_num_video_workers = movie_params.encode_workers;
+        num_threads = svr_max(1, av_cpu_count() / render_num_video_workers);
 
-    render_video_ctx->thread_count = 0; // Use all threads.
-
-    if (render_video_info->setup)
-    {
-        (this->*render_video_info->setup)();
+        if (render_use_video_chunks())
+        {
+            render_video_chunk_frames = movie_params.x264_chunk_length * movie_params.video_fps;
+        }
     }
 
-    res = avcodec_open2(render_video_ctx, codec, NULL);
+    // When encoding in chunks, this context is not used for encoding but it has the stream parameters and headers
+    // that every chunk will have.
+    res = render_open_video_ctx(num_threads, &render_video_ctx);
 
     if (res < 0)
     {
@@ -379,17 +454,78 @@ rexit:
     return ret;
 }
 
+// Create and open a video codec context according to the movie profile.
+// Several contexts can be created when encoding in parallel, so this can be called by the video workers too.
+// Returns a negative error code on failure.
+s32 EncoderState::render_open_video_ctx(s32 num_threads, AVCodecContext** dest)
+{
+    s32 res = 0;
+
+    // Time base for video. Always based in seconds, so 1/60 for example.
+    AVRational video_q = av_make_q(1, movie_params.video_fps);
+
+    AVCodecContext* ctx = avcodec_alloc_context3(render_video_codec);
+
+    if (ctx == NULL)
+    {
+        res = AVERROR(ENOMEM);
+        goto rfail;
+    }
+
+    ctx->bit_rate = 0;
+    ctx->width = movie_params.video_width;
+    ctx->height = movie_params.video_height;
+    ctx->time_base = video_q;
+    ctx->pix_fmt = render_video_info->pixel_format;
+    ctx->color_primaries = AVCOL_PRI_BT709;
+    ctx->color_trc = AVCOL_TRC_BT709;
+    ctx->color_range = AVCOL_RANGE_MPEG;
+    ctx->colorspace = AVCOL_SPC_BT709;
+
+    if (render_output_context->oformat->flags & AVFMT_GLOBALHEADER)
+    {
+        ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    ctx->thread_count = num_threads;
+
+    if (render_video_info->setup)
+    {
+        (this->*render_video_info->setup)(ctx);
+    }
+
+    res = avcodec_open2(ctx, render_video_codec, NULL);
+
+    if (res < 0)
+    {
+        goto rfail;
+    }
+
+    *dest = ctx;
+
+    goto rexit;
+
+rfail:
+    avcodec_free_context(&ctx);
+
+rexit:
+    return res;
+}
+
 bool EncoderState::render_init_audio()
 {
     bool ret = false;
     s32 res;
+    s32 hz;
+    AVRational audio_q;
+    const AVCodec* codec;
 
     if (!render_setup_audio_info())
     {
         goto rfail;
     }
 
-    s32 hz = movie_params.audio_hz;
+    hz = movie_params.audio_hz;
 
     // Set from encoder if it requires a set sample rate.
     if (render_audio_info->hz != 0)
@@ -398,9 +534,9 @@ bool EncoderState::render_init_audio()
     }
 
     // Time base for video. Always based in seconds, so 1/44100 for example.
-    AVRational audio_q = av_make_q(1, hz);
+    audio_q = av_make_q(1, hz);
 
-    const AVCodec* codec = avcodec_find_encoder_by_name(render_audio_info->codec_name);
+    codec = avcodec_find_encoder_by_name(render_audio_info->codec_name);
 
     // Maybe seems silly but this is possible to happen if someone replaces the dlls or something.
     if (codec == NULL)
@@ -455,7 +591,7 @@ bool EncoderState::render_init_audio()
 
     if (render_audio_info->setup)
     {
-        (this->*render_audio_info->setup)();
+        (this->*render_audio_info->setup)(render_audio_ctx);
     }
 
     res = avcodec_open2(render_audio_ctx, codec, NULL);
@@ -494,10 +630,17 @@ rexit:
 
 bool EncoderState::render_check_thread_errors()
 {
-    // Frame thread broke. Nothing more can be submitted.
-    if (svr_atom_load(&render_frame_thread_status) == 0)
+    // Video encode thread broke. Nothing more can be submitted.
+    if (svr_atom_load(&render_video_encode.status) == 0)
     {
-        error(render_frame_thread_message);
+        error(render_video_encode.message);
+        return true;
+    }
+
+    // Audio encode thread broke. Nothing more can be submitted.
+    if (svr_atom_load(&render_audio_encode.status) == 0)
+    {
+        error(render_audio_encode.message);
         return true;
     }
 
@@ -515,12 +658,60 @@ bool EncoderState::render_check_thread_errors()
         return true;
     }
 
+    // A video worker broke. Nothing more can be submitted.
+    if (svr_atom_load(&render_workers_status) == 0)
+    {
+        for (s32 i = 0; i < render_num_video_workers; i++)
+        {
+            if (render_video_workers[i].message[0])
+            {
+                error(render_video_workers[i].message);
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+// Same as render_check_thread_errors but can be used by any thread. Does not report the error.
+bool EncoderState::render_any_thread_failed()
+{
+    if (svr_atom_load(&render_video_encode.status) == 0)
+    {
+        return true;
+    }
+
+    if (svr_atom_load(&render_audio_encode.status) == 0)
+    {
+        return true;
+    }
+
+    if (svr_atom_load(&render_packet_thread_status) == 0)
+    {
+        return true;
+    }
+
+    if (svr_atom_load(&render_audio_thread_status) == 0)
+    {
+        return true;
+    }
+
+    if (svr_atom_load(&render_workers_status) == 0)
+    {
+        return true;
+    }
+
     return false;
 }
 
-// The shared game texture has been updated at this point.
-bool EncoderState::render_receive_video()
+// The shared game texture of this slot has been updated at this point.
+bool EncoderState::render_receive_video(s32 slot_idx)
 {
+    SVR_TRACE_SCOPE("render_receive_video");
+
     bool ret = false;
 
     if (render_check_thread_errors())
@@ -528,15 +719,41 @@ bool EncoderState::render_receive_video()
         goto rfail;
     }
 
-    // Submit enough textures so there is enough distance between the write head and the read head.
-    // This way we can mitigate the pipeline stalls a bit.
+    // Frames in memory are converted right away and do not go through the download textures.
+    if (vid_frame_mem.ptr)
+    {
+        s64 frame_size = (s64)movie_params.video_width * movie_params.video_height * 4;
+
+        AVFrame* frame = vid_convert_on_cpu((u8*)vid_frame_mem.ptr + slot_idx * frame_size);
+        frame->pts = render_video_pts;
+
+        render_video_pts++;
+
+        render_encode_video_frame(frame);
 
-    vid_push_texture_for_conversion();
+        ret = true;
+        goto rexit;
+    }
 
-    if (vid_can_map_now())
+#ifdef _WIN32
     {
-        render_submit_texture();
+        // Submit enough textures so there is enough distance between the write head and the read head.
+        // This way we can mitigate the pipeline stalls a bit.
+
+        s64 start = svr_prof_get_real_time();
+
+        vid_push_texture_for_conversion(slot_idx);
+
+        stats_add_stage(SVR_STATS_ENCODER_STAGE_CONVERT, start);
+
+        SVR_TRACE_COUNTER("vid_download_distance", render_download_write_idx - render_download_read_idx);
+
+        if (vid_can_map_now())
+        {
+            render_submit_texture();
+        }
     }
+#endif
 
     ret = true;
     goto rexit;
@@ -547,9 +764,11 @@ rexit:
     return ret;
 }
 
-// The shared audio samples have been updated at this point.
-bool EncoderState::render_receive_audio()
+// The samples are in the audio ring and are given back after this returns.
+bool EncoderState::render_receive_audio(void* samples, s32 num_samples)
 {
+    SVR_TRACE_SCOPE("render_receive_audio");
+
     bool ret = false;
 
     if (render_check_thread_errors())
@@ -562,25 +781,32 @@ bool EncoderState::render_receive_audio()
 
     if (audio_need_conversion())
     {
-        RenderAudioThreadInput input = render_get_new_audio_buffer(shared_mem_ptr->waiting_audio_samples);
+        RenderAudioThreadInput input = render_get_new_audio_buffer(num_samples);
+
+        s32 size = render_get_audio_buffer_size(num_samples);
+        memcpy(input.mem, samples, size);
 
-        s32 size = render_get_audio_buffer_size(shared_mem_ptr->waiting_audio_samples);
-        memcpy(input.mem, shared_audio_buffer, size);
+        if (!render_push_wait(&render_audio_queue, &input, &render_audio_thread_status))
+        {
+            svr_free(input.mem);
+        }
 
-        render_audio_queue.push(&input);
+        SVR_TRACE_COUNTER("render_audio_queue", render_audio_queue.size());
 
-        SetEvent(render_audio_wake_event_h); // Notify audio thread.
+        svr_doorbell_ring(&render_audio_bell); // Notify audio thread.
     }
 
     else
     {
         RenderAudioThreadInput input = {};
-        input.mem = shared_audio_buffer;
-        input.num_samples = shared_mem_ptr->waiting_audio_samples;
+        input.mem = samples;
+        input.num_samples = num_samples;
 
         render_give_audio_thread_input(&input);
     }
 
+    stats_encoder.audio_samples += num_samples;
+
     ret = true;
     goto rexit;
 
@@ -592,6 +818,8 @@ rexit:
 
 void EncoderState::render_give_audio_thread_input(RenderAudioThreadInput* input)
 {
+    SVR_TRACE_SCOPE("render_give_audio");
+
     audio_convert_to_codec_samples(input);
 
     // Must submit everything in the fifo so things don't start drifting away.
@@ -631,7 +859,7 @@ void EncoderState::render_submit_audio_fifo()
 // Common code for render_submit_audio_fifo and render_flush_audio_fifo.
 void EncoderState::render_encode_frame_from_audio_fifo(s32 num_samples)
 {
-    AVFrame* frame = render_get_new_audio_frame();
+    AVFrame* frame = pool_get_audio_frame();
     frame->pts = render_audio_pts;
 
     // Override the number of samples.
@@ -648,108 +876,51 @@ void EncoderState::render_encode_frame_from_audio_fifo(s32 num_samples)
 
 void EncoderState::render_encode_video_frame(AVFrame* frame)
 {
-    render_encode_frame(render_video_ctx, render_video_stream, frame, AVMEDIA_TYPE_VIDEO);
-}
-
-void EncoderState::render_encode_audio_frame(AVFrame* frame)
-{
-    render_encode_frame(render_audio_ctx, render_audio_stream, frame, AVMEDIA_TYPE_AUDIO);
-}
-
-void EncoderState::render_encode_frame(AVCodecContext* ctx, AVStream* stream, AVFrame* frame, AVMediaType type)
-{
-    // Send to frame thread.
-
-    RenderFrameThreadInput input = {};
-    input.ctx = ctx;
-    input.frame = frame;
-    input.stream = stream;
-    input.type = type;
-
-    render_frame_queue.push(&input);
-
-    SetEvent(render_frame_wake_event_h); // Notify frame thread.
-}
-
-AVFrame* EncoderState::render_get_new_video_frame()
-{
-    AVFrame* ret = NULL;
-    s32 res;
-
-    // Fast and good if we can reuse.
-    if (render_recycled_video_frames.pull(&ret))
+    // Send to any video worker, or to the worker of the chunk that the frame is in.
+    // The flush frames for the workers are sent in render_stop_video_workers.
+    if (render_num_video_workers > 0 && frame)
     {
-        return ret;
-    }
-
-    ret = av_frame_alloc();
+        if (render_video_chunk_frames > 0)
+        {
+            render_give_chunk_frame(frame);
+            return;
+        }
 
-    if (ret == NULL)
-    {
-        error("ERROR: Could not create render video encode frame\n");
-        goto rfail;
-    }
+        RenderWorkerInput input = {};
+        input.frame = frame;
+        input.chunk_idx = -1;
 
-    ret->format = render_video_ctx->pix_fmt;
-    ret->width = render_video_ctx->width;
-    ret->height = render_video_ctx->height;
+        if (!render_push_wait(&render_worker_queue, &input, &render_workers_status))
+        {
+            av_frame_free(&input.frame);
+        }
 
-    // Allocate buffers for frame.
-    res = av_frame_get_buffer(ret, 0);
+        SVR_TRACE_COUNTER("render_worker_queue", render_worker_queue.size());
 
-    if (res < 0)
-    {
-        error("ERROR: Could not allocate render video encode frame\n");
-        goto rfail;
+        svr_doorbell_ring(&render_worker_bell); // Notify workers.
+        return;
     }
 
-    goto rexit;
-
-rfail:
-
-rexit:
-    return ret;
+    render_encode_frame(&render_video_encode, frame);
 }
 
-AVFrame* EncoderState::render_get_new_audio_frame()
+void EncoderState::render_encode_audio_frame(AVFrame* frame)
 {
-    AVFrame* ret = NULL;
-    s32 res;
-
-    // Fast and good if we can reuse.
-    if (render_recycled_audio_frames.pull(&ret))
-    {
-        return ret;
-    }
-
-    ret = av_frame_alloc();
-
-    if (ret == NULL)
-    {
-        error("ERROR: Could not create render audio encode frame\n");
-        goto rfail;
-    }
-
-    ret->format = render_audio_ctx->sample_fmt;
-    ret->ch_layout = render_audio_ctx->ch_layout;
-    ret->sample_rate = render_audio_ctx->sample_rate;
-    ret->nb_samples = render_audio_ctx->frame_size; // All submitted audio frames will have this amount of samples, except the last.
+    render_encode_frame(&render_audio_encode, frame);
+}
 
-    // Allocate buffers for frame.
-    res = av_frame_get_buffer(ret, 0);
+void EncoderState::render_encode_frame(RenderEncodeThread* thread, AVFrame* frame)
+{
+    // Send to encode thread of the stream.
 
-    if (res < 0)
+    if (!render_push_wait(&thread->queue, &frame, &thread->status))
     {
-        error("ERROR: Could not allocate render audio encode frame\n");
-        goto rfail;
+        av_frame_free(&frame);
     }
 
-    goto rexit;
+    SVR_TRACE_COUNTER(thread->type == AVMEDIA_TYPE_VIDEO ? "render_video_encode_queue" : "render_audio_encode_queue", thread->queue.size());
 
-rfail:
-
-rexit:
-    return ret;
+    svr_doorbell_ring(&thread->bell); // Notify encode thread.
 }
 
 RenderAudioThreadInput EncoderState::render_get_new_audio_buffer(s32 num_samples)
@@ -779,20 +950,8 @@ s32 EncoderState::render_get_audio_buffer_size(s32 num_samples)
 }
 
 // Free the allocated buffers in the recycled stuff.
-void EncoderState::render_free_recycled_stuff()
+void EncoderState::render_free_recycled_audio_buffers()
 {
-    AVFrame* frame = NULL;
-
-    while (render_recycled_video_frames.pull(&frame))
-    {
-        av_frame_free(&frame);
-    }
-
-    while (render_recycled_audio_frames.pull(&frame))
-    {
-        av_frame_free(&frame);
-    }
-
     RenderAudioThreadInput audio_input = {};
 
     while (render_recycled_audio_buffers.pull(&audio_input))
@@ -812,28 +971,69 @@ void EncoderState::render_free_lingering_thread_inputs()
         svr_free(audio_input.mem);
     }
 
-    AVPacket* packet_input = NULL;
+    RenderPacketThreadInput packet_input = {};
 
     while (render_packet_queue.pull(&packet_input))
     {
-        av_packet_free(&packet_input);
+        av_packet_free(&packet_input.packet);
+    }
+
+    for (s32 i = 0; i < render_reorder.size(); i++)
+    {
+        av_packet_free(&render_reorder.heap[i].item);
+    }
+
+    render_reorder.clear(0);
+
+    RenderWorkerInput worker_input = {};
+
+    while (render_worker_queue.pull(&worker_input))
+    {
+        av_frame_free(&worker_input.frame);
     }
 
-    RenderFrameThreadInput frame_input = {};
+    AVFrame* frame_input = NULL;
+
+    while (render_video_encode.queue.pull(&frame_input))
+    {
+        av_frame_free(&frame_input);
+    }
 
-    while (render_frame_queue.pull(&frame_input))
+    while (render_audio_encode.queue.pull(&frame_input))
     {
-        av_frame_free(&frame_input.frame);
+        av_frame_free(&frame_input);
     }
 }
 
 void EncoderState::render_submit_texture()
 {
-    AVFrame* frame = render_get_new_video_frame();
+    SVR_TRACE_SCOPE("render_submit_texture");
+
+    // Only one frame is copied at a time, and it has had the time that the game took for the next frame.
+    render_finish_texture_download();
+
+#ifdef _WIN32
+    AVFrame* frame = pool_get_video_frame();
     frame->pts = render_video_pts;
 
-    vid_download_texture_into_frame(frame);
-    render_encode_video_frame(frame);
+    vid_start_download(frame);
 
     render_video_pts++;
+#endif
+}
+
+// Encode the frame that was being copied in the background, if any.
+void EncoderState::render_finish_texture_download()
+{
+    SVR_TRACE_SCOPE("render_finish_texture_download");
+
+    s64 start = svr_prof_get_real_time();
+
+    AVFrame* frame = vid_finish_download();
+
+    if (frame)
+    {
+        stats_add_stage(SVR_STATS_ENCODER_STAGE_DOWNLOAD, start);
+        render_encode_video_frame(frame);
+    }
 }
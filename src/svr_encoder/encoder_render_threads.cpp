@@ -1,56 +1,160 @@
 #include "encoder_priv.h"
 
-DWORD CALLBACK render_frame_thread_proc(LPVOID param)
+void render_encode_thread_proc(void* param)
 {
-    SetThreadDescription(GetCurrentThread(), L"RENDER FRAME THREAD");
+    RenderEncodeThread* thread = (RenderEncodeThread*)param;
 
-    EncoderState* encoder_ptr = (EncoderState*)param;
-    encoder_ptr->render_frame_proc();
+    if (thread->type == AVMEDIA_TYPE_VIDEO)
+    {
+#ifdef _WIN32
+        SetThreadDescription(GetCurrentThread(), L"RENDER VIDEO ENCODE THREAD");
+#endif
+        svr_trace_set_thread_name("RENDER VIDEO ENCODE THREAD");
+    }
 
-    return 0; // Not used.
+    else
+    {
+#ifdef _WIN32
+        SetThreadDescription(GetCurrentThread(), L"RENDER AUDIO ENCODE THREAD");
+#endif
+        svr_trace_set_thread_name("RENDER AUDIO ENCODE THREAD");
+    }
+
+    thread->encoder->render_encode_proc(thread);
 }
 
-DWORD CALLBACK render_packet_thread_proc(LPVOID param)
+void render_packet_thread_proc(void* param)
 {
+#ifdef _WIN32
     SetThreadDescription(GetCurrentThread(), L"RENDER PACKET THREAD");
+#endif
+    svr_trace_set_thread_name("RENDER PACKET THREAD");
 
     EncoderState* encoder_ptr = (EncoderState*)param;
     encoder_ptr->render_packet_proc();
-
-    return 0; // Not used.
 }
 
-DWORD CALLBACK render_audio_thread_proc(LPVOID param)
+void render_audio_thread_proc(void* param)
 {
+#ifdef _WIN32
     SetThreadDescription(GetCurrentThread(), L"RENDER AUDIO THREAD");
+#endif
+    svr_trace_set_thread_name("RENDER AUDIO THREAD");
 
     EncoderState* encoder_ptr = (EncoderState*)param;
     encoder_ptr->render_audio_proc();
-
-    return 0; // Not used.
 }
 
 bool EncoderState::render_start_threads()
 {
-    render_frame_thread_h = CreateThread(NULL, 0, render_frame_thread_proc, this, 0, NULL);
-    render_packet_thread_h = CreateThread(NULL, 0, render_packet_thread_proc, this, 0, NULL);
+    svr_thread_start(&render_packet_thread, render_packet_thread_proc, this);
+
+    // The video workers do their own encoding.
+    if (render_num_video_workers == 0)
+    {
+        svr_thread_start(&render_video_encode.thread, render_encode_thread_proc, &render_video_encode);
+    }
+
+    if (render_audio_ctx)
+    {
+        svr_thread_start(&render_audio_encode.thread, render_encode_thread_proc, &render_audio_encode);
+    }
 
     if (audio_need_conversion())
     {
-        render_audio_thread_h = CreateThread(NULL, 0, render_audio_thread_proc, this, 0, NULL);
+        svr_thread_start(&render_audio_thread, render_audio_thread_proc, this);
+    }
+
+    for (s32 i = 0; i < render_num_video_workers; i++)
+    {
+        RenderVideoWorker* worker = &render_video_workers[i];
+        svr_thread_start(&worker->thread, render_video_worker_thread_proc, worker);
     }
 
     return true;
 }
 
-// In frame thread.
-void EncoderState::render_frame_proc()
+// Receive all available packets from an encoder and send them to the packet thread.
+// Packets can be marked to be put back in order if several encoders are used for the same stream.
+// The chunk index is only used for RENDER_PACKET_ORDER_CHUNK.
+// Returns a negative error code on failure.
+s32 EncoderState::render_receive_packets(AVCodecContext* ctx, AVStream* stream, RenderPacketOrder order, s64 chunk_idx)
+{
+    s32 res = 0;
+
+    while (true)
+    {
+        AVPacket* packet = pool_get_packet();
+
+        res = avcodec_receive_packet(ctx, packet);
+
+        // This will return AVERROR(EAGAIN) when we need to send more data.
+        // This will return AVERROR_EOF when we are sending a flush frame.
+        if (res == AVERROR(EAGAIN) || res == AVERROR_EOF)
+        {
+            pool_put_packet(packet); // Nothing was written to it.
+            res = 0;
+            break;
+        }
+
+        if (res < 0)
+        {
+            pool_put_packet(packet);
+            break;
+        }
+
+        RenderPacketThreadInput input = {};
+        input.packet = packet;
+        input.reorder_idx = -1;
+
+        if (order == RENDER_PACKET_ORDER_FRAME)
+        {
+            input.reorder_idx = packet->pts;
+            input.reorder_last = true;
+            packet->dts = packet->pts;
+        }
+
+        else if (order == RENDER_PACKET_ORDER_CHUNK)
+        {
+            input.reorder_idx = chunk_idx;
+
+            // The context was given the frames of the chunk from 0.
+            if (packet->pts != AV_NOPTS_VALUE && packet->dts != AV_NOPTS_VALUE)
+            {
+                svr_stitch_offset(chunk_idx * render_video_chunk_frames, &packet->pts, &packet->dts);
+            }
+        }
+
+        packet->pts = av_rescale_q(packet->pts, ctx->time_base, stream->time_base);
+        packet->dts = av_rescale_q(packet->dts, ctx->time_base, stream->time_base);
+        packet->duration = av_rescale_q(packet->duration, ctx->time_base, stream->time_base);
+        packet->stream_index = stream->index;
+
+        pool_track_packet(packet);
+
+        // Send to packet thread.
+        // The data of the packet is given back to the budget when it is freed.
+        if (!render_push_wait(&render_packet_queue, &input, &render_packet_thread_status))
+        {
+            av_packet_free(&packet);
+        }
+
+        SVR_TRACE_COUNTER("render_packet_queue", render_packet_queue.size());
+
+        svr_doorbell_ring(&render_packet_bell); // Notify packet thread.
+    }
+
+    return res;
+}
+
+// In video or audio encode thread.
+void EncoderState::render_encode_proc(RenderEncodeThread* thread)
 {
     bool run = true;
 
     while (run)
     {
-        WaitForSingleObject(render_frame_wake_event_h, INFINITE);
+        s32 ticket = svr_doorbell_prepare(&thread->bell);
 
         // Exit thread on external error.
         if (svr_atom_load(&render_started) == 0)
@@ -58,80 +162,69 @@ void EncoderState::render_frame_proc()
             break;
         }
 
-        RenderFrameThreadInput input = {};
+        AVFrame* frame = NULL;
 
-        while (render_frame_queue.pull(&input))
+        while (thread->queue.pull(&frame))
         {
-            if (input.frame == NULL)
+            if (frame == NULL)
             {
                 run = false; // Stop on flush frame.
             }
 
-            s32 res = avcodec_send_frame(input.ctx, input.frame);
+            SvrTraceScope trace_scope(thread->type == AVMEDIA_TYPE_VIDEO ? "encode_video_frame" : "encode_audio_frame");
+            StatsEncodeScope encode_scope(this, thread->type);
+
+            s64 start = svr_prof_get_real_time();
+            bool is_video_frame = frame && thread->type == AVMEDIA_TYPE_VIDEO;
+
+            s32 res = avcodec_send_frame(thread->ctx, frame);
 
             // Recycle frames.
             // We don't want to allocate big frames if we don't have to.
             // Flush frame must not be reused.
-            if (input.frame)
+            if (frame)
             {
-                if (input.type == AVMEDIA_TYPE_VIDEO)
+                if (thread->type == AVMEDIA_TYPE_VIDEO)
                 {
-                    render_recycled_video_frames.push(&input.frame);
+                    pool_put_video_frame(frame);
                 }
 
-                if (input.type == AVMEDIA_TYPE_AUDIO)
+                if (thread->type == AVMEDIA_TYPE_AUDIO)
                 {
-                    render_recycled_audio_frames.push(&input.frame);
+                    pool_put_audio_frame(frame);
                 }
             }
 
             if (res < 0)
             {
-                SVR_SNPRINTF(render_frame_thread_message, "ERROR: Could not send raw frame to encoder (%d)\n", res);
+                SVR_SNPRINTF(thread->message, "ERROR: Could not send raw frame to encoder (%d)\n", res);
                 goto rfail;
             }
 
-            while (res == 0)
-            {
-                AVPacket* packet = av_packet_alloc();
+            res = render_receive_packets(thread->ctx, thread->stream, RENDER_PACKET_ORDER_NONE, -1);
 
-                res = avcodec_receive_packet(input.ctx, packet);
-
-                // This will return AVERROR(EAGAIN) when we need to send more data.
-                // This will return AVERROR_EOF when we are sending a flush frame.
-                if (res == AVERROR(EAGAIN) || res == AVERROR_EOF)
-                {
-                    // TODO Should not allocate and then free the packet like this.
-                    av_packet_free(&packet);
-                    break;
-                }
-
-                if (res < 0)
-                {
-                    SVR_SNPRINTF(render_frame_thread_message, "ERROR: Could not receive packet from encoder (%d)\n", res);
-                    av_packet_free(&packet);
-                    goto rfail;
-                }
+            if (res < 0)
+            {
+                SVR_SNPRINTF(thread->message, "ERROR: Could not receive packet from encoder (%d)\n", res);
+                goto rfail;
+            }
 
-                if (res == 0)
-                {
-                    packet->pts = av_rescale_q(packet->pts, input.ctx->time_base, input.stream->time_base);
-                    packet->dts = av_rescale_q(packet->dts, input.ctx->time_base, input.stream->time_base);
-                    packet->duration = av_rescale_q(packet->duration, input.ctx->time_base, input.stream->time_base);
-                    packet->stream_index = input.stream->index;
-
-                    // Send to packet thread.
-                    render_packet_queue.push(&packet);
-                    SetEvent(render_packet_wake_event_h); // Notify packet thread.
-                }
+            if (is_video_frame)
+            {
+                stats_add_stage(SVR_STATS_ENCODER_STAGE_ENCODE, start);
             }
         }
+
+        if (run)
+        {
+            svr_doorbell_wait(&thread->bell, ticket);
+        }
     }
 
     goto rexit;
 
 rfail:
-    svr_atom_store(&render_frame_thread_status, 0);
+    svr_atom_store(&thread->status, 0);
 
 rexit:
     return;
@@ -144,7 +237,7 @@ void EncoderState::render_packet_proc()
 
     while (run)
     {
-        WaitForSingleObject(render_packet_wake_event_h, INFINITE);
+        s32 ticket = svr_doorbell_prepare(&render_packet_bell);
 
         // Exit thread on external error.
         if (svr_atom_load(&render_started) == 0)
@@ -152,25 +245,51 @@ void EncoderState::render_packet_proc()
             break;
         }
 
-        AVPacket* packet = NULL;
+        RenderPacketThreadInput input = {};
 
-        while (render_packet_queue.pull(&packet))
+        while (render_packet_queue.pull(&input))
         {
-            if (packet == NULL)
+            if (input.packet == NULL && input.reorder_idx < 0)
             {
                 run = false; // Stop on flush packet.
+
+                // Everything has been encoded at this point, so there should not be anything left to reorder.
+                if (!render_write_reordered_packets(true))
+                {
+                    goto rfail;
+                }
+
+                if (!render_write_packet(NULL))
+                {
+                    goto rfail;
+                }
+
+                break;
             }
 
-            s32 res = av_interleaved_write_frame(render_output_context, packet);
+            // Packets from the video workers must wait for the packets before them.
+            if (input.reorder_idx >= 0)
+            {
+                render_reorder.push(input.reorder_idx, input.reorder_last, input.packet);
 
-            av_packet_free(&packet);
+                if (!render_write_reordered_packets(false))
+                {
+                    goto rfail;
+                }
 
-            if (res < 0)
+                continue;
+            }
+
+            if (!render_write_packet(input.packet))
             {
-                SVR_SNPRINTF(render_packet_thread_message, "ERROR: Could not write encoded packet to container (%d)\n", res);
                 goto rfail;
             }
         }
+
+        if (run)
+        {
+            svr_doorbell_wait(&render_packet_bell, ticket);
+        }
     }
 
     goto rexit;
@@ -182,6 +301,81 @@ rexit:
     return;
 }
 
+// In packet thread.
+// Write packets from the video workers whose turn it is.
+// When flushing, everything that is left is written in order even if there are holes.
+bool EncoderState::render_write_reordered_packets(bool flush)
+{
+    AVPacket* packet;
+    s64 reorder_idx;
+
+    while (render_reorder.pull(&packet, &reorder_idx, flush))
+    {
+        // End of a chunk.
+        if (packet == NULL)
+        {
+            continue;
+        }
+
+        if (render_video_chunk_frames > 0 && packet->dts != AV_NOPTS_VALUE)
+        {
+            if (!svr_stitch_check(&render_stitch_times, packet->pts, packet->dts))
+            {
+                SVR_SNPRINTF(render_packet_thread_message, "ERROR: Video chunk %lld does not follow the chunk before it (pts %lld, dts %lld)\n",
+                             (long long)reorder_idx, (long long)packet->pts, (long long)packet->dts);
+                av_packet_free(&packet);
+                return false;
+            }
+        }
+
+        if (!render_write_packet(packet))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// In packet thread.
+bool EncoderState::render_write_packet(AVPacket* packet)
+{
+    SVR_TRACE_SCOPE("render_write_packet");
+
+    s64 start = svr_prof_get_real_time();
+    s32 size = packet ? packet->size : 0;
+    bool is_video = packet && render_video_stream && packet->stream_index == render_video_stream->index;
+
+    s32 res = av_interleaved_write_frame(render_output_context, packet);
+
+    // The muxer takes the data so the packet is blank now and can be reused.
+    // The data is given back to the budget when the muxer lets go of it, which may be after later packets are written.
+    if (packet)
+    {
+        pool_put_packet(packet);
+    }
+
+    if (res < 0)
+    {
+        SVR_SNPRINTF(render_packet_thread_message, "ERROR: Could not write encoded packet to container (%d)\n", res);
+        return false;
+    }
+
+    if (size > 0)
+    {
+        stats_add_stage(SVR_STATS_ENCODER_STAGE_WRITE, start);
+    }
+
+    if (is_video)
+    {
+        svr_atom_add(&stats_frames_written, 1);
+    }
+
+    svr_atom_store(&stats_bytes_written, avio_tell(render_output_context->pb));
+
+    return true;
+}
+
 // In audio thread.
 void EncoderState::render_audio_proc()
 {
@@ -189,7 +383,7 @@ void EncoderState::render_audio_proc()
 
     while (run)
     {
-        WaitForSingleObject(render_audio_wake_event_h, INFINITE);
+        s32 ticket = svr_doorbell_prepare(&render_audio_bell);
 
         // Exit thread on external error.
         if (svr_atom_load(&render_started) == 0)
@@ -211,13 +405,10 @@ void EncoderState::render_audio_proc()
 
             render_recycled_audio_buffers.push(&buffer); // Give back the audio buffer.
         }
-    }
 
-    goto rexit;
-
-rfail:
-    svr_atom_store(&render_audio_thread_status, 0);
-
-rexit:
-    return;
+        if (run)
+        {
+            svr_doorbell_wait(&render_audio_bell, ticket);
+        }
+    }
 }
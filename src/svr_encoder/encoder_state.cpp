@@ -1,34 +1,47 @@
 #include "encoder_priv.h"
 
-bool EncoderState::init(HANDLE in_shared_mem_h)
+bool EncoderState::init(const char* shared_mem_id, EncoderHostParams* in_host)
 {
     bool ret = false;
 
-    main_thread_id = GetCurrentThreadId();
+    main_thread_id = svr_thread_get_current_id();
 
-    shared_mem_h = in_shared_mem_h;
+    svr_prof_init(); // Every module has its own timer state.
 
-    // At this point, the shared memory will already have some data already filled in.
-    shared_mem_ptr = (EncoderSharedMem*)MapViewOfFile(shared_mem_h, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+    svr_trace_set_thread_name("ENCODER MAIN THREAD");
+
+    host = in_host;
 
-    if (shared_mem_ptr == NULL)
+    if (host)
     {
-        error("ERROR: Could not view encoder shared memory (%lu)\n", GetLastError());
-        goto rfail;
+        SVR_COPY_STRING(host->resource_path, resource_path);
     }
 
-    game_wake_event_h = (HANDLE)shared_mem_ptr->game_wake_event_h;
-    encoder_wake_event_h = (HANDLE)shared_mem_ptr->encoder_wake_event_h;
-    shared_audio_buffer = (u8*)shared_mem_ptr + shared_mem_ptr->audio_buffer_offset;
-
-    game_process = OpenProcess(SYNCHRONIZE, FALSE, shared_mem_ptr->game_pid);
+    else
+    {
+        SVR_COPY_STRING(".", resource_path); // The process is started in the SVR directory.
+    }
 
-    if (game_process == NULL)
+    // At this point, the shared memory will already have some data already filled in.
+    // The events in there are already created too.
+    if (!svr_ipc_open_mem(shared_mem_id, &shared_mem))
     {
-        error("ERROR: Could not open game process (%lu)\n", GetLastError());
+        svr_log("ERROR: Could not view encoder shared memory (%u)\n", svr_get_last_error());
         goto rfail;
     }
 
+    shared_mem_ptr = (EncoderSharedMem*)shared_mem.ptr;
+
+    // Inside the game process the handle would be our own process, which can never be set while we wait on it.
+    if (host == NULL)
+    {
+        if (!svr_ipc_open_process(shared_mem_ptr->game_pid, &game_process))
+        {
+            error("ERROR: Could not open game process (%u)\n", svr_get_last_error());
+            goto rfail;
+        }
+    }
+
     if (!vid_init())
     {
         goto rfail;
@@ -44,6 +57,11 @@ bool EncoderState::init(HANDLE in_shared_mem_h)
         goto rfail;
     }
 
+    if (!pool_init())
+    {
+        goto rfail;
+    }
+
     ret = true;
     goto rexit;
 
@@ -62,6 +80,15 @@ void EncoderState::start_event()
     // want to have our own copy either way.
     movie_params = shared_mem_ptr->movie_params;
 
+    // Started before the threads so they are all in the trace.
+    if (movie_params.use_trace)
+    {
+        svr_trace_start();
+        movie_trace = true;
+    }
+
+    stats_start();
+
     if (!render_start())
     {
         goto rfail;
@@ -94,6 +121,13 @@ void EncoderState::start_event()
 
 rfail:
     free_dynamic();
+    stats_end();
+
+    if (movie_trace)
+    {
+        svr_trace_stop();
+        movie_trace = false;
+    }
 
 rexit:
     return;
@@ -103,124 +137,157 @@ void EncoderState::stop_event()
 {
     svr_log("Ending encoder\n");
 
+    bool was_started = svr_atom_load(&render_started);
+
     free_dynamic();
+    stats_end();
+
+    if (was_started)
+    {
+        pool_log_usage();
+    }
+
+    // The threads of the movie have stopped now, and the work threads have nothing to do.
+    if (movie_trace)
+    {
+        end_trace();
+    }
 }
 
-void EncoderState::new_video_frame_event()
+void EncoderState::end_trace()
 {
-    if (!render_receive_video())
+    svr_trace_stop();
+    movie_trace = false;
+
+    char path[256];
+    SVR_SNPRINTF(path, "%s.svr_encoder", movie_params.dest_file);
+
+    if (!svr_trace_save(path, "svr_encoder"))
     {
-        free_dynamic();
+        svr_log("ERROR: Could not save trace to %s.json\n", path);
+        return;
     }
+
+    svr_log("Saved trace to %s.json\n", path);
 }
 
-void EncoderState::new_audio_samples_event()
+void EncoderState::new_video_frame_event(s32 slot_idx)
 {
-    if (!render_receive_audio())
+    // The slots must still be given back after an error, or svr_game would wait forever for a free one.
+    if (svr_atom_load(&render_started) == 0)
+    {
+        return;
+    }
+
+    if (!render_receive_video(slot_idx))
     {
         free_dynamic();
     }
 }
 
-// Event reading from svr_game.
-void EncoderState::event_loop()
+void EncoderState::new_audio_samples_event(void* samples, s32 num_samples)
 {
-    svr_log("Encoder ready\n");
+    // The samples must still be read after an error, or svr_game would wait forever when the ring is full.
+    if (svr_atom_load(&render_started) == 0)
+    {
+        return;
+    }
 
-    HANDLE handles[] =
+    if (!render_receive_audio(samples, num_samples))
     {
-        game_process,
-        encoder_wake_event_h,
-    };
+        free_dynamic();
+    }
+}
 
-    while (true)
+// If we were recording, we did not get the stop command, so just stop as if we got it.
+// This will exit this process too. In svr_encoder_host.dll we only stop on ENCODER_EVENT_QUIT.
+void EncoderState::game_exited_event()
+{
+    if (svr_atom_load(&render_started))
     {
-        DWORD waited = WaitForMultipleObjects(SVR_ARRAY_SIZE(handles), handles, FALSE, INFINITE);
-        HANDLE waited_h = handles[waited - WAIT_OBJECT_0];
+        svr_log("Game exited without telling the encoder, ending movie\n");
 
-        // Game exited or crashed or something.
-        // If we were recording, we did not get the stop command, so just stop as if we got it.
-        // This will exit this process too.
-        if (waited_h == game_process)
-        {
-            if (svr_atom_load(&render_started))
-            {
-                svr_log("Game exited without telling the encoder, ending movie\n");
+        stop_event();
+    }
+}
 
-                stop_event();
-            }
+static void encoder_handle_start(void* param)
+{
+    ((EncoderState*)param)->start_event();
+}
 
-            break;
-        }
+static void encoder_handle_stop(void* param)
+{
+    ((EncoderState*)param)->stop_event();
+}
 
-        // We are woken up here because svr_game wants us to do something.
-        // Any code in here needs to be fast because the game is frozen at this point.
-        // Forward relevant stuff to the actual encoder thread.
-        if (waited_h == encoder_wake_event_h)
-        {
-            // Clear out any error from previous calls.
-            shared_mem_ptr->error = 0;
-            shared_mem_ptr->error_message[0] = 0;
-
-            switch (shared_mem_ptr->event_type)
-            {
-                case ENCODER_EVENT_START:
-                {
-                    start_event();
-                    break;
-                }
-
-                case ENCODER_EVENT_STOP:
-                {
-                    stop_event();
-                    break;
-                }
-
-                case ENCODER_EVENT_NEW_VIDEO:
-                {
-                    new_video_frame_event();
-                    break;
-                }
-
-                case ENCODER_EVENT_NEW_AUDIO:
-                {
-                    new_audio_samples_event();
-                    break;
-                }
-            }
-
-            // Notify svr_game that we handled this event.
-            // We go back to sleep after this, which puts us in a known paused state.
-            SetEvent(game_wake_event_h);
-        }
-    }
+static void encoder_handle_video_slot(void* param, s32 slot_idx)
+{
+    ((EncoderState*)param)->new_video_frame_event(slot_idx);
+}
+
+static void encoder_handle_audio_samples(void* param, void* samples, s32 num_samples)
+{
+    ((EncoderState*)param)->new_audio_samples_event(samples, num_samples);
+}
+
+static void encoder_handle_rings_read(void* param)
+{
+    ((EncoderState*)param)->stats_update(false);
+}
+
+static void encoder_handle_game_exited(void* param)
+{
+    ((EncoderState*)param)->game_exited_event();
+}
+
+// Event reading from svr_game.
+// Video frames and audio samples are read from the rings before every event, see encoder_shared_event_loop.
+void EncoderState::event_loop()
+{
+    svr_log("Encoder ready\n");
+
+    EncoderSharedHandler handler = {};
+    handler.param = this;
+    handler.start = encoder_handle_start;
+    handler.stop = encoder_handle_stop;
+    handler.video_slot = encoder_handle_video_slot;
+    handler.audio_samples = encoder_handle_audio_samples;
+    handler.rings_read = encoder_handle_rings_read;
+    handler.game_exited = encoder_handle_game_exited;
+
+    encoder_shared_event_loop(shared_mem_ptr, host ? NULL : &game_process, &handler);
 
     svr_log("Encoder finished\n");
 }
 
 void EncoderState::free_static()
 {
-    svr_maybe_close_handle(&game_process);
-    svr_maybe_close_handle(&shared_mem_h);
+    svr_ipc_close_process(&game_process);
 
-    if (shared_mem_ptr)
+    // In the game process these are the same event handles that svr_game has, and it closes them.
+    if (shared_mem_ptr && host == NULL)
     {
-        UnmapViewOfFile(shared_mem_ptr);
-        shared_mem_ptr = NULL;
-        shared_audio_buffer = NULL;
+        encoder_shared_close_events(shared_mem_ptr);
     }
 
-    svr_maybe_close_handle(&game_wake_event_h);
-    svr_maybe_close_handle(&encoder_wake_event_h);
+    shared_mem_ptr = NULL;
+
+    svr_ipc_free_mem(&shared_mem);
 
     render_free_static();
+    pool_free_static();
     vid_free_static();
     audio_free_static();
+    stats_free_static();
+
+    svr_trace_free();
 }
 
 void EncoderState::free_dynamic()
 {
     render_free_dynamic();
+    pool_free_dynamic();
     vid_free_dynamic();
     audio_free_dynamic();
 }
@@ -228,7 +295,7 @@ void EncoderState::free_dynamic()
 void EncoderState::error(const char* format, ...)
 {
     // Must only be called by the main thread because the shared memory can only be written by the main thread.
-    assert(GetCurrentThreadId() == main_thread_id);
+    assert(svr_thread_get_current_id() == main_thread_id);
 
     // Set this early so we don't try to flush the encoders or something.
     // If we have an error then we must stop right now, and not try to process any more data.
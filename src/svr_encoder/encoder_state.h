@@ -1,21 +1,94 @@
 #pragma once
 
+// The queue sizes must be powers of two.
 const s32 RENDER_QUEUED_FRAMES = 8192; // Max number of uncompressed AVFrame* to queue up for encoding.
 const s32 RENDER_QUEUED_PACKETS = 8192; // Max number of compressed AVPacket* to queue up for writing.
 const s32 VID_QUEUED_TEXTURES = 16; // Max number of converted uncompressed frames to store in RAM before encode.
 const s32 RENDER_QUEUED_AUDIO_BUFFERS = 8192; // Max number of audio buffers to queue up for conversion and encoding.
 const s32 VID_MAX_PLANES = 3; // At most, YUV uses 3 planes.
 const s32 AUDIO_MAX_CHANS = 8;
+const s32 POOL_PREALLOC_VIDEO_FRAMES = 16; // How many video frames to allocate when rendering starts, if they fit in the budget.
+const s32 POOL_PREALLOC_AUDIO_FRAMES = 32; // How many audio frames to allocate when rendering starts.
+const s32 POOL_PREALLOC_PACKETS = 64; // How many packets to allocate when rendering starts.
+const s32 VID_MAX_COPY_THREADS = 4; // Max number of threads to copy downloaded textures into frames with.
+const s32 BENCH_MAX_WORKER_COUNTS = 16; // Max number of worker counts that svr_encoder_bench can compare in one run.
 
+struct EncoderState;
 struct RenderVideoInfo;
 struct RenderAudioInfo;
 
-struct RenderFrameThreadInput
+// Thread that sends the uncompressed frames of one stream to its encoder.
+// Every stream has its own thread so that audio frames don't have to wait for a slow video frame to be encoded.
+struct RenderEncodeThread
 {
+    EncoderState* encoder;
+    SvrThread thread;
+
     AVCodecContext* ctx;
-    AVFrame* frame;
     AVStream* stream;
     AVMediaType type;
+
+    // Rung to notify that there are new frames to encode.
+    SvrDoorbell bell;
+
+    // Uncompressed frames ready to be encoded. A NULL frame flushes the encoder and stops the thread.
+    // Written to by the main thread for video, and by either the main or the audio thread for audio (never both at the same time).
+    // Order matters.
+    SvrSpscRing<AVFrame*> queue;
+
+    SvrAtom32 status; // Will be set to 0 by the thread if it failed. Message will be in message.
+    char message[256]; // Error message for the thread.
+};
+
+// How packets from an encoder are put in order before they are written.
+using RenderPacketOrder = s32;
+
+enum /* RenderPacketOrder */
+{
+    RENDER_PACKET_ORDER_NONE, // Packets are already in order.
+    RENDER_PACKET_ORDER_FRAME, // Every frame is its own packet, ordered by the presentation timestamp.
+    RENDER_PACKET_ORDER_CHUNK, // Ordered by the chunk the packets belong to. The end of a chunk is marked with a NULL packet.
+};
+
+struct RenderPacketThreadInput
+{
+    // Set to NULL with a reorder_idx of -1 to flush.
+    // Set to NULL with a reorder_idx of 0 or more to mark the end of that chunk.
+    AVPacket* packet;
+
+    // Position in the output for packets that are encoded in parallel and can arrive out of order.
+    // Set to -1 for packets that are already in order.
+    s64 reorder_idx;
+
+    // This is the last input for reorder_idx, so the inputs with the next index can be written after this.
+    bool reorder_last;
+};
+
+struct RenderWorkerInput
+{
+    AVFrame* frame; // Set to NULL to end a chunk, or to stop the worker if chunk_idx is -1.
+    s64 chunk_idx; // Chunk that the frame belongs to, or -1 if not encoding in chunks.
+};
+
+// Video encoder that runs on its own thread with its own codec context.
+struct RenderVideoWorker
+{
+    EncoderState* encoder;
+    SvrThread thread;
+
+    // When encoding in chunks, a new context is opened for every chunk and it only exists while the chunk is encoded.
+    AVCodecContext* ctx;
+
+    // Where this worker takes frames from. Either the shared render_worker_queue or chunk_queue.
+    SvrMpmcRing<RenderWorkerInput>* queue;
+
+    // Frames for the chunks that have been given to this worker, when encoding in chunks.
+    // Written to by the main thread, read by this worker.
+    SvrMpmcRing<RenderWorkerInput> chunk_queue;
+
+    SvrAtom32 num_chunks; // Chunks given to this worker that are not done yet.
+
+    char message[256]; // Error message for the worker if it failed.
 };
 
 struct RenderAudioThreadInput
@@ -24,43 +97,56 @@ struct RenderAudioThreadInput
     s32 num_samples; // How many samples there actually are.
 };
 
+#ifdef _WIN32
 struct VidTextureDownloadInput
 {
     ID3D11Texture2D* dl_texs[VID_MAX_PLANES]; // In system memory.
 };
 
+// Texture that svr_game draws to, for one slot in the video ring.
+struct VidGameTexture
+{
+    HANDLE tex_h;
+    ID3D11Texture2D* tex;
+    ID3D11ShaderResourceView* srv;
+    IDXGIKeyedMutex* lock;
+};
+
 struct EncoderShader
 {
     const char* name;
     void** dest;
     D3D11_SHADER_TYPE type;
 };
+#endif
 
 struct EncoderState
 {
     // -----------------------------------------------
     // Game and program state:
 
-    EncoderSharedMem* shared_mem_ptr;
+    SvrIpcMem shared_mem;
+    EncoderSharedMem* shared_mem_ptr; // Same as the pointer in shared_mem.
 
-    HANDLE game_process;
-    HANDLE shared_mem_h;
-    HANDLE game_wake_event_h;
-    HANDLE encoder_wake_event_h;
-    HANDLE game_texture_h;
-    void* shared_audio_buffer; // Where svr_game will put the audio samples.
+    SvrIpcProcess game_process; // Not opened in svr_encoder_host.dll, where svr_game always sends ENCODER_EVENT_QUIT before it goes away.
 
-    DWORD main_thread_id;
+    EncoderHostParams* host; // Set when running in svr_encoder_host.dll inside the game process.
+    char resource_path[260]; // Same size as MAX_PATH.
+
+    u32 main_thread_id;
 
     EncoderSharedMovieParams movie_params; // Copied from the shared memory on movie start.
+    bool movie_trace; // If a trace of this movie is being recorded.
 
-    bool init(HANDLE in_shared_mem_h);
+    bool init(const char* shared_mem_id, EncoderHostParams* in_host);
 
     void start_event();
     void stop_event();
-    void new_video_frame_event();
-    void new_audio_samples_event();
+    void new_video_frame_event(s32 slot_idx);
+    void new_audio_samples_event(void* samples, s32 num_samples);
+    void game_exited_event();
     void event_loop();
+    void end_trace();
 
     void free_static();
     void free_dynamic();
@@ -83,48 +169,38 @@ struct EncoderState
     // The threads start when rendering starts, and stop when rendering stops.
     // This makes it really easy to synchronize when stopping.
 
-    // Frame thread:
+    // Encode threads:
 
     SVR_THREAD_PADDING();
 
-    HANDLE render_frame_thread_h; // Thread used to process uncompressed video frames and audio samples.
-
-    // Event set by the main and audio threads to notify that there are new frames to encode.
-    HANDLE render_frame_wake_event_h;
+    RenderEncodeThread render_video_encode; // Not started when the video workers are used.
 
-    // Uncompressed frames and samples ready to be encoded.
-    // Written to by the main and audio threads, read by the frame thread.
-    // Order matters.
-    SvrLockedQueue<RenderFrameThreadInput> render_frame_queue;
-
-    // Video frames that have been encoded.
-    // Written to by the frame thread, read by the main thread.
-    // Order doesn't matter.
-    SvrLockedArray<AVFrame*> render_recycled_video_frames;
-
-    // Audio frames that have been encoded.
-    // Written to by the frame thread, read by the main thread.
-    // Order doesn't matter.
-    SvrLockedArray<AVFrame*> render_recycled_audio_frames;
+    SVR_THREAD_PADDING();
 
-    SvrAtom32 render_frame_thread_status; // Will be set to 0 by frame thread if it failed. Message will be in render_frame_thread_message.
-    char render_frame_thread_message[256]; // Error message for the frame thread.
+    RenderEncodeThread render_audio_encode; // Only started when there is audio.
 
     // Packet thread:
 
     SVR_THREAD_PADDING();
 
-    HANDLE render_packet_thread_h; // Thread used to process encoded packets for writing to the container.
+    SvrThread render_packet_thread; // Thread used to process encoded packets for writing to the container.
 
-    // Event set by the frame thread to notify that there are encoded packets to write.
-    // When rendering stops, this will be set by the main thread instead.
-    HANDLE render_packet_wake_event_h;
+    // Rung by the encode threads and video workers to notify that there are encoded packets to write.
+    // When rendering stops, this will be rung by the main thread instead.
+    SvrDoorbell render_packet_bell;
 
     // Compressed packets ready to be written.
-    // Written to by the frame thread, read by the packet thread.
-    // When rendering stops, this will be written to by the main thread instead.
-    // Order matters.
-    SvrLockedQueue<AVPacket*> render_packet_queue;
+    // Written to by the encode threads and video workers, read by the packet thread.
+    // The muxer interleaves the packets of the streams by their timestamps.
+    // When rendering stops, this will be written to by the main thread instead (after the other threads have finished).
+    // Order matters, except for the packets from the video workers which are put back in order by the packet thread.
+    SvrMpmcRing<RenderPacketThreadInput> render_packet_queue;
+
+    // Packets from the video workers, which wait here until the frames or chunks before them are written.
+    // Packets of the same chunk arrive in order, and the NULL packet at the end of a chunk lets the next chunk be written.
+    // Only used by the packet thread.
+    SvrReorder<AVPacket*> render_reorder;
+    SvrStitchTimes render_stitch_times; // Decode timestamps of the written video packets when encoding in chunks.
 
     SvrAtom32 render_packet_thread_status; // Will be set to 0 by packet thread if it failed. Message will be in render_packet_thread_message.
     char render_packet_thread_message[256]; // Error message for the packet thread.
@@ -133,15 +209,15 @@ struct EncoderState
 
     SVR_THREAD_PADDING();
 
-    HANDLE render_audio_thread_h; // Thread used to process incoming audio buffers for conversion and encoding.
+    SvrThread render_audio_thread; // Thread used to process incoming audio buffers for conversion and encoding.
 
-    // Event set by the main thread to notify that there are new audio buffers to process.
-    HANDLE render_audio_wake_event_h;
+    // Rung by the main thread to notify that there are new audio buffers to process.
+    SvrDoorbell render_audio_bell;
 
     // Uncompressed audio samples ready to be converted and encoded.
     // Written to by the main thread, read by the audio thread.
     // Order matters.
-    SvrLockedQueue<RenderAudioThreadInput> render_audio_queue;
+    SvrSpscRing<RenderAudioThreadInput> render_audio_queue;
 
     // Raw audio buffers.
     // Written to by the audio thread, read by the main thread.
@@ -151,9 +227,34 @@ struct EncoderState
     SvrAtom32 render_audio_thread_status; // Will be set to 0 by audio thread if it failed. Message will be in render_audio_thread_message.
     char render_audio_thread_message[256]; // Error message for the audio thread.
 
+    // Video workers:
+
+    SVR_THREAD_PADDING();
+
+    // Encoders where every frame is independent can be run with several codec contexts at the same time.
+    // The first worker uses render_video_ctx. In this mode, video frames don't go through the video encode thread.
+    // Other encoders can be run the same way by splitting the video into chunks that start with a keyframe and
+    // don't reference each other. Every chunk is then encoded by one worker with a new codec context.
+    RenderVideoWorker* render_video_workers;
+    s32 render_num_video_workers; // 0 when not used.
+
+    s32 render_video_chunk_frames; // Number of frames in a chunk, or 0 if not encoding in chunks.
+    s64 render_video_chunk_idx; // The chunk that the main thread is currently giving frames to.
+    RenderVideoWorker* render_chunk_worker; // The worker that is given the current chunk.
+
+    // Rung by the main thread to notify that there are new video frames to encode.
+    SvrDoorbell render_worker_bell;
+
+    // Uncompressed video frames ready to be encoded when every frame is independent.
+    // Written to by the main thread, read by any video worker. A NULL frame stops one worker.
+    SvrMpmcRing<RenderWorkerInput> render_worker_queue;
+
+    SvrAtom32 render_workers_status; // Will be set to 0 by a worker if it failed. Message will be in the message of that worker.
+
     SVR_THREAD_PADDING();
 
     const RenderVideoInfo* render_video_info;
+    const AVCodec* render_video_codec;
     AVStream* render_video_stream;
     AVCodecContext* render_video_ctx;
     s64 render_video_pts; // Presentation timestamp.
@@ -173,50 +274,133 @@ struct EncoderState
     bool render_start_threads();
     void render_free_static();
     void render_free_dynamic();
-    void render_frame_proc();
+    void render_encode_proc(RenderEncodeThread* thread);
     void render_packet_proc();
+    bool render_write_packet(AVPacket* packet);
+    bool render_write_reordered_packets(bool flush);
+    void render_video_worker_proc(RenderVideoWorker* worker);
+    bool render_encode_chunk_input(RenderVideoWorker* worker, RenderWorkerInput* input);
+    bool render_use_video_workers();
+    bool render_use_video_chunks();
+    bool render_start_video_workers();
+    void render_stop_video_workers();
+    void render_free_video_workers();
+    void render_give_chunk_frame(AVFrame* frame);
+    void render_end_video_chunk();
+    s32 render_receive_packets(AVCodecContext* ctx, AVStream* stream, RenderPacketOrder order, s64 chunk_idx);
+    bool render_any_thread_failed();
     void render_audio_proc();
     bool render_setup_video_info();
     bool render_setup_audio_info();
     bool render_init_output_context();
     bool render_init_video();
+    s32 render_open_video_ctx(s32 num_threads, AVCodecContext** dest);
     bool render_init_audio();
     bool render_check_thread_errors();
-    bool render_receive_video();
-    bool render_receive_audio();
+    bool render_receive_video(s32 slot_idx);
+    bool render_receive_audio(void* samples, s32 num_samples);
     void render_give_audio_thread_input(RenderAudioThreadInput* input);
     void render_flush_audio_fifo();
     void render_submit_audio_fifo();
     void render_encode_frame_from_audio_fifo(s32 num_samples);
     void render_encode_video_frame(AVFrame* frame);
     void render_encode_audio_frame(AVFrame* frame);
-    void render_encode_frame(AVCodecContext* ctx, AVStream* stream, AVFrame* frame, AVMediaType type);
-    AVFrame* render_get_new_video_frame();
-    AVFrame* render_get_new_audio_frame();
+    void render_encode_frame(RenderEncodeThread* thread, AVFrame* frame);
     RenderAudioThreadInput render_get_new_audio_buffer(s32 num_samples);
     s32 render_get_audio_buffer_size(s32 num_samples);
-    void render_free_recycled_stuff();
+    void render_free_recycled_audio_buffers();
     void render_free_lingering_thread_inputs();
     void render_submit_texture();
+    void render_finish_texture_download();
+
+    void render_setup_dnxhr(AVCodecContext* ctx);
+    void render_setup_libx264(AVCodecContext* ctx);
+
+    // -----------------------------------------------
+    // Pool state:
+
+    // Frames and packets that are reused between the threads.
+    // All allocated frames and all queued packet data count towards the memory budget from the movie profile.
+    // When the budget is used up, the threads that want new frames will wait until an encode thread or video worker gives one back.
 
-    void render_setup_dnxhr();
-    void render_setup_libx264();
+    s64 pool_budget; // In bytes.
+    s32 pool_video_frame_size; // In bytes.
+    s32 pool_audio_frame_size; // In bytes.
+
+    SVR_THREAD_PADDING();
+
+    SvrAtom64 pool_used; // Bytes in buffers of frames and packets that are still referenced by anyone.
+    SvrAtom64 pool_peak; // Highest value of pool_used during this movie.
+    SvrAtom32 pool_num_waits; // How many times a frame was requested when the budget was used up.
+    SvrAtom32 pool_video_frames_out; // Video frames that have been taken and not given back yet.
+    SvrAtom32 pool_audio_frames_out; // Audio frames that have been taken and not given back yet.
+
+    SVR_THREAD_PADDING();
+
+    // Rung when a frame is given back or packet data is written.
+    SvrDoorbell pool_bell;
+
+    // Video frames that are ready for use.
+    // Written to by the video encode thread and video workers, read by the main thread.
+    // Order doesn't matter.
+    SvrMpmcRing<AVFrame*> pool_video_frames;
+
+    // Audio frames that are ready for use.
+    // Written to by the audio encode thread, read by the main or audio thread.
+    // Order doesn't matter.
+    SvrMpmcRing<AVFrame*> pool_audio_frames;
+
+    // Packets that don't reference any data.
+    // Written to by the encode threads, video workers and packet thread, read by the encode threads and video workers.
+    // Order doesn't matter.
+    SvrMpmcRing<AVPacket*> pool_packets;
+
+    SVR_THREAD_PADDING();
+
+    bool pool_init();
+    void pool_free_static();
+    bool pool_start();
+    void pool_free_dynamic();
+    void pool_log_usage();
+    void pool_add_usage(s64 size);
+    void pool_remove_usage(s64 size);
+    void pool_track_buffer(AVBufferRef** buf);
+    void pool_track_frame(AVFrame* frame);
+    void pool_track_packet(AVPacket* packet);
+    bool pool_is_frame_reusable(AVFrame* frame);
+    bool pool_can_allocate(s32 size, SvrAtom32* num_out);
+    AVFrame* pool_alloc_video_frame();
+    AVFrame* pool_alloc_audio_frame();
+    AVFrame* pool_get_video_frame();
+    AVFrame* pool_get_audio_frame();
+    void pool_push_video_frame(AVFrame* frame);
+    void pool_push_audio_frame(AVFrame* frame);
+    void pool_put_video_frame(AVFrame* frame);
+    void pool_put_audio_frame(AVFrame* frame);
+    AVPacket* pool_get_packet();
+    void pool_put_packet(AVPacket* packet);
 
     // -----------------------------------------------
     // Video state:
 
+    s32 vid_num_planes;
+    s32 vid_plane_heights[VID_MAX_PLANES];
+    s32 vid_plane_row_sizes[VID_MAX_PLANES]; // In bytes.
+
+    // The GPU conversion and download only exist on Windows. Other platforms only have the frames in memory.
+#ifdef _WIN32
     ID3D11Device1* vid_d3d11_device;
     ID3D11DeviceContext* vid_d3d11_context;
+
+    // In svr_encoder_host.dll the conversion is recorded here and then executed on vid_d3d11_context, which is shared with svr_game.
+    // Executing restores the state of the immediate context, so svr_game never sees any of our state.
+    ID3D11DeviceContext* vid_deferred_context;
     void* vid_shader_mem;
     s32 vid_shader_size;
 
-    ID3D11Texture2D* vid_game_tex; // Texture that svr_game updates.
-    ID3D11ShaderResourceView* vid_game_tex_srv;
-    IDXGIKeyedMutex* vid_game_tex_lock;
+    VidGameTexture vid_game_texs[ENCODER_VIDEO_SLOTS]; // Textures that svr_game updates.
 
     ID3D11ComputeShader* vid_conversion_cs;
-    s32 vid_num_planes;
-    s32 vid_plane_heights[VID_MAX_PLANES];
 
     ID3D11ComputeShader* vid_nv12_cs;
     ID3D11ComputeShader* vid_yuv422_cs;
@@ -231,27 +415,51 @@ struct EncoderState
     ID3D11UnorderedAccessView* vid_converted_uavs[VID_MAX_PLANES];
 
     VidTextureDownloadInput* vid_texture_download_queue;
+    VidTextureDownloadInput* vid_copy_input; // The textures that are being copied from, or NULL if there is no copy.
+#endif
 
     // These indexes get wrapped.
     s64 render_download_write_idx;
     s64 render_download_read_idx;
 
+    // Copying from the downloaded textures into frames is done by these threads.
+    // The copy runs while the game makes the next frame, and the textures stay mapped until it is finished.
+    SvrWorkPool* vid_copy_pool;
+    SvrSimdLevel vid_simd_level;
+    SvrCopyJob vid_copy_job;
+    AVFrame* vid_copy_frame; // The frame that is being copied to, or NULL if there is no copy.
+
+    // When svr_game has no D3D11 device, the frames are in memory and are converted on the processor instead of with the shaders.
+    // svr_encoder_bench does the same with its own frames.
+    SvrIpcMem vid_frame_mem; // The slots of the video ring, from EncoderSharedMem::frame_mem_id.
+    SvrColorConversion vid_cpu_conversion;
+    u8* vid_cpu_planes[VID_MAX_PLANES]; // Stands in for vid_converted_texs and the download textures, with the same size as them.
+
     bool vid_init();
-    bool vid_create_device();
-    bool vid_create_shaders();
     void vid_free_static();
     void vid_free_dynamic();
+    bool vid_start();
+    AVFrame* vid_finish_download();
+    bool vid_can_map_now();
+    bool vid_drain_textures();
+    bool vid_open_frame_mem();
+    void vid_create_cpu_planes();
+    AVFrame* vid_convert_on_cpu(const u8* src);
+
+#ifdef _WIN32
+    bool vid_create_device();
+    bool vid_create_host_device();
+    bool vid_create_shaders();
     bool vid_load_shader(const char* name);
     bool vid_create_shader(const char* name, void** shader, D3D11_SHADER_TYPE type);
     bool vid_create_shaders_list(EncoderShader* shaders, s32 num);
-    bool vid_start();
-    bool vid_open_game_texture();
+    bool vid_open_game_textures();
     void vid_create_conversion_texs();
-    void vid_push_texture_for_conversion();
-    void vid_download_texture_into_frame(AVFrame* dest_frame);
-    bool vid_can_map_now();
-    bool vid_drain_textures();
+    void vid_push_texture_for_conversion(s32 slot_idx);
+    void vid_start_download(AVFrame* dest_frame);
+    void vid_map_download_texture(ID3D11Texture2D* tex, D3D11_MAPPED_SUBRESOURCE* map);
     s32 vid_get_num_cs_threads(s32 unit);
+#endif
 
     // -----------------------------------------------
     // Audio state:
@@ -277,6 +485,101 @@ struct EncoderState
     void audio_copy_samples_to_frame(AVFrame* dest_frame, s32 num_samples);
     s32 audio_num_queued_samples();
     bool audio_need_conversion();
+
+    // -----------------------------------------------
+    // Stats state:
+
+    // Live statistics that svr_monitor shows, in the part of the block that svr_game gave this encoder.
+    SvrIpcMem stats_mem;
+    SvrStatsBlock* stats_block; // NULL if svr_game has no stats.
+    SvrStatsEncoder stats_encoder; // Copied to the block by the main thread.
+
+    // Totals of every stage since the movie started, in microseconds and in runs. Added to by any thread.
+    SVR_THREAD_PADDING();
+
+    SvrAtom64 stats_stage_times[SVR_STATS_ENCODER_NUM_STAGES];
+    SvrAtom64 stats_stage_counts[SVR_STATS_ENCODER_NUM_STAGES];
+    SvrAtom64 stats_frames_written; // Set by the packet thread.
+    SvrAtom64 stats_bytes_written; // Set by the packet thread.
+
+    SVR_THREAD_PADDING();
+
+    // Totals at the last write to the block, so the averages are of the time since then.
+    s64 stats_prev_stage_times[SVR_STATS_ENCODER_NUM_STAGES];
+    s64 stats_prev_stage_counts[SVR_STATS_ENCODER_NUM_STAGES];
+
+    // Time that any video encoder, the audio encoder, and both at once were encoding, in microseconds.
+    // svr_encoder_bench reports these to show how much of the audio encoding happens while video is encoded on its own thread.
+    // Added to by the encode threads and video workers, under the lock.
+    SvrLock stats_encode_lock;
+    s32 stats_num_video_encoding;
+    s32 stats_num_audio_encoding;
+    s64 stats_encode_change_time; // When one of the counts last changed.
+    s64 stats_video_encode_time;
+    s64 stats_audio_encode_time;
+    s64 stats_both_encode_time;
+
+    void stats_free_static();
+    void stats_start();
+    void stats_end();
+    void stats_add_stage(SvrStatsEncoderStage stage, s64 start);
+    void stats_change_encoding(AVMediaType type, s32 change);
+    void stats_update(bool force);
+
+    // -----------------------------------------------
+    // Bench state:
+
+    // Only used by svr_encoder_bench, which gives made up or recorded frames and samples to the render pipeline without svr_game.
+    // See encoder_bench.cpp.
+
+    s32 bench_num_frames; // Video frames to encode.
+    s32 bench_worker_counts[BENCH_MAX_WORKER_COUNTS]; // The movie is made once with each.
+    s32 bench_num_worker_counts;
+    const char* bench_video_file; // Raw B8G8R8A8 frames to use, or NULL to make them up.
+    const char* bench_audio_file; // Raw interleaved s16 samples to use, or NULL to make them up.
+
+    // The sources are given again from the start when the end is reached.
+    u8* bench_video_mem; // Frames one after another, without padding.
+    s32 bench_num_video_frames;
+    s16* bench_audio_mem; // Samples of all channels, interleaved.
+    s32 bench_num_audio_samples; // For every channel.
+    s32 bench_audio_pos; // Next sample to give.
+
+    s32 bench_run(s32 argc, char** argv);
+    void bench_print_usage();
+    bool bench_parse_options(s32 argc, char** argv);
+    bool bench_parse_worker_counts(const char* value);
+    bool bench_init();
+    void bench_free();
+    bool bench_load_video();
+    void bench_make_video();
+    bool bench_load_audio();
+    void bench_make_audio();
+    bool bench_load_sources();
+    bool bench_run_movie(s64* time);
+    bool bench_give_video_frame(s32 frame_idx);
+    bool bench_give_audio(s32 num_samples);
+    void bench_print_result(s64 time, s64 first_time, s64 output_size);
+    void bench_print_error(const char* message);
+};
+
+// Counts the time until the end of the scope as encoding of the stream, see stats_change_encoding.
+struct StatsEncodeScope
+{
+    EncoderState* encoder;
+    AVMediaType type;
+
+    inline StatsEncodeScope(EncoderState* in_encoder, AVMediaType in_type)
+    {
+        encoder = in_encoder;
+        type = in_type;
+        encoder->stats_change_encoding(type, 1);
+    }
+
+    inline ~StatsEncodeScope()
+    {
+        encoder->stats_change_encoding(type, -1);
+    }
 };
 
 struct RenderVideoInfo
@@ -284,10 +587,11 @@ struct RenderVideoInfo
     const char* profile_name; // Name as written in the movie profile.
     const char* codec_name; // Name in ffmpeg.
     AVPixelFormat pixel_format; // An encoder may support several pixel formats, so we select the one we like the most.
+    bool intra_only; // Every frame is independent so several frames can be encoded at the same time.
 
     // Set state according to the movie profile.
     // This is called before the codec is opened.
-    void(EncoderState::*setup)();
+    void(EncoderState::*setup)(AVCodecContext* ctx);
 };
 
 struct RenderAudioInfo
@@ -302,5 +606,5 @@ struct RenderAudioInfo
 
     // Set state according to the movie profile.
     // This is called before the codec is opened.
-    void(EncoderState::*setup)();
+    void(EncoderState::*setup)(AVCodecContext* ctx);
 };
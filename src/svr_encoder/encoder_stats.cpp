@@ -0,0 +1,221 @@
+#include "encoder_priv.h"
+
+// Live statistics for svr_monitor, written to the part of the block that svr_game gave this encoder.
+// The threads add to the totals of the stages, and the main thread turns them into averages and writes them to the block now and then.
+
+const s64 STATS_UPDATE_INTERVAL = 100000; // Microseconds between writes to the block.
+
+void EncoderState::stats_free_static()
+{
+    svr_ipc_free_mem(&stats_mem);
+    stats_block = NULL;
+}
+
+// The block is opened on the first movie that has stats and kept after that, since svr_game keeps it too.
+// Must be called before the threads of the movie start.
+void EncoderState::stats_start()
+{
+    // The totals are kept without a block too, since svr_encoder_bench reports them.
+    for (s32 i = 0; i < SVR_STATS_ENCODER_NUM_STAGES; i++)
+    {
+        svr_atom_store(&stats_stage_times[i], 0);
+        svr_atom_store(&stats_stage_counts[i], 0);
+        stats_prev_stage_times[i] = 0;
+        stats_prev_stage_counts[i] = 0;
+    }
+
+    svr_atom_store(&stats_frames_written, 0);
+    svr_atom_store(&stats_bytes_written, 0);
+
+    stats_num_video_encoding = 0;
+    stats_num_audio_encoding = 0;
+    stats_encode_change_time = svr_prof_get_real_time();
+    stats_video_encode_time = 0;
+    stats_audio_encode_time = 0;
+    stats_both_encode_time = 0;
+
+    s32 idx = movie_params.stats_idx;
+
+    if (idx < 0 || idx >= SVR_STATS_MAX_ENCODERS)
+    {
+        return;
+    }
+
+    if (stats_block == NULL)
+    {
+        if (!svr_ipc_open_named_mem(SVR_STATS_MEM_NAME, &stats_mem))
+        {
+            svr_log("Could not open live statistics (%u)\n", svr_get_last_error());
+            return;
+        }
+
+        if (!svr_stats_check(stats_mem.ptr, stats_mem.size))
+        {
+            svr_log("Live statistics are from another version of svr_game\n");
+            svr_ipc_free_mem(&stats_mem);
+            return;
+        }
+
+        stats_block = (SvrStatsBlock*)stats_mem.ptr;
+    }
+
+    stats_encoder = {};
+    stats_encoder.state = SVR_STATS_STATE_RENDERING;
+
+    const char* name = movie_params.dest_file;
+
+    for (const char* c = name; *c; c++)
+    {
+        if (*c == '\\' || *c == '/')
+        {
+            name = c + 1;
+        }
+    }
+
+    SVR_COPY_STRING(name, stats_encoder.movie_name);
+
+    stats_update(true);
+}
+
+// The threads of the movie have stopped, so the totals are final.
+void EncoderState::stats_end()
+{
+    if (stats_block == NULL)
+    {
+        return;
+    }
+
+    stats_encoder.state = SVR_STATS_STATE_IDLE;
+    stats_update(true);
+}
+
+// Can be called from any thread.
+void EncoderState::stats_add_stage(SvrStatsEncoderStage stage, s64 start)
+{
+    svr_atom_add(&stats_stage_times[stage], svr_prof_get_real_time() - start);
+    svr_atom_add(&stats_stage_counts[stage], 1);
+}
+
+// Can be called from any thread.
+// Called with 1 when an encoder of the stream starts to work on a frame, and with -1 when it is done.
+// The time since the last change is added to the totals of the streams that were encoding during it.
+void EncoderState::stats_change_encoding(AVMediaType type, s32 change)
+{
+    svr_lock_acquire(&stats_encode_lock);
+
+    s64 now = svr_prof_get_real_time();
+    s64 passed = now - stats_encode_change_time;
+
+    if (stats_num_video_encoding > 0)
+    {
+        stats_video_encode_time += passed;
+    }
+
+    if (stats_num_audio_encoding > 0)
+    {
+        stats_audio_encode_time += passed;
+    }
+
+    if (stats_num_video_encoding > 0 && stats_num_audio_encoding > 0)
+    {
+        stats_both_encode_time += passed;
+    }
+
+    if (type == AVMEDIA_TYPE_VIDEO)
+    {
+        stats_num_video_encoding += change;
+    }
+
+    else
+    {
+        stats_num_audio_encoding += change;
+    }
+
+    stats_encode_change_time = now;
+
+    svr_lock_release(&stats_encode_lock);
+}
+
+// In main thread.
+// Writes to the block if enough time has passed since the last write, or always if forced.
+void EncoderState::stats_update(bool force)
+{
+    if (stats_block == NULL)
+    {
+        return;
+    }
+
+    s64 now = svr_prof_get_real_time();
+
+    if (!force && now - stats_encoder.update_time < STATS_UPDATE_INTERVAL)
+    {
+        return;
+    }
+
+    SvrStatsEncoder* stats = &stats_encoder;
+
+    // The average of every stage since the last write is added to the moving average, so it covers the last second or two.
+    for (s32 i = 0; i < SVR_STATS_ENCODER_NUM_STAGES; i++)
+    {
+        s64 time = svr_atom_load(&stats_stage_times[i]);
+        s64 count = svr_atom_load(&stats_stage_counts[i]);
+
+        if (count > stats_prev_stage_counts[i])
+        {
+            double avg = (double)(time - stats_prev_stage_times[i]) / (double)(count - stats_prev_stage_counts[i]);
+            svr_stats_add_time(&stats->stage_times[i], avg);
+        }
+
+        stats_prev_stage_times[i] = time;
+        stats_prev_stage_counts[i] = count;
+    }
+
+    stats->update_time = now;
+    stats->frames_received = stats_prev_stage_counts[SVR_STATS_ENCODER_STAGE_CONVERT];
+    stats->frames_downloaded = stats_prev_stage_counts[SVR_STATS_ENCODER_STAGE_DOWNLOAD];
+    stats->frames_encoded = stats_prev_stage_counts[SVR_STATS_ENCODER_STAGE_ENCODE];
+    stats->frames_written = svr_atom_load(&stats_frames_written);
+    stats->bytes_written = svr_atom_load(&stats_bytes_written);
+
+    stats->pool_used = svr_atom_load(&pool_used);
+    stats->pool_peak = svr_atom_load(&pool_peak);
+    stats->pool_budget = pool_budget;
+    stats->pool_num_waits = svr_atom_load(&pool_num_waits);
+
+    // The queues only exist while rendering.
+    stats->download_queue = 0;
+    stats->encode_queue = 0;
+    stats->audio_queue = 0;
+    stats->packet_queue = 0;
+
+    if (svr_atom_load(&render_started))
+    {
+        stats->download_queue = (s32)(render_download_write_idx - render_download_read_idx);
+        stats->packet_queue = render_packet_queue.size();
+
+        if (render_video_chunk_frames > 0)
+        {
+            for (s32 i = 0; i < render_num_video_workers; i++)
+            {
+                stats->encode_queue += render_video_workers[i].chunk_queue.size();
+            }
+        }
+
+        else if (render_num_video_workers > 0)
+        {
+            stats->encode_queue = render_worker_queue.size();
+        }
+
+        else
+        {
+            stats->encode_queue = render_video_encode.queue.size();
+        }
+
+        if (render_audio_info)
+        {
+            stats->audio_queue = render_audio_queue.size();
+        }
+    }
+
+    svr_stats_write_encoder(stats_block, movie_params.stats_idx, stats);
+}
@@ -3,38 +3,63 @@
 // Conversion from game texture format to video encoder format.
 
 const s32 VID_SHADER_SIZE = 8192; // Max size one shader can be when loading.
+const s32 VID_HOST_MAP_YIELDS = 4; // Tries to map a download texture in svr_encoder_host.dll before sleeping between the tries.
 
 bool EncoderState::vid_init()
 {
     bool ret = false;
-    HRESULT hr;
 
+    // svr_encoder_bench converts and downloads on the processor instead, see encoder_bench.cpp.
+#if defined(_WIN32) && !defined(SVR_ENCODER_BENCH)
     if (!vid_create_device())
     {
         goto rfail;
     }
 
-    if (!vid_create_shaders())
+    if (vid_d3d11_device)
     {
-        goto rfail;
+        if (!vid_create_shaders())
+        {
+            goto rfail;
+        }
     }
+#endif
 
+#ifdef _WIN32
     vid_texture_download_queue = SVR_ZALLOC_NUM(VidTextureDownloadInput, VID_QUEUED_TEXTURES);
+#endif
+
+    // The main thread does not take part in the copy since it runs in the background.
+    s32 num_copy_threads = svr_get_num_cpus() / 4;
+    svr_clamp(&num_copy_threads, 1, VID_MAX_COPY_THREADS);
+
+    vid_copy_pool = svr_work_pool_create(num_copy_threads + 1);
+    vid_simd_level = svr_simd_get_best_level();
+
+    svr_log("Using %d threads with %s for frame downloads\n", svr_work_pool_get_num_threads(vid_copy_pool) - 1, svr_simd_get_level_name(vid_simd_level));
 
     ret = true;
     goto rexit;
 
+#if defined(_WIN32) && !defined(SVR_ENCODER_BENCH)
 rfail:
+#endif
 
 rexit:
     return ret;
 }
 
+#ifdef _WIN32
 bool EncoderState::vid_create_device()
 {
     bool ret = false;
     HRESULT hr;
 
+    if (host)
+    {
+        return vid_create_host_device();
+    }
+
     UINT device_create_flags = D3D11_CREATE_DEVICE_SINGLETHREADED;
 
 #ifdef SVR_DEBUG
@@ -49,10 +74,12 @@ bool EncoderState::vid_create_device()
 
     hr = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, device_create_flags, &MINIMUM_DEVICE_LEVEL, 1, D3D11_SDK_VERSION, &initial_d3d11_device, NULL, &initial_d3d11_context);
 
+    // Frames that svr_game has in memory are converted on the processor, so this is only an error for the game textures.
     if (FAILED(hr))
     {
-        error("ERROR: Could not create D3D11 device (%#x)\n", hr);
-        goto rfail;
+        svr_log("Could not create D3D11 device (%#x), only frames in memory can be encoded\n", hr);
+        ret = true;
+        goto rexit;
     }
 
     hr = initial_d3d11_device->QueryInterface(IID_PPV_ARGS(&vid_d3d11_device));
@@ -82,6 +109,39 @@ rexit:
     return ret;
 }
 
+// Uses the device of svr_game when running inside the game process.
+bool EncoderState::vid_create_host_device()
+{
+    bool ret = false;
+    HRESULT hr;
+
+    hr = host->d3d11_device->QueryInterface(IID_PPV_ARGS(&vid_d3d11_device));
+
+    if (FAILED(hr))
+    {
+        error("ERROR: Could not query for newer D3D11 device features (%#x)\n", hr);
+        goto rfail;
+    }
+
+    vid_d3d11_device->GetImmediateContext(&vid_d3d11_context);
+
+    hr = vid_d3d11_device->CreateDeferredContext(0, &vid_deferred_context);
+
+    if (FAILED(hr))
+    {
+        error("ERROR: Could not create D3D11 deferred context (%#x)\n", hr);
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
 bool EncoderState::vid_create_shaders()
 {
     bool ret = false;
@@ -109,26 +169,41 @@ rexit:
     svr_free(vid_shader_mem);
     return ret;
 }
+#endif
 
 void EncoderState::vid_free_static()
 {
+#ifdef _WIN32
     svr_maybe_release(&vid_d3d11_device);
     svr_maybe_release(&vid_d3d11_context);
+    svr_maybe_release(&vid_deferred_context);
 
     svr_maybe_release(&vid_nv12_cs);
     svr_maybe_release(&vid_yuv422_cs);
     svr_maybe_release(&vid_yuv444_cs);
 
     svr_maybe_free((void**)&vid_texture_download_queue);
+#endif
+
+    if (vid_copy_pool)
+    {
+        svr_work_pool_free(vid_copy_pool);
+        vid_copy_pool = NULL;
+    }
 }
 
 void EncoderState::vid_free_dynamic()
 {
-    svr_maybe_close_handle(&game_texture_h);
+#ifdef _WIN32
+    for (s32 i = 0; i < ENCODER_VIDEO_SLOTS; i++)
+    {
+        VidGameTexture* game_tex = &vid_game_texs[i];
 
-    svr_maybe_release(&vid_game_tex);
-    svr_maybe_release(&vid_game_tex_srv);
-    svr_maybe_release(&vid_game_tex_lock);
+        svr_maybe_release(&game_tex->tex);
+        svr_maybe_release(&game_tex->srv);
+        svr_maybe_release(&game_tex->lock);
+        svr_maybe_close_handle(&game_tex->tex_h);
+    }
 
     for (s32 i = 0; i < VID_MAX_PLANES; i++)
     {
@@ -146,14 +221,24 @@ void EncoderState::vid_free_dynamic()
     }
 
     vid_conversion_cs = NULL;
+#endif
+
+    for (s32 i = 0; i < VID_MAX_PLANES; i++)
+    {
+        svr_maybe_free((void**)&vid_cpu_planes[i]);
+    }
+
+    svr_ipc_free_mem(&vid_frame_mem);
+
     vid_num_planes = 0;
 }
 
+#ifdef _WIN32
 bool EncoderState::vid_load_shader(const char* name)
 {
     bool ret = false;
 
-    HANDLE h = CreateFileA(svr_va("data\\shaders\\%s", name), GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    HANDLE h = CreateFileA(svr_va("%s\\data\\shaders\\%s", resource_path, name), GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 
     if (h == INVALID_HANDLE_VALUE)
     {
@@ -243,17 +328,46 @@ bool EncoderState::vid_create_shaders_list(EncoderShader* shaders, s32 num)
 
     return ret;
 }
+#endif
 
 bool EncoderState::vid_start()
 {
     bool ret = false;
 
-    if (!vid_open_game_texture())
+#ifdef SVR_ENCODER_BENCH
+    vid_create_cpu_planes();
+#else
+    if (shared_mem_ptr->frame_mem_id[0])
     {
-        goto rfail;
+        if (!vid_open_frame_mem())
+        {
+            goto rfail;
+        }
+
+        vid_create_cpu_planes();
     }
 
-    vid_create_conversion_texs();
+    else
+    {
+#ifdef _WIN32
+        if (vid_d3d11_device == NULL)
+        {
+            error("ERROR: The svr_game textures cannot be opened without a D3D11 device\n");
+            goto rfail;
+        }
+
+        if (!vid_open_game_textures())
+        {
+            goto rfail;
+        }
+
+        vid_create_conversion_texs();
+#else
+        error("ERROR: The svr_game textures can only be opened on Windows\n");
+        goto rfail;
+#endif
+    }
+#endif
 
     render_download_write_idx = 0;
     render_download_read_idx = 0;
@@ -261,28 +375,49 @@ bool EncoderState::vid_start()
     ret = true;
     goto rexit;
 
+#ifndef SVR_ENCODER_BENCH
 rfail:
+#endif
 
 rexit:
     return ret;
 }
 
-bool EncoderState::vid_open_game_texture()
+#ifdef _WIN32
+bool EncoderState::vid_open_game_textures()
 {
     bool ret = false;
     HRESULT hr;
 
-    hr = vid_d3d11_device->OpenSharedResource1((HANDLE)shared_mem_ptr->game_texture_h, IID_PPV_ARGS(&vid_game_tex));
-
-    if (FAILED(hr))
+    for (s32 i = 0; i < ENCODER_VIDEO_SLOTS; i++)
     {
-        error("ERROR: Could not open the shared svr_game texture (%#x)\n", hr);
-        goto rfail;
-    }
+        VidGameTexture* game_tex = &vid_game_texs[i];
+
+        // Inside the game process the textures are on the same device, so they can be used directly.
+        if (host)
+        {
+            game_tex->tex = host->game_texs[i];
+            game_tex->tex->AddRef();
+
+            vid_d3d11_device->CreateShaderResourceView(game_tex->tex, NULL, &game_tex->srv);
+            continue;
+        }
 
-    vid_d3d11_device->CreateShaderResourceView(vid_game_tex, NULL, &vid_game_tex_srv);
+        // The handles were duplicated into this process, so they are ours to close.
+        game_tex->tex_h = (HANDLE)shared_mem_ptr->game_texture_hs[i];
 
-    vid_game_tex->QueryInterface(IID_PPV_ARGS(&vid_game_tex_lock));
+        hr = vid_d3d11_device->OpenSharedResource1(game_tex->tex_h, IID_PPV_ARGS(&game_tex->tex));
+
+        if (FAILED(hr))
+        {
+            error("ERROR: Could not open the shared svr_game texture (%#x)\n", hr);
+            goto rfail;
+        }
+
+        vid_d3d11_device->CreateShaderResourceView(game_tex->tex, NULL, &game_tex->srv);
+
+        game_tex->tex->QueryInterface(IID_PPV_ARGS(&game_tex->lock));
+    }
 
     ret = true;
     goto rexit;
@@ -298,6 +433,7 @@ struct VidPlaneDesc
     DXGI_FORMAT format;
     s32 shift_x;
     s32 shift_y;
+    s32 pixel_size; // In bytes.
 };
 
 // Setup state and create the textures in the format that can be sent to the encoder.
@@ -312,8 +448,8 @@ void EncoderState::vid_create_conversion_texs()
             vid_conversion_cs = vid_nv12_cs;
             vid_num_planes = 2;
 
-            plane_descs[0] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0 };
-            plane_descs[1] = VidPlaneDesc { DXGI_FORMAT_R8G8_UINT, 1, 1 };
+            plane_descs[0] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0, 1 };
+            plane_descs[1] = VidPlaneDesc { DXGI_FORMAT_R8G8_UINT, 1, 1, 2 };
             break;
         }
 
@@ -322,9 +458,9 @@ void EncoderState::vid_create_conversion_texs()
             vid_conversion_cs = vid_yuv422_cs;
             vid_num_planes = 3;
 
-            plane_descs[0] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0 };
-            plane_descs[1] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 1, 0 };
-            plane_descs[2] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 1, 0 };
+            plane_descs[0] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0, 1 };
+            plane_descs[1] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 1, 0, 1 };
+            plane_descs[2] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 1, 0, 1 };
             break;
         }
 
@@ -333,9 +469,9 @@ void EncoderState::vid_create_conversion_texs()
             vid_conversion_cs = vid_yuv444_cs;
             vid_num_planes = 3;
 
-            plane_descs[0] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0 };
-            plane_descs[1] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0 };
-            plane_descs[2] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0 };
+            plane_descs[0] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0, 1 };
+            plane_descs[1] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0, 1 };
+            plane_descs[2] = VidPlaneDesc { DXGI_FORMAT_R8_UINT, 0, 0, 1 };
             break;
         }
 
@@ -361,6 +497,7 @@ void EncoderState::vid_create_conversion_texs()
         tex_desc.CPUAccessFlags = 0;
 
         vid_plane_heights[i] = tex_desc.Height;
+        vid_plane_row_sizes[i] = tex_desc.Width * plane_desc->pixel_size;
 
         vid_d3d11_device->CreateTexture2D(&tex_desc, NULL, &vid_converted_texs[i]);
         vid_d3d11_device->CreateUnorderedAccessView(vid_converted_texs[i], NULL, &vid_converted_uavs[i]);
@@ -390,30 +527,51 @@ void EncoderState::vid_create_conversion_texs()
 
 // Convert pixel formats and push result to be retrieved later.
 // This must be done to not stall too much.
-void EncoderState::vid_push_texture_for_conversion()
+void EncoderState::vid_push_texture_for_conversion(s32 slot_idx)
 {
-    vid_game_tex_lock->AcquireSync(ENCODER_PROC_ID, INFINITE); // Allow us to read now.
+    VidGameTexture* game_tex = &vid_game_texs[slot_idx];
 
-    vid_d3d11_context->CSSetShader(vid_conversion_cs, NULL, 0);
-    vid_d3d11_context->CSSetShaderResources(0, 1, &vid_game_tex_srv);
-    vid_d3d11_context->CSSetUnorderedAccessViews(0, vid_num_planes, vid_converted_uavs, NULL);
+    // There is no lock when the texture is on the same device as svr_game, since the commands of both are run in order.
+    if (game_tex->lock)
+    {
+        game_tex->lock->AcquireSync(ENCODER_PROC_ID, INFINITE); // Allow us to read now.
+    }
+
+    ID3D11DeviceContext* context = vid_deferred_context ? vid_deferred_context : vid_d3d11_context;
 
-    vid_d3d11_context->Dispatch(vid_get_num_cs_threads(movie_params.video_width), vid_get_num_cs_threads(movie_params.video_height), 1);
+    context->CSSetShader(vid_conversion_cs, NULL, 0);
+    context->CSSetShaderResources(0, 1, &game_tex->srv);
+    context->CSSetUnorderedAccessViews(0, vid_num_planes, vid_converted_uavs, NULL);
 
-    vid_game_tex_lock->ReleaseSync(ENCODER_GAME_ID); // Give back to game.
+    context->Dispatch(vid_get_num_cs_threads(movie_params.video_width), vid_get_num_cs_threads(movie_params.video_height), 1);
+
+    if (game_tex->lock)
+    {
+        game_tex->lock->ReleaseSync(ENCODER_GAME_ID); // Give back to game.
+    }
 
     ID3D11ShaderResourceView* null_srv = NULL;
     ID3D11UnorderedAccessView* null_uav = NULL;
 
-    vid_d3d11_context->CSSetShaderResources(0, 1, &null_srv);
-    vid_d3d11_context->CSSetUnorderedAccessViews(0, 1, &null_uav, NULL);
+    context->CSSetShaderResources(0, 1, &null_srv);
+    context->CSSetUnorderedAccessViews(0, 1, &null_uav, NULL);
 
     s64 wrapped_write_idx = render_download_write_idx & (VID_QUEUED_TEXTURES - 1);
     VidTextureDownloadInput* input = &vid_texture_download_queue[wrapped_write_idx];
 
     for (s32 i = 0; i < vid_num_planes; i++)
     {
-        vid_d3d11_context->CopyResource(input->dl_texs[i], vid_converted_texs[i]);
+        context->CopyResource(input->dl_texs[i], vid_converted_texs[i]);
+    }
+
+    if (vid_deferred_context)
+    {
+        ID3D11CommandList* list = NULL;
+        vid_deferred_context->FinishCommandList(FALSE, &list);
+
+        vid_d3d11_context->ExecuteCommandList(list, TRUE);
+
+        svr_release(list);
     }
 
     // Must flush because we write to the same textures (vid_converted_texs) every time before copying.
@@ -430,42 +588,98 @@ void EncoderState::vid_push_texture_for_conversion()
 // of the reads.
 // Instead we just try and separate the writes from the reads through a large gap, in which hopefully the reads do not suffer too much slowdown.
 // We always read from the oldest textures.
-void EncoderState::vid_download_texture_into_frame(AVFrame* dest_frame)
+// The copy into the frame is started here and finished by vid_finish_download, so the game does not have to wait for it.
+void EncoderState::vid_start_download(AVFrame* dest_frame)
 {
+    assert(vid_copy_input == NULL);
+
     s64 wrapped_read_idx = render_download_read_idx & (VID_QUEUED_TEXTURES - 1);
     VidTextureDownloadInput* input = &vid_texture_download_queue[wrapped_read_idx];
 
-    D3D11_MAPPED_SUBRESOURCE maps[VID_MAX_PLANES];
+    vid_copy_job = {};
+    vid_copy_job.num_planes = vid_num_planes;
+    vid_copy_job.level = vid_simd_level;
 
     for (s32 i = 0; i < vid_num_planes; i++)
     {
-        vid_d3d11_context->Map(input->dl_texs[i], 0, D3D11_MAP_READ, 0, &maps[i]);
+        D3D11_MAPPED_SUBRESOURCE map;
+        vid_map_download_texture(input->dl_texs[i], &map);
+
+        SvrPlaneCopy* plane = &vid_copy_job.planes[i];
+        plane->src = (u8*)map.pData;
+        plane->dest = dest_frame->data[i];
+        plane->src_pitch = map.RowPitch;
+        plane->dest_pitch = dest_frame->linesize[i];
+        plane->row_size = svr_min(vid_plane_row_sizes[i], dest_frame->linesize[i]);
+        plane->num_rows = vid_plane_heights[i];
     }
 
-    for (s32 i = 0; i < vid_num_planes; i++)
-    {
-        D3D11_MAPPED_SUBRESOURCE* map = &maps[i];
-        s32 height = vid_plane_heights[i];
-        u8* source_ptr = (u8*)map->pData;
-        s32 source_line_size = map->RowPitch;
-        u8* dest_ptr = dest_frame->data[i];
-        s32 dest_line_size = dest_frame->linesize[i];
+    svr_copy_start(&vid_copy_job, vid_copy_pool);
 
-        for (s32 j = 0; j < height; j++)
-        {
-            memcpy(dest_ptr, source_ptr, dest_line_size);
+    vid_copy_input = input;
+    vid_copy_frame = dest_frame;
 
-            source_ptr += source_line_size;
-            dest_ptr += dest_line_size;
+    render_download_read_idx++;
+}
+
+void EncoderState::vid_map_download_texture(ID3D11Texture2D* tex, D3D11_MAPPED_SUBRESOURCE* map)
+{
+    // A waiting map holds the lock of the device, and inside the game process that would stop svr_game from rendering until the copy is done.
+    // So poll instead and only take the lock for a moment every time.
+    // The copy is usually about to finish, so the first tries only give away the time slice. After that the GPU is behind,
+    // and sleeping between tries keeps us from using a whole core of the game while it catches up.
+    if (host)
+    {
+        for (s32 i = 0; vid_d3d11_context->Map(tex, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, map) == DXGI_ERROR_WAS_STILL_DRAWING; i++)
+        {
+            if (i < VID_HOST_MAP_YIELDS)
+            {
+                SwitchToThread();
+            }
+
+            else
+            {
+                Sleep(1);
+            }
         }
+
+        return;
+    }
+
+    vid_d3d11_context->Map(tex, 0, D3D11_MAP_READ, 0, map);
+}
+
+s32 EncoderState::vid_get_num_cs_threads(s32 unit)
+{
+    // Thread group divisor constant must match the thread count in the compute shaders!
+    return svr_align32(unit, 8) >> 3;
+}
+#endif
+
+// Waits for the copy from vid_start_download and gives back the frame.
+// Returns NULL if there was no copy.
+AVFrame* EncoderState::vid_finish_download()
+{
+    if (vid_copy_frame == NULL)
+    {
+        return NULL;
     }
 
+    svr_copy_wait(vid_copy_pool);
+
+#ifdef _WIN32
     for (s32 i = 0; i < vid_num_planes; i++)
     {
-        vid_d3d11_context->Unmap(input->dl_texs[i], 0);
+        vid_d3d11_context->Unmap(vid_copy_input->dl_texs[i], 0);
     }
 
-    render_download_read_idx++;
+    vid_copy_input = NULL;
+#endif
+
+    AVFrame* ret = vid_copy_frame;
+    vid_copy_frame = NULL;
+
+    return ret;
 }
 
 bool EncoderState::vid_can_map_now()
@@ -480,8 +694,106 @@ bool EncoderState::vid_drain_textures()
     return dist > 0;
 }
 
-s32 EncoderState::vid_get_num_cs_threads(s32 unit)
+// The memory was given to this process by svr_game, so it is ours to close.
+bool EncoderState::vid_open_frame_mem()
 {
-    // Thread group divisor constant must match the thread count in the compute shaders!
-    return svr_align32(unit, 8) >> 3;
+    bool ret = false;
+
+    s64 frame_size = (s64)movie_params.video_width * movie_params.video_height * 4;
+
+    if (!svr_ipc_open_given_mem(shared_mem_ptr->frame_mem_id, &vid_frame_mem))
+    {
+        error("ERROR: Could not open the svr_game frame memory (%u)\n", svr_get_last_error());
+        goto rfail;
+    }
+
+    if (vid_frame_mem.size < frame_size * ENCODER_VIDEO_SLOTS)
+    {
+        error("ERROR: The svr_game frame memory is too small for the movie\n");
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+// Same planes as vid_create_conversion_texs, but in memory.
+void EncoderState::vid_create_cpu_planes()
+{
+    SvrPixelFormat format = SVR_PIXEL_FORMAT_NV12;
+
+    switch (render_video_info->pixel_format)
+    {
+        case AV_PIX_FMT_NV12: format = SVR_PIXEL_FORMAT_NV12; break;
+        case AV_PIX_FMT_YUV422P: format = SVR_PIXEL_FORMAT_YUV422P; break;
+        case AV_PIX_FMT_YUV444P: format = SVR_PIXEL_FORMAT_YUV444P; break;
+
+        // This must work because the render info is our own thing.
+        default: assert(false);
+    }
+
+    vid_cpu_conversion = {};
+    vid_cpu_conversion.format = format;
+    vid_cpu_conversion.width = movie_params.video_width;
+    vid_cpu_conversion.height = movie_params.video_height;
+    vid_cpu_conversion.src_pitch = movie_params.video_width * 4;
+
+    vid_num_planes = svr_color_get_num_planes(format);
+
+    for (s32 i = 0; i < vid_num_planes; i++)
+    {
+        SvrVec2I size = svr_color_get_plane_size(format, i, movie_params.video_width, movie_params.video_height);
+
+        vid_plane_heights[i] = size.y;
+        vid_plane_row_sizes[i] = size.x;
+
+        // Mapped textures have aligned rows too.
+        s32 pitch = svr_align32(size.x, 64);
+
+        vid_cpu_planes[i] = (u8*)svr_alloc(pitch * size.y);
+        vid_cpu_conversion.planes[i] = vid_cpu_planes[i];
+        vid_cpu_conversion.pitches[i] = pitch;
+    }
+}
+
+// In place of vid_push_texture_for_conversion and the download, for frames that are in memory.
+// The frame is ready to be encoded right away, since nothing has to wait for the GPU.
+AVFrame* EncoderState::vid_convert_on_cpu(const u8* src)
+{
+    s64 start = svr_prof_get_real_time();
+
+    vid_cpu_conversion.src = src;
+    svr_color_convert(&vid_cpu_conversion, vid_simd_level, vid_copy_pool);
+
+    stats_add_stage(SVR_STATS_ENCODER_STAGE_CONVERT, start);
+
+    AVFrame* frame = pool_get_video_frame();
+
+    start = svr_prof_get_real_time();
+
+    SvrCopyJob job = {};
+    job.num_planes = vid_num_planes;
+    job.level = vid_simd_level;
+
+    for (s32 i = 0; i < vid_num_planes; i++)
+    {
+        SvrPlaneCopy* plane = &job.planes[i];
+        plane->src = vid_cpu_planes[i];
+        plane->dest = frame->data[i];
+        plane->src_pitch = vid_cpu_conversion.pitches[i];
+        plane->dest_pitch = frame->linesize[i];
+        plane->row_size = svr_min(vid_plane_row_sizes[i], frame->linesize[i]);
+        plane->num_rows = vid_plane_heights[i];
+    }
+
+    svr_copy_planes_parallel(&job, vid_copy_pool);
+
+    stats_add_stage(SVR_STATS_ENCODER_STAGE_DOWNLOAD, start);
+
+    return frame;
 }
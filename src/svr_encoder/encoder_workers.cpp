@@ -0,0 +1,409 @@
+#include "encoder_priv.h"
+
+// Parallel video encoding for encoders where every frame is independent.
+// Each worker has its own codec context and pulls frames from a shared queue, so a worker that is done can take the next frame
+// regardless of how long the other workers take. The packets will arrive out of order to the packet thread, which puts them back in order.
+
+// Other encoders are run in parallel by splitting the video into chunks of a fixed number of frames.
+// Every chunk is encoded with a new codec context, so it starts with a keyframe and no frame references another chunk.
+// All contexts are opened with the same parameters so they produce the same headers as render_video_ctx, which is what the stream uses.
+// Every context is given the frames of its chunk from 0, and the timestamps of the packets are moved back by where the chunk starts.
+// The chunks can then be written one after the other as one stream, which fails if a context delays its packets differently (see svr_reorder.h).
+
+void render_video_worker_thread_proc(void* param)
+{
+#ifdef _WIN32
+    SetThreadDescription(GetCurrentThread(), L"RENDER VIDEO WORKER THREAD");
+#endif
+    svr_trace_set_thread_name("RENDER VIDEO WORKER THREAD");
+
+    RenderVideoWorker* worker = (RenderVideoWorker*)param;
+    worker->encoder->render_video_worker_proc(worker);
+}
+
+bool EncoderState::render_use_video_workers()
+{
+    if (movie_params.encode_workers <= 1)
+    {
+        return false;
+    }
+
+    return render_video_info->intra_only || movie_params.x264_intra || render_use_video_chunks();
+}
+
+// Encoders with frames that reference each other must be encoded in chunks.
+bool EncoderState::render_use_video_chunks()
+{
+    if (render_video_info->intra_only || movie_params.x264_intra)
+    {
+        return false;
+    }
+
+    return movie_params.x264_chunk_length > 0;
+}
+
+// Creates the codec contexts for the workers. The threads are started in render_start_threads.
+bool EncoderState::render_start_video_workers()
+{
+    bool ret = false;
+
+    render_video_workers = SVR_ZALLOC_NUM(RenderVideoWorker, render_num_video_workers);
+
+    // Same thread split as the first context.
+    s32 num_threads = render_video_ctx->thread_count;
+
+    for (s32 i = 0; i < render_num_video_workers; i++)
+    {
+        RenderVideoWorker* worker = &render_video_workers[i];
+        worker->encoder = this;
+
+        // Contexts for chunks are opened by the workers when a chunk starts.
+        if (render_video_chunk_frames > 0)
+        {
+            worker->chunk_queue.init(RENDER_QUEUED_FRAMES);
+            worker->queue = &worker->chunk_queue;
+            continue;
+        }
+
+        worker->queue = &render_worker_queue;
+
+        if (i == 0)
+        {
+            worker->ctx = render_video_ctx;
+        }
+
+        else
+        {
+            s32 res = render_open_video_ctx(num_threads, &worker->ctx);
+
+            if (res < 0)
+            {
+                error("ERROR: Could not open render video codec for worker %d (%d)\n", i, res);
+                goto rfail;
+            }
+        }
+    }
+
+    svr_atom_store(&render_workers_status, 1);
+
+    render_video_chunk_idx = 0;
+    render_chunk_worker = NULL;
+
+    if (render_video_chunk_frames > 0)
+    {
+        svr_log("Using %d video workers with %d threads each in chunks of %d frames\n", render_num_video_workers, num_threads, render_video_chunk_frames);
+    }
+
+    else
+    {
+        svr_log("Using %d video workers with %d threads each\n", render_num_video_workers, num_threads);
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+// Sends a flush to every worker and waits for them to finish.
+void EncoderState::render_stop_video_workers()
+{
+    if (render_chunk_worker)
+    {
+        render_end_video_chunk();
+    }
+
+    for (s32 i = 0; i < render_num_video_workers; i++)
+    {
+        RenderWorkerInput flush_input = {};
+        flush_input.chunk_idx = -1;
+        render_push_wait(render_video_workers[i].queue, &flush_input, &render_workers_status);
+    }
+
+    svr_doorbell_ring(&render_worker_bell); // Notify workers.
+
+    for (s32 i = 0; i < render_num_video_workers; i++)
+    {
+        svr_thread_join(&render_video_workers[i].thread);
+    }
+}
+
+void EncoderState::render_free_video_workers()
+{
+    if (render_video_workers == NULL)
+    {
+        render_num_video_workers = 0;
+        return;
+    }
+
+    for (s32 i = 0; i < render_num_video_workers; i++)
+    {
+        RenderVideoWorker* worker = &render_video_workers[i];
+
+        // The first context is render_video_ctx which is freed elsewhere, unless this worker opens its own for every chunk.
+        if (i != 0 || render_video_chunk_frames > 0)
+        {
+            avcodec_free_context(&worker->ctx);
+        }
+
+        // Frames can be left here if the worker failed.
+        RenderWorkerInput input = {};
+
+        while (worker->chunk_queue.cells && worker->chunk_queue.pull(&input))
+        {
+            av_frame_free(&input.frame);
+        }
+
+        worker->chunk_queue.free();
+
+        svr_thread_join(&worker->thread); // Already stopped, this only frees it.
+    }
+
+    svr_free(render_video_workers);
+    render_video_workers = NULL;
+    render_num_video_workers = 0;
+}
+
+// Picks the worker for a new chunk and sends the frame there.
+// A chunk is given to the worker with the least chunks left to encode, so a worker that is slow with one chunk gets less of the next ones.
+void EncoderState::render_give_chunk_frame(AVFrame* frame)
+{
+    s64 chunk_idx = frame->pts / render_video_chunk_frames;
+
+    if (render_chunk_worker && chunk_idx != render_video_chunk_idx)
+    {
+        render_end_video_chunk();
+    }
+
+    if (render_chunk_worker == NULL)
+    {
+        // Start looking after the previous worker so that idle workers take turns.
+        s32 start_idx = (s32)(chunk_idx % render_num_video_workers);
+        RenderVideoWorker* best_worker = NULL;
+        s32 best_num_chunks = INT32_MAX;
+
+        for (s32 i = 0; i < render_num_video_workers; i++)
+        {
+            RenderVideoWorker* worker = &render_video_workers[(start_idx + i) % render_num_video_workers];
+            s32 num_chunks = svr_atom_load(&worker->num_chunks);
+
+            if (num_chunks < best_num_chunks)
+            {
+                best_worker = worker;
+                best_num_chunks = num_chunks;
+            }
+        }
+
+        svr_atom_add(&best_worker->num_chunks, 1);
+
+        render_chunk_worker = best_worker;
+        render_video_chunk_idx = chunk_idx;
+    }
+
+    RenderWorkerInput input = {};
+    input.frame = frame;
+    input.chunk_idx = chunk_idx;
+
+    if (!render_push_wait(render_chunk_worker->queue, &input, &render_workers_status))
+    {
+        av_frame_free(&input.frame);
+    }
+
+    SVR_TRACE_COUNTER("render_chunk_queue", render_chunk_worker->queue->size());
+
+    svr_doorbell_ring(&render_worker_bell); // Notify workers.
+}
+
+// Tells the worker of the current chunk that there are no more frames for it.
+void EncoderState::render_end_video_chunk()
+{
+    RenderWorkerInput input = {};
+    input.chunk_idx = render_video_chunk_idx;
+
+    render_push_wait(render_chunk_worker->queue, &input, &render_workers_status);
+    svr_doorbell_ring(&render_worker_bell); // Notify workers.
+
+    render_chunk_worker = NULL;
+}
+
+// In video worker thread.
+void EncoderState::render_video_worker_proc(RenderVideoWorker* worker)
+{
+    bool run = true;
+
+    while (run)
+    {
+        s32 ticket = svr_doorbell_prepare(&render_worker_bell);
+
+        // Exit thread on external error.
+        if (svr_atom_load(&render_started) == 0)
+        {
+            break;
+        }
+
+        RenderWorkerInput input = {};
+
+        // Only one flush frame must be taken, the other workers need theirs.
+        while (run && worker->queue->pull(&input))
+        {
+            if (input.chunk_idx >= 0)
+            {
+                if (!render_encode_chunk_input(worker, &input))
+                {
+                    goto rfail;
+                }
+
+                continue;
+            }
+
+            if (input.frame == NULL)
+            {
+                run = false; // Stop on flush frame.
+
+                // Nothing to flush when the contexts are only open for a chunk.
+                if (render_video_chunk_frames > 0)
+                {
+                    break;
+                }
+            }
+
+            SVR_TRACE_SCOPE("encode_video_frame");
+            StatsEncodeScope encode_scope(this, AVMEDIA_TYPE_VIDEO);
+
+            s64 start = svr_prof_get_real_time();
+            bool is_frame = input.frame != NULL;
+
+            s32 res = avcodec_send_frame(worker->ctx, input.frame);
+
+            if (input.frame)
+            {
+                pool_put_video_frame(input.frame);
+            }
+
+            if (res < 0)
+            {
+                SVR_SNPRINTF(worker->message, "ERROR: Could not send raw frame to encoder (%d)\n", res);
+                goto rfail;
+            }
+
+            // Every frame is a keyframe so the decode order is the same as the presentation order.
+            // The presentation timestamps were set by the main thread so they can be used to put the packets back in order.
+            res = render_receive_packets(worker->ctx, render_video_stream, RENDER_PACKET_ORDER_FRAME, -1);
+
+            if (res < 0)
+            {
+                SVR_SNPRINTF(worker->message, "ERROR: Could not receive packet from encoder (%d)\n", res);
+                goto rfail;
+            }
+
+            if (is_frame)
+            {
+                stats_add_stage(SVR_STATS_ENCODER_STAGE_ENCODE, start);
+            }
+        }
+
+        if (run)
+        {
+            svr_doorbell_wait(&render_worker_bell, ticket);
+        }
+    }
+
+    goto rexit;
+
+rfail:
+    svr_atom_store(&render_workers_status, 0);
+
+rexit:
+    return;
+}
+
+// In video worker thread.
+// Encodes a frame of a chunk, or finishes the chunk if the frame is NULL.
+bool EncoderState::render_encode_chunk_input(RenderVideoWorker* worker, RenderWorkerInput* input)
+{
+    SVR_TRACE_SCOPE("encode_chunk_frame");
+    StatsEncodeScope encode_scope(this, AVMEDIA_TYPE_VIDEO);
+
+    bool ret = false;
+    s32 res;
+    s64 start = svr_prof_get_real_time();
+
+    // First frame of a new chunk.
+    if (worker->ctx == NULL)
+    {
+        res = render_open_video_ctx(render_video_ctx->thread_count, &worker->ctx);
+
+        if (res < 0)
+        {
+            SVR_SNPRINTF(worker->message, "ERROR: Could not open render video codec for chunk (%d)\n", res);
+            goto rfail;
+        }
+
+        // The headers are only written once for the stream, so every chunk must be able to use them.
+        AVCodecContext* stream_ctx = render_video_ctx;
+
+        if (worker->ctx->extradata_size != stream_ctx->extradata_size || memcmp(worker->ctx->extradata, stream_ctx->extradata, stream_ctx->extradata_size))
+        {
+            SVR_COPY_STRING("ERROR: Video codec headers for chunk are not the same as for the stream\n", worker->message);
+            goto rfail;
+        }
+    }
+
+    // Every context starts from 0, and the packets are moved back to where the chunk starts when they are received.
+    if (input->frame)
+    {
+        input->frame->pts -= input->chunk_idx * render_video_chunk_frames;
+    }
+
+    res = avcodec_send_frame(worker->ctx, input->frame);
+
+    if (input->frame)
+    {
+        pool_put_video_frame(input->frame);
+    }
+
+    if (res < 0)
+    {
+        SVR_SNPRINTF(worker->message, "ERROR: Could not send raw frame to encoder (%d)\n", res);
+        goto rfail;
+    }
+
+    res = render_receive_packets(worker->ctx, render_video_stream, RENDER_PACKET_ORDER_CHUNK, input->chunk_idx);
+
+    if (res < 0)
+    {
+        SVR_SNPRINTF(worker->message, "ERROR: Could not receive packet from encoder (%d)\n", res);
+        goto rfail;
+    }
+
+    // End of chunk. Everything has been received from the context now.
+    if (input->frame == NULL)
+    {
+        RenderPacketThreadInput end_input = {};
+        end_input.reorder_idx = input->chunk_idx;
+        end_input.reorder_last = true;
+
+        render_push_wait(&render_packet_queue, &end_input, &render_packet_thread_status);
+        svr_doorbell_ring(&render_packet_bell); // Notify packet thread.
+
+        avcodec_free_context(&worker->ctx);
+
+        svr_atom_sub(&worker->num_chunks, 1);
+    }
+
+    else
+    {
+        stats_add_stage(SVR_STATS_ENCODER_STAGE_ENCODE, start);
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
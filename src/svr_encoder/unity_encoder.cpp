@@ -1,9 +1,14 @@
 #include "encoder_priv.h"
 #include "encoder_main.cpp"
+#include "encoder_host.cpp"
 #include "encoder_state.cpp"
 #include "encoder_audio.cpp"
 #include "encoder_video.cpp"
 #include "encoder_render.cpp"
+#include "encoder_pool.cpp"
+#include "encoder_workers.cpp"
 #include "encoder_dnxhr.cpp"
 #include "encoder_libx264.cpp"
 #include "encoder_render_threads.cpp"
+#include "encoder_stats.cpp"
+#include "encoder_bench.cpp"
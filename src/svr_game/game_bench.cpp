@@ -0,0 +1,415 @@
+#include "proc_priv.h"
+
+// Benchmark of the whole svr_game pipeline without a game, built as svr_game_bench.exe.
+// On other platforms it is built by CMakeLists.txt together with svr_encoder, and the velo is not drawn since there are no fonts to load.
+// Made up game frames, velocity and audio are given to ProcState the same way as through svr_api, and go through the motion blur,
+// the velo and svr_encoder into a movie like in a game. There is no D3D11 device, so the frames are processed by the CPU backend
+// and svr_encoder converts them on the processor too. This runs on machines without a GPU.
+// The movie profile, svr_encoder.exe and the movies folder are taken from the SVR directory.
+// The result is written to stdout as one JSON object so that runs can be compared between versions. Everything else goes to the log.
+
+#ifdef SVR_GAME_BENCH
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/stat.h>
+#include <sys/resource.h>
+#endif
+
+const s32 GAME_BENCH_MADE_UP_FRAMES = 8; // Frames to make up, which are given one after another like the buffers of a swapchain.
+const s32 GAME_BENCH_MAX_SIZE = 8192; // Max width and height.
+const s32 GAME_BENCH_AUDIO_HZ = 44100;
+const s32 GAME_BENCH_TONE_HZ = 441; // Whole periods fit in one second, so the tone has no jump when it starts over.
+const double GAME_BENCH_PI = 3.14159265358979323846;
+
+struct GameBenchOptions
+{
+    s32 num_frames; // Video frames of the movie.
+    s32 width;
+    s32 height;
+    const char* svr_path;
+    const char* profile; // Applied over the default profile, or NULL.
+    const char* output; // Name of the movie in the movies folder.
+};
+
+static void game_bench_print_json_string(const char* str)
+{
+    putchar('"');
+
+    for (const char* c = str; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            printf("\\%c", *c);
+        }
+
+        else if ((u8)*c < 0x20)
+        {
+            printf("\\u%04x", (u8)*c);
+        }
+
+        else
+        {
+            putchar(*c);
+        }
+    }
+
+    putchar('"');
+}
+
+// Returns -1 if the file cannot be found.
+static s64 game_bench_get_file_size(const char* path)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attrs;
+
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attrs))
+    {
+        return -1;
+    }
+
+    return ((s64)attrs.nFileSizeHigh << 32) | attrs.nFileSizeLow;
+#else
+    struct stat attrs;
+
+    if (stat(path, &attrs) != 0)
+    {
+        return -1;
+    }
+
+    return (s64)attrs.st_size;
+#endif
+}
+
+// Peak memory of this process, which does not have svr_encoder in it.
+static u64 game_bench_get_process_peak()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS mem_counters = {};
+    GetProcessMemoryInfo(GetCurrentProcess(), &mem_counters, sizeof(mem_counters));
+
+    return (u64)mem_counters.PeakWorkingSetSize;
+#else
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (u64)usage.ru_maxrss * 1024; // In kilobytes on Linux.
+#endif
+}
+
+static void game_bench_print_usage()
+{
+    printf("Usage: svr_game_bench [options]\n");
+    printf("\n");
+    printf("Makes a movie from made up game frames with the frame pipeline of svr_game and svr_encoder, and prints the result as JSON.\n");
+    printf("The frames are processed on the processor, so no GPU is needed.\n");
+    printf("\n");
+    printf("    --frames <n>        Video frames of the movie, 600 by default\n");
+    printf("    --width <n>         Width of the game frames, 1920 by default\n");
+    printf("    --height <n>        Height of the game frames, 1080 by default\n");
+    printf("    --svr-path <path>   SVR directory with svr_encoder.exe and the profiles, the current directory by default\n");
+    printf("    --profile <name>    Movie profile to use over the default profile\n");
+    printf("    --output <name>     Movie to write in the movies folder, svr_game_bench.mov by default\n");
+}
+
+static bool game_bench_parse_options(s32 argc, char** argv, GameBenchOptions* opts)
+{
+    opts->num_frames = 600;
+    opts->width = 1920;
+    opts->height = 1080;
+    opts->svr_path = ".";
+    opts->profile = NULL;
+    opts->output = "svr_game_bench.mov";
+
+    for (s32 i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        // Everything has a value.
+        if (value == NULL)
+        {
+            return false;
+        }
+
+        i++;
+
+        if (!strcmp(arg, "--frames"))
+        {
+            opts->num_frames = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--width"))
+        {
+            opts->width = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--height"))
+        {
+            opts->height = atoi(value);
+        }
+
+        else if (!strcmp(arg, "--svr-path"))
+        {
+            opts->svr_path = value;
+        }
+
+        else if (!strcmp(arg, "--profile"))
+        {
+            opts->profile = value;
+        }
+
+        else if (!strcmp(arg, "--output"))
+        {
+            opts->output = value;
+        }
+
+        else
+        {
+            return false;
+        }
+    }
+
+    // The size must be even for the chroma planes.
+
+    if (opts->num_frames < 1)
+    {
+        return false;
+    }
+
+    if (opts->width < 2 || opts->width > GAME_BENCH_MAX_SIZE || opts->width & 1)
+    {
+        return false;
+    }
+
+    if (opts->height < 2 || opts->height > GAME_BENCH_MAX_SIZE || opts->height & 1)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Gradients that move a bit between the frames, with a bar that moves faster so the motion blur has something to blend.
+static u8* game_bench_make_frames(s32 width, s32 height)
+{
+    s64 frame_size = (s64)width * height * 4;
+    u8* frames = (u8*)svr_alloc(frame_size * GAME_BENCH_MADE_UP_FRAMES);
+
+    for (s32 i = 0; i < GAME_BENCH_MADE_UP_FRAMES; i++)
+    {
+        u8* frame = frames + i * frame_size;
+        s32 bar_x = (i * width) / GAME_BENCH_MADE_UP_FRAMES;
+        s32 bar_w = svr_max(width / 32, 1);
+
+        for (s32 y = 0; y < height; y++)
+        {
+            u8* row = frame + (s64)y * width * 4;
+
+            for (s32 x = 0; x < width; x++)
+            {
+                bool in_bar = x >= bar_x && x < bar_x + bar_w;
+
+                row[x * 4 + 0] = in_bar ? 255 : (u8)((x + i * 4) * 255 / width);
+                row[x * 4 + 1] = in_bar ? 255 : (u8)((y + i * 2) * 255 / height);
+                row[x * 4 + 2] = in_bar ? 255 : (u8)(((x + y) / 2 + i * 8) & 255);
+                row[x * 4 + 3] = 255;
+            }
+        }
+    }
+
+    return frames;
+}
+
+// One second of a tone, which is given again from the start.
+static SvrWaveSample* game_bench_make_audio()
+{
+    SvrWaveSample* samples = SVR_ZALLOC_NUM(SvrWaveSample, GAME_BENCH_AUDIO_HZ);
+
+    for (s32 i = 0; i < GAME_BENCH_AUDIO_HZ; i++)
+    {
+        double t = (double)i / (double)GAME_BENCH_AUDIO_HZ;
+
+        samples[i].l = (s16)(sin(t * GAME_BENCH_TONE_HZ * 2.0 * GAME_BENCH_PI) * 8192.0);
+        samples[i].r = (s16)(sin(t * GAME_BENCH_TONE_HZ * 4.0 * GAME_BENCH_PI) * 8192.0);
+    }
+
+    return samples;
+}
+
+// Gives the samples from the tone, in pieces where it starts over.
+static void game_bench_give_audio(SvrWaveSample* tone, s32* tone_pos, s32 num_samples)
+{
+    while (num_samples > 0)
+    {
+        s32 num = svr_min(num_samples, GAME_BENCH_AUDIO_HZ - *tone_pos);
+
+        proc_state.new_audio_samples(tone + *tone_pos, SVR_WAVE_FORMAT_S16, num);
+
+        *tone_pos = (*tone_pos + num) % GAME_BENCH_AUDIO_HZ;
+        num_samples -= num;
+    }
+}
+
+static void game_bench_print_error(const char* message)
+{
+    printf("{\"error\":");
+    game_bench_print_json_string(message);
+    printf("}\n");
+}
+
+static s32 game_bench_run(s32 argc, char** argv)
+{
+    s32 ret = 1;
+
+    GameBenchOptions opts;
+    ProcGameTexture game_texture = {};
+    SvrAudioParams audio_params = {};
+    u8* frames = NULL;
+    SvrWaveSample* tone = NULL;
+    s32 tone_pos = 0;
+    s64 frame_size;
+    s64 start_time;
+    s64 end_time;
+    s32 game_rate;
+    s32 video_fps;
+    s64 pos = 0; // In frames at the game rate.
+    s64 end_pos;
+    s64 num_game_frames = 0;
+    double seconds;
+    char output_path[MAX_PATH];
+
+    if (!game_bench_parse_options(argc, argv, &opts))
+    {
+        game_bench_print_usage();
+        return 1;
+    }
+
+    if (!proc_state.init(opts.svr_path, NULL))
+    {
+        game_bench_print_error("Could not init svr_game, see GAME_BENCH_LOG.txt");
+        goto rfail;
+    }
+
+    frame_size = (s64)opts.width * opts.height * 4;
+    frames = game_bench_make_frames(opts.width, opts.height);
+    tone = game_bench_make_audio();
+
+    game_texture.pixels = frames;
+    game_texture.pitch = opts.width * 4;
+    game_texture.width = opts.width;
+    game_texture.height = opts.height;
+
+    audio_params.audio_channels = 2;
+    audio_params.audio_hz = GAME_BENCH_AUDIO_HZ;
+    audio_params.audio_bits = 16;
+
+    start_time = svr_prof_get_real_time();
+
+    // The fps is in the profile, so the length of the movie is not known in seconds yet.
+    if (!proc_state.start(opts.output, opts.profile, &game_texture, &audio_params, true, 0))
+    {
+        game_bench_print_error("Could not start the movie, see GAME_BENCH_LOG.txt");
+        goto rfail;
+    }
+
+    game_rate = proc_state.get_game_rate();
+    video_fps = proc_state.movie_profile.video_fps;
+    end_pos = (s64)opts.num_frames * (game_rate / video_fps);
+
+    // Like a game that sets its frame time from svr_get_frame_steps, so skipped and adaptive sub-frames are covered by longer game frames.
+    while (pos < end_pos)
+    {
+        s32 steps = proc_state.get_frame_steps(0);
+        double t = (double)pos / (double)game_rate;
+
+        proc_state.svr_game_texture.pixels = frames + (num_game_frames % GAME_BENCH_MADE_UP_FRAMES) * frame_size;
+
+        if (proc_state.is_velo_enabled())
+        {
+            SvrVec3 velo;
+            velo.x = (float)(cos(t) * 400.0);
+            velo.y = (float)(sin(t) * 400.0);
+            velo.z = (float)(sin(t * 3.0) * 100.0);
+
+            proc_state.velo_give(velo);
+        }
+
+        // The audio covers the same time as the game frame, with the remainder spread out between the frames.
+        if (proc_state.is_audio_enabled())
+        {
+            s32 num_samples = (s32)(((pos + steps) * GAME_BENCH_AUDIO_HZ / game_rate) - (pos * GAME_BENCH_AUDIO_HZ / game_rate));
+            game_bench_give_audio(tone, &tone_pos, num_samples);
+        }
+
+        proc_state.new_video_frame();
+
+        pos += steps;
+        num_game_frames++;
+    }
+
+    // Waits for svr_encoder to finish the movie.
+    proc_state.end();
+
+    end_time = svr_prof_get_real_time();
+    seconds = (double)(end_time - start_time) / 1000000.0;
+
+    SVR_SNPRINTF(output_path, "%s" SVR_PATH_SEP "movies" SVR_PATH_SEP "%s", opts.svr_path, opts.output);
+
+    printf("{\"svr_version\":%d", SVR_VERSION);
+
+    printf(",\"backend\":\"%s\",\"simd\":\"%s\",\"threads\":%d", proc_state.backend->name, svr_simd_get_level_name(proc_state.cpu_simd_level), svr_work_pool_get_num_threads(proc_state.cpu_pool));
+    printf(",\"profile\":");
+    game_bench_print_json_string(opts.profile ? opts.profile : "default");
+    printf(",\"velo\":%s", proc_state.is_velo_enabled() ? "true" : "false");
+
+    printf(",\"width\":%d,\"height\":%d,\"fps\":%d,\"game_rate\":%d", opts.width, opts.height, video_fps, game_rate);
+    printf(",\"frames\":%d,\"game_frames\":%lld", opts.num_frames, (long long)num_game_frames);
+
+    printf(",\"seconds\":%.3f,\"frames_per_second\":%.2f,\"game_frames_per_second\":%.2f", seconds, opts.num_frames / seconds, num_game_frames / seconds);
+    printf(",\"realtime\":%.3f", (opts.num_frames / seconds) / video_fps);
+
+    printf(",\"process_peak\":%llu", (unsigned long long)game_bench_get_process_peak());
+
+    printf(",\"output\":");
+    game_bench_print_json_string(output_path);
+    printf(",\"output_size\":%lld", (long long)game_bench_get_file_size(output_path));
+
+    printf("}\n");
+
+    ret = 0;
+    goto rexit;
+
+rfail:
+
+rexit:
+    svr_maybe_free((void**)&frames);
+    svr_maybe_free((void**)&tone);
+
+    proc_state.free_static();
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    // The result goes to stdout, so the log goes to a file.
+    svr_init_log("GAME_BENCH_LOG.txt", false);
+
+    svr_log("SVR " SVR_ARCH_STRING " version %d game benchmark\n", SVR_VERSION);
+
+#ifdef _WIN32
+    // WIC is used to draw the velo digits without a device.
+    CoInitializeEx(NULL, COINIT_MULTITHREADED);
+#endif
+
+    s32 ret = game_bench_run(argc, argv);
+
+#ifdef _WIN32
+    CoUninitialize();
+#endif
+
+    return ret;
+}
+
+#endif
@@ -0,0 +1,348 @@
+#include "proc_priv.h"
+
+// Backend that processes the frames on the processor, used when there is no D3D11 device.
+// The motion blur is the processor version in svr_mosample, which gives the same frames as the shaders.
+// The slots of the video ring are in memory that svr_encoder opens, and it converts the frames on the processor too.
+// The velo digits are rasterized with D2D1 on a WIC bitmap, which also needs no device.
+// This is the only backend on other platforms, where there is no velo since the digits cannot be rasterized.
+
+bool proc_cpu_init(ProcState* proc)
+{
+    proc->cpu_pool = svr_work_pool_create(0);
+    proc->cpu_simd_level = svr_simd_get_best_level();
+
+    svr_log("Using %d threads with %s for frames\n", svr_work_pool_get_num_threads(proc->cpu_pool), svr_simd_get_level_name(proc->cpu_simd_level));
+
+    return true;
+}
+
+void proc_cpu_free(ProcState* proc)
+{
+    if (proc->cpu_pool)
+    {
+        svr_work_pool_free(proc->cpu_pool);
+        proc->cpu_pool = NULL;
+    }
+}
+
+bool proc_cpu_create_targets(ProcState* proc)
+{
+    for (s32 i = 0; i < proc->mosample_schedule.num_shutters; i++)
+    {
+        svr_mosample_create_buffer(&proc->cpu_targets[i], proc->movie_width, proc->movie_height);
+    }
+
+    if (proc->mosample_schedule.timers[0].adaptive || proc->mosample_synth > 0)
+    {
+        proc->cpu_prev_frame = (u8*)svr_alloc(proc->movie_width * proc->movie_height * 4);
+        proc->cpu_has_prev = false;
+    }
+
+    if (proc->mosample_synth > 0)
+    {
+        svr_motion_create_field(&proc->cpu_motion, proc->movie_width, proc->movie_height);
+        proc->cpu_synth_frame = (u8*)svr_alloc(proc->svr_game_texture.pitch * proc->movie_height);
+    }
+
+    return true;
+}
+
+void proc_cpu_free_targets(ProcState* proc)
+{
+    for (s32 i = 0; i < SVR_MOSAMPLE_MAX_SHUTTERS; i++)
+    {
+        svr_mosample_free_buffer(&proc->cpu_targets[i]);
+    }
+
+    svr_maybe_free((void**)&proc->cpu_prev_frame);
+    svr_maybe_free((void**)&proc->cpu_synth_frame);
+
+    svr_motion_free_field(&proc->cpu_motion);
+}
+
+bool proc_cpu_create_share_slots(ProcState* proc, ProcEncoder* enc)
+{
+    bool ret = false;
+
+    s32 frame_size = proc->movie_width * proc->movie_height * 4;
+    s64 mem_size = (s64)frame_size * ENCODER_VIDEO_SLOTS;
+
+    if (mem_size > INT32_MAX)
+    {
+        svr_log("ERROR: The frames of %dx%d are too big to share with the encoder\n", proc->movie_width, proc->movie_height);
+        goto rfail;
+    }
+
+    if (!svr_ipc_create_mem((s32)mem_size, &enc->frame_mem))
+    {
+        svr_log("ERROR: Could not create encoder frame memory (%u)\n", svr_get_last_error());
+        goto rfail;
+    }
+
+    for (s32 i = 0; i < ENCODER_VIDEO_SLOTS; i++)
+    {
+        enc->share_slots[i].pixels = (u8*)enc->frame_mem.ptr + i * frame_size;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+void proc_cpu_free_share_slots(ProcState* proc, ProcEncoder* enc)
+{
+    (void)proc;
+
+    for (s32 i = 0; i < ENCODER_VIDEO_SLOTS; i++)
+    {
+        enc->share_slots[i].pixels = NULL;
+    }
+
+    svr_ipc_free_mem(&enc->frame_mem);
+}
+
+#ifdef _WIN32
+// COM must have been started on this thread for WIC, which svr_game_bench does.
+bool proc_cpu_create_overlay(ProcState* proc)
+{
+    bool ret = false;
+    HRESULT hr;
+
+    IWICImagingFactory* wic_factory = NULL;
+    IWICBitmap* bitmap = NULL;
+    IWICBitmapLock* lock = NULL;
+    ID2D1RenderTarget* target = NULL;
+    ID2D1SolidColorBrush* brush = NULL;
+    UINT lock_size = 0;
+    UINT lock_pitch = 0;
+    BYTE* lock_bits = NULL;
+
+    // The fill goes in the top row of cells and the border in the bottom row.
+    UINT width = svr_glyph_get_atlas_pitch(&proc->velo_atlas);
+    UINT height = proc->velo_atlas.cell_height * 2;
+
+    WICRect lock_rect = { 0, 0, (INT)width, (INT)height };
+    D2D1_RENDER_TARGET_PROPERTIES target_props = D2D1::RenderTargetProperties(D2D1_RENDER_TARGET_TYPE_SOFTWARE, D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
+
+    hr = CoCreateInstance(CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&wic_factory));
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create WIC factory (%#x)\n", hr);
+        goto rfail;
+    }
+
+    hr = wic_factory->CreateBitmap(width, height, GUID_WICPixelFormat32bppPBGRA, WICBitmapCacheOnLoad, &bitmap);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create velo atlas bitmap (%#x)\n", hr);
+        goto rfail;
+    }
+
+    hr = proc->vid_d2d1_factory->CreateWicBitmapRenderTarget(bitmap, target_props, &target);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create velo atlas render target (%#x)\n", hr);
+        goto rfail;
+    }
+
+    target->CreateSolidColorBrush(D2D1::ColorF(1.0f, 1.0f, 1.0f, 1.0f), &brush);
+
+    target->BeginDraw();
+
+    proc->velo_draw_atlas_cells(target, brush);
+
+    hr = target->EndDraw();
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not draw velo atlas (%#x)\n", hr);
+        goto rfail;
+    }
+
+    hr = bitmap->Lock(&lock_rect, WICBitmapLockRead, &lock);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not read velo atlas (%#x)\n", hr);
+        goto rfail;
+    }
+
+    lock->GetStride(&lock_pitch);
+    lock->GetDataPointer(&lock_size, &lock_bits);
+
+    proc->velo_read_atlas(lock_bits, lock_pitch);
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    svr_maybe_release(&lock);
+    svr_maybe_release(&brush);
+    svr_maybe_release(&target);
+    svr_maybe_release(&bitmap);
+    svr_maybe_release(&wic_factory);
+
+    return ret;
+}
+#else
+// Not called, since velo_start turns the velo off.
+bool proc_cpu_create_overlay(ProcState* proc)
+{
+    (void)proc;
+
+    svr_log("ERROR: The velo can only be drawn on Windows\n");
+    return false;
+}
+#endif
+
+// With mosample_synth, the sub-frames between the previous game frame and this one are made and added instead.
+// They are spread over the part of the game frame that the shutter is open for.
+void proc_cpu_accumulate(ProcState* proc, s32 idx, SvrMosampleStep* step)
+{
+    SVR_TRACE_SCOPE("mosample_process");
+
+    const u8* pixels = proc->svr_game_texture.pixels;
+    s32 pitch = proc->svr_game_texture.pitch;
+
+    if (proc->mosample_synth > 0 && proc->cpu_has_prev)
+    {
+        SvrMosampleTimer* timer = &proc->mosample_schedule.timers[idx];
+        float open_part = svr_min(step->weight * timer->open_len / step->num_steps, 1.0f);
+
+        svr_motion_add_subframes(&proc->cpu_motion, &proc->cpu_targets[idx], proc->cpu_prev_frame, proc->movie_width * 4, pixels, pitch,
+                                 open_part, proc->mosample_synth, step->weight, proc->cpu_synth_frame, proc->cpu_simd_level, proc->cpu_pool);
+        return;
+    }
+
+    svr_mosample_add(&proc->cpu_targets[idx], pixels, pitch, step->weight, proc->cpu_simd_level, proc->cpu_pool);
+}
+
+void proc_cpu_downsample(ProcState* proc, s32 idx)
+{
+    SVR_TRACE_SCOPE("mosample_downsample");
+
+    svr_mosample_downsample(&proc->cpu_targets[idx], proc->encoder_share_pixels, proc->movie_width * 4, proc->cpu_simd_level, proc->cpu_pool);
+}
+
+void proc_cpu_clear(ProcState* proc, s32 idx)
+{
+    svr_mosample_clear(&proc->cpu_targets[idx]);
+}
+
+// The slot is only read by svr_encoder, so it is written without going through the cache.
+void proc_cpu_copy(ProcState* proc)
+{
+    SvrCopyJob job = {};
+    job.num_planes = 1;
+    job.level = proc->cpu_simd_level;
+
+    SvrPlaneCopy* plane = &job.planes[0];
+    plane->src = proc->svr_game_texture.pixels;
+    plane->dest = proc->encoder_share_pixels;
+    plane->src_pitch = proc->svr_game_texture.pitch;
+    plane->dest_pitch = proc->movie_width * 4;
+    plane->row_size = proc->movie_width * 4;
+    plane->num_rows = proc->movie_height;
+
+    svr_copy_planes_parallel(&job, proc->cpu_pool);
+}
+
+// The difference is known right away, so the timer gets it before the next game frame.
+void proc_cpu_measure_diff(ProcState* proc, s32 num_steps)
+{
+    const u8* pixels = proc->svr_game_texture.pixels;
+    s32 pitch = proc->svr_game_texture.pitch;
+    s32 prev_pitch = proc->movie_width * 4;
+
+    if (proc->cpu_has_prev)
+    {
+        float diff = svr_mosample_get_difference(pixels, pitch, proc->cpu_prev_frame, prev_pitch, proc->movie_width, proc->movie_height, proc->cpu_simd_level);
+        svr_mosample_timer_give_difference(&proc->mosample_schedule.timers[0], diff, num_steps);
+    }
+
+    for (s32 y = 0; y < proc->movie_height; y++)
+    {
+        memcpy(proc->cpu_prev_frame + y * prev_pitch, pixels + y * pitch, prev_pitch);
+    }
+
+    proc->cpu_has_prev = true;
+}
+
+void proc_cpu_keep_frame(ProcState* proc)
+{
+    const u8* pixels = proc->svr_game_texture.pixels;
+    s32 pitch = proc->svr_game_texture.pitch;
+    s32 prev_pitch = proc->movie_width * 4;
+
+    for (s32 y = 0; y < proc->movie_height; y++)
+    {
+        memcpy(proc->cpu_prev_frame + y * prev_pitch, pixels + y * pitch, prev_pitch);
+    }
+
+    proc->cpu_has_prev = true;
+}
+
+// The digits are drawn right into the slot, so the sprite is not used.
+void proc_cpu_update_overlay(ProcState* proc, SvrVec4I rect)
+{
+    (void)proc;
+    (void)rect;
+}
+
+// The digits of velo_sprite_text are drawn from the atlas onto the slot, which only touches the text and clips to the frame like D2D1.
+void proc_cpu_composite_overlay(ProcState* proc, SvrVec4I rect)
+{
+    s32 text_length = (s32)strlen(proc->velo_sprite_text);
+    SvrVec4I text_rect = svr_glyph_get_text_rect(&proc->velo_atlas, text_length);
+
+    // The rect has the top left corner of the sprite, and the digits are drawn from the baseline.
+    SvrVec2I pos = SvrVec2I { rect.x - text_rect.x, rect.y - text_rect.y };
+
+    svr_glyph_draw_digits(&proc->velo_atlas, proc->velo_sprite_text, text_length, pos, proc->movie_profile.velo_font_color,
+                          proc->movie_profile.velo_font_border_color, proc->encoder_share_pixels, proc->movie_width * 4,
+                          proc->movie_width, proc->movie_height, proc->velo_simd_level);
+}
+
+// The video ring orders the memory of the slots, so there is nothing to lock.
+void proc_cpu_acquire_slot(ProcState* proc, ProcShareSlot* slot)
+{
+    (void)proc;
+    (void)slot;
+}
+
+void proc_cpu_release_slot(ProcState* proc, ProcShareSlot* slot)
+{
+    (void)proc;
+    (void)slot;
+}
+
+ProcBackendDesc proc_cpu_backend =
+{
+    .name = "CPU",
+    .init = proc_cpu_init,
+    .free = proc_cpu_free,
+    .create_targets = proc_cpu_create_targets,
+    .free_targets = proc_cpu_free_targets,
+    .create_share_slots = proc_cpu_create_share_slots,
+    .free_share_slots = proc_cpu_free_share_slots,
+    .create_overlay = proc_cpu_create_overlay,
+    .accumulate = proc_cpu_accumulate,
+    .downsample = proc_cpu_downsample,
+    .clear = proc_cpu_clear,
+    .copy = proc_cpu_copy,
+    .measure_diff = proc_cpu_measure_diff,
+    .keep_frame = proc_cpu_keep_frame,
+    .update_overlay = proc_cpu_update_overlay,
+    .composite_overlay = proc_cpu_composite_overlay,
+    .acquire_slot = proc_cpu_acquire_slot,
+    .release_slot = proc_cpu_release_slot,
+};
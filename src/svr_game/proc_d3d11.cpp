@@ -0,0 +1,678 @@
+#include "proc_priv.h"
+
+// Backend that processes the frames on the D3D11 device of the game, with compute shaders and D2D1.
+// The slots of the video ring are textures that are shared with svr_encoder.
+
+#ifdef _WIN32
+
+struct __declspec(align(16)) MosampleCb
+{
+    float mosample_weight;
+};
+
+bool proc_d3d11_create_mosample_buffer(ProcState* proc)
+{
+    bool ret = false;
+    HRESULT hr;
+
+    D3D11_BUFFER_DESC mosample_cb_desc = {};
+    mosample_cb_desc.ByteWidth = sizeof(MosampleCb);
+    mosample_cb_desc.Usage = D3D11_USAGE_DYNAMIC;
+    mosample_cb_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    mosample_cb_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    mosample_cb_desc.MiscFlags = 0;
+
+    hr = proc->vid_d3d11_device->CreateBuffer(&mosample_cb_desc, NULL, &proc->mosample_cb);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create mosample constant buffer (%#x)\n", hr);
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+bool proc_d3d11_init(ProcState* proc)
+{
+    bool ret = false;
+
+    ProcShader SHADER_LIST[] =
+    {
+        ProcShader { "mosample", (void**)&proc->mosample_cs, D3D11_COMPUTE_SHADER },
+        ProcShader { "downsample", (void**)&proc->mosample_downsample_cs, D3D11_COMPUTE_SHADER },
+        ProcShader { "motion_diff", (void**)&proc->mosample_diff_cs, D3D11_COMPUTE_SHADER },
+    };
+
+    if (!proc->vid_create_d2d1())
+    {
+        goto rfail;
+    }
+
+    if (!proc_d3d11_create_mosample_buffer(proc))
+    {
+        goto rfail;
+    }
+
+    if (!proc->vid_create_shaders_list(SHADER_LIST, SVR_ARRAY_SIZE(SHADER_LIST)))
+    {
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+void proc_d3d11_free(ProcState* proc)
+{
+    svr_maybe_release(&proc->mosample_cs);
+    svr_maybe_release(&proc->mosample_downsample_cs);
+    svr_maybe_release(&proc->mosample_diff_cs);
+    svr_maybe_release(&proc->mosample_cb);
+}
+
+bool proc_d3d11_create_target(ProcState* proc, ProcMosampleTarget* target)
+{
+    bool ret = false;
+    HRESULT hr;
+
+    D3D11_TEXTURE2D_DESC tex_desc = {};
+    tex_desc.Width = proc->movie_width;
+    tex_desc.Height = proc->movie_height;
+    tex_desc.MipLevels = 1;
+    tex_desc.ArraySize = 1;
+    tex_desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT; // Must be high precision!
+    tex_desc.SampleDesc.Count = 1;
+    tex_desc.Usage = D3D11_USAGE_DEFAULT;
+    tex_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_RENDER_TARGET;
+
+    hr = proc->vid_d3d11_device->CreateTexture2D(&tex_desc, NULL, &target->tex);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create work texture (%#x)\n", hr);
+        goto rfail;
+    }
+
+    proc->vid_d3d11_device->CreateShaderResourceView(target->tex, NULL, &target->srv);
+    proc->vid_d3d11_device->CreateRenderTargetView(target->tex, NULL, &target->rtv);
+    proc->vid_d3d11_device->CreateUnorderedAccessView(target->tex, NULL, &target->uav);
+
+    // The work texture may get reused by the runtime between renderings, so we must clear it.
+    proc->vid_clear_rtv(target->rtv, 0.0f, 0.0f, 0.0f, 1.0f);
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+bool proc_d3d11_create_diff_resources(ProcState* proc)
+{
+    bool ret = false;
+    HRESULT hr;
+
+    // One texel for every complete block.
+    D3D11_TEXTURE2D_DESC tex_desc = {};
+    tex_desc.Width = svr_max(proc->movie_width / SVR_MOSAMPLE_DIFF_BLOCK, 1);
+    tex_desc.Height = svr_max(proc->movie_height / SVR_MOSAMPLE_DIFF_BLOCK, 1);
+    tex_desc.MipLevels = 1;
+    tex_desc.ArraySize = 1;
+    tex_desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    tex_desc.SampleDesc.Count = 1;
+    tex_desc.Usage = D3D11_USAGE_DEFAULT;
+    tex_desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+
+    hr = proc->vid_d3d11_device->CreateTexture2D(&tex_desc, NULL, &proc->mosample_diff_tex);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create motion difference texture (%#x)\n", hr);
+        goto rfail;
+    }
+
+    proc->vid_d3d11_device->CreateUnorderedAccessView(proc->mosample_diff_tex, NULL, &proc->mosample_diff_tex_uav);
+
+    D3D11_BUFFER_DESC buf_desc = {};
+    buf_desc.ByteWidth = 16; // Smallest size of a buffer, only the first value is used.
+    buf_desc.Usage = D3D11_USAGE_DEFAULT;
+    buf_desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+    buf_desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+
+    hr = proc->vid_d3d11_device->CreateBuffer(&buf_desc, NULL, &proc->mosample_diff_buf);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create motion difference buffer (%#x)\n", hr);
+        goto rfail;
+    }
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uav_desc = {};
+    uav_desc.Format = DXGI_FORMAT_R32_TYPELESS;
+    uav_desc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+    uav_desc.Buffer.NumElements = 4;
+    uav_desc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+
+    proc->vid_d3d11_device->CreateUnorderedAccessView(proc->mosample_diff_buf, &uav_desc, &proc->mosample_diff_buf_uav);
+
+    buf_desc.Usage = D3D11_USAGE_STAGING;
+    buf_desc.BindFlags = 0;
+    buf_desc.MiscFlags = 0;
+    buf_desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+
+    for (s32 i = 0; i < PROC_MOSAMPLE_DIFF_READBACKS; i++)
+    {
+        hr = proc->vid_d3d11_device->CreateBuffer(&buf_desc, NULL, &proc->mosample_diff_readbacks[i]);
+
+        if (FAILED(hr))
+        {
+            svr_log("ERROR: Could not create motion difference readback buffer (%#x)\n", hr);
+            goto rfail;
+        }
+    }
+
+    proc->mosample_diff_read_idx = 0;
+    proc->mosample_diff_num_pending = 0;
+    proc->mosample_diff_has_prev = false;
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+bool proc_d3d11_create_targets(ProcState* proc)
+{
+    bool ret = false;
+
+    for (s32 i = 0; i < proc->mosample_schedule.num_shutters; i++)
+    {
+        if (!proc_d3d11_create_target(proc, &proc->mosample_targets[i]))
+        {
+            goto rfail;
+        }
+    }
+
+    if (proc->mosample_schedule.timers[0].adaptive)
+    {
+        if (!proc_d3d11_create_diff_resources(proc))
+        {
+            goto rfail;
+        }
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+// The textures are made for the size and shutters of every movie.
+void proc_d3d11_free_targets(ProcState* proc)
+{
+    for (s32 i = 0; i < SVR_MOSAMPLE_MAX_SHUTTERS; i++)
+    {
+        ProcMosampleTarget* target = &proc->mosample_targets[i];
+
+        svr_maybe_release(&target->tex);
+        svr_maybe_release(&target->rtv);
+        svr_maybe_release(&target->srv);
+        svr_maybe_release(&target->uav);
+    }
+
+    svr_maybe_release(&proc->mosample_diff_tex);
+    svr_maybe_release(&proc->mosample_diff_tex_uav);
+    svr_maybe_release(&proc->mosample_diff_buf);
+    svr_maybe_release(&proc->mosample_diff_buf_uav);
+
+    for (s32 i = 0; i < PROC_MOSAMPLE_DIFF_READBACKS; i++)
+    {
+        svr_maybe_release(&proc->mosample_diff_readbacks[i]);
+    }
+}
+
+bool proc_d3d11_create_share_texture(ProcState* proc, ProcEncoder* enc, ProcShareSlot* slot)
+{
+    bool ret = false;
+    HRESULT hr;
+
+    D3D11_TEXTURE2D_DESC tex_desc = {};
+    tex_desc.Width = proc->movie_width;
+    tex_desc.Height = proc->movie_height;
+    tex_desc.MipLevels = 1;
+    tex_desc.ArraySize = 1;
+    tex_desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    tex_desc.SampleDesc.Count = 1;
+    tex_desc.Usage = D3D11_USAGE_DEFAULT;
+    tex_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_RENDER_TARGET; // Must have these flags!
+
+    // Only the process has to open the texture on its own device.
+    if (!enc->hosted)
+    {
+        tex_desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED_NTHANDLE | D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX;
+    }
+
+    hr = proc->vid_d3d11_device->CreateTexture2D(&tex_desc, NULL, &slot->tex);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create share texture (%#x)\n", hr);
+        goto rfail;
+    }
+
+    proc->vid_d3d11_device->CreateShaderResourceView(slot->tex, NULL, &slot->srv);
+    proc->vid_d3d11_device->CreateUnorderedAccessView(slot->tex, NULL, &slot->uav);
+    proc->vid_d3d11_device->CreateRenderTargetView(slot->tex, NULL, &slot->rtv);
+
+    IDXGIResource1* dxgi_res = NULL;
+
+    if (enc->hosted)
+    {
+        ret = true;
+        goto rexit;
+    }
+    hr = slot->tex->QueryInterface(IID_PPV_ARGS(&dxgi_res));
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not query for newer D3D11 resource features (%#x)\n", hr);
+        goto rfail;
+    }
+
+    hr = dxgi_res->CreateSharedHandle(NULL, DXGI_SHARED_RESOURCE_READ, NULL, &slot->tex_h);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create share texture handle (%#x)\n", hr);
+        goto rfail;
+    }
+
+    // The key starts out as ENCODER_GAME_ID, so we own it until the first time it is sent.
+    slot->tex->QueryInterface(IID_PPV_ARGS(&slot->lock));
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    svr_maybe_release(&dxgi_res);
+    return ret;
+}
+
+bool proc_d3d11_create_d2d1_bitmap(ProcState* proc, ProcShareSlot* slot)
+{
+    bool ret = false;
+    HRESULT hr;
+
+    IDXGISurface* dxgi_surface = NULL;
+    slot->tex->QueryInterface(IID_PPV_ARGS(&dxgi_surface));
+
+    // Create passthrough reference to the used render target. This is not a real texture.
+    hr = proc->vid_d2d1_context->CreateBitmapFromDxgiSurface(dxgi_surface, NULL, &slot->d2d1_tex);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create SRV passthrough (%#x)\n", hr);
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    svr_maybe_release(&dxgi_surface);
+    return ret;
+}
+
+bool proc_d3d11_create_share_slots(ProcState* proc, ProcEncoder* enc)
+{
+    bool ret = false;
+
+    for (s32 i = 0; i < ENCODER_VIDEO_SLOTS; i++)
+    {
+        if (!proc_d3d11_create_share_texture(proc, enc, &enc->share_slots[i]))
+        {
+            goto rfail;
+        }
+
+        if (!proc_d3d11_create_d2d1_bitmap(proc, &enc->share_slots[i]))
+        {
+            goto rfail;
+        }
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+void proc_d3d11_free_share_slots(ProcState* proc, ProcEncoder* enc)
+{
+    for (s32 i = 0; i < ENCODER_VIDEO_SLOTS; i++)
+    {
+        ProcShareSlot* slot = &enc->share_slots[i];
+
+        svr_maybe_release(&slot->tex);
+        svr_maybe_release(&slot->srv);
+        svr_maybe_release(&slot->uav);
+        svr_maybe_release(&slot->rtv);
+
+        if (slot->tex_h)
+        {
+            CloseHandle(slot->tex_h);
+            slot->tex_h = NULL;
+        }
+
+        svr_maybe_release(&slot->d2d1_tex);
+        svr_maybe_release(&slot->lock);
+    }
+}
+
+// The digits are drawn on the GPU and read back, and the sprite is put on the frames with D2D1.
+bool proc_d3d11_create_overlay(ProcState* proc)
+{
+    bool ret = false;
+    HRESULT hr;
+
+    ID2D1Bitmap1* target = NULL;
+    ID2D1Bitmap1* readback = NULL;
+    D2D1_MAPPED_RECT mapped = {};
+
+    // The fill goes in the top row of cells and the border in the bottom row.
+    D2D1_SIZE_U size = D2D1::SizeU(svr_glyph_get_atlas_pitch(&proc->velo_atlas), proc->velo_atlas.cell_height * 2);
+    D2D1_PIXEL_FORMAT format = D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED);
+    D2D1_SIZE_U sprite_size = D2D1::SizeU(proc->velo_sprite_rect.z, proc->velo_sprite_rect.w);
+
+    hr = proc->vid_d2d1_context->CreateBitmap(size, NULL, 0, D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_TARGET, format), &target);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create velo atlas bitmap (%#x)\n", hr);
+        goto rfail;
+    }
+
+    hr = proc->vid_d2d1_context->CreateBitmap(size, NULL, 0, D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_CPU_READ | D2D1_BITMAP_OPTIONS_CANNOT_DRAW, format), &readback);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create velo atlas readback bitmap (%#x)\n", hr);
+        goto rfail;
+    }
+
+    proc->vid_d2d1_context->BeginDraw();
+    proc->vid_d2d1_context->SetTarget(target);
+
+    proc->velo_draw_atlas_cells(proc->vid_d2d1_context, proc->vid_d2d1_solid_brush);
+
+    hr = proc->vid_d2d1_context->EndDraw();
+    proc->vid_d2d1_context->SetTarget(NULL);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not draw velo atlas (%#x)\n", hr);
+        goto rfail;
+    }
+
+    readback->CopyFromBitmap(NULL, target, NULL);
+
+    hr = readback->Map(D2D1_MAP_OPTIONS_READ, &mapped);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not read velo atlas (%#x)\n", hr);
+        goto rfail;
+    }
+
+    proc->velo_read_atlas(mapped.bits, mapped.pitch);
+
+    readback->Unmap();
+
+    hr = proc->vid_d2d1_context->CreateBitmap(sprite_size, NULL, 0, D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_NONE, format), &proc->velo_sprite_bitmap);
+
+    if (FAILED(hr))
+    {
+        svr_log("ERROR: Could not create velo sprite bitmap (%#x)\n", hr);
+        goto rfail;
+    }
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    svr_maybe_release(&target);
+    svr_maybe_release(&readback);
+
+    return ret;
+}
+
+// TODO Probably consider to process several frames at once instead of just 1.
+void proc_d3d11_accumulate(ProcState* proc, s32 idx, SvrMosampleStep* step)
+{
+    SVR_TRACE_SCOPE("mosample_process");
+
+    float weight = step->weight;
+
+    ProcMosampleTarget* target = &proc->mosample_targets[idx];
+    ID3D11DeviceContext* ctx = proc->vid_d3d11_context;
+
+    if (weight != proc->mosample_weight_cache)
+    {
+        MosampleCb cb_data;
+        cb_data.mosample_weight = weight;
+
+        proc->mosample_weight_cache = weight;
+        proc->vid_update_constant_buffer(proc->mosample_cb, &cb_data, sizeof(MosampleCb));
+    }
+
+    ctx->CSSetShader(proc->mosample_cs, NULL, 0);
+    ctx->CSSetShaderResources(0, 1, &proc->svr_game_texture.srv);
+    ctx->CSSetConstantBuffers(0, 1, &proc->mosample_cb);
+    ctx->CSSetUnorderedAccessViews(0, 1, &target->uav, NULL);
+
+    ctx->Dispatch(proc->vid_get_num_cs_threads(proc->movie_width), proc->vid_get_num_cs_threads(proc->movie_height), 1);
+
+    ctx->Flush();
+
+    ID3D11ShaderResourceView* null_srv = NULL;
+    ID3D11UnorderedAccessView* null_uav = NULL;
+
+    ctx->CSSetShaderResources(0, 1, &null_srv);
+    ctx->CSSetUnorderedAccessViews(0, 1, &null_uav, NULL);
+}
+
+// Downsample 128 bpp texture to 32 bpp texture.
+void proc_d3d11_downsample(ProcState* proc, s32 idx)
+{
+    SVR_TRACE_SCOPE("mosample_downsample");
+
+    ProcMosampleTarget* target = &proc->mosample_targets[idx];
+    ID3D11DeviceContext* ctx = proc->vid_d3d11_context;
+
+    ctx->CSSetShader(proc->mosample_downsample_cs, NULL, 0);
+    ctx->CSSetShaderResources(0, 1, &target->srv);
+    ctx->CSSetUnorderedAccessViews(0, 1, &proc->encoder_share_tex_uav, NULL);
+
+    ctx->Dispatch(proc->vid_get_num_cs_threads(proc->movie_width), proc->vid_get_num_cs_threads(proc->movie_height), 1);
+
+    ID3D11ShaderResourceView* null_srv = NULL;
+    ID3D11UnorderedAccessView* null_uav = NULL;
+
+    ctx->CSSetShaderResources(0, 1, &null_srv);
+    ctx->CSSetUnorderedAccessViews(0, 1, &null_uav, NULL);
+}
+
+void proc_d3d11_clear(ProcState* proc, s32 idx)
+{
+    proc->vid_clear_rtv(proc->mosample_targets[idx].rtv, 0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+void proc_d3d11_copy(ProcState* proc)
+{
+    proc->vid_d3d11_context->CopyResource(proc->encoder_share_tex, proc->svr_game_texture.tex);
+}
+
+// Gives the differences that the GPU has finished to the timer, in order.
+void proc_d3d11_read_diffs(ProcState* proc)
+{
+    s32 num_blocks = (proc->movie_width / SVR_MOSAMPLE_DIFF_BLOCK) * (proc->movie_height / SVR_MOSAMPLE_DIFF_BLOCK);
+
+    while (proc->mosample_diff_num_pending > 0)
+    {
+        s32 idx = proc->mosample_diff_read_idx;
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        HRESULT hr = proc->vid_d3d11_context->Map(proc->mosample_diff_readbacks[idx], 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+
+        if (FAILED(hr))
+        {
+            break; // Not done yet.
+        }
+
+        u32 total = *(u32*)mapped.pData;
+        proc->vid_d3d11_context->Unmap(proc->mosample_diff_readbacks[idx], 0);
+
+        // The total is in quarters, for the sums of 16 pixels of 3 channels.
+        if (num_blocks > 0)
+        {
+            float diff = (float)((total * 4.0) / (num_blocks * 3.0 * SVR_MOSAMPLE_DIFF_BLOCK * SVR_MOSAMPLE_DIFF_BLOCK));
+            svr_mosample_timer_give_difference(&proc->mosample_schedule.timers[0], diff, proc->mosample_diff_steps[idx]);
+        }
+
+        proc->mosample_diff_read_idx = (idx + 1) % PROC_MOSAMPLE_DIFF_READBACKS;
+        proc->mosample_diff_num_pending--;
+    }
+}
+
+// Compares the game texture with the previous game frame for the adaptive mode.
+// The results are read back some frames later, so the game never has to wait for them.
+void proc_d3d11_measure_diff(ProcState* proc, s32 num_steps)
+{
+    ID3D11DeviceContext* ctx = proc->vid_d3d11_context;
+
+    proc_d3d11_read_diffs(proc);
+
+    UINT zero[4] = {};
+    ctx->ClearUnorderedAccessViewUint(proc->mosample_diff_buf_uav, zero);
+
+    ID3D11UnorderedAccessView* uavs[] = { proc->mosample_diff_tex_uav, proc->mosample_diff_buf_uav };
+
+    ctx->CSSetShader(proc->mosample_diff_cs, NULL, 0);
+    ctx->CSSetShaderResources(0, 1, &proc->svr_game_texture.srv);
+    ctx->CSSetUnorderedAccessViews(0, SVR_ARRAY_SIZE(uavs), uavs, NULL);
+
+    s32 num_blocks_x = proc->movie_width / SVR_MOSAMPLE_DIFF_BLOCK;
+    s32 num_blocks_y = proc->movie_height / SVR_MOSAMPLE_DIFF_BLOCK;
+
+    ctx->Dispatch(proc->vid_get_num_cs_threads(num_blocks_x), proc->vid_get_num_cs_threads(num_blocks_y), 1);
+
+    ID3D11ShaderResourceView* null_srv = NULL;
+    ID3D11UnorderedAccessView* null_uavs[] = { NULL, NULL };
+
+    ctx->CSSetShaderResources(0, 1, &null_srv);
+    ctx->CSSetUnorderedAccessViews(0, SVR_ARRAY_SIZE(null_uavs), null_uavs, NULL);
+
+    // The first game frame only fills in the block sums.
+    // If all readbacks are still in flight, this difference is not used but the block sums are still updated.
+    if (proc->mosample_diff_has_prev && proc->mosample_diff_num_pending < PROC_MOSAMPLE_DIFF_READBACKS)
+    {
+        s32 idx = (proc->mosample_diff_read_idx + proc->mosample_diff_num_pending) % PROC_MOSAMPLE_DIFF_READBACKS;
+
+        ctx->CopyResource(proc->mosample_diff_readbacks[idx], proc->mosample_diff_buf);
+        proc->mosample_diff_steps[idx] = num_steps;
+
+        proc->mosample_diff_num_pending++;
+    }
+
+    proc->mosample_diff_has_prev = true;
+}
+
+void proc_d3d11_update_overlay(ProcState* proc, SvrVec4I rect)
+{
+    D2D1_RECT_U dest_rect = D2D1::RectU(0, 0, rect.z, rect.w);
+    proc->velo_sprite_bitmap->CopyFromMemory(&dest_rect, proc->velo_sprite, proc->velo_sprite_rect.z * 4);
+}
+
+void proc_d3d11_composite_overlay(ProcState* proc, SvrVec4I rect)
+{
+    D2D1_RECT_F src_rect = D2D1::RectF(0.0f, 0.0f, rect.z, rect.w);
+    D2D1_RECT_F dest_rect = D2D1::RectF(rect.x, rect.y, rect.x + rect.z, rect.y + rect.w);
+
+    proc->vid_d2d1_context->BeginDraw();
+    proc->vid_d2d1_context->SetTarget(proc->encoder_d2d1_share_tex);
+
+    proc->vid_d2d1_context->DrawBitmap(proc->velo_sprite_bitmap, &dest_rect, 1.0f, D2D1_INTERPOLATION_MODE_NEAREST_NEIGHBOR, &src_rect);
+
+    proc->vid_d2d1_context->EndDraw();
+    proc->vid_d2d1_context->SetTarget(NULL);
+}
+
+// This does not wait, since svr_encoder gives the key back before it gives back the slot.
+// There is no key inside the game process, since the commands of both sides run in order on the same device.
+void proc_d3d11_acquire_slot(ProcState* proc, ProcShareSlot* slot)
+{
+    if (slot->lock)
+    {
+        slot->lock->AcquireSync(ENCODER_GAME_ID, INFINITE);
+    }
+}
+
+void proc_d3d11_release_slot(ProcState* proc, ProcShareSlot* slot)
+{
+    if (slot->lock)
+    {
+        slot->lock->ReleaseSync(ENCODER_PROC_ID); // Allow encoder to read.
+    }
+}
+
+ProcBackendDesc proc_d3d11_backend =
+{
+    .name = "D3D11",
+    .init = proc_d3d11_init,
+    .free = proc_d3d11_free,
+    .create_targets = proc_d3d11_create_targets,
+    .free_targets = proc_d3d11_free_targets,
+    .create_share_slots = proc_d3d11_create_share_slots,
+    .free_share_slots = proc_d3d11_free_share_slots,
+    .create_overlay = proc_d3d11_create_overlay,
+    .accumulate = proc_d3d11_accumulate,
+    .downsample = proc_d3d11_downsample,
+    .clear = proc_d3d11_clear,
+    .copy = proc_d3d11_copy,
+    .measure_diff = proc_d3d11_measure_diff,
+    .keep_frame = NULL, // Sub-frames are only made on the processor.
+    .update_overlay = proc_d3d11_update_overlay,
+    .composite_overlay = proc_d3d11_composite_overlay,
+    .acquire_slot = proc_d3d11_acquire_slot,
+    .release_slot = proc_d3d11_release_slot,
+};
+
+#endif
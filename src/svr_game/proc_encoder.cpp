@@ -4,22 +4,21 @@ bool ProcState::encoder_init()
 {
     bool ret = false;
 
-    // The shared memory handle must be created before the encoder process.
-    if (!encoder_create_shared_mem())
-    {
-        goto rfail;
-    }
+    encoder_simd_level = svr_simd_get_best_level();
 
-    // Start the encoder process early.
-    // The process will always be ready and when movie starts we will notify it that we will send data to it.
-    if (!encoder_start_process())
+    // Start the first encoder early.
+    // It will always be ready and when movie starts we will notify it that we will send data to it.
+    if (!encoder_launch(&encoders[0], true))
     {
         goto rfail;
     }
 
-    svr_console_msg_and_log("Started encoder process\n");
+    encoder_num_started = 1;
 
-    encoder_pending_samples.init(ENCODER_MAX_SAMPLES * 2);
+    for (s32 i = 0; i < PROC_MAX_ENCODERS; i++)
+    {
+        encoder_use_share_slot(&encoders[i], -1);
+    }
 
     ret = true;
     goto rexit;
@@ -30,108 +29,107 @@ rexit:
     return ret;
 }
 
-void ProcState::encoder_free_static()
+// Starts svr_encoder for an encoder, inside this process if allowed and possible.
+bool ProcState::encoder_launch(ProcEncoder* enc, bool allow_host)
 {
-    if (encoder_proc)
-    {
-        CloseHandle(encoder_proc);
-        encoder_proc = NULL;
-    }
+    bool ret = false;
 
-    if (encoder_shared_mem_h)
+    // The shared memory handle must be created before the encoder process.
+    if (!encoder_create_shared_mem(enc))
     {
-        CloseHandle(encoder_shared_mem_h);
-        encoder_shared_mem_h = NULL;
-        encoder_audio_buffer = NULL;
+        goto rfail;
     }
 
-    if (encoder_shared_ptr)
+#ifdef _WIN64
+    if (allow_host)
     {
-        UnmapViewOfFile(encoder_shared_ptr);
-        encoder_shared_ptr = NULL;
+        enc->hosted = encoder_start_host(enc);
     }
+#else
+    (void)allow_host;
+#endif
 
-    if (game_wake_event_h)
+    if (enc->hosted)
     {
-        CloseHandle(game_wake_event_h);
-        game_wake_event_h = NULL;
+        svr_console_msg_and_log("Started encoder in the game process\n");
     }
 
-    if (encoder_wake_event_h)
+    else
     {
-        CloseHandle(encoder_wake_event_h);
-        encoder_wake_event_h = NULL;
-    }
+        if (!encoder_start_process(enc))
+        {
+            goto rfail;
+        }
 
-    encoder_pending_samples.free();
-}
+        svr_console_msg_and_log("Started encoder process\n");
+    }
 
-void ProcState::encoder_free_dynamic()
-{
-    svr_maybe_release(&encoder_share_tex);
-    svr_maybe_release(&encoder_share_tex_srv);
-    svr_maybe_release(&encoder_share_tex_uav);
-    svr_maybe_release(&encoder_share_tex_rtv);
+    ret = true;
+    goto rexit;
 
-    if (encoder_share_tex_h)
-    {
-        CloseHandle(encoder_share_tex_h);
-        encoder_share_tex_h = NULL;
-    }
+rfail:
 
-    svr_maybe_release(&encoder_d2d1_share_tex);
-    svr_maybe_release(&encoder_share_tex_lock);
+rexit:
+    return ret;
 }
 
-bool ProcState::encoder_create_shared_mem()
+void ProcState::encoder_free_static()
 {
-    bool ret = false;
-
-    SECURITY_ATTRIBUTES sa = {};
-    sa.nLength = sizeof(sa);
-    sa.bInheritHandle = TRUE; // Allow encoder process to use this handle too.
+    for (s32 i = 0; i < PROC_MAX_ENCODERS; i++)
+    {
+        ProcEncoder* enc = &encoders[i];
 
-    s32 mem_size = sizeof(EncoderSharedMem);
-    mem_size += sizeof(SvrWaveSample) * ENCODER_MAX_SAMPLES; // Space for audio buffer.
+#ifdef _WIN32
+        // svr_encoder_host.dll has to be told to leave, since it does not exit with the process.
+        // It also uses our device, so it must be gone before the device is released.
+        if (enc->hosted && enc->proc.handle)
+        {
+            encoder_host_quit(enc->shared_ptr, &enc->proc);
 
-    // Create shared memory handle without a name. The handle will be passed as a parameter to the encoder process
-    // and it will open in that way, since we use inherited handles.
-    encoder_shared_mem_h = CreateFileMappingA(INVALID_HANDLE_VALUE, &sa, PAGE_READWRITE, 0, mem_size, NULL);
+            enc->hosted = false;
+        }
+#endif
 
-    if (encoder_shared_mem_h == NULL)
-    {
-        svr_log("ERROR: Could not create encoder shared memory (%lu)\n", GetLastError());
-        goto rfail;
-    }
+        svr_ipc_close_process(&enc->proc);
 
-    encoder_shared_ptr = (EncoderSharedMem*)MapViewOfFile(encoder_shared_mem_h, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+        if (enc->shared_ptr)
+        {
+            encoder_shared_close_events(enc->shared_ptr);
+            enc->shared_ptr = NULL;
+        }
 
-    // This can't fail in this case, but check anyway I guess.
-    if (encoder_shared_ptr == NULL)
-    {
-        svr_log("ERROR: Could not view encoder shared memory (%lu)\n", GetLastError());
-        goto rfail;
+        svr_ipc_free_mem(&enc->shared_mem);
     }
 
-    // These must be auto reset events so there are no race conditions!
-    game_wake_event_h = CreateEventA(&sa, FALSE, FALSE, NULL);
-    encoder_wake_event_h = CreateEventA(&sa, FALSE, FALSE, NULL);
+    encoder_num_started = 0;
+}
 
-    memset(encoder_shared_ptr, 0, mem_size); // Put to known state.
+void ProcState::encoder_free_dynamic()
+{
+    for (s32 i = 0; i < PROC_MAX_ENCODERS; i++)
+    {
+        ProcEncoder* enc = &encoders[i];
 
-    // Fill some initial data. The encoder process will need these right away.
-    // Also build the messy offsets because we are mixing 32-bit and 64-bit.
+        encoder_use_share_slot(enc, -1);
+        backend->free_share_slots(this, enc);
+    }
 
-    encoder_shared_ptr->game_pid = GetCurrentProcessId();
-    encoder_shared_ptr->game_wake_event_h = (u32)game_wake_event_h;
-    encoder_shared_ptr->encoder_wake_event_h = (u32)encoder_wake_event_h;
+    encoder_num_movies = 0;
+}
 
-    s32 offset = 0;
+bool ProcState::encoder_create_shared_mem(ProcEncoder* enc)
+{
+    bool ret = false;
 
-    offset += sizeof(EncoderSharedMem);
-    encoder_shared_ptr->audio_buffer_offset = offset;
+    // The memory is opened by the encoder process from the id that is passed as a parameter.
+    // The events and rings are set up here too, since the encoder process needs them right away.
+    if (!encoder_shared_create(&enc->shared_mem, sizeof(SvrWaveS16)))
+    {
+        svr_log("ERROR: Could not create encoder shared memory (%u)\n", svr_get_last_error());
+        goto rfail;
+    }
 
-    encoder_audio_buffer = (u8*)encoder_shared_ptr + encoder_shared_ptr->audio_buffer_offset;
+    enc->shared_ptr = (EncoderSharedMem*)enc->shared_mem.ptr;
 
     ret = true;
     goto rexit;
@@ -142,17 +140,20 @@ rexit:
     return ret;
 }
 
-bool ProcState::encoder_start_process()
+#ifdef _WIN32
+bool ProcState::encoder_start_process(ProcEncoder* enc)
 {
     bool ret = false;
 
     char full_args[1024];
     full_args[0] = 0;
 
-    // Put the handle to the shared memory as a parameter, we can pass the rest in there.
-    // All handles are 32-bit, so this is safe for the 64-bit svr_encoder too.
+    char mem_id[128];
+    svr_ipc_get_mem_id(&enc->shared_mem, mem_id, sizeof(mem_id));
+
+    // Put the id of the shared memory as a parameter, we can pass the rest in there.
     // The executable path must be quoted!
-    SVR_SNPRINTF(full_args, "\"%s\\svr_encoder.exe\" %u", svr_resource_path, (u32)encoder_shared_mem_h);
+    SVR_SNPRINTF(full_args, "\"%s\\svr_encoder.exe\" %s", svr_resource_path, mem_id);
 
     STARTUPINFOA start_info = {};
     start_info.cb = sizeof(STARTUPINFOA);
@@ -179,7 +180,8 @@ bool ProcState::encoder_start_process()
     // When this breakpoint is hit, attach to the svr_encoder process and then continue this process.
     ResumeThread(proc_info.hThread);
 
-    encoder_proc = proc_info.hProcess;
+    enc->proc.handle = proc_info.hProcess;
+    enc->proc.pid = proc_info.dwProcessId;
     CloseHandle(proc_info.hThread);
 
     ret = true;
@@ -190,29 +192,195 @@ rfail:
 rexit:
     return ret;
 }
+#else
+// The frame threads of the CPU backend are already running, so the child only makes calls that are safe after fork until it is svr_encoder.
+// The process has nothing to open, since svr_ipc only needs the id to see if it is still there.
+bool ProcState::encoder_start_process(ProcEncoder* enc)
+{
+    bool ret = false;
 
-bool ProcState::encoder_start()
+    char exe_path[MAX_PATH];
+    SVR_SNPRINTF(exe_path, "%s/svr_encoder", svr_resource_path);
+
+    char mem_id[128];
+    svr_ipc_get_mem_id(&enc->shared_mem, mem_id, sizeof(mem_id));
+
+    char* args[] = { exe_path, mem_id, NULL };
+    pid_t pid = -1;
+
+    // Checked here so a missing svr_encoder is an error now, and not an encoder that exits right away.
+    if (access(exe_path, X_OK) != 0)
+    {
+        svr_log("ERROR: Could not create encoder process (%u)\n", svr_get_last_error());
+        goto rfail;
+    }
+
+    pid = fork();
+
+    if (pid == -1)
+    {
+        svr_log("ERROR: Could not create encoder process (%u)\n", svr_get_last_error());
+        goto rfail;
+    }
+
+    // Working directory for the encoder process should be in the SVR directory.
+    if (pid == 0)
+    {
+        if (chdir(svr_resource_path) == 0)
+        {
+            execv(exe_path, args);
+        }
+
+        _exit(127);
+    }
+
+    enc->proc.handle = NULL;
+    enc->proc.pid = (u32)pid;
+
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+#endif
+
+#ifdef _WIN32
+// Runs svr_encoder on a thread in this process instead of in its own process. Returns false if the process should be used instead.
+bool ProcState::encoder_start_host(ProcEncoder* enc)
 {
     bool ret = false;
+    HRESULT hr;
+
+    HMODULE host_module = NULL;
+    ID3D11Multithread* multithread = NULL;
+    EncoderHostStartFn start_fn = NULL;
+    void* thread_h = NULL;
+
+    // The hosted encoder takes the textures of the device directly, so there must be one.
+    if (vid_d3d11_device == NULL)
+    {
+        svr_log("Using encoder process because there is no D3D11 device\n");
+        goto rfail;
+    }
+
+    // Both threads use the immediate context, which cannot be done if the device was created for a single thread.
+    if (vid_d3d11_device->GetCreationFlags() & D3D11_CREATE_DEVICE_SINGLETHREADED)
+    {
+        svr_log("Using encoder process because the D3D11 device is single threaded\n");
+        goto rfail;
+    }
+
+    hr = vid_d3d11_device->QueryInterface(IID_PPV_ARGS(&multithread));
+
+    if (FAILED(hr))
+    {
+        svr_log("Using encoder process because the D3D11 device cannot be protected for threads (%#x)\n", hr);
+        goto rfail;
+    }
+
+    // Look for the FFmpeg libraries next to the host and not in the game directory.
+    host_module = LoadLibraryExA(svr_va("%s\\svr_encoder_host.dll", svr_resource_path), NULL, LOAD_WITH_ALTERED_SEARCH_PATH);
 
-    if (!encoder_create_share_textures())
+    if (host_module == NULL)
     {
+        svr_log("Using encoder process because svr_encoder_host.dll could not be loaded (%lu)\n", GetLastError());
         goto rfail;
     }
 
-    if (!encoder_create_d2d1_bitmap())
+    start_fn = (EncoderHostStartFn)GetProcAddress(host_module, ENCODER_HOST_START_NAME);
+
+    if (start_fn == NULL)
     {
+        svr_log("Using encoder process because svr_encoder_host.dll is not valid\n");
         goto rfail;
     }
 
-    if (!encoder_set_shared_mem_params())
+    multithread->SetMultithreadProtected(TRUE);
+
+    SVR_COPY_STRING(svr_resource_path, enc->host_params.resource_path);
+    svr_ipc_get_mem_id(&enc->shared_mem, enc->host_params.shared_mem_id, sizeof(enc->host_params.shared_mem_id));
+    enc->host_params.d3d11_device = vid_d3d11_device;
+
+    thread_h = start_fn(&enc->host_params);
+
+    if (thread_h == NULL)
     {
         goto rfail;
     }
 
-    encoder_share_tex_lock->AcquireSync(ENCODER_GAME_ID, INFINITE); // Set initial owner now.
+    // Waiting for the thread works the same as waiting for the process.
+    enc->proc.handle = thread_h;
+    enc->proc.pid = svr_ipc_get_current_pid();
+
+    // The library is never unloaded, since it is used until the game exits anyway.
+
+    ret = true;
+    goto rexit;
+
+rfail:
+    if (host_module)
+    {
+        FreeLibrary(host_module);
+    }
+
+rexit:
+    svr_maybe_release(&multithread);
+    return ret;
+}
+#endif
+
+bool ProcState::encoder_start()
+{
+    bool ret = false;
+
+    encoder_num_movies = 1;
+
+    if (movie_profile.mosample_enabled)
+    {
+        encoder_num_movies = mosample_schedule.num_shutters;
+    }
+
+    for (s32 i = 0; i < encoder_num_movies; i++)
+    {
+        ProcEncoder* enc = &encoders[i];
+
+        // Only one svr_encoder can run inside this process, so the others are always processes.
+        if (i >= encoder_num_started)
+        {
+            if (!encoder_launch(enc, false))
+            {
+                goto rfail;
+            }
+
+            encoder_num_started++;
+        }
+
+        encoder_setup_movie_path(i);
+
+        for (s32 j = 0; j < PROC_IPC_WAIT_COUNT; j++)
+        {
+            svr_prof_histogram_reset(&enc->ipc_waits[j]);
+        }
+
+        if (!backend->create_share_slots(this, enc))
+        {
+            goto rfail;
+        }
+
+        if (!encoder_set_shared_mem_params(enc))
+        {
+            goto rfail;
+        }
 
-    encoder_pending_samples.clear();
+        // Take the first slot to draw to now.
+        if (!encoder_begin_share_slot(enc))
+        {
+            goto rfail;
+        }
+    }
 
     ret = true;
     goto rexit;
@@ -223,13 +391,39 @@ rexit:
     return ret;
 }
 
-bool ProcState::encoder_set_shared_mem_params()
+// The first movie goes to the path that was asked for, and the movies of the extra shutters
+// go next to it with the number of the shutter added to the name.
+void ProcState::encoder_setup_movie_path(s32 idx)
+{
+    ProcEncoder* enc = &encoders[idx];
+
+    if (idx == 0)
+    {
+        SVR_COPY_STRING(movie_path, enc->movie_path);
+        return;
+    }
+
+    const char* name = strrchr(movie_path, SVR_PATH_SEP[0]);
+    const char* ext = strrchr(movie_path, '.');
+
+    if (ext == NULL || (name && ext < name))
+    {
+        ext = movie_path + strlen(movie_path);
+    }
+
+    SVR_SNPRINTF(enc->movie_path, "%.*s_%d%s", (s32)(ext - movie_path), movie_path, idx + 1, ext);
+
+    SvrMosampleTimer* timer = &mosample_schedule.timers[idx];
+    svr_log("Movie of shutter %d (mult %d, exposure %0.2f) goes to %s\n", idx + 1, timer->mult, timer->open_len / timer->mult, enc->movie_path);
+}
+
+bool ProcState::encoder_set_shared_mem_params(ProcEncoder* enc)
 {
     bool ret = false;
 
     // Set movie parameters to svr_encoder.
 
-    EncoderSharedMovieParams* params = &encoder_shared_ptr->movie_params;
+    EncoderSharedMovieParams* params = &enc->shared_ptr->movie_params;
 
     params->video_fps = movie_profile.video_fps;
     params->video_width = movie_width;
@@ -239,34 +433,69 @@ bool ProcState::encoder_set_shared_mem_params()
     params->audio_bits = svr_audio_params.audio_bits;
     params->x264_crf = movie_profile.video_x264_crf;
     params->x264_intra = movie_profile.video_x264_intra;
+    params->x264_chunk_length = movie_profile.video_x264_chunk_length;
     params->use_audio = movie_profile.audio_enabled;
+    params->use_trace = movie_profile.trace_enabled;
+    params->memory_budget_mb = movie_profile.encoder_memory_budget;
+    params->encode_workers = movie_profile.encoder_workers;
+    params->stats_idx = stats_block ? (s32)(enc - encoders) : -1;
 
-    SVR_COPY_STRING(movie_path, params->dest_file);
+    SVR_COPY_STRING(enc->movie_path, params->dest_file);
     SVR_COPY_STRING(movie_profile.video_encoder, params->video_encoder);
     SVR_COPY_STRING(movie_profile.video_x264_preset, params->x264_preset);
     SVR_COPY_STRING(movie_profile.video_dnxhr_profile, params->dnxhr_profile);
     SVR_COPY_STRING(movie_profile.audio_encoder, params->audio_encoder);
 
-    // Must duplicate the handle for the encoder to be able to open it.
-    // Doesn't matter if you specify to inherit handles when creating the DXGI handle.
+    enc->shared_ptr->frame_mem_id[0] = 0;
 
-    HANDLE new_handle;
-    BOOL res = DuplicateHandle(GetCurrentProcess(), encoder_share_tex_h, encoder_proc, &new_handle, 0, TRUE, DUPLICATE_SAME_ACCESS);
+    // Frames from the processor are in memory that must be given to the encoder process, since it was started before the memory was made.
+    if (enc->frame_mem.ptr)
+    {
+        if (!svr_ipc_give_mem(&enc->frame_mem, &enc->proc, enc->shared_ptr->frame_mem_id, sizeof(enc->shared_ptr->frame_mem_id)))
+        {
+            svr_log("ERROR: Could not give frame memory to the encoder (%u)\n", svr_get_last_error());
+            goto rfail;
+        }
+    }
 
-    if (res == 0)
+#ifdef _WIN32
+    // Inside the game process the textures are given directly, since svr_encoder uses the same device.
+    else if (enc->hosted)
     {
-        svr_log("ERROR: Could not duplicate share texture handle (%lu)\n", GetLastError());
-        goto rfail;
+        for (s32 i = 0; i < ENCODER_VIDEO_SLOTS; i++)
+        {
+            enc->host_params.game_texs[i] = enc->share_slots[i].tex;
+        }
     }
 
-    encoder_shared_ptr->waiting_audio_samples = 0;
-    encoder_shared_ptr->game_texture_h = (u32)new_handle; // Transfer to encoder process, so don't close here.
+    else
+    {
+        // Must duplicate the handles for the encoder to be able to open them.
+        // Doesn't matter if you specify to inherit handles when creating the DXGI handle.
+        for (s32 i = 0; i < ENCODER_VIDEO_SLOTS; i++)
+        {
+            HANDLE new_handle;
+            BOOL res = DuplicateHandle(GetCurrentProcess(), enc->share_slots[i].tex_h, (HANDLE)enc->proc.handle, &new_handle, 0, TRUE, DUPLICATE_SAME_ACCESS);
 
-    encoder_shared_ptr->error = 0;
-    encoder_shared_ptr->error_message[0] = 0;
+            if (res == 0)
+            {
+                svr_log("ERROR: Could not duplicate share texture handle (%lu)\n", GetLastError());
+                goto rfail;
+            }
+
+            enc->shared_ptr->game_texture_hs[i] = (u32)new_handle; // Transfer to encoder process, so don't close here.
+        }
+    }
+#endif
+
+    // Everything from the last movie was read before it stopped.
+    svr_slot_ring_restart(&enc->shared_ptr->video_ring);
+
+    enc->shared_ptr->error = 0;
+    enc->shared_ptr->error_message[0] = 0;
 
     // Now wake svr_encoder up and let it wait for new data.
-    if (!encoder_send_event(ENCODER_EVENT_START))
+    if (!encoder_send_event(enc, ENCODER_EVENT_START))
     {
         goto rfail;
     }
@@ -280,52 +509,73 @@ rexit:
     return ret;
 }
 
-bool ProcState::encoder_create_share_textures()
+// Sets the slot of an encoder that is drawn to. Use -1 to clear.
+void ProcState::encoder_use_share_slot(ProcEncoder* enc, s32 idx)
 {
-    bool ret = false;
-    HRESULT hr;
+    enc->share_slot_idx = idx;
 
-    D3D11_TEXTURE2D_DESC tex_desc = {};
-    tex_desc.Width = movie_width;
-    tex_desc.Height = movie_height;
-    tex_desc.MipLevels = 1;
-    tex_desc.ArraySize = 1;
-    tex_desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
-    tex_desc.SampleDesc.Count = 1;
-    tex_desc.Usage = D3D11_USAGE_DEFAULT;
-    tex_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_RENDER_TARGET; // Must have these flags!
-    tex_desc.MiscFlags = D3D11_RESOURCE_MISC_SHARED_NTHANDLE | D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX;
+    if (enc == encoder_cur)
+    {
+        encoder_select((s32)(enc - encoders));
+    }
+}
 
-    hr = vid_d3d11_device->CreateTexture2D(&tex_desc, NULL, &encoder_share_tex);
+// Makes the current slot of an encoder the one that is drawn to.
+// Returns false if there is nothing to draw to, because the encoder has gone away.
+bool ProcState::encoder_select(s32 idx)
+{
+    ProcEncoder* enc = &encoders[idx];
+    encoder_cur = enc;
 
-    if (FAILED(hr))
+    if (enc->share_slot_idx < 0)
     {
-        svr_log("ERROR: Could not create share texture (%#x)\n", hr);
-        goto rfail;
+#ifdef _WIN32
+        encoder_share_tex = NULL;
+        encoder_share_tex_uav = NULL;
+        encoder_share_tex_rtv = NULL;
+        encoder_share_tex_srv = NULL;
+        encoder_d2d1_share_tex = NULL;
+        encoder_share_tex_lock = NULL;
+#endif
+        encoder_share_pixels = NULL;
+        return false;
     }
 
-    vid_d3d11_device->CreateShaderResourceView(encoder_share_tex, NULL, &encoder_share_tex_srv);
-    vid_d3d11_device->CreateUnorderedAccessView(encoder_share_tex, NULL, &encoder_share_tex_uav);
-    vid_d3d11_device->CreateRenderTargetView(encoder_share_tex, NULL, &encoder_share_tex_rtv);
+    ProcShareSlot* slot = &enc->share_slots[enc->share_slot_idx];
 
-    IDXGIResource1* dxgi_res = NULL;
-    hr = encoder_share_tex->QueryInterface(IID_PPV_ARGS(&dxgi_res));
+#ifdef _WIN32
+    encoder_share_tex = slot->tex;
+    encoder_share_tex_uav = slot->uav;
+    encoder_share_tex_rtv = slot->rtv;
+    encoder_share_tex_srv = slot->srv;
+    encoder_d2d1_share_tex = slot->d2d1_tex;
+    encoder_share_tex_lock = slot->lock;
+#endif
+    encoder_share_pixels = slot->pixels;
 
-    if (FAILED(hr))
-    {
-        svr_log("ERROR: Could not query for newer D3D11 resource features (%#x)\n", hr);
-        goto rfail;
-    }
+    return true;
+}
+
+// Waits until svr_encoder has given back a slot in the video ring, and makes it the one that is drawn to.
+// This is the only place where the game waits for video encoding, which only happens when every slot is full.
+bool ProcState::encoder_begin_share_slot(ProcEncoder* enc)
+{
+    bool ret = false;
+    s32 idx;
 
-    hr = dxgi_res->CreateSharedHandle(NULL, DXGI_SHARED_RESOURCE_READ, NULL, &encoder_share_tex_h);
+    encoder_use_share_slot(enc, -1);
 
-    if (FAILED(hr))
+    while (!svr_slot_ring_begin_write(&enc->shared_ptr->video_ring, &idx))
     {
-        svr_log("ERROR: Could not create share texture handle (%#x)\n", hr);
-        goto rfail;
+        if (!encoder_wait(enc, &enc->shared_ptr->video_slot_event, PROC_IPC_WAIT_VIDEO_SLOT))
+        {
+            goto rfail;
+        }
     }
 
-    encoder_share_tex->QueryInterface(IID_PPV_ARGS(&encoder_share_tex_lock));
+    encoder_use_share_slot(enc, idx);
+
+    backend->acquire_slot(this, &enc->share_slots[idx]);
 
     ret = true;
     goto rexit;
@@ -333,18 +583,25 @@ bool ProcState::encoder_create_share_textures()
 rfail:
 
 rexit:
-    svr_maybe_release(&dxgi_res);
     return ret;
 }
 
 void ProcState::encoder_end()
 {
-    if (movie_profile.audio_enabled)
+    for (s32 i = 0; i < encoder_num_movies; i++)
     {
-        encoder_flush_audio();
+        ProcEncoder* enc = &encoders[i];
+
+        // The slot that we have now was never drawn to, so it is not sent.
+        // svr_encoder reads all of the other slots and all of the audio before it stops.
+        svr_slot_ring_stop(&enc->shared_ptr->video_ring);
+
+        encoder_send_event(enc, ENCODER_EVENT_STOP);
+
+        encoder_log_ipc_waits(enc);
     }
 
-    encoder_send_event(ENCODER_EVENT_STOP);
+    encoder_free_dynamic();
 }
 
 // Call this to resume svr_encoder from a known state.
@@ -353,11 +610,9 @@ void ProcState::encoder_end()
 //
 // Check the enum for what events can fail. If an event can fail you need to handle it properly by
 // checking the return value of this function.
-bool ProcState::encoder_send_event(EncoderSharedEvent event)
+bool ProcState::encoder_send_event(ProcEncoder* enc, EncoderSharedEvent event)
 {
-    encoder_shared_ptr->event_type = event;
-
-    SetEvent(encoder_wake_event_h); // Let svr_encoder wake up and handle the event.
+    encoder_shared_post_event(enc->shared_ptr, event); // Let svr_encoder wake up and handle the event.
 
     // Block the calling thread until the event has been processed by svr_encoder.
     // We need to do this to ensure the audio and video data access doesn't suffer from any race condition.
@@ -365,157 +620,183 @@ bool ProcState::encoder_send_event(EncoderSharedEvent event)
     // When this returns, svr_encoder will be paused and in a known state waiting to be woken up again.
     // This call also makes synchronization easier in this process.
 
-    HANDLE handles[] =
-    {
-        encoder_proc,
-        game_wake_event_h,
-    };
-
-    DWORD waited = WaitForMultipleObjects(SVR_ARRAY_SIZE(handles), handles, FALSE, INFINITE);
-    HANDLE waited_h = handles[waited - WAIT_OBJECT_0];
+    ProcIpcWait wait = (event == ENCODER_EVENT_START) ? PROC_IPC_WAIT_START : PROC_IPC_WAIT_STOP;
 
-    // Encoder exited or crashed or something.
-    if (waited_h == encoder_proc)
+    if (!encoder_wait(enc, &enc->shared_ptr->game_wake_event, wait))
     {
-        svr_console_msg_and_log("Encoder exited or crashed\n");
         return false;
     }
 
-    if (waited_h == game_wake_event_h)
+    if (!encoder_check_error(enc))
     {
-        if (encoder_shared_ptr->error)
-        {
-            // Any error in svr_encoder is written to its log.
-            // We also want to log the error in the console and in our log.
-            svr_console_msg_and_log(encoder_shared_ptr->error_message);
-            svr_console_msg_and_log("See ENCODER_LOG.txt for more information\n");
-            return false;
-        }
+        return false;
     }
 
     return true;
 }
 
-bool ProcState::encoder_send_shared_tex()
+// Waits until svr_encoder sets the event. Returns false if svr_encoder is gone.
+bool ProcState::encoder_wait(ProcEncoder* enc, SvrIpcEvent* event, ProcIpcWait wait)
 {
-    bool ret = false;
-
-    encoder_share_tex_lock->ReleaseSync(ENCODER_PROC_ID); // Allow encoder to read.
-
-    if (!encoder_send_event(ENCODER_EVENT_NEW_VIDEO))
+    const char* TRACE_NAMES[] =
     {
-        goto rfail;
-    }
-
-    ret = true;
-    goto rexit;
+        "encoder_wait_start",
+        "encoder_wait_stop",
+        "encoder_wait_video_slot",
+        "encoder_wait_audio_space",
+        "encoder_wait_frame",
+    };
 
-rfail:
+    SvrTraceScope trace_scope(TRACE_NAMES[wait]);
 
-rexit:
-    encoder_share_tex_lock->AcquireSync(ENCODER_GAME_ID, INFINITE); // Give back to us now.
-    return ret;
-}
+    s64 start = svr_prof_get_real_time();
 
-bool ProcState::encoder_send_audio_samples(SvrWaveSample* samples, s32 num_samples)
-{
-    // During motion blur capture, we will be getting really low number of samples in here (like 12).
-    // This is way too little to wake up the encoder for and block the game.
-    // Queue up a larger amount and send that instead.
-    encoder_pending_samples.push_range(samples, num_samples);
+    SvrIpcWaitResult res = svr_ipc_wait(event, &enc->proc);
 
-    bool ret = false;
+    svr_prof_histogram_add(&enc->ipc_waits[wait], svr_prof_get_real_time() - start);
 
-    if (!encoder_submit_pending_samples())
+    // Encoder exited or crashed or something.
+    if (res == SVR_IPC_WAIT_EXITED)
     {
-        goto rfail;
+        svr_console_msg_and_log("Encoder exited or crashed\n");
+        return false;
     }
 
-    ret = true;
-    goto rexit;
-
-rfail:
-
-rexit:
-    return ret;
+    return true;
 }
 
-// Send any remaining samples just before the rendering stops.
-void ProcState::encoder_flush_audio()
+// Shows how long the game had to wait for svr_encoder during the movie.
+// The slow waits are what matter here, so the high percentiles are shown and not just the average.
+void ProcState::encoder_log_ipc_waits(ProcEncoder* enc)
 {
-    while (encoder_pending_samples.size() > 0)
+    const char* WAIT_NAMES[] =
+    {
+        "start event",
+        "stop event",
+        "video slot",
+        "audio space",
+        "frame send",
+    };
+
+    for (s32 i = 0; i < PROC_IPC_WAIT_COUNT; i++)
     {
-        s32 samples_to_write = svr_min(encoder_pending_samples.size(), ENCODER_MAX_SAMPLES);
+        SvrProfHistogram* hist = &enc->ipc_waits[i];
 
-        if (!encoder_send_audio_from_pending(samples_to_write))
+        if (hist->runs == 0)
         {
-            break;
+            continue;
         }
+
+        svr_log("Encoder %s (%s) took p50 %lld us, p99 %lld us, max %lld us over %lld times\n",
+                WAIT_NAMES[i], enc->hosted ? "in game process" : "in own process",
+                svr_prof_histogram_get_percentile(hist, 50), svr_prof_histogram_get_percentile(hist, 99), hist->max, hist->runs);
     }
 }
 
-// Send full batches of audio.
-bool ProcState::encoder_submit_pending_samples()
+// Shows an error that svr_encoder has set. Returns false if there was one.
+bool ProcState::encoder_check_error(ProcEncoder* enc)
 {
-    bool ret = false;
-
-    while (encoder_pending_samples.size() >= ENCODER_MAX_SAMPLES)
+    if (enc->shared_ptr->error == 0)
     {
-        s32 samples_to_write = ENCODER_MAX_SAMPLES;
-
-        if (!encoder_send_audio_from_pending(samples_to_write))
-        {
-            goto rfail;
-        }
+        return true;
     }
 
-    ret = true;
-    goto rexit;
+    // Any error in svr_encoder is written to its log.
+    // We also want to log the error in the console and in our log.
+    svr_console_msg_and_log(enc->shared_ptr->error_message);
+    svr_console_msg_and_log("See ENCODER_LOG.txt for more information\n");
 
-rfail:
+    // An error from a video frame can be seen a lot later than it happened, so it is cleared here to only be shown once.
+    enc->shared_ptr->error = 0;
 
-rexit:
-    return ret;
+    return false;
 }
 
-// Shared code between encoder_submit_pending_samples and encoder_flush_audio.
-bool ProcState::encoder_send_audio_from_pending(s32 num_samples)
+// Gives the slot that has been drawn to svr_encoder and takes the next one.
+// This does not wait for svr_encoder to read the slot, so the game can continue with the next frame while the encoder works.
+bool ProcState::encoder_send_shared_tex(ProcEncoder* enc)
 {
+    SVR_TRACE_SCOPE("encoder_send_shared_tex");
+
     bool ret = false;
 
-    assert(encoder_pending_samples.size() >= num_samples);
+    s64 start = svr_prof_get_real_time();
 
-    encoder_pending_samples.pull_range((SvrWaveSample*)encoder_audio_buffer, num_samples);
-    encoder_shared_ptr->waiting_audio_samples = num_samples;
+    ProcShareSlot* slot = &enc->share_slots[enc->share_slot_idx];
 
-    if (!encoder_send_event(ENCODER_EVENT_NEW_AUDIO))
+    backend->release_slot(this, slot); // Allow encoder to read.
+
+    svr_slot_ring_end_write(&enc->shared_ptr->video_ring);
+
+    svr_ipc_set_event(&enc->shared_ptr->encoder_wake_event); // Let svr_encoder wake up and read the slot.
+
+    if (!encoder_begin_share_slot(enc))
     {
         goto rfail;
     }
 
+    // Errors for earlier frames are only seen now.
+    if (!encoder_check_error(enc))
+    {
+        goto rfail;
+    }
+
+    stats_sent_shared_tex(enc, start);
+
     ret = true;
     goto rexit;
 
 rfail:
 
 rexit:
+    svr_prof_histogram_add(&enc->ipc_waits[PROC_IPC_WAIT_FRAME], svr_prof_get_real_time() - start);
     return ret;
 }
 
-bool ProcState::encoder_create_d2d1_bitmap()
+// Writes the samples to the audio ring. This only waits for svr_encoder if the ring is full.
+// The samples are converted to 16 bit as they are written.
+bool ProcState::encoder_send_audio_samples(ProcEncoder* enc, const void* samples, SvrWaveFormat format, s32 num_samples)
 {
+    SVR_TRACE_SCOPE("encoder_send_audio_samples");
+
     bool ret = false;
-    HRESULT hr;
 
-    IDXGISurface* dxgi_surface = NULL;
-    encoder_share_tex->QueryInterface(IID_PPV_ARGS(&dxgi_surface));
+    SvrSharedRing* ring = &enc->shared_ptr->audio_ring;
+    s32 num_before = svr_shared_ring_get_num_items(ring);
+    s32 sample_size = svr_wave_get_sample_size(format);
+    const u8* src = (const u8*)samples;
 
-    // Create passthrough reference to the used render target. This is not a real texture.
-    hr = vid_d2d1_context->CreateBitmapFromDxgiSurface(dxgi_surface, NULL, &encoder_d2d1_share_tex);
+    while (num_samples > 0)
+    {
+        s32 num_written = svr_wave_write_ring(ring, src, format, num_samples, encoder_simd_level);
 
-    if (FAILED(hr))
+        src += sample_size * num_written;
+        num_samples -= num_written;
+
+        if (num_samples > 0)
+        {
+            if (!encoder_wait_for_audio_space(enc))
+            {
+                goto rfail;
+            }
+
+            num_before = 0; // Woken up already.
+        }
+    }
+
+    SVR_TRACE_COUNTER("audio_ring", svr_shared_ring_get_num_items(ring));
+
+    // During motion blur capture, we will be getting really low number of samples in here (like 12).
+    // This is way too little to wake up the encoder for, so only do that once enough samples are waiting.
+    // The encoder also reads the samples when it is woken up for video.
+    if (num_before < ENCODER_MAX_SAMPLES && svr_shared_ring_get_num_items(ring) >= ENCODER_MAX_SAMPLES)
+    {
+        svr_ipc_set_event(&enc->shared_ptr->encoder_wake_event);
+    }
+
+    // Errors for earlier samples are only seen now.
+    if (!encoder_check_error(enc))
     {
-        svr_log("ERROR: Could not create SRV passthrough (%#x)\n", hr);
         goto rfail;
     }
 
@@ -525,6 +806,13 @@ bool ProcState::encoder_create_d2d1_bitmap()
 rfail:
 
 rexit:
-    svr_maybe_release(&dxgi_surface);
     return ret;
 }
+
+// Wakes svr_encoder and waits until it has read from the audio ring.
+bool ProcState::encoder_wait_for_audio_space(ProcEncoder* enc)
+{
+    svr_ipc_set_event(&enc->shared_ptr->encoder_wake_event);
+
+    return encoder_wait(enc, &enc->shared_ptr->audio_space_event, PROC_IPC_WAIT_AUDIO_SPACE);
+}
@@ -1,155 +1,80 @@
 #include "proc_priv.h"
 
-struct __declspec(align(16)) MosampleCb
-{
-    float mosample_weight;
-};
-
-bool ProcState::mosample_init()
+// The targets are made for the size and shutters of every movie.
+void ProcState::mosample_free_dynamic()
 {
-    bool ret = false;
-
-    if (!mosample_create_buffer())
-    {
-        goto rfail;
-    }
-
-    if (!mosample_create_shaders())
-    {
-        goto rfail;
-    }
-
-    ret = true;
-    goto rexit;
-
-rfail:
-
-rexit:
-    return ret;
+    backend->free_targets(this);
 }
 
-bool ProcState::mosample_create_buffer()
+bool ProcState::mosample_start()
 {
     bool ret = false;
-    HRESULT hr;
 
-    D3D11_BUFFER_DESC mosample_cb_desc = {};
-    mosample_cb_desc.ByteWidth = sizeof(MosampleCb);
-    mosample_cb_desc.Usage = D3D11_USAGE_DYNAMIC;
-    mosample_cb_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    mosample_cb_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    mosample_cb_desc.MiscFlags = 0;
+    SvrMosampleShutter shutters[SVR_MOSAMPLE_MAX_SHUTTERS];
+    s32 num_shutters = 1 + movie_profile.mosample_num_extra_shutters;
+    s32 max_mult = 0;
 
-    hr = vid_d3d11_device->CreateBuffer(&mosample_cb_desc, NULL, &mosample_cb);
+    mosample_synth = 0;
 
-    if (FAILED(hr))
+    if (!movie_profile.mosample_enabled)
     {
-        svr_log("ERROR: Could not create mosample constant buffer (%#x)\n", hr);
-        goto rfail;
+        ret = true;
+        goto rexit;
     }
 
-    ret = true;
-    goto rexit;
-
-rfail:
-
-rexit:
-    return ret;
-}
+    shutters[0].mult = movie_profile.mosample_mult;
+    shutters[0].exposure = movie_profile.mosample_exposure;
 
-bool ProcState::mosample_create_shaders()
-{
-    bool ret = false;
+    for (s32 i = 1; i < num_shutters; i++)
+    {
+        shutters[i] = movie_profile.mosample_extra_shutters[i - 1];
+    }
 
-    ProcShader SHADER_LIST[] =
+    for (s32 i = 0; i < num_shutters; i++)
     {
-        ProcShader { "mosample", (void**)&mosample_cs, D3D11_COMPUTE_SHADER },
-        ProcShader { "downsample", (void**)&mosample_downsample_cs, D3D11_COMPUTE_SHADER },
-    };
+        max_mult = svr_max(max_mult, shutters[i].mult);
+    }
 
-    if (!vid_create_shaders_list(SHADER_LIST, SVR_ARRAY_SIZE(SHADER_LIST)))
+    // Skipping changes how long the game frames are, so it can only be done if the game sets its frame time from us.
+    if (!svr_mosample_schedule_init(&mosample_schedule, shutters, num_shutters, movie_profile.mosample_skip_closed && use_frame_steps))
     {
+        svr_console_msg_and_log("ERROR: The motion blur shutters need too many samples together, use fps mults that have more in common\n");
         goto rfail;
     }
 
-    ret = true;
-    goto rexit;
-
-rfail:
-
-rexit:
-    return ret;
-}
-
-bool ProcState::mosample_create_textures()
-{
-    bool ret = false;
-    HRESULT hr;
-
-    D3D11_TEXTURE2D_DESC tex_desc = {};
-    tex_desc.Width = movie_width;
-    tex_desc.Height = movie_height;
-    tex_desc.MipLevels = 1;
-    tex_desc.ArraySize = 1;
-    tex_desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT; // Must be high precision!
-    tex_desc.SampleDesc.Count = 1;
-    tex_desc.Usage = D3D11_USAGE_DEFAULT;
-    tex_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_RENDER_TARGET;
-
-    hr = vid_d3d11_device->CreateTexture2D(&tex_desc, NULL, &mosample_work_tex);
-
-    if (FAILED(hr))
+    // Games that do not use the frame steps run every sub-frame of the schedule, but shutters only take the game frames
+    // at their own sub-frames. This only works if one of the shutters takes every game frame.
+    if (!use_frame_steps && mosample_schedule.mult != max_mult)
     {
-        svr_log("ERROR: Could not create work texture (%#x)\n", hr);
+        svr_console_msg_and_log("ERROR: This game needs one motion blur fps mult that all the others go into\n");
         goto rfail;
     }
 
-    vid_d3d11_device->CreateShaderResourceView(mosample_work_tex, NULL, &mosample_work_tex_srv);
-    vid_d3d11_device->CreateRenderTargetView(mosample_work_tex, NULL, &mosample_work_tex_rtv);
-    vid_d3d11_device->CreateUnorderedAccessView(mosample_work_tex, NULL, &mosample_work_tex_uav);
-
-    // The work texture may get reused by the runtime between renderings, so we must clear it.
-    vid_clear_rtv(mosample_work_tex_rtv, 0.0f, 0.0f, 0.0f, 1.0f);
-
-    ret = true;
-    goto rexit;
-
-rfail:
-
-rexit:
-    return ret;
-}
-
-void ProcState::mosample_free_static()
-{
-    svr_maybe_release(&mosample_work_tex);
-    svr_maybe_release(&mosample_work_tex_rtv);
-    svr_maybe_release(&mosample_work_tex_srv);
-    svr_maybe_release(&mosample_work_tex_uav);
-
-    svr_maybe_release(&mosample_cs);
-    svr_maybe_release(&mosample_downsample_cs);
-    svr_maybe_release(&mosample_cb);
-}
+    // The differences are between game frames of all shutters, so this only works for one.
+    if (movie_profile.mosample_adaptive && use_frame_steps && num_shutters == 1)
+    {
+        svr_mosample_timer_set_adaptive(&mosample_schedule.timers[0], movie_profile.mosample_adaptive_limit);
+    }
 
-void ProcState::mosample_free_dynamic()
-{
-}
+    if (movie_profile.mosample_synth > 1)
+    {
+        if (backend != &proc_cpu_backend || num_shutters > 1 || mosample_schedule.timers[0].adaptive)
+        {
+            svr_console_msg_and_log("Not making motion blur samples, since that only works on the processor with one shutter and without the adaptive mode\n");
+        }
 
-bool ProcState::mosample_start()
-{
-    bool ret = false;
+        else
+        {
+            mosample_synth = movie_profile.mosample_synth;
+        }
+    }
 
-    if (!mosample_create_textures())
+    // Made after the adaptive mode and the sample making is set, since those need more.
+    if (!backend->create_targets(this))
     {
         goto rfail;
     }
 
-    mosample_remainder = 0.0f;
-
-    s32 sps = movie_profile.video_fps * movie_profile.mosample_mult;
-    mosample_remainder_step = (1.0f / sps) / (1.0f / movie_profile.video_fps);
-
     ret = true;
     goto rexit;
 
@@ -161,100 +86,46 @@ rexit:
 
 void ProcState::mosample_end()
 {
-}
-
-// TODO Probably consider to process several frames at once instead of just 1.
-void ProcState::mosample_process(float weight)
-{
-    if (weight != mosample_weight_cache)
-    {
-        MosampleCb cb_data;
-        cb_data.mosample_weight = weight;
-
-        mosample_weight_cache = weight;
-        vid_update_constant_buffer(mosample_cb, &cb_data, sizeof(MosampleCb));
-    }
-
-    vid_d3d11_context->CSSetShader(mosample_cs, NULL, 0);
-    vid_d3d11_context->CSSetShaderResources(0, 1, &svr_game_texture.srv);
-    vid_d3d11_context->CSSetConstantBuffers(0, 1, &mosample_cb);
-    vid_d3d11_context->CSSetUnorderedAccessViews(0, 1, &mosample_work_tex_uav, NULL);
-
-    vid_d3d11_context->Dispatch(vid_get_num_cs_threads(movie_width), vid_get_num_cs_threads(movie_height), 1);
-
-    vid_d3d11_context->Flush();
-
-    ID3D11ShaderResourceView* null_srv = NULL;
-    ID3D11UnorderedAccessView* null_uav = NULL;
-
-    vid_d3d11_context->CSSetShaderResources(0, 1, &null_srv);
-    vid_d3d11_context->CSSetUnorderedAccessViews(0, 1, &null_uav, NULL);
+    mosample_free_dynamic();
 }
 
 void ProcState::mosample_new_video_frame()
 {
-    float old_rem = mosample_remainder;
-    float exposure = movie_profile.mosample_exposure;
-
-    mosample_remainder += mosample_remainder_step;
+    SvrMosampleScheduleStep sched_step;
+    svr_mosample_schedule_step(&mosample_schedule, &sched_step);
 
-    if (mosample_remainder <= (1.0f - exposure))
+    if (mosample_schedule.timers[0].adaptive)
     {
+        backend->measure_diff(this, sched_step.num_steps);
     }
 
-    else if (mosample_remainder < 1.0f)
+    for (s32 i = 0; i < mosample_schedule.num_shutters; i++)
     {
-        float weight = (mosample_remainder - svr_max(1.0f - exposure, old_rem)) * (1.0f / exposure);
-        mosample_process(weight);
-    }
-
-    else
-    {
-        float weight = (1.0f - svr_max(1.0f - exposure, old_rem)) * (1.0f / exposure);
-
-        mosample_process(weight);
-
-        mosample_downsample_to_share_tex();
-
-        process_finished_shared_tex();
-
-        mosample_remainder -= 1.0f;
+        SvrMosampleStep* step = &sched_step.steps[i];
 
-        s32 additional = mosample_remainder;
+        if (step->weight > 0.0f)
+        {
+            backend->accumulate(this, i, step);
+        }
 
-        if (additional > 0)
+        if (step->finish_frame)
         {
-            for (s32 i = 0; i < additional; i++)
+            // Nothing can be drawn if the encoder has gone away, but the other shutters can still go on.
+            if (encoder_select(i))
             {
+                backend->downsample(this, i);
+
                 process_finished_shared_tex();
             }
 
-            mosample_remainder -= additional;
-        }
-
-        // Black is the only color that will work here, because the motion sampling is additive.
-        vid_clear_rtv(mosample_work_tex_rtv, 0.0f, 0.0f, 0.0f, 1.0f);
-
-        if (mosample_remainder > FLT_EPSILON && mosample_remainder > (1.0f - exposure))
-        {
-            weight = ((mosample_remainder - (1.0f - exposure)) * (1.0f / exposure));
-            mosample_process(weight);
+            // Black is the only color that will work here, because the motion sampling is additive.
+            backend->clear(this, i);
         }
     }
-}
-
-// Downsample 128 bpp texture to 32 bpp texture.
-void ProcState::mosample_downsample_to_share_tex()
-{
-    vid_d3d11_context->CSSetShader(mosample_downsample_cs, NULL, 0);
-    vid_d3d11_context->CSSetShaderResources(0, 1, &mosample_work_tex_srv);
-    vid_d3d11_context->CSSetUnorderedAccessViews(0, 1, &encoder_share_tex_uav, NULL);
-
-    vid_d3d11_context->Dispatch(vid_get_num_cs_threads(movie_width), vid_get_num_cs_threads(movie_height), 1);
 
-    ID3D11ShaderResourceView* null_srv = NULL;
-    ID3D11UnorderedAccessView* null_uav = NULL;
-
-    vid_d3d11_context->CSSetShaderResources(0, 1, &null_srv);
-    vid_d3d11_context->CSSetUnorderedAccessViews(0, 1, &null_uav, NULL);
+    // Every game frame is kept, since the sub-frames of a blended game frame are made from the one right before it.
+    if (mosample_synth > 0)
+    {
+        backend->keep_frame(this);
+    }
 }
@@ -5,26 +5,45 @@
 #include "svr_console.h"
 #include "svr_queue.h"
 #include "encoder_shared.h"
+#include "encoder_host.h"
+#ifdef _WIN32
 #include <d3d11.h>
+#include <d3d11_4.h>
 #include <d3d11shadertracing.h>
 #include <dxgi1_2.h>
 #include <strsafe.h>
 #include <dwrite.h>
 #include <d2d1_1.h>
+#include <wincodec.h>
 #include <malloc.h>
-#include <assert.h>
 #include <intrin.h>
+#else
+#include <unistd.h>
+#endif
+#include <assert.h>
 #include "svr_prof.h"
+#include "svr_trace.h"
 #include <stb_sprintf.h>
 #include "svr_api.h"
 #include "svr_ini.h"
 #include "svr_alloc.h"
-#include <Shlwapi.h>
+#include "svr_mosample.h"
+#include "svr_motion.h"
+#include "svr_glyphs.h"
+#include "svr_wave.h"
+#include "svr_stats.h"
+#include "svr_work_pool.h"
+#include "svr_copy.h"
 #include <math.h>
 #include <float.h>
+#include <string.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <Shlwapi.h>
 #include <TlHelp32.h>
 #include <d3d9.h>
 #include <Psapi.h>
+#endif
 
 #include "proc_state.h"
 #include "proc_profile_opts.h"
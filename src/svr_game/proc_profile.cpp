@@ -2,6 +2,7 @@
 
 // Profile loading.
 
+#ifdef _WIN32
 // Names for ini.
 OptStrIntMapping VELO_FONT_WEIGHT_TABLE[] =
 {
@@ -25,6 +26,7 @@ OptStrIntMapping VELO_FONT_STYLE_TABLE[] =
     OptStrIntMapping { "italic", DWRITE_FONT_STYLE_ITALIC },
     OptStrIntMapping { "extraitalic", DWRITE_FONT_STYLE_OBLIQUE },
 };
+#endif
 
 // Names for ini.
 OptStrIntMapping VELO_ANCHOR_TABLE[] =
@@ -106,18 +108,46 @@ void ProcState::movie_end()
 
 void ProcState::movie_setup_params()
 {
-    D3D11_TEXTURE2D_DESC tex_desc;
-    svr_game_texture.tex->GetDesc(&tex_desc);
+#ifdef _WIN32
+    if (svr_game_texture.tex)
+    {
+        D3D11_TEXTURE2D_DESC tex_desc;
+        svr_game_texture.tex->GetDesc(&tex_desc);
+
+        movie_width = tex_desc.Width;
+        movie_height = tex_desc.Height;
+        return;
+    }
+#endif
+
+    // The CPU backend has the size with the pixels.
+    movie_width = svr_game_texture.width;
+    movie_height = svr_game_texture.height;
+}
+
+// The trace of every svr_encoder is saved next to its movie, and ours goes next to the first movie.
+void ProcState::movie_end_trace()
+{
+    svr_trace_stop();
+    movie_trace = false;
+
+    char path[MAX_PATH];
+    SVR_SNPRINTF(path, "%s.svr_game", movie_path);
+
+    if (!svr_trace_save(path, "svr_game"))
+    {
+        svr_log("ERROR: Could not save trace to %s.json\n", path);
+        return;
+    }
 
-    movie_width = tex_desc.Width;
-    movie_height = tex_desc.Height;
+    svr_log("Saved trace to %s.json\n", path);
 }
 
 // A required profile must have all variables set to a proper value. This is used with the default profile.
 bool ProcState::movie_load_profile(const char* name, bool required)
 {
     char full_profile_path[MAX_PATH];
-    SVR_SNPRINTF(full_profile_path, "%s\\data\\profiles\\%s.ini", svr_resource_path, name);
+    SVR_SNPRINTF(full_profile_path, "%s" SVR_PATH_SEP "data" SVR_PATH_SEP "profiles" SVR_PATH_SEP "%s.ini", svr_resource_path, name);
 
     bool ret = false;
 
@@ -136,13 +166,22 @@ bool ProcState::movie_load_profile(const char* name, bool required)
     ret &= OPT_S32(ini_root, "video_x264_crf", 0, 52, &movie_profile.video_x264_crf);
     ret &= OPT_STR_LIST(ini_root, "video_x264_preset", X264_PRESET_TABLE, &movie_profile.video_x264_preset);
     ret &= OPT_BOOL(ini_root, "video_x264_intra", &movie_profile.video_x264_intra);
+    ret &= OPT_S32(ini_root, "video_x264_chunk_length", 1, 3600, &movie_profile.video_x264_chunk_length);
     ret &= OPT_STR_LIST(ini_root, "video_dnxhr_profile", DNXHR_PROFILE_TABLE, &movie_profile.video_dnxhr_profile);
     ret &= OPT_BOOL(ini_root, "audio_enabled", &movie_profile.audio_enabled);
     ret &= OPT_STR_LIST(ini_root, "audio_encoder", AUDIO_ENCODER_TABLE, &movie_profile.audio_encoder);
+    ret &= OPT_S32(ini_root, "encoder_memory_budget", 256, INT32_MAX, &movie_profile.encoder_memory_budget);
+    ret &= OPT_S32(ini_root, "encoder_workers", 0, 64, &movie_profile.encoder_workers);
+    ret &= OPT_BOOL(ini_root, "trace_enabled", &movie_profile.trace_enabled);
 
     ret &= OPT_BOOL(ini_root, "motion_blur_enabled", &movie_profile.mosample_enabled);
     ret &= OPT_S32(ini_root, "motion_blur_fps_mult", 2, INT32_MAX, &movie_profile.mosample_mult);
     ret &= OPT_FLOAT(ini_root, "motion_blur_exposure", 0.0f, 1.0f, &movie_profile.mosample_exposure);
+    ret &= OPT_BOOL(ini_root, "motion_blur_skip_closed", &movie_profile.mosample_skip_closed);
+    ret &= OPT_BOOL(ini_root, "motion_blur_adaptive", &movie_profile.mosample_adaptive);
+    ret &= OPT_FLOAT(ini_root, "motion_blur_adaptive_limit", 0.0f, 255.0f, &movie_profile.mosample_adaptive_limit);
+    ret &= OPT_S32(ini_root, "motion_blur_synth", 0, 64, &movie_profile.mosample_synth);
+    ret &= OPT_SHUTTERS(ini_root, "motion_blur_extra_shutters", movie_profile.mosample_extra_shutters, &movie_profile.mosample_num_extra_shutters);
 
     ret &= OPT_BOOL(ini_root, "velo_enabled", &movie_profile.velo_enabled);
     ret &= OPT_STR(ini_root, "velo_font", &movie_profile.velo_font);
@@ -150,8 +189,10 @@ bool ProcState::movie_load_profile(const char* name, bool required)
     ret &= OPT_COLOR(ini_root, "velo_color", &movie_profile.velo_font_color);
     ret &= OPT_COLOR(ini_root, "velo_border_color", &movie_profile.velo_font_border_color);
     ret &= OPT_S32(ini_root, "velo_border_size", 0, 192, &movie_profile.velo_font_border_size);
+#ifdef _WIN32
     ret &= OPT_STR_MAP(ini_root, "velo_font_style", VELO_FONT_STYLE_TABLE, (s32*)&movie_profile.velo_font_style);
     ret &= OPT_STR_MAP(ini_root, "velo_font_weight", VELO_FONT_WEIGHT_TABLE, (s32*)&movie_profile.velo_font_weight);
+#endif
     ret &= OPT_VEC2(ini_root, "velo_align", &movie_profile.velo_align);
     ret &= OPT_STR_MAP(ini_root, "velo_anchor", VELO_ANCHOR_TABLE, &movie_profile.velo_anchor);
     ret &= OPT_STR_MAP(ini_root, "velo_length", VELO_LENGTH_TABLE, &movie_profile.velo_length);
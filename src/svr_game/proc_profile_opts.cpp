@@ -84,11 +84,11 @@ bool opt_str_in_list_or(SvrIniKeyValue* kv, const char** list, s32 num, const ch
 
     for (s32 i = 0; i < num; i++)
     {
-        StringCchCatA(opts, SVR_ARRAY_SIZE(opts), list[i]);
+        strncat(opts, list[i], SVR_ARRAY_SIZE(opts) - strlen(opts) - 1);
 
         if (i != num - 1)
         {
-            StringCchCatA(opts, SVR_ARRAY_SIZE(opts), ", ");
+            strncat(opts, ", ", SVR_ARRAY_SIZE(opts) - strlen(opts) - 1);
         }
     }
 
@@ -121,11 +121,11 @@ bool opt_map_str_in_list_or(SvrIniKeyValue* kv, OptStrIntMapping* mappings, s32
     for (s32 i = 0; i < num; i++)
     {
         OptStrIntMapping* m = &mappings[i];
-        StringCchCatA(opts, SVR_ARRAY_SIZE(opts), m->name);
+        strncat(opts, m->name, SVR_ARRAY_SIZE(opts) - strlen(opts) - 1);
 
         if (i != num - 1)
         {
-            StringCchCatA(opts, SVR_ARRAY_SIZE(opts), ", ");
+            strncat(opts, ", ", SVR_ARRAY_SIZE(opts) - strlen(opts) - 1);
         }
     }
 
@@ -180,3 +180,49 @@ bool opt_make_color_or(SvrIniKeyValue* kv, SvrVec4I* dest)
     *dest = ret;
     return true;
 }
+
+// Shutters are pairs of <fps mult> <exposure>, or none.
+bool opt_make_shutters_or(SvrIniKeyValue* kv, SvrMosampleShutter* dest, s32 max, s32* num_dest)
+{
+    if (kv == NULL)
+    {
+        return false;
+    }
+
+    s32 num = 0;
+
+    if (strcmp(kv->value, "none"))
+    {
+        const char* ptr = svr_advance_until_after_whitespace(kv->value);
+
+        while (*ptr)
+        {
+            SvrMosampleShutter shutter;
+            s32 len = 0;
+
+            if (sscanf(ptr, "%d %f%n", &shutter.mult, &shutter.exposure, &len) != 2)
+            {
+                num = 0;
+                svr_console_msg_and_log("Option %s has incorrect formatting. It should be none or pairs of <fps mult> <exposure>. Setting to none\n", kv->key);
+                break;
+            }
+
+            ptr = svr_advance_until_after_whitespace(ptr + len);
+
+            if (num == max)
+            {
+                svr_console_msg_and_log("Option %s has more than %d shutters, the rest are not used\n", kv->key, max);
+                break;
+            }
+
+            svr_clamp(&shutter.mult, 2, INT32_MAX);
+            svr_clamp(&shutter.exposure, 0.0f, 1.0f);
+
+            dest[num] = shutter;
+            num++;
+        }
+    }
+
+    *num_dest = num;
+    return true;
+}
@@ -6,6 +6,10 @@ bool ProcState::init(const char* in_resource_path, ID3D11Device* in_d3d11_device
 
     SVR_COPY_STRING(in_resource_path, svr_resource_path);
 
+    svr_prof_init(); // Every module has its own timer state.
+
+    stats_init();
+
     if (!vid_init(in_d3d11_device))
     {
         goto rfail;
@@ -16,11 +20,6 @@ bool ProcState::init(const char* in_resource_path, ID3D11Device* in_d3d11_device
         goto rfail;
     }
 
-    if (!mosample_init())
-    {
-        goto rfail;
-    }
-
     if (!encoder_init())
     {
         goto rfail;
@@ -39,6 +38,10 @@ rexit:
 
 void ProcState::new_video_frame()
 {
+    SVR_TRACE_SCOPE("new_video_frame");
+
+    s64 start = svr_prof_get_real_time();
+
     // If we are using mosample, we will have to accumulate enough frames before we can start sending.
     // Mosample will internally send the frames when they are ready.
     if (movie_profile.mosample_enabled)
@@ -47,16 +50,27 @@ void ProcState::new_video_frame()
     }
 
     // No mosample, just send the frame over directly.
-    else
+    // Nothing can be drawn if the encoder has gone away.
+    else if (encoder_select(0))
     {
-        vid_d3d11_context->CopyResource(encoder_share_tex, svr_game_texture.tex);
+        backend->copy(this);
         process_finished_shared_tex();
     }
+
+    stats_new_video_frame(start);
 }
 
-void ProcState::new_audio_samples(SvrWaveSample* samples, s32 num_samples)
+// Every movie has the same audio.
+void ProcState::new_audio_samples(const void* samples, SvrWaveFormat format, s32 num_samples)
 {
-    encoder_send_audio_samples(samples, num_samples);
+    SVR_TRACE_SCOPE("new_audio_samples");
+
+    for (s32 i = 0; i < encoder_num_movies; i++)
+    {
+        encoder_send_audio_samples(&encoders[i], samples, format, num_samples);
+    }
+
+    stats_new_audio_samples(num_samples);
 }
 
 bool ProcState::is_velo_enabled()
@@ -69,7 +83,13 @@ bool ProcState::is_audio_enabled()
     return movie_profile.audio_enabled;
 }
 
+bool ProcState::is_trace_enabled()
+{
+    return movie_trace;
+}
+
 // Call this when you have written everything you need to encoder_share_tex.
+// This sends it to the encoder that was selected with encoder_select.
 void ProcState::process_finished_shared_tex()
 {
     // Now is the time to draw the velo if we have it.
@@ -78,21 +98,22 @@ void ProcState::process_finished_shared_tex()
         velo_draw();
     }
 
-    encoder_send_shared_tex();
+    encoder_send_shared_tex(encoder_cur);
 }
 
-bool ProcState::start(const char* dest_file, const char* profile, ProcGameTexture* game_texture, SvrAudioParams* audio_params)
+bool ProcState::start(const char* dest_file, const char* profile, ProcGameTexture* game_texture, SvrAudioParams* audio_params, bool in_use_frame_steps, s32 movie_length)
 {
     bool ret = false;
 
     svr_game_texture = *game_texture;
     svr_audio_params = *audio_params;
+    use_frame_steps = in_use_frame_steps;
 
     // Build output video path.
 
-    SVR_SNPRINTF(movie_path, "%s\\movies\\", svr_resource_path);
-    CreateDirectoryA(movie_path, NULL);
-    SVR_SNPRINTF(movie_path, "%s\\movies\\%s", svr_resource_path, dest_file);
+    SVR_SNPRINTF(movie_path, "%s" SVR_PATH_SEP "movies" SVR_PATH_SEP, svr_resource_path);
+    svr_create_dir(movie_path);
+    SVR_SNPRINTF(movie_path, "%s" SVR_PATH_SEP "movies" SVR_PATH_SEP "%s", svr_resource_path, dest_file);
 
     movie_setup_params();
 
@@ -115,6 +136,14 @@ bool ProcState::start(const char* dest_file, const char* profile, ProcGameTextur
         }
     }
 
+    // Started before anything else so the start of the movie is in the trace.
+    if (movie_profile.trace_enabled)
+    {
+        svr_trace_set_thread_name("GAME THREAD");
+        svr_trace_start();
+        movie_trace = true;
+    }
+
     if (!vid_start())
     {
         goto rfail;
@@ -135,12 +164,20 @@ bool ProcState::start(const char* dest_file, const char* profile, ProcGameTextur
         goto rfail;
     }
 
+    stats_start(movie_length);
+
     ret = true;
     goto rexit;
 
 rfail:
     free_dynamic();
 
+    if (movie_trace)
+    {
+        svr_trace_stop();
+        movie_trace = false;
+    }
+
 rexit:
     return ret;
 }
@@ -148,19 +185,27 @@ rexit:
 void ProcState::end()
 {
     encoder_end();
+    stats_end();
     mosample_end();
     velo_end();
     vid_end();
 
+    if (movie_trace)
+    {
+        movie_end_trace();
+    }
+
     svr_game_texture = {};
 }
 
 void ProcState::free_static()
 {
     encoder_free_static();
-    mosample_free_static();
     velo_free_static();
     vid_free_static();
+    stats_free_static();
+
+    svr_trace_free();
 }
 
 void ProcState::free_dynamic()
@@ -175,8 +220,18 @@ s32 ProcState::get_game_rate()
 {
     if (movie_profile.mosample_enabled)
     {
-        return movie_profile.video_fps * movie_profile.mosample_mult;
+        return movie_profile.video_fps * mosample_schedule.mult;
     }
 
     return movie_profile.video_fps;
 }
+
+s32 ProcState::get_frame_steps(s32 frames_ahead)
+{
+    if (movie_profile.mosample_enabled)
+    {
+        return svr_mosample_schedule_get_steps(&mosample_schedule, frames_ahead);
+    }
+
+    return 1;
+}
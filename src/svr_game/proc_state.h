@@ -2,12 +2,40 @@
 
 // Texture that comes directly from the game.
 // This is read only and is managed by svr_api.
+// The CPU backend has no texture, and the game frame is in memory instead.
 struct ProcGameTexture
 {
+#ifdef _WIN32
     ID3D11Texture2D* tex;
     ID3D11ShaderResourceView* srv;
+#endif
+
+    // CPU backend only. B8G8R8A8 pixels that are read on every new video frame.
+    const u8* pixels;
+    s32 pitch;
+    s32 width;
+    s32 height;
+};
+
+// What svr_game waits for svr_encoder on, for the wait times that are logged after every movie.
+using ProcIpcWait = s32;
+
+enum /* ProcIpcWait */
+{
+    PROC_IPC_WAIT_START, // Round trip of ENCODER_EVENT_START.
+    PROC_IPC_WAIT_STOP, // Round trip of ENCODER_EVENT_STOP.
+    PROC_IPC_WAIT_VIDEO_SLOT, // Every slot in the video ring was full.
+    PROC_IPC_WAIT_AUDIO_SPACE, // The audio ring was full.
+    PROC_IPC_WAIT_FRAME, // Everything in giving a frame to svr_encoder, including any wait for a free slot. For comparing the process and the host.
+    PROC_IPC_WAIT_COUNT,
 };
 
+// Difference measurements of adaptive motion blur that can be in flight on the GPU.
+const s32 PROC_MOSAMPLE_DIFF_READBACKS = 4;
+
+// Movies that can be made at the same time, one for every motion blur shutter.
+const s32 PROC_MAX_ENCODERS = SVR_MOSAMPLE_MAX_SHUTTERS;
+
 using ProcVeloAnchor = s32;
 
 enum /* ProcVeloAnchor */
@@ -36,12 +64,22 @@ struct MovieProfile
     s32 video_fps;
     s32 video_x264_crf;
     s32 video_x264_intra;
+    s32 video_x264_chunk_length; // In seconds.
     s32 audio_enabled;
+    s32 encoder_memory_budget; // In megabytes.
+    s32 encoder_workers;
+    s32 trace_enabled;
 
     // Mosample options:
     s32 mosample_enabled;
     s32 mosample_mult;
     float mosample_exposure;
+    s32 mosample_skip_closed;
+    s32 mosample_adaptive;
+    float mosample_adaptive_limit;
+    s32 mosample_synth; // Sub-frames made from every blended game frame, or 0 for none.
+    SvrMosampleShutter mosample_extra_shutters[SVR_MOSAMPLE_MAX_SHUTTERS - 1]; // Shutters for more movies from the same game frames.
+    s32 mosample_num_extra_shutters;
 
     // Velo options:
     s32 velo_enabled;
@@ -50,19 +88,119 @@ struct MovieProfile
     SvrVec4I velo_font_color;
     SvrVec4I velo_font_border_color;
     s32 velo_font_border_size;
+#ifdef _WIN32
     DWRITE_FONT_STYLE velo_font_style;
     DWRITE_FONT_WEIGHT velo_font_weight;
+#endif
     SvrVec2I velo_align;
     ProcVeloAnchor velo_anchor;
     ProcVeloLength velo_length;
 };
 
+#ifdef _WIN32
 struct ProcShader
 {
     const char* name;
     void** dest;
     D3D11_SHADER_TYPE type;
 };
+#endif
+
+// Texture in a slot of the video ring that is shared with svr_encoder.
+struct ProcShareSlot
+{
+#ifdef _WIN32
+    ID3D11Texture2D* tex;
+    ID3D11UnorderedAccessView* uav;
+    ID3D11RenderTargetView* rtv;
+    ID3D11ShaderResourceView* srv;
+    HANDLE tex_h;
+    ID2D1Bitmap1* d2d1_tex;
+    IDXGIKeyedMutex* lock;
+#endif
+
+    u8* pixels; // CPU backend only. Part of the frame memory of the encoder.
+};
+
+#ifdef _WIN32
+// High precision texture that one motion blur shutter adds its sub-frames to (total 128 bits per pixel).
+struct ProcMosampleTarget
+{
+    ID3D11Texture2D* tex;
+    ID3D11RenderTargetView* rtv;
+    ID3D11ShaderResourceView* srv;
+    ID3D11UnorderedAccessView* uav;
+};
+#endif
+
+// Connection to one svr_encoder, which makes one movie.
+struct ProcEncoder
+{
+    // Has full access and not just the access needed to wait, since handles are duplicated into it.
+    // When svr_encoder runs inside this process, this is the thread that it runs on.
+    SvrIpcProcess proc;
+
+    bool hosted; // If svr_encoder runs inside this process from svr_encoder_host.dll. Only for 64-bit.
+    EncoderHostParams host_params;
+
+    SvrIpcMem shared_mem;
+    EncoderSharedMem* shared_ptr; // Same as the pointer in shared_mem.
+
+    SvrProfHistogram ipc_waits[PROC_IPC_WAIT_COUNT]; // Microseconds spent waiting for svr_encoder. Reset on every movie start.
+
+    // Intermediate textures needed for texture sharing, one for every slot in the video ring.
+    // High precision textures are not allowed to be shared, so we need to downsample the result of the mosample to 32 bpp.
+    // These textures are the final result from all prior processing, such as motion blur and velo text.
+    ProcShareSlot share_slots[ENCODER_VIDEO_SLOTS];
+    s32 share_slot_idx; // The slot that is being written to, or -1 if we could not get one.
+
+    // CPU backend only. The frames of all slots one after another, which svr_encoder opens for every movie.
+    SvrIpcMem frame_mem;
+
+    char movie_path[MAX_PATH];
+};
+
+struct ProcState;
+
+// Interface abstraction for where the frames are processed.
+// Everything that touches the pixels between the game frame and svr_encoder goes through here, so the scheduling of the
+// sub-frames, the velo and the handoff to svr_encoder are the same for every backend.
+// The D3D11 backend is used in games. The CPU backend is used when there is no device, which is how svr_game_bench runs without a GPU.
+// Only the CPU backend exists on other platforms.
+struct ProcBackendDesc
+{
+    const char* name;
+
+    bool(*init)(ProcState* proc);
+    void(*free)(ProcState* proc);
+
+    // Movie resources.
+    bool(*create_targets)(ProcState* proc); // Mosample targets for every shutter, and what the adaptive mode needs.
+    void(*free_targets)(ProcState* proc);
+    bool(*create_share_slots)(ProcState* proc, ProcEncoder* enc);
+    void(*free_share_slots)(ProcState* proc, ProcEncoder* enc);
+    bool(*create_overlay)(ProcState* proc); // Rasterizes the digits into velo_atlas, and makes what is needed to put velo_sprite on the frames.
+
+    // Work on the game frame. Everything that writes to a slot writes to the one that was selected with encoder_select.
+    void(*accumulate)(ProcState* proc, s32 idx, SvrMosampleStep* step); // Adds the game frame to the mosample target of a shutter.
+    void(*downsample)(ProcState* proc, s32 idx); // Writes the mosample target of a shutter to the slot.
+    void(*clear)(ProcState* proc, s32 idx); // Puts the mosample target of a shutter back to black.
+    void(*copy)(ProcState* proc); // Writes the game frame to the slot.
+    void(*measure_diff)(ProcState* proc, s32 num_steps); // Gives the differences that are done to the mosample timer, and measures this game frame.
+    void(*keep_frame)(ProcState* proc); // Keeps the game frame to make sub-frames from with the next one. Only when mosample_synth is used.
+    void(*update_overlay)(ProcState* proc, SvrVec4I rect); // The part of velo_sprite in the rect has been drawn again.
+    void(*composite_overlay)(ProcState* proc, SvrVec4I rect); // Puts velo_sprite on the slot, with the top left corner and size in the rect. The CPU backend draws the digits of velo_sprite_text instead.
+
+    // Handoff to svr_encoder.
+    void(*acquire_slot)(ProcState* proc, ProcShareSlot* slot); // The slot was given back by svr_encoder.
+    void(*release_slot)(ProcState* proc, ProcShareSlot* slot); // The slot is about to be given to svr_encoder.
+};
+
+#ifdef _WIN32
+extern ProcBackendDesc proc_d3d11_backend;
+#endif
+
+extern ProcBackendDesc proc_cpu_backend;
 
 struct ProcState
 {
@@ -73,22 +211,36 @@ struct ProcState
 
     ProcGameTexture svr_game_texture; // Texture of the game.
     SvrAudioParams svr_audio_params;
+    bool use_frame_steps; // If the game sets the time of its frames from get_frame_steps.
+
+    ProcBackendDesc* backend; // The D3D11 backend if there is a device, and the CPU backend if not.
 
     bool init(const char* in_resource_path, ID3D11Device* in_d3d11_device);
-    bool start(const char* dest_file, const char* profile, ProcGameTexture* game_texture, SvrAudioParams* audio_params);
+    bool start(const char* dest_file, const char* profile, ProcGameTexture* game_texture, SvrAudioParams* audio_params, bool in_use_frame_steps, s32 movie_length);
     void new_video_frame();
-    void new_audio_samples(SvrWaveSample* samples, s32 num_samples);
+    void new_audio_samples(const void* samples, SvrWaveFormat format, s32 num_samples);
     bool is_velo_enabled();
     bool is_audio_enabled();
+    bool is_trace_enabled();
     void process_finished_shared_tex();
     void end();
     void free_static();
     void free_dynamic();
     s32 get_game_rate();
+    s32 get_frame_steps(s32 frames_ahead);
 
     // -----------------------------------------------
     // Video state:
 
+    bool vid_init(ID3D11Device* d3d11_device);
+    void vid_free_static();
+    void vid_free_dynamic();
+    bool vid_start();
+    void vid_end();
+
+#ifdef _WIN32
+    // The device and the 2D drawing on it are only for the D3D11 backend.
+    // The D2D1 factory and the DirectWrite factory are used by both.
     ID3D11Device* vid_d3d11_device;
     ID3D11DeviceContext* vid_d3d11_context;
     void* vid_shader_mem;
@@ -101,42 +253,57 @@ struct ProcState
     IDWriteFactory* vid_dwrite_factory;
     ID2D1SolidColorBrush* vid_d2d1_solid_brush;
 
-    bool vid_init(ID3D11Device* d3d11_device);
+    bool vid_create_d2d1_factory();
     bool vid_create_d2d1();
     bool vid_create_dwrite();
-    void vid_free_static();
-    void vid_free_dynamic();
     bool vid_load_shader(const char* name);
     bool vid_create_shader(const char* name, void** shader, D3D11_SHADER_TYPE type);
     bool vid_create_shaders_list(ProcShader* shaders, s32 num);
     void vid_update_constant_buffer(ID3D11Buffer* buffer, void* data, UINT size);
     void vid_clear_rtv(ID3D11RenderTargetView* rtv, float r, float g, float b, float a);
     s32 vid_get_num_cs_threads(s32 unit);
-    bool vid_start();
-    void vid_end();
     D2D1_COLOR_F vid_fill_d2d1_color(SvrVec4I color);
     D2D1_POINT_2F vid_fill_d2d1_pt(SvrVec2I p);
+#endif
 
     // -----------------------------------------------
     // Velo state:
 
+#ifdef _WIN32
     IDWriteFontFace* velo_font_face;
+    UINT16 velo_number_glyph_idxs[10]; // Glyph indexes for all numbers so we don't have to look that up every time.
+    ID2D1Bitmap1* velo_sprite_bitmap;
+#endif
+
     SvrVec2I velo_draw_pos;
 
     // Emulation of tabular font feature.
     float velo_tab_height;
     float velo_tab_advance_x;
 
-    UINT16 velo_number_glyph_idxs[10]; // Glyph indexes for all numbers so we don't have to look that up every time.
-
     SvrVec3 velo_vector;
 
+    // The digits are rasterized once into the atlas, and numbers are drawn from it into the sprite on the processor.
+    // The sprite is only drawn again when the number changes, and is then put on top of every frame.
+    SvrGlyphAtlas velo_atlas;
+    SvrSimdLevel velo_simd_level;
+    u8* velo_sprite; // Premultiplied 32 bpp pixels of the size of the longest number.
+    SvrVec4I velo_sprite_rect; // Size of the sprite and where it is from the baseline origin.
+    char velo_sprite_text[16]; // Number that is in the sprite now.
+
     bool velo_init();
     void velo_free_static();
     void velo_free_dynamic();
+#ifdef _WIN32
     bool velo_create_font_face();
     void velo_setup_tab_metrix();
     void velo_setup_glyph_idxs();
+    void velo_create_atlas();
+    void velo_draw_atlas_cells(ID2D1RenderTarget* target, ID2D1SolidColorBrush* brush);
+#endif
+    void velo_read_atlas(const u8* bits, s32 pitch);
+    void velo_create_sprite();
+    void velo_update_sprite(const char* text, s32 text_length);
     bool velo_start();
     void velo_end();
     void velo_draw();
@@ -147,11 +314,9 @@ struct ProcState
     // -----------------------------------------------
     // Motion blur state:
 
-    // High precision texture used for the result of mosample (total 128 bits per pixel).
-    ID3D11Texture2D* mosample_work_tex;
-    ID3D11RenderTargetView* mosample_work_tex_rtv;
-    ID3D11ShaderResourceView* mosample_work_tex_srv;
-    ID3D11UnorderedAccessView* mosample_work_tex_uav;
+#ifdef _WIN32
+    // Result of mosample for every shutter. D3D11 backend only, the CPU backend has cpu_targets.
+    ProcMosampleTarget mosample_targets[SVR_MOSAMPLE_MAX_SHUTTERS];
 
     ID3D11ComputeShader* mosample_cs;
     ID3D11ComputeShader* mosample_downsample_cs;
@@ -161,73 +326,92 @@ struct ProcState
 
     // To not upload data all the time.
     float mosample_weight_cache;
+#endif
+
+    // Same timing as the processor version in svr_mosample.
+    // The first shutter is from the main options and the others are the extra shutters.
+    SvrMosampleSchedule mosample_schedule;
+
+    // Sub-frames made from every blended game frame with svr_motion, or 0 if they are not made.
+    // Only the CPU backend can do this, since the D3D11 backend would have to read back every game frame.
+    s32 mosample_synth;
+
+#ifdef _WIN32
+    // For the adaptive mode, the difference between every game frame and the one before is measured.
+    // The results are read back some frames later, so the game never has to wait for them.
+    ID3D11ComputeShader* mosample_diff_cs;
+    ID3D11Texture2D* mosample_diff_tex; // Block sums of the previous game frame.
+    ID3D11UnorderedAccessView* mosample_diff_tex_uav;
+    ID3D11Buffer* mosample_diff_buf; // Total difference.
+    ID3D11UnorderedAccessView* mosample_diff_buf_uav;
+    ID3D11Buffer* mosample_diff_readbacks[PROC_MOSAMPLE_DIFF_READBACKS];
+    s32 mosample_diff_steps[PROC_MOSAMPLE_DIFF_READBACKS]; // Sub-frames between the game frames of each readback.
+    s32 mosample_diff_read_idx;
+    s32 mosample_diff_num_pending;
+    bool mosample_diff_has_prev; // If the block sums have a game frame to compare with.
+#endif
 
-    float mosample_remainder;
-    float mosample_remainder_step;
-
-    bool mosample_init();
-    bool mosample_create_buffer();
-    bool mosample_create_shaders();
-    bool mosample_create_textures();
-    void mosample_free_static();
     void mosample_free_dynamic();
     bool mosample_start();
     void mosample_end();
-    void mosample_process(float weight);
     void mosample_new_video_frame();
-    void mosample_downsample_to_share_tex();
 
     // -----------------------------------------------
     // Encoder state:
 
-    HANDLE encoder_proc;
-    HANDLE encoder_shared_mem_h;
-    HANDLE game_wake_event_h;
-    HANDLE encoder_wake_event_h;
-    EncoderSharedMem* encoder_shared_ptr;
-    void* encoder_audio_buffer;
+    // The first encoder is started on init and is the only one that can run inside this process.
+    // The others are started as processes when a movie first needs them, and are kept for later movies.
+    ProcEncoder encoders[PROC_MAX_ENCODERS];
+    s32 encoder_num_started;
+    s32 encoder_num_movies; // Encoders that the current movie uses.
 
-    // FIFO of audio samples we need to send to the encoder.
-    // During motion blur capture, the number of samples sent from the game will be very low (like 12).
-    // We should not wake up the encoder and wait for just that little, so queue up a bunch instead and send many.
-    SvrDynQueue<SvrWaveSample> encoder_pending_samples;
-
-    // Intermediate texture needed for texture sharing.
-    // High precision textures are not allowed to be shared, so we need to downsample the result of the mosample to 32 bpp.
-    // This texture is the final result from all prior processing, such as motion blur and velo text.
+    // The encoder and the texture of its current slot. Everything that draws the final result draws into these.
+    ProcEncoder* encoder_cur;
+#ifdef _WIN32
     ID3D11Texture2D* encoder_share_tex;
     ID3D11UnorderedAccessView* encoder_share_tex_uav;
     ID3D11RenderTargetView* encoder_share_tex_rtv;
     ID3D11ShaderResourceView* encoder_share_tex_srv;
-    HANDLE encoder_share_tex_h;
     ID2D1Bitmap1* encoder_d2d1_share_tex; // Not a real texture, but a reference to encoder_share_tex.
     IDXGIKeyedMutex* encoder_share_tex_lock;
+#endif
+    u8* encoder_share_pixels; // CPU backend only.
+
+    SvrSimdLevel encoder_simd_level; // For converting audio into the audio ring.
 
     bool encoder_init();
     void encoder_free_static();
     void encoder_free_dynamic();
-    bool encoder_create_shared_mem();
-    bool encoder_start_process();
+    bool encoder_launch(ProcEncoder* enc, bool allow_host);
+    bool encoder_create_shared_mem(ProcEncoder* enc);
+    bool encoder_start_process(ProcEncoder* enc);
+#ifdef _WIN32
+    bool encoder_start_host(ProcEncoder* enc);
+#endif
     bool encoder_start();
-    bool encoder_create_share_textures();
-    bool encoder_set_shared_mem_params();
+    void encoder_setup_movie_path(s32 idx);
+    bool encoder_begin_share_slot(ProcEncoder* enc);
+    void encoder_use_share_slot(ProcEncoder* enc, s32 idx);
+    bool encoder_select(s32 idx);
+    bool encoder_check_error(ProcEncoder* enc);
+    bool encoder_set_shared_mem_params(ProcEncoder* enc);
     void encoder_end();
-    bool encoder_send_event(EncoderSharedEvent event);
-    bool encoder_send_shared_tex();
-    bool encoder_send_audio_samples(SvrWaveSample* samples, s32 num_samples);
-    void encoder_flush_audio();
-    bool encoder_submit_pending_samples();
-    bool encoder_send_audio_from_pending(s32 num_samples);
-    bool encoder_create_d2d1_bitmap();
+    bool encoder_send_event(ProcEncoder* enc, EncoderSharedEvent event);
+    bool encoder_send_shared_tex(ProcEncoder* enc);
+    bool encoder_send_audio_samples(ProcEncoder* enc, const void* samples, SvrWaveFormat format, s32 num_samples);
+    bool encoder_wait_for_audio_space(ProcEncoder* enc);
+    bool encoder_wait(ProcEncoder* enc, SvrIpcEvent* event, ProcIpcWait wait);
+    void encoder_log_ipc_waits(ProcEncoder* enc);
 
     // -----------------------------------------------
     // Movie state:
 
     s32 movie_width;
     s32 movie_height;
-    char movie_path[MAX_PATH];
+    char movie_path[MAX_PATH]; // Of the first movie.
 
     MovieProfile movie_profile;
+    bool movie_trace; // If a trace of this movie is being recorded.
 
     bool movie_init();
     void movie_free_static();
@@ -235,5 +419,40 @@ struct ProcState
     bool movie_start();
     void movie_end();
     void movie_setup_params();
+    void movie_end_trace();
     bool movie_load_profile(const char* name, bool required);
+
+    // -----------------------------------------------
+    // Stats state:
+
+    // Live statistics that svr_monitor shows. Only the first game that runs has them.
+    SvrIpcMem stats_mem;
+    SvrStatsBlock* stats_block; // NULL if there are no stats.
+    SvrStatsGame stats_game; // Copied to the block after every game frame.
+    s64 stats_frame_end_time; // When the last svr_frame returned, or 0 before the first.
+    s64 stats_video_frame_time; // When the last video frame was given to the first encoder.
+
+    void stats_init();
+    void stats_free_static();
+    void stats_start(s32 movie_length);
+    void stats_end();
+    void stats_new_video_frame(s64 start);
+    void stats_new_audio_samples(s32 num_samples);
+    void stats_sent_shared_tex(ProcEncoder* enc, s64 start);
+
+    // -----------------------------------------------
+    // CPU backend state:
+
+    SvrWorkPool* cpu_pool;
+    SvrSimdLevel cpu_simd_level;
+
+    SvrMosampleBuffer cpu_targets[SVR_MOSAMPLE_MAX_SHUTTERS];
+
+    // For the adaptive mode and mosample_synth, the previous game frame is kept to compare with or to make sub-frames from.
+    u8* cpu_prev_frame;
+    bool cpu_has_prev;
+
+    // For mosample_synth.
+    SvrMotionField cpu_motion;
+    u8* cpu_synth_frame;
 };
@@ -0,0 +1,122 @@
+#include "proc_priv.h"
+
+// Live statistics for svr_monitor.
+// Everything is kept in stats_game and copied to the block after every game frame, which is only a few stores.
+
+static_assert(PROC_MAX_ENCODERS <= SVR_STATS_MAX_ENCODERS, "Every encoder must have a part in the stats block");
+
+// Not an error, since the stats are only for watching. The name is the same for every game, so only the first game that runs has them.
+void ProcState::stats_init()
+{
+    if (!svr_ipc_create_named_mem(SVR_STATS_MEM_NAME, sizeof(SvrStatsBlock), &stats_mem))
+    {
+        svr_log("Could not create live statistics, they are only shown for the first running game\n");
+        return;
+    }
+
+    stats_block = (SvrStatsBlock*)stats_mem.ptr;
+    svr_stats_init(stats_block, svr_ipc_get_current_pid());
+}
+
+void ProcState::stats_free_static()
+{
+    svr_ipc_free_mem(&stats_mem);
+    stats_block = NULL;
+}
+
+// The length is in seconds of video, or 0 if not known.
+void ProcState::stats_start(s32 movie_length)
+{
+    if (stats_block == NULL)
+    {
+        return;
+    }
+
+    s64 now = svr_prof_get_real_time();
+
+    stats_game = {};
+    stats_game.state = SVR_STATS_STATE_RENDERING;
+    stats_game.num_encoders = encoder_num_movies;
+    stats_game.video_fps = movie_profile.video_fps;
+    stats_game.game_rate = get_game_rate();
+    stats_game.start_time = now;
+    stats_game.update_time = now;
+    stats_game.movie_frames = (s64)movie_length * movie_profile.video_fps;
+
+    stats_frame_end_time = 0;
+    stats_video_frame_time = now;
+
+    svr_stats_write_game(stats_block, &stats_game);
+}
+
+void ProcState::stats_end()
+{
+    if (stats_block == NULL)
+    {
+        return;
+    }
+
+    stats_game.state = SVR_STATS_STATE_IDLE;
+    stats_game.update_time = svr_prof_get_real_time();
+
+    svr_stats_write_game(stats_block, &stats_game);
+}
+
+// Called after every game frame with the time that svr_frame started.
+void ProcState::stats_new_video_frame(s64 start)
+{
+    if (stats_block == NULL)
+    {
+        return;
+    }
+
+    s64 now = svr_prof_get_real_time();
+
+    if (stats_frame_end_time > 0)
+    {
+        svr_stats_add_time(&stats_game.stage_times[SVR_STATS_GAME_STAGE_GAME], (double)(start - stats_frame_end_time));
+    }
+
+    svr_stats_add_time(&stats_game.stage_times[SVR_STATS_GAME_STAGE_PROCESS], (double)(now - start));
+
+    stats_game.game_frames++;
+    stats_game.update_time = now;
+    stats_frame_end_time = now;
+
+    svr_stats_write_game(stats_block, &stats_game);
+}
+
+void ProcState::stats_new_audio_samples(s32 num_samples)
+{
+    stats_game.audio_samples += num_samples;
+}
+
+// Called for every frame given to an encoder, with the time it started.
+// The frames of the first encoder count as the video frames, and set how fast the movie renders.
+void ProcState::stats_sent_shared_tex(ProcEncoder* enc, s64 start)
+{
+    if (stats_block == NULL)
+    {
+        return;
+    }
+
+    s64 now = svr_prof_get_real_time();
+
+    svr_stats_add_time(&stats_game.stage_times[SVR_STATS_GAME_STAGE_SEND], (double)(now - start));
+
+    if (enc != &encoders[0])
+    {
+        return;
+    }
+
+    svr_stats_add_time(&stats_game.frame_interval, (double)(now - stats_video_frame_time));
+
+    stats_game.video_frames++;
+    stats_video_frame_time = now;
+
+    if (stats_game.movie_frames > 0)
+    {
+        s64 frames_left = svr_max(stats_game.movie_frames - stats_game.video_frames, (s64)0);
+        stats_game.finish_time = now + (s64)(frames_left * stats_game.frame_interval);
+    }
+}
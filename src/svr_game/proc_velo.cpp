@@ -1,7 +1,11 @@
 #include "proc_priv.h"
 
+// Most digits of a number, which is the most for a s32.
+const s32 VELO_MAX_DIGITS = 10;
+
 bool ProcState::velo_init()
 {
+    velo_simd_level = svr_simd_get_best_level();
     return true;
 }
 
@@ -11,9 +15,21 @@ void ProcState::velo_free_static()
 
 void ProcState::velo_free_dynamic()
 {
+#ifdef _WIN32
     svr_maybe_release(&velo_font_face);
+    svr_maybe_release(&velo_sprite_bitmap);
+#endif
+
+    if (velo_sprite)
+    {
+        svr_free(velo_sprite);
+        velo_sprite = NULL;
+    }
+
+    svr_glyph_free_atlas(&velo_atlas);
 }
 
+#ifdef _WIN32
 // Try to find the font in the system.
 bool ProcState::velo_create_font_face()
 {
@@ -109,11 +125,139 @@ void ProcState::velo_setup_glyph_idxs()
     velo_font_face->GetGlyphIndicesW(CPS, SVR_ARRAY_SIZE(CPS), velo_number_glyph_idxs);
 }
 
+// Lays out the atlas for the fill and the border of every digit.
+// The backend rasterizes the cells with velo_draw_atlas_cells and gives them back with velo_read_atlas.
+void ProcState::velo_create_atlas()
+{
+    bool has_border = movie_profile.velo_font_border_size > 0;
+
+    DWRITE_FONT_METRICS font_metrix;
+    velo_font_face->GetMetrics(&font_metrix);
+
+    float scale = (float)movie_profile.velo_font_size / (float)font_metrix.designUnitsPerEm;
+
+    // Room around the glyphs for the border and for parts of glyphs that go outside of the advance.
+    s32 margin = (movie_profile.velo_font_border_size + 1) / 2 + movie_profile.velo_font_size / 8 + 1;
+    s32 ascent = (s32)ceilf(font_metrix.ascent * scale);
+    s32 descent = (s32)ceilf(font_metrix.descent * scale);
+
+    s32 cell_w = (s32)ceilf(velo_tab_advance_x) + 2 * margin;
+    s32 cell_h = ascent + descent + 2 * margin;
+    SvrVec2I origin = SvrVec2I { margin, margin + ascent };
+
+    svr_glyph_create_atlas(&velo_atlas, cell_w, cell_h, origin, velo_tab_advance_x, has_border);
+}
+
+// Draws the fill and the border of every digit in the same way that they would be drawn on the frame.
+// The fill goes in the top row of cells and the border in the bottom row.
+// Both are drawn in white, so the alpha is the coverage.
+// Must be called between BeginDraw and EndDraw of the target.
+void ProcState::velo_draw_atlas_cells(ID2D1RenderTarget* target, ID2D1SolidColorBrush* brush)
+{
+    bool has_border = velo_atlas.border != NULL;
+
+    target->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+    target->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+
+    brush->SetColor(D2D1::ColorF(1.0f, 1.0f, 1.0f, 1.0f));
+
+    for (s32 i = 0; i < SVR_GLYPH_NUM_DIGITS; i++)
+    {
+        float x = (float)(i * velo_atlas.cell_width + velo_atlas.origin.x);
+        float y = (float)velo_atlas.origin.y;
+
+        if (has_border)
+        {
+            ID2D1PathGeometry* geom;
+            vid_d2d1_factory->CreatePathGeometry(&geom);
+
+            ID2D1GeometrySink* sink;
+            geom->Open(&sink);
+
+            velo_font_face->GetGlyphRunOutline(movie_profile.velo_font_size, &velo_number_glyph_idxs[i], NULL, NULL, 1, FALSE, FALSE, sink);
+
+            sink->Close();
+
+            target->SetTransform(D2D1::Matrix3x2F::Translation(x, y));
+            target->FillGeometry(geom, brush);
+
+            target->SetTransform(D2D1::Matrix3x2F::Translation(x, y + velo_atlas.cell_height));
+            target->DrawGeometry(geom, brush, movie_profile.velo_font_border_size);
+
+            svr_release(geom);
+            svr_release(sink);
+        }
+
+        // Use more specialized path with no border.
+        else
+        {
+            DWRITE_GLYPH_RUN run = {};
+            run.fontFace = velo_font_face;
+            run.fontEmSize = movie_profile.velo_font_size;
+            run.glyphCount = 1;
+            run.glyphIndices = &velo_number_glyph_idxs[i];
+
+            target->DrawGlyphRun(D2D1::Point2F(x, y), &run, brush);
+        }
+    }
+
+    target->SetTransform(D2D1::Matrix3x2F::Identity());
+}
+#endif
+
+// Takes the coverage of the cells that were drawn with velo_draw_atlas_cells, in premultiplied BGRA.
+void ProcState::velo_read_atlas(const u8* bits, s32 pitch)
+{
+    s32 atlas_pitch = svr_glyph_get_atlas_pitch(&velo_atlas);
+    s32 cell_h = velo_atlas.cell_height;
+
+    for (s32 y = 0; y < cell_h; y++)
+    {
+        for (s32 x = 0; x < atlas_pitch; x++)
+        {
+            velo_atlas.fill[y * atlas_pitch + x] = bits[y * pitch + x * 4 + 3];
+
+            if (velo_atlas.border)
+            {
+                velo_atlas.border[y * atlas_pitch + x] = bits[(y + cell_h) * pitch + x * 4 + 3];
+            }
+        }
+    }
+}
+
+// The sprite has room for the longest number, but only the part that the current number covers is used.
+void ProcState::velo_create_sprite()
+{
+    velo_sprite_rect = svr_glyph_get_text_rect(&velo_atlas, VELO_MAX_DIGITS);
+    velo_sprite = (u8*)svr_zalloc(velo_sprite_rect.z * velo_sprite_rect.w * 4);
+    velo_sprite_text[0] = 0;
+}
+
+// Draws a new number into the sprite from the atlas.
+void ProcState::velo_update_sprite(const char* text, s32 text_length)
+{
+    SvrVec4I rect = svr_glyph_get_text_rect(&velo_atlas, text_length);
+    s32 pitch = velo_sprite_rect.z * 4;
+
+    for (s32 y = 0; y < rect.w; y++)
+    {
+        memset(velo_sprite + y * pitch, 0, rect.z * 4);
+    }
+
+    SvrVec2I pos = SvrVec2I { -rect.x, -rect.y };
+    svr_glyph_draw_digits(&velo_atlas, text, text_length, pos, movie_profile.velo_font_color, movie_profile.velo_font_border_color,
+                          velo_sprite, pitch, rect.z, rect.w, velo_simd_level);
+
+    backend->update_overlay(this, rect);
+
+    SVR_COPY_STRING(text, velo_sprite_text);
+}
+
 bool ProcState::velo_start()
 {
     bool ret = false;
-    HRESULT hr;
 
+#ifdef _WIN32
     if (!velo_create_font_face())
     {
         goto rfail;
@@ -124,10 +268,31 @@ bool ProcState::velo_start()
     velo_setup_tab_metrix();
     velo_setup_glyph_idxs();
 
+    if (movie_profile.velo_enabled)
+    {
+        velo_create_atlas();
+        velo_create_sprite();
+
+        if (!backend->create_overlay(this))
+        {
+            goto rfail;
+        }
+    }
+#else
+    // The digits are rasterized from a system font with DirectWrite, and there is nothing to load fonts with on other platforms.
+    if (movie_profile.velo_enabled)
+    {
+        svr_console_msg_and_log("Not drawing the velo, since fonts can only be loaded on Windows\n");
+        movie_profile.velo_enabled = 0;
+    }
+#endif
+
     ret = true;
     goto rexit;
 
+#ifdef _WIN32
 rfail:
+#endif
 
 rexit:
 
@@ -136,42 +301,32 @@ rexit:
 
 void ProcState::velo_end()
 {
+    velo_free_dynamic();
 }
 
 void ProcState::velo_draw()
 {
+    SVR_TRACE_SCOPE("velo_draw");
+
     float length = velo_get_length();
     s32 speed = (s32)(sqrtf(length) + 0.5f);
 
     char buf[128];
     s32 text_length = SVR_SNPRINTF(buf, "%d", speed);
 
-    UINT16* idxs = SVR_ALLOCA_NUM(UINT16, text_length);
-    float* advances = SVR_ALLOCA_NUM(float, text_length);
-
-    // Map the glyph indexes.
-    for (s32 i = 0; i < text_length; i++)
+    // With motion blur the number is the same for many frames in a row.
+    if (strcmp(buf, velo_sprite_text))
     {
-        s32 idx = buf[i] - '0';
-        idxs[i] = velo_number_glyph_idxs[idx];
+        velo_update_sprite(buf, text_length);
     }
 
     // Emulation of tabular font feature where every number is monospaced.
     // For the full feature, the font itself also changes its shaping for the glyphs to be wider, but that is not important.
     // This also prevents the text from jittering when it changes during the centering logic. Typically caused by the 1 character sometimes being thinner than other characters.
 
-    for (s32 i = 0; i < text_length; i++)
-    {
-        advances[i] = velo_tab_advance_x;
-    }
-
-    // Vertical positioning is done from the baseline.
-
     float w = text_length * velo_tab_advance_x;
-    float h = velo_tab_height;
 
     s32 real_w = (s32)ceilf(w);
-    s32 real_h = (s32)ceilf(h);
     s32 shift_x = real_w / 2;
 
     SvrVec2I pos = velo_draw_pos;
@@ -186,54 +341,10 @@ void ProcState::velo_draw()
         pos.x -= real_w;
     }
 
-    vid_d2d1_context->BeginDraw();
-    vid_d2d1_context->SetTarget(encoder_d2d1_share_tex);
-
-    if (movie_profile.velo_font_border_size > 0)
-    {
-        ID2D1PathGeometry* geom;
-        vid_d2d1_factory->CreatePathGeometry(&geom);
-
-        ID2D1GeometrySink* sink;
-        geom->Open(&sink);
-
-        velo_font_face->GetGlyphRunOutline(movie_profile.velo_font_size, idxs, advances, NULL, text_length, FALSE, FALSE, sink);
-
-        sink->Close();
-
-        vid_d2d1_context->SetTransform(D2D1::Matrix3x2F::Translation(pos.x, pos.y));
-
-        // Draw the fill.
-        vid_d2d1_solid_brush->SetColor(vid_fill_d2d1_color(movie_profile.velo_font_color));
-        vid_d2d1_context->FillGeometry(geom, vid_d2d1_solid_brush);
-
-        // Draw the border.
-        vid_d2d1_solid_brush->SetColor(vid_fill_d2d1_color(movie_profile.velo_font_border_color));
-        vid_d2d1_context->DrawGeometry(geom, vid_d2d1_solid_brush, movie_profile.velo_font_border_size);
-
-        svr_release(geom);
-        geom = NULL;
-
-        svr_release(sink);
-        sink = NULL;
-    }
-
-    // Use more specialized path with no border.
-    else
-    {
-        DWRITE_GLYPH_RUN run = {};
-        run.fontFace = velo_font_face;
-        run.fontEmSize = movie_profile.velo_font_size;
-        run.glyphCount = text_length;
-        run.glyphIndices = idxs;
-        run.glyphAdvances = advances;
-
-        vid_d2d1_solid_brush->SetColor(vid_fill_d2d1_color(movie_profile.velo_font_color));
-        vid_d2d1_context->DrawGlyphRun(vid_fill_d2d1_pt(pos), &run, vid_d2d1_solid_brush);
-    }
+    // Vertical positioning is done from the baseline, which is where the sprite is placed from.
+    SvrVec4I rect = svr_glyph_get_text_rect(&velo_atlas, text_length);
 
-    vid_d2d1_context->EndDraw();
-    vid_d2d1_context->SetTarget(NULL);
+    backend->composite_overlay(this, SvrVec4I { pos.x + rect.x, pos.y + rect.y, rect.z, rect.w });
 }
 
 void ProcState::velo_give(SvrVec3 source)
@@ -2,17 +2,32 @@
 
 const s32 VID_SHADER_SIZE = 8192; // Max size one shader can be when loading.
 
+// Without a device, everything is done on the processor.
 bool ProcState::vid_init(ID3D11Device* d3d11_device)
 {
     bool ret = false;
-    HRESULT hr;
 
-    vid_d3d11_device = d3d11_device;
-    vid_d3d11_device->AddRef();
+#ifdef _WIN32
+    backend = d3d11_device ? &proc_d3d11_backend : &proc_cpu_backend;
+#else
+    (void)d3d11_device;
+    backend = &proc_cpu_backend;
+#endif
 
-    vid_d3d11_device->GetImmediateContext(&vid_d3d11_context);
+    svr_log("Using %s backend for frames\n", backend->name);
 
-    if (!vid_create_d2d1())
+#ifdef _WIN32
+    if (d3d11_device)
+    {
+        vid_d3d11_device = d3d11_device;
+        vid_d3d11_device->AddRef();
+
+        vid_d3d11_device->GetImmediateContext(&vid_d3d11_context);
+
+        vid_shader_mem = svr_alloc(VID_SHADER_SIZE);
+    }
+
+    if (!vid_create_d2d1_factory())
     {
         goto rfail;
     }
@@ -21,8 +36,12 @@ bool ProcState::vid_init(ID3D11Device* d3d11_device)
     {
         goto rfail;
     }
+#endif
 
-    vid_shader_mem = svr_alloc(VID_SHADER_SIZE);
+    if (!backend->init(this))
+    {
+        goto rfail;
+    }
 
     ret = true;
     goto rexit;
@@ -33,14 +52,12 @@ rexit:
     return ret;
 }
 
-bool ProcState::vid_create_d2d1()
+#ifdef _WIN32
+bool ProcState::vid_create_d2d1_factory()
 {
     bool ret = false;
     HRESULT hr;
 
-    IDXGIDevice* dxgi_device = NULL;
-    vid_d3d11_device->QueryInterface(IID_PPV_ARGS(&dxgi_device));
-
     hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, IID_PPV_ARGS(&vid_d2d1_factory));
 
     if (FAILED(hr))
@@ -49,6 +66,24 @@ bool ProcState::vid_create_d2d1()
         goto rfail;
     }
 
+    ret = true;
+    goto rexit;
+
+rfail:
+
+rexit:
+    return ret;
+}
+
+// 2D drawing on the device, for the D3D11 backend.
+bool ProcState::vid_create_d2d1()
+{
+    bool ret = false;
+    HRESULT hr;
+
+    IDXGIDevice* dxgi_device = NULL;
+    vid_d3d11_device->QueryInterface(IID_PPV_ARGS(&dxgi_device));
+
     hr = vid_d2d1_factory->CreateDevice(dxgi_device, &vid_d2d1_device);
 
     if (FAILED(hr))
@@ -98,9 +133,17 @@ rfail:
 rexit:
     return ret;
 }
+#endif
 
 void ProcState::vid_free_static()
 {
+    if (backend)
+    {
+        backend->free(this);
+        backend = NULL;
+    }
+
+#ifdef _WIN32
     svr_maybe_release(&vid_d3d11_device);
     svr_maybe_release(&vid_d3d11_context);
 
@@ -111,12 +154,14 @@ void ProcState::vid_free_static()
     svr_maybe_release(&vid_d2d1_solid_brush);
 
     svr_maybe_free((void**)&vid_shader_mem);
+#endif
 }
 
 void ProcState::vid_free_dynamic()
 {
 }
 
+#ifdef _WIN32
 bool ProcState::vid_load_shader(const char* name)
 {
     bool ret = false;
@@ -237,6 +282,7 @@ s32 ProcState::vid_get_num_cs_threads(s32 unit)
     // Thread group divisor constant must match the thread count in the compute shaders!
     return svr_align32(unit, 8) >> 3;
 }
+#endif
 
 bool ProcState::vid_start()
 {
@@ -247,6 +293,7 @@ void ProcState::vid_end()
 {
 }
 
+#ifdef _WIN32
 D2D1_COLOR_F ProcState::vid_fill_d2d1_color(SvrVec4I color)
 {
     D2D1_COLOR_F ret;
@@ -261,3 +308,4 @@ D2D1_POINT_2F ProcState::vid_fill_d2d1_pt(SvrVec2I p)
 {
     return D2D1::Point2F(p.x, p.y);
 }
+#endif
@@ -2,9 +2,11 @@
 
 // Used for internal and external SVR.
 // This layer if necessary translates operations from D3D9Ex to D3D11.
+// Only Windows games have it, so on other platforms svr_game_bench uses proc_state directly.
 
 // -------------------------------------------------
 
+#ifdef _WIN32
 ID3D11Device* svr_d3d11_device;
 ID3D11DeviceContext* svr_d3d11_context;
 IDirect3DDevice9Ex* svr_d3d9ex_device;
@@ -17,6 +19,7 @@ IDirect3DSurface9* svr_d3d9ex_share_surf;
 // Destination texture that we work with (Both D3D11 and D3D9Ex).
 ID3D11Texture2D* svr_content_tex;
 ID3D11ShaderResourceView* svr_content_srv;
+#endif
 
 // -------------------------------------------------
 
@@ -24,6 +27,8 @@ ProcState proc_state;
 
 // -------------------------------------------------
 
+#ifdef _WIN32
+
 bool svr_movie_running;
 
 // -------------------------------------------------
@@ -147,8 +152,13 @@ bool svr_init(const char* svr_path, IUnknown* game_device)
         svr_log("Init for a D3D9Ex game\n");
 
         // BGRA support needed for Direct2D interoperability.
-        // It is also only intended to be used from a single thread.
-        UINT device_create_flags = D3D11_CREATE_DEVICE_SINGLETHREADED | D3D11_CREATE_DEVICE_BGRA_SUPPORT;
+        UINT device_create_flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
+
+        // It is only intended to be used from a single thread, except in 64-bit where svr_encoder can run in this process
+        // and use it from its own thread.
+#ifndef _WIN64
+        device_create_flags |= D3D11_CREATE_DEVICE_SINGLETHREADED;
+#endif
 
 #ifdef SVR_DEBUG
         device_create_flags |= D3D11_CREATE_DEVICE_DEBUG;
@@ -279,7 +289,7 @@ bool svr_start(const char* movie_name, const char* movie_profile, SvrStartMovieD
     game_texture.tex = svr_content_tex;
     game_texture.srv = svr_content_srv;
 
-    if (!proc_state.start(movie_name, movie_profile, &game_texture, &movie_data->audio_params))
+    if (!proc_state.start(movie_name, movie_profile, &game_texture, &movie_data->audio_params, movie_data->use_frame_steps, movie_data->movie_length))
     {
         goto rfail;
     }
@@ -310,6 +320,17 @@ int svr_get_game_rate()
     return proc_state.get_game_rate();
 }
 
+int svr_get_frame_steps(int frames_ahead)
+{
+    if (!svr_movie_running)
+    {
+        OutputDebugStringA("SVR (svr_get_frame_steps): Movie is not started. It is not allowed to call this now\n");
+        return 1;
+    }
+
+    return proc_state.get_frame_steps(frames_ahead);
+}
+
 void svr_stop()
 {
     if (!svr_movie_running)
@@ -344,6 +365,11 @@ bool svr_is_audio_enabled()
     return proc_state.is_audio_enabled();
 }
 
+bool svr_is_trace_enabled()
+{
+    return proc_state.is_trace_enabled();
+}
+
 void svr_give_velocity(float* xyz)
 {
     SvrVec3 vec;
@@ -354,7 +380,18 @@ void svr_give_velocity(float* xyz)
     proc_state.velo_give(vec);
 }
 
+// The samples of the API are given to svr_wave as its own types.
+static_assert(sizeof(SvrWaveSample) == sizeof(SvrWaveS16) && offsetof(SvrWaveSample, r) == offsetof(SvrWaveS16, r), "Audio sample layouts must match");
+static_assert(sizeof(SvrWaveSample32) == sizeof(SvrWaveS32) && offsetof(SvrWaveSample32, r) == offsetof(SvrWaveS32, r), "Audio sample layouts must match");
+
 void svr_give_audio(SvrWaveSample* samples, int num_samples)
 {
-    proc_state.new_audio_samples(samples, num_samples);
+    proc_state.new_audio_samples(samples, SVR_WAVE_FORMAT_S16, num_samples);
 }
+
+void svr_give_audio_32(SvrWaveSample32* samples, int num_samples)
+{
+    proc_state.new_audio_samples(samples, SVR_WAVE_FORMAT_S32, num_samples);
+}
+
+#endif
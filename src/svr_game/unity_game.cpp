@@ -4,6 +4,10 @@
 #include "proc_state.cpp"
 #include "proc_velo.cpp"
 #include "proc_video.cpp"
+#include "proc_d3d11.cpp"
+#include "proc_cpu.cpp"
 #include "proc_profile.cpp"
 #include "proc_profile_opts.cpp"
+#include "proc_stats.cpp"
 #include "svr_api.cpp"
+#include "game_bench.cpp"
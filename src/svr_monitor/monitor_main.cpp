@@ -0,0 +1,512 @@
+#include "svr_common.h"
+#include "svr_stats.h"
+#include "svr_ipc.h"
+#include "svr_prof.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Shows the live statistics of a running game, either as a view that is redrawn like top or as one JSON object per line.
+// The block is opened again for every sample, so a game that has exited is noticed and a new game is found.
+
+using MonitorStatus = s32;
+
+enum /* MonitorStatus */
+{
+    MONITOR_STATUS_OK,
+    MONITOR_STATUS_NOT_RUNNING, // There is no game with stats.
+    MONITOR_STATUS_WRONG_VERSION, // The game is from another version of SVR.
+    MONITOR_STATUS_BUSY, // A part could not be read because it was always being written.
+};
+
+const char* MONITOR_STATUS_NAMES[] =
+{
+    "ok",
+    "not_running",
+    "wrong_version",
+    "busy",
+};
+
+const char* MONITOR_GAME_STAGE_NAMES[] =
+{
+    "game",
+    "process",
+    "send",
+};
+
+const char* MONITOR_ENCODER_STAGE_NAMES[] =
+{
+    "convert",
+    "download",
+    "encode",
+    "write",
+};
+
+static_assert(SVR_ARRAY_SIZE(MONITOR_GAME_STAGE_NAMES) == SVR_STATS_GAME_NUM_STAGES, "Every game stage must have a name");
+static_assert(SVR_ARRAY_SIZE(MONITOR_ENCODER_STAGE_NAMES) == SVR_STATS_ENCODER_NUM_STAGES, "Every encoder stage must have a name");
+
+struct MonitorSample
+{
+    MonitorStatus status;
+    s64 time; // From svr_prof_get_real_time.
+    u32 game_pid;
+    SvrStatsGame game;
+    SvrStatsEncoder encoders[SVR_STATS_MAX_ENCODERS];
+};
+
+struct MonitorOptions
+{
+    bool json;
+    s32 interval; // In milliseconds.
+    s32 count; // Samples to show before exiting, or 0 to run until stopped.
+};
+
+static MonitorStatus monitor_read_block(SvrStatsBlock* block, MonitorSample* dest)
+{
+    dest->game_pid = block->header.game_pid;
+
+    if (!svr_stats_read_game(block, &dest->game))
+    {
+        return MONITOR_STATUS_BUSY;
+    }
+
+    for (s32 i = 0; i < SVR_STATS_MAX_ENCODERS; i++)
+    {
+        if (!svr_stats_read_encoder(block, i, &dest->encoders[i]))
+        {
+            return MONITOR_STATUS_BUSY;
+        }
+    }
+
+    return MONITOR_STATUS_OK;
+}
+
+static void monitor_read(MonitorSample* dest)
+{
+    SvrIpcMem mem;
+
+    *dest = {};
+    dest->time = svr_prof_get_real_time();
+
+    if (!svr_ipc_open_named_mem(SVR_STATS_MEM_NAME, &mem))
+    {
+        dest->status = MONITOR_STATUS_NOT_RUNNING;
+        return;
+    }
+
+    if (!svr_stats_check(mem.ptr, mem.size))
+    {
+        dest->status = MONITOR_STATUS_WRONG_VERSION;
+    }
+
+    else
+    {
+        dest->status = monitor_read_block((SvrStatsBlock*)mem.ptr, dest);
+    }
+
+    svr_ipc_free_mem(&mem);
+}
+
+// Text for a length of time in microseconds, as hours, minutes and seconds.
+static void monitor_format_duration(s64 time, char* buf, s32 buf_size)
+{
+    s64 secs = svr_max(time, (s64)0) / 1000000;
+    stbsp_snprintf(buf, buf_size, "%02lld:%02lld:%02lld", (long long)(secs / 3600), (long long)((secs / 60) % 60), (long long)(secs % 60));
+}
+
+static s64 monitor_get_video_time(SvrStatsGame* game)
+{
+    if (game->video_fps == 0)
+    {
+        return 0;
+    }
+
+    return game->video_frames * 1000000 / game->video_fps;
+}
+
+static s64 monitor_get_real_time(MonitorSample* sample)
+{
+    SvrStatsGame* game = &sample->game;
+    s64 end = game->state == SVR_STATS_STATE_RENDERING ? sample->time : game->update_time;
+
+    return end - game->start_time;
+}
+
+// Microseconds until the movie is done, or -1 if not known.
+static s64 monitor_get_time_left(MonitorSample* sample)
+{
+    SvrStatsGame* game = &sample->game;
+
+    if (game->state != SVR_STATS_STATE_RENDERING || game->finish_time == 0)
+    {
+        return -1;
+    }
+
+    return svr_max(game->finish_time - sample->time, (s64)0);
+}
+
+// Video frames rendered every second of real time.
+static double monitor_get_speed(SvrStatsGame* game)
+{
+    if (game->frame_interval <= 0.0)
+    {
+        return 0.0;
+    }
+
+    return 1000000.0 / game->frame_interval;
+}
+
+// Bytes written every second since the last sample, or 0 if the last sample was not of the same movie.
+static double monitor_get_write_rate(MonitorSample* sample, MonitorSample* prev, s32 idx)
+{
+    SvrStatsEncoder* enc = &sample->encoders[idx];
+    SvrStatsEncoder* prev_enc = &prev->encoders[idx];
+    s64 duration = sample->time - prev->time;
+
+    if (prev->status != MONITOR_STATUS_OK || prev->game_pid != sample->game_pid || duration <= 0 || enc->bytes_written < prev_enc->bytes_written)
+    {
+        return 0.0;
+    }
+
+    return (double)(enc->bytes_written - prev_enc->bytes_written) * 1000000.0 / (double)duration;
+}
+
+static const char* monitor_get_state_name(SvrStatsState state)
+{
+    return state == SVR_STATS_STATE_RENDERING ? "rendering" : "idle";
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Top view.
+
+static void monitor_print_view(MonitorSample* sample, MonitorSample* prev)
+{
+    char buf0[32];
+    char buf1[32];
+
+    printf("\x1b[H\x1b[2J"); // Move to the top and clear the screen.
+
+    if (sample->status == MONITOR_STATUS_NOT_RUNNING)
+    {
+        printf("svr_monitor - waiting for a game to start\n");
+        return;
+    }
+
+    if (sample->status == MONITOR_STATUS_WRONG_VERSION)
+    {
+        printf("svr_monitor - the running game is from another version of SVR\n");
+        return;
+    }
+
+    if (sample->status == MONITOR_STATUS_BUSY)
+    {
+        printf("svr_monitor - the statistics of the game could not be read\n");
+        return;
+    }
+
+    SvrStatsGame* game = &sample->game;
+
+    printf("svr_monitor - game %u - %s\n\n", sample->game_pid, monitor_get_state_name(game->state));
+
+    if (game->start_time == 0)
+    {
+        printf("No movie has been made yet\n");
+        return;
+    }
+
+    monitor_format_duration(monitor_get_video_time(game), buf0, sizeof(buf0));
+
+    if (game->movie_frames > 0 && game->video_fps > 0)
+    {
+        monitor_format_duration(game->movie_frames * 1000000 / game->video_fps, buf1, sizeof(buf1));
+        printf("Video time      %s / %s (%.1f%%)\n", buf0, buf1, 100.0 * (double)game->video_frames / (double)game->movie_frames);
+    }
+
+    else
+    {
+        printf("Video time      %s\n", buf0);
+    }
+
+    monitor_format_duration(monitor_get_real_time(sample), buf0, sizeof(buf0));
+    printf("Real time       %s\n", buf0);
+
+    double speed = monitor_get_speed(game);
+    printf("Speed           %.1f fps (%.2fx real time)\n", speed, game->video_fps > 0 ? speed / game->video_fps : 0.0);
+
+    s64 time_left = monitor_get_time_left(sample);
+
+    if (time_left >= 0)
+    {
+        time_t done = time(NULL) + (time_t)(time_left / 1000000);
+        struct tm* done_tm = localtime(&done);
+
+        monitor_format_duration(time_left, buf0, sizeof(buf0));
+        strftime(buf1, sizeof(buf1), "%H:%M:%S", done_tm);
+        printf("Time left       %s (done at %s)\n", buf0, buf1);
+    }
+
+    printf("Frames          game %lld  video %lld  audio samples %lld\n", (long long)game->game_frames, (long long)game->video_frames, (long long)game->audio_samples);
+
+    printf("Stages (ms)   ");
+
+    for (s32 i = 0; i < SVR_STATS_GAME_NUM_STAGES; i++)
+    {
+        printf("  %s %.2f", MONITOR_GAME_STAGE_NAMES[i], game->stage_times[i] / 1000.0);
+    }
+
+    printf("\n");
+
+    s32 num_encoders = svr_min(game->num_encoders, SVR_STATS_MAX_ENCODERS);
+
+    for (s32 i = 0; i < num_encoders; i++)
+    {
+        SvrStatsEncoder* enc = &sample->encoders[i];
+        double write_rate = monitor_get_write_rate(sample, prev, i);
+
+        printf("\nMovie %d: %s - %s\n", i, enc->movie_name, monitor_get_state_name(enc->state));
+        printf("Frames          received %lld  downloaded %lld  encoded %lld  written %lld\n",
+               (long long)enc->frames_received, (long long)enc->frames_downloaded, (long long)enc->frames_encoded, (long long)enc->frames_written);
+        printf("Queues          download %d  encode %d  audio %d  packets %d\n", enc->download_queue, enc->encode_queue, enc->audio_queue, enc->packet_queue);
+        printf("Memory          used %lld MB  peak %lld MB  budget %lld MB  waits %d\n",
+               (long long)SVR_FROM_MB(enc->pool_used), (long long)SVR_FROM_MB(enc->pool_peak), (long long)SVR_FROM_MB(enc->pool_budget), enc->pool_num_waits);
+        printf("Written         %.1f MB (%.2f MB/s)\n", enc->bytes_written / 1048576.0, write_rate / 1048576.0);
+
+        printf("Stages (ms)   ");
+
+        for (s32 j = 0; j < SVR_STATS_ENCODER_NUM_STAGES; j++)
+        {
+            printf("  %s %.2f", MONITOR_ENCODER_STAGE_NAMES[j], enc->stage_times[j] / 1000.0);
+        }
+
+        printf("\n");
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// JSON lines.
+
+// Movie names come from the file system, so they can have characters that must be escaped.
+static void monitor_print_json_string(const char* str)
+{
+    putchar('"');
+
+    for (const char* c = str; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            printf("\\%c", *c);
+        }
+
+        else if ((u8)*c < 0x20)
+        {
+            printf("\\u%04x", (u8)*c);
+        }
+
+        else
+        {
+            putchar(*c);
+        }
+    }
+
+    putchar('"');
+}
+
+static void monitor_print_json_stages(const double* times, const char** names, s32 num)
+{
+    printf("{");
+
+    for (s32 i = 0; i < num; i++)
+    {
+        printf("%s\"%s\":%.3f", i > 0 ? "," : "", names[i], times[i] / 1000.0);
+    }
+
+    printf("}");
+}
+
+// Times are in seconds and stages are in milliseconds.
+static void monitor_print_json(MonitorSample* sample, MonitorSample* prev)
+{
+    printf("{\"time\":%lld,\"status\":\"%s\"", (long long)time(NULL), MONITOR_STATUS_NAMES[sample->status]);
+
+    if (sample->status != MONITOR_STATUS_OK)
+    {
+        printf("}\n");
+        return;
+    }
+
+    SvrStatsGame* game = &sample->game;
+    s64 time_left = monitor_get_time_left(sample);
+
+    printf(",\"game_pid\":%u,\"state\":\"%s\"", sample->game_pid, monitor_get_state_name(game->state));
+    printf(",\"video_fps\":%d,\"game_rate\":%d", game->video_fps, game->game_rate);
+    printf(",\"game_frames\":%lld,\"video_frames\":%lld,\"audio_samples\":%lld,\"movie_frames\":%lld",
+           (long long)game->game_frames, (long long)game->video_frames, (long long)game->audio_samples, (long long)game->movie_frames);
+    printf(",\"video_time\":%.3f,\"real_time\":%.3f", monitor_get_video_time(game) / 1000000.0, monitor_get_real_time(sample) / 1000000.0);
+    printf(",\"speed\":%.3f", monitor_get_speed(game));
+
+    if (time_left >= 0)
+    {
+        printf(",\"time_left\":%.3f", time_left / 1000000.0);
+    }
+
+    else
+    {
+        printf(",\"time_left\":null");
+    }
+
+    printf(",\"stages\":");
+    monitor_print_json_stages(game->stage_times, MONITOR_GAME_STAGE_NAMES, SVR_STATS_GAME_NUM_STAGES);
+
+    printf(",\"encoders\":[");
+
+    s32 num_encoders = svr_min(game->num_encoders, SVR_STATS_MAX_ENCODERS);
+
+    for (s32 i = 0; i < num_encoders; i++)
+    {
+        SvrStatsEncoder* enc = &sample->encoders[i];
+        double write_rate = monitor_get_write_rate(sample, prev, i);
+
+        printf("%s{\"movie\":", i > 0 ? "," : "");
+        monitor_print_json_string(enc->movie_name);
+        printf(",\"state\":\"%s\"", monitor_get_state_name(enc->state));
+        printf(",\"frames_received\":%lld,\"frames_downloaded\":%lld,\"frames_encoded\":%lld,\"frames_written\":%lld",
+               (long long)enc->frames_received, (long long)enc->frames_downloaded, (long long)enc->frames_encoded, (long long)enc->frames_written);
+        printf(",\"bytes_written\":%lld,\"write_rate\":%.0f,\"audio_samples\":%lld", (long long)enc->bytes_written, write_rate, (long long)enc->audio_samples);
+        printf(",\"queues\":{\"download\":%d,\"encode\":%d,\"audio\":%d,\"packets\":%d}",
+               enc->download_queue, enc->encode_queue, enc->audio_queue, enc->packet_queue);
+        printf(",\"pool_used\":%lld,\"pool_peak\":%lld,\"pool_budget\":%lld,\"pool_waits\":%d",
+               (long long)enc->pool_used, (long long)enc->pool_peak, (long long)enc->pool_budget, enc->pool_num_waits);
+        printf(",\"stages\":");
+        monitor_print_json_stages(enc->stage_times, MONITOR_ENCODER_STAGE_NAMES, SVR_STATS_ENCODER_NUM_STAGES);
+        printf("}");
+    }
+
+    printf("]}\n");
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static void monitor_sleep(s32 ms)
+{
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    usleep(ms * 1000);
+#endif
+}
+
+// The view is drawn with escape codes, which have to be turned on for the Windows console.
+static void monitor_enable_escape_codes()
+{
+#ifdef _WIN32
+    HANDLE out_h = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode;
+
+    if (GetConsoleMode(out_h, &mode))
+    {
+        SetConsoleMode(out_h, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+#endif
+}
+
+static void monitor_print_usage()
+{
+    printf("Usage: svr_monitor [--json] [--interval <ms>] [--count <n>]\n");
+    printf("\n");
+    printf("Shows the live statistics of the movie that a running game is making.\n");
+    printf("\n");
+    printf("    --json             Print one JSON object per line instead of the view\n");
+    printf("    --interval <ms>    Time between samples, 1000 by default\n");
+    printf("    --count <n>        Exit after this many samples\n");
+}
+
+static bool monitor_parse_options(s32 argc, char** argv, MonitorOptions* options)
+{
+    options->json = false;
+    options->interval = 1000;
+    options->count = 0;
+
+    for (s32 i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!strcmp(arg, "--json"))
+        {
+            options->json = true;
+        }
+
+        else if (!strcmp(arg, "--interval") && value)
+        {
+            options->interval = svr_max(atoi(value), 10);
+            i++;
+        }
+
+        else if (!strcmp(arg, "--count") && value)
+        {
+            options->count = svr_max(atoi(value), 0);
+            i++;
+        }
+
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    MonitorOptions options;
+
+    if (!monitor_parse_options(argc, argv, &options))
+    {
+        monitor_print_usage();
+        return 1;
+    }
+
+    svr_prof_init();
+
+    if (!options.json)
+    {
+        monitor_enable_escape_codes();
+    }
+
+    MonitorSample prev = {};
+    MonitorSample sample = {};
+
+    for (s32 i = 0; options.count == 0 || i < options.count; i++)
+    {
+        if (i > 0)
+        {
+            monitor_sleep(options.interval);
+        }
+
+        monitor_read(&sample);
+
+        if (options.json)
+        {
+            monitor_print_json(&sample, &prev);
+        }
+
+        else
+        {
+            monitor_print_view(&sample, &prev);
+        }
+
+        fflush(stdout);
+
+        prev = sample;
+    }
+
+    return 0;
+}
@@ -1,14 +1,21 @@
 #include "svr_common.h"
 #include "svr_console.h"
 #include "svr_log.h"
+
+#ifdef _WIN32
 #include <Windows.h>
 
 using GameMsgFn = void(__cdecl*)(const char* format, ...);
+#else
+using GameMsgFn = void(*)(const char* format, ...);
+#endif
 
 GameMsgFn svr_console_msg_fn;
 
+// There is no game on other platforms, so the messages only go to the log.
 void svr_console_init()
 {
+#ifdef _WIN32
     HMODULE module = GetModuleHandleA("tier0.dll");
 
     if (module == NULL)
@@ -17,6 +24,7 @@ void svr_console_init()
     }
 
     svr_console_msg_fn = (GameMsgFn)GetProcAddress(module, "Msg");
+#endif
 }
 
 void svr_console_msg(const char* format, ...)
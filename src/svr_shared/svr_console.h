@@ -1,7 +1,10 @@
 #pragma once
 #include <stdarg.h>
 
-#ifdef SVR_SHARED_DLL
+// On other platforms it is built into the program that uses it.
+#ifndef _WIN32
+#define SVR_CONSOLE_API
+#elif defined(SVR_SHARED_DLL)
 #define SVR_CONSOLE_API __declspec(dllexport)
 #else
 #define SVR_CONSOLE_API __declspec(dllimport)
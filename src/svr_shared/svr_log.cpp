@@ -1,6 +1,9 @@
 #include "svr_log.h"
 #include "svr_common.h"
+#include "svr_thread.h"
 #include <assert.h>
+
+#ifdef _WIN32
 #include <Windows.h>
 
 HANDLE log_file_handle;
@@ -45,6 +48,41 @@ void svr_free_log()
 {
     svr_maybe_close_handle(&log_file_handle);
 }
+#else
+FILE* log_file_handle;
+SvrLock log_lock;
+
+void log_function(const char* text, s32 length)
+{
+    assert(log_file_handle);
+
+    // Written right away like WriteFile, so nothing is lost if the program crashes.
+    svr_lock_acquire(&log_lock);
+    fwrite(text, sizeof(char), length, log_file_handle);
+    fflush(log_file_handle);
+    svr_lock_release(&log_lock);
+}
+
+void svr_init_log(const char* log_file_path, bool append)
+{
+    if (log_file_handle)
+    {
+        return;
+    }
+
+    // The file might be set to read only or something. Don't bother then.
+    log_file_handle = fopen(log_file_path, append ? "ab" : "wb");
+}
+
+void svr_free_log()
+{
+    if (log_file_handle)
+    {
+        fclose(log_file_handle);
+        log_file_handle = NULL;
+    }
+}
+#endif
 
 // Below log functions not used for integrated SVR, but we may get here still from game_log.
 
@@ -1,7 +1,10 @@
 #pragma once
 #include <stdarg.h>
 
-#ifdef SVR_SHARED_DLL
+// On other platforms it is built into the program that uses it.
+#ifndef _WIN32
+#define SVR_LOG_API
+#elif defined(SVR_SHARED_DLL)
 #define SVR_LOG_API __declspec(dllexport)
 #else
 #define SVR_LOG_API __declspec(dllimport)
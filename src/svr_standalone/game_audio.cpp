@@ -51,17 +51,22 @@ void game_audio_free()
 
 void game_audio_frame()
 {
+    SVR_TRACE_SCOPE("audio_frame");
+
     if (svr_is_audio_enabled())
     {
         if (game_state.audio_desc)
         {
             // Figure out how many samples we need to process for this frame.
+            // This is the frame that the game runs now, which is given to svr_frame in the next frame.
+            // The samples are counted from the start so the fractions of samples add up exactly.
+
+            game_state.snd_num_steps += svr_get_frame_steps(GAME_REC_AUDIO_STEPS_AHEAD);
 
-            float time_ahead_to_mix = 1.0f / (float)game_state.rec_game_rate;
-            float num_frac_samples_to_mix = (time_ahead_to_mix * game_state.search_desc.snd_sample_rate) + game_state.snd_lost_mix_time;
+            s64 end_sample = (game_state.snd_num_steps * game_state.search_desc.snd_sample_rate) / game_state.rec_game_rate;
 
-            s32 num_samples_to_mix = (s32)num_frac_samples_to_mix;
-            game_state.snd_lost_mix_time = num_frac_samples_to_mix - (float)num_samples_to_mix;
+            s32 num_samples_to_mix = (s32)(end_sample - game_state.snd_num_mixed);
+            game_state.snd_num_mixed = end_sample;
 
             game_state.audio_desc->mix_audio_for_one_frame(num_samples_to_mix);
         }
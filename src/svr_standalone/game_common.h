@@ -178,16 +178,21 @@ struct GameState
     ITaskbarList3* wind_taskbar_list; // The taskbar progress bar.
 
     s64 rec_num_frames; // Number of processed frames.
+    s64 rec_num_steps; // Number of frames at the game rate that the processed frames have covered. Can be more than the frames if frames are skipped.
+    SvrFrameSteps rec_frame_steps; // Steps that host_framerate was set to cover for the frames that are running.
     s64 rec_start_time; // Time of start for timing purposes.
     s32 rec_game_rate; // Frames per second the game is processing game at (includes motion blur).
     s32 rec_timeout; // After how many seconds to automatically end the movie.
     GameRecState rec_state; // Recording state tracking for autostop.
     bool rec_enable_autostop; // From start args: automatically stop on disconnect.
     bool rec_disable_window_update; // From start args: skip swap presentation.
+    bool rec_trace; // If a trace of this movie is being recorded.
+    char rec_trace_path[260]; // Where the trace of this movie is saved, without the extension.
 
     bool snd_is_painting; // Our signal to do specific paths during recording.
     bool snd_listener_underwater; // State variable from the engine.
-    float snd_lost_mix_time; // Time that was lost between the fps to sample rate conversion. This is added back next frame.
+    s64 snd_num_steps; // Number of frames at the game rate that audio has been mixed for.
+    s64 snd_num_mixed; // Number of samples that have been mixed. Always the samples for snd_num_steps rounded down, so nothing is lost between frames.
     s32 snd_num_samples; // Used by audio variant 2.
     s32 snd_skipped_samples; // The number of samples to submit must align to 4 sample boundaries, that means there may be samples over that we have to process in the next frame.
 };
@@ -209,6 +214,16 @@ bool game_wait_for_libs_to_load(const char** libs, s32 num, s32 timeout);
 // A start address can be specified to chain several pattern scans together.
 void* game_scan_pattern(const char* dll, const char* pattern, void* from);
 
+// Batches of patterns, so every module is only searched once for all the patterns in it.
+// Between begin and run, game_scan_pattern only remembers the patterns and returns NULL.
+// Between run and end, game_scan_pattern returns what was found for the remembered patterns without searching again.
+void game_scan_begin_batch();
+void game_scan_run_batch();
+void game_scan_end_batch();
+
+// For checking that a global that was found through code is in the data sections of the module.
+bool game_is_in_module_data(const char* dll, void* addr);
+
 // -----------------------------------------------
 // game_util.cpp:
 
@@ -319,6 +334,13 @@ void game_wind_reset();
 // -----------------------------------------------
 // game_rec.cpp:
 
+// How many svr_frame calls later a new host_framerate shows up.
+// The engine uses it from the next frame, and the result of that frame is given to svr_frame in the frame after.
+const s32 GAME_REC_FRAME_STEPS_AHEAD = 2;
+
+// The audio mixed in a frame is for the frame that the engine is running, which is given to svr_frame in the next frame.
+const s32 GAME_REC_AUDIO_STEPS_AHEAD = 1;
+
 void game_rec_init();
 void game_rec_update_timeout();
 void game_rec_update_recording_state();
@@ -327,6 +349,7 @@ void game_rec_show_start_movie_usage();
 void game_rec_start_movie(void* cmd_args);
 void game_rec_end_movie();
 bool game_rec_run_frame();
+void game_rec_update_frame_steps();
 void game_rec_do_record_frame();
 
 // -----------------------------------------------
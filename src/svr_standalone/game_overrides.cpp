@@ -1,6 +1,6 @@
 #include "game_priv.h"
 
-// Convert sample format and send.
+// The paint buffer is the mix before clipping, which is converted as it is sent.
 void game_prepare_and_send_sound_0(GameSndSample0* paint_buf, s32 num_samples)
 {
     if (!svr_is_audio_enabled())
@@ -8,15 +8,8 @@ void game_prepare_and_send_sound_0(GameSndSample0* paint_buf, s32 num_samples)
         return;
     }
 
-    SvrWaveSample* buf = (SvrWaveSample*)_alloca(sizeof(SvrWaveSample) * num_samples);
-
-    for (s32 i = 0; i < num_samples; i++)
-    {
-        GameSndSample0* sample = &paint_buf[i];
-        buf[i] = SvrWaveSample { (s16)sample->left, (s16)sample->right };
-    }
-
-    svr_give_audio(buf, num_samples);
+    // Same layout.
+    svr_give_audio_32((SvrWaveSample32*)paint_buf, num_samples);
 }
 
 // ----------------------------------------------------------------
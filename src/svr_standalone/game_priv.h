@@ -14,6 +14,12 @@
 #include <assert.h>
 #include <Psapi.h>
 #include "svr_prof.h"
+#include "svr_trace.h"
+#include "svr_simd.h"
+#include "svr_scan.h"
+#include "svr_scan_cache.h"
+#include "svr_pe.h"
+#include "svr_frame_steps.h"
 #include <Shlwapi.h>
 #include <d3d9.h>
 #include <ShlObj_core.h>
@@ -14,7 +14,7 @@ void game_rec_update_timeout()
     s64 end_frame = game_state.rec_timeout * game_state.rec_game_rate;
 
     // No more frames should be processed.
-    if (game_state.rec_num_frames >= end_frame)
+    if (game_state.rec_num_steps >= end_frame)
     {
         game_rec_end_movie();
     }
@@ -227,6 +227,8 @@ void game_rec_start_movie(void* cmd_args)
     startmovie_data.audio_params.audio_channels = game_state.search_desc.snd_num_channels;
     startmovie_data.audio_params.audio_hz = game_state.search_desc.snd_sample_rate;
     startmovie_data.audio_params.audio_bits = game_state.search_desc.snd_bit_depth;
+    startmovie_data.use_frame_steps = true;
+    startmovie_data.movie_length = game_state.rec_timeout;
 
     if (!svr_start(movie_name, profile_name, &startmovie_data))
     {
@@ -240,6 +242,7 @@ void game_rec_start_movie(void* cmd_args)
     game_state.rec_game_rate = svr_get_game_rate();
 
     game_engine_client_command(svr_va("host_framerate %d\n", game_state.rec_game_rate));
+    svr_frame_steps_init(&game_state.rec_frame_steps, game_state.rec_game_rate, GAME_REC_FRAME_STEPS_AHEAD);
 
     // Allow recording the next frame.
     game_state.rec_state = GAME_REC_WAITING;
@@ -247,12 +250,23 @@ void game_rec_start_movie(void* cmd_args)
     // Reset recording state.
 
     game_state.rec_num_frames = 0;
+    game_state.rec_num_steps = 0;
     game_state.rec_start_time = svr_prof_get_real_time();
 
     game_state.snd_skipped_samples = 0;
-    game_state.snd_lost_mix_time = 0.0f;
+    game_state.snd_num_steps = 0;
+    game_state.snd_num_mixed = 0;
     game_state.snd_num_samples = 0;
 
+    // Our trace goes next to the one that svr_game saves.
+    if (svr_is_trace_enabled())
+    {
+        SVR_SNPRINTF(game_state.rec_trace_path, "%s\\movies\\%s.svr_standalone", game_state.svr_path, movie_name);
+        svr_trace_set_thread_name("GAME THREAD");
+        svr_trace_start();
+        game_state.rec_trace = true;
+    }
+
     svr_console_msg_and_log("Starting movie to %s\n", movie_name);
 
     goto rexit;
@@ -284,8 +298,24 @@ void game_rec_end_movie()
 
     svr_console_msg_and_log("Ending movie after %0.2f seconds (%lld frames, %0.2f fps)\n", time_taken, game_state.rec_num_frames, fps);
 
+    if (game_state.rec_frame_steps.num_wrong > 0)
+    {
+        svr_console_msg_and_log("WARNING: %lld frames had another frame time than the motion blur expected\n", game_state.rec_frame_steps.num_wrong);
+    }
+
     svr_stop();
 
+    if (game_state.rec_trace)
+    {
+        svr_trace_stop();
+        game_state.rec_trace = false;
+
+        if (!svr_trace_save(game_state.rec_trace_path, "svr_standalone"))
+        {
+            svr_log("ERROR: Could not save trace to %s.json\n", game_state.rec_trace_path);
+        }
+    }
+
     game_run_cfgs_for_event("end");
 
     game_wind_reset();
@@ -305,11 +335,38 @@ bool game_rec_run_frame()
     return false;
 }
 
+// Sets how long the game frames are, so that frames that are not used by motion blur are skipped.
+void game_rec_update_frame_steps()
+{
+    s32 steps = svr_get_frame_steps(GAME_REC_FRAME_STEPS_AHEAD);
+
+    char cmd[64];
+
+    if (svr_frame_steps_set(&game_state.rec_frame_steps, steps, cmd, SVR_ARRAY_SIZE(cmd)))
+    {
+        game_engine_client_command(cmd);
+    }
+}
+
 void game_rec_do_record_frame()
 {
+    SVR_TRACE_SCOPE("record_frame");
+
+    game_rec_update_frame_steps();
+
     game_audio_frame();
     game_velo_frame();
 
+    s32 steps = svr_get_frame_steps(0);
+
+    // The frame time must be what the motion blur and the audio count with, or they go out of sync.
+    if (!svr_frame_steps_check(&game_state.rec_frame_steps, steps) && game_state.rec_frame_steps.num_wrong == 1)
+    {
+        svr_log("WARNING: Frame %lld covers %d steps but host_framerate was set for another time\n", game_state.rec_num_frames, steps);
+    }
+
+    game_state.rec_num_steps += steps;
+
     svr_frame();
 
     game_state.rec_num_frames++;
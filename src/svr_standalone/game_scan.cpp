@@ -2,116 +2,346 @@
 
 // Memory scanning.
 
-// How many bytes there can be in a pattern scan.
-const s32 GAME_MAX_SCAN_BYTES = 256;
+// A pattern that is searched for together with the other patterns of the same library.
+struct GameScanEntry
+{
+    const char* dll;
+    const char* pattern;
+    void* addr;
+    bool scanned;
+};
 
-struct GameScanPattern
+struct GameScanBatch
 {
-    // A value of -1 means unknown byte.
-    s16 bytes[GAME_MAX_SCAN_BYTES];
-    s16 used;
+    bool collecting; // Patterns are only remembered, not searched for.
+    SvrDynArray<GameScanEntry> entries;
 };
 
-bool game_is_hex_char(char c)
+GameScanBatch game_scan_batch;
+
+bool game_get_module_range(const char* dll, u8** start, s64* size)
 {
-    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F');
+    MODULEINFO info;
+
+    if (!GetModuleInformation(GetCurrentProcess(), GetModuleHandleA(dll), &info, sizeof(MODULEINFO)))
+    {
+        return false;
+    }
+
+    *start = (u8*)info.lpBaseOfDll;
+    *size = info.SizeOfImage;
+    return true;
 }
 
-void game_pattern_bytes_from_string(const char* input, GameScanPattern* out)
+// Code patterns can only be in the sections that can be executed, so the headers and data are not searched.
+// Returns the number of ranges, which are limited to start at the offset.
+s32 game_get_module_code_ranges(u8* start, s64 size, s64 offset, SvrScanRange* dest)
 {
-    const char* ptr = input;
-
-    out->used = 0;
+    SvrPeInfo info;
+    SvrPeRange pe_ranges[SVR_PE_MAX_SECTIONS];
 
-    for (; *ptr != 0; ptr++)
+    if (!svr_pe_read_info(start, size, &info))
     {
-        assert(out->used < GAME_MAX_SCAN_BYTES);
+        dest[0].start = offset;
+        dest[0].end = size;
+        return 1;
+    }
 
-        if (game_is_hex_char(*ptr))
-        {
-            assert(game_is_hex_char(*(ptr + 1))); // Next must be the next 4 bits.
+    s32 num_pe_ranges = svr_pe_get_ranges(&info, SVR_PE_RANGE_CODE, pe_ranges, SVR_PE_MAX_SECTIONS);
+    num_pe_ranges = svr_min(num_pe_ranges, SVR_PE_MAX_SECTIONS);
 
-            out->bytes[out->used] = strtol(ptr, NULL, 16);
-            out->used++;
-            ptr++;
-        }
+    s32 ret = 0;
 
-        else if (*ptr == '?')
-        {
-            assert(*(ptr + 1) == '?'); // Next must be question mark.
+    for (s32 i = 0; i < num_pe_ranges; i++)
+    {
+        SvrScanRange range;
+        range.start = svr_max((s64)pe_ranges[i].start, offset);
+        range.end = svr_min((s64)pe_ranges[i].end, size);
 
-            out->bytes[out->used] = -1;
-            out->used++;
-            ptr++;
+        if (range.start < range.end)
+        {
+            dest[ret] = range;
+            ret++;
         }
     }
 
-    assert(out->used > 0); // Must have written something.
+    return ret;
 }
 
-bool game_compare_data(u8* data, GameScanPattern* pattern)
+bool game_is_in_module_data(const char* dll, void* addr)
 {
-    s32 index = 0;
-    s16* bytes = pattern->bytes;
+    u8* start;
+    s64 size;
+    SvrPeInfo info;
+
+    if (!game_get_module_range(dll, &start, &size))
+    {
+        return false;
+    }
+
+    if ((u8*)addr < start || (u8*)addr >= start + size)
+    {
+        return false;
+    }
+
+    if (!svr_pe_read_info(start, size, &info))
+    {
+        return true; // Nothing more to tell.
+    }
+
+    const SvrPeSection* section = svr_pe_find_section(&info, (u32)((u8*)addr - start));
+
+    return section && svr_pe_is_section_type(section, SVR_PE_RANGE_DATA);
+}
 
-    for (s32 i = 0; i < pattern->used; i++)
+GameScanEntry* game_scan_find_entry(const char* dll, const char* pattern)
+{
+    for (s32 i = 0; i < game_scan_batch.entries.size; i++)
     {
-        s16 byte = *bytes;
+        GameScanEntry* entry = &game_scan_batch.entries[i];
 
-        if (byte > -1 && *data != byte)
+        if (!strcmp(entry->dll, dll) && !strcmp(entry->pattern, pattern))
         {
-            return false;
+            return entry;
         }
+    }
 
-        data++;
-        bytes++;
-        index++;
+    return NULL;
+}
+
+// The found addresses are kept between launches, so the libraries do not have to be searched again if the game has not been updated.
+void game_scan_load_cache(SvrScanCache* cache)
+{
+    char path[MAX_PATH];
+    SVR_SNPRINTF(path, "%s\\data\\scan_cache.bin", game_state.svr_path);
+
+    u8* mem = NULL;
+    DWORD num_read = 0;
+    LARGE_INTEGER size;
+
+    *cache = {};
+
+    HANDLE h = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (h == INVALID_HANDLE_VALUE)
+    {
+        goto rexit;
+    }
+
+    GetFileSizeEx(h, &size);
+
+    if (size.HighPart != 0 || size.LowPart > INT32_MAX)
+    {
+        goto rexit;
+    }
+
+    mem = (u8*)svr_alloc(size.LowPart);
+    ReadFile(h, mem, size.LowPart, &num_read, NULL);
+
+    if (!svr_scan_cache_read(cache, mem, num_read))
+    {
+        svr_log("Pattern cache is old or damaged and will be made again\n");
     }
 
-    return index == pattern->used;
+rexit:
+    if (mem)
+    {
+        svr_free(mem);
+    }
+
+    if (h != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(h);
+    }
 }
 
-void* game_find_pattern(void* start, s32 search_length, GameScanPattern* pattern)
+void game_scan_save_cache(SvrScanCache* cache)
 {
-    s16 length = pattern->used;
+    char path[MAX_PATH];
+    SVR_SNPRINTF(path, "%s\\data\\scan_cache.bin", game_state.svr_path);
+
+    SvrDynArray<u8> data = {};
+    svr_scan_cache_write(cache, &data);
 
-    for (s32 i = 0; i <= search_length - length; i++)
+    HANDLE h = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (h != INVALID_HANDLE_VALUE)
     {
-        u8* addr = (u8*)start + i;
+        WriteFile(h, data.mem, data.size, NULL, NULL);
+        CloseHandle(h);
+    }
 
-        if (game_compare_data(addr, pattern))
+    else
+    {
+        svr_log("Could not write pattern cache %s (%lu)\n", path, GetLastError());
+    }
+
+    data.free();
+}
+
+void game_scan_begin_batch()
+{
+    game_scan_batch.entries.init(64);
+    game_scan_batch.collecting = true;
+}
+
+void game_scan_run_batch()
+{
+    SvrSimdLevel level = svr_simd_get_best_level();
+
+    SvrDynArray<SvrScanPattern> patterns = {};
+    SvrDynArray<GameScanEntry*> pattern_entries = {};
+    SvrDynArray<s64> offsets = {};
+
+    SvrScanCache cache;
+    game_scan_load_cache(&cache);
+
+    game_scan_batch.collecting = false;
+
+    // Every library is searched once for all of its patterns.
+    for (s32 i = 0; i < game_scan_batch.entries.size; i++)
+    {
+        const char* dll = game_scan_batch.entries[i].dll;
+
+        if (game_scan_batch.entries[i].scanned)
         {
-            return addr;
+            continue;
         }
+
+        patterns.size = 0;
+        pattern_entries.size = 0;
+
+        for (s32 j = i; j < game_scan_batch.entries.size; j++)
+        {
+            GameScanEntry* entry = &game_scan_batch.entries[j];
+
+            if (entry->scanned || strcmp(entry->dll, dll))
+            {
+                continue;
+            }
+
+            entry->scanned = true;
+
+            SvrScanPattern pattern;
+
+            if (!svr_scan_compile_pattern(entry->pattern, &pattern))
+            {
+                svr_log("Invalid pattern %s\n", entry->pattern);
+                continue;
+            }
+
+            patterns.push(pattern);
+            pattern_entries.push(entry);
+        }
+
+        u8* start;
+        s64 size;
+
+        // Module is not loaded. Not an error because we allow fallthrough scanning of multiple patterns.
+        if (!game_get_module_range(dll, &start, &size))
+        {
+            continue;
+        }
+
+        offsets.expand_if_needed(patterns.size);
+
+        SvrScanRange ranges[SVR_PE_MAX_SECTIONS];
+        s32 num_ranges = game_get_module_code_ranges(start, size, 0, ranges);
+
+        s64 scan_start = svr_prof_get_real_time();
+        s32 num_cached = svr_scan_find_all_cached(&cache, dll, start, size, ranges, num_ranges, patterns.mem, patterns.size, offsets.mem, level);
+        s64 scan_end = svr_prof_get_real_time();
+
+        for (s32 j = 0; j < patterns.size; j++)
+        {
+            if (offsets.mem[j] != -1)
+            {
+                pattern_entries[j]->addr = start + offsets.mem[j];
+            }
+        }
+
+        svr_log("Found %d patterns in %s in %lld us (%d from cache)\n", patterns.size, dll, scan_end - scan_start, num_cached);
     }
 
-    return NULL;
+    if (cache.changed)
+    {
+        game_scan_save_cache(&cache);
+    }
+
+    svr_scan_cache_free(&cache);
+    patterns.free();
+    pattern_entries.free();
+    offsets.free();
+}
+
+void game_scan_end_batch()
+{
+    game_scan_batch.entries.free();
+    game_scan_batch.collecting = false;
 }
 
 void* game_scan_pattern(const char* dll, const char* pattern, void* from)
 {
-    MODULEINFO info;
+    if (from == NULL)
+    {
+        GameScanEntry* entry = game_scan_find_entry(dll, pattern);
 
-    if (!GetModuleInformation(GetCurrentProcess(), GetModuleHandleA(dll), &info, sizeof(MODULEINFO)))
+        if (game_scan_batch.collecting)
+        {
+            if (entry == NULL)
+            {
+                GameScanEntry new_entry = {};
+                new_entry.dll = dll;
+                new_entry.pattern = pattern;
+                game_scan_batch.entries.push(new_entry);
+            }
+
+            return NULL;
+        }
+
+        if (entry && entry->scanned)
+        {
+            return entry->addr;
+        }
+    }
+
+    u8* start;
+    s64 size;
+
+    if (!game_get_module_range(dll, &start, &size))
     {
         // Module is not loaded. Not an error because we allow fallthrough scanning of multiple patterns.
         return NULL;
     }
 
-    GameScanPattern pattern_bytes = {};
-    game_pattern_bytes_from_string(pattern, &pattern_bytes);
+    SvrScanPattern pattern_bytes;
 
-    if (from == NULL)
+    if (!svr_scan_compile_pattern(pattern, &pattern_bytes))
     {
-        from = info.lpBaseOfDll;
+        assert(false);
+        return NULL;
     }
 
-    else
+    s64 offset = 0;
+
+    if (from)
     {
         // Start address must be in range of the module.
-        assert(((u8*)from >= info.lpBaseOfDll) && (u8*)from < ((u8*)info.lpBaseOfDll + info.SizeOfImage));
+        assert(((u8*)from >= start) && (u8*)from < (start + size));
+
+        offset = (u8*)from - start;
     }
 
-    void* ret = game_find_pattern(from, info.SizeOfImage, &pattern_bytes);
-    return ret;
+    SvrScanRange ranges[SVR_PE_MAX_SECTIONS];
+    s32 num_ranges = game_get_module_code_ranges(start, size, offset, ranges);
+
+    s64 found;
+    svr_scan_find_all_in_ranges(start, ranges, num_ranges, &pattern_bytes, 1, &found, svr_simd_get_best_level());
+
+    if (found == -1)
+    {
+        return NULL;
+    }
+
+    return start + found;
 }
@@ -55,6 +55,12 @@ GameFnProxy game_get_snd_paint_time_proxy_2()
     addr += 2;
     addr = (u8*)game_follow_displacement(addr, 4);
 
+    // Globals must be in the data of the module, or the pattern was found in the wrong place.
+    if (!game_is_in_module_data("engine.dll", addr))
+    {
+        return {};
+    }
+
     GameFnProxy px;
     px.target = addr;
     px.proxy = game_paint_time_proxy_1;
@@ -135,6 +141,11 @@ GameFnProxy game_get_snd_get_paint_buffer_proxy_0()
     addr += 3;
     addr = (u8*)game_follow_displacement(addr, 4);
 
+    if (!game_is_in_module_data("engine.dll", addr))
+    {
+        return {};
+    }
+
     GameFnProxy px;
     px.target = addr;
     px.proxy = game_paint_buffer_proxy_1;
@@ -411,6 +422,11 @@ GameFnProxy game_get_signon_state_proxy_1()
     addr += 2;
     addr = (u8*)game_follow_displacement(addr, 8);
 
+    if (!game_is_in_module_data("engine.dll", addr))
+    {
+        return {};
+    }
+
     GameFnProxy px;
     px.target = addr;
     px.proxy = game_signon_state_proxy_1;
@@ -478,6 +494,11 @@ GameFnProxy game_get_local_player_proxy_1()
     addr += 3;
     addr = (u8*)game_follow_displacement(addr, 4);
 
+    if (!game_is_in_module_data("client.dll", addr))
+    {
+        return {};
+    }
+
     GameFnProxy px;
     px.target = addr;
     px.proxy = game_local_player_proxy_1;
@@ -539,6 +560,11 @@ GameFnProxy game_get_d3d9ex_device_proxy_1()
     addr += 3;
     addr = (u8*)game_follow_displacement(addr, 4);
 
+    if (!game_is_in_module_data("shaderapidx9.dll", addr))
+    {
+        return {};
+    }
+
     GameFnProxy px;
     px.target = addr;
     px.proxy = game_d3d9ex_device_proxy_1;
@@ -1030,6 +1056,29 @@ GameFnProxy game_select_opts(GameProxyOpt* opts, s32 num, const char* array_name
     return {};
 }
 
+// Runs the options only to remember their patterns, so they can all be found with one search per library.
+void game_collect_opts(GameOverrideOpt* opts, s32 num)
+{
+    for (s32 i = 0; i < num; i++)
+    {
+        if (opts[i].cond)
+        {
+            opts[i].func();
+        }
+    }
+}
+
+void game_collect_opts(GameProxyOpt* opts, s32 num)
+{
+    for (s32 i = 0; i < num; i++)
+    {
+        if (opts[i].cond)
+        {
+            opts[i].func();
+        }
+    }
+}
+
 bool game_lib_already_added(SvrDynArray<const char*>* libs, const char* test)
 {
     for (s32 i = 0; i < libs->size; i++)
@@ -1169,6 +1218,33 @@ void game_search_fill_desc(GameSearchDesc* desc)
 #define ALL_TRUE(OPTS) svr_check_all_true(OPTS, SVR_ARRAY_SIZE(OPTS))
 #define ANY_TRUE(OPTS) svr_check_one_true(OPTS, SVR_ARRAY_SIZE(OPTS))
 #define SELECT_CAPS(OPTS) game_select_caps(OPTS, SVR_ARRAY_SIZE(OPTS))
+#define COLLECT_OPT(OPTS) game_collect_opts(OPTS, SVR_ARRAY_SIZE(OPTS))
+
+    // Remember the patterns of every option first so each library is only searched once.
+    // The options are then selected like normal with the found addresses.
+
+    game_scan_begin_batch();
+
+    COLLECT_OPT(GAME_START_MOVIE_OVERRIDES);
+    COLLECT_OPT(GAME_END_MOVIE_OVERRIDES);
+    COLLECT_OPT(GAME_FILTER_TIME_OVERRIDES);
+    COLLECT_OPT(GAME_CVAR_RESTRICT_PROXIES);
+    COLLECT_OPT(GAME_ENGINE_CLIENT_COMMAND_PROXIES);
+    COLLECT_OPT(GAME_CMD_ARGS_PROXIES);
+    COLLECT_OPT(GAME_D3D9EX_DEVICE_PTR_PROXIES);
+    COLLECT_OPT(GAME_ENTITY_VELOCITY_PROXIES);
+    COLLECT_OPT(GAME_PLAYER_BY_INDEX_PROXIES);
+    COLLECT_OPT(GAME_SPEC_TARGET_PROXIES);
+    COLLECT_OPT(GAME_LOCAL_PLAYER_PROXIES);
+    COLLECT_OPT(GAME_SPEC_TARGET_OR_LOCAL_PLAYER_PROXIES);
+    COLLECT_OPT(GAME_SND_PAINT_TIME_PROXIES);
+    COLLECT_OPT(GAME_SND_PAINT_CHANS_OVERRIDES);
+    COLLECT_OPT(GAME_SND_TX_STEREO_OVERRIDES);
+    COLLECT_OPT(GAME_SND_DEVICE_TX_SAMPLES_OVERRIDES);
+    COLLECT_OPT(GAME_SND_PAINT_BUFFER_PROXIES);
+    COLLECT_OPT(GAME_SIGNON_STATE_PROXIES);
+
+    game_scan_run_batch();
 
     // Core required:
     desc->start_movie_override = SELECT_OPT(GAME_START_MOVIE_OVERRIDES);
@@ -1322,4 +1398,7 @@ void game_search_fill_desc(GameSearchDesc* desc)
 #undef ALL_TRUE
 #undef ANY_TRUE
 #undef SELECT_CAPS
+#undef COLLECT_OPT
+
+    game_scan_end_batch();
 }
@@ -0,0 +1,224 @@
+#include "tests_priv.h"
+#include "svr_color.h"
+#include "svr_work_pool.h"
+#include <stdlib.h>
+
+// Tests of the processor color conversion against a float version of tex2vid.hlsl.
+// The fixed point math may be off by one from the float math, but all SIMD levels must give exactly the same result.
+
+const s32 TESTS_COLOR_SIZES[][2] =
+{
+    { 64, 32 },
+    { 33, 17 }, // Odd sizes repeat the edge and leave tails for the scalar level.
+    { 1, 1 },
+    { 250, 9 },
+};
+
+// Same as convert_rgb_to_yuv in tex2vid.hlsl with AVCOL_SPC_BT709.
+static void tests_color_reference(float b, float g, float r, s32* y, s32* u, s32* v)
+{
+    r /= 1.164383f;
+    g /= 1.164383f;
+    b /= 1.164383f;
+
+    *y = (s32)(16 + (r * +0.212600f) + (g * +0.715200f) + (b * +0.072200f));
+    *u = (s32)(128 + (r * -0.114572f) + (g * -0.385428f) + (b * +0.500000f));
+    *v = (s32)(128 + (r * +0.500000f) + (g * -0.454153f) + (b * -0.045847f));
+}
+
+struct TestsColorImage
+{
+    u8* planes[3];
+    s32 pitches[3];
+};
+
+static void tests_color_alloc_image(TestsColorImage* image, SvrPixelFormat format, s32 width, s32 height)
+{
+    for (s32 i = 0; i < svr_color_get_num_planes(format); i++)
+    {
+        SvrVec2I size = svr_color_get_plane_size(format, i, width, height);
+        image->pitches[i] = size.x + 7; // Pitches that are not a multiple of the vector size.
+        image->planes[i] = (u8*)svr_zalloc(image->pitches[i] * size.y);
+    }
+}
+
+static void tests_color_free_image(TestsColorImage* image, SvrPixelFormat format)
+{
+    for (s32 i = 0; i < svr_color_get_num_planes(format); i++)
+    {
+        svr_free(image->planes[i]);
+    }
+}
+
+static void tests_color_convert(SvrPixelFormat format, s32 width, s32 height, const u8* src, s32 src_pitch, TestsColorImage* image, SvrSimdLevel level, SvrWorkPool* pool)
+{
+    SvrColorConversion conv = {};
+    conv.format = format;
+    conv.width = width;
+    conv.height = height;
+    conv.src = src;
+    conv.src_pitch = src_pitch;
+
+    for (s32 i = 0; i < 3; i++)
+    {
+        conv.planes[i] = image->planes[i];
+        conv.pitches[i] = image->pitches[i];
+    }
+
+    svr_color_convert(&conv, level, pool);
+}
+
+static bool tests_color_near(s32 a, s32 b)
+{
+    return abs(a - b) <= 1;
+}
+
+// Checks the scalar result against the float reference. Returns the number of samples that are off by more than one.
+static s32 tests_color_check_reference(SvrPixelFormat format, s32 width, s32 height, const u8* src, s32 src_pitch, TestsColorImage* image)
+{
+    s32 num_wrong = 0;
+
+    // Size of the area that one chroma sample covers.
+    s32 cw = (format == SVR_PIXEL_FORMAT_YUV444P) ? 1 : 2;
+    s32 ch = (format == SVR_PIXEL_FORMAT_NV12) ? 2 : 1;
+
+    for (s32 y = 0; y < height; y++)
+    {
+        for (s32 x = 0; x < width; x++)
+        {
+            const u8* px = src + y * src_pitch + x * 4;
+
+            s32 ry, ru, rv;
+            tests_color_reference(px[0], px[1], px[2], &ry, &ru, &rv);
+
+            num_wrong += !tests_color_near(image->planes[0][y * image->pitches[0] + x], ry);
+
+            if ((x % cw) != 0 || (y % ch) != 0)
+            {
+                continue;
+            }
+
+            // Average like load_average in the shader, which repeats the last row and column.
+            s32 last_x = svr_min(x + cw - 1, width - 1);
+            s32 last_y = svr_min(y + ch - 1, height - 1);
+
+            const u8* corners[4] =
+            {
+                px,
+                src + y * src_pitch + last_x * 4,
+                src + last_y * src_pitch + x * 4,
+                src + last_y * src_pitch + last_x * 4,
+            };
+
+            float sum[3] = {};
+
+            for (s32 i = 0; i < 4; i++)
+            {
+                for (s32 c = 0; c < 3; c++)
+                {
+                    sum[c] += corners[i][c];
+                }
+            }
+
+            tests_color_reference(sum[0] * 0.25f, sum[1] * 0.25f, sum[2] * 0.25f, &ry, &ru, &rv);
+
+            s32 cx = x / cw;
+            s32 cy = y / ch;
+
+            if (format == SVR_PIXEL_FORMAT_NV12)
+            {
+                u8* uv = image->planes[1] + cy * image->pitches[1] + cx * 2;
+                num_wrong += !tests_color_near(uv[0], ru);
+                num_wrong += !tests_color_near(uv[1], rv);
+            }
+
+            else
+            {
+                num_wrong += !tests_color_near(image->planes[1][cy * image->pitches[1] + cx], ru);
+                num_wrong += !tests_color_near(image->planes[2][cy * image->pitches[2] + cx], rv);
+            }
+        }
+    }
+
+    return num_wrong;
+}
+
+static bool tests_color_same_image(SvrPixelFormat format, s32 width, s32 height, TestsColorImage* a, TestsColorImage* b)
+{
+    for (s32 i = 0; i < svr_color_get_num_planes(format); i++)
+    {
+        SvrVec2I size = svr_color_get_plane_size(format, i, width, height);
+
+        for (s32 y = 0; y < size.y; y++)
+        {
+            if (memcmp(a->planes[i] + y * a->pitches[i], b->planes[i] + y * b->pitches[i], size.x))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static void tests_color_format(SvrPixelFormat format, s32 width, s32 height, SvrWorkPool* pool)
+{
+    s32 src_pitch = width * 4 + 12;
+    u8* src = (u8*)svr_alloc(src_pitch * height);
+
+    // Random pixels, with the extremes of every channel at the start.
+    srand(width * 1000 + height);
+
+    for (s32 i = 0; i < src_pitch * height; i++)
+    {
+        src[i] = (u8)rand();
+    }
+
+    for (s32 i = 0; i < svr_min(width * height, 8); i++)
+    {
+        u8* px = src + (i / width) * src_pitch + (i % width) * 4;
+        px[0] = (i & 1) ? 255 : 0;
+        px[1] = (i & 2) ? 255 : 0;
+        px[2] = (i & 4) ? 255 : 0;
+    }
+
+    TestsColorImage scalar = {};
+    tests_color_alloc_image(&scalar, format, width, height);
+    tests_color_convert(format, width, height, src, src_pitch, &scalar, SVR_SIMD_SCALAR, NULL);
+
+    TEST_CHECK(tests_color_check_reference(format, width, height, src, src_pitch, &scalar) == 0);
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR + 1; level <= svr_simd_get_best_level(); level++)
+    {
+        TestsColorImage image = {};
+        tests_color_alloc_image(&image, format, width, height);
+
+        tests_color_convert(format, width, height, src, src_pitch, &image, level, NULL);
+        TEST_CHECK(tests_color_same_image(format, width, height, &scalar, &image));
+
+        tests_color_convert(format, width, height, src, src_pitch, &image, level, pool);
+        TEST_CHECK(tests_color_same_image(format, width, height, &scalar, &image));
+
+        tests_color_free_image(&image, format);
+    }
+
+    tests_color_free_image(&scalar, format);
+    svr_free(src);
+}
+
+void tests_color()
+{
+    SvrWorkPool* pool = svr_work_pool_create(3);
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(TESTS_COLOR_SIZES); i++)
+    {
+        s32 width = TESTS_COLOR_SIZES[i][0];
+        s32 height = TESTS_COLOR_SIZES[i][1];
+
+        tests_color_format(SVR_PIXEL_FORMAT_NV12, width, height, pool);
+        tests_color_format(SVR_PIXEL_FORMAT_YUV422P, width, height, pool);
+        tests_color_format(SVR_PIXEL_FORMAT_YUV444P, width, height, pool);
+    }
+
+    svr_work_pool_free(pool);
+}
@@ -0,0 +1,139 @@
+#include "tests_priv.h"
+#include "svr_copy.h"
+#include "svr_work_pool.h"
+
+// Tests of the plane copy with sizes and offsets that leave unaligned heads and tails for the streaming stores.
+
+const u8 TESTS_COPY_PADDING = 0xcd; // Bytes after the row size in the destination must keep this.
+
+struct TestsCopyCase
+{
+    s32 row_size;
+    s32 num_rows;
+    s32 src_offset; // From an aligned address.
+    s32 dest_offset;
+};
+
+const TestsCopyCase TESTS_COPY_CASES[] =
+{
+    TestsCopyCase { 1920, 16, 0, 0 },
+    TestsCopyCase { 1921, 7, 3, 5 },
+    TestsCopyCase { 15, 3, 1, 9 },
+    TestsCopyCase { 1, 1, 0, 1 },
+    TestsCopyCase { 100, 33, 7, 0 },
+};
+
+enum
+{
+    TESTS_COPY_CALLING_THREAD,
+    TESTS_COPY_PARALLEL,
+    TESTS_COPY_START_WAIT,
+};
+
+static void tests_copy_case(const TestsCopyCase* test, SvrSimdLevel level, s32 mode, SvrWorkPool* pool)
+{
+    const s32 NUM_PLANES = 3;
+
+    SvrCopyJob job = {};
+    job.num_planes = NUM_PLANES;
+    job.level = level;
+
+    u8* src_bufs[NUM_PLANES];
+    u8* dest_bufs[NUM_PLANES];
+
+    for (s32 i = 0; i < NUM_PLANES; i++)
+    {
+        SvrPlaneCopy* plane = &job.planes[i];
+
+        // Later planes are smaller like chroma planes.
+        plane->row_size = svr_max(1, test->row_size >> i);
+        plane->num_rows = svr_max(1, test->num_rows >> i);
+        plane->src_pitch = plane->row_size + 13;
+        plane->dest_pitch = plane->row_size + 64;
+
+        s32 src_size = plane->src_pitch * plane->num_rows + test->src_offset;
+        s32 dest_size = plane->dest_pitch * plane->num_rows + test->dest_offset;
+
+        src_bufs[i] = (u8*)svr_align_alloc(src_size, 64);
+        dest_bufs[i] = (u8*)svr_align_alloc(dest_size, 64);
+
+        for (s32 j = 0; j < src_size; j++)
+        {
+            src_bufs[i][j] = (u8)(j * 31 + i);
+        }
+
+        memset(dest_bufs[i], TESTS_COPY_PADDING, dest_size);
+
+        plane->src = src_bufs[i] + test->src_offset;
+        plane->dest = dest_bufs[i] + test->dest_offset;
+    }
+
+    switch (mode)
+    {
+        case TESTS_COPY_CALLING_THREAD:
+        {
+            svr_copy_planes(&job);
+            break;
+        }
+
+        case TESTS_COPY_PARALLEL:
+        {
+            svr_copy_planes_parallel(&job, pool);
+            break;
+        }
+
+        case TESTS_COPY_START_WAIT:
+        {
+            svr_copy_start(&job, pool);
+            svr_copy_wait(pool);
+            break;
+        }
+    }
+
+    s32 num_wrong = 0;
+
+    for (s32 i = 0; i < NUM_PLANES; i++)
+    {
+        SvrPlaneCopy* plane = &job.planes[i];
+
+        for (s32 j = 0; j < test->dest_offset; j++)
+        {
+            num_wrong += dest_bufs[i][j] != TESTS_COPY_PADDING;
+        }
+
+        for (s32 y = 0; y < plane->num_rows; y++)
+        {
+            const u8* src_row = plane->src + y * plane->src_pitch;
+            const u8* dest_row = plane->dest + y * plane->dest_pitch;
+
+            num_wrong += memcmp(src_row, dest_row, plane->row_size) != 0;
+
+            for (s32 x = plane->row_size; x < plane->dest_pitch; x++)
+            {
+                num_wrong += dest_row[x] != TESTS_COPY_PADDING;
+            }
+        }
+
+        svr_align_free(src_bufs[i], 64);
+        svr_align_free(dest_bufs[i], 64);
+    }
+
+    TEST_CHECK(num_wrong == 0);
+}
+
+void tests_copy()
+{
+    SvrWorkPool* pool = svr_work_pool_create(3);
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(TESTS_COPY_CASES); i++)
+    {
+        for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+        {
+            tests_copy_case(&TESTS_COPY_CASES[i], level, TESTS_COPY_CALLING_THREAD, pool);
+            tests_copy_case(&TESTS_COPY_CASES[i], level, TESTS_COPY_PARALLEL, pool);
+            tests_copy_case(&TESTS_COPY_CASES[i], level, TESTS_COPY_START_WAIT, pool);
+        }
+    }
+
+    svr_work_pool_free(pool);
+}
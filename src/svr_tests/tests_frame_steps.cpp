@@ -0,0 +1,208 @@
+#include "tests_priv.h"
+#include "svr_frame_steps.h"
+#include "svr_mosample.h"
+#include <stdlib.h>
+#include <math.h>
+
+// Tests that the frames given to svr_frame cover the time that the motion blur schedule expects.
+// The engine is modelled like the Source engine that svr_standalone records: a frame gets its time from host_framerate when it starts,
+// the recording hook runs and queues console commands, and the commands run after that so they are used from the next frame.
+// The result of a frame is given to svr_frame in the hook of the frame after, so a new host_framerate shows up two svr_frame calls later.
+
+const s32 TESTS_FRAME_STEPS_ENGINE_LATENCY = 2;
+const s32 TESTS_FRAME_STEPS_VIDEO_FPS = 60;
+const s32 TESTS_FRAME_STEPS_VIDEO_FRAMES = 300;
+
+struct TestsFrameStepsEngine
+{
+    double host_framerate; // Console variable.
+    char queued_cmd[64]; // Command buffer, empty if nothing is queued.
+    double frame_time; // Time of the frame that is running.
+    double prev_frame_time; // Time of the frame that is given to svr_frame next.
+};
+
+static void tests_frame_steps_run_cmd(TestsFrameStepsEngine* engine)
+{
+    if (engine->queued_cmd[0] == 0)
+    {
+        return;
+    }
+
+    const char* prefix = "host_framerate ";
+    TEST_CHECK(!strncmp(engine->queued_cmd, prefix, strlen(prefix)));
+
+    engine->host_framerate = strtod(engine->queued_cmd + strlen(prefix), NULL);
+    engine->queued_cmd[0] = 0;
+}
+
+struct TestsFrameStepsResult
+{
+    s64 num_wrong_times; // Frames that the engine ran with another time than the schedule.
+    s64 num_wrong_checks; // Frames that svr_frame_steps_check saw as wrong.
+};
+
+// Records a movie with the game setting the steps this many frames ahead.
+// The start frames can be turned off to see what happens if the schedule skips before the game can set host_framerate.
+static TestsFrameStepsResult tests_frame_steps_record(SvrMosampleShutter* shutters, s32 num_shutters, bool skip_closed, s32 frames_ahead, bool use_start_frames)
+{
+    SvrMosampleSchedule sched;
+    TEST_CHECK(svr_mosample_schedule_init(&sched, shutters, num_shutters, skip_closed));
+
+    if (!use_start_frames)
+    {
+        sched.num_fixed = 0;
+    }
+
+    s32 game_rate = TESTS_FRAME_STEPS_VIDEO_FPS * sched.mult;
+    s64 end_steps = (s64)TESTS_FRAME_STEPS_VIDEO_FRAMES * sched.mult;
+
+    // The movie is started from a console command, so the rate is set before the first frame that is recorded.
+    TestsFrameStepsEngine engine = {};
+    engine.host_framerate = game_rate;
+    engine.prev_frame_time = 1.0 / engine.host_framerate;
+
+    SvrFrameSteps fs;
+    svr_frame_steps_init(&fs, game_rate, frames_ahead);
+
+    s64 num_steps = 0;
+    s64 num_frames = 0;
+    s64 num_wrong_times = 0;
+    double total_time = 0.0;
+
+    while (num_steps < end_steps)
+    {
+        engine.frame_time = 1.0 / engine.host_framerate;
+
+        // Recording hook, like game_rec_do_record_frame.
+
+        char cmd[64];
+
+        if (svr_frame_steps_set(&fs, svr_mosample_schedule_get_steps(&sched, frames_ahead), cmd, SVR_ARRAY_SIZE(cmd)))
+        {
+            SVR_COPY_STRING(cmd, engine.queued_cmd);
+        }
+
+        s32 steps = svr_mosample_schedule_get_steps(&sched, 0);
+        svr_frame_steps_check(&fs, steps);
+
+        // Every frame must be exact to the rounding of a double, or the error adds up over the movie.
+        if (fabs(engine.prev_frame_time * game_rate - steps) > steps * 1e-12)
+        {
+            num_wrong_times++;
+        }
+
+        SvrMosampleScheduleStep sched_step;
+        svr_mosample_schedule_step(&sched, &sched_step);
+
+        TEST_CHECK(sched_step.num_steps == steps);
+
+        // The first frames were started before the game could set their steps.
+        if (use_start_frames && num_frames < SVR_MOSAMPLE_START_FRAMES)
+        {
+            TEST_CHECK(steps == 1);
+        }
+
+        num_steps += steps;
+        num_frames++;
+        total_time += engine.prev_frame_time;
+
+        tests_frame_steps_run_cmd(&engine);
+
+        engine.prev_frame_time = engine.frame_time;
+    }
+
+    TEST_CHECK(num_steps == end_steps);
+    TEST_CHECK(fs.num_frames == num_frames);
+
+    // The whole movie must also come out at the length of the video frames.
+    if (num_wrong_times == 0)
+    {
+        TEST_CHECK(fabs(total_time - (double)TESTS_FRAME_STEPS_VIDEO_FRAMES / TESTS_FRAME_STEPS_VIDEO_FPS) < 1e-9);
+    }
+
+    // Skipping must make fewer game frames, otherwise this does not test anything.
+    if (skip_closed)
+    {
+        TEST_CHECK(num_frames < end_steps);
+    }
+
+    TestsFrameStepsResult res;
+    res.num_wrong_times = num_wrong_times;
+    res.num_wrong_checks = fs.num_wrong;
+    return res;
+}
+
+// Records a movie where the game sets the steps with the latency of the engine, where every frame must be right.
+static void tests_frame_steps_record_right(SvrMosampleShutter* shutters, s32 num_shutters, bool skip_closed)
+{
+    TestsFrameStepsResult res = tests_frame_steps_record(shutters, num_shutters, skip_closed, TESTS_FRAME_STEPS_ENGINE_LATENCY, true);
+
+    TEST_CHECK(res.num_wrong_times == 0);
+    TEST_CHECK(res.num_wrong_checks == 0);
+}
+
+static void tests_frame_steps_cmd()
+{
+    SvrFrameSteps fs;
+    svr_frame_steps_init(&fs, 3600, TESTS_FRAME_STEPS_ENGINE_LATENCY);
+
+    char cmd[64];
+
+    // Nothing to change when the steps stay at the rate that the movie starts with.
+    TEST_CHECK(!svr_frame_steps_set(&fs, 1, cmd, SVR_ARRAY_SIZE(cmd)));
+
+    TEST_CHECK(svr_frame_steps_set(&fs, 31, cmd, SVR_ARRAY_SIZE(cmd)));
+    TEST_CHECK(strtod(cmd + strlen("host_framerate "), NULL) == 3600.0 / 31.0);
+
+    TEST_CHECK(!svr_frame_steps_set(&fs, 31, cmd, SVR_ARRAY_SIZE(cmd)));
+
+    TEST_CHECK(svr_frame_steps_set(&fs, 1, cmd, SVR_ARRAY_SIZE(cmd)));
+    TEST_CHECK(!strcmp(cmd, "host_framerate 3600\n"));
+
+    // Every rate must read back as the same double.
+    for (s32 rate = 1; rate <= 7200; rate += 7)
+    {
+        for (s32 steps = 2; steps <= 64; steps++)
+        {
+            svr_frame_steps_init(&fs, rate, TESTS_FRAME_STEPS_ENGINE_LATENCY);
+            svr_frame_steps_set(&fs, steps, cmd, SVR_ARRAY_SIZE(cmd));
+
+            double value = strtod(cmd + strlen("host_framerate "), NULL);
+
+            if (value != (double)rate / (double)steps)
+            {
+                TEST_CHECK(value == (double)rate / (double)steps);
+                return;
+            }
+        }
+    }
+}
+
+void tests_frame_steps()
+{
+    tests_frame_steps_cmd();
+
+    SvrMosampleShutter shutters[] =
+    {
+        SvrMosampleShutter { 60, 0.5f },
+        SvrMosampleShutter { 40, 0.25f },
+    };
+
+    tests_frame_steps_record_right(shutters, 1, false);
+    tests_frame_steps_record_right(shutters, 1, true);
+    tests_frame_steps_record_right(shutters, 2, false);
+    tests_frame_steps_record_right(shutters, 2, true);
+
+    SvrMosampleShutter odd_shutter = { 7, 0.3f };
+    tests_frame_steps_record_right(&odd_shutter, 1, true);
+
+    // Without the start frames the schedule wants longer frames than the engine is already running, which the check must see.
+    TestsFrameStepsResult res = tests_frame_steps_record(shutters, 1, true, TESTS_FRAME_STEPS_ENGINE_LATENCY, false);
+    TEST_CHECK(res.num_wrong_times > 0);
+    TEST_CHECK(res.num_wrong_checks == res.num_wrong_times);
+
+    // The check can only see what the game was told, so a game that has the latency wrong is only seen in the frame times.
+    // This is why GAME_REC_FRAME_STEPS_AHEAD must match the engine.
+    res = tests_frame_steps_record(shutters, 1, true, TESTS_FRAME_STEPS_ENGINE_LATENCY - 1, true);
+    TEST_CHECK(res.num_wrong_times > 0);
+}
@@ -0,0 +1,228 @@
+#include "tests_priv.h"
+#include "svr_glyphs.h"
+#include <stdlib.h>
+#include <math.h>
+
+// Tests of drawing digits from a glyph atlas with random coverage.
+// All levels must give the same pixels, the blend must be within 1 of a float blend, and nothing outside the frame
+// or the text may be touched.
+
+const s32 TESTS_GLYPHS_WIDTH = 67;
+const s32 TESTS_GLYPHS_HEIGHT = 29;
+const s32 TESTS_GLYPHS_PITCH = TESTS_GLYPHS_WIDTH * 4 + 12; // Padding that must never be written.
+const s32 TESTS_GLYPHS_SIZE = TESTS_GLYPHS_PITCH * TESTS_GLYPHS_HEIGHT;
+
+static void tests_glyphs_make_atlas(SvrGlyphAtlas* atlas, bool has_border)
+{
+    SvrVec2I origin = { 2, 14 };
+    svr_glyph_create_atlas(atlas, 13, 18, origin, 11.4f, has_border);
+
+    s32 size = svr_glyph_get_atlas_pitch(atlas) * atlas->cell_height;
+
+    // Runs of zero coverage too, so the skipped blocks of the SIMD level are used.
+    for (s32 i = 0; i < size; i++)
+    {
+        atlas->fill[i] = (rand() % 3 == 0) ? 0 : (u8)rand();
+
+        if (has_border)
+        {
+            atlas->border[i] = (rand() % 3 == 0) ? 0 : (u8)rand();
+        }
+    }
+}
+
+static void tests_glyphs_make_frame(u8* frame)
+{
+    for (s32 i = 0; i < TESTS_GLYPHS_SIZE; i++)
+    {
+        frame[i] = (u8)rand();
+    }
+}
+
+// Float version of blending one layer of one digit.
+static void tests_glyphs_reference(SvrGlyphAtlas* atlas, const u8* cells, s32 digit, s32 x0, s32 y0, SvrVec4I color, u8* frame)
+{
+    float channels[4] = { (float)color.z, (float)color.y, (float)color.x, 255.0f };
+    s32 pitch = svr_glyph_get_atlas_pitch(atlas);
+
+    for (s32 y = 0; y < atlas->cell_height; y++)
+    {
+        for (s32 x = 0; x < atlas->cell_width; x++)
+        {
+            s32 fx = x0 + x;
+            s32 fy = y0 + y;
+
+            if (fx < 0 || fy < 0 || fx >= TESTS_GLYPHS_WIDTH || fy >= TESTS_GLYPHS_HEIGHT)
+            {
+                continue;
+            }
+
+            float a = cells[y * pitch + digit * atlas->cell_width + x] / 255.0f * color.w / 255.0f;
+            u8* px = frame + fy * TESTS_GLYPHS_PITCH + fx * 4;
+
+            for (s32 i = 0; i < 4; i++)
+            {
+                px[i] = (u8)floorf(channels[i] * a + px[i] * (1.0f - a) + 0.5f);
+            }
+        }
+    }
+}
+
+static s32 tests_glyphs_max_diff(const u8* a, const u8* b)
+{
+    s32 ret = 0;
+
+    for (s32 y = 0; y < TESTS_GLYPHS_HEIGHT; y++)
+    {
+        for (s32 x = 0; x < TESTS_GLYPHS_WIDTH * 4; x++)
+        {
+            ret = svr_max(ret, abs((s32)a[y * TESTS_GLYPHS_PITCH + x] - (s32)b[y * TESTS_GLYPHS_PITCH + x]));
+        }
+    }
+
+    return ret;
+}
+
+// Draws at many positions, also where the text goes over every edge.
+static void tests_glyphs_levels(SvrGlyphAtlas* atlas)
+{
+    const char* digits = "9072a5";
+    s32 num_digits = (s32)strlen(digits);
+
+    SvrVec4I fill = { 250, 180, 30, 200 };
+    SvrVec4I border = { 0, 0, 0, 255 };
+
+    u8* start = (u8*)svr_alloc(TESTS_GLYPHS_SIZE);
+    u8* scalar = (u8*)svr_alloc(TESTS_GLYPHS_SIZE);
+    u8* other = (u8*)svr_alloc(TESTS_GLYPHS_SIZE);
+
+    tests_glyphs_make_frame(start);
+
+    for (s32 y = -20; y < TESTS_GLYPHS_HEIGHT + 20; y += 3)
+    {
+        for (s32 x = -70; x < TESTS_GLYPHS_WIDTH + 10; x += 7)
+        {
+            SvrVec2I pos = { x, y };
+
+            memcpy(scalar, start, TESTS_GLYPHS_SIZE);
+            svr_glyph_draw_digits(atlas, digits, num_digits, pos, fill, border, scalar, TESTS_GLYPHS_PITCH, TESTS_GLYPHS_WIDTH, TESTS_GLYPHS_HEIGHT, SVR_SIMD_SCALAR);
+
+            for (SvrSimdLevel level = SVR_SIMD_SSE41; level <= svr_simd_get_best_level(); level++)
+            {
+                memcpy(other, start, TESTS_GLYPHS_SIZE);
+                svr_glyph_draw_digits(atlas, digits, num_digits, pos, fill, border, other, TESTS_GLYPHS_PITCH, TESTS_GLYPHS_WIDTH, TESTS_GLYPHS_HEIGHT, level);
+
+                TEST_CHECK(!memcmp(scalar, other, TESTS_GLYPHS_SIZE));
+            }
+
+            // The padding after every row must be left alone.
+            for (s32 row = 0; row < TESTS_GLYPHS_HEIGHT; row++)
+            {
+                s32 offset = row * TESTS_GLYPHS_PITCH + TESTS_GLYPHS_WIDTH * 4;
+                TEST_CHECK(!memcmp(scalar + offset, start + offset, TESTS_GLYPHS_PITCH - TESTS_GLYPHS_WIDTH * 4));
+            }
+
+            // Pixels outside of the text rect must be left alone.
+            SvrVec4I rect = svr_glyph_get_text_rect(atlas, num_digits);
+
+            for (s32 row = 0; row < TESTS_GLYPHS_HEIGHT; row++)
+            {
+                for (s32 col = 0; col < TESTS_GLYPHS_WIDTH; col++)
+                {
+                    bool inside = col >= x + rect.x && col < x + rect.x + rect.z && row >= y + rect.y && row < y + rect.y + rect.w;
+
+                    if (!inside)
+                    {
+                        s32 offset = row * TESTS_GLYPHS_PITCH + col * 4;
+                        TEST_CHECK(!memcmp(scalar + offset, start + offset, 4));
+                    }
+                }
+            }
+        }
+    }
+
+    svr_free(start);
+    svr_free(scalar);
+    svr_free(other);
+}
+
+// One layer at a time against the float blend, with colors that are partly transparent.
+static void tests_glyphs_reference_blend(SvrGlyphAtlas* atlas)
+{
+    const char* digits = "31415";
+    s32 num_digits = (s32)strlen(digits);
+
+    u8* start = (u8*)svr_alloc(TESTS_GLYPHS_SIZE);
+    u8* result = (u8*)svr_alloc(TESTS_GLYPHS_SIZE);
+    u8* reference = (u8*)svr_alloc(TESTS_GLYPHS_SIZE);
+
+    tests_glyphs_make_frame(start);
+
+    SvrVec4I colors[] =
+    {
+        SvrVec4I { 255, 255, 255, 255 },
+        SvrVec4I { 10, 200, 90, 128 },
+        SvrVec4I { 255, 0, 0, 1 },
+    };
+
+    SvrVec4I none = {};
+
+    // The digits of the atlas overlap, and a pixel that is blended twice can be off by 1 each time, so every digit is drawn on its own.
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(colors); i++)
+    {
+        memcpy(result, start, TESTS_GLYPHS_SIZE);
+        memcpy(reference, start, TESTS_GLYPHS_SIZE);
+
+        for (s32 j = 0; j < num_digits; j++)
+        {
+            SvrVec2I pos = { -3 + j * (atlas->cell_width + 1), 12 };
+
+            svr_glyph_draw_digits(atlas, digits + j, 1, pos, colors[i], none, result, TESTS_GLYPHS_PITCH, TESTS_GLYPHS_WIDTH, TESTS_GLYPHS_HEIGHT, svr_simd_get_best_level());
+            tests_glyphs_reference(atlas, atlas->fill, digits[j] - '0', pos.x - atlas->origin.x, pos.y - atlas->origin.y, colors[i], reference);
+        }
+
+        TEST_CHECK(tests_glyphs_max_diff(result, reference) <= 1);
+    }
+
+    // A border color without alpha must not change anything.
+    memcpy(result, start, TESTS_GLYPHS_SIZE);
+    svr_glyph_draw_digits(atlas, digits, num_digits, SvrVec2I { 5, 15 }, none, none, result, TESTS_GLYPHS_PITCH, TESTS_GLYPHS_WIDTH, TESTS_GLYPHS_HEIGHT, svr_simd_get_best_level());
+    TEST_CHECK(!memcmp(result, start, TESTS_GLYPHS_SIZE));
+
+    svr_free(start);
+    svr_free(result);
+    svr_free(reference);
+}
+
+static void tests_glyphs_text_rect(SvrGlyphAtlas* atlas)
+{
+    SvrVec4I empty = svr_glyph_get_text_rect(atlas, 0);
+    TEST_CHECK(empty.z == 0 && empty.w == 0);
+
+    // The last digit of 3 starts at round(2 * 11.4) = 23.
+    SvrVec4I rect = svr_glyph_get_text_rect(atlas, 3);
+    TEST_CHECK(rect.x == -atlas->origin.x);
+    TEST_CHECK(rect.y == -atlas->origin.y);
+    TEST_CHECK(rect.z == 23 + atlas->cell_width);
+    TEST_CHECK(rect.w == atlas->cell_height);
+}
+
+void tests_glyphs()
+{
+    srand(17);
+
+    SvrGlyphAtlas atlas;
+    tests_glyphs_make_atlas(&atlas, true);
+
+    tests_glyphs_levels(&atlas);
+    tests_glyphs_text_rect(&atlas);
+
+    svr_glyph_free_atlas(&atlas);
+
+    tests_glyphs_make_atlas(&atlas, false);
+
+    tests_glyphs_levels(&atlas);
+    tests_glyphs_reference_blend(&atlas);
+
+    svr_glyph_free_atlas(&atlas);
+}
@@ -0,0 +1,508 @@
+#include "tests_priv.h"
+#include "encoder_shared.h"
+#include "encoder_host.h"
+
+// Tests of the shared memory between svr_game and svr_encoder.
+// The test acts like svr_game and sends a movie from a fake frame source. The encoder side is the event loop of svr_encoder
+// with a handler that checks everything it gets instead of encoding it. The encoder runs either on a thread that is started and
+// stopped the same way as svr_encoder_host.dll, or in a forked process like svr_encoder.exe. Fork is not on Windows, so there only the thread is tested.
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+const s32 TESTS_IPC_WIDTH = 64;
+const s32 TESTS_IPC_HEIGHT = 36;
+const s32 TESTS_IPC_FRAMES = 1000;
+const s32 TESTS_IPC_MAX_FRAME_SAMPLES = 1500; // The audio for a frame is between 1 and this many samples.
+
+// Number of samples that are sent after a frame. Both sides know this so the encoder can check the total.
+static s32 tests_ipc_get_frame_samples(s32 frame)
+{
+    return 1 + (frame * 7919) % TESTS_IPC_MAX_FRAME_SAMPLES;
+}
+
+static s32 tests_ipc_get_total_samples()
+{
+    s32 ret = 0;
+
+    for (s32 i = 0; i < TESTS_IPC_FRAMES; i++)
+    {
+        ret += tests_ipc_get_frame_samples(i);
+    }
+
+    return ret;
+}
+
+static u32 tests_ipc_get_pixel(s32 frame, s32 idx)
+{
+    return (u32)frame * 2654435761u + (u32)idx;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Encoder side.
+
+struct TestsIpcEncoder
+{
+    EncoderSharedMem* shared;
+
+    SvrIpcMem frame_mem; // From frame_mem_id, like EncoderState::vid_frame_mem.
+    bool started;
+    s32 num_frames;
+    u32 num_samples;
+    s32 num_exits;
+};
+
+// Only the first error is kept, like EncoderState::error.
+static void tests_ipc_encoder_error(TestsIpcEncoder* enc, const char* message)
+{
+    if (enc->shared->error == 0)
+    {
+        enc->shared->error = 1;
+        SVR_COPY_STRING(message, enc->shared->error_message);
+    }
+}
+
+static void tests_ipc_encoder_video_slot(void* param, s32 slot_idx)
+{
+    TestsIpcEncoder* enc = (TestsIpcEncoder*)param;
+
+    s32 frame_size = TESTS_IPC_WIDTH * TESTS_IPC_HEIGHT * 4;
+    u32* pixels = (u32*)((u8*)enc->frame_mem.ptr + slot_idx * frame_size);
+
+    if (!enc->started)
+    {
+        tests_ipc_encoder_error(enc, "Got a frame outside of a movie");
+    }
+
+    else
+    {
+        for (s32 i = 0; i < TESTS_IPC_WIDTH * TESTS_IPC_HEIGHT; i++)
+        {
+            if (pixels[i] != tests_ipc_get_pixel(enc->num_frames, i))
+            {
+                tests_ipc_encoder_error(enc, svr_va("Frame %d has the wrong pixels in slot %d", enc->num_frames, slot_idx));
+                break;
+            }
+        }
+    }
+
+    enc->num_frames++;
+}
+
+// The samples must continue from the last ones.
+static void tests_ipc_encoder_audio_samples(void* param, void* samples, s32 num_samples)
+{
+    TestsIpcEncoder* enc = (TestsIpcEncoder*)param;
+    u32* values = (u32*)samples;
+
+    for (s32 i = 0; i < num_samples; i++)
+    {
+        if (values[i] != enc->num_samples)
+        {
+            tests_ipc_encoder_error(enc, svr_va("Got sample %u when %u was expected", values[i], enc->num_samples));
+        }
+
+        enc->num_samples++;
+    }
+}
+
+static void tests_ipc_encoder_rings_read(void* param)
+{
+    (void)param;
+}
+
+static void tests_ipc_encoder_start(void* param)
+{
+    TestsIpcEncoder* enc = (TestsIpcEncoder*)param;
+    EncoderSharedMovieParams* params = &enc->shared->movie_params;
+
+    if (params->video_width != TESTS_IPC_WIDTH || params->video_height != TESTS_IPC_HEIGHT)
+    {
+        tests_ipc_encoder_error(enc, "Got the wrong movie parameters");
+        return;
+    }
+
+    if (!svr_ipc_open_given_mem(enc->shared->frame_mem_id, &enc->frame_mem))
+    {
+        tests_ipc_encoder_error(enc, "Could not open the frame memory");
+        return;
+    }
+
+    enc->started = true;
+    enc->num_frames = 0;
+    enc->num_samples = 0;
+}
+
+static void tests_ipc_encoder_stop(void* param)
+{
+    TestsIpcEncoder* enc = (TestsIpcEncoder*)param;
+
+    // Everything that was sent before the stop has been read now.
+    if (enc->num_frames != TESTS_IPC_FRAMES)
+    {
+        tests_ipc_encoder_error(enc, svr_va("Got %d frames when %d were sent", enc->num_frames, TESTS_IPC_FRAMES));
+    }
+
+    if (enc->num_samples != (u32)tests_ipc_get_total_samples())
+    {
+        tests_ipc_encoder_error(enc, svr_va("Got %u samples when %d were sent", enc->num_samples, tests_ipc_get_total_samples()));
+    }
+
+    svr_ipc_free_mem(&enc->frame_mem);
+    enc->started = false;
+}
+
+static void tests_ipc_encoder_game_exited(void* param)
+{
+    TestsIpcEncoder* enc = (TestsIpcEncoder*)param;
+    enc->num_exits++;
+}
+
+// Runs the event loop of svr_encoder until it is told to quit or the game is gone. The game process is NULL when on a thread in the same process.
+static void tests_ipc_encoder_run(TestsIpcEncoder* enc, SvrIpcProcess* game)
+{
+    EncoderSharedHandler handler = {};
+    handler.param = enc;
+    handler.start = tests_ipc_encoder_start;
+    handler.stop = tests_ipc_encoder_stop;
+    handler.video_slot = tests_ipc_encoder_video_slot;
+    handler.audio_samples = tests_ipc_encoder_audio_samples;
+    handler.rings_read = tests_ipc_encoder_rings_read;
+    handler.game_exited = tests_ipc_encoder_game_exited;
+
+    encoder_shared_event_loop(enc->shared, game, &handler);
+}
+
+// Started by encoder_host_start_thread. Opens the memory from the id like svr_encoder_host.dll does.
+static void tests_ipc_encoder_host_proc(void* param)
+{
+    EncoderHostParams* params = (EncoderHostParams*)param;
+    SvrIpcMem mem = {};
+    TestsIpcEncoder enc = {};
+
+    if (!svr_ipc_open_mem(params->shared_mem_id, &mem))
+    {
+        return;
+    }
+
+    enc.shared = (EncoderSharedMem*)mem.ptr;
+
+    tests_ipc_encoder_run(&enc, NULL);
+
+    svr_ipc_free_mem(&mem);
+}
+
+#ifndef _WIN32
+// The encoder process. Opens everything from the id like svr_encoder.exe does.
+static void tests_ipc_encoder_proc(const char* mem_id)
+{
+    SvrIpcMem mem = {};
+    SvrIpcProcess game = {};
+    TestsIpcEncoder enc = {};
+
+    if (!svr_ipc_open_mem(mem_id, &mem))
+    {
+        _exit(1);
+    }
+
+    enc.shared = (EncoderSharedMem*)mem.ptr;
+
+    if (!svr_ipc_open_process(enc.shared->game_pid, &game))
+    {
+        _exit(1);
+    }
+
+    tests_ipc_encoder_run(&enc, &game);
+
+    svr_ipc_free_mem(&mem);
+    _exit(enc.num_exits == 0 ? 0 : 1);
+}
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+// Game side.
+
+struct TestsIpcGame
+{
+    EncoderSharedMem* shared;
+    SvrIpcProcess* encoder; // The thread of svr_encoder when it is hosted, which is waited on like the process.
+    bool hosted;
+    SvrIpcMem frame_mem; // One frame for every slot, like proc_cpu_create_share_slots.
+};
+
+// Like ProcState::encoder_send_event.
+static bool tests_ipc_send_event(TestsIpcGame* game, EncoderSharedEvent event)
+{
+    encoder_shared_post_event(game->shared, event);
+
+    return svr_ipc_wait(&game->shared->game_wake_event, game->encoder) == SVR_IPC_WAIT_EVENT;
+}
+
+// Like ProcState::encoder_begin_share_slot and ProcState::encoder_send_shared_tex.
+static bool tests_ipc_send_frame(TestsIpcGame* game, s32 frame)
+{
+    SvrSlotRing* ring = &game->shared->video_ring;
+    s32 slot_idx;
+
+    while (!svr_slot_ring_begin_write(ring, &slot_idx))
+    {
+        if (svr_ipc_wait(&game->shared->video_slot_event, game->encoder) == SVR_IPC_WAIT_EXITED)
+        {
+            return false;
+        }
+    }
+
+    s32 frame_size = TESTS_IPC_WIDTH * TESTS_IPC_HEIGHT * 4;
+    u32* pixels = (u32*)((u8*)game->frame_mem.ptr + slot_idx * frame_size);
+
+    for (s32 i = 0; i < TESTS_IPC_WIDTH * TESTS_IPC_HEIGHT; i++)
+    {
+        pixels[i] = tests_ipc_get_pixel(frame, i);
+    }
+
+    svr_slot_ring_end_write(ring);
+    svr_ipc_set_event(&game->shared->encoder_wake_event);
+
+    return true;
+}
+
+// Like ProcState::encoder_send_audio_samples, which only wakes the encoder when a block is waiting or the ring is full.
+static bool tests_ipc_send_audio(TestsIpcGame* game, u32* next_value, s32 num_samples)
+{
+    SvrSharedRing* ring = &game->shared->audio_ring;
+    s32 num_before = svr_shared_ring_get_num_items(ring);
+
+    while (num_samples > 0)
+    {
+        void* dest;
+        s32 num_free = svr_shared_ring_begin_write(ring, &dest, num_samples);
+
+        if (num_free == 0)
+        {
+            svr_ipc_set_event(&game->shared->encoder_wake_event);
+
+            if (svr_ipc_wait(&game->shared->audio_space_event, game->encoder) == SVR_IPC_WAIT_EXITED)
+            {
+                return false;
+            }
+
+            num_before = 0;
+            continue;
+        }
+
+        u32* values = (u32*)dest;
+
+        for (s32 i = 0; i < num_free; i++)
+        {
+            values[i] = *next_value;
+            (*next_value)++;
+        }
+
+        svr_shared_ring_end_write(ring, num_free);
+        num_samples -= num_free;
+    }
+
+    if (num_before < ENCODER_MAX_SAMPLES && svr_shared_ring_get_num_items(ring) >= ENCODER_MAX_SAMPLES)
+    {
+        svr_ipc_set_event(&game->shared->encoder_wake_event);
+    }
+
+    return true;
+}
+
+// Records a movie from the fake frame source.
+static void tests_ipc_record(TestsIpcGame* game)
+{
+    EncoderSharedMem* shared = game->shared;
+
+    TEST_CHECK(svr_ipc_create_mem(TESTS_IPC_WIDTH * TESTS_IPC_HEIGHT * 4 * ENCODER_VIDEO_SLOTS, &game->frame_mem));
+
+    SvrIpcProcess self = {};
+    self.pid = svr_ipc_get_current_pid();
+
+    TEST_CHECK(svr_ipc_give_mem(&game->frame_mem, game->hosted ? &self : game->encoder, shared->frame_mem_id, sizeof(shared->frame_mem_id)));
+
+    shared->movie_params.video_width = TESTS_IPC_WIDTH;
+    shared->movie_params.video_height = TESTS_IPC_HEIGHT;
+
+    // Like encoder_start.
+    svr_slot_ring_restart(&shared->video_ring);
+    TEST_CHECK(tests_ipc_send_event(game, ENCODER_EVENT_START));
+
+    u32 next_value = 0;
+    bool sent = true;
+
+    for (s32 i = 0; i < TESTS_IPC_FRAMES && sent; i++)
+    {
+        sent &= tests_ipc_send_frame(game, i);
+        sent &= tests_ipc_send_audio(game, &next_value, tests_ipc_get_frame_samples(i));
+    }
+
+    TEST_CHECK(sent);
+
+    // Like encoder_end.
+    svr_slot_ring_stop(&shared->video_ring);
+    TEST_CHECK(tests_ipc_send_event(game, ENCODER_EVENT_STOP));
+
+    if (shared->error)
+    {
+        printf("Encoder: %s\n", shared->error_message);
+    }
+
+    TEST_CHECK(shared->error == 0);
+    TEST_CHECK(svr_slot_ring_is_done(&shared->video_ring));
+    TEST_CHECK(svr_shared_ring_get_num_items(&shared->audio_ring) == 0);
+
+    svr_ipc_free_mem(&game->frame_mem);
+}
+
+// Like ProcState::encoder_start_host and ProcState::encoder_free_static with svr_encoder_host.dll.
+static void tests_ipc_thread()
+{
+    SvrIpcMem mem = {};
+
+    if (!encoder_shared_create(&mem, sizeof(u32)))
+    {
+        TEST_CHECK(!"Could not create the shared memory");
+        return;
+    }
+
+    EncoderHostParams params = {};
+    svr_ipc_get_mem_id(&mem, params.shared_mem_id, sizeof(params.shared_mem_id));
+
+    SvrIpcProcess host = {};
+    host.handle = encoder_host_start_thread(tests_ipc_encoder_host_proc, &params);
+    host.pid = svr_ipc_get_current_pid();
+
+    TEST_CHECK(host.handle != NULL);
+
+    TestsIpcGame game = {};
+    game.shared = (EncoderSharedMem*)mem.ptr;
+    game.encoder = &host;
+    game.hosted = true;
+
+    tests_ipc_record(&game);
+
+    encoder_host_quit(game.shared, &host);
+    TEST_CHECK(host.handle == NULL);
+
+    encoder_shared_close_events(game.shared);
+    svr_ipc_free_mem(&mem);
+}
+
+#ifndef _WIN32
+static void tests_ipc_process()
+{
+    SvrIpcMem mem = {};
+    SvrIpcProcess encoder = {};
+
+    if (!encoder_shared_create(&mem, sizeof(u32)))
+    {
+        TEST_CHECK(!"Could not create the shared memory");
+        return;
+    }
+
+    char mem_id[128];
+    svr_ipc_get_mem_id(&mem, mem_id, sizeof(mem_id));
+
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        tests_ipc_encoder_proc(mem_id);
+    }
+
+    TEST_CHECK(pid > 0 && svr_ipc_open_process((u32)pid, &encoder));
+
+    TestsIpcGame game = {};
+    game.shared = (EncoderSharedMem*)mem.ptr;
+    game.encoder = &encoder;
+
+    tests_ipc_record(&game);
+
+    TEST_CHECK(tests_ipc_send_event(&game, ENCODER_EVENT_QUIT));
+
+    svr_ipc_close_process(&encoder);
+
+    // The encoder exits with 0 only if it left on ENCODER_EVENT_QUIT.
+    int status = -1;
+    waitpid(pid, &status, 0);
+    TEST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    encoder_shared_close_events(game.shared);
+    svr_ipc_free_mem(&mem);
+}
+
+// The event loop of svr_encoder must leave when the game exits without telling it, and only call the handler for that.
+static void tests_ipc_game_exited()
+{
+    SvrIpcMem mem = {};
+
+    if (!encoder_shared_create(&mem, sizeof(u32)))
+    {
+        TEST_CHECK(!"Could not create the shared memory");
+        return;
+    }
+
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        _exit(0);
+    }
+
+    SvrIpcProcess game = {};
+    game.pid = (u32)pid;
+
+    TestsIpcEncoder enc = {};
+    enc.shared = (EncoderSharedMem*)mem.ptr;
+
+    tests_ipc_encoder_run(&enc, &game);
+
+    TEST_CHECK(enc.num_exits == 1);
+    TEST_CHECK(!enc.started && enc.num_frames == 0 && enc.num_samples == 0);
+    TEST_CHECK(enc.shared->error == 0);
+
+    encoder_shared_close_events(enc.shared);
+    svr_ipc_free_mem(&mem);
+}
+
+// Waiting must stop when the other process exits without setting the event.
+static void tests_ipc_exited()
+{
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        _exit(0);
+    }
+
+    SvrIpcEvent event = {};
+    SvrIpcProcess process = {};
+    process.pid = (u32)pid;
+
+    TEST_CHECK(svr_ipc_create_event(&event));
+    TEST_CHECK(svr_ipc_wait(&event, &process) == SVR_IPC_WAIT_EXITED);
+    TEST_CHECK(!svr_ipc_open_process((u32)pid, &process));
+
+    // A set event is seen once, and not again.
+    svr_ipc_set_event(&event);
+    TEST_CHECK(svr_ipc_wait(&event, NULL) == SVR_IPC_WAIT_EVENT);
+    TEST_CHECK(svr_ipc_wait(&event, &process) == SVR_IPC_WAIT_EXITED);
+
+    svr_ipc_close_event(&event);
+}
+#endif
+
+void tests_ipc()
+{
+    tests_ipc_thread();
+
+#ifndef _WIN32
+    tests_ipc_process();
+    tests_ipc_game_exited();
+    tests_ipc_exited();
+#endif
+}
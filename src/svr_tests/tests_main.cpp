@@ -0,0 +1,83 @@
+#include "tests_priv.h"
+
+struct TestsGroup
+{
+    const char* name;
+    void(*fn)();
+};
+
+TestsGroup TESTS_GROUPS[] =
+{
+    TestsGroup { "ring", tests_ring },
+    TestsGroup { "color", tests_color },
+    TestsGroup { "copy", tests_copy },
+    TestsGroup { "slot_ring", tests_slot_ring },
+    TestsGroup { "ipc", tests_ipc },
+    TestsGroup { "mosample", tests_mosample },
+    TestsGroup { "frame_steps", tests_frame_steps },
+    TestsGroup { "motion", tests_motion },
+    TestsGroup { "glyphs", tests_glyphs },
+    TestsGroup { "scan", tests_scan },
+    TestsGroup { "scan_cache", tests_scan_cache },
+    TestsGroup { "pe", tests_pe },
+    TestsGroup { "wave", tests_wave },
+    TestsGroup { "trace", tests_trace },
+    TestsGroup { "reorder", tests_reorder },
+    TestsGroup { "stats", tests_stats },
+};
+
+s32 tests_num_checks;
+s32 tests_num_failed;
+
+void tests_check(bool value, const char* expr, const char* location)
+{
+    tests_num_checks++;
+
+    if (!value)
+    {
+        tests_num_failed++;
+        printf("FAILED: %s (%s)\n", expr, location);
+    }
+}
+
+static bool tests_run_group(const char* name)
+{
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(TESTS_GROUPS); i++)
+    {
+        TestsGroup* group = &TESTS_GROUPS[i];
+
+        if (!strcmp(group->name, name))
+        {
+            s32 prev_failed = tests_num_failed;
+            group->fn();
+
+            printf("%s: %s\n", group->name, tests_num_failed == prev_failed ? "ok" : "failed");
+            return true;
+        }
+    }
+
+    printf("No test group named %s\n", name);
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    bool found = true;
+
+    if (argc < 2)
+    {
+        for (s32 i = 0; i < SVR_ARRAY_SIZE(TESTS_GROUPS); i++)
+        {
+            tests_run_group(TESTS_GROUPS[i].name);
+        }
+    }
+
+    for (s32 i = 1; i < argc; i++)
+    {
+        found &= tests_run_group(argv[i]);
+    }
+
+    printf("%d checks, %d failed\n", tests_num_checks, tests_num_failed);
+
+    return (found && tests_num_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,419 @@
+#include "tests_priv.h"
+#include "svr_mosample.h"
+#include "svr_work_pool.h"
+#include <stdlib.h>
+#include <math.h>
+
+// Tests of the processor motion sampling against a float version of motion_sample.hlsl and downsample.hlsl.
+// The output table may be off by one from the rounded pow result, but all SIMD levels must give exactly the same result.
+
+const s32 TESTS_MOSAMPLE_WIDTH = 37; // Leaves tails for the SIMD levels.
+const s32 TESTS_MOSAMPLE_HEIGHT = 11;
+const s32 TESTS_MOSAMPLE_PITCH = TESTS_MOSAMPLE_WIDTH * 4 + 20;
+const s32 TESTS_MOSAMPLE_MULT = 6;
+
+struct TestsMosampleFrames
+{
+    u8* frames[TESTS_MOSAMPLE_MULT];
+    float weights[TESTS_MOSAMPLE_MULT];
+};
+
+static void tests_mosample_make_frames(TestsMosampleFrames* frames, float exposure)
+{
+    SvrMosampleTimer timer;
+    svr_mosample_timer_init(&timer, TESTS_MOSAMPLE_MULT, exposure, false);
+
+    srand(TESTS_MOSAMPLE_MULT);
+
+    for (s32 i = 0; i < TESTS_MOSAMPLE_MULT; i++)
+    {
+        frames->frames[i] = (u8*)svr_alloc(TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT);
+
+        for (s32 j = 0; j < TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT; j++)
+        {
+            frames->frames[i][j] = (u8)rand();
+        }
+
+        SvrMosampleStep step;
+        svr_mosample_timer_step(&timer, &step);
+
+        frames->weights[i] = step.weight;
+    }
+}
+
+static void tests_mosample_free_frames(TestsMosampleFrames* frames)
+{
+    for (s32 i = 0; i < TESTS_MOSAMPLE_MULT; i++)
+    {
+        svr_free(frames->frames[i]);
+    }
+}
+
+// Blends all frames into dest.
+static void tests_mosample_blend(TestsMosampleFrames* frames, u8* dest, SvrSimdLevel level, SvrWorkPool* pool)
+{
+    SvrMosampleBuffer buf;
+    svr_mosample_create_buffer(&buf, TESTS_MOSAMPLE_WIDTH, TESTS_MOSAMPLE_HEIGHT);
+    svr_mosample_clear(&buf);
+
+    for (s32 i = 0; i < TESTS_MOSAMPLE_MULT; i++)
+    {
+        if (frames->weights[i] > 0.0f)
+        {
+            svr_mosample_add(&buf, frames->frames[i], TESTS_MOSAMPLE_PITCH, frames->weights[i], level, pool);
+        }
+    }
+
+    svr_mosample_downsample(&buf, dest, TESTS_MOSAMPLE_PITCH, level, pool);
+    svr_mosample_free_buffer(&buf);
+}
+
+// Same as the shaders in doubles. Returns the number of channels that are more than 1 away.
+static s32 tests_mosample_check_reference(TestsMosampleFrames* frames, u8* result)
+{
+    s32 num_wrong = 0;
+
+    for (s32 y = 0; y < TESTS_MOSAMPLE_HEIGHT; y++)
+    {
+        for (s32 x = 0; x < TESTS_MOSAMPLE_WIDTH; x++)
+        {
+            s32 offset = y * TESTS_MOSAMPLE_PITCH + x * 4;
+
+            for (s32 c = 0; c < 3; c++)
+            {
+                double sum = 0.0;
+
+                for (s32 i = 0; i < TESTS_MOSAMPLE_MULT; i++)
+                {
+                    sum += frames->weights[i] * pow(frames->frames[i][offset + c] / 255.0, 2.2);
+                }
+
+                s32 expected = (s32)(pow(sum, 1.0 / 2.2) * 255.0 + 0.5);
+                svr_clamp(&expected, 0, 255);
+
+                num_wrong += abs(result[offset + c] - expected) > 1;
+            }
+
+            num_wrong += result[offset + 3] != 255;
+        }
+    }
+
+    return num_wrong;
+}
+
+static bool tests_mosample_same_image(u8* a, u8* b)
+{
+    for (s32 y = 0; y < TESTS_MOSAMPLE_HEIGHT; y++)
+    {
+        if (memcmp(a + y * TESTS_MOSAMPLE_PITCH, b + y * TESTS_MOSAMPLE_PITCH, TESTS_MOSAMPLE_WIDTH * 4))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void tests_mosample_blending(float exposure, SvrWorkPool* pool)
+{
+    TestsMosampleFrames frames;
+    tests_mosample_make_frames(&frames, exposure);
+
+    u8* scalar = (u8*)svr_zalloc(TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT);
+    u8* other = (u8*)svr_zalloc(TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT);
+
+    tests_mosample_blend(&frames, scalar, SVR_SIMD_SCALAR, NULL);
+    TEST_CHECK(tests_mosample_check_reference(&frames, scalar) == 0);
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR + 1; level <= svr_simd_get_best_level(); level++)
+    {
+        tests_mosample_blend(&frames, other, level, NULL);
+        TEST_CHECK(tests_mosample_same_image(scalar, other));
+
+        tests_mosample_blend(&frames, other, level, pool);
+        TEST_CHECK(tests_mosample_same_image(scalar, other));
+    }
+
+    svr_free(scalar);
+    svr_free(other);
+    tests_mosample_free_frames(&frames);
+}
+
+// Every channel value must come back the same when only one frame is blended with the full weight.
+static void tests_mosample_round_trip()
+{
+    u8* src = (u8*)svr_alloc(TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT);
+    u8* dest = (u8*)svr_alloc(TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT);
+
+    for (s32 i = 0; i < TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT; i++)
+    {
+        src[i] = (u8)i;
+    }
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        SvrMosampleBuffer buf;
+        svr_mosample_create_buffer(&buf, TESTS_MOSAMPLE_WIDTH, TESTS_MOSAMPLE_HEIGHT);
+        svr_mosample_clear(&buf);
+        svr_mosample_add(&buf, src, TESTS_MOSAMPLE_PITCH, 1.0f, level, NULL);
+        svr_mosample_downsample(&buf, dest, TESTS_MOSAMPLE_PITCH, level, NULL);
+        svr_mosample_free_buffer(&buf);
+
+        s32 num_wrong = 0;
+
+        for (s32 y = 0; y < TESTS_MOSAMPLE_HEIGHT; y++)
+        {
+            for (s32 x = 0; x < TESTS_MOSAMPLE_WIDTH * 4; x++)
+            {
+                s32 offset = y * TESTS_MOSAMPLE_PITCH + x;
+
+                if ((x & 3) != 3)
+                {
+                    num_wrong += abs(src[offset] - dest[offset]) > 1;
+                }
+            }
+        }
+
+        TEST_CHECK(num_wrong == 0);
+    }
+
+    svr_free(src);
+    svr_free(dest);
+}
+
+// The weights of a video frame must add up to one, and the frame must end after exactly mult sub-frames.
+static void tests_mosample_timer(s32 mult, float exposure, bool skip_closed)
+{
+    SvrMosampleTimer timer;
+    svr_mosample_timer_init(&timer, mult, exposure, skip_closed);
+
+    for (s32 i = 0; i < 5; i++)
+    {
+        float sum = 0.0f;
+        s32 num_steps = 0;
+        SvrMosampleStep step = {};
+
+        while (!step.finish_frame)
+        {
+            s32 expected_steps = svr_mosample_timer_get_steps(&timer, 0);
+
+            svr_mosample_timer_step(&timer, &step);
+
+            TEST_CHECK(step.num_steps == expected_steps);
+            TEST_CHECK(step.weight >= 0.0f);
+
+            sum += step.weight;
+            num_steps += step.num_steps;
+        }
+
+        TEST_CHECK(num_steps == mult);
+        TEST_CHECK(fabsf(sum - 1.0f) < 0.0001f);
+    }
+}
+
+// The adaptive mode must use one game frame for still video frames and every sub-frame for fast ones, while keeping the same exposure.
+// Steps that have been returned by svr_mosample_timer_get_steps must not change when the motion changes.
+static void tests_mosample_adaptive()
+{
+    const s32 MULT = 60;
+    const s32 NUM_VIDEO_FRAMES = 24;
+    const s32 MAX_GAME_FRAMES = MULT * NUM_VIDEO_FRAMES;
+    const s32 LOOK_AHEAD = 3;
+
+    SvrMosampleTimer timer;
+    svr_mosample_timer_init(&timer, MULT, 0.5f, true);
+    svr_mosample_timer_set_adaptive(&timer, 0.25f);
+
+    // Steps that were returned for every game frame, or 0 if none were.
+    s32* told_steps = SVR_ZALLOC_NUM(s32, (MAX_GAME_FRAMES + LOOK_AHEAD + 1));
+    s32 game_frame = 0;
+
+    s32 video_frame_game_frames[NUM_VIDEO_FRAMES];
+
+    for (s32 i = 0; i < NUM_VIDEO_FRAMES; i++)
+    {
+        // Still for the first half and then moving fast.
+        float motion = (i < NUM_VIDEO_FRAMES / 2) ? 0.0f : 10.0f;
+
+        float sum = 0.0f;
+        s32 num_steps = 0;
+        s32 num_game_frames = 0;
+        SvrMosampleStep step = {};
+
+        while (!step.finish_frame)
+        {
+            for (s32 j = 0; j <= LOOK_AHEAD; j++)
+            {
+                s32 steps = svr_mosample_timer_get_steps(&timer, j);
+
+                if (told_steps[game_frame + j] != 0)
+                {
+                    TEST_CHECK(told_steps[game_frame + j] == steps);
+                }
+
+                told_steps[game_frame + j] = steps;
+            }
+
+            svr_mosample_timer_step(&timer, &step);
+            svr_mosample_timer_give_difference(&timer, motion * step.num_steps, step.num_steps);
+
+            sum += step.weight;
+            num_steps += step.num_steps;
+            num_game_frames++;
+            game_frame++;
+        }
+
+        TEST_CHECK(num_steps == MULT);
+        TEST_CHECK(fabsf(sum - 1.0f) < 0.0001f);
+
+        video_frame_game_frames[i] = num_game_frames;
+    }
+
+    // The motion is seen a few video frames late, so only the ends of the halves are checked.
+    TEST_CHECK(video_frame_game_frames[NUM_VIDEO_FRAMES / 2 - 1] == 1);
+    TEST_CHECK(video_frame_game_frames[NUM_VIDEO_FRAMES - 1] == MULT / 2);
+
+    svr_free(told_steps);
+}
+
+// What a shutter does with one game frame, with the end time of the game frame in video frames as a fraction.
+struct TestsMosampleShutterStep
+{
+    s64 end_num; // End time is end_num / end_den video frames.
+    s64 end_den;
+    float weight;
+    bool finish_frame;
+};
+
+// Runs a schedule for some video frames and keeps the steps that one shutter got.
+static s32 tests_mosample_run_schedule(SvrMosampleShutter* shutters, s32 num_shutters, bool skip_closed, s32 idx, TestsMosampleShutterStep* dest, s32 max_steps)
+{
+    const s32 NUM_VIDEO_FRAMES = 6;
+
+    SvrMosampleSchedule sched;
+    TEST_CHECK(svr_mosample_schedule_init(&sched, shutters, num_shutters, skip_closed));
+
+    s64 pos = 0;
+    s32 num_video_frames = 0;
+    s32 num_steps = 0;
+
+    while (num_video_frames < NUM_VIDEO_FRAMES)
+    {
+        SvrMosampleScheduleStep sched_step;
+        svr_mosample_schedule_step(&sched, &sched_step);
+
+        pos += sched_step.num_steps;
+
+        SvrMosampleStep* step = &sched_step.steps[idx];
+
+        if (step->num_steps == 0)
+        {
+            continue;
+        }
+
+        if (num_steps == max_steps)
+        {
+            TEST_CHECK(false);
+            break;
+        }
+
+        TestsMosampleShutterStep* res = &dest[num_steps];
+        res->end_num = pos;
+        res->end_den = sched.mult;
+        res->weight = step->weight;
+        res->finish_frame = step->finish_frame;
+
+        num_steps++;
+
+        if (step->finish_frame)
+        {
+            num_video_frames++;
+        }
+    }
+
+    return num_steps;
+}
+
+// Every shutter of a schedule must get game frames at the same times with the same weights as a schedule with only that shutter,
+// so the movies come out the same as recording them one at a time.
+static void tests_mosample_schedule(SvrMosampleShutter* shutters, s32 num_shutters, bool skip_closed)
+{
+    const s32 MAX_STEPS = 1024;
+
+    TestsMosampleShutterStep* together = SVR_ZALLOC_NUM(TestsMosampleShutterStep, MAX_STEPS);
+    TestsMosampleShutterStep* alone = SVR_ZALLOC_NUM(TestsMosampleShutterStep, MAX_STEPS);
+
+    for (s32 i = 0; i < num_shutters; i++)
+    {
+        s32 num_together = tests_mosample_run_schedule(shutters, num_shutters, skip_closed, i, together, MAX_STEPS);
+        s32 num_alone = tests_mosample_run_schedule(&shutters[i], 1, skip_closed, 0, alone, MAX_STEPS);
+
+        TEST_CHECK(num_together == num_alone);
+
+        for (s32 j = 0; j < svr_min(num_together, num_alone); j++)
+        {
+            TEST_CHECK(together[j].end_num * alone[j].end_den == alone[j].end_num * together[j].end_den);
+            TEST_CHECK(together[j].weight == alone[j].weight);
+            TEST_CHECK(together[j].finish_frame == alone[j].finish_frame);
+        }
+    }
+
+    svr_free(together);
+    svr_free(alone);
+}
+
+static void tests_mosample_difference()
+{
+    u8* a = (u8*)svr_alloc(TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT);
+    u8* b = (u8*)svr_alloc(TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT);
+
+    srand(2);
+
+    for (s32 i = 0; i < TESTS_MOSAMPLE_PITCH * TESTS_MOSAMPLE_HEIGHT; i++)
+    {
+        a[i] = (u8)(rand() % 200);
+        b[i] = a[i] + 10;
+    }
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        TEST_CHECK(svr_mosample_get_difference(a, TESTS_MOSAMPLE_PITCH, a, TESTS_MOSAMPLE_PITCH, TESTS_MOSAMPLE_WIDTH, TESTS_MOSAMPLE_HEIGHT, level) == 0.0f);
+
+        float diff = svr_mosample_get_difference(a, TESTS_MOSAMPLE_PITCH, b, TESTS_MOSAMPLE_PITCH, TESTS_MOSAMPLE_WIDTH, TESTS_MOSAMPLE_HEIGHT, level);
+        TEST_CHECK(fabsf(diff - 10.0f) < 0.001f);
+    }
+
+    svr_free(a);
+    svr_free(b);
+}
+
+void tests_mosample()
+{
+    SvrWorkPool* pool = svr_work_pool_create(3);
+
+    tests_mosample_blending(1.0f, pool);
+    tests_mosample_blending(0.5f, pool);
+    tests_mosample_round_trip();
+
+    tests_mosample_timer(1, 1.0f, false);
+    tests_mosample_timer(60, 0.5f, false);
+    tests_mosample_timer(60, 0.5f, true);
+    tests_mosample_timer(7, 0.3f, true);
+
+    tests_mosample_adaptive();
+
+    SvrMosampleShutter two_shutters[] = { { 60, 0.5f }, { 40, 0.25f } };
+    SvrMosampleShutter three_shutters[] = { { 60, 0.5f }, { 24, 1.0f }, { 7, 0.3f } };
+    SvrMosampleShutter same_mults[] = { { 30, 0.5f }, { 30, 0.1f } };
+
+    for (s32 skip_closed = 0; skip_closed < 2; skip_closed++)
+    {
+        tests_mosample_schedule(two_shutters, SVR_ARRAY_SIZE(two_shutters), skip_closed);
+        tests_mosample_schedule(three_shutters, SVR_ARRAY_SIZE(three_shutters), skip_closed);
+        tests_mosample_schedule(same_mults, SVR_ARRAY_SIZE(same_mults), skip_closed);
+    }
+
+    tests_mosample_difference();
+
+    svr_work_pool_free(pool);
+}
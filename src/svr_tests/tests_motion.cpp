@@ -0,0 +1,332 @@
+#include "tests_priv.h"
+#include "svr_motion.h"
+#include "svr_mosample.h"
+#include <stdlib.h>
+#include <math.h>
+
+// Tests of the motion estimation and of motion blur made from fewer game frames, on synthetic moving blocks.
+// A textured block moves over a textured background, so the vectors of the blocks inside it are known.
+
+const s32 TESTS_MOTION_WIDTH = 160;
+const s32 TESTS_MOTION_HEIGHT = 96;
+const s32 TESTS_MOTION_PITCH = TESTS_MOTION_WIDTH * 4;
+const s32 TESTS_MOTION_FRAME_SIZE = TESTS_MOTION_PITCH * TESTS_MOTION_HEIGHT;
+const s32 TESTS_MOTION_OBJECT_SIZE = 48;
+
+struct TestsMotionScene
+{
+    u8* background;
+    u8* object;
+};
+
+static u8 tests_motion_hash(s32 x, s32 y, s32 c, s32 seed)
+{
+    u32 h = (u32)x * 374761393u + (u32)y * 668265263u + (u32)c * 2246822519u + (u32)seed * 3266489917u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return (u8)(h >> 24);
+}
+
+// Random values between every 8 pixels, bilinear in between.
+// Smooth enough to be found at quarter size, and nothing repeats so there is only one place that matches.
+static u8 tests_motion_texture(s32 x, s32 y, s32 c, s32 seed)
+{
+    const s32 CELL = 8;
+
+    s32 cx = x / CELL;
+    s32 cy = y / CELL;
+    s32 fx = x % CELL;
+    s32 fy = y % CELL;
+
+    s32 top = tests_motion_hash(cx, cy, c, seed) * (CELL - fx) + tests_motion_hash(cx + 1, cy, c, seed) * fx;
+    s32 bottom = tests_motion_hash(cx, cy + 1, c, seed) * (CELL - fx) + tests_motion_hash(cx + 1, cy + 1, c, seed) * fx;
+
+    return (u8)((top * (CELL - fy) + bottom * fy) / (CELL * CELL));
+}
+
+static void tests_motion_make_scene(TestsMotionScene* scene)
+{
+    scene->background = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+    scene->object = (u8*)svr_alloc(TESTS_MOTION_OBJECT_SIZE * TESTS_MOTION_OBJECT_SIZE * 4);
+
+    for (s32 y = 0; y < TESTS_MOTION_HEIGHT; y++)
+    {
+        for (s32 x = 0; x < TESTS_MOTION_WIDTH; x++)
+        {
+            for (s32 c = 0; c < 4; c++)
+            {
+                scene->background[y * TESTS_MOTION_PITCH + x * 4 + c] = (c == 3) ? 255 : tests_motion_texture(x, y, c, 1);
+            }
+        }
+    }
+
+    for (s32 y = 0; y < TESTS_MOTION_OBJECT_SIZE; y++)
+    {
+        for (s32 x = 0; x < TESTS_MOTION_OBJECT_SIZE; x++)
+        {
+            for (s32 c = 0; c < 4; c++)
+            {
+                scene->object[(y * TESTS_MOTION_OBJECT_SIZE + x) * 4 + c] = (c == 3) ? 255 : tests_motion_texture(x, y, c, 7);
+            }
+        }
+    }
+}
+
+static void tests_motion_free_scene(TestsMotionScene* scene)
+{
+    svr_free(scene->background);
+    svr_free(scene->object);
+}
+
+// Draws the scene with the top left corner of the object at a whole pixel position.
+static void tests_motion_draw(TestsMotionScene* scene, s32 obj_x, s32 obj_y, u8* dest)
+{
+    memcpy(dest, scene->background, TESTS_MOTION_FRAME_SIZE);
+
+    for (s32 y = 0; y < TESTS_MOTION_OBJECT_SIZE; y++)
+    {
+        s32 dy = obj_y + y;
+
+        if (dy < 0 || dy >= TESTS_MOTION_HEIGHT)
+        {
+            continue;
+        }
+
+        for (s32 x = 0; x < TESTS_MOTION_OBJECT_SIZE; x++)
+        {
+            s32 dx = obj_x + x;
+
+            if (dx < 0 || dx >= TESTS_MOTION_WIDTH)
+            {
+                continue;
+            }
+
+            memcpy(dest + dy * TESTS_MOTION_PITCH + dx * 4, scene->object + (y * TESTS_MOTION_OBJECT_SIZE + x) * 4, 4);
+        }
+    }
+}
+
+static double tests_motion_get_psnr(const u8* a, const u8* b)
+{
+    double sum = 0.0;
+
+    for (s32 i = 0; i < TESTS_MOTION_FRAME_SIZE; i++)
+    {
+        if ((i & 3) == 3)
+        {
+            continue;
+        }
+
+        double d = (double)a[i] - (double)b[i];
+        sum += d * d;
+    }
+
+    double mse = sum / (TESTS_MOTION_WIDTH * TESTS_MOTION_HEIGHT * 3);
+
+    if (mse == 0.0)
+    {
+        return INFINITY;
+    }
+
+    return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+// The blocks that are inside the object in the next frame must point back to where the object was.
+static void tests_motion_vectors(TestsMotionScene* scene)
+{
+    u8* prev = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+    u8* next = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+
+    SvrMotionField field;
+    svr_motion_create_field(&field, TESTS_MOTION_WIDTH, TESTS_MOTION_HEIGHT);
+
+    s32 moves[][2] =
+    {
+        { 0, 0 },
+        { 5, 0 },
+        { -12, 3 },
+        { 21, -9 },
+    };
+
+    SvrMotionVector* first_vectors = SVR_ZALLOC_NUM(SvrMotionVector, (field.blocks_x * field.blocks_y));
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(moves); i++)
+    {
+        s32 x = 48;
+        s32 y = 24;
+
+        tests_motion_draw(scene, x, y, prev);
+        tests_motion_draw(scene, x + moves[i][0], y + moves[i][1], next);
+
+        for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+        {
+            svr_motion_estimate(&field, prev, TESTS_MOTION_PITCH, next, TESTS_MOTION_PITCH, level, NULL);
+
+            for (s32 by = 0; by < field.blocks_y; by++)
+            {
+                for (s32 bx = 0; bx < field.blocks_x; bx++)
+                {
+                    SvrMotionVector v = field.vectors[by * field.blocks_x + bx];
+
+                    // All levels must find the same vectors.
+                    if (level == SVR_SIMD_SCALAR)
+                    {
+                        first_vectors[by * field.blocks_x + bx] = v;
+                    }
+
+                    else
+                    {
+                        SvrMotionVector first = first_vectors[by * field.blocks_x + bx];
+                        TEST_CHECK(v.x == first.x && v.y == first.y);
+                    }
+
+                    s32 px = bx * SVR_MOTION_BLOCK;
+                    s32 py = by * SVR_MOTION_BLOCK;
+
+                    bool inside = px >= x + moves[i][0] && px + SVR_MOTION_BLOCK <= x + moves[i][0] + TESTS_MOTION_OBJECT_SIZE
+                               && py >= y + moves[i][1] && py + SVR_MOTION_BLOCK <= y + moves[i][1] + TESTS_MOTION_OBJECT_SIZE;
+
+                    if (inside)
+                    {
+                        TEST_CHECK(v.x == -moves[i][0] && v.y == -moves[i][1]);
+                    }
+                }
+            }
+        }
+    }
+
+    svr_free(first_vectors);
+    svr_motion_free_field(&field);
+    svr_free(prev);
+    svr_free(next);
+}
+
+// Motion blur from a few game frames with sub-frames made between them must be closer to the motion blur from every sub-frame
+// than the few game frames alone. The object moves two pixels for every sub-frame.
+static void tests_motion_subframes(TestsMotionScene* scene, s32 num_game_frames, s32 num_subframes, float exposure)
+{
+    const s32 SPEED = 2;
+
+    s32 mult = num_game_frames * num_subframes;
+    s32 start_x = 8;
+    s32 y = 30;
+
+    u8* prev = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+    u8* next = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+    u8* temp = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+    u8* all_result = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+    u8* few_result = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+    u8* made_result = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+
+    SvrMotionField field;
+    svr_motion_create_field(&field, TESTS_MOTION_WIDTH, TESTS_MOTION_HEIGHT);
+
+    SvrMosampleBuffer buf;
+    svr_mosample_create_buffer(&buf, TESTS_MOTION_WIDTH, TESTS_MOTION_HEIGHT);
+
+    // Every sub-frame.
+    SvrMosampleTimer timer;
+    svr_mosample_timer_init(&timer, mult, exposure, false);
+    svr_mosample_clear(&buf);
+
+    for (s32 i = 1; i <= mult; i++)
+    {
+        SvrMosampleStep step;
+        svr_mosample_timer_step(&timer, &step);
+
+        tests_motion_draw(scene, start_x + i * SPEED, y, next);
+        svr_mosample_add(&buf, next, TESTS_MOTION_PITCH, step.weight, SVR_SIMD_SCALAR, NULL);
+    }
+
+    svr_mosample_downsample(&buf, all_result, TESTS_MOTION_PITCH, SVR_SIMD_SCALAR, NULL);
+
+    // Only the game frames, and the game frames with made sub-frames.
+    for (s32 made = 0; made < 2; made++)
+    {
+        svr_mosample_timer_init(&timer, num_game_frames, exposure, false);
+        svr_mosample_clear(&buf);
+
+        tests_motion_draw(scene, start_x, y, prev);
+
+        for (s32 i = 1; i <= num_game_frames; i++)
+        {
+            SvrMosampleStep step;
+            svr_mosample_timer_step(&timer, &step);
+
+            tests_motion_draw(scene, start_x + i * num_subframes * SPEED, y, next);
+
+            if (step.weight > 0.0f)
+            {
+                if (made)
+                {
+                    float open_part = svr_min(step.weight * timer.open_len / step.num_steps, 1.0f);
+                    svr_motion_add_subframes(&field, &buf, prev, TESTS_MOTION_PITCH, next, TESTS_MOTION_PITCH, open_part, num_subframes, step.weight, temp, svr_simd_get_best_level(), NULL);
+                }
+
+                else
+                {
+                    svr_mosample_add(&buf, next, TESTS_MOTION_PITCH, step.weight, SVR_SIMD_SCALAR, NULL);
+                }
+            }
+
+            memcpy(prev, next, TESTS_MOTION_FRAME_SIZE);
+        }
+
+        svr_mosample_downsample(&buf, made ? made_result : few_result, TESTS_MOTION_PITCH, SVR_SIMD_SCALAR, NULL);
+    }
+
+    double few_psnr = tests_motion_get_psnr(all_result, few_result);
+    double made_psnr = tests_motion_get_psnr(all_result, made_result);
+
+    // Blocks on the edges of the object have both the object and the background, so those do not get better.
+    TEST_CHECK(made_psnr > few_psnr + 1.0);
+    TEST_CHECK(made_psnr > 33.0);
+
+    svr_mosample_free_buffer(&buf);
+    svr_motion_free_field(&field);
+    svr_free(prev);
+    svr_free(next);
+    svr_free(temp);
+    svr_free(all_result);
+    svr_free(few_result);
+    svr_free(made_result);
+}
+
+// Without motion the made sub-frames are the same as the game frame.
+static void tests_motion_still(TestsMotionScene* scene)
+{
+    u8* frame = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+    u8* temp = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+    u8* result = (u8*)svr_alloc(TESTS_MOTION_FRAME_SIZE);
+
+    tests_motion_draw(scene, 20, 20, frame);
+
+    SvrMotionField field;
+    svr_motion_create_field(&field, TESTS_MOTION_WIDTH, TESTS_MOTION_HEIGHT);
+
+    SvrMosampleBuffer buf;
+    svr_mosample_create_buffer(&buf, TESTS_MOTION_WIDTH, TESTS_MOTION_HEIGHT);
+
+    svr_motion_add_subframes(&field, &buf, frame, TESTS_MOTION_PITCH, frame, TESTS_MOTION_PITCH, 1.0f, 8, 1.0f, temp, svr_simd_get_best_level(), NULL);
+    svr_mosample_downsample(&buf, result, TESTS_MOTION_PITCH, SVR_SIMD_SCALAR, NULL);
+
+    TEST_CHECK(!memcmp(frame, result, TESTS_MOTION_FRAME_SIZE));
+
+    svr_mosample_free_buffer(&buf);
+    svr_motion_free_field(&field);
+    svr_free(frame);
+    svr_free(temp);
+    svr_free(result);
+}
+
+void tests_motion()
+{
+    TestsMotionScene scene;
+    tests_motion_make_scene(&scene);
+
+    tests_motion_vectors(&scene);
+    tests_motion_still(&scene);
+    tests_motion_subframes(&scene, 4, 4, 1.0f);
+    tests_motion_subframes(&scene, 8, 4, 0.5f);
+
+    tests_motion_free_scene(&scene);
+}
@@ -0,0 +1,210 @@
+#include "tests_priv.h"
+#include "svr_pe.h"
+
+// Tests of reading PE headers and getting the code and data ranges, with small PE images.
+
+const s32 TESTS_PE_IMAGE_SIZE = 0x1000;
+
+static const TestsPeSection TESTS_PE_SECTIONS[] =
+{
+    // Two code sections next to each other with a gap less than a page, which are one range.
+    TestsPeSection { ".text", 0x1000, 0x1800, 0x1800, SVR_PE_SECTION_CODE | SVR_PE_SECTION_EXECUTE },
+    TestsPeSection { ".text2", 0x3000, 0x100, 0x200, SVR_PE_SECTION_EXECUTE },
+    TestsPeSection { ".rdata", 0x4000, 0x1000, 0x1000, SVR_PE_SECTION_INIT_DATA },
+    TestsPeSection { ".data", 0x5000, 0x800, 0x200, SVR_PE_SECTION_INIT_DATA },
+    TestsPeSection { ".bss", 0x6000, 0x400, 0, SVR_PE_SECTION_UNINIT_DATA },
+
+    // A page away from the last code section, so it is its own range. The virtual size is 0 so the raw size is used.
+    TestsPeSection { ".lookslong", 0x8000, 0, 0x300, SVR_PE_SECTION_CODE },
+
+    // Neither code nor data.
+    TestsPeSection { ".reloc", 0x9000, 0x100, 0x200, 0 },
+
+    // Past the end of the image, so it is not in any range.
+    TestsPeSection { ".late", 0xb000, 0x100, 0x200, SVR_PE_SECTION_CODE },
+};
+
+const u32 TESTS_PE_IMAGE_END = 0xa000;
+
+static s32 tests_pe_make(u8* image, const TestsPeSection* sections, s32 num_sections)
+{
+    memset(image, 0xcc, TESTS_PE_IMAGE_SIZE);
+    return tests_make_pe_image(image, 0x5f000000, TESTS_PE_IMAGE_END, sections, num_sections);
+}
+
+static void tests_pe_read()
+{
+    u8* image = (u8*)svr_alloc(TESTS_PE_IMAGE_SIZE);
+    s32 headers_size = tests_pe_make(image, TESTS_PE_SECTIONS, SVR_ARRAY_SIZE(TESTS_PE_SECTIONS));
+
+    SvrPeInfo info;
+    TEST_CHECK(svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &info));
+    TEST_CHECK(info.machine == 0x8664);
+    TEST_CHECK(info.timestamp == 0x5f000000);
+    TEST_CHECK(info.image_size == TESTS_PE_IMAGE_END);
+    TEST_CHECK(info.num_sections == SVR_ARRAY_SIZE(TESTS_PE_SECTIONS));
+
+    for (s32 i = 0; i < svr_min(info.num_sections, (s32)SVR_ARRAY_SIZE(TESTS_PE_SECTIONS)); i++)
+    {
+        const TestsPeSection* a = &TESTS_PE_SECTIONS[i];
+        const SvrPeSection* b = &info.sections[i];
+
+        // Names are cut to 8 characters.
+        TEST_CHECK(!strncmp(a->name, b->name, 8) && strlen(b->name) <= 8);
+        TEST_CHECK(a->rva == b->rva && a->virtual_size == b->virtual_size && a->raw_size == b->raw_size);
+        TEST_CHECK(a->characteristics == b->characteristics);
+    }
+
+    // Every cut of the headers is refused.
+    for (s32 i = 0; i < headers_size; i++)
+    {
+        TEST_CHECK(!svr_pe_read_info(image, i, &info));
+    }
+
+    TEST_CHECK(svr_pe_read_info(image, headers_size, &info));
+
+    // Broken signatures.
+    image[1] = 'X';
+    TEST_CHECK(!svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &info));
+    image[1] = 'Z';
+
+    image[0x40 + 1] = 'X';
+    TEST_CHECK(!svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &info));
+    image[0x40 + 1] = 'E';
+
+    // A position of the PE header that is past the data.
+    u32 nt_pos = 0x7ffffff0;
+    memcpy(image + 0x3c, &nt_pos, sizeof(nt_pos));
+    TEST_CHECK(!svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &info));
+    nt_pos = 0x40;
+    memcpy(image + 0x3c, &nt_pos, sizeof(nt_pos));
+
+    // An optional header that is too small to have the image size.
+    u16 opt_size = 32;
+    memcpy(image + 0x40 + 4 + 16, &opt_size, sizeof(opt_size));
+    TEST_CHECK(!svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &info));
+    opt_size = 240;
+    memcpy(image + 0x40 + 4 + 16, &opt_size, sizeof(opt_size));
+
+    // More sections than the loader allows.
+    u16 num_sections = SVR_PE_MAX_SECTIONS + 1;
+    memcpy(image + 0x40 + 4 + 2, &num_sections, sizeof(num_sections));
+    TEST_CHECK(!svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &info));
+
+    TEST_CHECK(!svr_pe_read_info(image, 0, &info));
+
+    svr_free(image);
+}
+
+static void tests_pe_section_hash()
+{
+    u8* image = (u8*)svr_alloc(TESTS_PE_IMAGE_SIZE);
+    s32 headers_size = tests_pe_make(image, TESTS_PE_SECTIONS, SVR_ARRAY_SIZE(TESTS_PE_SECTIONS));
+
+    SvrPeInfo a;
+    SvrPeInfo b;
+    TEST_CHECK(svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &a));
+
+    // Bytes after the headers are not part of the hash.
+    image[headers_size] ^= 0xff;
+    TEST_CHECK(svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &b));
+    TEST_CHECK(a.section_hash == b.section_hash);
+
+    TestsPeSection sections[SVR_ARRAY_SIZE(TESTS_PE_SECTIONS)];
+    memcpy(sections, TESTS_PE_SECTIONS, sizeof(sections));
+    sections[3].raw_size += 0x200;
+
+    tests_pe_make(image, sections, SVR_ARRAY_SIZE(sections));
+    TEST_CHECK(svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &b));
+    TEST_CHECK(a.section_hash != b.section_hash);
+
+    svr_free(image);
+}
+
+static void tests_pe_sections()
+{
+    u8* image = (u8*)svr_alloc(TESTS_PE_IMAGE_SIZE);
+    tests_pe_make(image, TESTS_PE_SECTIONS, SVR_ARRAY_SIZE(TESTS_PE_SECTIONS));
+
+    SvrPeInfo info;
+    TEST_CHECK(svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &info));
+
+    // The larger of the virtual and raw size is used, and the end is not included.
+    TEST_CHECK(svr_pe_find_section(&info, 0xfff) == NULL);
+    TEST_CHECK(svr_pe_find_section(&info, 0x1000) == &info.sections[0]);
+    TEST_CHECK(svr_pe_find_section(&info, 0x27ff) == &info.sections[0]);
+    TEST_CHECK(svr_pe_find_section(&info, 0x2800) == NULL);
+    TEST_CHECK(svr_pe_find_section(&info, 0x31ff) == &info.sections[1]);
+    TEST_CHECK(svr_pe_find_section(&info, 0x3200) == NULL);
+    TEST_CHECK(svr_pe_find_section(&info, 0x57ff) == &info.sections[3]);
+    TEST_CHECK(svr_pe_find_section(&info, 0x82ff) == &info.sections[5]);
+    TEST_CHECK(svr_pe_find_section(&info, 0xffffffff) == NULL);
+
+    TEST_CHECK(svr_pe_is_section_type(&info.sections[0], SVR_PE_RANGE_CODE));
+    TEST_CHECK(!svr_pe_is_section_type(&info.sections[0], SVR_PE_RANGE_DATA));
+    TEST_CHECK(svr_pe_is_section_type(&info.sections[1], SVR_PE_RANGE_CODE));
+    TEST_CHECK(svr_pe_is_section_type(&info.sections[3], SVR_PE_RANGE_DATA));
+    TEST_CHECK(!svr_pe_is_section_type(&info.sections[3], SVR_PE_RANGE_CODE));
+    TEST_CHECK(svr_pe_is_section_type(&info.sections[4], SVR_PE_RANGE_DATA));
+    TEST_CHECK(!svr_pe_is_section_type(&info.sections[6], SVR_PE_RANGE_CODE));
+    TEST_CHECK(!svr_pe_is_section_type(&info.sections[6], SVR_PE_RANGE_DATA));
+
+    // Code that also has initialized data is code.
+    SvrPeSection both = info.sections[0];
+    both.characteristics |= SVR_PE_SECTION_INIT_DATA;
+    TEST_CHECK(svr_pe_is_section_type(&both, SVR_PE_RANGE_CODE));
+    TEST_CHECK(!svr_pe_is_section_type(&both, SVR_PE_RANGE_DATA));
+
+    svr_free(image);
+}
+
+static void tests_pe_ranges()
+{
+    u8* image = (u8*)svr_alloc(TESTS_PE_IMAGE_SIZE);
+    tests_pe_make(image, TESTS_PE_SECTIONS, SVR_ARRAY_SIZE(TESTS_PE_SECTIONS));
+
+    SvrPeInfo info;
+    TEST_CHECK(svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &info));
+
+    SvrPeRange ranges[SVR_PE_MAX_SECTIONS];
+
+    s32 num_code = svr_pe_get_ranges(&info, SVR_PE_RANGE_CODE, ranges, SVR_ARRAY_SIZE(ranges));
+    TEST_CHECK(num_code == 2);
+    TEST_CHECK(ranges[0].start == 0x1000 && ranges[0].end == 0x3100);
+    TEST_CHECK(ranges[1].start == 0x8000 && ranges[1].end == 0x8300);
+
+    // The data sections are all next to each other.
+    s32 num_data = svr_pe_get_ranges(&info, SVR_PE_RANGE_DATA, ranges, SVR_ARRAY_SIZE(ranges));
+    TEST_CHECK(num_data == 1);
+    TEST_CHECK(ranges[0].start == 0x4000 && ranges[0].end == 0x6400);
+
+    // With too little room the count is still right and only the first ranges are written.
+    SvrPeRange few[2] = {};
+    TEST_CHECK(svr_pe_get_ranges(&info, SVR_PE_RANGE_CODE, few, 1) == 2);
+    TEST_CHECK(few[0].start == 0x1000 && few[0].end == 0x3100);
+    TEST_CHECK(few[1].start == 0 && few[1].end == 0);
+
+    TEST_CHECK(svr_pe_get_ranges(&info, SVR_PE_RANGE_CODE, NULL, 0) == 2);
+
+    // A section that goes past the end of the image is cut.
+    TestsPeSection sections[SVR_ARRAY_SIZE(TESTS_PE_SECTIONS)];
+    memcpy(sections, TESTS_PE_SECTIONS, sizeof(sections));
+    sections[5].virtual_size = 0x4000;
+
+    tests_pe_make(image, sections, SVR_ARRAY_SIZE(sections));
+    TEST_CHECK(svr_pe_read_info(image, TESTS_PE_IMAGE_SIZE, &info));
+
+    num_code = svr_pe_get_ranges(&info, SVR_PE_RANGE_CODE, ranges, SVR_ARRAY_SIZE(ranges));
+    TEST_CHECK(num_code == 2);
+    TEST_CHECK(ranges[1].start == 0x8000 && ranges[1].end == TESTS_PE_IMAGE_END);
+
+    svr_free(image);
+}
+
+void tests_pe()
+{
+    tests_pe_read();
+    tests_pe_section_hash();
+    tests_pe_sections();
+    tests_pe_ranges();
+}
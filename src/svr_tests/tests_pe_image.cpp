@@ -0,0 +1,57 @@
+#include "tests_priv.h"
+
+// Small PE images for the tests of svr_pe and svr_scan_cache, since no real library can be shipped.
+// Only the fields that svr_pe reads are written, the rest of the headers is zero.
+
+const s32 TESTS_PE_NT_POS = 0x40;
+const s32 TESTS_PE_OPT_SIZE = 240; // Size of the 64 bit optional header.
+
+static void tests_pe_write_u16(u8* dest, u16 value)
+{
+    memcpy(dest, &value, sizeof(value));
+}
+
+static void tests_pe_write_u32(u8* dest, u32 value)
+{
+    memcpy(dest, &value, sizeof(value));
+}
+
+s32 tests_make_pe_image(u8* dest, u32 timestamp, u32 image_size, const TestsPeSection* sections, s32 num_sections)
+{
+    s32 sections_pos = TESTS_PE_NT_POS + 24 + TESTS_PE_OPT_SIZE;
+    s32 headers_size = sections_pos + num_sections * 40;
+
+    memset(dest, 0, headers_size);
+
+    dest[0] = 'M';
+    dest[1] = 'Z';
+    tests_pe_write_u32(dest + 0x3c, TESTS_PE_NT_POS);
+
+    u8* nt = dest + TESTS_PE_NT_POS;
+    memcpy(nt, "PE\0\0", 4);
+
+    u8* file_header = nt + 4;
+    tests_pe_write_u16(file_header, 0x8664);
+    tests_pe_write_u16(file_header + 2, (u16)num_sections);
+    tests_pe_write_u32(file_header + 4, timestamp);
+    tests_pe_write_u16(file_header + 16, TESTS_PE_OPT_SIZE);
+
+    u8* opt_header = nt + 24;
+    tests_pe_write_u16(opt_header, 0x20b);
+    tests_pe_write_u32(opt_header + 56, image_size);
+
+    for (s32 i = 0; i < num_sections; i++)
+    {
+        const TestsPeSection* section = &sections[i];
+        u8* header = dest + sections_pos + i * 40;
+
+        memcpy(header, section->name, svr_min((s32)strlen(section->name), 8));
+        tests_pe_write_u32(header + 8, section->virtual_size);
+        tests_pe_write_u32(header + 12, section->rva);
+        tests_pe_write_u32(header + 16, section->raw_size);
+        tests_pe_write_u32(header + 20, section->rva); // Same as loaded.
+        tests_pe_write_u32(header + 36, section->characteristics);
+    }
+
+    return headers_size;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "svr_common.h"
+#include "svr_alloc.h"
+#include "svr_atom.h"
+#include "svr_thread.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+// Tests of the parts of svr_common that can be built everywhere, built as svr_tests.
+// Every group is a function that checks one module. The groups to run are given on the command line, or all of them when there are none.
+// A failed check is printed and the group continues, so one run shows every failure.
+
+#define TEST_CHECK(EXPR) tests_check((EXPR), #EXPR, SVR_FILE_LOCATION)
+
+void tests_check(bool value, const char* expr, const char* location);
+
+// Small PE images for the tests of svr_pe and svr_scan_cache, in tests_pe_image.cpp.
+struct TestsPeSection
+{
+    const char* name;
+    u32 rva;
+    u32 virtual_size;
+    u32 raw_size;
+    u32 characteristics;
+};
+
+// Writes the headers to the start of dest, which must have room for them, and returns their size.
+s32 tests_make_pe_image(u8* dest, u32 timestamp, u32 image_size, const TestsPeSection* sections, s32 num_sections);
+
+void tests_ring();
+void tests_color();
+void tests_copy();
+void tests_slot_ring();
+void tests_ipc();
+void tests_mosample();
+void tests_frame_steps();
+void tests_motion();
+void tests_glyphs();
+void tests_scan();
+void tests_scan_cache();
+void tests_pe();
+void tests_wave();
+void tests_trace();
+void tests_reorder();
+void tests_stats();
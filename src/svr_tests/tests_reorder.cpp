@@ -0,0 +1,334 @@
+#include "tests_priv.h"
+#include "svr_reorder.h"
+#include "svr_ring.h"
+#include <stdlib.h>
+
+// Tests of putting packets back in order, and of the timestamps of a stream that is put together from chunks.
+// The chunks are made the way an encoder with delayed frames makes them, and are given from several threads like the video workers do.
+
+const s32 TESTS_REORDER_NUM_CHUNKS = 24;
+const s32 TESTS_REORDER_CHUNK_FRAMES = 37; // Not a multiple of any delay, so every chunk ends with a short group.
+const s32 TESTS_REORDER_NUM_WORKERS = 3;
+const s32 TESTS_REORDER_QUEUE_SIZE = 256;
+
+struct TestsReorderPacket
+{
+    s64 chunk_idx;
+    s64 pts; // In the context of the chunk until it is stitched.
+    s64 dts;
+    bool end; // Marks the end of a chunk.
+};
+
+// Presentation timestamps in decode order for a context that delays frames, like an encoder with B-frames.
+// Every group starts with the frame it will be shown last, and the frames before it follow.
+// The decode timestamps are the index minus the delay, so every packet is decoded before it is shown.
+static void tests_reorder_make_chunk(s32 delay, s64* pts)
+{
+    s32 num = 0;
+    s32 start = 1;
+
+    pts[num] = 0;
+    num++;
+
+    while (start < TESTS_REORDER_CHUNK_FRAMES)
+    {
+        s32 group = svr_min(delay + 1, TESTS_REORDER_CHUNK_FRAMES - start);
+
+        pts[num] = start + group - 1;
+        num++;
+
+        for (s32 i = 0; i < group - 1; i++)
+        {
+            pts[num] = start + i;
+            num++;
+        }
+
+        start += group;
+    }
+}
+
+static void tests_reorder_frames()
+{
+    SvrReorder<s64> reorder;
+    reorder.init(4);
+
+    // One item for every index, given in a random order.
+    const s32 NUM = 200;
+    s64 idxs[NUM];
+
+    for (s32 i = 0; i < NUM; i++)
+    {
+        idxs[i] = i;
+    }
+
+    for (s32 i = NUM - 1; i > 0; i--)
+    {
+        s32 j = rand() % (i + 1);
+        s64 temp = idxs[i];
+        idxs[i] = idxs[j];
+        idxs[j] = temp;
+    }
+
+    s64 next = 0;
+    bool right = true;
+
+    for (s32 i = 0; i < NUM; i++)
+    {
+        reorder.push(idxs[i], true, idxs[i] * 10);
+
+        s64 item;
+        s64 idx;
+
+        while (reorder.pull(&item, &idx, false))
+        {
+            right &= idx == next && item == next * 10;
+            next++;
+        }
+    }
+
+    TEST_CHECK(right);
+    TEST_CHECK(next == NUM);
+    TEST_CHECK(reorder.size() == 0);
+
+    // Nothing comes out before its turn, and flushing skips the holes.
+    reorder.clear(0);
+    reorder.push(5, true, 50);
+    reorder.push(2, false, 20);
+    reorder.push(2, false, 21);
+    reorder.push(9, true, 90);
+
+    s64 item;
+    s64 idx;
+    TEST_CHECK(!reorder.pull(&item, &idx, false));
+
+    // The items of an index come out in the order they were added, and the index does not end without its last item.
+    TEST_CHECK(reorder.pull(&item, &idx, true) && idx == 2 && item == 20);
+    TEST_CHECK(reorder.pull(&item, &idx, false) && idx == 2 && item == 21);
+    TEST_CHECK(!reorder.pull(&item, &idx, false));
+    TEST_CHECK(reorder.pull(&item, &idx, true) && idx == 5 && item == 50);
+    TEST_CHECK(reorder.pull(&item, &idx, true) && idx == 9 && item == 90);
+    TEST_CHECK(!reorder.pull(&item, &idx, true));
+
+    reorder.free();
+}
+
+struct TestsReorderWorker
+{
+    SvrThread thread;
+    s32 idx;
+    s32 delays[TESTS_REORDER_NUM_CHUNKS]; // Delay of the context of every chunk.
+    SvrMpmcRing<TestsReorderPacket>* queue;
+};
+
+static void tests_reorder_push_wait(SvrMpmcRing<TestsReorderPacket>* queue, TestsReorderPacket* packet)
+{
+    while (!queue->push(packet))
+    {
+        svr_thread_yield();
+    }
+}
+
+// Takes every chunk in turn with the other workers, and sometimes lets them get ahead.
+static void tests_reorder_worker_proc(void* param)
+{
+    TestsReorderWorker* worker = (TestsReorderWorker*)param;
+    s64 pts[TESTS_REORDER_CHUNK_FRAMES];
+
+    for (s32 c = worker->idx; c < TESTS_REORDER_NUM_CHUNKS; c += TESTS_REORDER_NUM_WORKERS)
+    {
+        s32 delay = worker->delays[c];
+        tests_reorder_make_chunk(delay, pts);
+
+        for (s32 i = 0; i < TESTS_REORDER_CHUNK_FRAMES; i++)
+        {
+            TestsReorderPacket packet = {};
+            packet.chunk_idx = c;
+            packet.pts = pts[i];
+            packet.dts = i - delay;
+
+            tests_reorder_push_wait(worker->queue, &packet);
+
+            if ((c + i) % 7 == 0)
+            {
+                svr_thread_yield();
+            }
+        }
+
+        TestsReorderPacket end = {};
+        end.chunk_idx = c;
+        end.end = true;
+
+        tests_reorder_push_wait(worker->queue, &end);
+    }
+}
+
+// Same as the packet thread: every packet goes through the reorder, and the ones whose turn it is are stitched.
+// Returns the number of packets that could be stitched, which stops at the first one that cannot.
+static s32 tests_reorder_stitch(const s32* delays, s64* stream_pts, s64* stream_dts, s64* chunk_idxs)
+{
+    SvrMpmcRing<TestsReorderPacket> queue = {};
+    queue.init(TESTS_REORDER_QUEUE_SIZE);
+
+    TestsReorderWorker workers[TESTS_REORDER_NUM_WORKERS] = {};
+
+    for (s32 i = 0; i < TESTS_REORDER_NUM_WORKERS; i++)
+    {
+        workers[i].idx = i;
+        workers[i].queue = &queue;
+        memcpy(workers[i].delays, delays, sizeof(workers[i].delays));
+
+        svr_thread_start(&workers[i].thread, tests_reorder_worker_proc, &workers[i]);
+    }
+
+    SvrReorder<TestsReorderPacket> reorder;
+    reorder.init(16);
+
+    SvrStitchTimes times;
+    svr_stitch_start(&times);
+
+    s32 num_ends = 0;
+    s32 num_written = 0;
+    bool failed = false;
+
+    while (num_ends < TESTS_REORDER_NUM_CHUNKS)
+    {
+        TestsReorderPacket packet;
+
+        if (!queue.pull(&packet))
+        {
+            svr_thread_yield();
+            continue;
+        }
+
+        if (packet.end)
+        {
+            num_ends++;
+        }
+
+        reorder.push(packet.chunk_idx, packet.end, packet);
+
+        s64 idx;
+
+        while (reorder.pull(&packet, &idx, false))
+        {
+            if (packet.end || failed)
+            {
+                continue;
+            }
+
+            svr_stitch_offset(idx * TESTS_REORDER_CHUNK_FRAMES, &packet.pts, &packet.dts);
+
+            if (!svr_stitch_check(&times, packet.pts, packet.dts))
+            {
+                failed = true;
+                continue;
+            }
+
+            stream_pts[num_written] = packet.pts;
+            stream_dts[num_written] = packet.dts;
+            chunk_idxs[num_written] = idx;
+            num_written++;
+        }
+    }
+
+    TEST_CHECK(reorder.size() == 0);
+
+    for (s32 i = 0; i < TESTS_REORDER_NUM_WORKERS; i++)
+    {
+        svr_thread_join(&workers[i].thread);
+    }
+
+    reorder.free();
+    queue.free();
+
+    return num_written;
+}
+
+static void tests_reorder_chunks()
+{
+    const s32 NUM_PACKETS = TESTS_REORDER_NUM_CHUNKS * TESTS_REORDER_CHUNK_FRAMES;
+
+    s64* stream_pts = (s64*)svr_alloc(sizeof(s64) * NUM_PACKETS);
+    s64* stream_dts = (s64*)svr_alloc(sizeof(s64) * NUM_PACKETS);
+    s64* chunk_idxs = (s64*)svr_alloc(sizeof(s64) * NUM_PACKETS);
+    bool* shown = (bool*)svr_alloc(sizeof(bool) * NUM_PACKETS);
+
+    s32 delays[TESTS_REORDER_NUM_CHUNKS];
+
+    for (s32 delay = 0; delay <= 3; delay++)
+    {
+        for (s32 i = 0; i < TESTS_REORDER_NUM_CHUNKS; i++)
+        {
+            delays[i] = delay;
+        }
+
+        TEST_CHECK(tests_reorder_stitch(delays, stream_pts, stream_dts, chunk_idxs) == NUM_PACKETS);
+
+        // The chunks are in order, and the decode timestamps are the same as one context would have made.
+        bool right = true;
+        memset(shown, 0, sizeof(bool) * NUM_PACKETS);
+
+        for (s32 i = 0; i < NUM_PACKETS; i++)
+        {
+            right &= chunk_idxs[i] == i / TESTS_REORDER_CHUNK_FRAMES;
+            right &= stream_dts[i] == i - delay;
+            right &= stream_pts[i] >= stream_dts[i];
+            right &= stream_pts[i] >= 0 && stream_pts[i] < NUM_PACKETS && !shown[stream_pts[i]];
+
+            if (stream_pts[i] >= 0 && stream_pts[i] < NUM_PACKETS)
+            {
+                shown[stream_pts[i]] = true;
+            }
+        }
+
+        TEST_CHECK(right);
+    }
+
+    // A context that delays more than the one before it would decode before the previous chunk ends.
+    // The stream must stop there, and not go on with packets that are moved one at a time.
+    for (s32 i = 0; i < TESTS_REORDER_NUM_CHUNKS; i++)
+    {
+        delays[i] = i == 5 ? 2 : 1;
+    }
+
+    s32 num_written = tests_reorder_stitch(delays, stream_pts, stream_dts, chunk_idxs);
+    TEST_CHECK(num_written == 5 * TESTS_REORDER_CHUNK_FRAMES);
+
+    // Less delay than the chunk before leaves a gap, which is fine to decode.
+    for (s32 i = 0; i < TESTS_REORDER_NUM_CHUNKS; i++)
+    {
+        delays[i] = i < 5 ? 2 : 1;
+    }
+
+    TEST_CHECK(tests_reorder_stitch(delays, stream_pts, stream_dts, chunk_idxs) == NUM_PACKETS);
+
+    svr_free(shown);
+    svr_free(chunk_idxs);
+    svr_free(stream_dts);
+    svr_free(stream_pts);
+}
+
+static void tests_reorder_check()
+{
+    SvrStitchTimes times;
+    svr_stitch_start(&times);
+
+    // The first packet can decode before 0.
+    TEST_CHECK(svr_stitch_check(&times, 0, -2));
+    TEST_CHECK(svr_stitch_check(&times, 3, -1));
+    TEST_CHECK(!svr_stitch_check(&times, 3, -1));
+    TEST_CHECK(!svr_stitch_check(&times, 4, -5));
+
+    // Never decoded after it is shown.
+    TEST_CHECK(!svr_stitch_check(&times, 5, 6));
+    TEST_CHECK(svr_stitch_check(&times, 5, 5));
+}
+
+void tests_reorder()
+{
+    srand(4);
+
+    tests_reorder_frames();
+    tests_reorder_check();
+    tests_reorder_chunks();
+}
@@ -0,0 +1,309 @@
+#include "tests_priv.h"
+#include "svr_ring.h"
+#include "svr_locked_queue.h"
+
+// Tests of the lock free rings and the locked queue they replaced.
+
+const s32 TESTS_RING_CAPACITY = 16;
+const s32 TESTS_RING_ITEMS = 200000; // Per producer for the threaded tests.
+const s32 TESTS_RING_PRODUCERS = 3;
+const s32 TESTS_RING_CONSUMERS = 2;
+
+// Items are the producer index in the high bits and a sequence in the low bits, so the consumer can check the order.
+static u32 tests_ring_make_item(s32 producer, s32 seq)
+{
+    return ((u32)producer << 24) | (u32)seq;
+}
+
+template <class Ring>
+static void tests_ring_single_thread(Ring* ring)
+{
+    u32 item;
+
+    TEST_CHECK(!ring->pull(&item));
+
+    for (s32 i = 0; i < TESTS_RING_CAPACITY; i++)
+    {
+        item = i;
+        TEST_CHECK(ring->push(&item));
+    }
+
+    item = 1234;
+    TEST_CHECK(!ring->push(&item)); // Full.
+    TEST_CHECK(ring->size() == TESTS_RING_CAPACITY);
+
+    for (s32 i = 0; i < TESTS_RING_CAPACITY; i++)
+    {
+        TEST_CHECK(ring->pull(&item));
+        TEST_CHECK(item == (u32)i);
+    }
+
+    TEST_CHECK(!ring->pull(&item));
+    TEST_CHECK(ring->size() == 0);
+
+    // Go around many times with a few items in the ring so the mask is used.
+    s32 next_push = 0;
+    s32 next_pull = 0;
+
+    for (s32 i = 0; i < TESTS_RING_CAPACITY * 10; i++)
+    {
+        for (s32 j = 0; j < 3; j++)
+        {
+            item = next_push;
+            TEST_CHECK(ring->push(&item));
+            next_push++;
+        }
+
+        for (s32 j = 0; j < 3; j++)
+        {
+            TEST_CHECK(ring->pull(&item));
+            TEST_CHECK(item == (u32)next_pull);
+            next_pull++;
+        }
+    }
+}
+
+// The indexes are free running and must keep working when they overflow.
+static void tests_ring_spsc_overflow()
+{
+    SvrSpscRing<u32> ring = {};
+    ring.init(TESTS_RING_CAPACITY);
+
+    s32 start = (s32)0xfffffff8;
+    svr_atom_store(&ring.write_idx, start);
+    svr_atom_store(&ring.read_idx, start);
+    ring.cached_read_idx = start;
+    ring.cached_write_idx = start;
+
+    tests_ring_single_thread(&ring);
+
+    ring.free();
+}
+
+static void tests_ring_mpmc_overflow()
+{
+    SvrMpmcRing<u32> ring = {};
+    ring.init(TESTS_RING_CAPACITY);
+
+    s32 start = (s32)0xfffffff8;
+    svr_atom_store(&ring.write_idx, start);
+    svr_atom_store(&ring.read_idx, start);
+
+    // Every cell must be ready to be written on the lap the indexes start at.
+    for (s32 i = 0; i < TESTS_RING_CAPACITY; i++)
+    {
+        s32 pos = start + i;
+        svr_atom_store(&ring.cells[pos & ring.mask].seq, pos);
+    }
+
+    tests_ring_single_thread(&ring);
+
+    ring.free();
+}
+
+struct TestsSpscState
+{
+    SvrSpscRing<u32> ring;
+    bool in_order;
+};
+
+static void tests_ring_spsc_producer(void* param)
+{
+    TestsSpscState* state = (TestsSpscState*)param;
+
+    for (s32 i = 0; i < TESTS_RING_ITEMS; i++)
+    {
+        u32 item = tests_ring_make_item(0, i);
+
+        while (!state->ring.push(&item))
+        {
+            svr_thread_yield();
+        }
+    }
+}
+
+static void tests_ring_spsc_threads()
+{
+    TestsSpscState state = {};
+    state.ring.init(TESTS_RING_CAPACITY);
+    state.in_order = true;
+
+    SvrThread producer = {};
+    TEST_CHECK(svr_thread_start(&producer, tests_ring_spsc_producer, &state));
+
+    for (s32 i = 0; i < TESTS_RING_ITEMS; i++)
+    {
+        u32 item;
+
+        while (!state.ring.pull(&item))
+        {
+            svr_thread_yield();
+        }
+
+        if (item != tests_ring_make_item(0, i))
+        {
+            state.in_order = false;
+        }
+    }
+
+    svr_thread_join(&producer);
+
+    TEST_CHECK(state.in_order);
+    TEST_CHECK(state.ring.size() == 0);
+
+    state.ring.free();
+}
+
+struct TestsMpmcState;
+
+struct TestsMpmcThread
+{
+    TestsMpmcState* state;
+    s32 index;
+};
+
+struct TestsMpmcState
+{
+    SvrMpmcRing<u32> ring;
+    SvrAtom32 num_pulled;
+    SvrAtom32 num_seen[TESTS_RING_PRODUCERS * TESTS_RING_ITEMS];
+    SvrAtom32 num_out_of_order;
+};
+
+static void tests_ring_mpmc_producer(void* param)
+{
+    TestsMpmcThread* thread = (TestsMpmcThread*)param;
+
+    for (s32 i = 0; i < TESTS_RING_ITEMS; i++)
+    {
+        u32 item = tests_ring_make_item(thread->index, i);
+
+        while (!thread->state->ring.push(&item))
+        {
+            svr_thread_yield();
+        }
+    }
+}
+
+static void tests_ring_mpmc_consumer(void* param)
+{
+    TestsMpmcThread* thread = (TestsMpmcThread*)param;
+    TestsMpmcState* state = thread->state;
+
+    // Items from the same producer must come out in the order they were pushed, also when seen by one consumer.
+    s32 last_seq[TESTS_RING_PRODUCERS];
+
+    for (s32 i = 0; i < TESTS_RING_PRODUCERS; i++)
+    {
+        last_seq[i] = -1;
+    }
+
+    while (svr_atom_load(&state->num_pulled) < TESTS_RING_PRODUCERS * TESTS_RING_ITEMS)
+    {
+        u32 item;
+
+        if (!state->ring.pull(&item))
+        {
+            svr_thread_yield();
+            continue;
+        }
+
+        s32 producer = item >> 24;
+        s32 seq = item & 0xffffff;
+
+        if (seq <= last_seq[producer])
+        {
+            svr_atom_add(&state->num_out_of_order, 1);
+        }
+
+        last_seq[producer] = seq;
+
+        svr_atom_add(&state->num_seen[producer * TESTS_RING_ITEMS + seq], 1);
+        svr_atom_add(&state->num_pulled, 1);
+    }
+}
+
+static void tests_ring_mpmc_threads()
+{
+    TestsMpmcState* state = SVR_ZALLOC(TestsMpmcState);
+    state->ring.init(TESTS_RING_CAPACITY);
+
+    TestsMpmcThread producers[TESTS_RING_PRODUCERS];
+    TestsMpmcThread consumers[TESTS_RING_CONSUMERS];
+    SvrThread threads[TESTS_RING_PRODUCERS + TESTS_RING_CONSUMERS] = {};
+
+    for (s32 i = 0; i < TESTS_RING_CONSUMERS; i++)
+    {
+        consumers[i] = TestsMpmcThread { state, i };
+        TEST_CHECK(svr_thread_start(&threads[i], tests_ring_mpmc_consumer, &consumers[i]));
+    }
+
+    for (s32 i = 0; i < TESTS_RING_PRODUCERS; i++)
+    {
+        producers[i] = TestsMpmcThread { state, i };
+        TEST_CHECK(svr_thread_start(&threads[TESTS_RING_CONSUMERS + i], tests_ring_mpmc_producer, &producers[i]));
+    }
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(threads); i++)
+    {
+        svr_thread_join(&threads[i]);
+    }
+
+    s32 num_wrong = 0;
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(state->num_seen); i++)
+    {
+        num_wrong += svr_atom_load(&state->num_seen[i]) != 1;
+    }
+
+    TEST_CHECK(num_wrong == 0);
+    TEST_CHECK(svr_atom_load(&state->num_out_of_order) == 0);
+    TEST_CHECK(state->ring.size() == 0);
+
+    state->ring.free();
+    svr_free(state);
+}
+
+static void tests_ring_locked_queue()
+{
+    SvrLockedQueue<u32> queue = {};
+    queue.init(4);
+
+    u32 item;
+    TEST_CHECK(!queue.pull(&item));
+
+    // Grows past the initial capacity and keeps the order.
+    for (u32 i = 0; i < 100; i++)
+    {
+        queue.push(&i);
+    }
+
+    for (u32 i = 0; i < 100; i++)
+    {
+        TEST_CHECK(queue.pull(&item));
+        TEST_CHECK(item == i);
+    }
+
+    TEST_CHECK(!queue.pull(&item));
+
+    queue.free();
+}
+
+void tests_ring()
+{
+    SvrSpscRing<u32> spsc = {};
+    spsc.init(TESTS_RING_CAPACITY);
+    tests_ring_single_thread(&spsc);
+    spsc.free();
+
+    SvrMpmcRing<u32> mpmc = {};
+    mpmc.init(TESTS_RING_CAPACITY);
+    tests_ring_single_thread(&mpmc);
+    mpmc.free();
+
+    tests_ring_spsc_overflow();
+    tests_ring_mpmc_overflow();
+    tests_ring_spsc_threads();
+    tests_ring_mpmc_threads();
+    tests_ring_locked_queue();
+}
@@ -0,0 +1,185 @@
+#include "tests_priv.h"
+#include "svr_scan.h"
+#include <stdlib.h>
+
+// Tests of the pattern search against comparing every pattern at every position.
+// The data only has a few byte values so the anchors are found in many places where the full pattern is not.
+
+const s32 TESTS_SCAN_DATA_SIZE = 64 * 1024 + 13; // Not a multiple of the SIMD width, so the scalar level finishes the search.
+const s32 TESTS_SCAN_NUM_PATTERNS = 200;
+
+static const u8 TESTS_SCAN_BYTES[] = { 0x00, 0x48, 0x89, 0x8b, 0xe8, 0xcc, 0x5e, 0x0f };
+
+// Makes a pattern text of the data with some unknown bytes and compiles it.
+static void tests_scan_make_pattern(const u8* data, s32 size, SvrScanPattern* out)
+{
+    char text[SVR_SCAN_MAX_BYTES * 3 + 1];
+    s32 len = 0;
+
+    for (s32 i = 0; i < size; i++)
+    {
+        // The first byte is always known so every pattern can be compiled.
+        if (i > 0 && rand() % 4 == 0)
+        {
+            len += stbsp_snprintf(text + len, sizeof(text) - len, "?? ");
+        }
+
+        else
+        {
+            len += stbsp_snprintf(text + len, sizeof(text) - len, "%02X ", data[i]);
+        }
+    }
+
+    bool res = svr_scan_compile_pattern(text, out);
+    TEST_CHECK(res);
+    TEST_CHECK(out->size == size);
+}
+
+static s64 tests_scan_find_reference(const u8* data, const SvrScanRange* ranges, s32 num_ranges, const SvrScanPattern* pattern)
+{
+    for (s32 i = 0; i < num_ranges; i++)
+    {
+        for (s64 pos = ranges[i].start; pos + pattern->size <= ranges[i].end; pos++)
+        {
+            if (svr_scan_compare(data + pos, pattern))
+            {
+                return pos;
+            }
+        }
+    }
+
+    return -1;
+}
+
+static void tests_scan_compile()
+{
+    SvrScanPattern pattern;
+
+    TEST_CHECK(svr_scan_compile_pattern("8B 0D ?? ?? ?? ?? 85 c9", &pattern));
+    TEST_CHECK(pattern.size == 8);
+    TEST_CHECK(pattern.bytes[0] == 0x8b && pattern.mask[0] == 0xff);
+    TEST_CHECK(pattern.bytes[2] == 0 && pattern.mask[2] == 0);
+    TEST_CHECK(pattern.bytes[7] == 0xc9 && pattern.mask[7] == 0xff);
+
+    // The anchor is on the rarest bytes that are next to each other, not on the common 8B.
+    TEST_CHECK(pattern.anchor == 6);
+    TEST_CHECK(pattern.mask[pattern.anchor] == 0xff);
+
+    // No two known bytes next to each other, so the second byte of the anchor is unknown.
+    TEST_CHECK(svr_scan_compile_pattern("?? 8B ?? 85", &pattern));
+    TEST_CHECK(pattern.mask[pattern.anchor] == 0xff);
+
+    TEST_CHECK(!svr_scan_compile_pattern("?? ?? ??", &pattern));
+    TEST_CHECK(!svr_scan_compile_pattern("", &pattern));
+    TEST_CHECK(!svr_scan_compile_pattern("8B 0", &pattern));
+    TEST_CHECK(!svr_scan_compile_pattern("8B ZZ", &pattern));
+    TEST_CHECK(!svr_scan_compile_pattern("8B ?", &pattern));
+
+    char text[(SVR_SCAN_MAX_BYTES + 1) * 3 + 1] = {};
+
+    for (s32 i = 0; i < SVR_SCAN_MAX_BYTES + 1; i++)
+    {
+        memcpy(text + i * 3, "AB ", 3);
+    }
+
+    TEST_CHECK(!svr_scan_compile_pattern(text, &pattern));
+
+    text[SVR_SCAN_MAX_BYTES * 3] = 0;
+    TEST_CHECK(svr_scan_compile_pattern(text, &pattern));
+    TEST_CHECK(pattern.size == SVR_SCAN_MAX_BYTES);
+}
+
+static void tests_scan_check_levels(const u8* data, const SvrScanRange* ranges, s32 num_ranges, const SvrScanPattern* patterns, s32 num_patterns)
+{
+    s64* reference = (s64*)svr_alloc(sizeof(s64) * num_patterns);
+    s64* offsets = (s64*)svr_alloc(sizeof(s64) * num_patterns);
+
+    for (s32 i = 0; i < num_patterns; i++)
+    {
+        reference[i] = tests_scan_find_reference(data, ranges, num_ranges, &patterns[i]);
+    }
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        svr_scan_find_all_in_ranges(data, ranges, num_ranges, patterns, num_patterns, offsets, level);
+        TEST_CHECK(!memcmp(offsets, reference, sizeof(s64) * num_patterns));
+    }
+
+    svr_free(reference);
+    svr_free(offsets);
+}
+
+static void tests_scan_find()
+{
+    u8* data = (u8*)svr_alloc(TESTS_SCAN_DATA_SIZE);
+
+    for (s32 i = 0; i < TESTS_SCAN_DATA_SIZE; i++)
+    {
+        data[i] = TESTS_SCAN_BYTES[rand() % SVR_ARRAY_SIZE(TESTS_SCAN_BYTES)];
+    }
+
+    SvrScanPattern* patterns = (SvrScanPattern*)svr_alloc(sizeof(SvrScanPattern) * TESTS_SCAN_NUM_PATTERNS);
+
+    for (s32 i = 0; i < TESTS_SCAN_NUM_PATTERNS; i++)
+    {
+        s32 size = 1 + rand() % 24;
+        s32 start;
+
+        // Some at the very start and end, the rest anywhere.
+        switch (i % 8)
+        {
+            case 0: start = 0; break;
+            case 1: start = TESTS_SCAN_DATA_SIZE - size; break;
+            default: start = rand() % (TESTS_SCAN_DATA_SIZE - size + 1); break;
+        }
+
+        tests_scan_make_pattern(data + start, size, &patterns[i]);
+
+        // Some that are very likely not in the data, so the search goes to the end.
+        if (i % 5 == 0 && size > 8)
+        {
+            patterns[i].bytes[size - 1] = 0xa5;
+            patterns[i].mask[size - 1] = 0xff;
+        }
+    }
+
+    // The whole data.
+    SvrScanRange all = { 0, TESTS_SCAN_DATA_SIZE };
+    tests_scan_check_levels(data, &all, 1, patterns, TESTS_SCAN_NUM_PATTERNS);
+
+    // Ranges that are not in order of the data and that split patterns, of sizes around the SIMD width.
+    SvrScanRange ranges[] =
+    {
+        SvrScanRange { 40000, 40031 },
+        SvrScanRange { 100, 133 },
+        SvrScanRange { 1000, 1017 },
+        SvrScanRange { 5000, 5001 },
+        SvrScanRange { 7, 7 },
+        SvrScanRange { 20000, 30000 },
+        SvrScanRange { TESTS_SCAN_DATA_SIZE - 70, TESTS_SCAN_DATA_SIZE },
+    };
+
+    tests_scan_check_levels(data, ranges, SVR_ARRAY_SIZE(ranges), patterns, TESTS_SCAN_NUM_PATTERNS);
+
+    // One pattern many times, so the first place must be taken and the ones after it must not replace it.
+    SvrScanPattern repeated[2];
+    TEST_CHECK(svr_scan_compile_pattern("48 89", &repeated[0]));
+    TEST_CHECK(svr_scan_compile_pattern("48 ?? 89", &repeated[1]));
+    tests_scan_check_levels(data, &all, 1, repeated, SVR_ARRAY_SIZE(repeated));
+
+    // Nothing to search.
+    s64 offset = 0;
+    svr_scan_find_all(data, 0, patterns, 1, &offset, svr_simd_get_best_level());
+    TEST_CHECK(offset == -1);
+
+    svr_free(patterns);
+    svr_free(data);
+}
+
+void tests_scan()
+{
+    srand(18);
+
+    tests_scan_compile();
+    tests_scan_find();
+}
@@ -0,0 +1,272 @@
+#include "tests_priv.h"
+#include "svr_scan_cache.h"
+#include "svr_pe.h"
+#include <stdlib.h>
+
+// Tests of the cache of found patterns, with a small PE image as the module.
+// Offsets from the cache must be the same as searching, and the cache must not be used when the module or the patterns have changed.
+
+const s32 TESTS_SCAN_CACHE_IMAGE_SIZE = 0xb000;
+const u32 TESTS_SCAN_CACHE_CODE_START = 0x1000;
+const u32 TESTS_SCAN_CACHE_CODE_END = 0x9000;
+const s32 TESTS_SCAN_CACHE_NUM_PATTERNS = 24;
+
+static const TestsPeSection TESTS_SCAN_CACHE_SECTIONS[] =
+{
+    TestsPeSection { ".text", TESTS_SCAN_CACHE_CODE_START, TESTS_SCAN_CACHE_CODE_END - TESTS_SCAN_CACHE_CODE_START, 0x8000, SVR_PE_SECTION_CODE | SVR_PE_SECTION_EXECUTE },
+    TestsPeSection { ".data", 0x9000, 0x2000, 0x2000, SVR_PE_SECTION_INIT_DATA },
+};
+
+static void tests_scan_cache_make_image(u8* image, u32 timestamp)
+{
+    for (s32 i = 0; i < TESTS_SCAN_CACHE_IMAGE_SIZE; i++)
+    {
+        image[i] = (u8)((rand() % 4) * 0x41);
+    }
+
+    tests_make_pe_image(image, timestamp, TESTS_SCAN_CACHE_IMAGE_SIZE, TESTS_SCAN_CACHE_SECTIONS, SVR_ARRAY_SIZE(TESTS_SCAN_CACHE_SECTIONS));
+}
+
+// Patterns from the code, with the last few made to not be found.
+static void tests_scan_cache_make_patterns(const u8* image, SvrScanPattern* patterns)
+{
+    for (s32 i = 0; i < TESTS_SCAN_CACHE_NUM_PATTERNS; i++)
+    {
+        s32 size = 10 + rand() % 10;
+        s32 start = TESTS_SCAN_CACHE_CODE_START + rand() % (TESTS_SCAN_CACHE_CODE_END - TESTS_SCAN_CACHE_CODE_START - size);
+
+        SvrScanPattern* pattern = &patterns[i];
+        *pattern = {};
+        pattern->size = size;
+
+        for (s32 j = 0; j < size; j++)
+        {
+            pattern->bytes[j] = image[start + j];
+            pattern->mask[j] = 0xff;
+        }
+
+        pattern->mask[size / 2] = 0;
+        pattern->bytes[size / 2] = 0;
+        pattern->anchor = 0;
+
+        if (i >= TESTS_SCAN_CACHE_NUM_PATTERNS - 4)
+        {
+            pattern->bytes[size - 1] = 0x17;
+        }
+    }
+}
+
+static void tests_scan_cache_hash()
+{
+    SvrScanPattern a;
+    SvrScanPattern b;
+
+    TEST_CHECK(svr_scan_compile_pattern("8B 0D ?? ?? 85 C9", &a));
+    TEST_CHECK(svr_scan_compile_pattern("8B 0D ?? ?? 85 C9", &b));
+    TEST_CHECK(svr_scan_cache_hash_pattern(&a) == svr_scan_cache_hash_pattern(&b));
+
+    // Bytes after the size are not part of the pattern.
+    b.bytes[b.size] = 0x55;
+    TEST_CHECK(svr_scan_cache_hash_pattern(&a) == svr_scan_cache_hash_pattern(&b));
+
+    // A known zero and an unknown byte have the same bytes but different masks.
+    TEST_CHECK(svr_scan_compile_pattern("8B 0D 00 ?? 85 C9", &b));
+    TEST_CHECK(svr_scan_cache_hash_pattern(&a) != svr_scan_cache_hash_pattern(&b));
+
+    TEST_CHECK(svr_scan_compile_pattern("8B 0D ?? ?? 85 C8", &b));
+    TEST_CHECK(svr_scan_cache_hash_pattern(&a) != svr_scan_cache_hash_pattern(&b));
+
+    TEST_CHECK(svr_scan_compile_pattern("8B 0D ?? ?? 85 C9 ??", &b));
+    TEST_CHECK(svr_scan_cache_hash_pattern(&a) != svr_scan_cache_hash_pattern(&b));
+}
+
+static void tests_scan_cache_read_write()
+{
+    SvrScanCache cache = {};
+
+    for (s32 i = 0; i < 3; i++)
+    {
+        SvrScanCacheModule* module = cache.modules.emplace_zero();
+        SVR_SNPRINTF(module->name, "module%d.dll", i);
+        module->timestamp = 100 + i;
+        module->image_size = 0x10000 * (i + 1);
+        module->section_hash = 0x123456789abcdef0ULL + i;
+
+        for (s32 j = 0; j < i * 5; j++)
+        {
+            SvrScanCacheEntry* entry = module->entries.emplace();
+            entry->pattern_hash = (u64)j * 0x9e3779b97f4a7c15ULL;
+            entry->offset = j == 2 ? -1 : j * 1000;
+        }
+    }
+
+    SvrDynArray<u8> data = {};
+    svr_scan_cache_write(&cache, &data);
+
+    SvrScanCache read;
+    TEST_CHECK(svr_scan_cache_read(&read, data.mem, data.size));
+    TEST_CHECK(read.modules.size == cache.modules.size);
+    TEST_CHECK(!read.changed);
+
+    for (s32 i = 0; i < svr_min(read.modules.size, cache.modules.size); i++)
+    {
+        SvrScanCacheModule* a = &cache.modules[i];
+        SvrScanCacheModule* b = &read.modules[i];
+
+        TEST_CHECK(!strcmp(a->name, b->name));
+        TEST_CHECK(a->timestamp == b->timestamp && a->image_size == b->image_size && a->section_hash == b->section_hash);
+        TEST_CHECK(a->entries.size == b->entries.size);
+        TEST_CHECK(!memcmp(a->entries.mem, b->entries.mem, sizeof(SvrScanCacheEntry) * svr_min(a->entries.size, b->entries.size)));
+    }
+
+    svr_scan_cache_free(&read);
+
+    // Every cut of the data is refused and leaves the cache empty.
+    for (s32 i = 0; i < data.size; i++)
+    {
+        TEST_CHECK(!svr_scan_cache_read(&read, data.mem, i));
+        TEST_CHECK(read.modules.size == 0);
+    }
+
+    // The version is after the magic.
+    u32 version;
+    memcpy(&version, data.mem + 4, sizeof(version));
+    TEST_CHECK(version == SVR_SCAN_CACHE_VERSION);
+
+    u32 other_version = SVR_SCAN_CACHE_VERSION + 1;
+    memcpy(data.mem + 4, &other_version, sizeof(other_version));
+    TEST_CHECK(!svr_scan_cache_read(&read, data.mem, data.size));
+    TEST_CHECK(read.modules.size == 0);
+    memcpy(data.mem + 4, &version, sizeof(version));
+
+    data.mem[0] ^= 1;
+    TEST_CHECK(!svr_scan_cache_read(&read, data.mem, data.size));
+    data.mem[0] ^= 1;
+
+    // Counts that cannot be right.
+    s32 bad_modules = -1;
+    memcpy(data.mem + 8, &bad_modules, sizeof(bad_modules));
+    TEST_CHECK(!svr_scan_cache_read(&read, data.mem, data.size));
+
+    bad_modules = 1000000;
+    memcpy(data.mem + 8, &bad_modules, sizeof(bad_modules));
+    TEST_CHECK(!svr_scan_cache_read(&read, data.mem, data.size));
+
+    TEST_CHECK(svr_scan_cache_read(&read, data.mem, 0) == false);
+
+    svr_scan_cache_free(&read);
+    svr_scan_cache_free(&cache);
+    data.free();
+}
+
+static void tests_scan_cache_find()
+{
+    u8* image = (u8*)svr_alloc(TESTS_SCAN_CACHE_IMAGE_SIZE);
+    tests_scan_cache_make_image(image, 1000);
+
+    SvrScanPattern patterns[TESTS_SCAN_CACHE_NUM_PATTERNS];
+    tests_scan_cache_make_patterns(image, patterns);
+
+    SvrScanRange range = { TESTS_SCAN_CACHE_CODE_START, TESTS_SCAN_CACHE_CODE_END };
+
+    s64 reference[TESTS_SCAN_CACHE_NUM_PATTERNS];
+    s64 offsets[TESTS_SCAN_CACHE_NUM_PATTERNS];
+
+    svr_scan_find_all_in_ranges(image, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, reference, SVR_SIMD_SCALAR);
+    TEST_CHECK(reference[0] != -1);
+    TEST_CHECK(reference[TESTS_SCAN_CACHE_NUM_PATTERNS - 1] == -1);
+
+    SvrScanCache cache = {};
+    SvrSimdLevel level = svr_simd_get_best_level();
+
+    // Nothing is in the cache the first time.
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "client.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == 0);
+    TEST_CHECK(!memcmp(offsets, reference, sizeof(offsets)));
+    TEST_CHECK(cache.changed);
+
+    // Everything is in the cache the second time, also the ones that were not found, and the cache does not have to be written again.
+    cache.changed = false;
+    memset(offsets, 0, sizeof(offsets));
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "client.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == TESTS_SCAN_CACHE_NUM_PATTERNS);
+    TEST_CHECK(!memcmp(offsets, reference, sizeof(offsets)));
+    TEST_CHECK(!cache.changed);
+
+    // The same after the cache has been written and read back.
+    SvrDynArray<u8> data = {};
+    svr_scan_cache_write(&cache, &data);
+    svr_scan_cache_free(&cache);
+    TEST_CHECK(svr_scan_cache_read(&cache, data.mem, data.size));
+    data.free();
+
+    memset(offsets, 0, sizeof(offsets));
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "client.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == TESTS_SCAN_CACHE_NUM_PATTERNS);
+    TEST_CHECK(!memcmp(offsets, reference, sizeof(offsets)));
+
+    // Another module with the same headers has its own entries.
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "engine.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == 0);
+    TEST_CHECK(cache.modules.size == 2);
+
+    // A pattern that is not the same is searched for.
+    SvrScanPattern changed_patterns[TESTS_SCAN_CACHE_NUM_PATTERNS];
+    memcpy(changed_patterns, patterns, sizeof(patterns));
+    changed_patterns[3].mask[changed_patterns[3].size / 2] = 0xff;
+    changed_patterns[3].bytes[changed_patterns[3].size / 2] = image[reference[3] + changed_patterns[3].size / 2];
+
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "client.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, changed_patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == TESTS_SCAN_CACHE_NUM_PATTERNS - 1);
+    TEST_CHECK(!memcmp(offsets, reference, sizeof(offsets)));
+
+    // A stale entry where the code no longer matches is searched for again, and the new place is cached.
+    // The pattern is broken where it was and put in again later in the code.
+    s32 moved = 5;
+    s64 old_offset = reference[moved];
+    s64 new_offset = TESTS_SCAN_CACHE_CODE_END - 64;
+
+    TEST_CHECK(old_offset < new_offset);
+
+    memcpy(image + new_offset, image + old_offset, patterns[moved].size);
+    image[old_offset] ^= 0x01;
+
+    svr_scan_find_all_in_ranges(image, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, reference, SVR_SIMD_SCALAR);
+    TEST_CHECK(reference[moved] != old_offset && reference[moved] != -1);
+
+    cache.changed = false;
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "client.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == TESTS_SCAN_CACHE_NUM_PATTERNS - 1);
+    TEST_CHECK(offsets[moved] == reference[moved]);
+    TEST_CHECK(cache.changed);
+
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "client.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == TESTS_SCAN_CACHE_NUM_PATTERNS);
+    TEST_CHECK(offsets[moved] == reference[moved]);
+
+    // A new build throws away every entry of the module, even if the code is the same.
+    tests_make_pe_image(image, 1001, TESTS_SCAN_CACHE_IMAGE_SIZE, TESTS_SCAN_CACHE_SECTIONS, SVR_ARRAY_SIZE(TESTS_SCAN_CACHE_SECTIONS));
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "client.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == 0);
+    TEST_CHECK(!memcmp(offsets, reference, sizeof(offsets)));
+
+    // So does a change to the sections only.
+    TestsPeSection sections[SVR_ARRAY_SIZE(TESTS_SCAN_CACHE_SECTIONS)];
+    memcpy(sections, TESTS_SCAN_CACHE_SECTIONS, sizeof(sections));
+    sections[1].raw_size -= 0x200;
+
+    tests_make_pe_image(image, 1001, TESTS_SCAN_CACHE_IMAGE_SIZE, sections, SVR_ARRAY_SIZE(sections));
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "client.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == 0);
+    TEST_CHECK(!memcmp(offsets, reference, sizeof(offsets)));
+
+    // Data that is not a PE image cannot be told apart, so it is always searched and never cached.
+    image[0] = 0;
+    s32 num_modules = cache.modules.size;
+    TEST_CHECK(svr_scan_find_all_cached(&cache, "other.dll", image, TESTS_SCAN_CACHE_IMAGE_SIZE, &range, 1, patterns, TESTS_SCAN_CACHE_NUM_PATTERNS, offsets, level) == 0);
+    TEST_CHECK(!memcmp(offsets, reference, sizeof(offsets)));
+    TEST_CHECK(cache.modules.size == num_modules);
+
+    svr_scan_cache_free(&cache);
+    svr_free(image);
+}
+
+void tests_scan_cache()
+{
+    srand(19);
+
+    tests_scan_cache_hash();
+    tests_scan_cache_read_write();
+    tests_scan_cache_find();
+}
@@ -0,0 +1,144 @@
+#include "tests_priv.h"
+#include "svr_slot_ring.h"
+
+// Tests of the slot ring that svr_game and svr_encoder share the video textures with.
+
+const s32 TESTS_SLOT_RING_FRAMES = 100000;
+
+static void tests_slot_ring_single_thread(s32 num_slots, s32 start_seq)
+{
+    SvrSlotRing ring;
+    svr_slot_ring_init(&ring, num_slots);
+
+    // Start somewhere else to check that the sequence numbers can overflow.
+    svr_atom_store(&ring.write_seq, start_seq);
+    svr_atom_store(&ring.read_seq, start_seq);
+
+    s32 slot;
+    s32 seq;
+
+    TEST_CHECK(svr_slot_ring_get_num_slots(&ring) == num_slots);
+    TEST_CHECK(!svr_slot_ring_begin_read(&ring, &slot, &seq));
+
+    for (s32 lap = 0; lap < 3; lap++)
+    {
+        for (s32 i = 0; i < num_slots; i++)
+        {
+            s32 first_slot;
+            TEST_CHECK(svr_slot_ring_begin_write(&ring, &first_slot));
+
+            // The same slot until it is given away.
+            TEST_CHECK(svr_slot_ring_begin_write(&ring, &slot));
+            TEST_CHECK(slot == first_slot);
+
+            svr_slot_ring_end_write(&ring);
+        }
+
+        TEST_CHECK(!svr_slot_ring_begin_write(&ring, &slot)); // Full.
+        TEST_CHECK(svr_slot_ring_get_num_full(&ring) == num_slots);
+
+        for (s32 i = 0; i < num_slots; i++)
+        {
+            s32 expected_seq = (s32)((u32)start_seq + (u32)(lap * num_slots + i));
+
+            TEST_CHECK(svr_slot_ring_begin_read(&ring, &slot, &seq));
+            TEST_CHECK(seq == expected_seq);
+            TEST_CHECK(slot == (expected_seq & (num_slots - 1)));
+
+            svr_slot_ring_end_read(&ring);
+        }
+
+        TEST_CHECK(!svr_slot_ring_begin_read(&ring, &slot, &seq));
+        TEST_CHECK(svr_slot_ring_get_num_full(&ring) == 0);
+    }
+
+    // Everything written before the stop is still read, and then it is done.
+    TEST_CHECK(svr_slot_ring_begin_write(&ring, &slot));
+    svr_slot_ring_end_write(&ring);
+    svr_slot_ring_stop(&ring);
+
+    TEST_CHECK(!svr_slot_ring_is_done(&ring));
+    TEST_CHECK(svr_slot_ring_begin_read(&ring, &slot, NULL));
+    svr_slot_ring_end_read(&ring);
+    TEST_CHECK(svr_slot_ring_is_done(&ring));
+
+    // After a restart the ring is empty and writable again.
+    svr_slot_ring_restart(&ring);
+    TEST_CHECK(!svr_slot_ring_is_done(&ring));
+    TEST_CHECK(!svr_slot_ring_begin_read(&ring, &slot, &seq));
+    TEST_CHECK(svr_slot_ring_begin_write(&ring, &slot));
+}
+
+struct TestsSlotRingState
+{
+    SvrSlotRing ring;
+    s32 slot_contents[SVR_SLOT_RING_MAX_SLOTS]; // Stands for the shared textures.
+};
+
+static void tests_slot_ring_producer(void* param)
+{
+    TestsSlotRingState* state = (TestsSlotRingState*)param;
+
+    for (s32 i = 0; i < TESTS_SLOT_RING_FRAMES; i++)
+    {
+        s32 slot;
+
+        while (!svr_slot_ring_begin_write(&state->ring, &slot))
+        {
+            svr_thread_yield();
+        }
+
+        state->slot_contents[slot] = i;
+        svr_slot_ring_end_write(&state->ring);
+    }
+
+    svr_slot_ring_stop(&state->ring);
+}
+
+// The consumer must see every frame in order, and never a slot that the producer is still writing.
+static void tests_slot_ring_threads(s32 num_slots)
+{
+    TestsSlotRingState state = {};
+    svr_slot_ring_init(&state.ring, num_slots);
+
+    SvrThread producer = {};
+    TEST_CHECK(svr_thread_start(&producer, tests_slot_ring_producer, &state));
+
+    s32 num_read = 0;
+    s32 num_wrong = 0;
+
+    while (!svr_slot_ring_is_done(&state.ring))
+    {
+        s32 slot;
+        s32 seq;
+
+        if (!svr_slot_ring_begin_read(&state.ring, &slot, &seq))
+        {
+            svr_thread_yield();
+            continue;
+        }
+
+        num_wrong += seq != num_read;
+        num_wrong += state.slot_contents[slot] != num_read;
+        num_read++;
+
+        svr_slot_ring_end_read(&state.ring);
+    }
+
+    svr_thread_join(&producer);
+
+    TEST_CHECK(num_read == TESTS_SLOT_RING_FRAMES);
+    TEST_CHECK(num_wrong == 0);
+}
+
+void tests_slot_ring()
+{
+    for (s32 num_slots = 1; num_slots <= SVR_SLOT_RING_MAX_SLOTS; num_slots *= 2)
+    {
+        tests_slot_ring_single_thread(num_slots, 0);
+        tests_slot_ring_single_thread(num_slots, (s32)0xfffffffa);
+    }
+
+    tests_slot_ring_threads(1);
+    tests_slot_ring_threads(4);
+}
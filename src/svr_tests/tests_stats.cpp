@@ -0,0 +1,252 @@
+#include "tests_priv.h"
+#include "svr_stats.h"
+#include "svr_ipc.h"
+
+// Tests of the live statistics block between svr_game, svr_encoder and svr_monitor.
+// A writer thread changes the game part and one encoder part all the time, and a reader copies them from its own view of the memory
+// like svr_monitor does. Every field of a part is made from the same number, so a copy with fields from two writes is seen.
+// The memory has another name than the one svr_game uses, so a running game is not disturbed.
+
+const char* const TESTS_STATS_MEM_NAME = "svr_stats_tests";
+const s32 TESTS_STATS_WRITES = 200000;
+const s32 TESTS_STATS_ENCODER_IDX = 2;
+
+static void tests_stats_make_game(s32 n, SvrStatsGame* dest)
+{
+    *dest = {};
+    dest->state = n & 1;
+    dest->num_encoders = n % SVR_STATS_MAX_ENCODERS;
+    dest->video_fps = n;
+    dest->game_rate = n * 3;
+    dest->start_time = n;
+    dest->update_time = (s64)n * 2;
+    dest->finish_time = (s64)n * 5;
+    dest->game_frames = (s64)n * 7;
+    dest->video_frames = (s64)n * 11;
+    dest->audio_samples = (s64)n * 13;
+    dest->movie_frames = (s64)n * 17;
+    dest->frame_interval = n * 0.5;
+
+    for (s32 i = 0; i < SVR_STATS_GAME_NUM_STAGES; i++)
+    {
+        dest->stage_times[i] = n + i;
+    }
+}
+
+static void tests_stats_make_encoder(s32 n, SvrStatsEncoder* dest)
+{
+    *dest = {};
+    dest->state = n & 1;
+    SVR_SNPRINTF(dest->movie_name, "movie %d", n);
+    dest->update_time = n;
+    dest->frames_received = (s64)n * 2;
+    dest->frames_downloaded = (s64)n * 3;
+    dest->frames_encoded = (s64)n * 5;
+    dest->frames_written = (s64)n * 7;
+    dest->bytes_written = (s64)n * 11;
+    dest->audio_samples = (s64)n * 13;
+    dest->download_queue = n % 3;
+    dest->encode_queue = n % 5;
+    dest->audio_queue = n % 7;
+    dest->packet_queue = n % 11;
+    dest->pool_used = (s64)n * 17;
+    dest->pool_peak = (s64)n * 19;
+    dest->pool_budget = (s64)n * 23;
+    dest->pool_num_waits = n % 13;
+
+    for (s32 i = 0; i < SVR_STATS_ENCODER_NUM_STAGES; i++)
+    {
+        dest->stage_times[i] = n * 0.25 + i;
+    }
+}
+
+// The sequence numbers are not compared, since the reader has a number of its own.
+static bool tests_stats_game_is_whole(SvrStatsGame* game)
+{
+    SvrStatsGame expected;
+    tests_stats_make_game(game->video_fps, &expected);
+    expected.seq = game->seq;
+
+    return !memcmp(game, &expected, sizeof(SvrStatsGame));
+}
+
+static bool tests_stats_encoder_is_whole(SvrStatsEncoder* enc)
+{
+    SvrStatsEncoder expected;
+    tests_stats_make_encoder((s32)enc->update_time, &expected);
+    expected.seq = enc->seq;
+
+    return !memcmp(enc, &expected, sizeof(SvrStatsEncoder));
+}
+
+struct TestsStatsWriter
+{
+    SvrStatsBlock* block;
+    SvrAtom32 done;
+};
+
+static void tests_stats_writer_proc(void* param)
+{
+    TestsStatsWriter* writer = (TestsStatsWriter*)param;
+
+    SvrStatsGame game;
+    SvrStatsEncoder enc;
+
+    for (s32 i = 1; i <= TESTS_STATS_WRITES; i++)
+    {
+        tests_stats_make_game(i, &game);
+        svr_stats_write_game(writer->block, &game);
+
+        tests_stats_make_encoder(i, &enc);
+        svr_stats_write_encoder(writer->block, TESTS_STATS_ENCODER_IDX, &enc);
+    }
+
+    svr_atom_store(&writer->done, 1);
+}
+
+static void tests_stats_concurrent()
+{
+    SvrIpcMem write_mem = {};
+    SvrIpcMem read_mem = {};
+
+    if (!svr_ipc_create_named_mem(TESTS_STATS_MEM_NAME, sizeof(SvrStatsBlock), &write_mem))
+    {
+        TEST_CHECK(!"Could not create the stats memory");
+        return;
+    }
+
+    SvrStatsBlock* write_block = (SvrStatsBlock*)write_mem.ptr;
+    svr_stats_init(write_block, svr_ipc_get_current_pid());
+
+    // Opened again like svr_monitor, so the reader has its own view at another address.
+    TEST_CHECK(svr_ipc_open_named_mem(TESTS_STATS_MEM_NAME, &read_mem));
+    TEST_CHECK(svr_stats_check(read_mem.ptr, read_mem.size));
+
+    SvrStatsBlock* read_block = (SvrStatsBlock*)read_mem.ptr;
+
+    TestsStatsWriter writer = {};
+    writer.block = write_block;
+
+    SvrThread thread = {};
+    TEST_CHECK(svr_thread_start(&thread, tests_stats_writer_proc, &writer));
+
+    s32 num_reads = 0;
+    s32 num_busy = 0;
+    s32 num_torn = 0;
+    s32 num_backwards = 0;
+    s32 last_game = 0;
+    s32 last_enc = 0;
+
+    while (true)
+    {
+        // Read once more after the writer is done, so the last write is always seen.
+        bool done = svr_atom_load(&writer.done) != 0;
+
+        SvrStatsGame game;
+        SvrStatsEncoder enc;
+
+        if (!svr_stats_read_game(read_block, &game) || !svr_stats_read_encoder(read_block, TESTS_STATS_ENCODER_IDX, &enc))
+        {
+            num_busy++;
+        }
+
+        else
+        {
+            num_reads++;
+
+            // The first read can be before the first write, when the parts are still zero.
+            if (game.video_fps != 0 && !tests_stats_game_is_whole(&game))
+            {
+                num_torn++;
+            }
+
+            if (enc.update_time != 0 && !tests_stats_encoder_is_whole(&enc))
+            {
+                num_torn++;
+            }
+
+            if (game.video_fps < last_game || (s32)enc.update_time < last_enc)
+            {
+                num_backwards++;
+            }
+
+            last_game = game.video_fps;
+            last_enc = (s32)enc.update_time;
+        }
+
+        if (done)
+        {
+            break;
+        }
+
+        svr_thread_yield();
+    }
+
+    svr_thread_join(&thread);
+
+    TEST_CHECK(num_reads > 0);
+    TEST_CHECK(num_busy == 0);
+    TEST_CHECK(num_torn == 0);
+    TEST_CHECK(num_backwards == 0);
+    TEST_CHECK(last_game == TESTS_STATS_WRITES);
+    TEST_CHECK(last_enc == TESTS_STATS_WRITES);
+
+    // The other encoder parts were never written.
+    SvrStatsEncoder other;
+    TEST_CHECK(svr_stats_read_encoder(read_block, 0, &other));
+    TEST_CHECK(other.update_time == 0 && other.movie_name[0] == 0);
+
+    svr_ipc_free_mem(&read_mem);
+    svr_ipc_free_mem(&write_mem);
+}
+
+// A block from another version or of another size must not be read, and a reader must not wait forever on a writer that stopped.
+static void tests_stats_check()
+{
+    SvrStatsBlock* block = SVR_ZALLOC(SvrStatsBlock);
+
+    // Nothing has been set up yet.
+    TEST_CHECK(!svr_stats_check(block, sizeof(SvrStatsBlock)));
+
+    svr_stats_init(block, 1234);
+    TEST_CHECK(svr_stats_check(block, sizeof(SvrStatsBlock)));
+    TEST_CHECK(block->header.game_pid == 1234);
+
+    TEST_CHECK(!svr_stats_check(block, sizeof(SvrStatsHeader) - 1));
+    TEST_CHECK(!svr_stats_check(block, sizeof(SvrStatsBlock) - 1));
+
+    block->header.version = SVR_STATS_VERSION + 1;
+    TEST_CHECK(!svr_stats_check(block, sizeof(SvrStatsBlock)));
+
+    block->header.version = SVR_STATS_VERSION - 1;
+    TEST_CHECK(!svr_stats_check(block, sizeof(SvrStatsBlock)));
+
+    block->header.version = SVR_STATS_VERSION;
+    block->header.size = sizeof(SvrStatsBlock) + 8;
+    TEST_CHECK(!svr_stats_check(block, sizeof(SvrStatsBlock) + 8));
+
+    block->header.size = sizeof(SvrStatsBlock);
+    block->header.magic = SVR_STATS_MAGIC + 1;
+    TEST_CHECK(!svr_stats_check(block, sizeof(SvrStatsBlock)));
+
+    block->header.magic = SVR_STATS_MAGIC;
+    TEST_CHECK(svr_stats_check(block, sizeof(SvrStatsBlock)));
+
+    // A writer that stopped in the middle leaves an odd number.
+    SvrStatsGame game;
+    tests_stats_make_game(5, &game);
+    svr_stats_write_game(block, &game);
+
+    TEST_CHECK(svr_stats_read_game(block, &game) && tests_stats_game_is_whole(&game));
+
+    svr_atom_store(&block->game.seq, block->game.seq.v + 1);
+    TEST_CHECK(!svr_stats_read_game(block, &game));
+
+    svr_free(block);
+}
+
+void tests_stats()
+{
+    tests_stats_check();
+    tests_stats_concurrent();
+}
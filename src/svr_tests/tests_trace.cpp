@@ -0,0 +1,589 @@
+#include "tests_priv.h"
+#include "svr_trace.h"
+
+// Tests of the trace JSON, which is read back with a small JSON parser that refuses anything that is not strict JSON.
+// The events that are read back must be the ones that were recorded, from every thread and in the order they were recorded.
+
+const s32 TESTS_TRACE_MAX_EVENTS = 80000;
+const s32 TESTS_TRACE_NAME_SIZE = 128;
+const s32 TESTS_TRACE_THREADS = 3;
+const s32 TESTS_TRACE_THREAD_EVENTS = 20000; // More than one chunk of events.
+
+struct TestsTraceEvent
+{
+    char name[TESTS_TRACE_NAME_SIZE];
+    char ph[4];
+    char arg_name[TESTS_TRACE_NAME_SIZE];
+    s64 pid;
+    s64 tid;
+    s64 ts;
+    s64 dur;
+    s64 value;
+    s32 num_fields;
+};
+
+struct TestsTraceJson
+{
+    const char* ptr;
+    const char* end;
+
+    TestsTraceEvent* events;
+    s32 num_events;
+};
+
+static void tests_trace_json_skip_space(TestsTraceJson* json)
+{
+    while (json->ptr < json->end && (*json->ptr == ' ' || *json->ptr == '\n' || *json->ptr == '\r' || *json->ptr == '\t'))
+    {
+        json->ptr++;
+    }
+}
+
+static bool tests_trace_json_char(TestsTraceJson* json, char c)
+{
+    tests_trace_json_skip_space(json);
+
+    if (json->ptr < json->end && *json->ptr == c)
+    {
+        json->ptr++;
+        return true;
+    }
+
+    return false;
+}
+
+static s32 tests_trace_json_hex(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool tests_trace_json_peek(TestsTraceJson* json, char c)
+{
+    tests_trace_json_skip_space(json);
+    return json->ptr < json->end && *json->ptr == c;
+}
+
+// Only escapes of characters below 0x80 are taken, which is all that the trace writes.
+static bool tests_trace_json_string(TestsTraceJson* json, char* dest, s32 dest_size)
+{
+    if (!tests_trace_json_char(json, '"'))
+    {
+        return false;
+    }
+
+    s32 len = 0;
+
+    while (json->ptr < json->end && *json->ptr != '"')
+    {
+        char c = *json->ptr++;
+
+        if ((u8)c < 0x20)
+        {
+            return false;
+        }
+
+        if (c == '\\')
+        {
+            if (json->ptr == json->end)
+            {
+                return false;
+            }
+
+            char e = *json->ptr++;
+
+            switch (e)
+            {
+                case '"': case '\\': case '/': c = e; break;
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+
+                case 'u':
+                {
+                    s32 v = 0;
+
+                    for (s32 i = 0; i < 4; i++)
+                    {
+                        if (json->ptr == json->end || tests_trace_json_hex(*json->ptr) == -1)
+                        {
+                            return false;
+                        }
+
+                        v = v * 16 + tests_trace_json_hex(*json->ptr++);
+                    }
+
+                    if (v >= 0x80)
+                    {
+                        return false;
+                    }
+
+                    c = (char)v;
+                    break;
+                }
+
+                default:
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (len + 1 < dest_size)
+        {
+            dest[len++] = c;
+        }
+    }
+
+    if (dest_size > 0)
+    {
+        dest[len] = 0;
+    }
+
+    return tests_trace_json_char(json, '"');
+}
+
+// Only integers, which is all that the trace writes.
+static bool tests_trace_json_number(TestsTraceJson* json, s64* dest)
+{
+    tests_trace_json_skip_space(json);
+
+    bool negative = json->ptr < json->end && *json->ptr == '-';
+
+    if (negative)
+    {
+        json->ptr++;
+    }
+
+    if (json->ptr == json->end || *json->ptr < '0' || *json->ptr > '9')
+    {
+        return false;
+    }
+
+    s64 v = 0;
+
+    while (json->ptr < json->end && *json->ptr >= '0' && *json->ptr <= '9')
+    {
+        v = v * 10 + (*json->ptr - '0');
+        json->ptr++;
+    }
+
+    *dest = negative ? -v : v;
+    return true;
+}
+
+static bool tests_trace_json_value(TestsTraceJson* json, s32 depth);
+
+// Object of the args of an event, where the name of metadata and the value of counters are.
+static bool tests_trace_json_args(TestsTraceJson* json, TestsTraceEvent* event)
+{
+    if (!tests_trace_json_char(json, '{'))
+    {
+        return false;
+    }
+
+    if (tests_trace_json_char(json, '}'))
+    {
+        return true;
+    }
+
+    do
+    {
+        char key[32];
+
+        if (!tests_trace_json_string(json, key, sizeof(key)) || !tests_trace_json_char(json, ':'))
+        {
+            return false;
+        }
+
+        bool res;
+
+        if (!strcmp(key, "name")) res = tests_trace_json_string(json, event->arg_name, sizeof(event->arg_name));
+        else if (!strcmp(key, "value")) res = tests_trace_json_number(json, &event->value);
+        else res = tests_trace_json_value(json, 2);
+
+        if (!res)
+        {
+            return false;
+        }
+    }
+    while (tests_trace_json_char(json, ','));
+
+    return tests_trace_json_char(json, '}');
+}
+
+static bool tests_trace_json_event(TestsTraceJson* json)
+{
+    if (json->num_events == TESTS_TRACE_MAX_EVENTS || !tests_trace_json_char(json, '{'))
+    {
+        return false;
+    }
+
+    TestsTraceEvent* event = &json->events[json->num_events];
+    *event = {};
+    event->dur = -1;
+    event->value = -1;
+
+    json->num_events++;
+
+    if (tests_trace_json_char(json, '}'))
+    {
+        return true;
+    }
+
+    do
+    {
+        char key[32];
+
+        if (!tests_trace_json_string(json, key, sizeof(key)) || !tests_trace_json_char(json, ':'))
+        {
+            return false;
+        }
+
+        bool res;
+
+        if (!strcmp(key, "name")) res = tests_trace_json_string(json, event->name, sizeof(event->name));
+        else if (!strcmp(key, "ph")) res = tests_trace_json_string(json, event->ph, sizeof(event->ph));
+        else if (!strcmp(key, "pid")) res = tests_trace_json_number(json, &event->pid);
+        else if (!strcmp(key, "tid")) res = tests_trace_json_number(json, &event->tid);
+        else if (!strcmp(key, "ts")) res = tests_trace_json_number(json, &event->ts);
+        else if (!strcmp(key, "dur")) res = tests_trace_json_number(json, &event->dur);
+        else if (!strcmp(key, "args")) res = tests_trace_json_args(json, event);
+        else res = tests_trace_json_value(json, 2);
+
+        if (!res)
+        {
+            return false;
+        }
+
+        event->num_fields++;
+    }
+    while (tests_trace_json_char(json, ','));
+
+    return tests_trace_json_char(json, '}');
+}
+
+// Any value, which is only checked and not kept.
+static bool tests_trace_json_value(TestsTraceJson* json, s32 depth)
+{
+    if (depth > 16)
+    {
+        return false;
+    }
+
+    tests_trace_json_skip_space(json);
+
+    if (json->ptr == json->end)
+    {
+        return false;
+    }
+
+    char c = *json->ptr;
+
+    if (c == '"')
+    {
+        return tests_trace_json_string(json, NULL, 0);
+    }
+
+    if (c == '-' || (c >= '0' && c <= '9'))
+    {
+        s64 v;
+        return tests_trace_json_number(json, &v);
+    }
+
+    const char* words[] = { "true", "false", "null" };
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(words); i++)
+    {
+        s32 len = (s32)strlen(words[i]);
+
+        if (json->end - json->ptr >= len && !memcmp(json->ptr, words[i], len))
+        {
+            json->ptr += len;
+            return true;
+        }
+    }
+
+    bool is_object = c == '{';
+
+    if (!is_object && c != '[')
+    {
+        return false;
+    }
+
+    json->ptr++;
+
+    if (tests_trace_json_char(json, is_object ? '}' : ']'))
+    {
+        return true;
+    }
+
+    do
+    {
+        if (is_object && (!tests_trace_json_string(json, NULL, 0) || !tests_trace_json_char(json, ':')))
+        {
+            return false;
+        }
+
+        if (!tests_trace_json_value(json, depth + 1))
+        {
+            return false;
+        }
+    }
+    while (tests_trace_json_char(json, ','));
+
+    return tests_trace_json_char(json, is_object ? '}' : ']');
+}
+
+// Reads the whole document, which must be an object with the events in traceEvents and nothing after it.
+static bool tests_trace_parse(SvrDynArray<char>* data, TestsTraceJson* json)
+{
+    json->ptr = data->mem;
+    json->end = data->mem + data->size;
+    json->num_events = 0;
+
+    bool has_events = false;
+
+    if (!tests_trace_json_char(json, '{'))
+    {
+        return false;
+    }
+
+    do
+    {
+        char key[32];
+
+        if (!tests_trace_json_string(json, key, sizeof(key)) || !tests_trace_json_char(json, ':'))
+        {
+            return false;
+        }
+
+        if (!strcmp(key, "traceEvents"))
+        {
+            has_events = true;
+
+            if (!tests_trace_json_char(json, '['))
+            {
+                return false;
+            }
+
+            if (!tests_trace_json_peek(json, ']'))
+            {
+                do
+                {
+                    if (!tests_trace_json_event(json))
+                    {
+                        return false;
+                    }
+                }
+                while (tests_trace_json_char(json, ','));
+            }
+
+            if (!tests_trace_json_char(json, ']'))
+            {
+                return false;
+            }
+        }
+
+        else if (!tests_trace_json_value(json, 1))
+        {
+            return false;
+        }
+    }
+    while (tests_trace_json_char(json, ','));
+
+    if (!tests_trace_json_char(json, '}'))
+    {
+        return false;
+    }
+
+    tests_trace_json_skip_space(json);
+
+    return has_events && json->ptr == json->end;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct TestsTraceThread
+{
+    s32 index;
+    u32 thread_id;
+};
+
+const char* TESTS_TRACE_THREAD_NAMES[TESTS_TRACE_THREADS] = { "worker 0", "worker \"1\"", "worker\\2" };
+
+// Scopes with made up times so they can be checked, and a counter every 100 scopes.
+static void tests_trace_thread(void* param)
+{
+    TestsTraceThread* thread = (TestsTraceThread*)param;
+    thread->thread_id = svr_thread_get_current_id();
+
+    svr_trace_set_thread_name(TESTS_TRACE_THREAD_NAMES[thread->index]);
+
+    for (s32 i = 0; i < TESTS_TRACE_THREAD_EVENTS; i++)
+    {
+        if (i % 100 == 0)
+        {
+            svr_trace_add_counter("queue", thread->index * 1000000 + i);
+        }
+
+        else
+        {
+            svr_trace_add_scope("work", (s64)thread->index * 100000000 + i, i % 7);
+        }
+    }
+}
+
+static void tests_trace_threads(TestsTraceJson* json)
+{
+    svr_trace_start();
+
+    TestsTraceThread threads[TESTS_TRACE_THREADS];
+    SvrThread handles[TESTS_TRACE_THREADS] = {};
+
+    for (s32 i = 0; i < TESTS_TRACE_THREADS; i++)
+    {
+        threads[i].index = i;
+        TEST_CHECK(svr_thread_start(&handles[i], tests_trace_thread, &threads[i]));
+    }
+
+    for (s32 i = 0; i < TESTS_TRACE_THREADS; i++)
+    {
+        svr_thread_join(&handles[i]);
+    }
+
+    svr_trace_stop();
+
+    // Nothing is recorded by the macros after the trace is stopped.
+    SVR_TRACE_COUNTER("after", 1);
+
+    {
+        SVR_TRACE_SCOPE("after");
+    }
+
+    SvrDynArray<char> data = {};
+    svr_trace_write_json("svr_tests \"trace\"\n", &data);
+
+    TEST_CHECK(tests_trace_parse(&data, json));
+
+    TEST_CHECK(json->num_events == 1 + TESTS_TRACE_THREADS * (1 + TESTS_TRACE_THREAD_EVENTS));
+    TEST_CHECK(!strcmp(json->events[0].ph, "M") && !strcmp(json->events[0].name, "process_name"));
+    TEST_CHECK(!strcmp(json->events[0].arg_name, "svr_tests \"trace\"\n"));
+
+    s64 pid = json->events[0].pid;
+
+    for (s32 i = 0; i < TESTS_TRACE_THREADS; i++)
+    {
+        TestsTraceThread* thread = &threads[i];
+
+        // The threads are written in the order they first recorded, which is not known, so the name is looked for.
+        TestsTraceEvent* start = NULL;
+
+        for (s32 j = 1; j < json->num_events; j++)
+        {
+            TestsTraceEvent* event = &json->events[j];
+
+            if (!strcmp(event->ph, "M") && !strcmp(event->name, "thread_name") && event->tid == thread->thread_id)
+            {
+                start = event;
+                break;
+            }
+        }
+
+        TEST_CHECK(start != NULL);
+
+        if (start == NULL)
+        {
+            continue;
+        }
+
+        TEST_CHECK(!strcmp(start->arg_name, TESTS_TRACE_THREAD_NAMES[i]));
+        TEST_CHECK(start + 1 + TESTS_TRACE_THREAD_EVENTS <= json->events + json->num_events);
+
+        bool right = true;
+
+        for (s32 j = 0; j < TESTS_TRACE_THREAD_EVENTS && start + 1 + j < json->events + json->num_events; j++)
+        {
+            TestsTraceEvent* event = start + 1 + j;
+
+            right &= event->pid == pid && event->tid == thread->thread_id;
+
+            if (j % 100 == 0)
+            {
+                right &= !strcmp(event->name, "queue") && !strcmp(event->ph, "C") && event->value == i * 1000000 + j;
+                right &= event->ts > 0 && event->num_fields == 6;
+            }
+
+            else
+            {
+                right &= !strcmp(event->name, "work") && !strcmp(event->ph, "X");
+                right &= event->ts == (s64)i * 100000000 + j && event->dur == j % 7 && event->num_fields == 6;
+            }
+        }
+
+        TEST_CHECK(right);
+    }
+
+    // The stages add up every scope of a name from every thread.
+    SvrDynArray<SvrTraceStage> stages = {};
+    svr_trace_get_stages(&stages);
+
+    TEST_CHECK(stages.size == 1);
+    TEST_CHECK(stages.size > 0 && !strcmp(stages[0].name, "work"));
+    TEST_CHECK(stages.size > 0 && stages[0].hist.runs == TESTS_TRACE_THREADS * (TESTS_TRACE_THREAD_EVENTS - TESTS_TRACE_THREAD_EVENTS / 100));
+    TEST_CHECK(stages.size > 0 && stages[0].hist.max == 6);
+
+    TEST_CHECK(svr_trace_get_num_dropped() == 0);
+
+    stages.free();
+    data.free();
+}
+
+// A new trace forgets the events of the last one, and an empty trace is still a valid document.
+static void tests_trace_restart(TestsTraceJson* json)
+{
+    svr_trace_start();
+    svr_trace_stop();
+
+    SvrDynArray<char> data = {};
+    svr_trace_write_json("empty", &data);
+
+    TEST_CHECK(tests_trace_parse(&data, json));
+    TEST_CHECK(json->num_events == 1);
+
+    svr_trace_start();
+    svr_trace_set_thread_name(NULL);
+    svr_trace_add_scope("tab\tand \\ slash", 5, 6);
+    svr_trace_stop();
+
+    data.size = 0;
+    svr_trace_write_json("one", &data);
+
+    TEST_CHECK(tests_trace_parse(&data, json));
+    TEST_CHECK(json->num_events == 2);
+    TEST_CHECK(json->num_events == 2 && !strcmp(json->events[1].name, "tab\tand \\ slash") && json->events[1].ts == 5 && json->events[1].dur == 6);
+
+    // The parser must refuse what the trace used to write for such names.
+    const char* bad = "{\"traceEvents\":[{\"name\":\"a\"b\"}]}";
+    data.size = 0;
+    data.insert_range(0, bad, (s32)strlen(bad));
+    TEST_CHECK(!tests_trace_parse(&data, json));
+
+    data.free();
+}
+
+void tests_trace()
+{
+    TestsTraceJson json = {};
+    json.events = (TestsTraceEvent*)svr_alloc(sizeof(TestsTraceEvent) * TESTS_TRACE_MAX_EVENTS);
+
+    tests_trace_threads(&json);
+    tests_trace_restart(&json);
+
+    svr_trace_free();
+    svr_free(json.events);
+}
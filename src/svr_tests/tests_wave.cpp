@@ -0,0 +1,232 @@
+#include "tests_priv.h"
+#include "svr_wave.h"
+#include <stdlib.h>
+
+// Tests of converting audio samples to 16 bit, and of writing them into the audio ring.
+
+const s32 TESTS_WAVE_MAX_SAMPLES = 70;
+const s32 TESTS_WAVE_MAX_OFFSET = 7; // Values that the source and destination are moved by, so no SIMD alignment is the same.
+const s32 TESTS_WAVE_RING_CAPACITY = 64;
+
+static s16 tests_wave_clip(s32 v)
+{
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (s16)v;
+}
+
+// Full scale is 1.0 in the mix of the game, which is 32768 in 16 bit units. Only -1.0 fits.
+static void tests_wave_saturation()
+{
+    s32 values[] =
+    {
+        0, 1, -1,
+        INT16_MAX, INT16_MAX + 1, INT16_MIN, INT16_MIN - 1,
+        32768 * 2, -32768 * 2, 32768 * 100, -32768 * 100,
+        INT32_MAX, INT32_MIN, INT32_MAX - 1, INT32_MIN + 1,
+        0x00010000, -0x00010000, 0x00018000, 0x7fff8000,
+    };
+
+    // Repeated so every level uses its full width, with an odd count so the scalar level also has some.
+    const s32 NUM_SAMPLES = 37;
+
+    SvrWaveS32 src[NUM_SAMPLES];
+    SvrWaveS16 dest[NUM_SAMPLES];
+
+    for (s32 i = 0; i < NUM_SAMPLES; i++)
+    {
+        src[i].l = values[(i * 2) % SVR_ARRAY_SIZE(values)];
+        src[i].r = values[(i * 2 + 1) % SVR_ARRAY_SIZE(values)];
+    }
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        memset(dest, 0, sizeof(dest));
+        svr_wave_convert(src, SVR_WAVE_FORMAT_S32, dest, NUM_SAMPLES, level);
+
+        bool same = true;
+
+        for (s32 i = 0; i < NUM_SAMPLES; i++)
+        {
+            same &= dest[i].l == tests_wave_clip(src[i].l);
+            same &= dest[i].r == tests_wave_clip(src[i].r);
+        }
+
+        TEST_CHECK(same);
+    }
+
+    // The ends themselves, the way a game with clipping would check them.
+    SvrWaveS32 ends[] = { SvrWaveS32 { 32767, -32768 }, SvrWaveS32 { 32768, -32769 }, SvrWaveS32 { 40000, -40000 } };
+    SvrWaveS16 end_dest[SVR_ARRAY_SIZE(ends)];
+
+    svr_wave_convert(ends, SVR_WAVE_FORMAT_S32, end_dest, SVR_ARRAY_SIZE(ends), svr_simd_get_best_level());
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(ends); i++)
+    {
+        TEST_CHECK(end_dest[i].l == 32767 && end_dest[i].r == -32768);
+    }
+}
+
+// Every count and offset against the scalar level, with guard values around the destination that must not be written.
+static void tests_wave_counts()
+{
+    s32 num_values = (TESTS_WAVE_MAX_SAMPLES + TESTS_WAVE_MAX_OFFSET) * 2;
+
+    s32* src = (s32*)svr_alloc(sizeof(s32) * num_values);
+    s16* scalar = (s16*)svr_alloc(sizeof(s16) * (num_values + 2));
+    s16* other = (s16*)svr_alloc(sizeof(s16) * (num_values + 2));
+
+    for (s32 i = 0; i < num_values; i++)
+    {
+        src[i] = (s32)((u32)rand() << 16 ^ (u32)rand()) >> (rand() % 16);
+    }
+
+    for (s32 num_samples = 0; num_samples <= TESTS_WAVE_MAX_SAMPLES; num_samples++)
+    {
+        for (s32 src_offset = 0; src_offset <= TESTS_WAVE_MAX_OFFSET; src_offset++)
+        {
+            for (s32 dest_offset = 0; dest_offset <= TESTS_WAVE_MAX_OFFSET; dest_offset++)
+            {
+                const s32* src_start = src + src_offset;
+                s32 end = dest_offset + num_samples * 2;
+
+                memset(scalar, 0x5a, sizeof(s16) * (num_values + 2));
+                svr_wave_convert(src_start, SVR_WAVE_FORMAT_S32, (SvrWaveS16*)(scalar + dest_offset), num_samples, SVR_SIMD_SCALAR);
+
+                bool right = true;
+
+                for (s32 i = 0; i < num_samples * 2; i++)
+                {
+                    right &= scalar[dest_offset + i] == tests_wave_clip(src_start[i]);
+                }
+
+                TEST_CHECK(right);
+                TEST_CHECK(scalar[end] == 0x5a5a && (dest_offset == 0 || scalar[dest_offset - 1] == 0x5a5a));
+
+                for (SvrSimdLevel level = SVR_SIMD_SSE41; level <= svr_simd_get_best_level(); level++)
+                {
+                    memset(other, 0x5a, sizeof(s16) * (num_values + 2));
+                    svr_wave_convert(src_start, SVR_WAVE_FORMAT_S32, (SvrWaveS16*)(other + dest_offset), num_samples, level);
+
+                    TEST_CHECK(!memcmp(scalar, other, sizeof(s16) * (num_values + 2)));
+                }
+            }
+        }
+
+        // 16 bit samples are copied as they are.
+        memset(other, 0, sizeof(s16) * (num_values + 2));
+        svr_wave_convert(scalar + 1, SVR_WAVE_FORMAT_S16, (SvrWaveS16*)other, num_samples, svr_simd_get_best_level());
+        TEST_CHECK(!memcmp(other, scalar + 1, sizeof(s16) * num_samples * 2));
+    }
+
+    TEST_CHECK(svr_wave_get_sample_size(SVR_WAVE_FORMAT_S16) == 4);
+    TEST_CHECK(svr_wave_get_sample_size(SVR_WAVE_FORMAT_S32) == 8);
+
+    svr_free(src);
+    svr_free(scalar);
+    svr_free(other);
+}
+
+// Reads everything in the ring, which takes two turns if it wraps around.
+static s32 tests_wave_read_ring(SvrSharedRing* ring, SvrWaveS16* dest)
+{
+    s32 num_read = 0;
+
+    while (true)
+    {
+        void* src;
+        s32 num = svr_shared_ring_begin_read(ring, &src, TESTS_WAVE_RING_CAPACITY);
+
+        if (num == 0)
+        {
+            break;
+        }
+
+        memcpy(dest + num_read, src, sizeof(SvrWaveS16) * num);
+        svr_shared_ring_end_read(ring, num);
+
+        num_read += num;
+    }
+
+    return num_read;
+}
+
+static void tests_wave_ring()
+{
+    s32 mem_size = sizeof(SvrSharedRing) + sizeof(SvrWaveS16) * TESTS_WAVE_RING_CAPACITY;
+    SvrSharedRing* ring = (SvrSharedRing*)svr_zalloc(mem_size);
+
+    SvrWaveS32 src[TESTS_WAVE_RING_CAPACITY * 2];
+    SvrWaveS16 read[TESTS_WAVE_RING_CAPACITY];
+
+    for (s32 i = 0; i < SVR_ARRAY_SIZE(src); i++)
+    {
+        src[i].l = (i - 40) * 1000;
+        src[i].r = -(i - 40) * 1500;
+    }
+
+    for (SvrSimdLevel level = SVR_SIMD_SCALAR; level <= svr_simd_get_best_level(); level++)
+    {
+        svr_shared_ring_init(ring, sizeof(SvrWaveS16), TESTS_WAVE_RING_CAPACITY, sizeof(SvrSharedRing));
+
+        // Move the indexes close to the end of the storage.
+        TEST_CHECK(svr_wave_write_ring(ring, src, SVR_WAVE_FORMAT_S32, 50, level) == 50);
+        TEST_CHECK(tests_wave_read_ring(ring, read) == 50);
+
+        // 33 samples from 50 go 19 past the end. The SIMD levels get both an odd start and an odd count.
+        TEST_CHECK(svr_wave_write_ring(ring, src + 1, SVR_WAVE_FORMAT_S32, 33, level) == 33);
+        TEST_CHECK(svr_shared_ring_get_num_items(ring) == 33);
+        TEST_CHECK(tests_wave_read_ring(ring, read) == 33);
+
+        bool right = true;
+
+        for (s32 i = 0; i < 33; i++)
+        {
+            right &= read[i].l == tests_wave_clip(src[1 + i].l) && read[i].r == tests_wave_clip(src[1 + i].r);
+        }
+
+        TEST_CHECK(right);
+
+        // Only what fits is written, and the rest can be written once there is space.
+        TEST_CHECK(svr_wave_write_ring(ring, src, SVR_WAVE_FORMAT_S32, 100, level) == TESTS_WAVE_RING_CAPACITY);
+        TEST_CHECK(svr_wave_write_ring(ring, src, SVR_WAVE_FORMAT_S32, 1, level) == 0);
+        TEST_CHECK(tests_wave_read_ring(ring, read) == TESTS_WAVE_RING_CAPACITY);
+
+        right = true;
+
+        for (s32 i = 0; i < TESTS_WAVE_RING_CAPACITY; i++)
+        {
+            right &= read[i].l == tests_wave_clip(src[i].l) && read[i].r == tests_wave_clip(src[i].r);
+        }
+
+        TEST_CHECK(right);
+
+        TEST_CHECK(svr_wave_write_ring(ring, src + TESTS_WAVE_RING_CAPACITY, SVR_WAVE_FORMAT_S32, 36, level) == 36);
+        TEST_CHECK(tests_wave_read_ring(ring, read) == 36);
+        TEST_CHECK(read[35].l == tests_wave_clip(src[TESTS_WAVE_RING_CAPACITY + 35].l));
+
+        // 16 bit samples across the end too.
+        SvrWaveS16 src16[40];
+
+        for (s32 i = 0; i < SVR_ARRAY_SIZE(src16); i++)
+        {
+            src16[i].l = (s16)(i * 3);
+            src16[i].r = (s16)(-i * 5);
+        }
+
+        TEST_CHECK(svr_wave_write_ring(ring, src16, SVR_WAVE_FORMAT_S16, SVR_ARRAY_SIZE(src16), level) == SVR_ARRAY_SIZE(src16));
+        TEST_CHECK(tests_wave_read_ring(ring, read) == SVR_ARRAY_SIZE(src16));
+        TEST_CHECK(!memcmp(read, src16, sizeof(src16)));
+    }
+
+    svr_free(ring);
+}
+
+void tests_wave()
+{
+    srand(21);
+
+    tests_wave_saturation();
+    tests_wave_counts();
+    tests_wave_ring();
+}
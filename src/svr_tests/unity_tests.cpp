@@ -0,0 +1,19 @@
+#include "tests_priv.h"
+#include "tests_main.cpp"
+#include "tests_pe_image.cpp"
+#include "tests_ring.cpp"
+#include "tests_color.cpp"
+#include "tests_copy.cpp"
+#include "tests_slot_ring.cpp"
+#include "tests_ipc.cpp"
+#include "tests_mosample.cpp"
+#include "tests_frame_steps.cpp"
+#include "tests_motion.cpp"
+#include "tests_glyphs.cpp"
+#include "tests_scan.cpp"
+#include "tests_scan_cache.cpp"
+#include "tests_pe.cpp"
+#include "tests_wave.cpp"
+#include "tests_trace.cpp"
+#include "tests_reorder.cpp"
+#include "tests_stats.cpp"